@@ -0,0 +1,52 @@
+// Sparse voxel mips, the layout of BrickMap (Engine/Utilities/BrickMap.h). Every mip is split into
+// bricks of 8x8x8 voxels. An R32_UINT indirection texture per mip holds, per brick, the index of the
+// brick in the pool plus one, zero for an empty brick. The pool is one RGBA8_UNORM 3D texture shared by
+// every mip, BRICK_POOL_WIDTH by BRICK_POOL_HEIGHT bricks wide.
+
+#define BRICK_SIZE 8
+#define BRICK_POOL_WIDTH 8
+#define BRICK_POOL_HEIGHT 8
+
+// Texel of the pool where a brick starts
+inline uint3 GetBrickOrigin(uint brickIndex)
+{
+	uint3 brick = uint3(brickIndex % BRICK_POOL_WIDTH, (brickIndex / BRICK_POOL_WIDTH) % BRICK_POOL_HEIGHT,
+		brickIndex / (BRICK_POOL_WIDTH * BRICK_POOL_HEIGHT));
+	return brick * BRICK_SIZE;
+}
+
+// Returns the voxel at integer coordinates of a mip, zero in an empty brick
+inline float4 LoadBrickVoxel(Texture3D<uint> indirection, Texture3D brickPool, uint3 voxel)
+{
+	uint entry = indirection.Load(int4(voxel / BRICK_SIZE, 0));
+
+	if (entry == 0)
+		return float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+	return brickPool.Load(int4(GetBrickOrigin(entry - 1) + (voxel % BRICK_SIZE), 0));
+}
+
+// Returns the voxel information at a position normalized to the volume, filtered like SampleLevel()
+// with gsamLinearWrap on a dense grid. Bricks have no border, so the eight voxels are loaded one by one.
+inline float4 SampleBrickVoxel(Texture3D<uint> indirection, Texture3D brickPool, float3 voxelPosition, uint resolution)
+{
+	float3 coordinate = voxelPosition * resolution - 0.5f;
+	float3 base = floor(coordinate);
+	float3 weights = coordinate - base;
+	int3 baseVoxel = int3(base);
+
+	float4 info = float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+	[unroll]
+	for (uint corner = 0; corner < 8; ++corner)
+	{
+		uint3 offset = uint3(corner & 1, (corner >> 1) & 1, corner >> 2);
+		int3 wrapped = (baseVoxel + int3(offset)) % int(resolution);
+		uint3 voxel = uint3(wrapped + (wrapped < 0) * int(resolution));
+		float3 cornerWeights = lerp(1.0f - weights, weights, float3(offset));
+
+		info += cornerWeights.x * cornerWeights.y * cornerWeights.z * LoadBrickVoxel(indirection, brickPool, voxel);
+	}
+
+	return info;
+}
\ No newline at end of file
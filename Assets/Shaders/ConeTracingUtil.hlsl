@@ -21,6 +21,9 @@ cbuffer cbPass : register(b0)
 	float4x4 gShadowViewProj;
 	float4x4 gShadowTransform;
 	float4 worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A;
+	uint gSHUpdateCellCount;
+	uint3 gSHUpdatePadding;
+	uint4 gSHUpdateCells[32];
 };
 
 Texture3D VoxelGrid0 			: register(t0);
@@ -48,6 +51,11 @@ SamplerState gsamLinearWrap		: register(s0);
 #define RAY_STEP 0.2f
 #define RAY_OFFSET 0.2f
 
+// The finest grid keeps depth in alpha. The coarser grids keep the fraction of occupied voxels below,
+// at least 1/8 when anything is there, so a sample stops a cone at a fifth of a lone occupied voxel.
+#define OCCUPIED_ALPHA 0.05f
+#define COARSE_OCCUPIED_ALPHA 0.025f
+
 #define RANDOM_VECTOR float3(0.267261f, 0.534522f, 0.801784f)
 
 /*Cosine lobe coeff*/
@@ -112,6 +120,9 @@ inline float3 DiffuseConeTrace(float3 worldPosition, float3 coneDirection)
 
 	float4 currentVoxelInfo = float4(0.0f, 0.0f, 0.0f, 0.0f);
 
+	// A sample is tested against the threshold of the grid it was taken from
+	bool searching = true;
+
 	// Sample voxel grid 0
 	uint iter;
 	
@@ -119,13 +130,14 @@ inline float3 DiffuseConeTrace(float3 worldPosition, float3 coneDirection)
 	{
 		currentPosition += (worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.g * coneDirection);
 
-		if (currentVoxelInfo.a < 0.05f)
+		if (searching)
 		{
 			currentVoxelInfo = GetVoxelInfo0(GetVoxelPosition(currentPosition));
+			searching = currentVoxelInfo.a < OCCUPIED_ALPHA;
 		}
 	}
 	
-	if (currentVoxelInfo.a > 0.05f)
+	if (!searching)
 		return currentVoxelInfo.rgb;
 
 	// Sample voxel grid 1
@@ -133,13 +145,14 @@ inline float3 DiffuseConeTrace(float3 worldPosition, float3 coneDirection)
 	{
 		currentPosition += (worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.g * coneDirection);
 
-		if (currentVoxelInfo.a < 0.05f)
+		if (searching)
 		{
 			currentVoxelInfo = GetVoxelInfo1(GetVoxelPosition(currentPosition));
+			searching = currentVoxelInfo.a < COARSE_OCCUPIED_ALPHA;
 		}
 	}
 
-	if (currentVoxelInfo.a > 0.05f)
+	if (!searching)
 		return currentVoxelInfo.rgb;
 	
 	// Sample voxel grid 2
@@ -147,13 +160,14 @@ inline float3 DiffuseConeTrace(float3 worldPosition, float3 coneDirection)
 	{
 		currentPosition += (worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.g * coneDirection);
 
-		if (currentVoxelInfo.a < 0.05f)
+		if (searching)
 		{
 			currentVoxelInfo = GetVoxelInfo2(GetVoxelPosition(currentPosition));
+			searching = currentVoxelInfo.a < COARSE_OCCUPIED_ALPHA;
 		}
 	}
 
-	if (currentVoxelInfo.a > 0.05f)
+	if (!searching)
 		return currentVoxelInfo.rgb;
 	
 	// Sample voxel grid 3
@@ -161,13 +175,14 @@ inline float3 DiffuseConeTrace(float3 worldPosition, float3 coneDirection)
 	{
 		currentPosition += (worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.g * coneDirection);
 
-		if (currentVoxelInfo.a < 0.05f)
+		if (searching)
 		{
 			currentVoxelInfo = GetVoxelInfo3(GetVoxelPosition(currentPosition));
+			searching = currentVoxelInfo.a < COARSE_OCCUPIED_ALPHA;
 		}
 	}
 
-	if (currentVoxelInfo.a > 0.05f)
+	if (!searching)
 		return currentVoxelInfo.rgb;
 	
 	// Sample voxel grid 4
@@ -175,9 +190,10 @@ inline float3 DiffuseConeTrace(float3 worldPosition, float3 coneDirection)
 	{
 		currentPosition += (worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.g * coneDirection);
 
-		if (currentVoxelInfo.a < 0.05f)
+		if (searching)
 		{
 			currentVoxelInfo = GetVoxelInfo4(GetVoxelPosition(currentPosition));
+			searching = currentVoxelInfo.a < COARSE_OCCUPIED_ALPHA;
 		}
 	}
 
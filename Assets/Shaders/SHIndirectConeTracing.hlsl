@@ -1,8 +1,18 @@
 #include "ConeTracingUtil.hlsl"
 
-[numthreads(4, 4, 4)]
-void CS(uint3 id : SV_DispatchThreadID)
+// One thread per cell scheduled this frame, see SHUpdateScheduler
+[numthreads(64, 1, 1)]
+void CS(uint3 dispatchThreadID : SV_DispatchThreadID)
 {
+	if (dispatchThreadID.x >= gSHUpdateCellCount)
+		return;
+
+	uint packedCells = gSHUpdateCells[dispatchThreadID.x / 8][(dispatchThreadID.x / 2) % 4];
+	uint cell = (packedCells >> ((dispatchThreadID.x % 2) * 16)) & 0xFFFF;
+
+	uint gridResolution = (uint)round(worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.r / worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.b);
+	uint3 id = uint3(cell % gridResolution, (cell / gridResolution) % gridResolution, cell / (gridResolution * gridResolution));
+
 	// Compute the current cell's world space position
 	
 	// Find the position first in range [0..1]
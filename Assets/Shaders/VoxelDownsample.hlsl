@@ -0,0 +1,42 @@
+// Builds one coarser voxel grid from the one before it, compiled once per grid with SOURCE_GRID and
+// DESTINATION_GRID naming the two UAVs, and FINEST_SOURCE set when reading the injected grid.
+// The same reduction as VoxelMipBuilder::Reduce() (Engine/Utilities/VoxelMipBuilder.h).
+
+RWTexture3D<float4> voxelGrid0 		: register(u0);
+RWTexture3D<float4> voxelGrid1 		: register(u1);
+RWTexture3D<float4> voxelGrid2 		: register(u2);
+RWTexture3D<float4> voxelGrid3 		: register(u3);
+RWTexture3D<float4> voxelGrid4 		: register(u4);
+
+[numthreads(4, 4, 4)]
+void CS(uint3 id : SV_DispatchThreadID)
+{
+	uint3 destinationSize;
+	DESTINATION_GRID.GetDimensions(destinationSize.x, destinationSize.y, destinationSize.z);
+
+	if (any(id >= destinationSize))
+		return;
+
+	float4 sum = float4(0.0f, 0.0f, 0.0f, 0.0f);
+	float occupiedChildren = 0.0f;
+
+	// Average of the eight voxels below, the color weighted by occupancy
+	[unroll]
+	for (uint child = 0; child < 8; ++child)
+	{
+		float4 voxelInfo = SOURCE_GRID[id * 2 + uint3(child & 1, (child >> 1) & 1, child >> 2)];
+
+#if FINEST_SOURCE
+		// The injected grid keeps the depth in alpha, any is an occupied voxel
+		float occupancy = voxelInfo.a > 0.0f ? 1.0f : 0.0f;
+#else
+		float occupancy = voxelInfo.a;
+#endif
+
+		sum += float4(voxelInfo.rgb * occupancy, occupancy);
+		occupiedChildren += occupancy > 0.0f ? 1.0f : 0.0f;
+	}
+
+	// Alpha is the fraction of occupied children, so sparse geometry keeps at least 1/8 in every mip
+	DESTINATION_GRID[id] = sum.a > 0.0f ? float4(sum.rgb / sum.a, occupiedChildren * 0.125f) : float4(0.0f, 0.0f, 0.0f, 0.0f);
+}
\ No newline at end of file
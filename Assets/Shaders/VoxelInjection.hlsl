@@ -1,7 +1,3 @@
-#define LUMA_THRESHOLD_FACTOR 0.02f // Higher = higher accuracy with higher flickering
-#define LUMA_DEPTH_FACTOR 100.0f 	// Higher = lesser variation with depth
-#define LUMA_FACTOR 1.9632107f
-
 // Constant data that varies per pass.
 cbuffer cbPass : register(b0)
 {
@@ -25,6 +21,12 @@ cbuffer cbPass : register(b0)
 	float4x4 gShadowViewProj;
 	float4x4 gShadowTransform;
 	float4 worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A;
+	uint gSHUpdateCellCount;
+	uint3 gSHUpdatePadding;
+	uint4 gSHUpdateCells[32];
+	uint gInjectionRectCount;
+	uint3 gInjectionPadding;
+	uint4 gInjectionRects[16];
 };
 
 Texture2D LightingTexture      		: register(t0);
@@ -35,9 +37,11 @@ RWTexture3D<float4> voxelGrid1 		: register(u1);
 RWTexture3D<float4> voxelGrid2 		: register(u2);
 RWTexture3D<float4> voxelGrid3 		: register(u3);
 RWTexture3D<float4> voxelGrid4 		: register(u4);
+// The finest grid packed for InterlockedMax, see PackedVoxelGrid.h
+RWTexture3D<uint> voxelPackedGrid	: register(u5);
 
-// Get the world position from linear depth
-inline float3 GetWorldPosition(float depth, uint2 id)
+// Get the world position from linear depth, and the view depth
+inline float3 GetWorldPosition(float depth, uint2 id, out float viewDepth)
 {
     float z = depth * 2.0f - 1.0f;
 
@@ -48,6 +52,7 @@ inline float3 GetWorldPosition(float depth, uint2 id)
 
     // Perspective division
     viewSpacePosition /= viewSpacePosition.w;
+    viewDepth = viewSpacePosition.z;
 
     float4 worldSpacePosition = mul(viewSpacePosition, gInvView);
 
@@ -70,15 +75,47 @@ inline uint3 GetVoxelPosition(float3 encodedPosition, uint resolution)
 	return voxelPosition;
 }
 
-// Function to get the luma value of the input color
-inline float GetLuma(float3 inputColor)
+// The view depth over the far plane in 12 bits, inverted in the high bits so that nearer is larger,
+// and the color in 7, 7 and 6 bits below, see PackedVoxelGrid.h. The depth is from the view of the frame
+// that wrote the texel, it isn't converted when the camera moves.
+inline uint PackVoxel(float3 color, float depth)
 {
-	return ((inputColor.y * LUMA_FACTOR) + inputColor.x);
+	uint3 color7 = (uint3)(saturate(color) * float3(127.0f, 127.0f, 63.0f) + 0.5f);
+	uint depth12 = (uint)(saturate(depth) * 4094.0f + 0.5f);
+
+	return ((4095 - depth12) << 20) | (color7.b << 14) | (color7.g << 7) | color7.r;
 }
 
+// The depth is only quantized to 8 bits here, as an alpha in [0.5..1] that is larger farther away
+inline float4 UnpackVoxel(uint packedVoxel)
+{
+	uint invertedDepth = packedVoxel >> 20;
+
+	if (invertedDepth == 0)
+		return float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+	uint3 color = uint3(packedVoxel & 0x7F, (packedVoxel >> 7) & 0x7F, (packedVoxel >> 14) & 0x3F);
+	color = (color << uint3(1, 1, 2)) | (color >> uint3(6, 6, 4));
+
+	return float4(color, 128 + ((4095 - invertedDepth) >> 5)) / 255.0f;
+}
+
+// A thread group per tile of the rectangles InjectionChangeDetector picked, one rectangle after the other
 [numthreads(16, 16, 1)]
-void CS(uint3 id : SV_DispatchThreadID)
+void CS(uint3 groupID : SV_GroupID, uint3 groupThreadID : SV_GroupThreadID)
 {
+	uint tile = groupID.x;
+	uint rect = 0;
+
+	while (rect + 1 < gInjectionRectCount && tile >= gInjectionRects[rect].z * gInjectionRects[rect].w)
+	{
+		tile -= gInjectionRects[rect].z * gInjectionRects[rect].w;
+		++rect;
+	}
+
+	uint4 tileRect = gInjectionRects[rect];
+	uint2 id = (tileRect.xy + uint2(tile % tileRect.z, tile / tileRect.z)) * 16 + groupThreadID.xy;
+
 	float4 lightingDepth = LightingTexture[id.xy];
 	
 	// Extract the pixel's depth
@@ -91,97 +128,48 @@ void CS(uint3 id : SV_DispatchThreadID)
 	uint voxelResolution = worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.a;
 
 	// World space position in [0..1] range
-	float3 encodedPosition = EncodePosition(GetWorldPosition(depth, id.xy));
-	
-	// Color of the current voxel with lighting
-	float3 lightingColor = lightingDepth.rgb;
-	
-	// Calculate depth based luma threshold (decreases with increasing depth)
-	float lumaThreshold = LUMA_THRESHOLD_FACTOR * (1.0f / max(depth * LUMA_DEPTH_FACTOR, 0.1f));
-	
-	// Find the current pixel's luma
-	float pixelLuma = GetLuma(lightingColor);
+	float viewDepth;
+	float3 encodedPosition = EncodePosition(GetWorldPosition(depth, id.xy, viewDepth));
+
+	// The far plane is at a clip space depth of one
+	float4 farPosition = mul(float4(0.0f, 0.0f, 1.0f, 1.0f), gInvProj);
 	
 	// Enter data into the zeroith voxel grid
 	uint3 voxelPosition = GetVoxelPosition(encodedPosition, voxelResolution);
 
-	// Value to be injected into the voxel grids
-	float4 injectionValue = float4(lightingColor, depth);
-	
-	// Inject the current voxel's information into the grid
-	float4 currentVoxelInfo = voxelGrid0[voxelPosition];
+	// The nearest pixel of the voxel wins whatever order the threads run in. The grid stays from frame to
+	// frame and only ever rises, so that holds within a dispatch: a pixel farther than what an earlier
+	// frame left, or at the same depth and darker, is dropped until ReseedCS runs on a scene change.
+	InterlockedMax(voxelPackedGrid[voxelPosition], PackVoxel(lightingDepth.rgb, viewDepth * farPosition.w / farPosition.z));
 
-	// Calculate difference between voxel and pixel luma
-	float currentVoxelLuma = GetLuma(currentVoxelInfo.rgb);
-	float lumaDiff = saturate(currentVoxelLuma - pixelLuma);
-	
-	// Only inject if currently voxel is either 1. unoccupied or 2. of a lesser depth and passes luma test
-	if ((currentVoxelInfo.a == 0.0f) || ((depth < currentVoxelInfo.a) && (lumaDiff < lumaThreshold)))
-	{
-		voxelGrid0[voxelPosition] = injectionValue;
-	}
-	
-	// Enter data into the first voxel grid
-	voxelPosition = GetVoxelPosition(encodedPosition, (voxelResolution >> 1));
+	// ResolveCS unpacks it into voxelGrid0, the coarser grids are downsampled from that by VoxelDownsample.hlsl
+}
 
-	// Inject the current voxel's information into the grid
-	currentVoxelInfo = voxelGrid1[voxelPosition];
-	
-	// Calculate difference between voxel and pixel luma
-	currentVoxelLuma = GetLuma(currentVoxelInfo.rgb);
-	lumaDiff = saturate(currentVoxelLuma - pixelLuma);
-	
-	// Only inject if currently voxel is either 1. unoccupied or 2. of a lesser depth and passes luma test
-	if ((currentVoxelInfo.a == 0.0f) || ((depth < currentVoxelInfo.a) && (lumaDiff < lumaThreshold)))
-	{
-		voxelGrid1[voxelPosition] = injectionValue;
-	}
-	
-	// Enter data into the second voxel grid
-	voxelPosition = GetVoxelPosition(encodedPosition, (voxelResolution >> 2));
+// Every voxel of the packed grid into voxelGrid0, after injection
+[numthreads(4, 4, 4)]
+void ResolveCS(uint3 id : SV_DispatchThreadID)
+{
+	voxelGrid0[id] = UnpackVoxel(voxelPackedGrid[id]);
+}
 
-	// Inject the current voxel's information into the grid
-	currentVoxelInfo = voxelGrid2[voxelPosition];
-	
-	// Calculate difference between voxel and pixel luma
-	currentVoxelLuma = GetLuma(currentVoxelInfo.rgb);
-	lumaDiff = saturate(currentVoxelLuma - pixelLuma);
-	
-	// Only inject if currently voxel is either 1. unoccupied or 2. of a lesser depth and passes luma test
-	if ((currentVoxelInfo.a == 0.0f) || ((depth < currentVoxelInfo.a) && (lumaDiff < lumaThreshold)))
-	{
-		voxelGrid2[voxelPosition] = injectionValue;
-	}
-	
-	// Enter data into the third voxel grid
-	voxelPosition = GetVoxelPosition(encodedPosition, (voxelResolution >> 3));
+// Every occupied voxel of the packed grid moved to the far plane with its color, before injecting after
+// the light or the scene changed, so the frame's pixels replace it whatever their color
+[numthreads(4, 4, 4)]
+void ReseedCS(uint3 id : SV_DispatchThreadID)
+{
+	uint packedVoxel = voxelPackedGrid[id];
 
-	// Inject the current voxel's information into the grid
-	currentVoxelInfo = voxelGrid3[voxelPosition];
-	
-	// Calculate difference between voxel and pixel luma
-	currentVoxelLuma = GetLuma(currentVoxelInfo.rgb);
-	lumaDiff = saturate(currentVoxelLuma - pixelLuma);
-	
-	// Only inject if currently voxel is either 1. unoccupied or 2. of a lesser depth and passes luma test
-	if ((currentVoxelInfo.a == 0.0f) || ((depth < currentVoxelInfo.a) && (lumaDiff < lumaThreshold)))
-	{
-		voxelGrid3[voxelPosition] = injectionValue;
-	}
-	
-	// Enter data into the fourth voxel grid
-	voxelPosition = GetVoxelPosition(encodedPosition, (voxelResolution >> 4));
+	voxelPackedGrid[id] = packedVoxel != 0 ? (1u << 20) | (packedVoxel & 0xFFFFF) : 0;
+}
 
-	// Inject the current voxel's information into the grid
-	currentVoxelInfo = voxelGrid4[voxelPosition];
-	
-	// Calculate difference between voxel and pixel luma
-	currentVoxelLuma = GetLuma(currentVoxelInfo.rgb);
-	lumaDiff = saturate(currentVoxelLuma - pixelLuma);
-	
-	// Only inject if currently voxel is either 1. unoccupied or 2. of a lesser depth and passes luma test
-	if ((currentVoxelInfo.a == 0.0f) || ((depth < currentVoxelInfo.a) && (lumaDiff < lumaThreshold)))
-	{
-		voxelGrid4[voxelPosition] = injectionValue;
-	}
+// Every voxel of voxelGrid0 into the packed grid, after it was seeded or restored from the GI cache
+[numthreads(4, 4, 4)]
+void PackCS(uint3 id : SV_DispatchThreadID)
+{
+	uint4 texel = (uint4)(saturate(voxelGrid0[id]) * 255.0f + 0.5f);
+
+	// Alphas below a half are taken as the nearest depth, the bits dropped are the ones UnpackVoxel repeats
+	uint depth12 = (max(texel.a, 128u) - 128u) << 5;
+
+	voxelPackedGrid[id] = texel.a > 0 ? ((4095 - depth12) << 20) | ((texel.b >> 2) << 14) | ((texel.g >> 1) << 7) | (texel.r >> 1) : 0;
 }
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	// Nearest rank percentile of an already sorted sample set
+	double Percentile(const std::vector<double>& sortedSamples, double percentile)
+	{
+		size_t rank = (size_t)std::ceil(percentile * sortedSamples.size());
+		rank = std::min(std::max<size_t>(rank, 1), sortedSamples.size());
+
+		return sortedSamples[rank - 1];
+	}
+
+	double Median(const std::vector<double>& sortedSamples)
+	{
+		size_t middle = sortedSamples.size() / 2;
+
+		if (sortedSamples.size() % 2 == 0)
+			return 0.5 * (sortedSamples[middle - 1] + sortedSamples[middle]);
+
+		return sortedSamples[middle];
+	}
+
+	const char* GetCompilerName()
+	{
+#if defined(_MSC_VER)
+		return "msvc";
+#elif defined(__clang__)
+		return "clang";
+#elif defined(__GNUC__)
+		return "gcc";
+#else
+		return "unknown";
+#endif
+	}
+}
+
+void Benchmark::UseCharPointer(const volatile char*)
+{
+}
+
+std::vector<Benchmark::Case>& Benchmark::GetCases()
+{
+	static std::vector<Case> cases;
+	return cases;
+}
+
+std::vector<Benchmark::CaseCheck>& Benchmark::GetChecks()
+{
+	static std::vector<CaseCheck> checks;
+	return checks;
+}
+
+uint32_t& Benchmark::GetReportedFailures()
+{
+	static uint32_t reportedFailures = 0;
+	return reportedFailures;
+}
+
+void Benchmark::Register(const std::string& name, Function function, uint64_t itemsPerIteration)
+{
+	GetCases().push_back({ name, function, itemsPerIteration, {} });
+}
+
+void Benchmark::SetMetric(const std::string& name, const std::string& metricName, double value)
+{
+	for (Case& benchmarkCase : GetCases())
+	{
+		if (benchmarkCase.name == name)
+			benchmarkCase.metrics.push_back({ metricName, value });
+	}
+}
+
+void Benchmark::Check(const std::string& description, const std::vector<std::string>& caseNames, CheckFunction function)
+{
+	GetChecks().push_back({ description, caseNames, function, false });
+}
+
+void Benchmark::ReportFailure(const std::string& description, uint32_t failedChecks)
+{
+	std::cerr << description << " failed " << failedChecks << " checks" << std::endl;
+	GetReportedFailures() += failedChecks;
+}
+
+uint32_t Benchmark::RunChecks(const std::string& name)
+{
+	uint32_t failedChecks = 0;
+
+	for (CaseCheck& check : GetChecks())
+	{
+		if (check.bDone || std::find(check.caseNames.begin(), check.caseNames.end(), name) == check.caseNames.end())
+			continue;
+
+		check.bDone = true;
+
+		const uint32_t checkFailures = check.function();
+
+		if (checkFailures != 0)
+			std::cerr << check.description << " failed " << checkFailures << " checks" << std::endl;
+
+		// Summed over every check of a case
+		for (Case& benchmarkCase : GetCases())
+		{
+			if (std::find(check.caseNames.begin(), check.caseNames.end(), benchmarkCase.name) == check.caseNames.end())
+				continue;
+
+			auto metric = std::find_if(benchmarkCase.metrics.begin(), benchmarkCase.metrics.end(),
+				[](const std::pair<std::string, double>& value) { return value.first == "failed_checks"; });
+
+			if (metric != benchmarkCase.metrics.end())
+				metric->second += checkFailures;
+			else
+				benchmarkCase.metrics.push_back({ "failed_checks", (double)checkFailures });
+		}
+
+		failedChecks += checkFailures;
+	}
+
+	return failedChecks;
+}
+
+bool Benchmark::ParseArguments(int argc, char** argv, BenchmarkSettings& settings)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = (i + 1 < argc);
+
+		if (strcmp(argv[i], "--filter") == 0 && hasValue)
+			settings.filter = argv[++i];
+		else if (strcmp(argv[i], "--out") == 0 && hasValue)
+			settings.outputPath = argv[++i];
+		else if (strcmp(argv[i], "--trace") == 0 && hasValue)
+			settings.tracePath = argv[++i];
+		else if (strcmp(argv[i], "--warmup") == 0 && hasValue)
+			settings.warmupSamples = (uint32_t)std::stoul(argv[++i]);
+		else if (strcmp(argv[i], "--samples") == 0 && hasValue)
+			settings.samples = std::max<uint32_t>(1, (uint32_t)std::stoul(argv[++i]));
+		else if (strcmp(argv[i], "--min-sample-ms") == 0 && hasValue)
+			settings.minSampleTime = std::stod(argv[++i]) * 1.0e6;
+		else if (strcmp(argv[i], "--list") == 0)
+			settings.listOnly = true;
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--filter substring] [--out results.json] [--trace trace.json]"
+				<< " [--warmup samples] [--samples samples] [--min-sample-ms milliseconds] [--list]" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+BenchmarkResult Benchmark::RunCase(const Case& benchmarkCase, const BenchmarkSettings& settings)
+{
+	BenchmarkResult result;
+	result.name = benchmarkCase.name;
+	result.itemsPerIteration = benchmarkCase.itemsPerIteration;
+	result.metrics = benchmarkCase.metrics;
+
+	// Calibrate the batch size so that timer resolution does not dominate fast cases. The
+	// calibration runs double as the first warmup.
+	uint64_t iterations = 1;
+
+	for (;;)
+	{
+		uint64_t startTime = Profiler::Now();
+
+		for (uint64_t i = 0; i < iterations; ++i)
+			benchmarkCase.function();
+
+		double elapsedTime = (double)(Profiler::Now() - startTime);
+
+		if (elapsedTime >= settings.minSampleTime || iterations >= (1ull << 30))
+			break;
+
+		// Aim slightly above the target, at most 10x per round so a noisy first run can't overshoot badly
+		double scale = (elapsedTime > 0.0) ? (1.2 * settings.minSampleTime / elapsedTime) : 10.0;
+		iterations = (uint64_t)(iterations * std::min(std::max(scale, 1.5), 10.0));
+	}
+
+	result.iterationsPerSample = iterations;
+
+	std::vector<double> samples;
+	samples.reserve(settings.samples);
+
+	for (uint32_t sample = 0; sample < settings.warmupSamples + settings.samples; ++sample)
+	{
+		PROFILE_SCOPE(benchmarkCase.name.c_str());
+
+		uint64_t startTime = Profiler::Now();
+
+		for (uint64_t i = 0; i < iterations; ++i)
+			benchmarkCase.function();
+
+		uint64_t endTime = Profiler::Now();
+
+		if (sample >= settings.warmupSamples)
+			samples.push_back((double)(endTime - startTime) / (double)iterations);
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (double sampleTime : samples)
+		sum += sampleTime;
+
+	result.samples = samples.size();
+	result.mean = sum / samples.size();
+	result.median = Median(samples);
+	result.p95 = Percentile(samples, 0.95);
+	result.min = samples.front();
+	result.max = samples.back();
+
+	double variance = 0.0;
+	for (double sampleTime : samples)
+		variance += (sampleTime - result.mean) * (sampleTime - result.mean);
+
+	result.stddev = (samples.size() > 1) ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+
+	return result;
+}
+
+bool Benchmark::WriteResults(const std::vector<BenchmarkResult>& results, const BenchmarkSettings& settings)
+{
+	std::ofstream outputFile(settings.outputPath, std::fstream::out | std::fstream::trunc);
+
+	if (!outputFile.is_open())
+		return false;
+
+	char dateBuffer[32] = {};
+	std::time_t currentTime = std::time(nullptr);
+	std::strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&currentTime));
+
+	outputFile << "{\n\t\"context\": {\n";
+	outputFile << "\t\t\"date\": \"" << dateBuffer << "\",\n";
+	outputFile << "\t\t\"compiler\": \"" << GetCompilerName() << "\",\n";
+#if defined(_DEBUG) || !defined(NDEBUG)
+	outputFile << "\t\t\"build\": \"debug\",\n";
+#else
+	outputFile << "\t\t\"build\": \"release\",\n";
+#endif
+	outputFile << "\t\t\"warmup_samples\": " << settings.warmupSamples << ",\n";
+	outputFile << "\t\t\"samples\": " << settings.samples << "\n";
+	outputFile << "\t},\n\t\"benchmarks\": [";
+
+	outputFile.precision(10);
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchmarkResult& result = results[i];
+
+		outputFile << (i == 0 ? "\n" : ",\n") << "\t\t{ \"name\": \"" << result.name << "\""
+			<< ", \"iterations_per_sample\": " << result.iterationsPerSample
+			<< ", \"samples\": " << result.samples
+			<< ", \"median_ns\": " << result.median
+			<< ", \"p95_ns\": " << result.p95
+			<< ", \"mean_ns\": " << result.mean
+			<< ", \"stddev_ns\": " << result.stddev
+			<< ", \"min_ns\": " << result.min
+			<< ", \"max_ns\": " << result.max;
+
+		if (result.itemsPerIteration > 0)
+			outputFile << ", \"items_per_second\": " << (result.itemsPerIteration * 1.0e9 / result.median);
+
+		for (const auto& metric : result.metrics)
+			outputFile << ", \"" << metric.first << "\": " << metric.second;
+
+		outputFile << " }";
+	}
+
+	outputFile << "\n\t]\n}\n";
+	outputFile.close();
+
+	return true;
+}
+
+int Benchmark::Run(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+
+	if (!ParseArguments(argc, argv, settings))
+		return 1;
+
+	Profiler::SetThreadName("Benchmark");
+	Profiler::SetEnabled(!settings.tracePath.empty());
+
+	std::vector<BenchmarkResult> results;
+	uint32_t failedChecks = GetReportedFailures();
+
+	for (const Case& benchmarkCase : GetCases())
+	{
+		if (!settings.filter.empty() && benchmarkCase.name.find(settings.filter) == std::string::npos)
+			continue;
+
+		if (settings.listOnly)
+		{
+			std::cout << benchmarkCase.name << std::endl;
+			continue;
+		}
+
+		failedChecks += RunChecks(benchmarkCase.name);
+		results.push_back(RunCase(benchmarkCase, settings));
+
+		const BenchmarkResult& result = results.back();
+
+		char line[256];
+		snprintf(line, sizeof(line), "%-60s median %12.1f ns   p95 %12.1f ns   (%llu x %llu)",
+			result.name.c_str(), result.median, result.p95,
+			(unsigned long long)result.samples, (unsigned long long)result.iterationsPerSample);
+
+		std::cout << line << std::endl;
+	}
+
+	if (settings.listOnly)
+		return 0;
+
+	if (!WriteResults(results, settings))
+	{
+		std::cerr << "Failed to write " << settings.outputPath << std::endl;
+		return 1;
+	}
+
+	if (!settings.tracePath.empty() && !Profiler::ExportChromeTrace(settings.tracePath))
+	{
+		std::cerr << "Failed to write " << settings.tracePath << std::endl;
+		return 1;
+	}
+
+	if (failedChecks != 0)
+	{
+		std::cerr << failedChecks << " checks failed" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
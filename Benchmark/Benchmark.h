@@ -0,0 +1,142 @@
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Statistics of one benchmark case. All times are per iteration in nanoseconds.
+struct BenchmarkResult
+{
+	std::string name;
+	uint64_t iterationsPerSample = 0;
+	uint64_t samples = 0;
+	double median = 0.0;
+	double p95 = 0.0;
+	double mean = 0.0;
+	double stddev = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+
+	// Optional throughput, reported as items (vertices, texels, objects ...) per second
+	uint64_t itemsPerIteration = 0;
+
+	// Quality numbers measured once at registration (PSNR, error counts ...)
+	std::vector<std::pair<std::string, double>> metrics;
+};
+
+struct BenchmarkSettings
+{
+	std::string filter;
+	std::string outputPath = "BenchmarkResults.json";
+	std::string tracePath;
+	uint32_t warmupSamples = 3;
+	uint32_t samples = 30;
+	// Fast cases are batched until a single sample takes at least this long
+	double minSampleTime = 1.0e6;
+	bool listOnly = false;
+};
+
+// Minimal benchmark harness. Cases register a function which runs one iteration of the measured
+// work; the harness batches iterations into samples, discards a number of warmup samples and
+// reports robust statistics (median and 95th percentile) as JSON.
+class Benchmark
+{
+public:
+	Benchmark() = default;
+	~Benchmark() = default;
+
+	using Function = std::function<void()>;
+	// Returns the number of checks that failed
+	using CheckFunction = std::function<uint32_t()>;
+
+	static void Register(const std::string&, Function, uint64_t itemsPerIteration = 0);
+
+	// Attaches a named value to an already registered case, written next to its timings
+	static void SetMetric(const std::string&, const std::string&, double);
+
+	// Correctness checks of the named cases, run once before the first of them is timed and only when
+	// one of them is selected. Failures are printed under the description, written as the cases'
+	// failed_checks metric and fail the run. A check may set metrics of its cases.
+	static void Check(const std::string&, const std::vector<std::string>&, CheckFunction);
+	// Failures found while registering, when a case can't even be set up
+	static void ReportFailure(const std::string&, uint32_t failedChecks = 1);
+
+	// Calls of the global operator new on any thread since startup, BenchmarkMain.cpp replaces it to
+	// count them
+	static uint64_t GetHeapAllocationCount();
+
+	// Parses the command line, runs every matching case and writes the results.
+	// Returns the process exit code, nonzero when a check failed.
+	static int Run(int, char**);
+
+	// Prevents the compiler from discarding a result that is otherwise unused.
+	template<typename T>
+	static void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		UseCharPointer(&reinterpret_cast<const volatile char&>(value));
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "g"(&value) : "memory");
+#endif
+	}
+
+private:
+
+	struct Case
+	{
+		std::string name;
+		Function function;
+		uint64_t itemsPerIteration;
+		std::vector<std::pair<std::string, double>> metrics;
+	};
+
+	struct CaseCheck
+	{
+		std::string description;
+		std::vector<std::string> caseNames;
+		CheckFunction function;
+		bool bDone;
+	};
+
+	static bool ParseArguments(int, char**, BenchmarkSettings&);
+	static BenchmarkResult RunCase(const Case&, const BenchmarkSettings&);
+	static bool WriteResults(const std::vector<BenchmarkResult>&, const BenchmarkSettings&);
+
+	// Runs the checks of a case not run yet, returns how many of them failed
+	static uint32_t RunChecks(const std::string&);
+
+	static std::vector<Case>& GetCases();
+	static std::vector<CaseCheck>& GetChecks();
+	static uint32_t& GetReportedFailures();
+
+	// Defined out of line so the optimizer has to assume the pointed to value is read
+	static void UseCharPointer(const volatile char*);
+};
+
+// Each file of cases exposes one of these, called from main
+void RegisterMeshBenchmarks();
+void RegisterSceneBenchmarks();
+void RegisterTextureBenchmarks();
+void RegisterBlockCompressionBenchmarks();
+void RegisterTextureStreamingBenchmarks();
+void RegisterTextureUploadBenchmarks();
+void RegisterUploadQueueBenchmarks();
+void RegisterDescriptorAllocatorBenchmarks();
+void RegisterVoxelInjectionBenchmarks();
+void RegisterVoxelizerBenchmarks();
+void RegisterBrickMapBenchmarks();
+void RegisterVoxelClipmapBenchmarks();
+void RegisterSHUpdateSchedulerBenchmarks();
+void RegisterInjectionChangeDetectorBenchmarks();
+void RegisterSphericalHarmonicsBenchmarks();
+void RegisterGICacheBenchmarks();
+void RegisterGIStatisticsBenchmarks();
+void RegisterPackedVoxelGridBenchmarks();
+void RegisterSHGridBakerBenchmarks();
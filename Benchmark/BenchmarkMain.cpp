@@ -0,0 +1,70 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/ThreadPool.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> heapAllocationCount = { 0 };
+}
+
+// Counts every allocation of the runner, the array, nothrow and sized forms forward to these. Kept
+// apart from the cases so the compiler doesn't inline them into the containers' code.
+void* operator new(std::size_t size)
+{
+	heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* memory = std::malloc(size > 0 ? size : 1))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+uint64_t Benchmark::GetHeapAllocationCount()
+{
+	return heapAllocationCount.load(std::memory_order_relaxed);
+}
+
+// Runs from the Benchmark directory so the engine's relative "../Assets/" paths resolve
+int main(int argc, char** argv)
+{
+	ThreadPool::Initialize();
+
+	RegisterMeshBenchmarks();
+	RegisterSceneBenchmarks();
+	RegisterTextureBenchmarks();
+	RegisterBlockCompressionBenchmarks();
+	RegisterTextureStreamingBenchmarks();
+	RegisterTextureUploadBenchmarks();
+	RegisterUploadQueueBenchmarks();
+	RegisterDescriptorAllocatorBenchmarks();
+	RegisterVoxelInjectionBenchmarks();
+	RegisterVoxelizerBenchmarks();
+	RegisterBrickMapBenchmarks();
+	RegisterVoxelClipmapBenchmarks();
+	RegisterSHUpdateSchedulerBenchmarks();
+	RegisterInjectionChangeDetectorBenchmarks();
+	RegisterSphericalHarmonicsBenchmarks();
+	RegisterGICacheBenchmarks();
+	RegisterGIStatisticsBenchmarks();
+	RegisterPackedVoxelGridBenchmarks();
+	RegisterSHGridBakerBenchmarks();
+
+	int exitCode = Benchmark::Run(argc, argv);
+
+	ThreadPool::Shutdown();
+
+	return exitCode;
+}
@@ -0,0 +1,525 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/BCDecoder.h"
+#include "../Engine/Utilities/BCEncoder.h"
+#include "../Engine/Utilities/MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	const uint32_t TextureSize = 256;
+
+	// Cheap deterministic value noise so the synthetic textures are the same on every run
+	uint32_t HashBits(uint32_t x, uint32_t y)
+	{
+		uint32_t h = x * 374761393u + y * 668265263u;
+		h = (h ^ (h >> 13)) * 1274126177u;
+		return h ^ (h >> 16);
+	}
+
+	float Hash(uint32_t x, uint32_t y)
+	{
+		return (float)(HashBits(x, y) & 0xFFFF) / 65535.0f;
+	}
+
+	float SmoothNoise(float x, float y)
+	{
+		uint32_t x0 = (uint32_t)x;
+		uint32_t y0 = (uint32_t)y;
+		float fx = x - x0;
+		float fy = y - y0;
+
+		float top = Hash(x0, y0) + (Hash(x0 + 1, y0) - Hash(x0, y0)) * fx;
+		float bottom = Hash(x0, y0 + 1) + (Hash(x0 + 1, y0 + 1) - Hash(x0, y0 + 1)) * fx;
+
+		return top + (bottom - top) * fy;
+	}
+
+	uint8_t ToByte(float value)
+	{
+		return (uint8_t)std::min(std::max(value * 255.0f + 0.5f, 0.0f), 255.0f);
+	}
+
+	// Green foliage with noisy shading and leaf shaped alpha with soft edges around the clip threshold
+	std::vector<uint8_t> MakeFoliageAlbedo()
+	{
+		std::vector<uint8_t> texels(TextureSize * TextureSize * 4);
+
+		for (uint32_t y = 0; y < TextureSize; ++y)
+		{
+			for (uint32_t x = 0; x < TextureSize; ++x)
+			{
+				float u = (float)x / TextureSize;
+				float v = (float)y / TextureSize;
+				float shade = 0.6f + 0.4f * SmoothNoise(u * 32.0f, v * 32.0f);
+
+				// Leaflets along a central stem
+				float leaf = std::fabs(std::sin(v * 40.0f)) * (0.5f - std::fabs(u - 0.5f)) * 4.0f;
+				float alpha = std::min(std::max((leaf - 0.4f) * 2.5f, 0.0f), 1.0f);
+
+				uint8_t* texel = &texels[(y * TextureSize + x) * 4];
+				texel[0] = ToByte(shade * (0.20f + 0.15f * u));
+				texel[1] = ToByte(shade * (0.45f + 0.20f * v));
+				texel[2] = ToByte(shade * 0.10f);
+				texel[3] = ToByte(alpha);
+			}
+		}
+
+		return texels;
+	}
+
+	// Tangent space normals of a rocky height field, roughness in alpha
+	std::vector<uint8_t> MakeNormalRoughness()
+	{
+		std::vector<uint8_t> texels(TextureSize * TextureSize * 4);
+
+		auto height = [](float u, float v)
+		{
+			return 0.5f * SmoothNoise(u * 16.0f, v * 16.0f) + 0.25f * SmoothNoise(u * 48.0f, v * 48.0f)
+				+ 0.1f * std::sin(u * 25.0f) * std::cos(v * 19.0f);
+		};
+
+		for (uint32_t y = 0; y < TextureSize; ++y)
+		{
+			for (uint32_t x = 0; x < TextureSize; ++x)
+			{
+				float u = (float)x / TextureSize;
+				float v = (float)y / TextureSize;
+				float step = 1.0f / TextureSize;
+
+				float dx = (height(u + step, v) - height(u - step, v)) * 24.0f;
+				float dy = (height(u, v + step) - height(u, v - step)) * 24.0f;
+				float inverseLength = 1.0f / std::sqrt(dx * dx + dy * dy + 1.0f);
+
+				uint8_t* texel = &texels[(y * TextureSize + x) * 4];
+				texel[0] = ToByte(-dx * inverseLength * 0.5f + 0.5f);
+				texel[1] = ToByte(-dy * inverseLength * 0.5f + 0.5f);
+				texel[2] = ToByte(inverseLength * 0.5f + 0.5f);
+				texel[3] = ToByte(0.3f + 0.5f * SmoothNoise(u * 8.0f, v * 8.0f));
+			}
+		}
+
+		return texels;
+	}
+
+	// Writes fields into a 128 bit block from the least significant bit of the first byte on
+	struct BlockBitWriter
+	{
+		uint8_t bytes[16] = {};
+		uint32_t position = 0;
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0; bit < bitCount; ++bit, ++position)
+				bytes[position / 8] |= (uint8_t)(((value >> bit) & 1) << (position % 8));
+		}
+	};
+
+	size_t CountMismatches(const void* a, const void* b, size_t size)
+	{
+		const uint8_t* bytesA = static_cast<const uint8_t*>(a);
+		const uint8_t* bytesB = static_cast<const uint8_t*>(b);
+
+		size_t mismatches = 0;
+
+		for (size_t i = 0; i < size; ++i)
+			mismatches += (bytesA[i] != bytesB[i]) ? 1 : 0;
+
+		return mismatches;
+	}
+
+	// Hand assembled blocks with their expected texels, worked out from the format specification
+	size_t CountKnownBlockMismatches()
+	{
+		const int32_t weights2[4] = { 0, 21, 43, 64 };
+		const int32_t weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+		const int32_t weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		size_t mismatches = 0;
+		uint8_t texels[64];
+		uint16_t halfTexels[64];
+
+		// BC7 mode 6, black to white with texel i using index i
+		{
+			BlockBitWriter writer;
+			writer.Write(1 << 6, 7);
+
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				writer.Write(0, 7);
+				writer.Write(127, 7);
+			}
+
+			writer.Write(0, 1);
+			writer.Write(1, 1);
+
+			for (uint32_t i = 0; i < 16; ++i)
+				writer.Write(i, (i == 0) ? 3 : 4);
+
+			BCDecoder::DecodeBlock(DXGI_FORMAT_BC7_UNORM, writer.bytes, texels);
+
+			for (uint32_t i = 0; i < 64; ++i)
+				mismatches += (texels[i] != (uint8_t)((weights4[i / 4] * 255 + 32) >> 6)) ? 1 : 0;
+		}
+
+		// BC7 mode 4 with rotation 1, the alpha ramp ends up in red and the color ramp in alpha
+		{
+			BlockBitWriter writer;
+			writer.Write(1 << 4, 5);
+			writer.Write(1, 2);
+			writer.Write(0, 1);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				writer.Write(0, 5);
+				writer.Write(31, 5);
+			}
+
+			writer.Write(0, 6);
+			writer.Write(63, 6);
+
+			for (uint32_t i = 0; i < 16; ++i)
+				writer.Write(i & 3, (i == 0) ? 1 : 2);
+
+			for (uint32_t i = 0; i < 16; ++i)
+				writer.Write(i & 7, (i == 0) ? 2 : 3);
+
+			BCDecoder::DecodeBlock(DXGI_FORMAT_BC7_UNORM, writer.bytes, texels);
+
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				uint8_t color = (uint8_t)((weights2[i & 3] * 255 + 32) >> 6);
+				uint8_t alpha = (uint8_t)((weights3[i & 7] * 255 + 32) >> 6);
+				uint8_t expected[4] = { alpha, color, color, color };
+
+				mismatches += CountMismatches(&texels[i * 4], expected, 4);
+			}
+		}
+
+		// BC6H mode 11 (10 bit endpoints, no deltas), unsigned 0 to 1023 and signed -511 to 511
+		for (uint32_t isSigned = 0; isSigned < 2; ++isSigned)
+		{
+			BlockBitWriter writer;
+			writer.Write(0x03, 5);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				writer.Write(isSigned ? 0x201 : 0, 10);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				writer.Write(isSigned ? 0x1FF : 0x3FF, 10);
+
+			for (uint32_t i = 0; i < 16; ++i)
+				writer.Write(i, (i == 0) ? 3 : 4);
+
+			BCDecoder::DecodeBlock(isSigned ? DXGI_FORMAT_BC6H_SF16 : DXGI_FORMAT_BC6H_UF16, writer.bytes, halfTexels);
+
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				int32_t weight = weights4[i];
+				uint16_t expected = 0;
+
+				if (isSigned)
+				{
+					int32_t value = ((64 - weight) * -0x7FFF + weight * 0x7FFF + 32) >> 6;
+					int32_t magnitude = (std::abs(value) * 31) >> 5;
+					expected = (uint16_t)((value < 0) ? (0x8000 | magnitude) : magnitude);
+				}
+				else
+				{
+					expected = (uint16_t)((((weight * 0xFFFF + 32) >> 6) * 31) >> 6);
+				}
+
+				uint16_t expectedTexel[4] = { expected, expected, expected, 0x3C00 };
+				mismatches += CountMismatches(&halfTexels[i * 4], expectedTexel, sizeof(expectedTexel));
+			}
+		}
+
+		return mismatches;
+	}
+
+	struct DecodedFormat
+	{
+		DXGI_FORMAT format;
+		const char* name;
+	};
+
+	const DecodedFormat DecodedFormats[] =
+	{
+		{ DXGI_FORMAT_BC1_UNORM, "BC1" }, { DXGI_FORMAT_BC1_UNORM_SRGB, "BC1_SRGB" }, { DXGI_FORMAT_BC2_UNORM, "BC2" },
+		{ DXGI_FORMAT_BC3_UNORM, "BC3" }, { DXGI_FORMAT_BC4_UNORM, "BC4" }, { DXGI_FORMAT_BC4_SNORM, "BC4_SNORM" },
+		{ DXGI_FORMAT_BC5_UNORM, "BC5" }, { DXGI_FORMAT_BC5_SNORM, "BC5_SNORM" }, { DXGI_FORMAT_BC6H_UF16, "BC6H_UF16" },
+		{ DXGI_FORMAT_BC6H_SF16, "BC6H_SF16" }, { DXGI_FORMAT_BC7_UNORM, "BC7" }, { DXGI_FORMAT_BC7_UNORM_SRGB, "BC7_SRGB" }
+	};
+
+	// Random bits hit every BC6H mode including the reserved ones. BC7 picks its mode by the lowest
+	// set bit, so the first byte is forced to cycle through all eight and the invalid zero byte.
+	std::vector<uint8_t> MakeRandomBlocks(DXGI_FORMAT format, size_t blockCount)
+	{
+		size_t blockSize = BCDecoder::GetBlockSize(format);
+		std::vector<uint8_t> blocks(blockCount * blockSize);
+
+		for (size_t i = 0; i < blocks.size(); ++i)
+			blocks[i] = (uint8_t)HashBits((uint32_t)i, (uint32_t)format);
+
+		if (format == DXGI_FORMAT_BC7_UNORM || format == DXGI_FORMAT_BC7_UNORM_SRGB)
+		{
+			for (size_t block = 0; block < blockCount; ++block)
+			{
+				uint32_t mode = block % 9;
+				uint8_t& modeByte = blocks[block * blockSize];
+
+				modeByte = (mode == 8) ? 0 : (uint8_t)(((modeByte >> (mode + 1)) << (mode + 1)) | (1 << mode));
+			}
+		}
+
+		return blocks;
+	}
+
+	// The vectorized block decode has to match the reference decode bit for bit in both outputs
+	size_t CountReferenceMismatches(DXGI_FORMAT format, const std::vector<uint8_t>& blocks)
+	{
+		size_t blockSize = BCDecoder::GetBlockSize(format);
+		size_t mismatches = 0;
+
+		uint8_t texels[64];
+		uint8_t referenceTexels[64];
+		uint16_t halfTexels[64];
+		uint16_t referenceHalfTexels[64];
+
+		for (size_t offset = 0; offset < blocks.size(); offset += blockSize)
+		{
+			BCDecoder::DecodeBlock(format, &blocks[offset], texels);
+			BCDecoder::DecodeBlockReference(format, &blocks[offset], referenceTexels);
+			BCDecoder::DecodeBlock(format, &blocks[offset], halfTexels);
+			BCDecoder::DecodeBlockReference(format, &blocks[offset], referenceHalfTexels);
+
+			mismatches += CountMismatches(texels, referenceTexels, sizeof(texels));
+			mismatches += CountMismatches(halfTexels, referenceHalfTexels, sizeof(halfTexels));
+		}
+
+		return mismatches;
+	}
+
+	void RegisterRandomBlockDecode()
+	{
+		const size_t BlockCount = 4608;
+
+		std::vector<std::string> names;
+
+		for (const DecodedFormat& decodedFormat : DecodedFormats)
+		{
+			DXGI_FORMAT format = decodedFormat.format;
+			auto blocks = std::make_shared<std::vector<uint8_t>>(MakeRandomBlocks(format, BlockCount));
+			std::string name = std::string("BCDecoder::DecodeBlock/") + decodedFormat.name + "/Random";
+
+			Benchmark::Register(name, [blocks, format]()
+			{
+				size_t blockSize = BCDecoder::GetBlockSize(format);
+				uint16_t texels[64];
+
+				for (size_t offset = 0; offset < blocks->size(); offset += blockSize)
+				{
+					BCDecoder::DecodeBlock(format, &(*blocks)[offset], texels);
+					Benchmark::DoNotOptimize(texels);
+				}
+			}, BlockCount * 16);
+
+			Benchmark::Check("BCDecoder SIMD and reference decode of " + name, { name }, [blocks, format, name]()
+			{
+				size_t mismatches = CountReferenceMismatches(format, *blocks);
+				Benchmark::SetMetric(name, "reference_mismatches", (double)mismatches);
+
+				return (uint32_t)mismatches;
+			});
+
+			names.push_back(name);
+		}
+
+		Benchmark::Check("BCDecoder of the hand assembled blocks", names, [names]()
+		{
+			size_t knownMismatches = CountKnownBlockMismatches();
+
+			for (const std::string& name : names)
+				Benchmark::SetMetric(name, "known_block_mismatches", (double)knownMismatches);
+
+			return (uint32_t)knownMismatches;
+		});
+	}
+
+	// Decodes what the encoder wrote, the result has to be exactly what the encoder says a decoder sees
+	void RegisterDecode(const std::string& name, std::shared_ptr<std::vector<uint8_t>> encoded, BCFormat format,
+		const std::vector<uint8_t>& encoderDecoded)
+	{
+		size_t blocksWide = TextureSize / 4;
+		size_t texelCount = TextureSize * TextureSize;
+		DXGI_FORMAT dxgiFormat = BCEncoder::GetDXGIFormat(format, false);
+
+		DDSSubresource subresource;
+		subresource.data = encoded->data();
+		subresource.size = encoded->size();
+		subresource.width = TextureSize;
+		subresource.height = TextureSize;
+		subresource.depth = 1;
+		subresource.rowPitch = blocksWide * BCEncoder::GetBlockSize(format);
+		subresource.rowCount = blocksWide;
+		subresource.slicePitch = encoded->size();
+
+		auto output = std::make_shared<std::vector<uint8_t>>(texelCount * 4);
+		auto halfOutput = std::make_shared<std::vector<uint16_t>>(texelCount * 4);
+
+		std::string surfaceName = "BCDecoder::DecodeSurface/" + name;
+
+		Benchmark::Register(surfaceName, [encoded, subresource, dxgiFormat, output]()
+		{
+			BCDecoder::DecodeSurface(subresource, dxgiFormat, output->data(), TextureSize * 4);
+			Benchmark::DoNotOptimize(*output);
+		}, texelCount);
+
+		Benchmark::Register("BCDecoder::DecodeSurface/RGBA16F/" + name, [encoded, subresource, dxgiFormat, halfOutput]()
+		{
+			BCDecoder::DecodeSurface(subresource, dxgiFormat, halfOutput->data(), TextureSize * 4 * sizeof(uint16_t));
+			Benchmark::DoNotOptimize(*halfOutput);
+		}, texelCount);
+
+		auto expected = std::make_shared<std::vector<uint8_t>>(encoderDecoded);
+
+		Benchmark::Check("BCDecoder against BCEncoder of " + name, { surfaceName }, [subresource, dxgiFormat, output, expected, surfaceName]()
+		{
+			BCDecoder::DecodeSurface(subresource, dxgiFormat, output->data(), TextureSize * 4);
+			size_t mismatches = CountMismatches(output->data(), expected->data(), output->size());
+			Benchmark::SetMetric(surfaceName, "encoder_mismatches", (double)mismatches);
+
+			return (uint32_t)mismatches;
+		});
+	}
+
+	void RegisterMipGeneration(std::shared_ptr<std::vector<uint8_t>> albedo, std::shared_ptr<std::vector<uint8_t>> normalRoughness)
+	{
+		std::string diffuseName = "MipGenerator::GenerateDiffuseOpacityMips/FoliageAlbedo";
+
+		Benchmark::Register(diffuseName, [albedo]()
+		{
+			std::vector<MipLevel> mips;
+			MipGenerator::GenerateDiffuseOpacityMips(albedo->data(), TextureSize, TextureSize, BCEncoder::DiffuseAlphaClipThreshold, mips);
+			Benchmark::DoNotOptimize(mips);
+		}, TextureSize * TextureSize);
+
+		Benchmark::Register("MipGenerator::GenerateNormalRoughnessMips/NormalRoughness", [normalRoughness]()
+		{
+			std::vector<MipLevel> mips;
+			MipGenerator::GenerateNormalRoughnessMips(normalRoughness->data(), TextureSize, TextureSize, mips);
+			Benchmark::DoNotOptimize(mips);
+		}, TextureSize * TextureSize);
+
+		// Worst alpha test coverage difference to the top mip, with and without rescaling. The
+		// smallest mips only have a few texels and can't match exactly, they are left out.
+		Benchmark::Check("MipGenerator coverage rescaling", { diffuseName }, [albedo, diffuseName]()
+		{
+			std::vector<MipLevel> mips;
+			std::vector<MipCoverage> coverage;
+			MipGenerator::GenerateDiffuseOpacityMips(albedo->data(), TextureSize, TextureSize, BCEncoder::DiffuseAlphaClipThreshold, mips, &coverage);
+
+			double maxError = 0.0;
+			double maxFilteredError = 0.0;
+
+			for (size_t mip = 0; mip < coverage.size() && mips[mip].width >= 8; ++mip)
+			{
+				maxError = std::max(maxError, std::fabs(coverage[mip].coverage - coverage[mip].targetCoverage));
+				maxFilteredError = std::max(maxFilteredError, std::fabs(coverage[mip].filteredCoverage - coverage[mip].targetCoverage));
+			}
+
+			Benchmark::SetMetric(diffuseName, "max_coverage_error", maxError);
+			Benchmark::SetMetric(diffuseName, "max_box_filter_coverage_error", maxFilteredError);
+
+			// Rescaling must not make the coverage worse
+			return maxError > maxFilteredError ? 1u : 0u;
+		});
+	}
+
+	void RegisterEncode(const std::string& name, std::shared_ptr<std::vector<uint8_t>> texels, BCFormat format, float alphaClipThreshold)
+	{
+		size_t blocksWide = TextureSize / 4;
+		size_t blockSize = BCEncoder::GetBlockSize(format);
+		size_t texelCount = TextureSize * TextureSize;
+
+		auto output = std::make_shared<std::vector<uint8_t>>(blocksWide * blocksWide * blockSize);
+
+		std::string surfaceName = "BCEncoder::EncodeSurface/" + name;
+
+		Benchmark::Register(surfaceName, [texels, output, format, alphaClipThreshold, blocksWide, blockSize]()
+		{
+			BCEncoder::EncodeSurface(texels->data(), TextureSize, TextureSize, TextureSize * 4, format, alphaClipThreshold,
+				output->data(), blocksWide * blockSize);
+			Benchmark::DoNotOptimize(*output);
+		}, texelCount);
+
+		// The same blocks on the calling thread only, per core throughput
+		Benchmark::Register("BCEncoder::EncodeBlock/" + name, [texels, output, format, alphaClipThreshold, blocksWide, blockSize]()
+		{
+			uint8_t block[64];
+
+			for (size_t blockY = 0; blockY < blocksWide; ++blockY)
+			{
+				for (size_t blockX = 0; blockX < blocksWide; ++blockX)
+				{
+					for (size_t row = 0; row < 4; ++row)
+						memcpy(&block[row * 16], &(*texels)[((blockY * 4 + row) * TextureSize + blockX * 4) * 4], 16);
+
+					uint8_t* encoded = &(*output)[(blockY * blocksWide + blockX) * blockSize];
+
+					if (format == BCFormat::BC1)
+						BCEncoder::EncodeBlockBC1(block, encoded, alphaClipThreshold);
+					else if (format == BCFormat::BC3)
+						BCEncoder::EncodeBlockBC3(block, encoded, alphaClipThreshold);
+					else if (format == BCFormat::BC5)
+						BCEncoder::EncodeBlockBC5(block, encoded);
+					else
+						BCEncoder::EncodeBlockBC7(block, encoded);
+				}
+			}
+
+			Benchmark::DoNotOptimize(*output);
+		}, texelCount);
+
+		// Quality of what the decoder will see
+		std::vector<uint8_t> decoded(texelCount * 4);
+		BCEncoder::EncodeSurface(texels->data(), TextureSize, TextureSize, TextureSize * 4, format, alphaClipThreshold,
+			output->data(), blocksWide * blockSize, decoded.data());
+
+		if (format == BCFormat::BC5)
+		{
+			Benchmark::SetMetric(surfaceName, "psnr_rg_db", BCEncoder::ComputePSNR(texels->data(), decoded.data(), texelCount, 2));
+		}
+		else if (format == BCFormat::BC7)
+		{
+			Benchmark::SetMetric(surfaceName, "psnr_rgba_db", BCEncoder::ComputePSNR(texels->data(), decoded.data(), texelCount, 4));
+		}
+		else
+		{
+			Benchmark::SetMetric(surfaceName, "psnr_rgb_db", BCEncoder::ComputePSNR(texels->data(), decoded.data(), texelCount, 3,
+				alphaClipThreshold));
+			Benchmark::SetMetric(surfaceName, "clip_mismatches",
+				(double)BCEncoder::CountClipMismatches(texels->data(), decoded.data(), texelCount, alphaClipThreshold));
+		}
+
+		RegisterDecode(name, output, format, decoded);
+	}
+}
+
+void RegisterBlockCompressionBenchmarks()
+{
+	auto albedo = std::make_shared<std::vector<uint8_t>>(MakeFoliageAlbedo());
+	auto normalRoughness = std::make_shared<std::vector<uint8_t>>(MakeNormalRoughness());
+
+	RegisterEncode("BC1/FoliageAlbedo", albedo, BCFormat::BC1, BCEncoder::DiffuseAlphaClipThreshold);
+	RegisterEncode("BC3/FoliageAlbedo", albedo, BCFormat::BC3, BCEncoder::DiffuseAlphaClipThreshold);
+	RegisterEncode("BC5/NormalRoughness", normalRoughness, BCFormat::BC5, BCEncoder::NoAlphaClip);
+	RegisterEncode("BC7/NormalRoughness", normalRoughness, BCFormat::BC7, BCEncoder::NoAlphaClip);
+
+	RegisterRandomBlockDecode();
+
+	RegisterMipGeneration(albedo, normalRoughness);
+}
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/BrickMap.h"
+#include "../Engine/Utilities/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace
+{
+	const uint32_t MipCount = 5;
+	const float WorldVolumeBoundary = 50.0f;
+	const uint32_t LookupCount = 1 << 16;
+
+	struct Sphere
+	{
+		float center[3];
+		float radius;
+	};
+
+	const Sphere Spheres[] =
+	{
+		{ { -12.0f, 6.0f, 10.0f }, 6.0f },
+		{ { 8.0f, 4.0f, 0.0f }, 4.0f },
+		{ { 20.0f, 10.0f, 30.0f }, 10.0f }
+	};
+
+	// Distance to the surfaces of the room of the voxel injection cases: a floor, three walls and spheres
+	float GetSurfaceDistance(const float* position, uint32_t& surface)
+	{
+		float distances[] =
+		{
+			std::fabs(position[1]),
+			std::fabs(position[0] + 40.0f),
+			std::fabs(position[0] - 40.0f),
+			std::fabs(position[2] - 45.0f)
+		};
+
+		float distance = distances[0];
+		surface = 0;
+
+		for (uint32_t i = 1; i < 4; ++i)
+		{
+			if (distances[i] < distance)
+			{
+				distance = distances[i];
+				surface = i;
+			}
+		}
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			const Sphere& sphere = Spheres[i];
+			float offset[3] = { position[0] - sphere.center[0], position[1] - sphere.center[1], position[2] - sphere.center[2] };
+			float sphereDistance = std::fabs(std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]) - sphere.radius);
+
+			if (sphereDistance < distance)
+			{
+				distance = sphereDistance;
+				surface = 4 + i;
+			}
+		}
+
+		return distance;
+	}
+
+	// Marks the voxels a surface passes through, the way the voxelization leaves a scene of thin walls
+	void BuildGrid(VoxelGrid& grid, uint32_t resolution)
+	{
+		grid.Reset(resolution);
+
+		const float voxelSize = 2.0f * WorldVolumeBoundary / (float)resolution;
+		const float halfDiagonal = voxelSize * 0.8660254f;
+
+		ThreadPool::ParallelFor(resolution, 1, [&](size_t begin, size_t end)
+		{
+			for (uint32_t z = (uint32_t)begin; z < (uint32_t)end; ++z)
+			{
+				for (uint32_t y = 0; y < resolution; ++y)
+				{
+					for (uint32_t x = 0; x < resolution; ++x)
+					{
+						const float center[3] =
+						{
+							((float)x + 0.5f) * voxelSize - WorldVolumeBoundary,
+							((float)y + 0.5f) * voxelSize - WorldVolumeBoundary,
+							((float)z + 0.5f) * voxelSize - WorldVolumeBoundary
+						};
+
+						uint32_t surface = 0;
+
+						if (center[1] < 30.0f + halfDiagonal && GetSurfaceDistance(center, surface) < halfDiagonal)
+						{
+							const float shade = 0.2f + 0.1f * (float)surface;
+							grid.GetTexels()[grid.GetIndex(x, y, z)] = VoxelGrid::Pack(shade, shade * 0.9f, shade * 0.7f, 1.0f);
+						}
+					}
+				}
+			}
+		});
+	}
+
+	uint32_t WrapCoordinate(int32_t coordinate, uint32_t resolution)
+	{
+		if ((uint32_t)coordinate < resolution)
+			return (uint32_t)coordinate;
+
+		const int32_t wrapped = coordinate % (int32_t)resolution;
+		return (uint32_t)(wrapped < 0 ? wrapped + (int32_t)resolution : wrapped);
+	}
+
+	// The same filtering as BrickMap::Sample(), straight from a dense grid
+	void SampleDense(const VoxelGrid& grid, const float* position, float* result)
+	{
+		const uint32_t resolution = grid.GetResolution();
+		uint32_t voxels[3][2];
+		float weights[3];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const float coordinate = position[axis] * (float)resolution - 0.5f;
+			const float floorCoordinate = std::floor(coordinate);
+			const int32_t base = (int32_t)floorCoordinate;
+
+			voxels[axis][0] = WrapCoordinate(base, resolution);
+			voxels[axis][1] = WrapCoordinate(base + 1, resolution);
+			weights[axis] = coordinate - floorCoordinate;
+		}
+
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			result[channel] = 0.0f;
+
+		for (uint32_t corner = 0; corner < 8; ++corner)
+		{
+			const uint32_t offsetX = corner & 1;
+			const uint32_t offsetY = (corner >> 1) & 1;
+			const uint32_t offsetZ = corner >> 2;
+
+			const float weight = (offsetX != 0 ? weights[0] : 1.0f - weights[0])
+				* (offsetY != 0 ? weights[1] : 1.0f - weights[1])
+				* (offsetZ != 0 ? weights[2] : 1.0f - weights[2]);
+
+			const uint32_t texel = grid.GetTexels()[grid.GetIndex(voxels[0][offsetX], voxels[1][offsetY], voxels[2][offsetZ])];
+
+			for (uint32_t channel = 0; channel < 4; ++channel)
+				result[channel] += weight * VoxelGrid::Unpack(texel, channel);
+		}
+	}
+
+	struct BrickMapState
+	{
+		VoxelGrid grids[MipCount];
+		BrickMap brickMap;
+		// Normalized positions, half anywhere in the volume and half next to an occupied voxel, the
+		// samples of cone tracing that go on and the ones that stop
+		std::vector<float> positions;
+		std::vector<uint32_t> voxels;
+	};
+
+	void BuildLookups(BrickMapState& state)
+	{
+		const VoxelGrid& grid = state.grids[0];
+		const uint32_t resolution = grid.GetResolution();
+
+		std::vector<uint32_t> occupiedVoxels;
+
+		for (uint32_t i = 0; i < (uint32_t)grid.GetTexelCount(); ++i)
+		{
+			if ((grid.GetTexels()[i] >> 24) != 0)
+				occupiedVoxels.push_back(i);
+		}
+
+		uint32_t random = 12345;
+		auto nextRandom = [&random]()
+		{
+			random = random * 1664525u + 1013904223u;
+			return random >> 8;
+		};
+
+		state.positions.resize(LookupCount * 3);
+		state.voxels.resize(LookupCount * 3);
+
+		for (uint32_t i = 0; i < LookupCount; ++i)
+		{
+			for (uint32_t axis = 0; axis < 3; ++axis)
+				state.positions[i * 3 + axis] = (float)nextRandom() / (float)(1 << 24);
+
+			if (i % 2 == 1 && !occupiedVoxels.empty())
+			{
+				const uint32_t voxel = occupiedVoxels[nextRandom() % occupiedVoxels.size()];
+				const uint32_t coordinates[3] = { voxel % resolution, voxel / resolution % resolution, voxel / (resolution * resolution) };
+
+				for (uint32_t axis = 0; axis < 3; ++axis)
+					state.positions[i * 3 + axis] = ((float)coordinates[axis] + state.positions[i * 3 + axis]) / (float)resolution;
+			}
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+				state.voxels[i * 3 + axis] = std::min((uint32_t)(state.positions[i * 3 + axis] * (float)resolution), resolution - 1);
+		}
+	}
+
+	void RegisterBrickMap(uint32_t resolution)
+	{
+		auto state = std::make_shared<BrickMapState>();
+		state->brickMap.Reset(resolution, MipCount);
+
+		size_t denseBytes = 0;
+		size_t texelCount = 0;
+		uint32_t occupiedVoxels = 0;
+
+		for (uint32_t mip = 0; mip < MipCount; ++mip)
+		{
+			BuildGrid(state->grids[mip], resolution >> mip);
+			state->brickMap.Update(mip, state->grids[mip]);
+
+			denseBytes += state->grids[mip].GetTexelCount() * sizeof(uint32_t);
+			texelCount += state->grids[mip].GetTexelCount();
+		}
+
+		for (size_t i = 0; i < state->grids[0].GetTexelCount(); ++i)
+			occupiedVoxels += (state->grids[0].GetTexels()[i] >> 24) != 0 ? 1 : 0;
+
+		BuildLookups(*state);
+
+		std::string size = std::to_string(resolution);
+
+		std::string sampleName = "BrickMap::Sample/" + size;
+
+		Benchmark::Register(sampleName, [state]()
+		{
+			float sum = 0.0f;
+
+			for (uint32_t i = 0; i < LookupCount; ++i)
+			{
+				float sample[4];
+				state->brickMap.Sample(0, &state->positions[i * 3], sample);
+				sum += sample[3];
+			}
+
+			Benchmark::DoNotOptimize(sum);
+		}, LookupCount);
+
+		Benchmark::SetMetric(sampleName, "dense_bytes", (double)denseBytes);
+		Benchmark::SetMetric(sampleName, "sparse_bytes", (double)state->brickMap.GetMemoryBytes());
+		Benchmark::SetMetric(sampleName, "sparse_to_dense_ratio", (double)state->brickMap.GetMemoryBytes() / (double)denseBytes);
+		Benchmark::SetMetric(sampleName, "bricks", state->brickMap.GetBrickCount());
+		Benchmark::SetMetric(sampleName, "occupied_voxels", occupiedVoxels);
+
+		// Every voxel of every mip and every filtered lookup must read the same as the dense grids
+		Benchmark::Check("BrickMap at " + size, { sampleName }, [state, sampleName]()
+		{
+			uint32_t mismatchedTexels = 0;
+
+			for (uint32_t mip = 0; mip < MipCount; ++mip)
+			{
+				const VoxelGrid& grid = state->grids[mip];
+				const uint32_t mipResolution = grid.GetResolution();
+
+				for (uint32_t z = 0; z < mipResolution; ++z)
+				{
+					for (uint32_t y = 0; y < mipResolution; ++y)
+					{
+						for (uint32_t x = 0; x < mipResolution; ++x)
+							mismatchedTexels += state->brickMap.Load(mip, x, y, z) != grid.GetTexels()[grid.GetIndex(x, y, z)] ? 1 : 0;
+					}
+				}
+			}
+
+			uint32_t mismatchedSamples = 0;
+
+			for (uint32_t i = 0; i < LookupCount; ++i)
+			{
+				float sample[4];
+				float denseSample[4];
+				state->brickMap.Sample(0, &state->positions[i * 3], sample);
+				SampleDense(state->grids[0], &state->positions[i * 3], denseSample);
+
+				for (uint32_t channel = 0; channel < 4; ++channel)
+					mismatchedSamples += std::fabs(sample[channel] - denseSample[channel]) > 1.0e-6f ? 1 : 0;
+			}
+
+			Benchmark::SetMetric(sampleName, "mismatched_texels", mismatchedTexels);
+			Benchmark::SetMetric(sampleName, "mismatched_samples", mismatchedSamples);
+
+			return mismatchedTexels + mismatchedSamples;
+		});
+
+		Benchmark::Register("DenseGrid::Sample/" + size, [state]()
+		{
+			float sum = 0.0f;
+
+			for (uint32_t i = 0; i < LookupCount; ++i)
+			{
+				float sample[4];
+				SampleDense(state->grids[0], &state->positions[i * 3], sample);
+				sum += sample[3];
+			}
+
+			Benchmark::DoNotOptimize(sum);
+		}, LookupCount);
+
+		Benchmark::Register("BrickMap::Load/" + size, [state]()
+		{
+			uint32_t sum = 0;
+
+			for (uint32_t i = 0; i < LookupCount; ++i)
+				sum += state->brickMap.Load(0, state->voxels[i * 3], state->voxels[i * 3 + 1], state->voxels[i * 3 + 2]) >> 24;
+
+			Benchmark::DoNotOptimize(sum);
+		}, LookupCount);
+
+		Benchmark::Register("DenseGrid::Load/" + size, [state]()
+		{
+			const VoxelGrid& grid = state->grids[0];
+			uint32_t sum = 0;
+
+			for (uint32_t i = 0; i < LookupCount; ++i)
+				sum += grid.GetTexels()[grid.GetIndex(state->voxels[i * 3], state->voxels[i * 3 + 1], state->voxels[i * 3 + 2])] >> 24;
+
+			Benchmark::DoNotOptimize(sum);
+		}, LookupCount);
+
+		// Re-uploading every mip of an unchanged scene, the bricks are only rewritten
+		Benchmark::Register("BrickMap::Update/" + size, [state]()
+		{
+			uint32_t changedBricks = 0;
+
+			for (uint32_t mip = 0; mip < MipCount; ++mip)
+				changedBricks += state->brickMap.Update(mip, state->grids[mip]);
+
+			Benchmark::DoNotOptimize(changedBricks);
+		}, texelCount);
+	}
+}
+
+void RegisterBrickMapBenchmarks()
+{
+	RegisterBrickMap(64);
+	RegisterBrickMap(128);
+	RegisterBrickMap(256);
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/DescriptorAllocator.h"
+
+#include <memory>
+
+namespace
+{
+	const uint32_t FrameCount = 3;
+
+	uint32_t CountDescriptorAllocatorErrors()
+	{
+		DescriptorAllocator allocator;
+		allocator.Reset(16, 8, FrameCount);
+
+		uint32_t errors = 0;
+		DescriptorHandle first, second, third, fourth;
+
+		errors += allocator.GetCapacity() != 16 + 8 * FrameCount ? 1 : 0;
+		errors += allocator.IsValid(DescriptorHandle()) ? 1 : 0;
+
+		errors += (!allocator.Allocate(4, first) || first.index != 0 || first.generation == 0) ? 1 : 0;
+		errors += (!allocator.Allocate(4, second) || second.index != 4) ? 1 : 0;
+		errors += (!allocator.Allocate(8, third) || third.index != 8) ? 1 : 0;
+		errors += allocator.Allocate(1, fourth) ? 1 : 0;
+		errors += allocator.GetPersistentUsedCount() != 16 ? 1 : 0;
+
+		// Stale right away, but the range stays in use until the fence completes
+		errors += !allocator.Free(second, 5) ? 1 : 0;
+		errors += (allocator.IsValid(second) || allocator.Free(second, 5)) ? 1 : 0;
+
+		allocator.BeginFrame(0, 4);
+		errors += allocator.Allocate(4, fourth) ? 1 : 0;
+
+		allocator.BeginFrame(1, 5);
+		errors += (!allocator.Allocate(4, fourth) || fourth.index != 4 || fourth.generation == second.generation) ? 1 : 0;
+		errors += (allocator.IsValid(second) || !allocator.IsValid(fourth)) ? 1 : 0;
+
+		// A handle only matches the range it was allocated with
+		DescriptorHandle resized = fourth;
+		resized.count = 2;
+		errors += allocator.IsValid(resized) ? 1 : 0;
+
+		// Freed out of order, the ranges merge back into one
+		allocator.Free(third, 6);
+		allocator.Free(first, 6);
+		allocator.Free(fourth, 6);
+		allocator.BeginFrame(2, 6);
+
+		errors += (allocator.GetFreeRangeCount() != 1 || allocator.GetLargestFreeRange() != 16 || allocator.GetPersistentUsedCount() != 0) ? 1 : 0;
+
+		// Every frame has a region of its own behind the persistent descriptors
+		uint32_t index = 0;
+
+		allocator.BeginFrame(1, 6);
+		errors += (!allocator.AllocateTransient(5, index) || index != 16 + 8) ? 1 : 0;
+		errors += allocator.AllocateTransient(4, index) ? 1 : 0;
+		errors += (!allocator.AllocateTransient(3, index) || index != 16 + 8 + 5) ? 1 : 0;
+
+		allocator.BeginFrame(2, 6);
+		errors += (allocator.GetTransientUsedCount() != 0 || !allocator.AllocateTransient(8, index) || index != 16 + 16) ? 1 : 0;
+
+		return errors;
+	}
+
+	struct ChurnState
+	{
+		DescriptorAllocator			allocator;
+		std::vector<DescriptorHandle>	liveHandles;
+
+		uint32_t					random = 12345;
+		uint64_t					frame = 0;
+		uint32_t					failedAllocations = 0;
+
+		uint32_t Next()
+		{
+			random = random * 1664525u + 1013904223u;
+			return random >> 8;
+		}
+	};
+
+	// One frame of a renderer that creates and destroys descriptor tables of 1 to 16 descriptors
+	// while recording a few hundred transient ones. Freed ranges come back once the frame resource
+	// is reused.
+	void RunChurnFrame(ChurnState& state, uint32_t operationsPerFrame, uint32_t transientTables)
+	{
+		++state.frame;
+		state.allocator.BeginFrame((uint32_t)(state.frame % FrameCount), state.frame > FrameCount ? state.frame - FrameCount : 0);
+
+		for (uint32_t i = 0; i < operationsPerFrame; ++i)
+		{
+			// Settles around 512 live tables
+			if (state.Next() % 1024 < state.liveHandles.size())
+			{
+				size_t slot = state.Next() % state.liveHandles.size();
+
+				state.allocator.Free(state.liveHandles[slot], state.frame);
+				state.liveHandles[slot] = state.liveHandles.back();
+				state.liveHandles.pop_back();
+			}
+			else
+			{
+				DescriptorHandle handle;
+
+				if (state.allocator.Allocate(1 + state.Next() % 16, handle))
+					state.liveHandles.push_back(handle);
+				else
+					++state.failedAllocations;
+			}
+		}
+
+		uint32_t index = 0;
+
+		for (uint32_t i = 0; i < transientTables; ++i)
+			Benchmark::DoNotOptimize(state.allocator.AllocateTransient(1 + i % 8, index));
+	}
+}
+
+void RegisterDescriptorAllocatorBenchmarks()
+{
+	const uint32_t operationsPerFrame = 256;
+	const uint32_t transientTables = 512;
+
+	auto state = std::make_shared<ChurnState>();
+	state->allocator.Reset(16384, 4096, FrameCount);
+
+	// Warmed up to a steady state
+	for (uint32_t i = 0; i < 256; ++i)
+		RunChurnFrame(*state, operationsPerFrame, transientTables);
+
+	std::string churnName = "DescriptorAllocator::Churn/256";
+
+	Benchmark::Register(churnName, [state, operationsPerFrame, transientTables]()
+	{
+		RunChurnFrame(*state, operationsPerFrame, transientTables);
+	}, operationsPerFrame + transientTables);
+
+	Benchmark::SetMetric(churnName, "live_tables", (double)state->liveHandles.size());
+	Benchmark::SetMetric(churnName, "persistent_used", state->allocator.GetPersistentUsedCount());
+	Benchmark::SetMetric(churnName, "free_ranges", state->allocator.GetFreeRangeCount());
+	Benchmark::SetMetric(churnName, "largest_free_range", state->allocator.GetLargestFreeRange());
+	Benchmark::SetMetric(churnName, "failed_allocations", state->failedAllocations);
+
+	Benchmark::Check("DescriptorAllocator", { churnName }, CountDescriptorAllocatorErrors);
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "Benchmark.h"
+#include "VoxelBenchmarkScene.h"
+#include "../Engine/Utilities/GICache.h"
+#include "../Engine/Utilities/SHUpdateScheduler.h"
+#include "../Engine/Utilities/ThreadPool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+using namespace DirectX;
+
+namespace
+{
+	const char* GICacheFilePath = "GICacheBenchmark.gicache";
+
+	void RemoveGICacheFiles()
+	{
+		std::remove(GICacheFilePath);
+		std::remove((std::string(GICacheFilePath) + ".bad").c_str());
+	}
+
+	struct GIStartState
+	{
+		InjectionFrame frame;
+		VoxelInjector injector;
+		VoxelGrid grids[VoxelInjector::MipCount];
+		VoxelGrid shGrids[GICache::SHGridCount];
+		SHUpdateScheduler scheduler;
+		std::vector<uint32_t> cells;
+		GICache cache;
+	};
+
+	bool SameGrids(const VoxelGrid* grids, const VoxelGrid* otherGrids, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (grids[i].GetTexelCount() != otherGrids[i].GetTexelCount() ||
+				std::memcmp(grids[i].GetTexels(), otherGrids[i].GetTexels(), grids[i].GetTexelCount() * sizeof(uint32_t)) != 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Renderer::Execute's start from empty grids: every frame injects, downsamples and cone traces the
+	// cells SHUpdateScheduler picks. Returns the frames until the SH grids stop changing, they are
+	// converged from that frame on, and the time those frames took. Noticing it takes a sweep of the grid.
+	uint32_t ConvergeFromEmptyGrids(GIStartState& state, const SHBakeSettings& settings, double& convergedMilliseconds)
+	{
+		const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		const float camera[3] = { 0.0f, 8.0f, -40.0f };
+
+		ResetGrids(state.grids);
+
+		for (uint32_t i = 0; i < GICache::SHGridCount; ++i)
+			state.shGrids[i].Reset(settings.gridResolution);
+
+		SHUpdateSettings updateSettings;
+		updateSettings.gridResolution = settings.gridResolution;
+		updateSettings.worldBoundary = settings.worldBoundary;
+		state.scheduler.Reset(updateSettings);
+
+		const uint32_t sweepFrames = (state.scheduler.GetCellCount() + state.scheduler.GetCellsPerFrame() - 1) / state.scheduler.GetCellsPerFrame();
+
+		VoxelGrid previousSHGrids[GICache::SHGridCount];
+		const uint32_t maxFrames = 128;
+		uint32_t lastChangedFrame = 0;
+		convergedMilliseconds = 0.0;
+
+		for (uint32_t frame = 1; frame <= maxFrames && frame - lastChangedFrame <= sweepFrames; ++frame)
+		{
+			state.injector.Inject(state.frame.input, state.grids, 1);
+			VoxelMipBuilder::BuildMips(state.grids, VoxelInjector::MipCount);
+
+			for (uint32_t i = 0; i < GICache::SHGridCount; ++i)
+				previousSHGrids[i] = state.shGrids[i];
+
+			state.scheduler.Schedule(camera, state.cells);
+			SHGridBaker::BakeCells(settings, state.grids, state.cells.data(), state.cells.size(), state.shGrids);
+
+			if (!SameGrids(state.shGrids, previousSHGrids, GICache::SHGridCount))
+			{
+				lastChangedFrame = frame;
+				convergedMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+			}
+		}
+
+		return lastChangedFrame;
+	}
+
+	// Time to converged indirect lighting with and without a cache saved by an earlier run
+	void RegisterGICache(uint32_t width, uint32_t height)
+	{
+		auto state = std::make_shared<GIStartState>();
+		BuildInjectionFrame(state->frame, width, height);
+
+		const SHBakeSettings settings = GetSHBakeSettings();
+
+		double coldMilliseconds = 0.0;
+		const uint32_t coldFrames = ConvergeFromEmptyGrids(*state, settings, coldMilliseconds);
+
+		GICacheKey key;
+		key.sceneName = "VoxelInjectionBenchmark";
+		key.contentHash = GICache::Hash(state->frame.lighting.data(), state->frame.lighting.size() * sizeof(XMFLOAT4));
+		key.worldBoundary = WorldVolumeBoundary;
+		key.voxelResolution = VoxelResolution;
+		key.voxelMipCount = VoxelInjector::MipCount;
+		key.shGridResolution = settings.gridResolution;
+
+		std::atexit(RemoveGICacheFiles);
+
+		std::string size = std::to_string(width) + "x" + std::to_string(height);
+
+		// The warm start loads this file
+		if (!GICache::Save(GICacheFilePath, key, state->grids, state->shGrids))
+			Benchmark::ReportFailure("GICache::Save at " + size);
+
+		std::string coldName = "GICache::ColdStart/" + size;
+
+		Benchmark::Register(coldName, [state, settings]()
+		{
+			double convergedMilliseconds = 0.0;
+			Benchmark::DoNotOptimize(ConvergeFromEmptyGrids(*state, settings, convergedMilliseconds));
+		}, 1);
+
+		Benchmark::SetMetric(coldName, "frames_to_converge", coldFrames);
+		Benchmark::SetMetric(coldName, "converged_ms", coldMilliseconds);
+		Benchmark::SetMetric(coldName, "threads", ThreadPool::GetThreadCount());
+
+		std::string warmName = "GICache::WarmStart/" + size;
+
+		Benchmark::Register(warmName, [state, key]()
+		{
+			Benchmark::DoNotOptimize(state->cache.Open(GICacheFilePath, key));
+			state->cache.CopyTo(state->grids, state->shGrids);
+			state->cache.Close();
+		}, 1);
+
+		Benchmark::SetMetric(warmName, "frames_to_converge", 0);
+
+		// What was saved has to come back texel for texel, and caches of other content or corrupted
+		// ones have to be turned down
+		Benchmark::Check("GICache at " + size, { warmName }, [state, key, warmName]()
+		{
+			VoxelGrid loadedGrids[VoxelInjector::MipCount];
+			VoxelGrid loadedSHGrids[GICache::SHGridCount];
+
+			const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+			uint32_t errors = state->cache.Open(GICacheFilePath, key) == GICacheStatus::Loaded ? 0 : 1;
+
+			if (state->cache.IsOpen())
+				state->cache.CopyTo(loadedGrids, loadedSHGrids);
+
+			const double warmMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+			const size_t fileBytes = state->cache.GetFileSize();
+
+			errors += SameGrids(loadedGrids, state->grids, VoxelInjector::MipCount) ? 0 : 1;
+			errors += SameGrids(loadedSHGrids, state->shGrids, GICache::SHGridCount) ? 0 : 1;
+			state->cache.Close();
+
+			GICacheKey staleKey = key;
+			staleKey.contentHash ^= 1;
+			errors += state->cache.Open(GICacheFilePath, staleKey) == GICacheStatus::Stale ? 0 : 1;
+
+			// A cache written with an older texel encoding is stale too
+			staleKey = key;
+			--staleKey.texelEncoding;
+			errors += state->cache.Open(GICacheFilePath, staleKey) == GICacheStatus::Stale ? 0 : 1;
+
+			// A flipped texel has to fail the checksum
+			const std::string corruptedFilePath = std::string(GICacheFilePath) + ".bad";
+			std::vector<uint8_t> corruptedFile;
+
+			{
+				MappedFile savedFile;
+
+				if (savedFile.Open(GICacheFilePath))
+					corruptedFile.assign(savedFile.GetData(), savedFile.GetData() + savedFile.GetSize());
+			}
+
+			if (!corruptedFile.empty())
+				corruptedFile.back() ^= 1;
+
+			std::ofstream(corruptedFilePath, std::ios::binary).write(reinterpret_cast<const char*>(corruptedFile.data()), (std::streamsize)corruptedFile.size());
+
+			errors += state->cache.Open(corruptedFilePath, key) == GICacheStatus::Invalid ? 0 : 1;
+			errors += state->cache.Open("Missing.gicache", key) == GICacheStatus::Missing ? 0 : 1;
+			state->cache.Close();
+
+			Benchmark::SetMetric(warmName, "converged_ms", warmMilliseconds);
+			Benchmark::SetMetric(warmName, "file_bytes", (double)fileBytes);
+
+			return errors;
+		});
+
+		Benchmark::Register("GICache::Save/" + size, [state, key]()
+		{
+			Benchmark::DoNotOptimize(GICache::Save(GICacheFilePath, key, state->grids, state->shGrids));
+		}, 1);
+	}
+}
+
+void RegisterGICacheBenchmarks()
+{
+	RegisterGICache(1280, 720);
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "Benchmark.h"
+#include "VoxelBenchmarkScene.h"
+#include "../Engine/Utilities/GICache.h"
+#include "../Engine/Utilities/GIStatistics.h"
+#include "../Engine/Utilities/InjectionChangeDetector.h"
+#include "../Engine/Utilities/SHUpdateScheduler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace
+{
+	struct GIStatisticsState
+	{
+		InjectionFrame frame;
+		VoxelInjector injector;
+		VoxelGrid grids[VoxelInjector::MipCount];
+		VoxelGrid shGrids[GICache::SHGridCount];
+		InjectionChangeDetector detector;
+		SHUpdateScheduler scheduler;
+		std::vector<uint32_t> cells;
+		GIStatistics statistics;
+	};
+
+	const char* GIStatisticsFilePath = "GIStatisticsBenchmark.gistats.csv";
+	const char* GICellEnergyFilePath = "GIStatisticsBenchmark.gicells.csv";
+
+	uint32_t CountCSVRows(const char* filePath)
+	{
+		std::ifstream file(filePath);
+		std::string line;
+		uint32_t rows = 0;
+
+		while (std::getline(file, line))
+			++rows;
+
+		return rows;
+	}
+
+	// Renderer::Execute along the walk, measured every frame: injection where InjectionChangeDetector
+	// finds something new, downsampling and the SH cells SHUpdateScheduler picks. When injection runs,
+	// every cell counts as changed instead of those around the injected rectangles.
+	void RegisterGIStatistics(uint32_t width, uint32_t height)
+	{
+		auto state = std::make_shared<GIStatisticsState>();
+		const SHBakeSettings settings = GetSHBakeSettings();
+
+		InjectionChangeSettings changeSettings;
+		changeSettings.worldBoundary = WorldVolumeBoundary;
+		state->detector.Reset(changeSettings);
+
+		SHUpdateSettings updateSettings;
+		updateSettings.gridResolution = settings.gridResolution;
+		updateSettings.worldBoundary = settings.worldBoundary;
+		state->scheduler.Reset(updateSettings);
+
+		ResetGrids(state->grids);
+
+		for (uint32_t i = 0; i < GICache::SHGridCount; ++i)
+			state->shGrids[i].Reset(settings.gridResolution);
+
+		std::string measureName = "GIStatistics::AddFrame/" + std::to_string(settings.gridResolution);
+
+		Benchmark::Register(measureName, [state, settings]()
+		{
+			// Only the latest frame is kept, the history would otherwise grow with every iteration
+			if (state->statistics.GetFrames().size() >= 2 * PathFrameCount)
+				state->statistics.Reset();
+
+			Benchmark::DoNotOptimize(state->statistics.AddFrame(settings, state->grids, state->shGrids, VoxelInjectionStatistics()).coneSamples);
+		}, state->scheduler.GetCellCount() * SHGridBaker::ConeCount);
+
+		// Walks the path once before the case is timed, the case measures on the grids the walk ended with
+		Benchmark::Check("GIStatistics", { measureName }, [state, settings, width, height, measureName]()
+		{
+			uint32_t errors = 0;
+			uint64_t writes = 0;
+			double measureMilliseconds = 0.0;
+
+			for (uint32_t frame = 0; frame < PathFrameCount; ++frame)
+			{
+				float eye[3];
+				float yaw = 0.0f;
+				const bool bMoved = GetPathCamera(frame, eye, yaw);
+
+				if (frame == 0 || bMoved)
+					BuildInjectionFrame(state->frame, width, height, eye, yaw);
+
+				VoxelInjectionStatistics injection;
+				const InjectionDecision decision = state->detector.Detect(state->frame.view);
+
+				if (decision != InjectionDecision::Skip)
+				{
+					VoxelInjectionInput input = state->frame.input;
+					input.tileMask = decision == InjectionDecision::Tiles ? state->detector.GetTileMask() : nullptr;
+					input.statistics = &injection;
+
+					const uint32_t frameWrites = state->injector.Inject(input, state->grids, 1);
+					errors += frameWrites != injection.writtenEmpty[0] + injection.writtenNearer[0] ? 1 : 0;
+					errors += CountUnaccountedPixels(injection, 1);
+					writes += frameWrites;
+
+					VoxelMipBuilder::BuildMips(state->grids, VoxelInjector::MipCount);
+					state->scheduler.MarkAllChanged();
+				}
+
+				state->scheduler.Schedule(eye, state->cells);
+				SHGridBaker::BakeCells(settings, state->grids, state->cells.data(), state->cells.size(), state->shGrids);
+
+				const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+				const GIFrameStatistics& statistics = state->statistics.AddFrame(settings, state->grids, state->shGrids, injection);
+				measureMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+				uint32_t stoppedCones = statistics.missedCones;
+
+				for (uint32_t mip = 0; mip < SHGridBaker::MipCount; ++mip)
+					stoppedCones += statistics.hitCones[mip];
+
+				errors += statistics.cones != state->scheduler.GetCellCount() * SHGridBaker::ConeCount || stoppedCones != statistics.cones ? 1 : 0;
+			}
+
+			// The injector counts the same with and without the thread pool
+			VoxelGrid referenceGrids[VoxelInjector::MipCount];
+			VoxelInjectionStatistics statistics;
+			VoxelInjectionStatistics referenceStatistics;
+
+			for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+				referenceGrids[mip] = state->grids[mip];
+
+			VoxelInjectionInput input = state->frame.input;
+			input.statistics = &statistics;
+			state->injector.Inject(input, state->grids, VoxelInjector::MipCount);
+
+			input.statistics = &referenceStatistics;
+			VoxelInjector::InjectSerial(input, referenceGrids, VoxelInjector::MipCount);
+
+			errors += std::memcmp(&statistics, &referenceStatistics, sizeof(VoxelInjectionStatistics)) != 0 ? 1 : 0;
+			errors += CountUnaccountedPixels(statistics, VoxelInjector::MipCount);
+
+			// A header and a row per frame, and per frame and cell
+			errors += !state->statistics.ExportCSV(GIStatisticsFilePath) || CountCSVRows(GIStatisticsFilePath) != PathFrameCount + 1 ? 1 : 0;
+			errors += !state->statistics.ExportCellEnergyCSV(GICellEnergyFilePath)
+				|| CountCSVRows(GICellEnergyFilePath) != PathFrameCount * state->statistics.GetCellCount() + 1 ? 1 : 0;
+
+			std::remove(GIStatisticsFilePath);
+			std::remove(GICellEnergyFilePath);
+
+			// Totals of the walk
+			VoxelInjectionStatistics injection;
+			uint64_t cones = 0;
+			uint64_t coneSamples = 0;
+			uint64_t hitMipSum = 0;
+			uint64_t hitCones = 0;
+
+			for (const GIFrameStatistics& frame : state->statistics.GetFrames())
+			{
+				injection.Add(frame.injection);
+				cones += frame.cones;
+				coneSamples += frame.coneSamples;
+
+				for (uint32_t mip = 0; mip < SHGridBaker::MipCount; ++mip)
+				{
+					hitCones += frame.hitCones[mip];
+					hitMipSum += (uint64_t)frame.hitCones[mip] * mip;
+				}
+			}
+
+			const uint64_t tests = injection.writtenEmpty[0] + injection.writtenNearer[0] + injection.rejectedFarther[0] + injection.rejectedDarker[0];
+			const GIFrameStatistics& last = state->statistics.GetFrames().back();
+
+			Benchmark::SetMetric(measureName, "path_frames", PathFrameCount);
+			Benchmark::SetMetric(measureName, "path_measure_ms", measureMilliseconds);
+			Benchmark::SetMetric(measureName, "path_writes", (double)writes);
+			Benchmark::SetMetric(measureName, "path_background_fraction", (double)injection.backgroundPixels / (double)injection.pixels);
+			Benchmark::SetMetric(measureName, "path_outside_volume_fraction", (double)injection.outsideVolume[0] / (double)injection.pixels);
+			Benchmark::SetMetric(measureName, "path_written_empty_fraction", (double)injection.writtenEmpty[0] / (double)tests);
+			Benchmark::SetMetric(measureName, "path_written_nearer_fraction", (double)injection.writtenNearer[0] / (double)tests);
+			Benchmark::SetMetric(measureName, "path_rejected_farther_fraction", (double)injection.rejectedFarther[0] / (double)tests);
+			Benchmark::SetMetric(measureName, "path_rejected_darker_fraction", (double)injection.rejectedDarker[0] / (double)tests);
+			Benchmark::SetMetric(measureName, "path_mean_cone_samples", (double)coneSamples / (double)cones);
+			Benchmark::SetMetric(measureName, "path_mean_hit_mip", hitCones > 0 ? (double)hitMipSum / (double)hitCones : 0.0);
+			Benchmark::SetMetric(measureName, "path_missed_cone_fraction", (double)(cones - hitCones) / (double)cones);
+			Benchmark::SetMetric(measureName, "final_filled_voxels", last.filledVoxels[0]);
+			Benchmark::SetMetric(measureName, "final_sh_mean_energy", last.meanEnergy);
+
+			return errors;
+		});
+	}
+}
+
+void RegisterGIStatisticsBenchmarks()
+{
+	RegisterGIStatistics(1280, 720);
+}
\ No newline at end of file
@@ -0,0 +1,470 @@
+#include "Benchmark.h"
+#include "VoxelBenchmarkScene.h"
+#include "../Engine/Utilities/InjectionChangeDetector.h"
+#include "../Engine/Utilities/SHUpdateScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+using namespace DirectX;
+
+namespace
+{
+	const float Pi = 3.14159265f;
+
+	// DemoApp's camera: a left handed perspective with a 60 degree vertical field of view, turned by
+	// a yaw around the up axis, then rolled around the view axis
+	InjectionView MakeView(const float* eye, float yaw, float roll, uint32_t width, uint32_t height, float fovY = Pi / 3.0f)
+	{
+		const float nearZ = 1.0f;
+		const float farZ = 500.0f;
+		const float yScale = 1.0f / std::tan(fovY * 0.5f);
+		const float xScale = yScale * (float)height / (float)width;
+
+		const float forward[3] = { std::sin(yaw), 0.0f, std::cos(yaw) };
+		const float flatRight[3] = { std::cos(yaw), 0.0f, -std::sin(yaw) };
+		const float right[3] = { flatRight[0] * std::cos(roll), std::sin(roll), flatRight[2] * std::cos(roll) };
+		const float up[3] = { -flatRight[0] * std::sin(roll), std::cos(roll), -flatRight[2] * std::sin(roll) };
+
+		InjectionView view;
+		view.width = width;
+		view.height = height;
+		view.lightDirection = XMFLOAT3(0.5f, -0.5f, 0.5f);
+		view.lightStrength = XMFLOAT3(1.0f, 1.0f, 1.0f);
+
+		view.invView = XMFLOAT4X4(
+			right[0], right[1], right[2], 0.0f,
+			up[0], up[1], up[2], 0.0f,
+			forward[0], forward[1], forward[2], 0.0f,
+			eye[0], eye[1], eye[2], 1.0f);
+
+		view.view = XMFLOAT4X4(
+			right[0], up[0], forward[0], 0.0f,
+			right[1], up[1], forward[1], 0.0f,
+			right[2], up[2], forward[2], 0.0f,
+			-(eye[0] * right[0] + eye[1] * right[1] + eye[2] * right[2]),
+			-(eye[0] * up[0] + eye[1] * up[1] + eye[2] * up[2]),
+			-(eye[0] * forward[0] + eye[1] * forward[1] + eye[2] * forward[2]), 1.0f);
+
+		view.proj = XMFLOAT4X4(
+			xScale, 0.0f, 0.0f, 0.0f,
+			0.0f, yScale, 0.0f, 0.0f,
+			0.0f, 0.0f, farZ / (farZ - nearZ), 1.0f,
+			0.0f, 0.0f, -nearZ * farZ / (farZ - nearZ), 0.0f);
+
+		view.invProj = XMFLOAT4X4(
+			1.0f / xScale, 0.0f, 0.0f, 0.0f,
+			0.0f, 1.0f / yScale, 0.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, -(farZ - nearZ) / (nearZ * farZ),
+			0.0f, 0.0f, 1.0f, 1.0f / nearZ);
+
+		return view;
+	}
+
+	// The rectangles cover the mask's tiles exactly, once each, and there is room for them
+	uint32_t CountMaskErrors(const InjectionChangeDetector& detector)
+	{
+		const uint32_t tileCount = detector.GetTilesX() * detector.GetTilesY();
+		std::vector<uint32_t> coverage(tileCount, 0);
+		uint32_t errors = detector.GetRects().size() > InjectionChangeDetector::MaxRects ? 1 : 0;
+
+		for (const InjectionRect& rect : detector.GetRects())
+		{
+			errors += rect.width == 0 || rect.height == 0 || rect.x + rect.width > detector.GetTilesX()
+				|| rect.y + rect.height > detector.GetTilesY() ? 1 : 0;
+
+			for (uint32_t y = rect.y; y < std::min(rect.y + rect.height, detector.GetTilesY()); ++y)
+			{
+				for (uint32_t x = rect.x; x < std::min(rect.x + rect.width, detector.GetTilesX()); ++x)
+					++coverage[y * detector.GetTilesX() + x];
+			}
+		}
+
+		uint32_t maskedTiles = 0;
+
+		for (uint32_t tile = 0; tile < tileCount; ++tile)
+		{
+			const uint32_t masked = detector.GetTileMask()[tile] != 0 ? 1 : 0;
+			errors += coverage[tile] != masked ? 1 : 0;
+			maskedTiles += masked;
+		}
+
+		errors += maskedTiles != detector.GetTileCount() ? 1 : 0;
+
+		return errors;
+	}
+
+	// Row vector times matrix
+	void Transform(const float* point, const XMFLOAT4X4& matrix, float* result)
+	{
+		for (uint32_t column = 0; column < 4; ++column)
+		{
+			result[column] = point[0] * matrix.m[0][column] + point[1] * matrix.m[1][column]
+				+ point[2] * matrix.m[2][column] + point[3] * matrix.m[3][column];
+		}
+	}
+
+	// SH cells around the voxels the rectangles can inject into, as Renderer::ScheduleSHUpdates() marks them
+	uint32_t CountChangedCells(const InjectionChangeDetector& detector)
+	{
+		SHUpdateSettings settings;
+		settings.worldBoundary = detector.GetSettings().worldBoundary;
+
+		SHUpdateScheduler scheduler;
+		scheduler.Reset(settings);
+
+		const float cameraPosition[3] = { 0.0f, 0.0f, 0.0f };
+		std::vector<uint32_t> cells;
+
+		// Nothing is left changed after a sweep
+		for (uint32_t frame = 0; frame < scheduler.GetCellCount() / scheduler.GetCellsPerFrame(); ++frame)
+			scheduler.Schedule(cameraPosition, cells);
+
+		for (uint32_t rect = 0; rect < (uint32_t)detector.GetRects().size(); ++rect)
+		{
+			for (uint32_t slice = 0; slice < InjectionChangeDetector::DepthSlices; ++slice)
+			{
+				float boxMin[3], boxMax[3];
+
+				if (detector.GetInjectedBounds(rect, slice, boxMin, boxMax))
+					scheduler.MarkChanged(boxMin, boxMax);
+			}
+		}
+
+		uint32_t changedCells = 0;
+
+		for (uint32_t cell = 0; cell < scheduler.GetCellCount(); ++cell)
+			changedCells += scheduler.IsChanged(cell) ? 1 : 0;
+
+		return changedCells;
+	}
+
+	// Points inside the volume on the rays through a rectangle's pixels, from the near plane on, have
+	// to be inside its injected bounds
+	uint32_t CountBoundsErrors(const InjectionChangeDetector& detector, const InjectionView& view)
+	{
+		const float worldBoundary = detector.GetSettings().worldBoundary;
+		const uint32_t tileSize = InjectionChangeDetector::TileSize;
+		const uint32_t pixelSteps = 4;
+		uint32_t errors = 0;
+
+		for (uint32_t rectIndex = 0; rectIndex < (uint32_t)detector.GetRects().size(); ++rectIndex)
+		{
+			const InjectionRect& rect = detector.GetRects()[rectIndex];
+			float boxMins[InjectionChangeDetector::DepthSlices][3], boxMaxs[InjectionChangeDetector::DepthSlices][3];
+			bool bSeesVolume[InjectionChangeDetector::DepthSlices];
+
+			for (uint32_t slice = 0; slice < InjectionChangeDetector::DepthSlices; ++slice)
+				bSeesVolume[slice] = detector.GetInjectedBounds(rectIndex, slice, boxMins[slice], boxMaxs[slice]);
+
+			for (uint32_t stepY = 0; stepY <= pixelSteps; ++stepY)
+			{
+				for (uint32_t stepX = 0; stepX <= pixelSteps; ++stepX)
+				{
+					const float pixelX = (float)(rect.x * tileSize) + (float)(rect.width * tileSize * stepX) / (float)pixelSteps;
+					const float pixelY = (float)(rect.y * tileSize) + (float)(rect.height * tileSize * stepY) / (float)pixelSteps;
+
+					// The ray at a view depth of one
+					const float clipPoint[4] = { pixelX / (float)view.width * 2.0f - 1.0f, pixelY / (float)view.height * 2.0f - 1.0f, 0.0f, 1.0f };
+					float viewPoint[4];
+					Transform(clipPoint, view.invProj, viewPoint);
+
+					for (uint32_t i = 0; i < 3; ++i)
+						viewPoint[i] /= viewPoint[2];
+
+					for (float depth = 1.0f; depth < 200.0f; depth += 0.5f)
+					{
+						const float depthPoint[4] = { viewPoint[0] * depth, viewPoint[1] * depth, depth, 1.0f };
+						float point[4];
+						Transform(depthPoint, view.invView, point);
+
+						bool bInVolume = true;
+						bool bInBounds = false;
+
+						for (uint32_t axis = 0; axis < 3; ++axis)
+							bInVolume = bInVolume && std::fabs(point[axis]) <= worldBoundary;
+
+						for (uint32_t slice = 0; slice < InjectionChangeDetector::DepthSlices && !bInBounds; ++slice)
+						{
+							bInBounds = bSeesVolume[slice];
+
+							for (uint32_t axis = 0; axis < 3; ++axis)
+								bInBounds = bInBounds && point[axis] >= boxMins[slice][axis] - 1e-3f && point[axis] <= boxMaxs[slice][axis] + 1e-3f;
+						}
+
+						errors += bInVolume && !bInBounds ? 1 : 0;
+					}
+				}
+			}
+		}
+
+		return errors;
+	}
+
+	uint32_t CountInjectionChangeDetectorErrors()
+	{
+		uint32_t errors = 0;
+		const uint32_t width = 1280;
+		const uint32_t height = 720;
+		const uint32_t tilesX = width / InjectionChangeDetector::TileSize;
+		const uint32_t tilesY = height / InjectionChangeDetector::TileSize;
+		const float eye[3] = { 0.0f, 8.0f, -40.0f };
+
+		InjectionChangeSettings settings;
+		settings.refreshFrames = 100;
+
+		InjectionChangeDetector detector;
+		detector.Reset(settings);
+
+		// The first frame goes whole, the same again not at all
+		InjectionView view = MakeView(eye, 0.0f, 0.0f, width, height);
+		errors += detector.Detect(view) != InjectionDecision::Full || !detector.HasSceneChanged() ? 1 : 0;
+		errors += detector.GetTileCount() != tilesX * tilesY || detector.GetRects().size() != 1 ? 1 : 0;
+		errors += CountMaskErrors(detector);
+		errors += CountBoundsErrors(detector, view);
+
+		const uint32_t fullCells = CountChangedCells(detector);
+
+		errors += detector.Detect(view) != InjectionDecision::Skip || detector.HasSceneChanged() ? 1 : 0;
+		errors += detector.GetTileCount() != 0 || !detector.GetRects().empty() ? 1 : 0;
+		errors += CountMaskErrors(detector);
+		errors += CountBoundsErrors(detector, view);
+
+		// Turning right uncovers the right edge, a degree is a column or two of tiles, and a sliver along
+		// the top and bottom of about the right half, which the turn tilts into view. Nothing on the left.
+		view = MakeView(eye, Pi / 180.0f, 0.0f, width, height);
+		errors += detector.Detect(view) != InjectionDecision::Tiles || detector.HasSceneChanged() ? 1 : 0;
+		errors += CountMaskErrors(detector);
+		errors += detector.GetTileCount() > tilesX * tilesY / 20 ? 1 : 0;
+		errors += CountBoundsErrors(detector, view);
+
+		// The SH cells marked changed are those around a part of what the whole screen sees
+		errors += CountChangedCells(detector) >= fullCells ? 1 : 0;
+
+		for (uint32_t tileY = 0; tileY < tilesY; ++tileY)
+		{
+			errors += detector.GetTileMask()[tileY * tilesX + tilesX - 1] == 0 ? 1 : 0;
+
+			for (uint32_t tileX = 0; tileX < tilesX / 3; ++tileX)
+				errors += detector.GetTileMask()[tileY * tilesX + tileX] != 0 ? 1 : 0;
+		}
+
+		// Stopping injects everything once, for what the moving camera uncovered behind nearer surfaces
+		errors += detector.Detect(view) != InjectionDecision::Full || detector.HasSceneChanged() ? 1 : 0;
+		errors += detector.Detect(view) != InjectionDecision::Skip ? 1 : 0;
+
+		// Moving forward shows nothing new around the edges, moving back shows a ring of them
+		const float forwardEye[3] = { eye[0] + 0.1f * std::sin(Pi / 180.0f), eye[1], eye[2] + 0.1f * std::cos(Pi / 180.0f) };
+		errors += detector.Detect(MakeView(forwardEye, Pi / 180.0f, 0.0f, width, height)) != InjectionDecision::Skip ? 1 : 0;
+
+		errors += detector.Detect(view) != InjectionDecision::Tiles ? 1 : 0;
+		errors += CountMaskErrors(detector);
+
+		errors += CountBoundsErrors(detector, view);
+
+		const uint8_t* mask = detector.GetTileMask();
+		errors += mask[0] == 0 || mask[tilesX - 1] == 0 || mask[(tilesY - 1) * tilesX] == 0 || mask[tilesY / 2 * tilesX + tilesX / 2] != 0 ? 1 : 0;
+
+		// Rolling uncovers the corners, as staircases of more runs than there is room for
+		const InjectionView rolledView = MakeView(eye, Pi / 180.0f, 0.05f, width, height);
+		errors += detector.Detect(rolledView) != InjectionDecision::Tiles ? 1 : 0;
+		errors += CountMaskErrors(detector);
+		errors += CountBoundsErrors(detector, rolledView);
+
+		// The light, the scene, the projection and the size each send the whole screen
+		detector.Detect(view);
+		detector.Detect(view);
+
+		InjectionView changedView = view;
+		changedView.lightDirection.y = -0.6f;
+		errors += detector.Detect(changedView) != InjectionDecision::Full || !detector.HasSceneChanged() ? 1 : 0;
+
+		changedView.bSceneChanged = true;
+		errors += detector.Detect(changedView) != InjectionDecision::Full || !detector.HasSceneChanged() ? 1 : 0;
+
+		changedView.bSceneChanged = false;
+		errors += detector.Detect(changedView) != InjectionDecision::Skip ? 1 : 0;
+
+		changedView = MakeView(eye, Pi / 180.0f, 0.0f, width, height, Pi / 4.0f);
+		errors += detector.Detect(changedView) != InjectionDecision::Full ? 1 : 0;
+
+		changedView = MakeView(eye, Pi / 180.0f, 0.0f, 1920, 1080, Pi / 4.0f);
+		errors += detector.Detect(changedView) != InjectionDecision::Full || detector.GetTileCount() != 120 * 67 ? 1 : 0;
+		errors += CountMaskErrors(detector);
+
+		const InjectionCounters& counters = detector.GetCounters();
+		errors += counters.frames != counters.skippedFrames + counters.tileFrames + counters.fullFrames ? 1 : 0;
+
+		// While the camera keeps moving, the whole screen goes every refreshFrames frames
+		settings.refreshFrames = 4;
+		detector.Reset(settings);
+		detector.Detect(MakeView(eye, 0.0f, 0.0f, width, height));
+
+		for (uint32_t frame = 1; frame <= 8; ++frame)
+		{
+			const InjectionDecision expected = frame % 4 == 0 ? InjectionDecision::Full : InjectionDecision::Tiles;
+			errors += detector.Detect(MakeView(eye, (float)frame * Pi / 360.0f, 0.0f, width, height)) != expected ? 1 : 0;
+		}
+
+		errors += detector.GetCounters().frames != 9 || detector.GetCounters().fullFrames != 3 || detector.GetCounters().tileFrames != 6 ? 1 : 0;
+
+		return errors;
+	}
+
+	struct DetectState
+	{
+		InjectionChangeDetector detector;
+		uint32_t frame = 0;
+	};
+
+	// The camera turning half a degree a frame, never refreshed whole
+	InjectionDecision RunPanFrame(DetectState& state, uint32_t width, uint32_t height)
+	{
+		const float eye[3] = { 0.0f, 8.0f, -40.0f };
+		const float yaw = (float)(state.frame++ % 720) * Pi / 360.0f;
+
+		return state.detector.Detect(MakeView(eye, yaw, 0.0f, width, height));
+	}
+
+	struct ChangeDetectionState
+	{
+		InjectionFrame frame;
+		VoxelInjector injector;
+		InjectionChangeDetector detector;
+		VoxelGrid grids[VoxelInjector::MipCount];
+		std::vector<uint8_t> tileMask;
+	};
+
+	// Injecting only when and where InjectionChangeDetector finds something new, against injecting the
+	// whole screen every frame, along the walk
+	void RegisterChangeDetection(uint32_t width, uint32_t height)
+	{
+		auto state = std::make_shared<ChangeDetectionState>();
+
+		InjectionChangeSettings settings;
+		settings.worldBoundary = WorldVolumeBoundary;
+		state->detector.Reset(settings);
+
+		VoxelGrid referenceGrids[VoxelInjector::MipCount];
+		ResetGrids(referenceGrids);
+		ResetGrids(state->grids);
+
+		double referenceMilliseconds = 0.0;
+		double detectedMilliseconds = 0.0;
+		uint32_t maxMismatchedTexels = 0;
+		uint32_t mismatchedTexels = 0;
+
+		for (uint32_t frame = 0; frame < PathFrameCount; ++frame)
+		{
+			float eye[3];
+			float yaw = 0.0f;
+			const bool bMoved = GetPathCamera(frame, eye, yaw);
+
+			if (frame == 0 || bMoved)
+				BuildInjectionFrame(state->frame, width, height, eye, yaw);
+
+			std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+			state->injector.Inject(state->frame.input, referenceGrids, 1);
+			referenceMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+			startTime = std::chrono::steady_clock::now();
+			const InjectionDecision decision = state->detector.Detect(state->frame.view);
+
+			if (decision != InjectionDecision::Skip)
+			{
+				VoxelInjectionInput input = state->frame.input;
+				input.tileMask = decision == InjectionDecision::Tiles ? state->detector.GetTileMask() : nullptr;
+				state->injector.Inject(input, state->grids, 1);
+			}
+
+			detectedMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+			mismatchedTexels = CountMismatchedTexels(state->grids, referenceGrids, 1);
+			maxMismatchedTexels = std::max(maxMismatchedTexels, mismatchedTexels);
+		}
+
+		const InjectionCounters counters = state->detector.GetCounters();
+		std::string size = std::to_string(width) + "x" + std::to_string(height);
+
+		// A frame of the turn, the tiles it uncovers injected
+		float eye[3];
+		float yaw = 0.0f;
+		state->detector.Reset(settings);
+		GetPathCamera(8, eye, yaw);
+		BuildInjectionFrame(state->frame, width, height, eye, yaw);
+		state->detector.Detect(state->frame.view);
+
+		GetPathCamera(9, eye, yaw);
+		BuildInjectionFrame(state->frame, width, height, eye, yaw);
+		state->detector.Detect(state->frame.view);
+
+		state->tileMask.assign(state->detector.GetTileMask(), state->detector.GetTileMask() + state->detector.GetTilesX() * state->detector.GetTilesY());
+		state->frame.input.tileMask = state->tileMask.data();
+
+		const uint64_t tilePixelCount = (uint64_t)state->detector.GetTileCount() * InjectionChangeDetector::TileSize * InjectionChangeDetector::TileSize;
+		std::string tilesName = "VoxelInjection::InjectExposedTiles/" + size;
+
+		Benchmark::Register(tilesName, [state]()
+		{
+			Benchmark::DoNotOptimize(state->injector.Inject(state->frame.input, state->grids, 1));
+		}, tilePixelCount);
+
+		Benchmark::SetMetric(tilesName, "exposed_tiles", state->detector.GetTileCount());
+		Benchmark::SetMetric(tilesName, "tiles", state->detector.GetTilesX() * state->detector.GetTilesY());
+		Benchmark::SetMetric(tilesName, "path_frames", (double)counters.frames);
+		Benchmark::SetMetric(tilesName, "path_skipped_frames", (double)counters.skippedFrames);
+		Benchmark::SetMetric(tilesName, "path_tile_frames", (double)counters.tileFrames);
+		Benchmark::SetMetric(tilesName, "path_full_frames", (double)counters.fullFrames);
+		Benchmark::SetMetric(tilesName, "path_injected_tile_fraction", (double)counters.injectedTiles / (double)(counters.injectedTiles + counters.skippedTiles));
+		Benchmark::SetMetric(tilesName, "path_inject_ms", detectedMilliseconds);
+		Benchmark::SetMetric(tilesName, "path_always_inject_ms", referenceMilliseconds);
+		// Finest texels unlike injecting every frame, at most along the walk and once it stood still
+		Benchmark::SetMetric(tilesName, "path_max_mismatched_texels", maxMismatchedTexels);
+		Benchmark::SetMetric(tilesName, "path_final_mismatched_texels", mismatchedTexels);
+	}
+}
+
+void RegisterInjectionChangeDetectorBenchmarks()
+{
+	const uint32_t resolutions[][2] = { { 1280, 720 }, { 1920, 1080 } };
+	std::vector<std::string> detectNames;
+
+	for (const auto& resolution : resolutions)
+	{
+		auto state = std::make_shared<DetectState>();
+
+		InjectionChangeSettings settings;
+		settings.refreshFrames = UINT32_MAX;
+		state->detector.Reset(settings);
+
+		RunPanFrame(*state, resolution[0], resolution[1]);
+		RunPanFrame(*state, resolution[0], resolution[1]);
+
+		const uint32_t width = resolution[0];
+		const uint32_t height = resolution[1];
+		std::string detectName = "InjectionChangeDetector::Detect/" + std::to_string(width) + "x" + std::to_string(height);
+
+		// Measured before the timing moves the camera on
+		const uint32_t exposedTiles = state->detector.GetTileCount();
+		const size_t rectCount = state->detector.GetRects().size();
+		const uint32_t changedCells = CountChangedCells(state->detector);
+
+		Benchmark::Register(detectName, [state, width, height]()
+		{
+			Benchmark::DoNotOptimize(RunPanFrame(*state, width, height));
+		}, 1);
+
+		Benchmark::SetMetric(detectName, "tiles", state->detector.GetTilesX() * state->detector.GetTilesY());
+		Benchmark::SetMetric(detectName, "exposed_tiles", exposedTiles);
+		Benchmark::SetMetric(detectName, "rects", (double)rectCount);
+		Benchmark::SetMetric(detectName, "changed_sh_cells", changedCells);
+
+		detectNames.push_back(detectName);
+	}
+
+	Benchmark::Check("InjectionChangeDetector", detectNames, CountInjectionChangeDetectorErrors);
+
+	RegisterChangeDetection(1280, 720);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "Benchmark.h"
+#include "../Engine/SceneManagement/MeshLoader.h"
+
+#include <iostream>
+
+void RegisterMeshBenchmarks()
+{
+	// Every mesh shipped in Assets/Meshes
+	const char* meshNames[] =
+	{
+		"BostonFernMesh",
+		"CastleWallMesh",
+		"CommonFernMesh",
+		"MossyRockMesh",
+		"MossyTreeLogMesh",
+		"RockGraniteAssemblyMesh",
+		"RockGraniteMesh",
+		"RoughMossyRockMesh"
+	};
+
+	for (const char* meshName : meshNames)
+	{
+		std::string name = meshName;
+
+		MeshLoader::MeshData meshData = MeshLoader::LoadModel(name);
+
+		if (meshData.Vertices.empty())
+		{
+			std::cerr << "Skipping " << name << ", mesh file not found" << std::endl;
+			continue;
+		}
+
+		Benchmark::Register("MeshLoader::LoadModel/" + name, [name]()
+		{
+			MeshLoader::MeshData loadedMesh = MeshLoader::LoadModel(name);
+			Benchmark::DoNotOptimize(loadedMesh);
+		}, meshData.Vertices.size());
+	}
+}
@@ -0,0 +1,334 @@
+#include "Benchmark.h"
+#include "VoxelBenchmarkScene.h"
+#include "../Engine/Utilities/PackedVoxelGrid.h"
+#include "../Engine/Utilities/ThreadPool.h"
+#include "../Engine/Utilities/VoxelInjector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace
+{
+	struct PackedInjectionState
+	{
+		InjectionFrame frame;
+		VoxelInjector injector;
+		PackedVoxelGrid grid;
+		PackedVoxelGrid contendedGrid;
+		VoxelGrid resolvedGrid;
+	};
+
+	uint32_t CountMismatchedTexels(const PackedVoxelGrid& grid, const PackedVoxelGrid& referenceGrid)
+	{
+		uint32_t mismatchedTexels = 0;
+
+		for (size_t i = 0; i < grid.GetTexelCount(); ++i)
+			mismatchedTexels += grid.Load(i) != referenceGrid.Load(i) ? 1 : 0;
+
+		return mismatchedTexels;
+	}
+
+	// The packed grid keeps 7, 7 and 6 bits of color, the texels are compared to what that rounding allows
+	bool SameColor(uint32_t texel, uint32_t otherTexel)
+	{
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			const int difference = (int)((texel >> (channel * 8)) & 0xFF) - (int)((otherTexel >> (channel * 8)) & 0xFF);
+
+			if (std::abs(difference) > (channel == 2 ? 3 : 2))
+				return false;
+		}
+
+		return true;
+	}
+
+	// The atomic max into the packed grid as VoxelInjection.hlsl does it, against the serial order and
+	// against the ordered injection with the luma test it replaced
+	void RegisterPackedInjection(uint32_t width, uint32_t height)
+	{
+		auto state = std::make_shared<PackedInjectionState>();
+		std::string size = std::to_string(width) + "x" + std::to_string(height);
+
+		// The first frame into an empty grid, then a turned one into the grid the first left
+		auto firstFrame = std::make_shared<InjectionFrame>();
+		BuildInjectionFrame(*firstFrame, width, height);
+		BuildInjectionFrame(state->frame, width, height, DefaultEye, 0.1f);
+
+		state->grid.Reset(VoxelResolution);
+		VoxelInjector::InjectPackedSerial(firstFrame->input, state->grid);
+		VoxelInjector::InjectPackedSerial(state->frame.input, state->grid);
+		state->grid.Resolve(state->resolvedGrid);
+
+		const uint64_t pixelCount = (uint64_t)(width / 16 * 16) * (height / 16 * 16);
+		const uint32_t contendedResolution = 4;
+
+		// Steady state, the frame injected again into the grid it filled
+		std::string packedName = "VoxelInjection::InjectPacked/" + size;
+		// Every pixel of the frame into an empty grid of 64 voxels, most of them raising a texel
+		std::string contendedName = "VoxelInjection::InjectPackedContended/" + size;
+
+		Benchmark::Check("Packed voxel injection at " + size, { packedName, contendedName }, [state, firstFrame, contendedResolution, packedName, contendedName]()
+		{
+			uint32_t errors = 0;
+
+			// A resolved texel round trips through the packed grid, nearer is larger whatever the color and
+			// tells depths apart an RGBA8 alpha can't, and empty stays empty
+			const uint32_t resolvedTexel = PackedVoxelGrid::ToTexel(PackedVoxelGrid::Encode(0.25f, 0.5f, 0.75f, 0.3f));
+			errors += PackedVoxelGrid::ToTexel(PackedVoxelGrid::FromTexel(resolvedTexel)) != resolvedTexel || PackedVoxelGrid::FromTexel(0x00FFFFFF) != 0 ? 1 : 0;
+			errors += PackedVoxelGrid::ToTexel(PackedVoxelGrid::Encode(1.0f, 1.0f, 1.0f, 1.0f)) != 0xFFFFFFFF ? 1 : 0;
+			errors += PackedVoxelGrid::Encode(0.0f, 0.0f, 0.0f, 0.5f) <= PackedVoxelGrid::Encode(1.0f, 1.0f, 1.0f, 0.501f) ? 1 : 0;
+
+			// Both frames repeated on the thread pool, the grid has to match the serial order texel for
+			// texel every time
+			PackedVoxelGrid referenceGrid;
+			referenceGrid.Reset(VoxelResolution);
+			VoxelInjector::InjectPackedSerial(firstFrame->input, referenceGrid);
+
+			VoxelGrid firstGrid;
+			referenceGrid.Resolve(firstGrid);
+
+			const uint32_t repeatCount = 8;
+			PackedVoxelGrid grid;
+			uint32_t mismatchedTexels = 0;
+			uint32_t minWrites = UINT32_MAX;
+			uint32_t maxWrites = 0;
+			uint64_t lostExchanges = 0;
+			uint64_t injectedPixels = 0;
+
+			for (uint32_t frame = 0; frame < 2; ++frame)
+			{
+				const VoxelInjectionInput& frameInput = frame == 0 ? firstFrame->input : state->frame.input;
+
+				// The second frame goes into the first one's grid as resolved, the packed one keeps more depth
+				if (frame == 1)
+				{
+					referenceGrid.Pack(firstGrid);
+					VoxelInjector::InjectPackedSerial(frameInput, referenceGrid);
+				}
+
+				for (uint32_t repeat = 0; repeat < repeatCount; ++repeat)
+				{
+					if (frame == 0)
+						grid.Reset(VoxelResolution);
+					else
+						grid.Pack(firstGrid);
+
+					VoxelInjectionStatistics statistics;
+					VoxelInjectionInput input = frameInput;
+					input.statistics = &statistics;
+
+					const uint32_t writes = state->injector.InjectPacked(input, grid);
+					mismatchedTexels += CountMismatchedTexels(grid, referenceGrid);
+					minWrites = std::min(minWrites, writes);
+					maxWrites = std::max(maxWrites, writes);
+					lostExchanges += statistics.lostExchanges;
+					injectedPixels += statistics.writtenEmpty[0] + statistics.writtenNearer[0] + statistics.rejectedFarther[0];
+
+					errors += writes != statistics.writtenEmpty[0] + statistics.writtenNearer[0] ? 1 : 0;
+					errors += CountUnaccountedPixels(statistics, 1);
+				}
+			}
+
+			// The same frame again changes nothing
+			errors += state->injector.InjectPacked(state->frame.input, grid) != 0 ? 1 : 0;
+			mismatchedTexels += CountMismatchedTexels(grid, referenceGrid);
+
+			// What the ordered injection with the luma test leaves in the finest grid for the same two frames
+			VoxelGrid orderedGrid;
+			orderedGrid.Reset(VoxelResolution);
+			state->injector.Inject(firstFrame->input, &orderedGrid, 1);
+			state->injector.Inject(state->frame.input, &orderedGrid, 1);
+
+			VoxelGrid resolvedGrid;
+			grid.Resolve(resolvedGrid);
+
+			uint32_t occupiedVoxels = 0;
+			uint32_t orderedDifferentVoxels = 0;
+
+			for (size_t i = 0; i < orderedGrid.GetTexelCount(); ++i)
+			{
+				occupiedVoxels += (resolvedGrid.GetTexels()[i] >> 24) != 0 ? 1 : 0;
+				orderedDifferentVoxels += SameColor(resolvedGrid.GetTexels()[i], orderedGrid.GetTexels()[i]) ? 0 : 1;
+				errors += ((resolvedGrid.GetTexels()[i] >> 24) != 0) != ((orderedGrid.GetTexels()[i] >> 24) != 0) ? 1 : 0;
+			}
+
+			// Packing the resolved grid and resolving it again gives it back, as restoring a cache does
+			PackedVoxelGrid repackedGrid;
+			repackedGrid.Pack(resolvedGrid);
+
+			VoxelGrid reresolvedGrid;
+			repackedGrid.Resolve(reresolvedGrid);
+
+			for (size_t i = 0; i < resolvedGrid.GetTexelCount(); ++i)
+				errors += reresolvedGrid.GetTexels()[i] != resolvedGrid.GetTexels()[i] ? 1 : 0;
+
+			// Pixels crowding into a grid of 4x4x4 voxels, the threads' bands fight over the same texels
+			uint64_t contendedLostExchanges = 0;
+			uint64_t contendedPixels = 0;
+			PackedVoxelGrid contendedReferenceGrid;
+			contendedReferenceGrid.Reset(contendedResolution);
+			VoxelInjector::InjectPackedSerial(state->frame.input, contendedReferenceGrid);
+
+			for (uint32_t repeat = 0; repeat < repeatCount; ++repeat)
+			{
+				VoxelInjectionStatistics statistics;
+				VoxelInjectionInput input = state->frame.input;
+				input.statistics = &statistics;
+
+				grid.Reset(contendedResolution);
+				state->injector.InjectPacked(input, grid);
+				mismatchedTexels += CountMismatchedTexels(grid, contendedReferenceGrid);
+
+				contendedLostExchanges += statistics.lostExchanges;
+				contendedPixels += statistics.writtenEmpty[0] + statistics.writtenNearer[0] + statistics.rejectedFarther[0];
+			}
+
+			Benchmark::SetMetric(packedName, "occupied_voxels", occupiedVoxels);
+			Benchmark::SetMetric(packedName, "mismatched_texels", mismatchedTexels);
+			// The grid doesn't depend on the order, how many writes it took does
+			Benchmark::SetMetric(packedName, "min_writes", minWrites);
+			Benchmark::SetMetric(packedName, "max_writes", maxWrites);
+			Benchmark::SetMetric(packedName, "lost_exchanges_per_pixel", injectedPixels > 0 ? (double)lostExchanges / (double)injectedPixels : 0.0);
+			Benchmark::SetMetric(packedName, "ordered_luma_different_voxels", orderedDifferentVoxels);
+			Benchmark::SetMetric(contendedName, "lost_exchanges_per_pixel", contendedPixels > 0 ? (double)contendedLostExchanges / (double)contendedPixels : 0.0);
+
+			return mismatchedTexels + errors;
+		});
+
+		// The light dimmed by half: the same voxels at the same depths, lit darker
+		Benchmark::Check("Packed voxel reseed at " + size, { packedName }, [state, width, height, packedName]()
+		{
+			InjectionFrame dimFrame;
+			BuildInjectionFrame(dimFrame, width, height, DefaultEye, 0.1f);
+
+			for (DirectX::XMFLOAT4& lighting : dimFrame.lighting)
+			{
+				lighting.x *= 0.5f;
+				lighting.y *= 0.5f;
+				lighting.z *= 0.5f;
+			}
+
+			PackedVoxelGrid dimGrid;
+			dimGrid.Reset(VoxelResolution);
+			VoxelInjector::InjectPackedSerial(dimFrame.input, dimGrid);
+
+			// Without the reseed the brighter colors stay
+			PackedVoxelGrid grid;
+			grid.Reset(VoxelResolution);
+			VoxelInjector::InjectPackedSerial(state->frame.input, grid);
+			const uint32_t staleWrites = state->injector.InjectPacked(dimFrame.input, grid);
+
+			// With it every voxel the frame sees takes the darker color, the others keep theirs at the far plane
+			PackedVoxelGrid litGrid;
+			litGrid.Reset(VoxelResolution);
+			VoxelInjector::InjectPackedSerial(state->frame.input, litGrid);
+
+			grid.Reset(VoxelResolution);
+			VoxelInjector::InjectPackedSerial(state->frame.input, grid);
+			grid.Reseed();
+			state->injector.InjectPacked(dimFrame.input, grid);
+
+			uint32_t mismatchedTexels = 0;
+
+			for (size_t i = 0; i < grid.GetTexelCount(); ++i)
+			{
+				const uint32_t expected = dimGrid.Load(i) != 0 ? dimGrid.Load(i) : litGrid.Load(i) != 0 ? (1u << 20) | (litGrid.Load(i) & 0xFFFFF) : 0;
+				mismatchedTexels += grid.Load(i) != expected ? 1 : 0;
+			}
+
+			// A reseeded voxel resolves to the alpha of a seed
+			const uint32_t reseededTexel = PackedVoxelGrid::ToTexel((1u << 20) | 0xFFFFF);
+			const uint32_t errors = (reseededTexel >> 24) != 0xFF ? 1 : 0;
+
+			Benchmark::SetMetric(packedName, "dimmer_writes_without_reseed", staleWrites);
+			Benchmark::SetMetric(packedName, "reseeded_mismatched_texels", mismatchedTexels);
+
+			return (staleWrites != 0 ? 1 : 0) + mismatchedTexels + errors;
+		});
+
+		Benchmark::Register(packedName, [state]()
+		{
+			Benchmark::DoNotOptimize(state->injector.InjectPacked(state->frame.input, state->grid));
+		}, pixelCount);
+
+		Benchmark::SetMetric(packedName, "threads", ThreadPool::GetThreadCount());
+
+		Benchmark::Register("VoxelInjection::InjectPackedSerial/" + size, [state]()
+		{
+			Benchmark::DoNotOptimize(VoxelInjector::InjectPackedSerial(state->frame.input, state->grid));
+		}, pixelCount);
+
+		Benchmark::Register(contendedName, [state, contendedResolution]()
+		{
+			state->contendedGrid.Reset(contendedResolution);
+			Benchmark::DoNotOptimize(state->injector.InjectPacked(state->frame.input, state->contendedGrid));
+		}, pixelCount);
+
+		if (width != 1280)
+			return;
+
+		Benchmark::Register("PackedVoxelGrid::Resolve/" + std::to_string(VoxelResolution), [state]()
+		{
+			state->grid.Resolve(state->resolvedGrid);
+			Benchmark::DoNotOptimize(state->resolvedGrid.GetTexels()[0]);
+		}, state->grid.GetTexelCount());
+
+		// The cost of contention alone: rising values, so every max writes, into one texel all threads
+		// share against a texel per cache line
+		const size_t maxCount = 1 << 20;
+		const size_t maxGrainSize = 256;
+
+		auto contendedMax = [state, maxCount, maxGrainSize](bool bSameTexel)
+		{
+			std::atomic<uint64_t> lostExchanges(0);
+			state->contendedGrid.Reset(4);
+
+			ThreadPool::ParallelFor(maxCount, maxGrainSize, [&](size_t begin, size_t end)
+			{
+				const size_t texel = bSameTexel ? 0 : (begin / maxGrainSize) % 4 * 16;
+				uint32_t rangeLostExchanges = 0;
+
+				for (size_t i = begin; i < end; ++i)
+					state->contendedGrid.Max(texel, (uint32_t)i + 1, rangeLostExchanges);
+
+				lostExchanges += rangeLostExchanges;
+			});
+
+			return lostExchanges.load();
+		};
+
+		const uint64_t sameTexelLostExchanges = contendedMax(true);
+		const uint64_t ownTexelLostExchanges = contendedMax(false);
+
+		std::string sameTexelName = "PackedVoxelGrid::Max/SameTexel";
+
+		Benchmark::Register(sameTexelName, [contendedMax]()
+		{
+			Benchmark::DoNotOptimize(contendedMax(true));
+		}, maxCount);
+
+		Benchmark::SetMetric(sameTexelName, "threads", ThreadPool::GetThreadCount());
+		Benchmark::SetMetric(sameTexelName, "lost_exchanges_per_write", (double)sameTexelLostExchanges / (double)maxCount);
+
+		std::string ownTexelName = "PackedVoxelGrid::Max/OwnTexels";
+
+		Benchmark::Register(ownTexelName, [contendedMax]()
+		{
+			Benchmark::DoNotOptimize(contendedMax(false));
+		}, maxCount);
+
+		Benchmark::SetMetric(ownTexelName, "lost_exchanges_per_write", (double)ownTexelLostExchanges / (double)maxCount);
+	}
+}
+
+void RegisterPackedVoxelGridBenchmarks()
+{
+	const uint32_t resolutions[][2] = { { 1280, 720 }, { 1920, 1080 } };
+
+	for (const auto& resolution : resolutions)
+		RegisterPackedInjection(resolution[0], resolution[1]);
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "Benchmark.h"
+#include "VoxelBenchmarkScene.h"
+#include "../Engine/Utilities/SHGridBaker.h"
+#include "../Engine/Utilities/ThreadPool.h"
+
+#include <memory>
+#include <string>
+
+namespace
+{
+	// Baking the SH grids from the downsampled mips on the CPU, against tracing one cone at a time
+	void RegisterSHBake(const std::shared_ptr<DownsampleState>& state)
+	{
+		const SHBakeSettings settings = GetSHBakeSettings();
+
+		const uint32_t cellCount = SHGridBaker::Bake(settings, state->grids, state->shGrids);
+
+		// A lit cell has a nonzero first coefficient in some color
+		uint32_t litCells = 0;
+
+		for (uint32_t cell = 0; cell < cellCount; ++cell)
+		{
+			bool lit = false;
+
+			for (uint32_t i = 0; i < 3; ++i)
+				lit = lit || (state->shGrids[i].GetTexels()[cell] & 0xFF) != 0;
+
+			litCells += lit ? 1 : 0;
+		}
+
+		std::string resolution = std::to_string(settings.gridResolution);
+		std::string bakeName = "SHGridBaker::Bake/" + resolution;
+
+		Benchmark::Check("SHGridBaker against the serial bake at " + resolution, { bakeName }, [state, settings, cellCount, bakeName]()
+		{
+			VoxelGrid shGrids[3];
+			VoxelGrid referenceGrids[3];
+			SHGridBaker::Bake(settings, state->grids, shGrids);
+			SHGridBaker::BakeSerial(settings, state->grids, referenceGrids);
+
+			uint32_t mismatchedTexels = 0;
+
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				for (uint32_t cell = 0; cell < cellCount; ++cell)
+					mismatchedTexels += shGrids[i].GetTexels()[cell] != referenceGrids[i].GetTexels()[cell] ? 1 : 0;
+			}
+
+			Benchmark::SetMetric(bakeName, "mismatched_texels", mismatchedTexels);
+
+			return mismatchedTexels;
+		});
+
+		Benchmark::Register(bakeName, [state, settings]()
+		{
+			Benchmark::DoNotOptimize(SHGridBaker::Bake(settings, state->grids, state->shGrids));
+		}, cellCount);
+
+		Benchmark::SetMetric(bakeName, "cells", cellCount);
+		Benchmark::SetMetric(bakeName, "cones", cellCount * SHGridBaker::ConeCount);
+		Benchmark::SetMetric(bakeName, "avx2", SHGridBaker::IsAvx2Supported() ? 1 : 0);
+		Benchmark::SetMetric(bakeName, "threads", ThreadPool::GetThreadCount());
+		Benchmark::SetMetric(bakeName, "lit_cells", litCells);
+
+		Benchmark::Register("SHGridBaker::BakeSerial/" + resolution, [state, settings]()
+		{
+			Benchmark::DoNotOptimize(SHGridBaker::BakeSerial(settings, state->grids, state->shGrids));
+		}, cellCount);
+	}
+}
+
+void RegisterSHGridBakerBenchmarks()
+{
+	RegisterSHBake(CreateDownsampleState(1280, 720));
+}
\ No newline at end of file
@@ -0,0 +1,405 @@
+#include "Benchmark.h"
+#include "VoxelBenchmarkScene.h"
+#include "../Engine/Utilities/GICache.h"
+#include "../Engine/Utilities/SHGridBaker.h"
+#include "../Engine/Utilities/SHUpdateScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace
+{
+	// Frames a cell can wait at most: a sweep of the grid, plus the frames staleness needs to make up
+	// for the change and distance weights of the others
+	uint32_t GetStalenessBound(const SHUpdateScheduler& scheduler)
+	{
+		const SHUpdateSettings& settings = scheduler.GetSettings();
+		const uint32_t sweepFrames = (scheduler.GetCellCount() + scheduler.GetCellsPerFrame() - 1) / scheduler.GetCellsPerFrame();
+
+		return sweepFrames + (uint32_t)std::ceil((settings.changeWeight + settings.distanceWeight) / settings.stalenessWeight);
+	}
+
+	// Sorted, without duplicates, within the grid and at most the budget
+	uint32_t CountScheduleErrors(const SHUpdateScheduler& scheduler, const std::vector<uint32_t>& cells, uint32_t count)
+	{
+		uint32_t errors = count != cells.size() || count > scheduler.GetCellsPerFrame() ? 1 : 0;
+
+		for (size_t i = 0; i < cells.size(); ++i)
+		{
+			errors += cells[i] >= scheduler.GetCellCount() ? 1 : 0;
+			errors += i > 0 && cells[i] <= cells[i - 1] ? 1 : 0;
+			errors += scheduler.GetStaleness(cells[i]) != 0 || scheduler.IsChanged(cells[i]) ? 1 : 0;
+		}
+
+		return errors;
+	}
+
+	uint32_t CountSHUpdateSchedulerErrors()
+	{
+		uint32_t errors = 0;
+		const float origin[3] = { 0.0f, 0.0f, 0.0f };
+		std::vector<uint32_t> cells;
+
+		SHUpdateSettings settings;
+		SHUpdateScheduler scheduler;
+		scheduler.Reset(settings);
+
+		errors += scheduler.GetCellCount() != 512 || scheduler.GetCellsPerFrame() != 64 ? 1 : 0;
+
+		for (uint32_t cell = 0; cell < scheduler.GetCellCount(); ++cell)
+			errors += !scheduler.IsChanged(cell) || scheduler.GetStaleness(cell) != 0 ? 1 : 0;
+
+		// Without changes the first frames sweep the grid, every cell once
+		std::vector<uint32_t> traceCounts(scheduler.GetCellCount(), 0);
+
+		for (uint32_t frame = 0; frame < 8; ++frame)
+		{
+			uint32_t count = scheduler.Schedule(origin, cells);
+			errors += CountScheduleErrors(scheduler, cells, count);
+
+			for (uint32_t cell : cells)
+				++traceCounts[cell];
+
+			// Converged once the sweep is complete
+			errors += scheduler.IsTracedSince(1) != (frame == 7) ? 1 : 0;
+		}
+
+		for (uint32_t cell = 0; cell < scheduler.GetCellCount(); ++cell)
+			errors += traceCounts[cell] != 1 || scheduler.IsChanged(cell) ? 1 : 0;
+
+		// Nearest first: the cell at the camera's position went in the first frame, the corners last
+		errors += scheduler.GetStaleness(4 * 64 + 4 * 8 + 4) != 7 || scheduler.GetStaleness(0) != 0 ? 1 : 0;
+
+		// A box around the cell at the origin marks it alone, or with its neighbours
+		settings.changeRadius = 0;
+		scheduler.Reset(settings);
+
+		for (uint32_t frame = 0; frame < 8; ++frame)
+			scheduler.Schedule(origin, cells);
+
+		const float boxMin[3] = { -1.0f, -1.0f, -1.0f };
+		const float boxMax[3] = { 1.0f, 1.0f, 1.0f };
+		scheduler.MarkChanged(boxMin, boxMax);
+
+		uint32_t changedCells = 0;
+
+		for (uint32_t cell = 0; cell < scheduler.GetCellCount(); ++cell)
+			changedCells += scheduler.IsChanged(cell) ? 1 : 0;
+
+		errors += changedCells != 1 || !scheduler.IsChanged(4 * 64 + 4 * 8 + 4) ? 1 : 0;
+
+		settings.changeRadius = 1;
+		scheduler.Reset(settings);
+
+		for (uint32_t frame = 0; frame < 8; ++frame)
+			scheduler.Schedule(origin, cells);
+
+		scheduler.MarkChanged(boxMin, boxMax);
+		changedCells = 0;
+
+		for (uint32_t cell = 0; cell < scheduler.GetCellCount(); ++cell)
+			changedCells += scheduler.IsChanged(cell) ? 1 : 0;
+
+		errors += changedCells != 27 ? 1 : 0;
+
+		// Boxes outside the volume change nothing
+		const float outsideMin[3] = { 100.0f, 0.0f, 0.0f };
+		const float outsideMax[3] = { 120.0f, 10.0f, 10.0f };
+		scheduler.MarkChanged(outsideMin, outsideMax);
+		changedCells = 0;
+
+		for (uint32_t cell = 0; cell < scheduler.GetCellCount(); ++cell)
+			changedCells += scheduler.IsChanged(cell) ? 1 : 0;
+
+		errors += changedCells != 27 ? 1 : 0;
+
+		// Changed cells go before the stalest unchanged ones, even in the far corner
+		uint32_t count = scheduler.Schedule(origin, cells);
+		errors += CountScheduleErrors(scheduler, cells, count);
+
+		for (uint32_t cell = 0; cell < scheduler.GetCellCount(); ++cell)
+			errors += scheduler.IsChanged(cell) ? 1 : 0;
+
+		const float cornerMin[3] = { -50.0f, -50.0f, -50.0f };
+		scheduler.MarkChanged(cornerMin, cornerMin);
+		errors += !scheduler.IsChanged(0) ? 1 : 0;
+
+		scheduler.Schedule(origin, cells);
+		errors += std::find(cells.begin(), cells.end(), 0u) == cells.end() ? 1 : 0;
+
+		// The budget is capped by what the pass constants hold
+		settings.cellsPerFrame = 1000;
+		scheduler.Reset(settings);
+		count = scheduler.Schedule(origin, cells);
+		errors += count != SHUpdateScheduler::MaxCellsPerFrame ? 1 : 0;
+		errors += CountScheduleErrors(scheduler, cells, count);
+
+		// A budget of the whole grid traces every cell every frame
+		settings.gridResolution = 4;
+		settings.cellsPerFrame = 64;
+		scheduler.Reset(settings);
+
+		for (uint32_t frame = 0; frame < 3; ++frame)
+			errors += scheduler.Schedule(origin, cells) != 64 ? 1 : 0;
+
+		return errors;
+	}
+
+	struct ScheduleState
+	{
+		SHUpdateScheduler scheduler;
+		std::vector<uint32_t> cells;
+
+		uint32_t random = 12345;
+		uint32_t maxStaleness = 0;
+		uint32_t scheduleErrors = 0;
+		uint64_t changedCells = 0;
+		uint64_t frames = 0;
+
+		uint32_t Next()
+		{
+			random = random * 1664525u + 1013904223u;
+			return random >> 8;
+		}
+	};
+
+	// A camera circling the volume while a few boxes of voxels change every frame
+	void RunScheduleFrame(ScheduleState& state)
+	{
+		const float angle = (float)state.frames * 0.02f;
+		const float camera[3] = { 30.0f * std::cos(angle), 5.0f, 30.0f * std::sin(angle) };
+
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			float boxMin[3];
+			float boxMax[3];
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				boxMin[axis] = (float)(state.Next() % 100) - 50.0f;
+				boxMax[axis] = boxMin[axis] + (float)(state.Next() % 8);
+			}
+
+			state.scheduler.MarkChanged(boxMin, boxMax);
+		}
+
+		for (uint32_t cell = 0; cell < state.scheduler.GetCellCount(); ++cell)
+		{
+			// Staleness when the frame starts
+			state.maxStaleness = std::max(state.maxStaleness, state.scheduler.GetStaleness(cell) + 1);
+			state.changedCells += state.scheduler.IsChanged(cell) ? 1 : 0;
+		}
+
+		uint32_t count = state.scheduler.Schedule(camera, state.cells);
+		state.scheduleErrors += CountScheduleErrors(state.scheduler, state.cells, count);
+		++state.frames;
+	}
+
+	struct SHUpdateState
+	{
+		VoxelGrid grids[VoxelInjector::MipCount];
+		VoxelGrid shGrids[GICache::SHGridCount];
+		VoxelGrid referenceSHGrids[GICache::SHGridCount];
+		SHUpdateScheduler scheduler;
+		std::vector<uint32_t> cells;
+	};
+
+	// Cells whose texels differ from the reference
+	uint32_t CountStaleCells(const SHUpdateState& state)
+	{
+		uint32_t staleCells = 0;
+
+		for (size_t cell = 0; cell < state.shGrids[0].GetTexelCount(); ++cell)
+		{
+			bool stale = false;
+
+			for (uint32_t i = 0; i < GICache::SHGridCount; ++i)
+				stale = stale || state.shGrids[i].GetTexels()[cell] != state.referenceSHGrids[i].GetTexels()[cell];
+
+			staleCells += stale ? 1 : 0;
+		}
+
+		return staleCells;
+	}
+
+	// How many frames of scheduled updates the SH grids need to catch up with a change of the voxels,
+	// against tracing the whole grid every other frame
+	void RegisterSHUpdates()
+	{
+		std::shared_ptr<DownsampleState> downsampleState = CreateDownsampleState(1280, 720);
+		const SHBakeSettings settings = GetSHBakeSettings();
+		SHGridBaker::Bake(settings, downsampleState->grids, downsampleState->shGrids);
+		const float camera[3] = { 0.0f, 8.0f, -40.0f };
+
+		// A bright block lights up next to the first sphere
+		const float boxMin[3] = { -4.0f, 0.0f, 4.0f };
+		const float boxMax[3] = { 4.0f, 8.0f, 12.0f };
+
+		VoxelGrid changedGrids[VoxelInjector::MipCount];
+
+		for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+			changedGrids[mip] = downsampleState->grids[mip];
+
+		const float voxelSize = 2.0f * WorldVolumeBoundary / VoxelResolution;
+		uint32_t begin[3];
+		uint32_t end[3];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			begin[axis] = (uint32_t)((boxMin[axis] + WorldVolumeBoundary) / voxelSize);
+			end[axis] = (uint32_t)((boxMax[axis] + WorldVolumeBoundary) / voxelSize);
+		}
+
+		for (uint32_t z = begin[2]; z < end[2]; ++z)
+		{
+			for (uint32_t y = begin[1]; y < end[1]; ++y)
+			{
+				for (uint32_t x = begin[0]; x < end[0]; ++x)
+					changedGrids[0].GetTexels()[changedGrids[0].GetIndex(x, y, z)] = VoxelGrid::Pack(1.0f, 0.9f, 0.5f, 1.0f);
+			}
+		}
+
+		VoxelMipBuilder::BuildMips(changedGrids, VoxelInjector::MipCount);
+
+		VoxelGrid referenceSHGrids[GICache::SHGridCount];
+		SHGridBaker::Bake(settings, changedGrids, referenceSHGrids);
+
+		const uint32_t budgets[] = { 16, 32, 64, 128, 256 };
+
+		for (uint32_t budget : budgets)
+		{
+			auto state = std::make_shared<SHUpdateState>();
+
+			for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+				state->grids[mip] = changedGrids[mip];
+
+			for (uint32_t i = 0; i < GICache::SHGridCount; ++i)
+			{
+				state->shGrids[i] = downsampleState->shGrids[i];
+				state->referenceSHGrids[i] = referenceSHGrids[i];
+			}
+
+			// Converged on the old voxels, every cell was traced on the last frames
+			SHUpdateSettings updateSettings;
+			updateSettings.gridResolution = settings.gridResolution;
+			updateSettings.worldBoundary = settings.worldBoundary;
+			updateSettings.cellsPerFrame = budget;
+			state->scheduler.Reset(updateSettings);
+
+			const uint32_t sweepFrames = (state->scheduler.GetCellCount() + budget - 1) / budget;
+
+			for (uint32_t frame = 0; frame < sweepFrames; ++frame)
+				state->scheduler.Schedule(camera, state->cells);
+
+			const uint32_t initialStaleCells = CountStaleCells(*state);
+			state->scheduler.MarkChanged(boxMin, boxMax);
+
+			// The cells next to the change, which change the most
+			std::vector<uint32_t> markedCells;
+
+			for (uint32_t cell = 0; cell < state->scheduler.GetCellCount(); ++cell)
+			{
+				if (state->scheduler.IsChanged(cell))
+					markedCells.push_back(cell);
+			}
+
+			uint32_t markedCellsStaleAfterFirstFrame = 0;
+
+			const uint32_t maxFrames = 64;
+			uint32_t framesToConverge = maxFrames;
+			uint32_t staleCellsAfterFourFrames = 0;
+
+			for (uint32_t frame = 1; frame <= maxFrames && framesToConverge == maxFrames; ++frame)
+			{
+				state->scheduler.Schedule(camera, state->cells);
+				SHGridBaker::BakeCells(settings, state->grids, state->cells.data(), state->cells.size(), state->shGrids);
+
+				const uint32_t staleCells = CountStaleCells(*state);
+
+				for (uint32_t cell : markedCells)
+				{
+					bool stale = false;
+
+					for (uint32_t i = 0; i < GICache::SHGridCount; ++i)
+						stale = stale || state->shGrids[i].GetTexels()[cell] != state->referenceSHGrids[i].GetTexels()[cell];
+
+					markedCellsStaleAfterFirstFrame += frame == 1 && stale ? 1 : 0;
+				}
+
+				if (frame == 4)
+					staleCellsAfterFourFrames = staleCells;
+
+				if (staleCells == 0)
+					framesToConverge = frame;
+			}
+
+			if (framesToConverge <= 4)
+				staleCellsAfterFourFrames = 0;
+
+			std::string updateName = "SHUpdateScheduler::TraceFrame/" + std::to_string(budget);
+
+			// A frame of the steady state, the scheduled cells traced
+			Benchmark::Register(updateName, [state, settings, camera]()
+			{
+				state->scheduler.Schedule(camera, state->cells);
+				SHGridBaker::BakeCells(settings, state->grids, state->cells.data(), state->cells.size(), state->shGrids);
+			}, budget);
+
+			Benchmark::SetMetric(updateName, "cells_per_frame", budget);
+			Benchmark::SetMetric(updateName, "changed_cells", initialStaleCells);
+			Benchmark::SetMetric(updateName, "marked_cells", (double)markedCells.size());
+			Benchmark::SetMetric(updateName, "marked_cells_stale_after_first_frame", markedCellsStaleAfterFirstFrame);
+			Benchmark::SetMetric(updateName, "frames_to_converge", framesToConverge);
+			Benchmark::SetMetric(updateName, "stale_cells_after_4_frames", staleCellsAfterFourFrames);
+			// Tracing the whole grid every other frame, as Renderer used to
+			Benchmark::SetMetric(updateName, "alternating_frames_to_converge", 2);
+			Benchmark::SetMetric(updateName, "alternating_cells_per_frame", state->scheduler.GetCellCount() / 2);
+		}
+	}
+}
+
+void RegisterSHUpdateSchedulerBenchmarks()
+{
+	const uint32_t budgets[] = { 32, 64, 128 };
+	std::vector<std::string> scheduleNames;
+
+	for (uint32_t budget : budgets)
+	{
+		auto state = std::make_shared<ScheduleState>();
+
+		SHUpdateSettings settings;
+		settings.cellsPerFrame = budget;
+		state->scheduler.Reset(settings);
+
+		std::string scheduleName = "SHUpdateScheduler::Schedule/" + std::to_string(budget);
+		scheduleNames.push_back(scheduleName);
+
+		Benchmark::Register(scheduleName, [state]()
+		{
+			RunScheduleFrame(*state);
+		}, 1);
+
+		// Warms the schedule up to a steady state before it is timed
+		Benchmark::Check("SHUpdateScheduler at " + std::to_string(budget) + " cells per frame", { scheduleName }, [state, scheduleName, budget]()
+		{
+			for (uint32_t frame = 0; frame < 2000; ++frame)
+				RunScheduleFrame(*state);
+
+			const uint32_t stalenessBound = GetStalenessBound(state->scheduler);
+
+			Benchmark::SetMetric(scheduleName, "cells", state->scheduler.GetCellCount());
+			Benchmark::SetMetric(scheduleName, "cells_per_frame", budget);
+			Benchmark::SetMetric(scheduleName, "max_staleness", state->maxStaleness);
+			Benchmark::SetMetric(scheduleName, "staleness_bound", stalenessBound);
+			Benchmark::SetMetric(scheduleName, "changed_cells_per_frame", (double)state->changedCells / (double)state->frames);
+			Benchmark::SetMetric(scheduleName, "invalid_schedules", state->scheduleErrors);
+
+			return (state->maxStaleness > stalenessBound ? 1 : 0) + state->scheduleErrors;
+		});
+	}
+
+	Benchmark::Check("SHUpdateScheduler", scheduleNames, CountSHUpdateSchedulerErrors);
+
+	RegisterSHUpdates();
+}
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include "Benchmark.h"
+#include "../Engine/SceneManagement/Material.h"
+#include "../Engine/SceneManagement/SceneLoader.h"
+#include "../Engine/Utilities/MemoryArena.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+using namespace DirectX;
+
+namespace
+{
+	// Same layout and 256 byte constant buffer stride as ObjectConstants in FrameResource.h
+	struct ObjectConstants
+	{
+		XMFLOAT4X4 World;
+	};
+
+	const size_t ObjectConstantsByteSize = (sizeof(ObjectConstants) + 255) & ~255;
+
+	std::vector<XMFLOAT4X4> ComposeWorldMatrices(const SceneDescription& sceneDescription)
+	{
+		std::vector<XMFLOAT4X4> worldMatrices(sceneDescription.objects.size());
+
+		// Matches SceneManager::BuildRenderObjects
+		for (size_t i = 0; i < sceneDescription.objects.size(); ++i)
+		{
+			const SceneObject& sceneObject = sceneDescription.objects[i];
+
+			XMStoreFloat4x4(&worldMatrices[i], XMMatrixScaling(sceneObject.scale.x, sceneObject.scale.y, sceneObject.scale.z)
+				* XMMatrixRotationQuaternion(XMLoadFloat4(&sceneObject.rotation))
+				* XMMatrixTranslation(sceneObject.position.x, sceneObject.position.y, sceneObject.position.z));
+		}
+
+		return worldMatrices;
+	}
+
+	void RegisterObjectCBUpdate(const std::string& name, const std::vector<XMFLOAT4X4>& worldMatrices)
+	{
+		// Stands in for the mapped upload heap of FrameResource::ObjectCB
+		auto mappedData = std::make_shared<std::vector<uint8_t>>(worldMatrices.size() * ObjectConstantsByteSize);
+
+		// Matches DemoApp::UpdateObjectCBs with every object dirty
+		Benchmark::Register("DemoApp::UpdateObjectCBs/" + name, [worldMatrices, mappedData]()
+		{
+			for (size_t i = 0; i < worldMatrices.size(); ++i)
+			{
+				XMMATRIX world = XMLoadFloat4x4(&worldMatrices[i]);
+
+				ObjectConstants objConstants;
+				XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
+
+				memcpy(&(*mappedData)[i * ObjectConstantsByteSize], &objConstants, sizeof(ObjectConstants));
+			}
+
+			Benchmark::DoNotOptimize(*mappedData);
+		}, worldMatrices.size());
+	}
+
+	// The CPU side of SceneManager::LoadScene followed by UnloadScene: the scene objects, one
+	// material per unique mesh and the world matrices of the render objects, all from the arena
+	void LoadSceneIntoArena(MemoryArena& arena, const SceneDescription& sceneDescription)
+	{
+		size_t numberOfObjects = sceneDescription.objects.size();
+
+		SceneObject* objectsInScene = arena.NewArray<SceneObject>(numberOfObjects);
+		Material* materials = arena.NewArray<Material>(sceneDescription.numberOfUniqueObjects);
+		XMFLOAT4X4* worldMatrices = arena.NewArray<XMFLOAT4X4>(numberOfObjects);
+
+		for (size_t i = 0; i < numberOfObjects; ++i)
+			objectsInScene[i] = sceneDescription.objects[i];
+
+		for (uint32_t i = 0; i < sceneDescription.numberOfUniqueObjects; ++i)
+		{
+			materials[i].MatCBIndex = i;
+			materials[i].DiffuseSrvHeapIndex = i * 2;
+			materials[i].Name = objectsInScene[i % numberOfObjects].meshName;
+		}
+
+		for (size_t i = 0; i < numberOfObjects; ++i)
+			XMStoreFloat4x4(&worldMatrices[i], XMMatrixScaling(objectsInScene[i].scale.x, objectsInScene[i].scale.y, objectsInScene[i].scale.z)
+				* XMMatrixRotationQuaternion(XMLoadFloat4(&objectsInScene[i].rotation))
+				* XMMatrixTranslation(objectsInScene[i].position.x, objectsInScene[i].position.y, objectsInScene[i].position.z));
+
+		Benchmark::DoNotOptimize(worldMatrices);
+	}
+
+	// Same work with one heap allocation per array, the way the scene was stored before the arena
+	void LoadSceneIntoHeap(const SceneDescription& sceneDescription)
+	{
+		size_t numberOfObjects = sceneDescription.objects.size();
+
+		SceneObject* objectsInScene = new SceneObject[numberOfObjects];
+		Material* materials = new Material[sceneDescription.numberOfUniqueObjects];
+		XMFLOAT4X4* worldMatrices = new XMFLOAT4X4[numberOfObjects];
+
+		for (size_t i = 0; i < numberOfObjects; ++i)
+			objectsInScene[i] = sceneDescription.objects[i];
+
+		for (uint32_t i = 0; i < sceneDescription.numberOfUniqueObjects; ++i)
+		{
+			materials[i].MatCBIndex = i;
+			materials[i].DiffuseSrvHeapIndex = i * 2;
+			materials[i].Name = objectsInScene[i % numberOfObjects].meshName;
+		}
+
+		for (size_t i = 0; i < numberOfObjects; ++i)
+			XMStoreFloat4x4(&worldMatrices[i], XMMatrixScaling(objectsInScene[i].scale.x, objectsInScene[i].scale.y, objectsInScene[i].scale.z)
+				* XMMatrixRotationQuaternion(XMLoadFloat4(&objectsInScene[i].rotation))
+				* XMMatrixTranslation(objectsInScene[i].position.x, objectsInScene[i].position.y, objectsInScene[i].position.z));
+
+		Benchmark::DoNotOptimize(worldMatrices);
+
+		delete[] worldMatrices;
+		delete[] materials;
+		delete[] objectsInScene;
+	}
+
+	void RegisterLoadUnload(const std::string& name, const SceneDescription& sceneDescription)
+	{
+		if (sceneDescription.objects.empty())
+			return;
+
+		auto arena = std::make_shared<MemoryArena>(4 * 1024);
+		std::string arenaName = "SceneManager::LoadUnload/Arena/" + name;
+		std::string heapName = "SceneManager::LoadUnload/Heap/" + name;
+
+		// Stress the reload path up front, after the first fill the arena must neither grow nor
+		// allocate any more than the strings the scene copies
+		Benchmark::Check("Scene arena of " + name, { arenaName, heapName }, [arena, sceneDescription, arenaName, heapName]()
+		{
+			const uint32_t CycleCount = 1000;
+
+			uint64_t firstAllocations = Benchmark::GetHeapAllocationCount();
+			LoadSceneIntoArena(*arena, sceneDescription);
+			arena->Reset();
+			firstAllocations = Benchmark::GetHeapAllocationCount() - firstAllocations;
+
+			size_t reservedBytes = arena->GetReservedBytes();
+			uint64_t arenaAllocations = Benchmark::GetHeapAllocationCount();
+
+			for (uint32_t cycle = 0; cycle < CycleCount; ++cycle)
+			{
+				LoadSceneIntoArena(*arena, sceneDescription);
+				arena->Reset();
+			}
+
+			arenaAllocations = Benchmark::GetHeapAllocationCount() - arenaAllocations;
+
+			uint64_t heapAllocations = Benchmark::GetHeapAllocationCount();
+
+			for (uint32_t cycle = 0; cycle < CycleCount; ++cycle)
+				LoadSceneIntoHeap(sceneDescription);
+
+			heapAllocations = Benchmark::GetHeapAllocationCount() - heapAllocations;
+
+			Benchmark::SetMetric(arenaName, "first_load_heap_allocations", (double)firstAllocations);
+			Benchmark::SetMetric(arenaName, "heap_allocations_per_load", (double)arenaAllocations / CycleCount);
+			Benchmark::SetMetric(heapName, "heap_allocations_per_load", (double)heapAllocations / CycleCount);
+
+			// The heap path allocates the same strings plus its three arrays
+			uint32_t errors = arena->GetReservedBytes() != reservedBytes || arena->GetBlockCount() != 1 ? 1 : 0;
+			errors += arenaAllocations + 3 * CycleCount != heapAllocations ? 1 : 0;
+
+			return errors;
+		});
+
+		Benchmark::Register(arenaName, [arena, sceneDescription]()
+		{
+			LoadSceneIntoArena(*arena, sceneDescription);
+			arena->Reset();
+		}, sceneDescription.objects.size());
+
+		Benchmark::Register(heapName, [sceneDescription]()
+		{
+			LoadSceneIntoHeap(sceneDescription);
+		}, sceneDescription.objects.size());
+	}
+}
+
+void RegisterSceneBenchmarks()
+{
+	const char* sceneNames[] = { "DemoScene1", "DemoScene2", "DemoScene3", "DemoScene4" };
+
+	std::vector<XMFLOAT4X4> allWorldMatrices;
+	std::vector<SceneObject> allObjects;
+
+	for (const char* sceneName : sceneNames)
+	{
+		std::string name = sceneName;
+		std::string sceneFilePath = "../Assets/Scenes/" + name + ".txt";
+
+		SceneDescription sceneDescription;
+
+		if (!SceneLoader::LoadSceneDescription(sceneFilePath, sceneDescription))
+		{
+			std::cerr << "Skipping " << name << ", scene file not found" << std::endl;
+			continue;
+		}
+
+		Benchmark::Register("SceneLoader::LoadSceneDescription/" + name, [sceneFilePath]()
+		{
+			SceneDescription loadedScene;
+			SceneLoader::LoadSceneDescription(sceneFilePath, loadedScene);
+			Benchmark::DoNotOptimize(loadedScene);
+		}, sceneDescription.objects.size());
+
+		Benchmark::Register("SceneManager::BuildRenderObjects/WorldMatrices/" + name, [sceneDescription]()
+		{
+			Benchmark::DoNotOptimize(ComposeWorldMatrices(sceneDescription));
+		}, sceneDescription.objects.size());
+
+		std::vector<XMFLOAT4X4> worldMatrices = ComposeWorldMatrices(sceneDescription);
+		RegisterObjectCBUpdate(name, worldMatrices);
+
+		RegisterLoadUnload(name, sceneDescription);
+
+		allWorldMatrices.insert(allWorldMatrices.end(), worldMatrices.begin(), worldMatrices.end());
+		allObjects.insert(allObjects.end(), sceneDescription.objects.begin(), sceneDescription.objects.end());
+	}
+
+	// The demo scenes are small, replicate their objects to see how the update scales
+	if (!allWorldMatrices.empty())
+	{
+		std::vector<XMFLOAT4X4> manyWorldMatrices(4096);
+
+		for (size_t i = 0; i < manyWorldMatrices.size(); ++i)
+			manyWorldMatrices[i] = allWorldMatrices[i % allWorldMatrices.size()];
+
+		RegisterObjectCBUpdate("4096Objects", manyWorldMatrices);
+
+		// Large enough that the first fill spills over several arena blocks
+		SceneDescription manyObjectsScene;
+		manyObjectsScene.numberOfUniqueObjects = 256;
+		manyObjectsScene.objects.resize(4096);
+
+		for (size_t i = 0; i < manyObjectsScene.objects.size(); ++i)
+			manyObjectsScene.objects[i] = allObjects[i % allObjects.size()];
+
+		RegisterLoadUnload("4096Objects", manyObjectsScene);
+	}
+}
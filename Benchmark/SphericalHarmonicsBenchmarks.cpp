@@ -0,0 +1,565 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/SphericalHarmonics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace
+{
+	const double Pi = 3.14159265358979323846;
+
+	// Directions and weights of a midpoint rule in latitude and longitude, the reference integration
+	struct Quadrature
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> weights;
+	};
+
+	Quadrature BuildQuadrature(uint32_t latitudeCount)
+	{
+		Quadrature quadrature;
+		const uint32_t longitudeCount = 2 * latitudeCount;
+
+		for (uint32_t i = 0; i < latitudeCount; ++i)
+		{
+			const double theta = ((double)i + 0.5) * Pi / latitudeCount;
+			const double weight = std::sin(theta) * (Pi / latitudeCount) * (2.0 * Pi / longitudeCount);
+
+			for (uint32_t j = 0; j < longitudeCount; ++j)
+			{
+				const double phi = ((double)j + 0.5) * 2.0 * Pi / longitudeCount;
+
+				quadrature.x.push_back((float)(std::sin(theta) * std::cos(phi)));
+				quadrature.y.push_back((float)(std::sin(theta) * std::sin(phi)));
+				quadrature.z.push_back((float)std::cos(theta));
+				quadrature.weights.push_back((float)weight);
+			}
+		}
+
+		return quadrature;
+	}
+
+	struct Random
+	{
+		uint32_t state = 12345;
+
+		float Next()
+		{
+			state = state * 1664525u + 1013904223u;
+			return (float)(state >> 8) / 16777216.0f;
+		}
+
+		void NextDirection(float* direction)
+		{
+			const float z = 2.0f * Next() - 1.0f;
+			const float phi = 2.0f * (float)Pi * Next();
+			const float radius = std::sqrt(std::max(0.0f, 1.0f - z * z));
+
+			direction[0] = radius * std::cos(phi);
+			direction[1] = radius * std::sin(phi);
+			direction[2] = z;
+		}
+	};
+
+	// A smooth radiance in the span of L2, different per channel and positive everywhere
+	void GetBandLimitedRadiance(const float* d, float* color)
+	{
+		color[0] = 1.0f + 0.5f * d[2] - 0.3f * d[0] + 0.4f * d[0] * d[1];
+		color[1] = 0.8f + 0.2f * d[1] + 0.3f * (d[2] * d[2] - 0.3f);
+		color[2] = 1.2f - 0.4f * d[2] + 0.25f * (d[0] * d[0] - d[1] * d[1]) - 0.3f * d[1] * d[2];
+	}
+
+	// A sun: a narrow lobe around a direction on a dim sky, far from band limited
+	void GetSunRadiance(const float* d, float* color)
+	{
+		const float sunDirection[3] = { 0.48f, 0.6f, 0.64f };
+		const float cosine = std::max(0.0f, d[0] * sunDirection[0] + d[1] * sunDirection[1] + d[2] * sunDirection[2]);
+		const float sun = std::pow(cosine, 64.0f);
+
+		color[0] = 0.1f + 4.0f * sun;
+		color[1] = 0.15f + 3.5f * sun;
+		color[2] = 0.3f + 3.0f * sun;
+	}
+
+	template <uint32_t Order, typename Radiance>
+	SHColor<Order> ProjectRadiance(const Quadrature& quadrature, Radiance radiance)
+	{
+		const size_t count = quadrature.x.size();
+		std::vector<float> red(count);
+		std::vector<float> green(count);
+		std::vector<float> blue(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float direction[3] = { quadrature.x[i], quadrature.y[i], quadrature.z[i] };
+			float color[3];
+			radiance(direction, color);
+
+			red[i] = color[0];
+			green[i] = color[1];
+			blue[i] = color[2];
+		}
+
+		SHColor<Order> expansion;
+		SphericalHarmonics::ProjectBatch(quadrature.x.data(), quadrature.y.data(), quadrature.z.data(), red.data(), green.data(),
+			blue.data(), quadrature.weights.data(), count, expansion);
+
+		return expansion;
+	}
+
+	// Irradiance at a normal by integrating the radiance times the clamped cosine, in double
+	template <typename Radiance>
+	void IntegrateIrradiance(const Quadrature& quadrature, Radiance radiance, const float* normal, double* irradiance)
+	{
+		irradiance[0] = irradiance[1] = irradiance[2] = 0.0;
+
+		for (size_t i = 0; i < quadrature.x.size(); ++i)
+		{
+			const float direction[3] = { quadrature.x[i], quadrature.y[i], quadrature.z[i] };
+			const double cosine = (double)normal[0] * direction[0] + (double)normal[1] * direction[1] + (double)normal[2] * direction[2];
+
+			if (cosine <= 0.0)
+				continue;
+
+			float color[3];
+			radiance(direction, color);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				irradiance[channel] += color[channel] * cosine * quadrature.weights[i];
+		}
+	}
+
+	// Largest error of L2 irradiance against integrating, relative to the largest irradiance
+	template <typename Radiance>
+	double GetIrradianceError(const Quadrature& quadrature, Radiance radiance, uint32_t normalCount)
+	{
+		SHL2RGB expansion = ProjectRadiance<3>(quadrature, radiance);
+		SphericalHarmonics::ConvolveCosine(expansion);
+
+		Random random;
+		double maxError = 0.0;
+		double maxIrradiance = 0.0;
+
+		for (uint32_t i = 0; i < normalCount; ++i)
+		{
+			float normal[3];
+			random.NextDirection(normal);
+
+			double reference[3];
+			IntegrateIrradiance(quadrature, radiance, normal, reference);
+
+			float irradiance[3];
+			SphericalHarmonics::Evaluate(expansion, normal, irradiance);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				maxError = std::max(maxError, std::fabs(irradiance[channel] - reference[channel]));
+				maxIrradiance = std::max(maxIrradiance, reference[channel]);
+			}
+		}
+
+		return maxError / maxIrradiance;
+	}
+
+	SHL2RGB GetRandomExpansion(Random& random)
+	{
+		SHL2RGB expansion;
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			for (uint32_t i = 0; i < SHL2::CoefficientCount; ++i)
+				expansion.channels[channel].values[i] = 2.0f * random.Next() - 1.0f;
+		}
+
+		return expansion;
+	}
+
+	// Row major, about a unit axis
+	void GetRotation(const float* axis, float angle, float* matrix)
+	{
+		const float c = std::cos(angle);
+		const float s = std::sin(angle);
+		const float t = 1.0f - c;
+
+		const float rotation[9] =
+		{
+			t * axis[0] * axis[0] + c, t * axis[0] * axis[1] - s * axis[2], t * axis[0] * axis[2] + s * axis[1],
+			t * axis[0] * axis[1] + s * axis[2], t * axis[1] * axis[1] + c, t * axis[1] * axis[2] - s * axis[0],
+			t * axis[0] * axis[2] - s * axis[1], t * axis[1] * axis[2] + s * axis[0], t * axis[2] * axis[2] + c
+		};
+
+		std::copy(rotation, rotation + 9, matrix);
+	}
+
+	// Accuracy of the library against numerical integration and between its SIMD and scalar paths.
+	// Fills the largest errors, returns how many were over their tolerance.
+	uint32_t CheckSphericalHarmonics(std::vector<std::pair<std::string, double>>& errors)
+	{
+		const Quadrature quadrature = BuildQuadrature(256);
+		const size_t count = quadrature.x.size();
+		uint32_t failedChecks = 0;
+
+		auto check = [&](const char* name, double error, double tolerance)
+		{
+			errors.push_back(std::make_pair(name, error));
+			failedChecks += error <= tolerance ? 0 : 1;
+		};
+
+		// The basis is orthonormal
+		double orthonormalityError = 0.0;
+
+		{
+			std::vector<double> products(SHL2::CoefficientCount * SHL2::CoefficientCount, 0.0);
+
+			for (size_t q = 0; q < count; ++q)
+			{
+				const float direction[3] = { quadrature.x[q], quadrature.y[q], quadrature.z[q] };
+				SHL2 basis;
+				SphericalHarmonics::EvaluateBasis(direction, basis);
+
+				for (uint32_t i = 0; i < SHL2::CoefficientCount; ++i)
+				{
+					for (uint32_t j = 0; j < SHL2::CoefficientCount; ++j)
+						products[i * SHL2::CoefficientCount + j] += (double)basis.values[i] * basis.values[j] * quadrature.weights[q];
+				}
+			}
+
+			for (uint32_t i = 0; i < SHL2::CoefficientCount; ++i)
+			{
+				for (uint32_t j = 0; j < SHL2::CoefficientCount; ++j)
+					orthonormalityError = std::max(orthonormalityError, std::fabs(products[i * SHL2::CoefficientCount + j] - (i == j ? 1.0 : 0.0)));
+			}
+		}
+
+		check("orthonormality_error", orthonormalityError, 1.0e-4);
+
+		// Projecting a band limited radiance and evaluating it gives it back
+		Random random;
+		const SHL2RGB bandLimited = ProjectRadiance<3>(quadrature, GetBandLimitedRadiance);
+		double reconstructionError = 0.0;
+
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			float direction[3];
+			random.NextDirection(direction);
+
+			float reference[3];
+			float color[3];
+			GetBandLimitedRadiance(direction, reference);
+			SphericalHarmonics::Evaluate(bandLimited, direction, color);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				reconstructionError = std::max(reconstructionError, (double)std::fabs(color[channel] - reference[channel]));
+		}
+
+		check("reconstruction_error", reconstructionError, 1.0e-4);
+
+		// The cosine lobe is the projection of the clamped cosine, and the basis convolved with it
+		double cosineLobeError = 0.0;
+
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			float lobeDirection[3];
+			random.NextDirection(lobeDirection);
+
+			const SHL2RGB projected = ProjectRadiance<3>(quadrature, [&lobeDirection](const float* d, float* color)
+			{
+				color[0] = color[1] = color[2] = std::max(0.0f, d[0] * lobeDirection[0] + d[1] * lobeDirection[1] + d[2] * lobeDirection[2]);
+			});
+
+			SHL2 lobe;
+			SHL2 convolvedBasis;
+			SphericalHarmonics::EvaluateCosineLobe(lobeDirection, lobe);
+			SphericalHarmonics::EvaluateBasis(lobeDirection, convolvedBasis);
+			SphericalHarmonics::ConvolveCosine(convolvedBasis);
+
+			for (uint32_t j = 0; j < SHL2::CoefficientCount; ++j)
+			{
+				cosineLobeError = std::max(cosineLobeError, (double)std::fabs(lobe.values[j] - projected.channels[0].values[j]));
+				cosineLobeError = std::max(cosineLobeError, (double)std::fabs(lobe.values[j] - convolvedBasis.values[j]));
+			}
+
+			// L1 is the start of L2, and what the shaders' dirToCosineLobe() gives
+			SHL1 lobeL1;
+			SphericalHarmonics::EvaluateCosineLobe(lobeDirection, lobeL1);
+			const float shaderLobe[4] = { 0.886226925f, -1.02332671f * lobeDirection[1], 1.02332671f * lobeDirection[2], -1.02332671f * lobeDirection[0] };
+
+			for (uint32_t j = 0; j < SHL1::CoefficientCount; ++j)
+				failedChecks += lobeL1.values[j] == lobe.values[j] && lobeL1.values[j] == shaderLobe[j] ? 0 : 1;
+		}
+
+		check("cosine_lobe_error", cosineLobeError, 1.0e-3);
+
+		// Irradiance of a band limited radiance is exact, a sun's is within what L2 can do
+		check("irradiance_error", GetIrradianceError(quadrature, GetBandLimitedRadiance, 64), 1.0e-3);
+		errors.push_back(std::make_pair("sun_irradiance_error", GetIrradianceError(quadrature, GetSunRadiance, 64)));
+
+		// A rotated expansion takes at R * d the value the original takes at d
+		double rotationError = 0.0;
+
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			float axis[3];
+			random.NextDirection(axis);
+
+			float matrix[9];
+			GetRotation(axis, 2.0f * (float)Pi * random.Next(), matrix);
+
+			const SHRotation rotation(matrix);
+			const SHL2RGB expansion = GetRandomExpansion(random);
+			SHL2RGB rotated;
+			rotation.Apply(expansion, rotated);
+
+			SHL1RGB expansionL1;
+			SHL1RGB rotatedL1;
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				std::copy(expansion.channels[channel].values, expansion.channels[channel].values + SHL1::CoefficientCount, expansionL1.channels[channel].values);
+
+			rotation.Apply(expansionL1, rotatedL1);
+
+			for (uint32_t j = 0; j < 16; ++j)
+			{
+				float direction[3];
+				random.NextDirection(direction);
+
+				float rotatedDirection[3];
+
+				for (uint32_t row = 0; row < 3; ++row)
+					rotatedDirection[row] = matrix[row * 3] * direction[0] + matrix[row * 3 + 1] * direction[1] + matrix[row * 3 + 2] * direction[2];
+
+				float color[3];
+				float rotatedColor[3];
+				float colorL1[3];
+				float rotatedColorL1[3];
+				SphericalHarmonics::Evaluate(expansion, direction, color);
+				SphericalHarmonics::Evaluate(rotated, rotatedDirection, rotatedColor);
+				SphericalHarmonics::Evaluate(expansionL1, direction, colorL1);
+				SphericalHarmonics::Evaluate(rotatedL1, rotatedDirection, rotatedColorL1);
+
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					rotationError = std::max(rotationError, (double)std::fabs(color[channel] - rotatedColor[channel]));
+					rotationError = std::max(rotationError, (double)std::fabs(colorL1[channel] - rotatedColorL1[channel]));
+				}
+			}
+		}
+
+		check("rotation_error", rotationError, 1.0e-4);
+
+		// The SSE batches against one direction at a time, with a count that leaves a remainder
+		const size_t batchCount = 1003;
+		std::vector<float> x(batchCount);
+		std::vector<float> y(batchCount);
+		std::vector<float> z(batchCount);
+		std::vector<float> colors[3];
+		std::vector<float> weights(batchCount);
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+			colors[channel].resize(batchCount);
+
+		for (size_t i = 0; i < batchCount; ++i)
+		{
+			float direction[3];
+			random.NextDirection(direction);
+			x[i] = direction[0];
+			y[i] = direction[1];
+			z[i] = direction[2];
+			weights[i] = random.Next();
+		}
+
+		const SHL2RGB expansion = GetRandomExpansion(random);
+		SphericalHarmonics::EvaluateBatch(expansion, x.data(), y.data(), z.data(), batchCount, colors[0].data(), colors[1].data(), colors[2].data());
+
+		double batchError = 0.0;
+		SHL2RGB batchProjection;
+		SHL2RGB projection;
+		SphericalHarmonics::ProjectBatch(x.data(), y.data(), z.data(), colors[0].data(), colors[1].data(), colors[2].data(), weights.data(),
+			batchCount, batchProjection);
+
+		for (size_t i = 0; i < batchCount; ++i)
+		{
+			const float direction[3] = { x[i], y[i], z[i] };
+			float color[3];
+			SphericalHarmonics::Evaluate(expansion, direction, color);
+			SphericalHarmonics::Project(direction, color, weights[i], projection);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				batchError = std::max(batchError, (double)std::fabs(colors[channel][i] - color[channel]));
+		}
+
+		// Summed in another order, so relative to the sums
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			for (uint32_t i = 0; i < SHL2::CoefficientCount; ++i)
+			{
+				const double difference = std::fabs(batchProjection.channels[channel].values[i] - projection.channels[channel].values[i]);
+				batchError = std::max(batchError, difference / std::max(1.0, (double)std::fabs(projection.channels[channel].values[i])));
+			}
+		}
+
+		check("batch_error", batchError, 1.0e-4);
+
+		// The window damps the ringing of the sun, the darkest direction gets less negative
+		SHL2RGB sun = ProjectRadiance<3>(quadrature, GetSunRadiance);
+		SHL2RGB windowedSun = sun;
+		SphericalHarmonics::ApplyWindow(windowedSun, 3.0f);
+
+		std::vector<float> sunColors[3];
+		std::vector<float> windowedSunColors[3];
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			sunColors[channel].resize(count);
+			windowedSunColors[channel].resize(count);
+		}
+
+		SphericalHarmonics::EvaluateBatch(sun, quadrature.x.data(), quadrature.y.data(), quadrature.z.data(), count,
+			sunColors[0].data(), sunColors[1].data(), sunColors[2].data());
+		SphericalHarmonics::EvaluateBatch(windowedSun, quadrature.x.data(), quadrature.y.data(), quadrature.z.data(), count,
+			windowedSunColors[0].data(), windowedSunColors[1].data(), windowedSunColors[2].data());
+
+		const double sunMinimum = *std::min_element(sunColors[0].begin(), sunColors[0].end());
+		const double windowedSunMinimum = *std::min_element(windowedSunColors[0].begin(), windowedSunColors[0].end());
+
+		errors.push_back(std::make_pair("sun_minimum", sunMinimum));
+		errors.push_back(std::make_pair("windowed_sun_minimum", windowedSunMinimum));
+		failedChecks += windowedSunMinimum > sunMinimum ? 0 : 1;
+
+		// A window wider than the bands still scales them, one of zero width keeps band 0 alone
+		SHL2 band0 = sun.channels[0];
+		SphericalHarmonics::ApplyWindow(band0, 0.0f);
+		failedChecks += band0.values[0] == sun.channels[0].values[0] && band0.values[1] == 0.0f && band0.values[8] == 0.0f ? 0 : 1;
+
+		return failedChecks;
+	}
+
+	struct SHBatchState
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> colors[3];
+		SHL1RGB expansionL1;
+		SHL2RGB expansionL2;
+		std::vector<SHL2RGB> expansions;
+	};
+}
+
+void RegisterSphericalHarmonicsBenchmarks()
+{
+	auto state = std::make_shared<SHBatchState>();
+	const size_t count = 1 << 16;
+	Random random;
+
+	state->x.resize(count);
+	state->y.resize(count);
+	state->z.resize(count);
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+		state->colors[channel].resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float direction[3];
+		random.NextDirection(direction);
+		state->x[i] = direction[0];
+		state->y[i] = direction[1];
+		state->z[i] = direction[2];
+	}
+
+	state->expansionL2 = GetRandomExpansion(random);
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+		std::copy(state->expansionL2.channels[channel].values, state->expansionL2.channels[channel].values + SHL1::CoefficientCount,
+			state->expansionL1.channels[channel].values);
+
+	state->expansions.resize(4096);
+
+	for (SHL2RGB& expansion : state->expansions)
+		expansion = GetRandomExpansion(random);
+
+	Benchmark::Register("SphericalHarmonics::EvaluateBatch/L1", [state, count]()
+	{
+		SphericalHarmonics::EvaluateBatch(state->expansionL1, state->x.data(), state->y.data(), state->z.data(), count,
+			state->colors[0].data(), state->colors[1].data(), state->colors[2].data());
+		Benchmark::DoNotOptimize(state->colors[0][count - 1]);
+	}, count);
+
+	Benchmark::Register("SphericalHarmonics::EvaluateBatch/L2", [state, count]()
+	{
+		SphericalHarmonics::EvaluateBatch(state->expansionL2, state->x.data(), state->y.data(), state->z.data(), count,
+			state->colors[0].data(), state->colors[1].data(), state->colors[2].data());
+		Benchmark::DoNotOptimize(state->colors[0][count - 1]);
+	}, count);
+
+	// One direction at a time, what the batch is measured against
+	Benchmark::Register("SphericalHarmonics::Evaluate/L2", [state, count]()
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float direction[3] = { state->x[i], state->y[i], state->z[i] };
+			float color[3];
+			SphericalHarmonics::Evaluate(state->expansionL2, direction, color);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				state->colors[channel][i] = color[channel];
+		}
+
+		Benchmark::DoNotOptimize(state->colors[0][count - 1]);
+	}, count);
+
+	Benchmark::Register("SphericalHarmonics::ProjectBatch/L2", [state, count]()
+	{
+		SHL2RGB expansion;
+		SphericalHarmonics::ProjectBatch(state->x.data(), state->y.data(), state->z.data(), state->colors[0].data(), state->colors[1].data(),
+			state->colors[2].data(), nullptr, count, expansion);
+		Benchmark::DoNotOptimize(expansion);
+	}, count);
+
+	Benchmark::Register("SphericalHarmonics::Project/L2", [state, count]()
+	{
+		SHL2RGB expansion;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float direction[3] = { state->x[i], state->y[i], state->z[i] };
+			const float color[3] = { state->colors[0][i], state->colors[1][i], state->colors[2][i] };
+			SphericalHarmonics::Project(direction, color, 1.0f, expansion);
+		}
+
+		Benchmark::DoNotOptimize(expansion);
+	}, count);
+
+	const float axis[3] = { 0.48f, 0.6f, 0.64f };
+	float matrix[9];
+	GetRotation(axis, 0.7f, matrix);
+	const SHRotation rotation(matrix);
+
+	Benchmark::Register("SphericalHarmonics::Rotate/L2", [state, rotation]()
+	{
+		for (SHL2RGB& expansion : state->expansions)
+			rotation.Apply(expansion, expansion);
+
+		Benchmark::DoNotOptimize(state->expansions.back());
+	}, state->expansions.size());
+
+	const std::vector<std::string> checkedNames = { "SphericalHarmonics::EvaluateBatch/L2", "SphericalHarmonics::ProjectBatch/L2" };
+
+	Benchmark::Check("SphericalHarmonics", checkedNames, [checkedNames]()
+	{
+		std::vector<std::pair<std::string, double>> errors;
+		const uint32_t failedChecks = CheckSphericalHarmonics(errors);
+
+		for (const std::string& name : checkedNames)
+		{
+			for (const auto& error : errors)
+				Benchmark::SetMetric(name, error.first, error.second);
+		}
+
+		return failedChecks;
+	});
+}
\ No newline at end of file
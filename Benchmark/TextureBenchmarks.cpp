@@ -0,0 +1,245 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/DDSFormat.h"
+#include "../Engine/Utilities/DDSImage.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+	std::vector<uint8_t> ReadFile(const std::string& filePath)
+	{
+		std::ifstream inputFile(filePath, std::fstream::in | std::fstream::binary);
+
+		if (!inputFile.is_open())
+			return std::vector<uint8_t>();
+
+		return std::vector<uint8_t>((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+	}
+
+	// A header only DX10 file describing a full mip chain 2048x2048 BC7 cube map
+	std::vector<uint8_t> MakeDX10CubeMapHeader()
+	{
+		std::vector<uint8_t> ddsData(sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10), 0);
+
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = DDS_WIDTH | DDS_HEIGHT;
+		header.width = 2048;
+		header.height = 2048;
+		header.mipMapCount = 12;
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+		DDS_HEADER_DXT10 headerDXT10 = {};
+		headerDXT10.dxgiFormat = DXGI_FORMAT_BC7_UNORM_SRGB;
+		headerDXT10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+		headerDXT10.miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+		headerDXT10.arraySize = 1;
+
+		memcpy(&ddsData[0], &DDS_MAGIC, sizeof(uint32_t));
+		memcpy(&ddsData[sizeof(uint32_t)], &header, sizeof(DDS_HEADER));
+		memcpy(&ddsData[sizeof(uint32_t) + sizeof(DDS_HEADER)], &headerDXT10, sizeof(DDS_HEADER_DXT10));
+
+		return ddsData;
+	}
+
+	// A complete DX10 file whose subresources are filled with their own index, so a view that points
+	// at the wrong offset is easy to spot
+	std::vector<uint8_t> MakeDX10File(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t arraySize,
+		DXGI_FORMAT format, bool isCubeMap)
+	{
+		std::vector<uint8_t> ddsData = MakeDX10CubeMapHeader();
+
+		DDS_HEADER header;
+		memcpy(&header, &ddsData[sizeof(uint32_t)], sizeof(DDS_HEADER));
+		header.width = width;
+		header.height = height;
+		header.mipMapCount = mipCount;
+		memcpy(&ddsData[sizeof(uint32_t)], &header, sizeof(DDS_HEADER));
+
+		DDS_HEADER_DXT10 headerDXT10;
+		memcpy(&headerDXT10, &ddsData[sizeof(uint32_t) + sizeof(DDS_HEADER)], sizeof(DDS_HEADER_DXT10));
+		headerDXT10.dxgiFormat = format;
+		headerDXT10.miscFlag = isCubeMap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+		headerDXT10.arraySize = arraySize;
+		memcpy(&ddsData[sizeof(uint32_t) + sizeof(DDS_HEADER)], &headerDXT10, sizeof(DDS_HEADER_DXT10));
+
+		uint32_t sliceCount = isCubeMap ? (arraySize * 6) : arraySize;
+		uint8_t subresourceIndex = 0;
+
+		for (uint32_t arraySlice = 0; arraySlice < sliceCount; ++arraySlice)
+		{
+			for (uint32_t mip = 0; mip < mipCount; ++mip)
+			{
+				size_t mipWidth = (width >> mip) > 0 ? (width >> mip) : 1;
+				size_t mipHeight = (height >> mip) > 0 ? (height >> mip) : 1;
+
+				size_t numBytes = 0;
+				DDSFormat::GetSurfaceInfo(mipWidth, mipHeight, format, &numBytes, nullptr, nullptr);
+
+				ddsData.insert(ddsData.end(), numBytes, subresourceIndex++);
+			}
+		}
+
+		return ddsData;
+	}
+
+	// Checks the views of an image against its file, reports problems and returns false on failure
+	bool ValidateImage(const std::string& name, const DDSImage& image, const std::vector<uint8_t>& ddsData, bool hasIndexPattern)
+	{
+		const DDSDescription& description = image.GetDescription();
+		const uint8_t* fileEnd = image.GetSubresource(0).data - description.dataOffset + ddsData.size();
+
+		size_t totalSize = 0;
+
+		for (uint32_t i = 0; i < image.GetSubresourceCount(); ++i)
+		{
+			const DDSSubresource& subresource = image.GetSubresource(i);
+
+			bool isValid = subresource.data + subresource.size <= fileEnd
+				&& subresource.rowPitch * subresource.rowCount == subresource.slicePitch
+				&& subresource.slicePitch * subresource.depth == subresource.size
+				&& (i == 0 || subresource.data == image.GetSubresource(i - 1).data + image.GetSubresource(i - 1).size);
+
+			if (hasIndexPattern)
+				isValid = isValid && subresource.data[0] == (uint8_t)i && subresource.data[subresource.size - 1] == (uint8_t)i;
+
+			if (!isValid)
+			{
+				std::cerr << "DDSImage subresource " << i << " of " << name << " is invalid" << std::endl;
+				return false;
+			}
+
+			totalSize += subresource.size;
+		}
+
+		if (totalSize > description.dataSize)
+		{
+			std::cerr << "DDSImage subresources of " << name << " exceed the file" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	void RegisterImageLoad(const std::string& name, const std::string& filePath, const std::vector<uint8_t>& ddsData)
+	{
+		DDSImage image;
+
+		if (!image.Load(filePath) || !ValidateImage(name, image, ddsData, false))
+		{
+			Benchmark::ReportFailure("DDSImage::Load/" + name);
+			return;
+		}
+
+		Benchmark::Register("DDSImage::Load/" + name, [filePath]()
+		{
+			DDSImage loadedImage;
+			loadedImage.Load(filePath);
+			Benchmark::DoNotOptimize(loadedImage.GetSubresource(0));
+		}, 1);
+
+		// What LoadTextureDataFromFile does before the header is even looked at
+		Benchmark::Register("DDSTextureLoader::LoadTextureDataFromFile/" + name, [filePath]()
+		{
+			Benchmark::DoNotOptimize(ReadFile(filePath));
+		}, 1);
+	}
+
+	void RegisterImageViews(const std::string& name, const std::vector<uint8_t>& ddsData)
+	{
+		DDSImage image;
+
+		if (!image.LoadFromMemory(ddsData.data(), ddsData.size()) || !ValidateImage(name, image, ddsData, true))
+		{
+			Benchmark::ReportFailure("DDSImage::LoadFromMemory/" + name);
+			return;
+		}
+
+		auto fileData = std::make_shared<std::vector<uint8_t>>(ddsData);
+		std::string loadName = "DDSImage::LoadFromMemory/" + name;
+
+		// Every byte of the file is needed, losing the last one has to be caught
+		Benchmark::Check("DDSImage truncation of " + name, { loadName }, [fileData]()
+		{
+			DDSImage truncatedImage;
+			return truncatedImage.LoadFromMemory(fileData->data(), fileData->size() - 1) ? 1u : 0u;
+		});
+
+		Benchmark::Register(loadName, [fileData]()
+		{
+			DDSImage loadedImage;
+			loadedImage.LoadFromMemory(fileData->data(), fileData->size());
+			Benchmark::DoNotOptimize(loadedImage.GetSubresource(0));
+		}, image.GetSubresourceCount());
+	}
+
+	void RegisterHeaderParse(const std::string& name, const std::vector<uint8_t>& ddsData)
+	{
+		DDSDescription description;
+
+		if (!DDSFormat::ParseHeader(ddsData.data(), ddsData.size(), description))
+		{
+			std::cerr << "Skipping " << name << ", invalid DDS header" << std::endl;
+			return;
+		}
+
+		auto fileData = std::make_shared<std::vector<uint8_t>>(ddsData);
+
+		Benchmark::Register("DDSFormat::ParseHeader/" + name, [fileData]()
+		{
+			DDSDescription parsedDescription;
+			DDSFormat::ParseHeader(fileData->data(), fileData->size(), parsedDescription);
+			Benchmark::DoNotOptimize(parsedDescription);
+		}, 1);
+
+		// Walking the surfaces is what the loader does next to size the upload
+		Benchmark::Register("DDSFormat::GetSurfaceInfo/" + name, [description]()
+		{
+			size_t totalBytes = 0;
+
+			for (uint32_t arraySlice = 0; arraySlice < description.arraySize; ++arraySlice)
+			{
+				size_t width = description.width;
+				size_t height = description.height;
+
+				for (uint32_t mip = 0; mip < description.mipCount; ++mip)
+				{
+					size_t numBytes = 0;
+					DDSFormat::GetSurfaceInfo(width, height, description.format, &numBytes, nullptr, nullptr);
+					totalBytes += numBytes;
+
+					width = (width > 1) ? (width >> 1) : 1;
+					height = (height > 1) ? (height >> 1) : 1;
+				}
+			}
+
+			Benchmark::DoNotOptimize(totalBytes);
+		}, description.arraySize * description.mipCount);
+	}
+}
+
+void RegisterTextureBenchmarks()
+{
+	std::vector<uint8_t> lutData = ReadFile("../Assets/Textures/LUT.dds");
+
+	if (lutData.empty())
+	{
+		std::cerr << "Skipping LUT, texture file not found" << std::endl;
+	}
+	else
+	{
+		RegisterHeaderParse("LUT", lutData);
+		RegisterImageLoad("LUT", "../Assets/Textures/LUT.dds", lutData);
+	}
+
+	RegisterHeaderParse("DX10CubeMap", MakeDX10CubeMapHeader());
+
+	RegisterImageViews("BC7CubeMap", MakeDX10File(256, 256, 9, 1, DXGI_FORMAT_BC7_UNORM_SRGB, true));
+	RegisterImageViews("RGBA8Array", MakeDX10File(300, 200, 9, 4, DXGI_FORMAT_R8G8B8A8_UNORM, false));
+	RegisterImageViews("BC5NonPowerOfTwo", MakeDX10File(100, 60, 7, 1, DXGI_FORMAT_BC5_UNORM, false));
+}
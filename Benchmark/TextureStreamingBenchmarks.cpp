@@ -0,0 +1,479 @@
+#include "Benchmark.h"
+#include "../Engine/SceneManagement/MeshLoader.h"
+#include "../Engine/SceneManagement/SceneLoader.h"
+#include "../Engine/SceneManagement/TextureResidency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+
+using namespace DirectX;
+
+namespace
+{
+	// What DemoApp renders with
+	const float FovY = 0.33f * 3.14159265f;
+	const float ViewportHeight = 720.0f;
+
+	// The scene textures are not in the repository, every one stands in as a 2048x2048 BC7 texture
+	// whose tail starts at 128x128 like with the default TextureStreamerSettings
+	const uint32_t TextureSize = 2048;
+	const uint32_t TailMip = 4;
+
+	const uint64_t UploadLimit = 16ull * 1024 * 1024;
+
+	const double Megabyte = 1024.0 * 1024.0;
+
+	struct StreamedObject
+	{
+		XMFLOAT3 center;
+		float radius;
+		float uvDensity;
+		uint32_t textures[2];
+	};
+
+	struct CameraFrame
+	{
+		XMFLOAT3 position;
+		// Unit length
+		XMFLOAT3 forward;
+	};
+
+	struct MeshBounds
+	{
+		XMFLOAT3 center;
+		float radius;
+		float uvDensity;
+	};
+
+	std::vector<uint64_t> GetBC7MipBytes(uint32_t size)
+	{
+		std::vector<uint64_t> mipBytes;
+
+		for (uint32_t mipSize = size; ; mipSize = std::max(1u, mipSize / 2))
+		{
+			uint64_t blocks = std::max(1u, (mipSize + 3) / 4);
+			mipBytes.push_back(blocks * blocks * 16);
+
+			if (mipSize == 1)
+				break;
+		}
+
+		return mipBytes;
+	}
+
+	XMFLOAT3 Rotate(const XMFLOAT4& q, const XMFLOAT3& v)
+	{
+		// v + 2w (q x v) + 2 q x (q x v)
+		XMFLOAT3 t(2.0f * (q.y * v.z - q.z * v.y), 2.0f * (q.z * v.x - q.x * v.z), 2.0f * (q.x * v.y - q.y * v.x));
+
+		return XMFLOAT3(v.x + q.w * t.x + (q.y * t.z - q.z * t.y),
+			v.y + q.w * t.y + (q.z * t.x - q.x * t.z),
+			v.z + q.w * t.z + (q.x * t.y - q.y * t.x));
+	}
+
+	float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+	}
+
+	// Matches SceneManager::BuildRenderObjects: one material per unique mesh, whose diffuse and
+	// normal textures sit at twice its index
+	std::vector<StreamedObject> BuildObjects(const SceneDescription& sceneDescription, uint32_t& textureCount)
+	{
+		std::map<std::string, uint32_t> materialIndices;
+		std::vector<MeshBounds> meshBounds;
+		std::vector<StreamedObject> objects;
+
+		for (const SceneObject& sceneObject : sceneDescription.objects)
+		{
+			if (materialIndices.count(sceneObject.meshName) == 0)
+			{
+				MeshLoader::MeshData meshData = MeshLoader::LoadModel(sceneObject.meshName);
+
+				MeshBounds bounds;
+				MeshLoader::ComputeBoundingSphere(meshData, bounds.center, bounds.radius);
+				bounds.uvDensity = MeshLoader::ComputeUVDensity(meshData);
+
+				materialIndices[sceneObject.meshName] = (uint32_t)meshBounds.size();
+				meshBounds.push_back(bounds);
+			}
+
+			uint32_t materialIndex = materialIndices[sceneObject.meshName];
+			const MeshBounds& bounds = meshBounds[materialIndex];
+
+			float maxScale = std::max(std::fabs(sceneObject.scale.x), std::max(std::fabs(sceneObject.scale.y), std::fabs(sceneObject.scale.z)));
+			XMFLOAT3 scaledCenter(bounds.center.x * sceneObject.scale.x, bounds.center.y * sceneObject.scale.y, bounds.center.z * sceneObject.scale.z);
+			XMFLOAT3 rotatedCenter = Rotate(sceneObject.rotation, scaledCenter);
+
+			StreamedObject object;
+			object.center = XMFLOAT3(rotatedCenter.x + sceneObject.position.x, rotatedCenter.y + sceneObject.position.y,
+				rotatedCenter.z + sceneObject.position.z);
+			object.radius = bounds.radius * maxScale;
+			object.uvDensity = bounds.uvDensity / maxScale;
+			object.textures[0] = materialIndex * 2;
+			object.textures[1] = materialIndex * 2 + 1;
+
+			objects.push_back(object);
+		}
+
+		textureCount = 2 * (uint32_t)meshBounds.size();
+
+		return objects;
+	}
+
+	// From the scene's camera to just outside the bounds of every object in turn, looking where it goes
+	std::vector<CameraFrame> BuildCameraPath(const XMFLOAT3& start, const std::vector<StreamedObject>& objects, uint32_t framesPerLeg)
+	{
+		std::vector<CameraFrame> path;
+		XMFLOAT3 position = start;
+
+		for (const StreamedObject& object : objects)
+		{
+			float distance = std::max(Distance(position, object.center), 1.0e-3f);
+			float approach = std::max(0.0f, distance - object.radius - 1.0f) / distance;
+
+			XMFLOAT3 target(position.x + (object.center.x - position.x) * approach, position.y + (object.center.y - position.y) * approach,
+				position.z + (object.center.z - position.z) * approach);
+
+			CameraFrame frame;
+			frame.forward = XMFLOAT3((object.center.x - position.x) / distance, (object.center.y - position.y) / distance,
+				(object.center.z - position.z) / distance);
+
+			for (uint32_t frameIndex = 1; frameIndex <= framesPerLeg; ++frameIndex)
+			{
+				float t = (float)frameIndex / framesPerLeg;
+				frame.position = XMFLOAT3(position.x + (target.x - position.x) * t, position.y + (target.y - position.y) * t,
+					position.z + (target.z - position.z) * t);
+				path.push_back(frame);
+			}
+
+			position = target;
+		}
+
+		return path;
+	}
+
+	// Same requests as TextureStreamer::Update
+	void RequestMips(TextureResidency& residency, const std::vector<StreamedObject>& objects, const CameraFrame& camera)
+	{
+		for (const StreamedObject& object : objects)
+		{
+			XMFLOAT3 toObject(object.center.x - camera.position.x, object.center.y - camera.position.y, object.center.z - camera.position.z);
+
+			if (toObject.x * camera.forward.x + toObject.y * camera.forward.y + toObject.z * camera.forward.z < -object.radius)
+				continue;
+
+			float distance = Distance(object.center, camera.position) - object.radius;
+
+			for (uint32_t textureIndex : object.textures)
+			{
+				residency.Request(textureIndex, TextureResidency::ComputeRequiredMip(object.uvDensity * TextureSize, distance, FovY,
+					ViewportHeight, residency.GetMipCount(textureIndex)));
+			}
+		}
+	}
+
+	struct StreamingRun
+	{
+		uint64_t maxResidentBytes = 0;
+		uint64_t streamedInBytes = 0;
+		uint64_t evictedBytes = 0;
+		uint32_t budgetOverruns = 0;
+		uint32_t uploadLimitOverruns = 0;
+		uint32_t tailEvictions = 0;
+		// Updates until every request from the first camera position was granted
+		uint32_t updatesToSettle = 0;
+	};
+
+	StreamingRun RunCameraPath(TextureResidency& residency, const std::vector<StreamedObject>& objects, const std::vector<CameraFrame>& path)
+	{
+		StreamingRun run;
+		std::vector<ResidencyChange> changes;
+
+		// Standing still at the start first, then flying along the path
+		for (uint32_t update = 0; update < 1000; ++update)
+		{
+			RequestMips(residency, objects, path.front());
+			residency.Update(changes);
+
+			if (residency.GetStats().pendingTextures == 0)
+				break;
+
+			++run.updatesToSettle;
+		}
+
+		for (const CameraFrame& camera : path)
+		{
+			changes.clear();
+
+			RequestMips(residency, objects, camera);
+			residency.Update(changes);
+
+			const ResidencyStats& stats = residency.GetStats();
+
+			run.maxResidentBytes = std::max(run.maxResidentBytes, stats.residentBytes);
+			run.streamedInBytes += stats.streamedInBytes;
+			run.evictedBytes += stats.evictedBytes;
+
+			if (stats.residentBytes > residency.GetBudget())
+				++run.budgetOverruns;
+
+			// No single mip of the textures here is over the limit, which would be let through
+			if (stats.streamedInBytes > UploadLimit)
+				++run.uploadLimitOverruns;
+
+			for (const ResidencyChange& change : changes)
+			{
+				if (change.residentMip > residency.GetTailMip(change.texture))
+					++run.tailEvictions;
+			}
+		}
+
+		return run;
+	}
+
+	uint64_t AddTextures(TextureResidency& residency, uint32_t textureCount)
+	{
+		std::vector<uint64_t> mipBytes = GetBC7MipBytes(TextureSize);
+
+		for (uint32_t i = 0; i < textureCount; ++i)
+			residency.AddTexture(mipBytes, TailMip);
+
+		uint64_t fullChainBytes = 0;
+
+		for (uint64_t bytes : mipBytes)
+			fullChainBytes += bytes;
+
+		return fullChainBytes * textureCount;
+	}
+
+	// Three textures, room for two at full detail: after A and B were used, C has to evict A
+	uint32_t CountEvictionOrderErrors()
+	{
+		std::vector<uint64_t> mipBytes = GetBC7MipBytes(TextureSize);
+		uint64_t tailBytes = 0;
+		uint64_t fullChainBytes = 0;
+
+		for (size_t mip = 0; mip < mipBytes.size(); ++mip)
+		{
+			fullChainBytes += mipBytes[mip];
+
+			if (mip >= TailMip)
+				tailBytes += mipBytes[mip];
+		}
+
+		TextureResidency residency;
+		residency.SetBudget(2 * fullChainBytes + tailBytes);
+
+		for (int i = 0; i < 3; ++i)
+			residency.AddTexture(mipBytes, TailMip);
+
+		std::vector<ResidencyChange> changes;
+		uint32_t errors = 0;
+
+		residency.Request(0, 0);
+		residency.Update(changes);
+		residency.Request(1, 0);
+		residency.Update(changes);
+
+		if (residency.GetResidentMip(0) != 0 || residency.GetResidentMip(1) != 0)
+			++errors;
+
+		residency.Request(2, 0);
+		residency.Update(changes);
+
+		if (residency.GetResidentMip(0) != TailMip || residency.GetResidentMip(1) != 0 || residency.GetResidentMip(2) != 0)
+			++errors;
+
+		// Textures requested in the same update are never evicted for each other
+		residency.Request(1, 0);
+		residency.Request(2, 0);
+		residency.Request(0, 0);
+		residency.Update(changes);
+
+		if (residency.GetResidentMip(1) != 0 || residency.GetResidentMip(2) != 0 || residency.GetResidentMip(0) == 0)
+			++errors;
+
+		return errors;
+	}
+
+	// One texel per pixel at the distance where the texture's texels per world unit fill as many pixels,
+	// one mip down for every doubling of it
+	uint32_t CountRequiredMipErrors()
+	{
+		float texelsPerWorldUnit = (float)TextureSize;
+		float texelPerPixelDistance = ViewportHeight / (2.0f * std::tan(0.5f * FovY) * texelsPerWorldUnit);
+
+		uint32_t mipCount = (uint32_t)GetBC7MipBytes(TextureSize).size();
+		uint32_t errors = 0;
+
+		if (TextureResidency::ComputeRequiredMip(texelsPerWorldUnit, texelPerPixelDistance, FovY, ViewportHeight, mipCount) != 0)
+			++errors;
+
+		if (TextureResidency::ComputeRequiredMip(texelsPerWorldUnit, 2.5f * texelPerPixelDistance, FovY, ViewportHeight, mipCount) != 1)
+			++errors;
+
+		if (TextureResidency::ComputeRequiredMip(texelsPerWorldUnit, 4.5f * texelPerPixelDistance, FovY, ViewportHeight, mipCount) != 2)
+			++errors;
+
+		if (TextureResidency::ComputeRequiredMip(texelsPerWorldUnit, 1.0e6f, FovY, ViewportHeight, mipCount) != mipCount - 1)
+			++errors;
+
+		return errors;
+	}
+
+	void SetRunMetrics(const std::string& caseName, const StreamingRun& run)
+	{
+		Benchmark::SetMetric(caseName, "max_resident_mb", run.maxResidentBytes / Megabyte);
+		Benchmark::SetMetric(caseName, "streamed_in_mb", run.streamedInBytes / Megabyte);
+		Benchmark::SetMetric(caseName, "evicted_mb", run.evictedBytes / Megabyte);
+		Benchmark::SetMetric(caseName, "budget_overruns", run.budgetOverruns);
+		Benchmark::SetMetric(caseName, "upload_limit_overruns", run.uploadLimitOverruns);
+		Benchmark::SetMetric(caseName, "tail_evictions", run.tailEvictions);
+	}
+
+	uint32_t CountRunErrors(const StreamingRun& run)
+	{
+		return (run.budgetOverruns != 0 ? 1 : 0) + (run.uploadLimitOverruns != 0 ? 1 : 0) + (run.tailEvictions != 0 ? 1 : 0);
+	}
+
+	void RegisterSceneStreaming(const std::string& name)
+	{
+		SceneDescription sceneDescription;
+
+		if (!SceneLoader::LoadSceneDescription("../Assets/Scenes/" + name + ".txt", sceneDescription) || sceneDescription.objects.empty())
+		{
+			std::cerr << "Skipping texture streaming of " << name << ", scene file not found" << std::endl;
+			return;
+		}
+
+		uint32_t textureCount = 0;
+		auto objects = std::make_shared<std::vector<StreamedObject>>(BuildObjects(sceneDescription, textureCount));
+		auto path = std::make_shared<std::vector<CameraFrame>>(BuildCameraPath(sceneDescription.cameraPosition, *objects, 60));
+		auto residency = std::make_shared<TextureResidency>();
+
+		std::string caseName = "TextureResidency::Update/" + name;
+
+		// Walks the path once before it is timed, the timed walk goes on from where this one ended
+		Benchmark::Check("TextureResidency in " + name, { caseName }, [residency, objects, path, textureCount, caseName]()
+		{
+			// Unlimited budget, how much the tails save at startup and how much a walk through the scene needs
+			TextureResidency unlimitedResidency;
+			unlimitedResidency.SetUploadLimit(UploadLimit);
+
+			uint64_t fullChainBytes = AddTextures(unlimitedResidency, textureCount);
+			uint64_t startupBytes = unlimitedResidency.GetStats().residentBytes;
+
+			StreamingRun unlimitedRun = RunCameraPath(unlimitedResidency, *objects, *path);
+
+			// Half of what the walk needed, so textures have to be evicted along the way
+			uint64_t budget = startupBytes + (unlimitedRun.maxResidentBytes - startupBytes) / 2;
+
+			residency->SetBudget(budget);
+			residency->SetUploadLimit(UploadLimit);
+			AddTextures(*residency, textureCount);
+
+			StreamingRun run = RunCameraPath(*residency, *objects, *path);
+
+			Benchmark::SetMetric(caseName, "full_chain_mb", fullChainBytes / Megabyte);
+			Benchmark::SetMetric(caseName, "startup_upload_mb", startupBytes / Megabyte);
+			Benchmark::SetMetric(caseName, "unlimited_max_resident_mb", unlimitedRun.maxResidentBytes / Megabyte);
+			Benchmark::SetMetric(caseName, "unlimited_updates_to_settle", unlimitedRun.updatesToSettle);
+			Benchmark::SetMetric(caseName, "budget_mb", budget / Megabyte);
+			SetRunMetrics(caseName, run);
+
+			// Never going over the budget or upload limit or evicting a mip tail, and evicting at all with half the memory
+			return CountRunErrors(run) + (run.evictedBytes == 0 ? 1 : 0);
+		});
+
+		// One frame of the walk per iteration, going round the path
+		auto frame = std::make_shared<size_t>(0);
+
+		Benchmark::Register(caseName, [residency, objects, path, frame]()
+		{
+			std::vector<ResidencyChange> changes;
+
+			RequestMips(*residency, *objects, (*path)[*frame]);
+			residency->Update(changes);
+
+			*frame = (*frame + 1) % path->size();
+
+			Benchmark::DoNotOptimize(changes);
+		}, objects->size());
+	}
+
+	// Far more textures than the demo scenes, objects on a grid with the camera flying over it
+	void RegisterManyTextures(uint32_t objectCount)
+	{
+		auto objects = std::make_shared<std::vector<StreamedObject>>(objectCount);
+		uint32_t gridSize = (uint32_t)std::ceil(std::sqrt((double)objectCount));
+
+		for (uint32_t i = 0; i < objectCount; ++i)
+		{
+			StreamedObject& object = (*objects)[i];
+			object.center = XMFLOAT3(4.0f * (i % gridSize), 0.0f, 4.0f * (i / gridSize));
+			object.radius = 1.0f;
+			object.uvDensity = 0.5f;
+			object.textures[0] = 2 * i;
+			object.textures[1] = 2 * i + 1;
+		}
+
+		// Along the grid's diagonal and back
+		auto path = std::make_shared<std::vector<CameraFrame>>();
+		float extent = 4.0f * gridSize;
+
+		for (uint32_t frameIndex = 0; frameIndex < 600; ++frameIndex)
+		{
+			float t = frameIndex < 300 ? frameIndex / 300.0f : (600 - frameIndex) / 300.0f;
+			float direction = frameIndex < 300 ? 1.0f : -1.0f;
+
+			CameraFrame frame;
+			frame.position = XMFLOAT3(extent * t, 2.0f, extent * t);
+			frame.forward = XMFLOAT3(0.7071068f * direction, 0.0f, 0.7071068f * direction);
+			path->push_back(frame);
+		}
+
+		auto residency = std::make_shared<TextureResidency>();
+		uint64_t fullChainBytes = AddTextures(*residency, 2 * objectCount);
+		residency->SetBudget(fullChainBytes / 64);
+		residency->SetUploadLimit(UploadLimit);
+
+		std::string caseName = "TextureResidency::Update/Grid" + std::to_string(objectCount);
+
+		Benchmark::Check("TextureResidency with " + std::to_string(objectCount) + " objects", { caseName }, [residency, objects, path, caseName]()
+		{
+			StreamingRun run = RunCameraPath(*residency, *objects, *path);
+			SetRunMetrics(caseName, run);
+
+			return CountRunErrors(run);
+		});
+
+		auto frame = std::make_shared<size_t>(0);
+
+		Benchmark::Register(caseName, [residency, objects, path, frame]()
+		{
+			std::vector<ResidencyChange> changes;
+
+			RequestMips(*residency, *objects, (*path)[*frame]);
+			residency->Update(changes);
+
+			*frame = (*frame + 1) % path->size();
+
+			Benchmark::DoNotOptimize(changes);
+		}, objects->size());
+	}
+}
+
+void RegisterTextureStreamingBenchmarks()
+{
+	// The other scenes only use one or two meshes
+	RegisterSceneStreaming("DemoScene4");
+
+	RegisterManyTextures(2048);
+
+	Benchmark::Check("TextureResidency eviction order", { "TextureResidency::Update/DemoScene4", "TextureResidency::Update/Grid2048" }, CountEvictionOrderErrors);
+	Benchmark::Check("TextureResidency::ComputeRequiredMip", { "TextureResidency::Update/DemoScene4", "TextureResidency::Update/Grid2048" }, CountRequiredMipErrors);
+}
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include "Benchmark.h"
+#include "../Engine/SceneManagement/SceneLoader.h"
+#include "../Engine/Utilities/DDSFormat.h"
+#include "../Engine/Utilities/TextureUploadBatch.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+
+namespace
+{
+	// The scene textures are not in the repository, every one is written out as a 2048x2048 BC7 file
+	// with a full mip chain, the size the cooked scene textures are
+	const uint32_t TextureSize = 2048;
+	const uint32_t TailSize = 128;
+
+	const double Megabyte = 1024.0 * 1024.0;
+
+	std::vector<std::string> gTemporaryFiles;
+
+	void RemoveTemporaryFiles()
+	{
+		for (const std::string& filePath : gTemporaryFiles)
+			std::remove(filePath.c_str());
+	}
+
+	bool WriteTextureFile(const std::string& filePath, uint32_t seed)
+	{
+		DDSDescription description;
+		description.width = TextureSize;
+		description.height = TextureSize;
+		description.depth = 1;
+		description.arraySize = 1;
+		description.format = DXGI_FORMAT_BC7_UNORM_SRGB;
+		description.dimension = DDS_DIMENSION_TEXTURE2D;
+
+		for (uint32_t size = TextureSize; size > 0; size /= 2)
+			++description.mipCount;
+
+		std::vector<uint8_t> ddsData;
+		DDSFormat::WriteHeader(description, ddsData);
+
+		size_t headerSize = ddsData.size();
+
+		for (uint32_t mip = 0; mip < description.mipCount; ++mip)
+		{
+			size_t numBytes = 0;
+			DDSFormat::GetSurfaceInfo(std::max(1u, TextureSize >> mip), std::max(1u, TextureSize >> mip), description.format, &numBytes, nullptr, nullptr);
+			ddsData.resize(ddsData.size() + numBytes);
+		}
+
+		// Any block data will do, it is only copied around
+		uint32_t state = seed * 747796405u + 2891336453u;
+
+		for (size_t i = headerSize; i < ddsData.size(); ++i)
+		{
+			state = state * 1664525u + 1013904223u;
+			ddsData[i] = (uint8_t)(state >> 24);
+		}
+
+		std::ofstream outputFile(filePath, std::fstream::out | std::fstream::binary);
+
+		if (!outputFile.is_open())
+			return false;
+
+		outputFile.write((const char*)ddsData.data(), ddsData.size());
+
+		return outputFile.good();
+	}
+
+	// One read of the whole file, like LoadTextureDataFromFile
+	std::vector<uint8_t> ReadFile(const std::string& filePath)
+	{
+		std::ifstream inputFile(filePath, std::fstream::in | std::fstream::binary | std::fstream::ate);
+
+		if (!inputFile.is_open())
+			return std::vector<uint8_t>();
+
+		std::vector<uint8_t> fileData((size_t)inputFile.tellg());
+		inputFile.seekg(0);
+		inputFile.read((char*)fileData.data(), fileData.size());
+
+		return fileData;
+	}
+
+	// Same choice as TextureStreamer for the cooked textures, which halve exactly down to the tail
+	uint32_t GetTailMip(const DDSDescription& description)
+	{
+		uint32_t tailMip = 0;
+
+		while (tailMip + 1 < description.mipCount && std::max(description.width >> tailMip, description.height >> tailMip) > TailSize)
+			++tailMip;
+
+		return tailMip;
+	}
+
+	// The way every texture used to be loaded: the whole file read on the calling thread, then copied
+	// into a staging buffer of its own, one texture after the other. Returns the staged bytes.
+	uint64_t LoadSerially(const std::vector<std::string>& filePaths, std::vector<std::vector<uint8_t>>& stagingBuffers)
+	{
+		uint64_t stagedBytes = 0;
+
+		stagingBuffers.resize(filePaths.size());
+
+		for (size_t i = 0; i < filePaths.size(); ++i)
+		{
+			std::vector<uint8_t> ddsData = ReadFile(filePaths[i]);
+
+			DDSImage image;
+
+			if (!image.LoadFromMemory(ddsData.data(), ddsData.size()))
+				continue;
+
+			std::vector<UploadFootprint> footprints;
+			uint64_t stagingSize = TextureUploadBatch::ComputeLayout(image, 0, image.GetDescription().mipCount, footprints);
+
+			// A new upload heap per texture
+			stagingBuffers[i] = std::vector<uint8_t>(stagingSize);
+
+			for (const UploadFootprint& footprint : footprints)
+				TextureUploadBatch::CopyToStaging(image, footprint, stagingBuffers[i].data());
+
+			stagedBytes += stagingSize;
+		}
+
+		return stagedBytes;
+	}
+
+	uint64_t LoadBatched(const std::vector<std::string>& filePaths, bool isTailOnly, StagingRing& ring, std::vector<uint8_t>& ringData,
+		TextureUploadBatch& batch)
+	{
+		batch.Clear();
+
+		for (const std::string& filePath : filePaths)
+			batch.Add(filePath);
+
+		if (isTailOnly)
+			batch.Open(GetTailMip);
+		else
+			batch.Open(nullptr);
+
+		batch.Stage(ring, ringData.data());
+
+		uint64_t stagedBytes = 0;
+
+		for (uint32_t i = 0; i < batch.GetCount(); ++i)
+			stagedBytes += batch.GetUpload(i).isStaged ? batch.GetUpload(i).stagingSize : 0;
+
+		return stagedBytes;
+	}
+
+	// Walks a small ring through filling up, wrapping around and draining
+	uint32_t CountStagingRingErrors()
+	{
+		StagingRing ring;
+		ring.Reset(1000);
+
+		uint32_t errors = 0;
+		uint64_t offset = 0;
+
+		errors += (!ring.Allocate(400, 8, offset) || offset != 0) ? 1 : 0;
+		ring.Retire(1);
+		errors += (!ring.Allocate(390, 16, offset) || offset != 400) ? 1 : 0;
+		ring.Retire(2);
+
+		// Full until the first fence completes
+		errors += ring.Allocate(400, 8, offset) ? 1 : 0;
+		ring.Release(1);
+
+		// Doesn't fit at the end of the ring, so it wraps to the start
+		errors += (!ring.Allocate(400, 8, offset) || offset != 0) ? 1 : 0;
+		ring.Retire(3);
+
+		errors += ring.Allocate(1, 1, offset) ? 1 : 0;
+		errors += ring.GetUsedBytes() != 1000 ? 1 : 0;
+
+		ring.Release(3);
+		errors += ring.GetUsedBytes() != 0 ? 1 : 0;
+
+		// Never fits
+		errors += ring.Allocate(1001, 1, offset) ? 1 : 0;
+
+		return errors;
+	}
+
+	void RegisterSceneUpload(const std::string& name)
+	{
+		SceneDescription sceneDescription;
+
+		if (!SceneLoader::LoadSceneDescription("../Assets/Scenes/" + name + ".txt", sceneDescription))
+		{
+			std::cerr << "Skipping texture upload of " << name << ", scene file not found" << std::endl;
+			return;
+		}
+
+		std::set<std::string> textureNames;
+
+		for (const SceneObject& sceneObject : sceneDescription.objects)
+		{
+			textureNames.insert(sceneObject.diffuseOpacityTextureName);
+			textureNames.insert(sceneObject.normalRoughnessTextureName);
+		}
+
+		auto filePaths = std::make_shared<std::vector<std::string>>();
+		uint32_t seed = 0;
+
+		for (const std::string& textureName : textureNames)
+		{
+			std::string filePath = "TextureUploadBenchmark_" + textureName + ".dds";
+
+			if (!WriteTextureFile(filePath, seed++))
+			{
+				std::cerr << "Skipping texture upload of " << name << ", can't write " << filePath << std::endl;
+				return;
+			}
+
+			gTemporaryFiles.push_back(filePath);
+			filePaths->push_back(filePath);
+		}
+
+		auto serialStaging = std::make_shared<std::vector<std::vector<uint8_t>>>();
+		uint64_t stagedBytes = LoadSerially(*filePaths, *serialStaging);
+
+		// Big enough for every texture of the scene
+		auto ring = std::make_shared<StagingRing>();
+		auto ringData = std::make_shared<std::vector<uint8_t>>(stagedBytes + filePaths->size() * TextureUploadBatch::PlacementAlignment);
+		auto batch = std::make_shared<TextureUploadBatch>();
+
+		ring->Reset(ringData->size());
+
+		std::string serialName = "TextureUpload::Serial/" + name;
+		std::string batchName = "TextureUpload::Batch/" + name;
+		std::string tailName = "TextureUpload::BatchTails/" + name;
+
+		Benchmark::Register(serialName, [filePaths]()
+		{
+			std::vector<std::vector<uint8_t>> stagingBuffers;
+			Benchmark::DoNotOptimize(LoadSerially(*filePaths, stagingBuffers));
+		}, filePaths->size());
+
+		// The ring is drained after every load, as if the GPU kept up
+		uint64_t fence = 0;
+
+		Benchmark::Register(batchName, [filePaths, ring, ringData, batch, fence]() mutable
+		{
+			Benchmark::DoNotOptimize(LoadBatched(*filePaths, false, *ring, *ringData, *batch));
+
+			ring->Retire(++fence);
+			ring->Release(fence);
+		}, filePaths->size());
+
+		Benchmark::Register(tailName, [filePaths, ring, ringData, batch, fence]() mutable
+		{
+			Benchmark::DoNotOptimize(LoadBatched(*filePaths, true, *ring, *ringData, *batch));
+
+			ring->Retire(++fence);
+			ring->Release(fence);
+		}, filePaths->size());
+
+		// Both paths have to stage the same bytes
+		Benchmark::Check("TextureUploadBatch of " + name, { batchName, tailName }, [filePaths, serialStaging, ring, ringData, batch, batchName, tailName]()
+		{
+			LoadBatched(*filePaths, false, *ring, *ringData, *batch);
+
+			uint32_t mismatchedTextures = 0;
+
+			for (uint32_t i = 0; i < batch->GetCount(); ++i)
+			{
+				const TextureUpload& upload = batch->GetUpload(i);
+				const std::vector<uint8_t>& serialData = (*serialStaging)[i];
+
+				if (!upload.isStaged || upload.stagingSize != serialData.size()
+					|| memcmp(ringData->data() + upload.stagingOffset, serialData.data(), serialData.size()) != 0)
+					++mismatchedTextures;
+			}
+
+			ring->Retire(0);
+			ring->Release(0);
+
+			uint64_t tailBytes = LoadBatched(*filePaths, true, *ring, *ringData, *batch);
+			ring->Retire(0);
+			ring->Release(0);
+
+			Benchmark::SetMetric(batchName, "ring_peak_mb", ring->GetPeakUsedBytes() / Megabyte);
+			Benchmark::SetMetric(batchName, "mismatched_textures", mismatchedTextures);
+			Benchmark::SetMetric(tailName, "staged_mb", tailBytes / Megabyte);
+
+			return mismatchedTextures;
+		});
+
+		Benchmark::SetMetric(serialName, "textures", (double)filePaths->size());
+		Benchmark::SetMetric(serialName, "staged_mb", stagedBytes / Megabyte);
+		Benchmark::SetMetric(batchName, "staged_mb", stagedBytes / Megabyte);
+	}
+}
+
+void RegisterTextureUploadBenchmarks()
+{
+	std::atexit(RemoveTemporaryFiles);
+
+	RegisterSceneUpload("DemoScene4");
+
+	Benchmark::Check("StagingRing", { "TextureUpload::Batch/DemoScene4", "TextureUpload::BatchTails/DemoScene4" }, CountStagingRingErrors);
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/ThreadPool.h"
+#include "../Engine/Utilities/UploadQueue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	const double Megabyte = 1024.0 * 1024.0;
+
+	const uint64_t Alignment = 512;
+
+	// Geometry and small textures of a few to some hundred kilobytes, every byte derived from the index
+	uint64_t GetUploadSize(uint32_t index)
+	{
+		return 4096 + (uint64_t)((index * 2654435761u) % 61) * 4096;
+	}
+
+	uint8_t GetUploadByte(uint32_t index, uint64_t offset)
+	{
+		return (uint8_t)(index * 31 + offset);
+	}
+
+	struct UploadScenario
+	{
+		std::vector<std::vector<uint8_t>>	data;
+		uint64_t							totalBytes = 0;
+
+		StagingRing							ring;
+		std::vector<uint8_t>				ringData;
+	};
+
+	// Requests every upload from the thread pool, then packs and submits them until none is left
+	// waiting, completing each submission right away as if the GPU kept up. Returns the submissions.
+	uint32_t UploadThroughQueue(UploadScenario& scenario, uint64_t& fence, std::vector<uint64_t>* recordedTickets)
+	{
+		UploadQueue queue;
+		std::vector<UploadTicket> tickets(scenario.data.size());
+
+		ThreadPool::ParallelFor(scenario.data.size(), 16, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const std::vector<uint8_t>& data = scenario.data[i];
+
+				tickets[i] = queue.Enqueue(data.size(), Alignment, [&data](uint8_t* stagingData)
+				{
+					memcpy(stagingData, data.data(), data.size());
+				}, [&tickets, recordedTickets, i](uint64_t)
+				{
+					if (recordedTickets != nullptr)
+						recordedTickets->push_back(tickets[i].value);
+				});
+			}
+		});
+
+		uint32_t submissions = 0;
+
+		while (queue.GetWaitingCount() > 0)
+		{
+			queue.Pack(scenario.ring, scenario.ringData.data());
+			queue.Submit(scenario.ring, ++fence);
+			queue.Complete(scenario.ring, fence);
+			++submissions;
+		}
+
+		return submissions;
+	}
+
+	// The same copies without a queue, allocated and written by one thread
+	uint32_t UploadSerially(UploadScenario& scenario, uint64_t& fence)
+	{
+		uint32_t submissions = 1;
+
+		for (const std::vector<uint8_t>& data : scenario.data)
+		{
+			uint64_t offset = 0;
+
+			if (!scenario.ring.Allocate(data.size(), Alignment, offset))
+			{
+				scenario.ring.Retire(++fence);
+				scenario.ring.Release(fence);
+				++submissions;
+
+				scenario.ring.Allocate(data.size(), Alignment, offset);
+			}
+
+			memcpy(scenario.ringData.data() + offset, data.data(), data.size());
+		}
+
+		scenario.ring.Retire(++fence);
+		scenario.ring.Release(fence);
+
+		return submissions;
+	}
+
+	uint32_t CountUploadQueueErrors()
+	{
+		UploadQueue queue;
+		StagingRing ring;
+		std::vector<uint8_t> ringData(1000, 0);
+		std::vector<uint64_t> recordedOffsets;
+
+		ring.Reset(ringData.size());
+
+		uint32_t errors = 0;
+
+		auto write = [](uint8_t value)
+		{
+			return [value](uint8_t* stagingData) { memset(stagingData, value, 400); };
+		};
+
+		auto record = [&recordedOffsets](uint64_t offset) { recordedOffsets.push_back(offset); };
+
+		UploadTicket first = queue.Enqueue(400, 8, write(1), record);
+		UploadTicket second = queue.Enqueue(400, 8, write(2), record);
+		UploadTicket third = queue.Enqueue(400, 8, write(3), record);
+
+		errors += (first.value != 1 || second.value != 2 || third.value != 3 || queue.GetLastTicket().value != 3) ? 1 : 0;
+		errors += queue.IsComplete(UploadTicket()) ? 0 : 1;
+
+		// The third doesn't fit next to the first two
+		errors += queue.Pack(ring, ringData.data()) != 2 ? 1 : 0;
+		errors += queue.GetWaitingCount() != 1 ? 1 : 0;
+		errors += (recordedOffsets.size() != 2 || recordedOffsets[0] != 0 || recordedOffsets[1] != 400) ? 1 : 0;
+		errors += (ringData[0] != 1 || ringData[399] != 1 || ringData[400] != 2 || ringData[799] != 2) ? 1 : 0;
+
+		errors += queue.GetFence(first) != UINT64_MAX ? 1 : 0;
+		queue.Submit(ring, 5);
+		errors += (queue.GetFence(first) != 5 || queue.GetFence(second) != 5 || queue.GetFence(third) != UINT64_MAX) ? 1 : 0;
+
+		// Still full until the submission completes
+		errors += queue.Pack(ring, ringData.data()) != 0 ? 1 : 0;
+		queue.Submit(ring, 6);
+
+		queue.Complete(ring, 4);
+		errors += queue.IsComplete(first) ? 1 : 0;
+
+		queue.Complete(ring, 6);
+		errors += (!queue.IsComplete(first) || !queue.IsComplete(second) || queue.IsComplete(third)) ? 1 : 0;
+		errors += queue.GetFence(second) != 0 ? 1 : 0;
+
+		errors += queue.Pack(ring, ringData.data()) != 1 ? 1 : 0;
+		errors += (recordedOffsets.size() != 3 || recordedOffsets[2] != 0 || ringData[0] != 3) ? 1 : 0;
+		queue.Submit(ring, 7);
+		queue.Complete(ring, 7);
+		errors += queue.IsComplete(third) ? 0 : 1;
+
+		// Larger than the ring, it stays waiting and holds back the uploads behind it
+		queue.Enqueue(1001, 8, nullptr, nullptr);
+		UploadTicket recordOnly = queue.Enqueue(0, 1, nullptr, record);
+
+		errors += queue.Pack(ring, ringData.data()) != 0 ? 1 : 0;
+		errors += (queue.GetWaitingCount() != 2 || queue.GetFence(recordOnly) != UINT64_MAX) ? 1 : 0;
+
+		return errors;
+	}
+
+	void RegisterUploads(uint32_t uploadCount)
+	{
+		auto scenario = std::make_shared<UploadScenario>();
+
+		for (uint32_t i = 0; i < uploadCount; ++i)
+		{
+			std::vector<uint8_t> data((size_t)GetUploadSize(i));
+
+			for (size_t j = 0; j < data.size(); ++j)
+				data[j] = GetUploadByte(i, j);
+
+			scenario->totalBytes += data.size();
+			scenario->data.push_back(std::move(data));
+		}
+
+		// An eighth of the uploads fits at once, so they go out over several submissions
+		scenario->ringData.resize((size_t)(scenario->totalBytes / 8));
+		scenario->ring.Reset(scenario->ringData.size());
+
+		// Shared by the check and both cases, every upload signals the next fence value
+		auto fence = std::make_shared<uint64_t>(0);
+
+		std::string countName = std::to_string(uploadCount);
+		std::string queueName = "UploadQueue::EnqueuePack/" + countName;
+		std::string serialName = "UploadQueue::Serial/" + countName;
+
+		// Tickets have to be recorded in request order, whichever thread requested them
+		Benchmark::Check("UploadQueue ticket order with " + countName + " uploads", { queueName }, [scenario, fence, uploadCount, queueName]()
+		{
+			std::vector<uint64_t> recordedTickets;
+			uint32_t submissions = UploadThroughQueue(*scenario, *fence, &recordedTickets);
+
+			uint32_t outOfOrderTickets = 0;
+
+			for (size_t i = 0; i < recordedTickets.size(); ++i)
+				outOfOrderTickets += recordedTickets[i] != i + 1 ? 1 : 0;
+
+			outOfOrderTickets += (uint32_t)(uploadCount - std::min<size_t>(uploadCount, recordedTickets.size()));
+
+			Benchmark::SetMetric(queueName, "submissions", submissions);
+			Benchmark::SetMetric(queueName, "out_of_order_tickets", outOfOrderTickets);
+
+			return outOfOrderTickets;
+		});
+
+		Benchmark::Register(queueName, [scenario, fence]()
+		{
+			Benchmark::DoNotOptimize(UploadThroughQueue(*scenario, *fence, nullptr));
+		}, uploadCount);
+
+		Benchmark::Register(serialName, [scenario, fence]()
+		{
+			Benchmark::DoNotOptimize(UploadSerially(*scenario, *fence));
+		}, uploadCount);
+
+		Benchmark::SetMetric(queueName, "staged_mb", scenario->totalBytes / Megabyte);
+		Benchmark::SetMetric(queueName, "ring_mb", scenario->ringData.size() / Megabyte);
+		Benchmark::SetMetric(serialName, "staged_mb", scenario->totalBytes / Megabyte);
+	}
+}
+
+void RegisterUploadQueueBenchmarks()
+{
+	RegisterUploads(1024);
+
+	Benchmark::Check("UploadQueue", { "UploadQueue::EnqueuePack/1024" }, CountUploadQueueErrors);
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "VoxelBenchmarkScene.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	const float NearZ = 1.0f;
+	const float FarZ = 1000.0f;
+
+	struct Sphere
+	{
+		float center[3];
+		float radius;
+		float color[3];
+	};
+
+	const Sphere Spheres[] =
+	{
+		{ { -12.0f, 6.0f, 10.0f }, 6.0f, { 1.2f, 0.3f, 0.2f } },
+		{ { 8.0f, 4.0f, 0.0f }, 4.0f, { 0.2f, 0.9f, 0.3f } },
+		{ { 20.0f, 10.0f, 30.0f }, 10.0f, { 0.4f, 0.5f, 1.1f } }
+	};
+
+	float IntersectPlane(float origin, float direction, float plane)
+	{
+		float t = (plane - origin) / direction;
+		return t > 0.0f ? t : FarZ;
+	}
+
+	float IntersectSphere(const float* origin, const float* direction, const Sphere& sphere)
+	{
+		float offset[3] = { origin[0] - sphere.center[0], origin[1] - sphere.center[1], origin[2] - sphere.center[2] };
+		float a = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+		float b = offset[0] * direction[0] + offset[1] * direction[1] + offset[2] * direction[2];
+		float c = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2] - sphere.radius * sphere.radius;
+		float discriminant = b * b - a * c;
+
+		if (discriminant < 0.0f)
+			return FarZ;
+
+		float t = (-b - std::sqrt(discriminant)) / a;
+		return t > 0.0f ? t : FarZ;
+	}
+}
+
+void BuildInjectionFrame(InjectionFrame& frame, uint32_t width, uint32_t height, const float* eye, float yaw)
+{
+	const float yScale = 1.0f / std::tan(0.25f * 3.14159265f * 0.5f);
+	const float xScale = yScale * (float)height / (float)width;
+
+	const float right[3] = { std::cos(yaw), 0.0f, -std::sin(yaw) };
+	const float forward[3] = { std::sin(yaw), 0.0f, std::cos(yaw) };
+
+	// Inverse of a left handed perspective projection, and of a view that turns and moves the camera
+	frame.input.invProj = XMFLOAT4X4(
+		1.0f / xScale, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f / yScale, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, -(FarZ - NearZ) / (NearZ * FarZ),
+		0.0f, 0.0f, 1.0f, 1.0f / NearZ);
+
+	frame.input.invView = XMFLOAT4X4(
+		right[0], right[1], right[2], 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		forward[0], forward[1], forward[2], 0.0f,
+		eye[0], eye[1], eye[2], 1.0f);
+
+	frame.view.invProj = frame.input.invProj;
+	frame.view.invView = frame.input.invView;
+
+	frame.view.proj = XMFLOAT4X4(
+		xScale, 0.0f, 0.0f, 0.0f,
+		0.0f, yScale, 0.0f, 0.0f,
+		0.0f, 0.0f, FarZ / (FarZ - NearZ), 1.0f,
+		0.0f, 0.0f, -NearZ * FarZ / (FarZ - NearZ), 0.0f);
+
+	frame.view.view = XMFLOAT4X4(
+		right[0], 0.0f, forward[0], 0.0f,
+		right[1], 1.0f, forward[1], 0.0f,
+		right[2], 0.0f, forward[2], 0.0f,
+		-(eye[0] * right[0] + eye[2] * right[2]), -eye[1], -(eye[0] * forward[0] + eye[2] * forward[2]), 1.0f);
+
+	frame.view.width = width;
+	frame.view.height = height;
+
+	frame.lighting.resize((size_t)width * height);
+	frame.depth.resize((size_t)width * height);
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			// Distance along the view axis equals t, the ray's z is one in view space
+			const float viewX = ((float)x / width * 2.0f - 1.0f) / xScale;
+			float direction[3] = { viewX * right[0] + forward[0], ((float)y / height * 2.0f - 1.0f) / yScale, viewX * right[2] + forward[2] };
+
+			float t = std::min(IntersectPlane(eye[1], direction[1], 0.0f), IntersectPlane(eye[2], direction[2], 45.0f));
+			t = std::min(t, IntersectPlane(eye[0], direction[0], direction[0] < 0.0f ? -40.0f : 40.0f));
+
+			const Sphere* hitSphere = nullptr;
+
+			for (const Sphere& sphere : Spheres)
+			{
+				float sphereT = IntersectSphere(eye, direction, sphere);
+
+				if (sphereT < t)
+				{
+					t = sphereT;
+					hitSphere = &sphere;
+				}
+			}
+
+			size_t pixelIndex = (size_t)y * width + x;
+			float hit[3] = { eye[0] + direction[0] * t, eye[1] + direction[1] * t, eye[2] + direction[2] * t };
+
+			// Rays leaving through the open top keep the cleared depth
+			if (t >= FarZ || hit[1] > 30.0f)
+			{
+				frame.depth[pixelIndex] = 0.0f;
+				frame.lighting[pixelIndex] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+				continue;
+			}
+
+			frame.depth[pixelIndex] = 0.5f * (1.0f + FarZ * (t - NearZ) / (t * (FarZ - NearZ)));
+
+			if (hitSphere != nullptr)
+			{
+				float shade = 0.3f + 0.7f * std::max((hit[1] - hitSphere->center[1]) / hitSphere->radius, 0.0f);
+				frame.lighting[pixelIndex] = XMFLOAT4(hitSphere->color[0] * shade, hitSphere->color[1] * shade, hitSphere->color[2] * shade, 1.0f);
+			}
+			else
+			{
+				bool checker = (((int)std::floor(hit[0] / 4.0f) + (int)std::floor(hit[1] / 4.0f) + (int)std::floor(hit[2] / 4.0f)) & 1) != 0;
+				float shade = checker ? 0.8f : 0.25f;
+				frame.lighting[pixelIndex] = XMFLOAT4(shade, shade * 0.9f, shade * 0.7f, 1.0f);
+			}
+		}
+	}
+
+	frame.input.lighting = frame.lighting.data();
+	frame.input.depth = frame.depth.data();
+	frame.input.width = width;
+	frame.input.height = height;
+	frame.input.worldBoundary = WorldVolumeBoundary;
+}
+
+void BuildInjectionFrame(InjectionFrame& frame, uint32_t width, uint32_t height)
+{
+	BuildInjectionFrame(frame, width, height, DefaultEye, 0.0f);
+}
+
+std::shared_ptr<DownsampleState> CreateDownsampleState(uint32_t width, uint32_t height)
+{
+	auto state = std::make_shared<DownsampleState>();
+	BuildInjectionFrame(state->frame, width, height);
+	ResetGrids(state->grids);
+
+	state->injector.Inject(state->frame.input, state->grids, 1);
+	state->nextFrameWrites = state->injector.Inject(state->frame.input, state->grids, 1);
+	VoxelMipBuilder::BuildMips(state->grids, VoxelInjector::MipCount);
+
+	return state;
+}
+
+void ResetGrids(VoxelGrid* grids)
+{
+	for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+		grids[mip].Reset(VoxelResolution >> mip);
+}
+
+uint32_t CountMismatchedTexels(const VoxelGrid* grids, const VoxelGrid* referenceGrids, uint32_t mipCount)
+{
+	uint32_t mismatchedTexels = 0;
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		for (size_t i = 0; i < grids[mip].GetTexelCount(); ++i)
+			mismatchedTexels += grids[mip].GetTexels()[i] != referenceGrids[mip].GetTexels()[i] ? 1 : 0;
+	}
+
+	return mismatchedTexels;
+}
+
+uint32_t CountUnaccountedPixels(const VoxelInjectionStatistics& statistics, uint32_t mipCount)
+{
+	uint32_t errors = 0;
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		const uint64_t accounted = statistics.maskedPixels + statistics.backgroundPixels + statistics.outsideVolume[mip] + statistics.writtenEmpty[mip]
+			+ statistics.writtenNearer[mip] + statistics.rejectedFarther[mip] + statistics.rejectedDarker[mip];
+		errors += accounted != statistics.pixels ? 1 : 0;
+	}
+
+	return errors;
+}
+
+SHBakeSettings GetSHBakeSettings()
+{
+	SHBakeSettings settings;
+	settings.worldBoundary = WorldVolumeBoundary;
+	settings.coneStep = (32.0f * WorldVolumeBoundary) / ((VoxelResolution / 2) * std::tan(3.14159265f / 6.0f)) / 64.0f;
+	settings.gridResolution = 8;
+	return settings;
+}
+
+bool GetPathCamera(uint32_t frame, float* eye, float& yaw)
+{
+	const uint32_t turnFrames = 12;
+	const uint32_t stepFrames = 8;
+	const uint32_t turnStart = 6;
+	const uint32_t stepStart = turnStart + turnFrames;
+
+	const uint32_t turned = std::min(std::max(frame, turnStart) - turnStart, turnFrames);
+	const uint32_t stepped = std::min(std::max(frame, stepStart) - stepStart, stepFrames);
+
+	yaw = (float)turned * 3.14159265f / 360.0f;
+	eye[0] = DefaultEye[0] + (float)stepped * 0.25f;
+	eye[1] = DefaultEye[1];
+	eye[2] = DefaultEye[2];
+
+	return (frame > turnStart && frame <= stepStart) || (frame > stepStart && frame <= stepStart + stepFrames);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../Engine/Utilities/InjectionChangeDetector.h"
+#include "../Engine/Utilities/SHGridBaker.h"
+#include "../Engine/Utilities/VoxelInjector.h"
+#include "../Engine/Utilities/VoxelMipBuilder.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The synthetic room the voxel injection and GI benchmark cases render, shared by their files
+
+// VoxelInjectionRenderPass's volume
+const uint32_t VoxelResolution = 64;
+const float WorldVolumeBoundary = 50.0f;
+
+const float DefaultEye[3] = { 0.0f, 8.0f, -40.0f };
+
+// Frames of the walk GetPathCamera() describes
+const uint32_t PathFrameCount = 32;
+
+// A frame of a camera in an open topped room with a few spheres, stored the way the lighting and
+// depth passes leave it. Depth is encoded so the shader's reconstruction returns the hit point.
+struct InjectionFrame
+{
+	std::vector<DirectX::XMFLOAT4> lighting;
+	std::vector<float> depth;
+	VoxelInjectionInput input;
+	// The camera, as Renderer::ScheduleVoxelInjection gets it
+	InjectionView view;
+};
+
+// The default frame injected twice into the finest grid and downsampled into the others
+struct DownsampleState
+{
+	InjectionFrame frame;
+	VoxelInjector injector;
+	VoxelGrid grids[VoxelInjector::MipCount];
+	VoxelGrid directionalGrids[(VoxelInjector::MipCount - 1) * VoxelMipBuilder::DirectionCount];
+	VoxelGrid shGrids[3];
+	// What the second injection wrote
+	uint32_t nextFrameWrites = 0;
+};
+
+// The camera at an eye position, turned right by a yaw around the up axis
+void BuildInjectionFrame(InjectionFrame&, uint32_t, uint32_t, const float*, float);
+void BuildInjectionFrame(InjectionFrame&, uint32_t, uint32_t);
+
+std::shared_ptr<DownsampleState> CreateDownsampleState(uint32_t, uint32_t);
+
+// Empties the voxel mips of the volume
+void ResetGrids(VoxelGrid*);
+uint32_t CountMismatchedTexels(const VoxelGrid*, const VoxelGrid*, uint32_t mipCount = VoxelInjector::MipCount);
+
+// Every pixel of a dispatch is masked, background or tested in every mip injected into
+uint32_t CountUnaccountedPixels(const VoxelInjectionStatistics&, uint32_t);
+
+// SHIndirectRenderPass's grid with the cone step DemoApp sets for it
+SHBakeSettings GetSHBakeSettings();
+
+// A walk through the room: standing, turning right half a degree a frame, stepping sideways and
+// standing again. Returns whether the camera moved since the frame before.
+bool GetPathCamera(uint32_t, float*, float&);
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "Benchmark.h"
+#include "../Engine/Utilities/VoxelClipmap.h"
+
+#include <cmath>
+#include <memory>
+
+using namespace DirectX;
+
+namespace
+{
+	// VoxelInjectionRenderPass's fixed volume, with its four coarser mips
+	const uint32_t FixedResolution = 64;
+	const float FixedWorldBoundary = 50.0f;
+	const uint32_t FixedMipCount = 5;
+
+	const uint32_t PathLength = 120;
+
+	// A walk through the scene at a few units per second and 60 frames per second, with a teleport
+	// near the end
+	XMFLOAT3 GetCameraPosition(uint32_t frame)
+	{
+		const float time = (float)frame / 60.0f;
+		XMFLOAT3 position(-30.0f + 4.0f * time, 2.0f + std::sin(time), 20.0f * std::sin(0.3f * time));
+
+		if (frame >= 100)
+			position.x += 250.0f;
+
+		return position;
+	}
+
+	struct ClipmapState
+	{
+		VoxelClipmap clipmap;
+		std::vector<XMFLOAT3> path;
+		std::vector<ClipmapRegion> regions;
+	};
+
+	// Follows the path with a copy of every level that remembers which voxel each texel holds. After
+	// every update, each texel has to hold the voxel of the new volume that maps to it, and the regions
+	// must cover exactly the texels whose voxel changed.
+	uint32_t ValidatePath(uint32_t levelCount, uint32_t resolution, float finestVoxelSize, const std::vector<XMFLOAT3>& path, uint64_t& dirtyVoxels)
+	{
+		VoxelClipmap clipmap;
+		clipmap.Reset(levelCount, resolution, finestVoxelSize);
+
+		const size_t texelCount = (size_t)resolution * resolution * resolution;
+		std::vector<int32_t> texelVoxels(levelCount * texelCount * 3, INT32_MIN);
+		std::vector<uint32_t> writtenFrames(levelCount * texelCount, UINT32_MAX);
+		std::vector<ClipmapRegion> regions;
+
+		uint32_t errors = 0;
+		dirtyVoxels = 0;
+
+		for (uint32_t frame = 0; frame < (uint32_t)path.size(); ++frame)
+		{
+			regions.clear();
+			const uint32_t dirtyVoxelCount = clipmap.Update(path[frame], regions);
+			uint32_t writtenTexels = 0;
+
+			// The voxel a texel of a level holds now
+			auto getVoxel = [&](uint32_t level, uint32_t axis, uint32_t texel)
+			{
+				const int32_t origin = clipmap.GetOrigin(level)[axis];
+				return origin + (int32_t)((texel + resolution - clipmap.GetTexelCoordinate(origin)) % resolution);
+			};
+
+			for (const ClipmapRegion& region : regions)
+			{
+				for (uint32_t z = region.begin[2]; z < region.begin[2] + region.size[2]; ++z)
+				{
+					for (uint32_t y = region.begin[1]; y < region.begin[1] + region.size[1]; ++y)
+					{
+						for (uint32_t x = region.begin[0]; x < region.begin[0] + region.size[0]; ++x)
+						{
+							const size_t texel = region.level * texelCount + ((size_t)z * resolution + y) * resolution + x;
+							const int32_t voxel[3] = { getVoxel(region.level, 0, x), getVoxel(region.level, 1, y), getVoxel(region.level, 2, z) };
+
+							// Written twice, or initialized again though it kept its voxel
+							errors += writtenFrames[texel] == frame ? 1 : 0;
+							errors += texelVoxels[texel * 3] == voxel[0] && texelVoxels[texel * 3 + 1] == voxel[1] && texelVoxels[texel * 3 + 2] == voxel[2] ? 1 : 0;
+
+							writtenFrames[texel] = frame;
+							texelVoxels[texel * 3] = voxel[0];
+							texelVoxels[texel * 3 + 1] = voxel[1];
+							texelVoxels[texel * 3 + 2] = voxel[2];
+							++writtenTexels;
+						}
+					}
+				}
+			}
+
+			errors += writtenTexels != dirtyVoxelCount ? 1 : 0;
+			dirtyVoxels += frame > 0 ? dirtyVoxelCount : 0;
+
+			// A texel left out stays wrong, so looking at every texel now and then finds it
+			for (uint32_t level = 0; level < levelCount && frame % 10 == 0; ++level)
+			{
+				for (uint32_t z = 0; z < resolution; ++z)
+				{
+					for (uint32_t y = 0; y < resolution; ++y)
+					{
+						for (uint32_t x = 0; x < resolution; ++x)
+						{
+							const size_t texel = level * texelCount + ((size_t)z * resolution + y) * resolution + x;
+
+							errors += texelVoxels[texel * 3] != getVoxel(level, 0, x) || texelVoxels[texel * 3 + 1] != getVoxel(level, 1, y)
+								|| texelVoxels[texel * 3 + 2] != getVoxel(level, 2, z) ? 1 : 0;
+						}
+					}
+				}
+			}
+
+			// The camera is always in the finest level
+			errors += clipmap.FindLevel(path[frame]) != 0 ? 1 : 0;
+		}
+
+		return errors;
+	}
+
+	void RegisterClipmap(uint32_t levelCount, uint32_t resolution, float finestVoxelSize)
+	{
+		auto state = std::make_shared<ClipmapState>();
+		state->clipmap.Reset(levelCount, resolution, finestVoxelSize);
+
+		for (uint32_t frame = 0; frame < PathLength; ++frame)
+			state->path.push_back(GetCameraPosition(frame));
+
+		std::string name = "VoxelClipmap::Update/" + std::to_string(resolution) + "x" + std::to_string(levelCount) + "/" + std::to_string(finestVoxelSize).substr(0, 4);
+
+		Benchmark::Check("VoxelClipmap initialization for " + name, { name }, [levelCount, resolution, finestVoxelSize, state, name]()
+		{
+			uint64_t dirtyVoxels = 0;
+			const uint32_t errors = ValidatePath(levelCount, resolution, finestVoxelSize, state->path, dirtyVoxels);
+
+			Benchmark::SetMetric(name, "dirty_voxels_per_frame", (double)dirtyVoxels / (PathLength - 1));
+			Benchmark::SetMetric(name, "errors", errors);
+
+			return errors;
+		});
+
+		Benchmark::Register(name, [state]()
+		{
+			uint32_t dirtyVoxelCount = 0;
+
+			for (const XMFLOAT3& position : state->path)
+			{
+				state->regions.clear();
+				dirtyVoxelCount += state->clipmap.Update(position, state->regions);
+			}
+
+			Benchmark::DoNotOptimize(dirtyVoxelCount);
+		}, PathLength);
+
+		// A single volume covering the same extent at the finest voxel size, without mips
+		const float coverage = 2.0f * state->clipmap.GetHalfExtent(levelCount - 1);
+		const double sameDetailResolution = std::ceil(coverage / finestVoxelSize);
+
+		size_t fixedBytes = 0;
+
+		for (uint32_t mip = 0; mip < FixedMipCount; ++mip)
+			fixedBytes += (size_t)(FixedResolution >> mip) * (FixedResolution >> mip) * (FixedResolution >> mip) * sizeof(uint32_t);
+
+		Benchmark::SetMetric(name, "levels", levelCount);
+		Benchmark::SetMetric(name, "resolution", resolution);
+		Benchmark::SetMetric(name, "finest_voxel_size", finestVoxelSize);
+		Benchmark::SetMetric(name, "coverage_extent", coverage);
+		Benchmark::SetMetric(name, "clipmap_bytes", (double)state->clipmap.GetMemoryBytes());
+		Benchmark::SetMetric(name, "same_detail_volume_bytes", sameDetailResolution * sameDetailResolution * sameDetailResolution * sizeof(uint32_t));
+		Benchmark::SetMetric(name, "fixed_volume_bytes", (double)fixedBytes);
+		Benchmark::SetMetric(name, "fixed_volume_extent", 2.0f * FixedWorldBoundary);
+		Benchmark::SetMetric(name, "fixed_volume_voxel_size", 2.0f * FixedWorldBoundary / FixedResolution);
+		Benchmark::SetMetric(name, "voxels_per_frame_without_scrolling", (double)state->clipmap.GetMemoryBytes() / sizeof(uint32_t));
+	}
+}
+
+void RegisterVoxelClipmapBenchmarks()
+{
+	// The fixed volume's voxel size near the camera and eight times its extent, then twice the detail
+	RegisterClipmap(4, 64, 1.5625f);
+	RegisterClipmap(4, 64, 0.78125f);
+	RegisterClipmap(5, 32, 0.78125f);
+}
\ No newline at end of file
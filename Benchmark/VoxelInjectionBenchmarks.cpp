@@ -0,0 +1,158 @@
+#include "Benchmark.h"
+#include "VoxelBenchmarkScene.h"
+#include "../Engine/Utilities/ThreadPool.h"
+#include "../Engine/Utilities/VoxelInjector.h"
+#include "../Engine/Utilities/VoxelMipBuilder.h"
+
+#include <memory>
+#include <string>
+
+namespace
+{
+	// Coarse voxels cone tracing stops at
+	uint32_t CountCoarseOccupiedVoxels(const VoxelGrid* grids)
+	{
+		uint32_t occupiedVoxels = 0;
+
+		for (uint32_t mip = 1; mip < VoxelInjector::MipCount; ++mip)
+		{
+			for (size_t i = 0; i < grids[mip].GetTexelCount(); ++i)
+				occupiedVoxels += VoxelGrid::Unpack(grids[mip].GetTexels()[i], 3) > 0.05f ? 1 : 0;
+		}
+
+		return occupiedVoxels;
+	}
+
+	struct InjectionState
+	{
+		InjectionFrame frame;
+		VoxelInjector injector;
+		VoxelGrid grids[VoxelInjector::MipCount];
+	};
+
+	// Injecting into the finest mip and downsampling the others, against injecting into all of them
+	void RegisterDownsample(uint32_t width, uint32_t height, const InjectionState& fiveWayState, uint32_t fiveWayWrites)
+	{
+		std::shared_ptr<DownsampleState> state = CreateDownsampleState(width, height);
+
+		std::string size = std::to_string(width) + "x" + std::to_string(height);
+		const uint64_t pixelCount = (uint64_t)(width / 16 * 16) * (height / 16 * 16);
+
+		std::string downsampleName = "VoxelInjection::InjectAndDownsample/" + size;
+
+		Benchmark::Register(downsampleName, [state]()
+		{
+			uint32_t writes = state->injector.Inject(state->frame.input, state->grids, 1);
+			VoxelMipBuilder::BuildMips(state->grids, VoxelInjector::MipCount);
+			Benchmark::DoNotOptimize(writes);
+		}, pixelCount);
+
+		Benchmark::SetMetric(downsampleName, "megapixels", pixelCount / 1.0e6);
+		Benchmark::SetMetric(downsampleName, "threads", ThreadPool::GetThreadCount());
+		Benchmark::SetMetric(downsampleName, "next_frame_writes", state->nextFrameWrites);
+		Benchmark::SetMetric(downsampleName, "five_way_next_frame_writes", fiveWayWrites);
+		Benchmark::SetMetric(downsampleName, "coarse_occupied_voxels", CountCoarseOccupiedVoxels(state->grids));
+		Benchmark::SetMetric(downsampleName, "five_way_coarse_occupied_voxels", CountCoarseOccupiedVoxels(fiveWayState.grids));
+
+		Benchmark::Register("VoxelInjection::InjectFinest/" + size, [state]()
+		{
+			Benchmark::DoNotOptimize(state->injector.Inject(state->frame.input, state->grids, 1));
+		}, pixelCount);
+
+		// The downsampling alone doesn't depend on the frame size
+		if (width != 1280)
+			return;
+
+		const uint64_t coarseTexelCount = state->grids[1].GetTexelCount() + state->grids[2].GetTexelCount()
+			+ state->grids[3].GetTexelCount() + state->grids[4].GetTexelCount();
+
+		Benchmark::Register("VoxelMipBuilder::BuildMips/" + std::to_string(VoxelResolution), [state]()
+		{
+			VoxelMipBuilder::BuildMips(state->grids, VoxelInjector::MipCount);
+			Benchmark::DoNotOptimize(state->grids[1].GetTexels()[0]);
+		}, coarseTexelCount);
+
+		Benchmark::Register("VoxelMipBuilder::BuildAnisotropicMips/" + std::to_string(VoxelResolution), [state]()
+		{
+			VoxelMipBuilder::BuildAnisotropicMips(state->grids[0], state->directionalGrids, VoxelInjector::MipCount);
+			Benchmark::DoNotOptimize(state->directionalGrids[0].GetTexels()[0]);
+		}, coarseTexelCount);
+
+	}
+}
+
+void RegisterVoxelInjectionBenchmarks()
+{
+	const uint32_t resolutions[][2] = { { 1280, 720 }, { 1920, 1080 } };
+
+	for (const auto& resolution : resolutions)
+	{
+		auto state = std::make_shared<InjectionState>();
+		BuildInjectionFrame(state->frame, resolution[0], resolution[1]);
+
+		ResetGrids(state->grids);
+
+		uint32_t firstWrites = state->injector.Inject(state->frame.input, state->grids, VoxelInjector::MipCount);
+		uint32_t nextWrites = state->injector.Inject(state->frame.input, state->grids, VoxelInjector::MipCount);
+
+		uint32_t occupiedTexels = 0;
+
+		for (size_t i = 0; i < state->grids[0].GetTexelCount(); ++i)
+			occupiedTexels += (state->grids[0].GetTexels()[i] >> 24) != 0 ? 1 : 0;
+
+		std::string size = std::to_string(resolution[0]) + "x" + std::to_string(resolution[1]);
+
+		const uint64_t pixelCount = (uint64_t)(resolution[0] / 16 * 16) * (resolution[1] / 16 * 16);
+
+		// Steady state of progressive voxelization into every mip, the grids are never cleared
+		std::string injectName = "VoxelInjection::Inject/" + size;
+
+		// Both the first frame into empty grids and the next one into filled grids must match the serial order
+		Benchmark::Check("VoxelInjector against the serial injection at " + size, { injectName }, [state, injectName]()
+		{
+			VoxelGrid grids[VoxelInjector::MipCount];
+			VoxelGrid referenceGrids[VoxelInjector::MipCount];
+			ResetGrids(grids);
+			ResetGrids(referenceGrids);
+
+			uint32_t mismatchedWrites = 0;
+			uint32_t mismatchedTexels = 0;
+
+			for (int frame = 0; frame < 2; ++frame)
+			{
+				uint32_t writes = state->injector.Inject(state->frame.input, grids, VoxelInjector::MipCount);
+				uint32_t referenceWrites = VoxelInjector::InjectSerial(state->frame.input, referenceGrids, VoxelInjector::MipCount);
+
+				mismatchedWrites += writes != referenceWrites ? 1 : 0;
+				mismatchedTexels += CountMismatchedTexels(grids, referenceGrids);
+			}
+
+			Benchmark::SetMetric(injectName, "mismatched_texels", mismatchedTexels);
+
+			return mismatchedTexels + mismatchedWrites;
+		});
+
+		Benchmark::Register(injectName, [state]()
+		{
+			Benchmark::DoNotOptimize(state->injector.Inject(state->frame.input, state->grids, VoxelInjector::MipCount));
+		}, pixelCount);
+
+		Benchmark::SetMetric(injectName, "megapixels", pixelCount / 1.0e6);
+		Benchmark::SetMetric(injectName, "threads", ThreadPool::GetThreadCount());
+		Benchmark::SetMetric(injectName, "first_frame_writes", firstWrites);
+		Benchmark::SetMetric(injectName, "next_frame_writes", nextWrites);
+		Benchmark::SetMetric(injectName, "occupied_voxels", occupiedTexels);
+
+		std::string serialName = "VoxelInjection::Serial/" + size;
+
+		Benchmark::Register(serialName, [state]()
+		{
+			Benchmark::DoNotOptimize(VoxelInjector::InjectSerial(state->frame.input, state->grids, VoxelInjector::MipCount));
+		}, pixelCount);
+
+		Benchmark::SetMetric(serialName, "megapixels", pixelCount / 1.0e6);
+
+		RegisterDownsample(resolution[0], resolution[1], *state, nextWrites);
+	}
+
+}
\ No newline at end of file
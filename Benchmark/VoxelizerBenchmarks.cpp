@@ -0,0 +1,243 @@
+#include "Benchmark.h"
+#include "../Engine/SceneManagement/MeshLoader.h"
+#include "../Engine/SceneManagement/SceneLoader.h"
+#include "../Engine/Utilities/OccupancyPyramid.h"
+#include "../Engine/Utilities/SHGridBaker.h"
+#include "../Engine/Utilities/ThreadPool.h"
+#include "../Engine/Utilities/Voxelizer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+
+using namespace DirectX;
+
+namespace
+{
+	struct VoxelizerState
+	{
+		Voxelizer voxelizer;
+		VoxelGrid grids[Voxelizer::MipCount];
+		OccupancyPyramid pyramid;
+		VoxelGrid shGrids[3];
+	};
+
+	// Adds every object of the scene, the way SceneManager does once its meshes are loaded. The scene
+	// textures are not in the repository, so the albedo is a grey per mesh.
+	bool AddScene(Voxelizer& voxelizer, const SceneDescription& sceneDescription)
+	{
+		std::map<std::string, MeshLoader::MeshData> meshes;
+
+		for (const SceneObject& sceneObject : sceneDescription.objects)
+		{
+			if (meshes.count(sceneObject.meshName) == 0)
+				meshes[sceneObject.meshName] = MeshLoader::LoadModel(sceneObject.meshName);
+
+			const MeshLoader::MeshData& meshData = meshes[sceneObject.meshName];
+
+			if (meshData.Vertices.empty())
+				return false;
+
+			std::vector<XMFLOAT3> positions(meshData.Vertices.size());
+
+			for (size_t i = 0; i < positions.size(); ++i)
+				positions[i] = meshData.Vertices[i].Position;
+
+			XMFLOAT4X4 world;
+			XMStoreFloat4x4(&world, XMMatrixScaling(sceneObject.scale.x, sceneObject.scale.y, sceneObject.scale.z)
+				* XMMatrixRotationQuaternion(XMLoadFloat4(&sceneObject.rotation))
+				* XMMatrixTranslation(sceneObject.position.x, sceneObject.position.y, sceneObject.position.z));
+
+			float grey = 0.2f + 0.1f * (float)(meshes.size() % 6);
+			voxelizer.AddMesh(positions, meshData.Indices32, world, XMFLOAT3(grey, grey, grey));
+		}
+
+		return true;
+	}
+
+	// Voxels occupied in one grid but not the other
+	uint32_t CountOccupancyMismatches(const VoxelGrid& grid, const VoxelGrid& referenceGrid)
+	{
+		uint32_t occupancyMismatches = 0;
+
+		for (size_t i = 0; i < grid.GetTexelCount(); ++i)
+			occupancyMismatches += ((grid.GetTexels()[i] >> 24) != 0) != ((referenceGrid.GetTexels()[i] >> 24) != 0) ? 1 : 0;
+
+		return occupancyMismatches;
+	}
+
+	// Texels that differ in any channel, also counting a triangle that only touches a voxel's face on
+	// one side of a rounding error
+	uint32_t CountMismatchedTexels(const VoxelGrid* grids, const VoxelGrid* referenceGrids)
+	{
+		uint32_t mismatchedTexels = 0;
+
+		for (uint32_t mip = 0; mip < Voxelizer::MipCount; ++mip)
+		{
+			for (size_t i = 0; i < grids[mip].GetTexelCount(); ++i)
+				mismatchedTexels += grids[mip].GetTexels()[i] != referenceGrids[mip].GetTexels()[i] ? 1 : 0;
+		}
+
+		return mismatchedTexels;
+	}
+
+	// Cone tracing the voxelized scene from every SH cell, sampling every step against skipping the
+	// steps the occupancy pyramid shows to be empty
+	void RegisterConeTracing(const std::string& name, const std::shared_ptr<VoxelizerState>& state, float worldBoundary)
+	{
+		SHBakeSettings settings;
+		settings.worldBoundary = worldBoundary;
+		settings.coneStep = (32.0f * worldBoundary) / ((state->voxelizer.GetResolution() / 2) * std::tan(3.14159265f / 6.0f)) / 64.0f;
+		settings.gridResolution = 8;
+
+		const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		state->pyramid.Build(state->grids, Voxelizer::MipCount);
+		const double buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		const float (*directions)[3] = SHGridBaker::GetConeDirections();
+		const uint32_t cellCount = settings.gridResolution * settings.gridResolution * settings.gridResolution;
+		const uint32_t coneCount = cellCount * SHGridBaker::ConeCount;
+
+		const std::string bakeName = "SHGridBaker::Bake/" + name;
+		const std::string skippingName = "SHGridBaker::BakeSkipping/" + name;
+
+		Benchmark::Check("Skipping empty space of " + name, { bakeName, skippingName }, [state, settings, directions, cellCount, coneCount, bakeName, skippingName]()
+		{
+			uint64_t samples = 0;
+			uint64_t skippingSamples = 0;
+			uint32_t mismatchedCones = 0;
+			uint32_t hitCones = 0;
+
+			for (uint32_t cell = 0; cell < cellCount; ++cell)
+			{
+				float cellPosition[3];
+				SHGridBaker::GetCellPosition(settings, cell, cellPosition);
+
+				for (uint32_t cone = 0; cone < SHGridBaker::ConeCount; ++cone)
+				{
+					float color[3];
+					float skippingColor[3];
+					samples += SHGridBaker::TraceCone(settings, state->grids, cellPosition, directions[cone], color);
+					skippingSamples += SHGridBaker::TraceCone(settings, state->grids, state->pyramid, cellPosition, directions[cone], skippingColor);
+
+					mismatchedCones += std::memcmp(color, skippingColor, sizeof(color)) != 0 ? 1 : 0;
+					hitCones += color[0] != 0.0f || color[1] != 0.0f || color[2] != 0.0f ? 1 : 0;
+				}
+			}
+
+			// The whole bake has to come out texel for texel the same
+			VoxelGrid referenceSHGrids[3];
+			SHGridBaker::Bake(settings, state->grids, referenceSHGrids);
+			SHGridBaker::Bake(settings, state->grids, state->pyramid, state->shGrids);
+
+			for (uint32_t i = 0; i < 3; ++i)
+				mismatchedCones += std::memcmp(referenceSHGrids[i].GetTexels(), state->shGrids[i].GetTexels(), cellCount * sizeof(uint32_t)) != 0 ? 1 : 0;
+
+			Benchmark::SetMetric(bakeName, "samples_per_cone", (double)samples / coneCount);
+			Benchmark::SetMetric(skippingName, "samples_per_cone", (double)skippingSamples / coneCount);
+			Benchmark::SetMetric(skippingName, "hit_cones", hitCones);
+			Benchmark::SetMetric(skippingName, "mismatched_cones", mismatchedCones);
+
+			return mismatchedCones;
+		});
+
+		Benchmark::Register(bakeName, [state, settings]()
+		{
+			Benchmark::DoNotOptimize(SHGridBaker::Bake(settings, state->grids, state->shGrids));
+		}, cellCount);
+
+		Benchmark::Register("SHGridBaker::BakeSerial/" + name, [state, settings]()
+		{
+			Benchmark::DoNotOptimize(SHGridBaker::BakeSerial(settings, state->grids, state->shGrids));
+		}, cellCount);
+
+		Benchmark::Register(skippingName, [state, settings]()
+		{
+			Benchmark::DoNotOptimize(SHGridBaker::Bake(settings, state->grids, state->pyramid, state->shGrids));
+		}, cellCount);
+
+		Benchmark::SetMetric(bakeName, "avx2", SHGridBaker::IsAvx2Supported() ? 1.0 : 0.0);
+		Benchmark::SetMetric(skippingName, "cones", coneCount);
+		Benchmark::SetMetric(skippingName, "pyramid_bytes", (double)state->pyramid.GetMemorySize());
+		Benchmark::SetMetric(skippingName, "pyramid_build_ms", buildMilliseconds);
+
+		Benchmark::Register("OccupancyPyramid::Build/" + name, [state]()
+		{
+			Benchmark::DoNotOptimize(state->pyramid.Build(state->grids, Voxelizer::MipCount));
+		}, 1);
+	}
+
+	void RegisterVoxelize(const std::string& name, const SceneDescription& sceneDescription, uint32_t resolution, float worldBoundary)
+	{
+		auto state = std::make_shared<VoxelizerState>();
+		state->voxelizer.Reset(resolution, worldBoundary);
+
+		if (!AddScene(state->voxelizer, sceneDescription))
+		{
+			std::cerr << "Skipping Voxelizer/" << name << ", mesh file not found" << std::endl;
+			return;
+		}
+
+		// The cone tracing cases trace these grids
+		uint32_t occupiedVoxels = state->voxelizer.Voxelize(state->grids);
+
+		std::string voxelizeName = "Voxelizer::Voxelize/" + name;
+
+		// Conservative means the same voxels as testing every voxel against every triangle
+		Benchmark::Check("Voxelizer occupancy of " + name, { voxelizeName }, [state, occupiedVoxels, voxelizeName]()
+		{
+			VoxelGrid referenceGrids[Voxelizer::MipCount];
+			uint32_t referenceOccupiedVoxels = state->voxelizer.VoxelizeReference(referenceGrids);
+			uint32_t occupancyMismatches = CountOccupancyMismatches(state->grids[0], referenceGrids[0]);
+			uint32_t mismatchedTexels = CountMismatchedTexels(state->grids, referenceGrids);
+
+			Benchmark::SetMetric(voxelizeName, "occupancy_mismatches", occupancyMismatches);
+			Benchmark::SetMetric(voxelizeName, "mismatched_texels", mismatchedTexels);
+
+			return occupancyMismatches + (occupiedVoxels != referenceOccupiedVoxels ? 1 : 0);
+		});
+
+		uint32_t coarseOccupiedVoxels = 0;
+		const VoxelGrid& coarseGrid = state->grids[Voxelizer::MipCount - 1];
+
+		for (size_t i = 0; i < coarseGrid.GetTexelCount(); ++i)
+			coarseOccupiedVoxels += (coarseGrid.GetTexels()[i] >> 24) != 0 ? 1 : 0;
+
+		Benchmark::Register(voxelizeName, [state]()
+		{
+			Benchmark::DoNotOptimize(state->voxelizer.Voxelize(state->grids));
+		}, state->voxelizer.GetTriangleCount());
+
+		Benchmark::SetMetric(voxelizeName, "triangles", state->voxelizer.GetTriangleCount());
+		Benchmark::SetMetric(voxelizeName, "threads", ThreadPool::GetThreadCount());
+		Benchmark::SetMetric(voxelizeName, "occupied_voxels", occupiedVoxels);
+		Benchmark::SetMetric(voxelizeName, "coarsest_occupied_voxels", coarseOccupiedVoxels);
+
+		Benchmark::Register("Voxelizer::VoxelizeReference/" + name, [state]()
+		{
+			VoxelGrid grids[Voxelizer::MipCount];
+			Benchmark::DoNotOptimize(state->voxelizer.VoxelizeReference(grids));
+		}, state->voxelizer.GetTriangleCount());
+
+		RegisterConeTracing(name, state, worldBoundary);
+	}
+}
+
+void RegisterVoxelizerBenchmarks()
+{
+	SceneDescription sceneDescription;
+
+	if (!SceneLoader::LoadSceneDescription("../Assets/Scenes/DemoScene4.txt", sceneDescription))
+	{
+		std::cerr << "Skipping Voxelizer, scene file not found" << std::endl;
+		return;
+	}
+
+	// The volume VoxelInjectionRenderPass covers, and one fitted to the scene where triangles span many voxels
+	RegisterVoxelize("DemoScene4/64", sceneDescription, 64, 50.0f);
+	RegisterVoxelize("DemoScene4/64/Fitted", sceneDescription, 64, 12.0f);
+	RegisterVoxelize("DemoScene4/128/Fitted", sceneDescription, 128, 12.0f);
+}
\ No newline at end of file
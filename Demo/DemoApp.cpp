@@ -1,5 +1,7 @@
 #include "../Engine/Utilities/Camera.h"
 
+#include <chrono>
+
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
 
@@ -32,6 +34,13 @@ private:
 	void UpdateMainPassCB(const GameTimer& gt);
 
 	void BuildFrameResources();
+
+	// Copies the voxel and SH grids into readback buffers and waits for the copies
+	void ReadBackGIGrids();
+	// Reads the voxel and SH grids back and writes them to the scene's GI cache
+	void SaveGICache();
+	// Reads the voxel and SH grids back and measures them into the GI statistics
+	void CaptureGIStatistics();
     
 private:
 
@@ -46,6 +55,22 @@ private:
 	Camera mCamera;
 	XMFLOAT4X4 mView = MathHelper::Identity4x4();
 	XMFLOAT4X4 mProj = MathHelper::Identity4x4();
+	float mFovY = 0.33f * MathHelper::Pi;
+
+	// Start to first frame time, reported once the first frame is presented
+	std::chrono::steady_clock::time_point mStartTime;
+	bool bFirstFramePresented = false;
+
+	// Some object or material constants were updated this frame
+	bool bSceneChanged = false;
+
+	// Next to the scene file, written at shutdown when the scene had no usable cache
+	std::string mGICachePath;
+	GICacheStatus mGICacheStatus = GICacheStatus::Missing;
+	double mGICacheRestoreMilliseconds = 0.0;
+
+	// Every frame is read back and measured while set, which stalls on the GPU
+	bool bCapturingGIStatistics = false;
 };
 
 /// <summary>
@@ -59,6 +84,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+	Profiler::SetThreadName("Main");
+
+	// Record from the very first frame (including scene loading) when launched with -profile, in builds
+	// that define PVGI_PROFILING
+	if (cmdLine != nullptr && strstr(cmdLine, "-profile") != nullptr)
+		Profiler::SetEnabled(true);
+
     try
     {
         DemoApp theApp(hInstance);
@@ -84,7 +116,32 @@ DemoApp::~DemoApp()
 	if (md3dDevice != nullptr)
 	{
 		FlushCommandQueue();
+
+		// A failed save only costs the next launch its warm start. Grids still converging would warm
+		// start it with lighting that is partly stale, G saves them anyway.
+		if (mGICacheStatus != GICacheStatus::Loaded && !mGICachePath.empty())
+		{
+			if (!Renderer::IsGIConverged())
+			{
+				::OutputDebugStringA(("Did not save the GI cache to " + mGICachePath + ", the indirect lighting has not converged\n").c_str());
+			}
+			else
+			{
+				try
+				{
+					SaveGICache();
+				}
+				catch (DxException& e)
+				{
+					::OutputDebugStringW((L"Could not save the GI cache: " + e.ToString() + L"\n").c_str());
+				}
+			}
+		}
+
+		UploadService::Shutdown();
 		SceneManager::ReleaseMemory();
+		TextureUploader::Shutdown();
+		GlobalDescriptorHeap::Shutdown();
 	}
         
 }
@@ -94,6 +151,8 @@ DemoApp::~DemoApp()
 /// </summary>
 bool DemoApp::Initialize()
 {
+	mStartTime = std::chrono::steady_clock::now();
+
     if(!D3DApp::Initialize())
         return false;
 
@@ -104,10 +163,34 @@ bool DemoApp::Initialize()
 	// so we have to query this information.
     mCbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+	// Initialize the GPU timestamp queries used by the profiler
+	GpuProfiler::Initialize(md3dDevice, mCommandQueue);
+
+	// Only the mip tails of the material textures are loaded with the scene, the rest is streamed in
+	TextureStreamer::Initialize(TextureStreamerSettings());
+	// Room for the scene's mip tails and several frames of streaming
+	TextureUploader::Initialize(md3dDevice, 64ull * 1024 * 1024);
+	// Geometry and whole textures go through the copy queue
+	UploadService::Initialize(md3dDevice, 64ull * 1024 * 1024);
+
 	// Load the scene file
 	SceneManager::LoadScene("../Assets/Scenes/DemoScene4.txt", md3dDevice, mCommandList);
+	// Every pass allocates its descriptor tables from the one shader visible heap
+	GlobalDescriptorHeap::Initialize(md3dDevice, 1024, 1024);
 	// Initialize the renderer
 	Renderer::Initialize(md3dDevice, mClientWidth, mClientHeight, mBackBufferFormat, mDepthStencilFormat);
+	// Restore the converged grids of an earlier run, or fill the voxel grids with the scene's static
+	// geometry before the camera sees any of it
+	mGICachePath = GICache::GetFilePath("../Assets/Scenes", SceneManager::GetScenePtr()->name);
+
+	std::chrono::steady_clock::time_point restoreStartTime = std::chrono::steady_clock::now();
+	mGICacheStatus = Renderer::RestoreGICache(md3dDevice.Get(), mCommandList.Get(), mGICachePath);
+	mGICacheRestoreMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - restoreStartTime).count();
+
+	if (mGICacheStatus != GICacheStatus::Loaded)
+		Renderer::voxelInjectionRenderPass.SeedVoxelGrids(mCommandList.Get());
+	// Injection takes the atomic max into the finest grid packed
+	Renderer::voxelInjectionRenderPass.PackVoxelGrid(mCommandList.Get());
 	// Build the frame resources
 	BuildFrameResources();
 	
@@ -117,6 +200,9 @@ bool DemoApp::Initialize()
 		SceneManager::GetScenePtr()->cameraPosition.z,
 		1.0f));
 
+	// Send the scene's uploads to the copy queue, the direct queue waits for them on the GPU
+	UploadService::WaitOnQueue(mCommandQueue.Get(), SceneManager::GetScenePtr()->mUploadTicket);
+
     // Execute the initialization commands.
     ThrowIfFailed(mCommandList->Close());
     ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
@@ -125,6 +211,11 @@ bool DemoApp::Initialize()
     // Wait until initialization is complete.
     FlushCommandQueue();
 
+	// The copies recorded above have executed, the staging memory is no longer needed
+	SceneManager::DisposeUploaders();
+	Renderer::voxelInjectionRenderPass.ReleaseSeedUploaders();
+	Renderer::ReleaseGICacheUploaders();
+
     return true;
 }
  
@@ -136,7 +227,7 @@ void DemoApp::OnResize()
     D3DApp::OnResize();
 
     // The window resized, so update the aspect ratio and recompute the projection matrix.
-    XMMATRIX P = XMMatrixPerspectiveFovLH(0.33f*MathHelper::Pi, AspectRatio(), 1.0f, 500.0f);
+    XMMATRIX P = XMMatrixPerspectiveFovLH(mFovY, AspectRatio(), 1.0f, 500.0f);
     XMStoreFloat4x4(&mProj, P);
 }
 
@@ -145,10 +236,12 @@ void DemoApp::OnResize()
 /// </summary>
 void DemoApp::Update(const GameTimer& gt)
 {
+	PROFILE_SCOPE("DemoApp::Update");
+
     UpdateCamera(gt);
 
     // Cycle through the circular frame resource array.
-    mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % 3;
+    mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % gNumFrameResources;
     mCurrFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
 
     // Has the GPU finished processing the commands of the current frame resource?
@@ -161,7 +254,14 @@ void DemoApp::Update(const GameTimer& gt)
         CloseHandle(eventHandle);
     }
 
+	// The GPU is done with this frame resource so its timestamps can be read back
+	GpuProfiler::BeginFrame(mCurrFrameResourceIndex);
+
+	// Its transient descriptor tables can be rewritten as well
+	GlobalDescriptorHeap::BeginFrame(mCurrFrameResourceIndex, mFence->GetCompletedValue());
+
 	// Update the 3 constant buffers
+	bSceneChanged = false;
 	UpdateObjectCBs(gt);
 	UpdateMaterialCBs(gt);
 	UpdateMainPassCB(gt);
@@ -172,6 +272,8 @@ void DemoApp::Update(const GameTimer& gt)
 /// </summary>
 void DemoApp::Draw(const GameTimer& gt)
 {
+	PROFILE_SCOPE("DemoApp::Draw");
+
     auto cmdListAlloc = mCurrFrameResource->CmdListAlloc;
 	
     // Reuse the memory associated with command recording.
@@ -182,11 +284,27 @@ void DemoApp::Draw(const GameTimer& gt)
     // Reusing the command list reuses memory.
     ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), Renderer::directLightingRenderPass.mPSO.Get()));
 
+	// Every pass uses the global descriptor heap, so it is only set once
+	GlobalDescriptorHeap::SetHeap(mCommandList.Get());
+
+	// Staging ring space of the frames the GPU finished is free again
+	TextureUploader::Release(mFence->GetCompletedValue());
+
+	// Stream the texture mips needed from this view, the copies run before any pass samples them
+	TextureStreamer::Update(mCommandList.Get(), XMFLOAT3(mCamera.GetPositionPtr()->x, mCamera.GetPositionPtr()->y, mCamera.GetPositionPtr()->z),
+		XMFLOAT3(mCamera.GetForwardDirectionPtr()->x, mCamera.GetForwardDirectionPtr()->y, mCamera.GetForwardDirectionPtr()->z),
+		mFovY, (float)mClientHeight, mFence->GetCompletedValue(), mCurrentFence + 1);
+
+	TextureUploader::Retire(mCurrentFence + 1);
+
+	// Uploads requested since the last frame go out on the copy queue
+	UploadService::Submit();
+
 	// Render shadows only once
 	if (Renderer::bPerformShadowMapping)
 	{
 		// Draw shadows
-		Renderer::shadowMapRenderPass.Execute(mCommandList.Get(), &DepthStencilView(), mCurrFrameResource);
+		Renderer::ExecutePass(Renderer::shadowMapRenderPass, "ShadowMap", mCommandList.Get(), &DepthStencilView(), mCurrFrameResource);
 		Renderer::bPerformShadowMapping = false;
 	}
 	
@@ -203,6 +321,9 @@ void DemoApp::Draw(const GameTimer& gt)
 	// Copy the contents of the off-screen texture to the back buffer
 	Renderer::CopyToBackBuffer(mCommandList.Get(), CurrentBackBuffer());
 
+	// Resolve this frame's timestamp queries
+	GpuProfiler::EndFrame(mCommandList.Get());
+
     // Done recording commands.
     ThrowIfFailed(mCommandList->Close());
 
@@ -221,6 +342,28 @@ void DemoApp::Draw(const GameTimer& gt)
     // Because we are on the GPU timeline, the new fence point won't be 
     // set until the GPU finishes processing all the commands prior to this Signal().
     mCommandQueue->Signal(mFence.Get(), mCurrentFence);
+
+	if (bCapturingGIStatistics)
+		CaptureGIStatistics();
+
+	if (!bFirstFramePresented)
+	{
+		bFirstFramePresented = true;
+
+		double startToFirstFrame = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStartTime).count();
+
+		std::ostringstream report;
+		report << "Start to first frame: " << startToFirstFrame << " ms, "
+			<< TextureStreamer::GetResidentBytes() / (1024.0 * 1024.0) << " MB of streamed textures resident, "
+			<< MemoryTracker::GetLiveBytes(MemoryCategory::Textures) / (1024.0 * 1024.0) << " MB of textures allocated\n";
+
+		// With the cache the first frame already has converged indirect lighting
+		const char* statusNames[] = { "loaded", "missing", "invalid", "stale" };
+		report << "GI cache " << statusNames[(int)mGICacheStatus] << " (" << mGICacheRestoreMilliseconds << " ms), "
+			<< (mGICacheStatus == GICacheStatus::Loaded ? "indirect lighting restored" : "indirect lighting converges progressively") << "\n";
+
+		::OutputDebugStringA(report.str().c_str());
+	}
 }
 
 /// <summary>
@@ -277,7 +420,52 @@ void DemoApp::OnKeyPress(WPARAM keyState)
 	else if (keyState == VK_DOWN)
 	{
 		mCamera.RotateDown(mTimer.DeltaTime());
-	}	
+	}
+	// P pressed - start recording profiler markers
+	else if (keyState == 0x50)
+	{
+		Profiler::Reset();
+		Profiler::SetEnabled(true);
+	}
+	// O pressed - stop recording and export the capture
+	else if (keyState == 0x4F && Profiler::IsEnabled())
+	{
+		Profiler::SetEnabled(false);
+		Profiler::ExportChromeTrace("ProfilerTrace.json");
+		Profiler::ExportCSVSummary("ProfilerSummary.csv");
+	}
+	// M pressed - print the live and peak memory per category and the streamed texture mips to the debug output
+	else if (keyState == 0x4D)
+	{
+		::OutputDebugStringA(MemoryTracker::GetReport().c_str());
+		::OutputDebugStringA(TextureStreamer::GetReport().c_str());
+	}
+	// I pressed - print the voxel injection work skipped and executed to the debug output
+	else if (keyState == 0x49)
+	{
+		::OutputDebugStringA(Renderer::injectionChangeDetector.GetReport().c_str());
+	}
+	// G pressed - save the current voxel and SH grids as the scene's GI cache
+	else if (keyState == 0x47)
+	{
+		SaveGICache();
+	}
+	// V pressed - start measuring the voxel and SH grids every frame, or stop and export the measurements
+	else if (keyState == 0x56)
+	{
+		bCapturingGIStatistics = !bCapturingGIStatistics;
+
+		if (bCapturingGIStatistics)
+		{
+			Renderer::giStatistics.Reset();
+		}
+		else
+		{
+			Renderer::giStatistics.ExportCSV("GIStatistics.csv");
+			Renderer::giStatistics.ExportCellEnergyCSV("GICellEnergy.csv");
+			::OutputDebugStringA(Renderer::giStatistics.GetSummary().c_str());
+		}
+	}
 }
 
 /// <summary>
@@ -299,22 +487,25 @@ void DemoApp::UpdateCamera(const GameTimer& gt)
 /// </summary>
 void DemoApp::UpdateObjectCBs(const GameTimer& gt)
 {
+	PROFILE_SCOPE("DemoApp::UpdateObjectCBs");
+
 	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
 	for(UINT i = 0; i < SceneManager::GetScenePtr()->numberOfObjects; ++i)
 	{
 		// Only update the cbuffer data if the constants have changed.  
 		// This needs to be tracked per frame resource.
-		if(SceneManager::GetScenePtr()->mOpaqueRObjects[i]->GetNumFramesDirty() > 0)
+		if(SceneManager::GetScenePtr()->mOpaqueRObjects[i].GetNumFramesDirty() > 0)
 		{
-			XMMATRIX world = XMLoadFloat4x4(SceneManager::GetScenePtr()->mOpaqueRObjects[i]->GetWorldMatrixPtr());
+			XMMATRIX world = XMLoadFloat4x4(SceneManager::GetScenePtr()->mOpaqueRObjects[i].GetWorldMatrixPtr());
 			
 			ObjectConstants objConstants;
 			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
 			
-			currObjectCB->CopyData(SceneManager::GetScenePtr()->mOpaqueRObjects[i]->GetObjCBIndex(), objConstants);
+			currObjectCB->CopyData(SceneManager::GetScenePtr()->mOpaqueRObjects[i].GetObjCBIndex(), objConstants);
 
 			// Next FrameResource need to be updated too.
-			SceneManager::GetScenePtr()->mOpaqueRObjects[i]->DecrementNumFramesDirty();
+			SceneManager::GetScenePtr()->mOpaqueRObjects[i].DecrementNumFramesDirty();
+			bSceneChanged = true;
 		}
 	}
 }
@@ -324,19 +515,22 @@ void DemoApp::UpdateObjectCBs(const GameTimer& gt)
 /// </summary>
 void DemoApp::UpdateMaterialCBs(const GameTimer& gt)
 {
+	PROFILE_SCOPE("DemoApp::UpdateMaterialCBs");
+
 	auto currMaterialCB = mCurrFrameResource->MaterialCB.get();
 	for(UINT i = 0; i < SceneManager::GetScenePtr()->numberOfUniqueObjects; ++i)
 	{
 		// Only update the cbuffer data if the constants have changed.  If the cbuffer
 		// data changes, it needs to be updated for each FrameResource.
-		if(SceneManager::GetScenePtr()->mMaterials[i]->NumFramesDirty > 0)
+		if(SceneManager::GetScenePtr()->mMaterials[i].NumFramesDirty > 0)
 		{
 			MaterialConstants matConstants;
-			matConstants.Metallic = SceneManager::GetScenePtr()->mMaterials[i]->Metallic;
-			currMaterialCB->CopyData(SceneManager::GetScenePtr()->mMaterials[i]->MatCBIndex, matConstants);
+			matConstants.Metallic = SceneManager::GetScenePtr()->mMaterials[i].Metallic;
+			currMaterialCB->CopyData(SceneManager::GetScenePtr()->mMaterials[i].MatCBIndex, matConstants);
 
 			// Next FrameResource need to be updated too.
-			SceneManager::GetScenePtr()->mMaterials[i]->NumFramesDirty--;
+			SceneManager::GetScenePtr()->mMaterials[i].NumFramesDirty--;
+			bSceneChanged = true;
 		}
 	}
 }
@@ -346,6 +540,8 @@ void DemoApp::UpdateMaterialCBs(const GameTimer& gt)
 /// </summary>
 void DemoApp::UpdateMainPassCB(const GameTimer& gt)
 {
+	PROFILE_SCOPE("DemoApp::UpdateMainPassCB");
+
 	XMMATRIX view = XMLoadFloat4x4(&mView);
 	XMMATRIX proj = XMLoadFloat4x4(&mProj);
 
@@ -362,6 +558,22 @@ void DemoApp::UpdateMainPassCB(const GameTimer& gt)
 	XMStoreFloat4x4(&mMainPassCB.ViewProj, XMMatrixTranspose(viewProj));
 	XMStoreFloat4x4(&mMainPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
 
+	// The part of the screen injected into the voxel grids this frame
+	InjectionView injectionView;
+	injectionView.view = mView;
+	injectionView.proj = mProj;
+	XMStoreFloat4x4(&injectionView.invView, invView);
+	XMStoreFloat4x4(&injectionView.invProj, invProj);
+	injectionView.lightDirection = SceneManager::GetScenePtr()->lightDirection;
+	injectionView.lightStrength = SceneManager::GetScenePtr()->lightStrength;
+	injectionView.bSceneChanged = bSceneChanged;
+	injectionView.width = (UINT)mClientWidth;
+	injectionView.height = (UINT)mClientHeight;
+	Renderer::ScheduleVoxelInjection(injectionView, mMainPassCB);
+
+	// The SH grid cells cone traced this frame
+	Renderer::ScheduleSHUpdates(mView, mMainPassCB);
+
 	// Camera position
 	mMainPassCB.EyePosW = XMFLOAT3(mCamera.GetPositionPtr()->x, mCamera.GetPositionPtr()->y, mCamera.GetPositionPtr()->z);
 	
@@ -456,9 +668,55 @@ void DemoApp::UpdateMainPassCB(const GameTimer& gt)
 /// </summary>
 void DemoApp::BuildFrameResources()
 {
-    for(int i = 0; i < 3; ++i)
+    for(int i = 0; i < gNumFrameResources; ++i)
     {
         mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
             1, (UINT)SceneManager::GetScenePtr()->numberOfObjects, (UINT)SceneManager::GetScenePtr()->numberOfUniqueObjects));
     }
+}
+/// <summary>
+/// Copies the voxel and SH grids into readback buffers and waits until the copies executed
+/// </summary>
+void DemoApp::ReadBackGIGrids()
+{
+	// The initialization allocator is free once the frames in flight completed
+	FlushCommandQueue();
+
+	ThrowIfFailed(mDirectCmdListAlloc->Reset());
+	ThrowIfFailed(mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr));
+
+	Renderer::RecordGICacheReadback(md3dDevice.Get(), mCommandList.Get());
+
+	ThrowIfFailed(mCommandList->Close());
+	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
+	mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+
+	FlushCommandQueue();
+}
+
+/// <summary>
+/// Reads the voxel and SH grids back from the GPU and writes them to the scene's GI cache
+/// </summary>
+void DemoApp::SaveGICache()
+{
+	ReadBackGIGrids();
+
+	std::string report = (Renderer::SaveGICache(mGICachePath) ? "Saved the GI cache to " : "Could not save the GI cache to ") + mGICachePath + "\n";
+	::OutputDebugStringA(report.c_str());
+}
+
+/// <summary>
+/// Reads the voxel and SH grids back from the GPU and adds them as a frame of the GI statistics
+/// </summary>
+void DemoApp::CaptureGIStatistics()
+{
+	ReadBackGIGrids();
+
+	// The cones the SH pass traces with this frame's pass constants
+	SHBakeSettings settings;
+	settings.worldBoundary = mMainPassCB.worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.x;
+	settings.coneStep = mMainPassCB.worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A.y;
+	settings.gridResolution = Renderer::shIndirectRenderPass.gridResolution;
+
+	Renderer::AddGIStatisticsFrame(settings);
 }
\ No newline at end of file
@@ -7,10 +7,14 @@ void DirectLightingRenderPass::Execute(ID3D12GraphicsCommandList * commandList,
 	auto objectCB = mCurrFrameResource->ObjectCB->Resource();
 	auto matCB = mCurrFrameResource->MaterialCB->Resource();
 
-	UINT cbvSrvUavDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 	UINT rtvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 	CD3DX12_CPU_DESCRIPTOR_HANDLE dsvhDescriptor(mDsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
 
+	// The material texture SRVs change as textures are streamed, so this frame gets its own copy of them
+	D3D12_CPU_DESCRIPTOR_HANDLE materialDescriptors;
+	mMaterialTable = GlobalDescriptorHeap::AllocateTransient(TextureStreamer::GetTextureCount(), materialDescriptors);
+	TextureStreamer::CopyDescriptors(materialDescriptors);
+
 	commandList->SetPipelineState(mPSO.Get());
 
 	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mDepthStencilBuffer.Get(),
@@ -40,15 +44,9 @@ void DirectLightingRenderPass::Execute(ID3D12GraphicsCommandList * commandList,
 		0,
 		rtvDescriptorSize), true, &dsvhDescriptor);
 
-	ID3D12DescriptorHeap* descriptorHeapsGBuffer[] = { mSrvDescriptorHeap.Get() };
-	commandList->SetDescriptorHeaps(_countof(descriptorHeapsGBuffer), descriptorHeapsGBuffer);
-
 	commandList->SetGraphicsRootSignature(mRootSignature.Get());
 
-	CD3DX12_GPU_DESCRIPTOR_HANDLE tex(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-	tex.Offset((2 * SceneManager::GetScenePtr()->numberOfUniqueObjects), cbvSrvUavDescriptorSize);
-
-	commandList->SetGraphicsRootDescriptorTable(1, tex);
+	commandList->SetGraphicsRootDescriptorTable(1, GlobalDescriptorHeap::GetGpuHandle(mSrvDescriptors));
 
 	commandList->SetGraphicsRootConstantBufferView(3, passCB->GetGPUVirtualAddress());
 
@@ -73,7 +71,7 @@ void DirectLightingRenderPass::Draw(ID3D12GraphicsCommandList* commandList, ID3D
 
 	for (size_t i = 0; i < SceneManager::GetScenePtr()->numberOfObjects; ++i)
 	{
-		SceneManager::GetScenePtr()->mOpaqueRObjects[i]->Draw(commandList, objectCB, matCB, mSrvDescriptorHeap, cbvSrvDescriptorSize, objCBByteSize, matCBByteSize, false);
+		SceneManager::GetScenePtr()->mOpaqueRObjects[i].Draw(commandList, objectCB, matCB, mMaterialTable, cbvSrvDescriptorSize, objCBByteSize, matCBByteSize, false);
 	}
 }
 
@@ -169,6 +167,9 @@ void DirectLightingRenderPass::BuildDescriptorHeaps()
 	ThrowIfFailed(md3dDevice->CreateCommittedResource(&heapProperty, D3D12_HEAP_FLAG_NONE,
 		&resourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, &clearVal, IID_PPV_ARGS(mOutputBuffers[2].GetAddressOf())));
 
+	for (int i = 0; i < 3; ++i)
+		d3dUtil::TrackResource(md3dDevice.Get(), mOutputBuffers[i].Get(), MemoryCategory::PassOutputs);
+
 	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc;
 	rtvHeapDesc.NumDescriptors = 3;
 	rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
@@ -202,36 +203,10 @@ void DirectLightingRenderPass::BuildDescriptorHeaps()
 	md3dDevice->CreateRenderTargetView(mOutputBuffers[2].Get(), &rtvDesc, rtvhDescriptor);
 
 	//
-	// Create the SRV heap.
+	// Allocate the shadow map SRV in the global heap. The material textures go to a table of the
+	// frame, see Execute.
 	//
-	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-	srvHeapDesc.NumDescriptors = (2 * SceneManager::GetScenePtr()->numberOfUniqueObjects) + 1;
-	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvDescriptorHeap)));
-
-	//
-	// Fill out the heap with actual descriptors.
-	//
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-
-	UINT cbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-
-	for (UINT i = 0; i < (2 * SceneManager::GetScenePtr()->numberOfUniqueObjects); ++i)
-	{
-		srvDesc.Format = SceneManager::GetScenePtr()->mTextures[i]->Resource->GetDesc().Format;
-		srvDesc.Texture2D.MipLevels = SceneManager::GetScenePtr()->mTextures[i]->Resource->GetDesc().MipLevels;
-
-		md3dDevice->CreateShaderResourceView(SceneManager::GetScenePtr()->mTextures[i]->Resource.Get(), &srvDesc, hDescriptor);
-
-		hDescriptor.Offset(1, cbvSrvDescriptorSize);
-	}
+	ALLOCATE_SRV_UAV_DESCRIPTORS(1)
 
 	// Create SRV to resource so we can sample the shadow map in a shader program.
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDescShadowMap = {};
@@ -243,7 +218,7 @@ void DirectLightingRenderPass::BuildDescriptorHeaps()
 	srvDescShadowMap.Texture2D.ResourceMinLODClamp = 0.0f;
 	srvDescShadowMap.Texture2D.PlaneSlice = 0;
 
-	md3dDevice->CreateShaderResourceView(mInputBuffers[0].Get(), &srvDescShadowMap, hDescriptor);
+	md3dDevice->CreateShaderResourceView(mInputBuffers[0].Get(), &srvDescShadowMap, GlobalDescriptorHeap::GetCpuHandle(mSrvDescriptors));
 
 	// Create the depth/stencil buffer and view.
 	D3D12_RESOURCE_DESC depthStencilDesc;
@@ -271,6 +246,8 @@ void DirectLightingRenderPass::BuildDescriptorHeaps()
 		&optClear,
 		IID_PPV_ARGS(mDepthStencilBuffer.GetAddressOf())));
 
+	d3dUtil::TrackResource(md3dDevice.Get(), mDepthStencilBuffer.Get(), MemoryCategory::PassOutputs);
+
 	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
 	dsvHeapDesc.NumDescriptors = 1;
 	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
@@ -15,4 +15,7 @@ protected:
 	virtual void BuildDescriptorHeaps() override;
 	virtual void BuildPSOs() override;
 	virtual void Draw(ID3D12GraphicsCommandList*, ID3D12Resource*, ID3D12Resource*) override;
+
+	// This frame's copy of the material texture SRVs, in the global heap's transient region
+	D3D12_GPU_DESCRIPTOR_HANDLE mMaterialTable = {};
 };
\ No newline at end of file
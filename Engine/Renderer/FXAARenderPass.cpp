@@ -24,18 +24,18 @@ void FXAARenderPass::BuildDescriptorHeaps()
 
 	for (int i = 0; i < 1; ++i)
 	{
-		CREATE_OUTPUT_BUFFER_RESOURCE(nullptr)
+		CREATE_OUTPUT_BUFFER_RESOURCE(nullptr, MemoryCategory::PassOutputs)
 	}
 
 	//
-	// Create the SRV and UAV heap.
+	// Allocate the SRV and UAV table in the global heap.
 	//
-	CREATE_SRV_UAV_HEAP(2)
+	ALLOCATE_SRV_UAV_DESCRIPTORS(2)
 
 	//
-	// Fill out the heap with actual descriptors.
+	// Fill out the table with actual descriptors.
 	//
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(GlobalDescriptorHeap::GetCpuHandle(mSrvDescriptors));
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -0,0 +1,87 @@
+#include "GlobalDescriptorHeap.h"
+#include "../Utilities/FrameResource.h"
+
+using Microsoft::WRL::ComPtr;
+
+ComPtr<ID3D12DescriptorHeap> GlobalDescriptorHeap::mHeap;
+UINT GlobalDescriptorHeap::mDescriptorSize = 0;
+DescriptorAllocator GlobalDescriptorHeap::mAllocator;
+
+void GlobalDescriptorHeap::Initialize(ComPtr<ID3D12Device> device, UINT persistentCount, UINT transientCount)
+{
+	mAllocator.Reset(persistentCount, transientCount, gNumFrameResources);
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = mAllocator.GetCapacity();
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	ThrowIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&mHeap)));
+
+	mDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+void GlobalDescriptorHeap::Shutdown()
+{
+	mAllocator.Reset(0, 0, 1);
+	mHeap = nullptr;
+}
+
+DescriptorHandle GlobalDescriptorHeap::Allocate(UINT count)
+{
+	DescriptorHandle handle;
+
+	if (!mAllocator.Allocate(count, handle))
+		throw DxException(E_OUTOFMEMORY, L"GlobalDescriptorHeap::Allocate", AnsiToWString(__FILE__), __LINE__);
+
+	return handle;
+}
+
+void GlobalDescriptorHeap::Free(DescriptorHandle handle, UINT64 fence)
+{
+	if (!mAllocator.Free(handle, fence))
+		throw DxException(E_INVALIDARG, L"GlobalDescriptorHeap::Free", AnsiToWString(__FILE__), __LINE__);
+}
+
+void GlobalDescriptorHeap::BeginFrame(UINT frameIndex, UINT64 completedFence)
+{
+	mAllocator.BeginFrame(frameIndex, completedFence);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE GlobalDescriptorHeap::AllocateTransient(UINT count, D3D12_CPU_DESCRIPTOR_HANDLE& cpuHandle)
+{
+	uint32_t index = 0;
+
+	if (!mAllocator.AllocateTransient(count, index))
+		throw DxException(E_OUTOFMEMORY, L"GlobalDescriptorHeap::AllocateTransient", AnsiToWString(__FILE__), __LINE__);
+
+	cpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(mHeap->GetCPUDescriptorHandleForHeapStart(), index, mDescriptorSize);
+
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(mHeap->GetGPUDescriptorHandleForHeapStart(), index, mDescriptorSize);
+}
+
+void GlobalDescriptorHeap::SetHeap(ID3D12GraphicsCommandList* commandList)
+{
+	ID3D12DescriptorHeap* descriptorHeaps[] = { mHeap.Get() };
+	commandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE GlobalDescriptorHeap::GetCpuHandle(DescriptorHandle handle)
+{
+	if (!mAllocator.IsValid(handle))
+		throw DxException(E_INVALIDARG, L"GlobalDescriptorHeap::GetCpuHandle", AnsiToWString(__FILE__), __LINE__);
+
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(mHeap->GetCPUDescriptorHandleForHeapStart(), handle.index, mDescriptorSize);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE GlobalDescriptorHeap::GetGpuHandle(DescriptorHandle handle)
+{
+	if (!mAllocator.IsValid(handle))
+		throw DxException(E_INVALIDARG, L"GlobalDescriptorHeap::GetGpuHandle", AnsiToWString(__FILE__), __LINE__);
+
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(mHeap->GetGPUDescriptorHandleForHeapStart(), handle.index, mDescriptorSize);
+}
+
+UINT GlobalDescriptorHeap::GetDescriptorSize()
+{
+	return mDescriptorSize;
+}
\ No newline at end of file
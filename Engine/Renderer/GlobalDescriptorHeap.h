@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../Utilities/d3dUtil.h"
+#include "../Utilities/DescriptorAllocator.h"
+
+// The one shader visible CBV/SRV/UAV heap of the renderer, set once per command list. Passes keep
+// their descriptor tables in persistent ranges, tables that change every frame, like the streamed
+// material textures, go to the frame's transient region. See DescriptorAllocator.
+class GlobalDescriptorHeap
+{
+public:
+	GlobalDescriptorHeap() = default;
+	~GlobalDescriptorHeap() = default;
+
+	// Persistent descriptors and transient descriptors per frame resource
+	static void Initialize(Microsoft::WRL::ComPtr<ID3D12Device>, UINT, UINT);
+	static void Shutdown();
+
+	// Throws when no free range is large enough
+	static DescriptorHandle Allocate(UINT);
+	// The range is reused once the given fence completed
+	static void Free(DescriptorHandle, UINT64);
+
+	// Call after the fence of the frame resource with this index completed
+	static void BeginFrame(UINT, UINT64);
+	// A table that lives until the frame's fence completes. Throws when the frame's region is full.
+	static D3D12_GPU_DESCRIPTOR_HANDLE AllocateTransient(UINT, D3D12_CPU_DESCRIPTOR_HANDLE&);
+
+	static void SetHeap(ID3D12GraphicsCommandList*);
+
+	// Throw for stale handles
+	static D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(DescriptorHandle);
+	static D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(DescriptorHandle);
+
+	static UINT GetDescriptorSize();
+
+private:
+
+	static Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mHeap;
+	static UINT mDescriptorSize;
+	static DescriptorAllocator mAllocator;
+};
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "GpuProfiler.h"
+
+using Microsoft::WRL::ComPtr;
+
+ComPtr<ID3D12CommandQueue> GpuProfiler::mCommandQueue;
+ComPtr<ID3D12QueryHeap> GpuProfiler::mQueryHeap;
+ComPtr<ID3D12Resource> GpuProfiler::mReadbackBuffer;
+
+GpuProfiler::FrameQueries GpuProfiler::mFrames[GPU_PROFILER_FRAME_COUNT];
+UINT GpuProfiler::mOpenEvents[GPU_PROFILER_MAX_EVENTS];
+const UINT GpuProfiler::SkippedEvent;
+UINT GpuProfiler::mOpenEventCount = 0;
+UINT GpuProfiler::mSkippedOpenEventCount = 0;
+UINT GpuProfiler::mOverflowedOpenEventCount = 0;
+UINT GpuProfiler::mCurrentFrame = 0;
+UINT64 GpuProfiler::mTimestampFrequency = 1;
+bool GpuProfiler::bInitialized = false;
+
+void GpuProfiler::Initialize(ComPtr<ID3D12Device> inputDevice, ComPtr<ID3D12CommandQueue> inputCommandQueue)
+{
+	mCommandQueue = inputCommandQueue;
+
+	// Two timestamps (begin and end) per event
+	const UINT queryCount = GPU_PROFILER_FRAME_COUNT * GPU_PROFILER_MAX_EVENTS * 2;
+
+	D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = queryCount;
+	queryHeapDesc.NodeMask = 0;
+	ThrowIfFailed(inputDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&mQueryHeap)));
+
+	ThrowIfFailed(inputDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(queryCount * sizeof(UINT64)),
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&mReadbackBuffer)));
+
+	ThrowIfFailed(mCommandQueue->GetTimestampFrequency(&mTimestampFrequency));
+
+	bInitialized = true;
+}
+
+void GpuProfiler::BeginFrame(UINT frameIndex)
+{
+	if (!bInitialized)
+		return;
+
+	mCurrentFrame = frameIndex % GPU_PROFILER_FRAME_COUNT;
+
+	FrameQueries& frame = mFrames[mCurrentFrame];
+
+	// The previous user of this slot has finished on the GPU, hand its timings to the profiler
+	if (frame.isResolved && frame.eventCount > 0)
+		CollectFrame(frame, mCurrentFrame);
+
+	frame.eventCount = 0;
+	frame.isResolved = false;
+	mOpenEventCount = 0;
+	mSkippedOpenEventCount = 0;
+	mOverflowedOpenEventCount = 0;
+}
+
+void GpuProfiler::EndFrame(ID3D12GraphicsCommandList* commandList)
+{
+	if (!bInitialized)
+		return;
+
+	FrameQueries& frame = mFrames[mCurrentFrame];
+
+	// Close any region that was left open so the resolved range is fully written
+	while (mOpenEventCount > 0)
+		EndEvent(commandList);
+
+	if (frame.eventCount == 0)
+		return;
+
+	UINT firstQuery = mCurrentFrame * GPU_PROFILER_MAX_EVENTS * 2;
+
+	commandList->ResolveQueryData(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, frame.eventCount * 2,
+		mReadbackBuffer.Get(), firstQuery * sizeof(UINT64));
+
+	frame.isResolved = true;
+}
+
+void GpuProfiler::BeginEvent(ID3D12GraphicsCommandList* commandList, const char* name)
+{
+	if (!bInitialized)
+		return;
+
+	FrameQueries& frame = mFrames[mCurrentFrame];
+
+	// Nested deeper than the stack holds, only counted so its end is dropped as well
+	if (mOpenEventCount >= GPU_PROFILER_MAX_EVENTS)
+	{
+		++mOverflowedOpenEventCount;
+		return;
+	}
+
+	// A skipped region (profiler disabled or event budget exhausted) still takes its place on the
+	// stack, so its end doesn't close the region around it
+	if (!Profiler::IsEnabled() || frame.eventCount >= GPU_PROFILER_MAX_EVENTS)
+	{
+		mOpenEvents[mOpenEventCount++] = SkippedEvent;
+		++mSkippedOpenEventCount;
+		return;
+	}
+
+	UINT eventIndex = frame.eventCount++;
+
+	frame.names[eventIndex] = name;
+	frame.depths[eventIndex] = mOpenEventCount - mSkippedOpenEventCount;
+
+	mOpenEvents[mOpenEventCount++] = eventIndex;
+
+	commandList->EndQuery(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+		(mCurrentFrame * GPU_PROFILER_MAX_EVENTS + eventIndex) * 2);
+}
+
+void GpuProfiler::EndEvent(ID3D12GraphicsCommandList* commandList)
+{
+	if (!bInitialized)
+		return;
+
+	if (mOverflowedOpenEventCount > 0)
+	{
+		--mOverflowedOpenEventCount;
+		return;
+	}
+
+	if (mOpenEventCount == 0)
+		return;
+
+	UINT eventIndex = mOpenEvents[--mOpenEventCount];
+
+	// The matching begin was skipped, there is no query to end
+	if (eventIndex == SkippedEvent)
+	{
+		--mSkippedOpenEventCount;
+		return;
+	}
+
+	commandList->EndQuery(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+		(mCurrentFrame * GPU_PROFILER_MAX_EVENTS + eventIndex) * 2 + 1);
+}
+
+void GpuProfiler::CollectFrame(FrameQueries& frame, UINT frameIndex)
+{
+	// Map GPU ticks onto the profiler clock. The CPU side of the calibration is a QPC value which
+	// is also what steady_clock is based on.
+	UINT64 gpuCalibration = 0;
+	UINT64 cpuCalibration = 0;
+	ThrowIfFailed(mCommandQueue->GetClockCalibration(&gpuCalibration, &cpuCalibration));
+
+	LARGE_INTEGER qpcFrequency;
+	QueryPerformanceFrequency(&qpcFrequency);
+
+	double cpuCalibrationNs = (double)cpuCalibration * (1.0e9 / (double)qpcFrequency.QuadPart);
+	double nsPerTick = 1.0e9 / (double)mTimestampFrequency;
+
+	UINT firstQuery = frameIndex * GPU_PROFILER_MAX_EVENTS * 2;
+
+	D3D12_RANGE readRange = { firstQuery * sizeof(UINT64), (firstQuery + frame.eventCount * 2) * sizeof(UINT64) };
+	D3D12_RANGE writeRange = { 0, 0 };
+
+	UINT64* timestamps = nullptr;
+	ThrowIfFailed(mReadbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&timestamps)));
+
+	for (UINT i = 0; i < frame.eventCount; ++i)
+	{
+		UINT64 beginTicks = timestamps[firstQuery + i * 2];
+		UINT64 endTicks = timestamps[firstQuery + i * 2 + 1];
+
+		if (endTicks < beginTicks)
+			continue;
+
+		double beginNs = cpuCalibrationNs + ((double)beginTicks - (double)gpuCalibration) * nsPerTick;
+		double endNs = cpuCalibrationNs + ((double)endTicks - (double)gpuCalibration) * nsPerTick;
+
+		Profiler::RecordGpuEvent(frame.names[i], (uint64_t)beginNs, (uint64_t)endNs, frame.depths[i]);
+	}
+
+	mReadbackBuffer->Unmap(0, &writeRange);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../Utilities/d3dUtil.h"
+#include "../Utilities/Profiler.h"
+
+// Should match the number of frame resources so a slot is only read back after its fence completed
+#define GPU_PROFILER_FRAME_COUNT 3
+#define GPU_PROFILER_MAX_EVENTS 32
+
+// Timestamp query backend for the profiler. Regions are bracketed on the command list and
+// resolved into a readback buffer at the end of the frame. Results are fed into the
+// profiler's GPU track once the fence of that frame slot has been waited on.
+class GpuProfiler
+{
+public:
+	GpuProfiler() = default;
+	~GpuProfiler() = default;
+
+	static void Initialize(Microsoft::WRL::ComPtr<ID3D12Device>, Microsoft::WRL::ComPtr<ID3D12CommandQueue>);
+
+	// Call after the fence of the frame resource with this index completed.
+	static void BeginFrame(UINT);
+	static void EndFrame(ID3D12GraphicsCommandList*);
+
+	static void BeginEvent(ID3D12GraphicsCommandList*, const char*);
+	static void EndEvent(ID3D12GraphicsCommandList*);
+
+private:
+
+	struct FrameQueries
+	{
+		const char* names[GPU_PROFILER_MAX_EVENTS];
+		UINT depths[GPU_PROFILER_MAX_EVENTS];
+		UINT eventCount = 0;
+		bool isResolved = false;
+	};
+
+	static void CollectFrame(FrameQueries&, UINT);
+
+	static Microsoft::WRL::ComPtr<ID3D12CommandQueue> mCommandQueue;
+	static Microsoft::WRL::ComPtr<ID3D12QueryHeap> mQueryHeap;
+	static Microsoft::WRL::ComPtr<ID3D12Resource> mReadbackBuffer;
+
+	static FrameQueries mFrames[GPU_PROFILER_FRAME_COUNT];
+	// Indices of the open regions' events, SkippedEvent for the regions that got no queries
+	static const UINT SkippedEvent = UINT_MAX;
+	static UINT mOpenEvents[GPU_PROFILER_MAX_EVENTS];
+	static UINT mOpenEventCount;
+	static UINT mSkippedOpenEventCount;
+	// Open regions nested deeper than the stack holds, always the innermost ones
+	static UINT mOverflowedOpenEventCount;
+	static UINT mCurrentFrame;
+	static UINT64 mTimestampFrequency;
+	static bool bInitialized;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "GlobalDescriptorHeap.h"
 #include "../Utilities/PVGIDecl.h"
 
 using Microsoft::WRL::ComPtr;
@@ -10,7 +11,7 @@ using Microsoft::WRL::ComPtr;
 // 2. Set output buffers from Generic Read state to Render Target state
 // 3. Clear the render target views
 // 4. Set the render targets
-// 5. Set the SRV heap
+// 5. Set the descriptor tables of the global heap
 // 6. Set the root signature
 // 7. Set the constant buffer view for PassCB
 // 8. Draw scene/quad
@@ -29,9 +30,11 @@ public:
 	ComPtr<ID3D12PipelineState> mPSO = nullptr;
 
 	ComPtr<ID3D12DescriptorHeap> mRtvDescriptorHeap = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
 	ComPtr<ID3D12DescriptorHeap> mDsvDescriptorHeap = nullptr;
 
+	// SRV and UAV table in the global heap
+	DescriptorHandle mSrvDescriptors;
+
 	ComPtr<ID3D12RootSignature> mRootSignature = nullptr;
 
 	ComPtr<ID3D12Resource>* mInputBuffers;
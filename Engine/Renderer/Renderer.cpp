@@ -11,9 +11,19 @@ FXAARenderPass Renderer::fxaaRenderPass;
 ToneMappingRenderPass Renderer::toneMappingRenderPass;
 ColorGradingRenderPass Renderer::colorGradingRenderPass;
 
-bool Renderer::bPerformConeTracing = true;
 bool Renderer::bPerformShadowMapping = true;
 
+SHUpdateScheduler Renderer::shUpdateScheduler;
+InjectionChangeDetector Renderer::injectionChangeDetector;
+GIStatistics Renderer::giStatistics;
+std::vector<uint32_t> Renderer::mScheduledCells;
+// The first frame injects the whole screen
+uint32_t Renderer::mLastInjectionFrame = 1;
+
+GICache Renderer::mGICache;
+ComPtr<ID3D12Resource> Renderer::mGICacheUploaders[Voxelizer::MipCount + GICache::SHGridCount];
+ComPtr<ID3D12Resource> Renderer::mGICacheReadbacks[Voxelizer::MipCount + GICache::SHGridCount];
+
 void Renderer::Initialize(ComPtr<ID3D12Device> inputDevice, int inputWidth, int inputHeight,
 	DXGI_FORMAT inputFormatBackBuffer, DXGI_FORMAT inputFormatDepthBuffer)
 {
@@ -57,40 +67,59 @@ void Renderer::Initialize(ComPtr<ID3D12Device> inputDevice, int inputWidth, int
 	colorGradingRenderPass.Initialize(inputDevice, inputWidth, inputHeight,
 		inputFormatBackBuffer, inputFormatDepthBuffer, fxaaRenderPass.mOutputBuffers, 
 		nullptr, nullptr, nullptr, L"", L"ColorGrading.hlsl", true);
+
+	SHUpdateSettings shUpdateSettings;
+	shUpdateSettings.gridResolution = shIndirectRenderPass.gridResolution;
+	shUpdateSettings.worldBoundary = shIndirectRenderPass.worldVolumeBoundary;
+	shUpdateScheduler.Reset(shUpdateSettings);
+
+	InjectionChangeSettings injectionChangeSettings;
+	injectionChangeSettings.worldBoundary = voxelInjectionRenderPass.worldVolumeBoundary;
+	injectionChangeDetector.Reset(injectionChangeSettings);
 }
 
 void Renderer::Execute(ID3D12GraphicsCommandList * commandList, D3D12_CPU_DESCRIPTOR_HANDLE * depthStencilViewPtr,
 	FrameResource* mCurrFrameResource)
 {
-	bPerformConeTracing = !bPerformConeTracing;
+	PROFILE_SCOPE("Renderer::Execute");
 
 	// Render the gBuffers
-	directLightingRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	ExecutePass(directLightingRenderPass, "DirectLighting", commandList, depthStencilViewPtr, mCurrFrameResource);
+
+	// Inject lighting data into the voxel grids
+	ExecutePass(voxelInjectionRenderPass, "VoxelInjection", commandList, depthStencilViewPtr, mCurrFrameResource);
 
-	if (!bPerformConeTracing)
-		// Inject lighting data into the voxel grids
-		voxelInjectionRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
-	else
-		// Cone trace indirect lighting and inject it into the spherical harmonic grids
-		shIndirectRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	// Cone trace indirect lighting into the spherical harmonic grid cells scheduled for this frame
+	ExecutePass(shIndirectRenderPass, "SHIndirect", commandList, depthStencilViewPtr, mCurrFrameResource);
 
 	// Sample SH grid to compute indirect diffuse lighting
-	indirectLightingRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	ExecutePass(indirectLightingRenderPass, "IndirectLighting", commandList, depthStencilViewPtr, mCurrFrameResource);
 
 	// Render skybox on the background pixels using a quad
-	skyBoxRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	ExecutePass(skyBoxRenderPass, "SkyBox", commandList, depthStencilViewPtr, mCurrFrameResource);
 
 	// Perform ray marching to compute volumetric lighting
-	//volumetricLightingRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	//ExecutePass(volumetricLightingRenderPass, "VolumetricLighting", commandList, depthStencilViewPtr, mCurrFrameResource);
 
 	// Perform anti-aliasing using FXAA
-	fxaaRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	ExecutePass(fxaaRenderPass, "FXAA", commandList, depthStencilViewPtr, mCurrFrameResource);
 
 	// Bring the texture down to LDR range from HDR using Uncharted 2 style tonemapping
-	toneMappingRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	ExecutePass(toneMappingRenderPass, "ToneMapping", commandList, depthStencilViewPtr, mCurrFrameResource);
 
 	// Use 2D LUTs for color grading
-	colorGradingRenderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	ExecutePass(colorGradingRenderPass, "ColorGrading", commandList, depthStencilViewPtr, mCurrFrameResource);
+}
+
+void Renderer::ExecutePass(RenderPass& renderPass, const char* passName, ID3D12GraphicsCommandList* commandList,
+	D3D12_CPU_DESCRIPTOR_HANDLE* depthStencilViewPtr, FrameResource* mCurrFrameResource)
+{
+	// CPU scope measures command recording, the timestamp pair measures execution on the GPU
+	PROFILE_SCOPE(passName);
+
+	GpuProfiler::BeginEvent(commandList, passName);
+	renderPass.Execute(commandList, depthStencilViewPtr, mCurrFrameResource);
+	GpuProfiler::EndEvent(commandList);
 }
 
 void Renderer::CopyToBackBuffer(ID3D12GraphicsCommandList* commandList, ID3D12Resource * backBuffer)
@@ -109,3 +138,231 @@ void Renderer::CopyToBackBuffer(ID3D12GraphicsCommandList* commandList, ID3D12Re
 	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(colorGradingRenderPass.mOutputBuffers[0].Get(),
 		D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_GENERIC_READ));
 }
+
+void Renderer::ScheduleVoxelInjection(const InjectionView& injectionView, PassConstants& passConstants)
+{
+	PROFILE_SCOPE("Renderer::ScheduleVoxelInjection");
+
+	injectionChangeDetector.Detect(injectionView);
+
+	const std::vector<InjectionRect>& rects = injectionChangeDetector.GetRects();
+	passConstants.injectionRectCount = (UINT)rects.size();
+
+	for (UINT i = 0; i < InjectionChangeDetector::MaxRects; ++i)
+	{
+		passConstants.injectionRects[i] = i < rects.size() ? XMUINT4(rects[i].x, rects[i].y, rects[i].width, rects[i].height)
+			: XMUINT4(0, 0, 0, 0);
+	}
+
+	voxelInjectionRenderPass.injectionTileCount = injectionChangeDetector.GetTileCount();
+	voxelInjectionRenderPass.bReseedPackedGrid = injectionChangeDetector.HasSceneChanged();
+}
+
+void Renderer::ScheduleSHUpdates(const XMFLOAT4X4& view, PassConstants& passConstants)
+{
+	PROFILE_SCOPE("Renderer::ScheduleSHUpdates");
+
+	// The cells traced from the frame starting on see the injected voxels
+	if (injectionChangeDetector.HasSceneChanged() || voxelInjectionRenderPass.injectionTileCount > 0)
+		mLastInjectionFrame = shUpdateScheduler.GetFrame() + 1;
+
+	// A new light or scene changes the lighting everywhere
+	if (injectionChangeDetector.HasSceneChanged())
+	{
+		shUpdateScheduler.MarkAllChanged();
+	}
+	else if (voxelInjectionRenderPass.injectionTileCount > 0)
+	{
+		// Only around the voxels each injected rectangle sees, a turn exposes a thin wedge of the volume
+		for (uint32_t rect = 0; rect < (uint32_t)injectionChangeDetector.GetRects().size(); ++rect)
+		{
+			for (uint32_t slice = 0; slice < InjectionChangeDetector::DepthSlices; ++slice)
+			{
+				float boxMin[3], boxMax[3];
+
+				if (injectionChangeDetector.GetInjectedBounds(rect, slice, boxMin, boxMax))
+					shUpdateScheduler.MarkChanged(boxMin, boxMax);
+			}
+		}
+	}
+
+	// The eye is the translation of the inverse view
+	XMMATRIX viewMatrix = XMLoadFloat4x4(&view);
+	XMFLOAT4X4 invView;
+	XMStoreFloat4x4(&invView, XMMatrixInverse(&XMMatrixDeterminant(viewMatrix), viewMatrix));
+
+	const float eyePosition[3] = { invView._41, invView._42, invView._43 };
+	const UINT cellCount = shUpdateScheduler.Schedule(eyePosition, mScheduledCells);
+
+	passConstants.shUpdateCellCount = cellCount;
+
+	for (UINT i = 0; i < SHUpdateScheduler::MaxCellsPerFrame / 8; ++i)
+		passConstants.shUpdateCells[i] = XMUINT4(0, 0, 0, 0);
+
+	// Cell indices of the 8x8x8 grid fit in 16 bits
+	uint32_t* packedCells = &passConstants.shUpdateCells[0].x;
+
+	for (UINT i = 0; i < cellCount; ++i)
+		packedCells[i / 2] |= mScheduledCells[i] << ((i % 2) * 16);
+
+	shIndirectRenderPass.updateCellCount = cellCount;
+}
+
+bool Renderer::IsGIConverged()
+{
+	return shUpdateScheduler.IsTracedSince(mLastInjectionFrame);
+}
+
+GICacheKey Renderer::GetGICacheKey()
+{
+	GICacheKey key;
+	key.sceneName = SceneManager::GetScenePtr()->name;
+	key.contentHash = SceneManager::GetScenePtr()->contentHash;
+	key.worldBoundary = voxelInjectionRenderPass.worldVolumeBoundary;
+	key.voxelResolution = voxelInjectionRenderPass.voxelResolution;
+	key.voxelMipCount = Voxelizer::MipCount;
+	key.shGridResolution = shIndirectRenderPass.gridResolution;
+
+	return key;
+}
+
+GICacheStatus Renderer::RestoreGICache(ID3D12Device* device, ID3D12GraphicsCommandList* commandList, const std::string& filePath)
+{
+	PROFILE_SCOPE("Renderer::RestoreGICache");
+
+	GICacheStatus status = mGICache.Open(filePath, GetGICacheKey());
+
+	if (status != GICacheStatus::Loaded)
+		return status;
+
+	for (UINT i = 0; i < Voxelizer::MipCount + GICache::SHGridCount; ++i)
+	{
+		ID3D12Resource* resource = GetGICacheResource(i);
+		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(resource, 0, 1);
+
+		ThrowIfFailed(device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(mGICacheUploaders[i].GetAddressOf())));
+
+		// The texels are tightly packed in the file, so the rows are copied straight from the mapping
+		D3D12_SUBRESOURCE_DATA subResourceData = {};
+		subResourceData.pData = i < Voxelizer::MipCount ? mGICache.GetVoxelTexels(i) : mGICache.GetSHTexels(i - Voxelizer::MipCount);
+		subResourceData.RowPitch = (LONG_PTR)resource->GetDesc().Width * sizeof(uint32_t);
+		subResourceData.SlicePitch = subResourceData.RowPitch * resource->GetDesc().Height;
+
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource,
+			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST));
+		UpdateSubresources<1>(commandList, resource, mGICacheUploaders[i].Get(), 0, 0, 1, &subResourceData);
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource,
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+	}
+
+	return status;
+}
+
+void Renderer::ReleaseGICacheUploaders()
+{
+	for (UINT i = 0; i < Voxelizer::MipCount + GICache::SHGridCount; ++i)
+		mGICacheUploaders[i] = nullptr;
+
+	mGICache.Close();
+}
+
+void Renderer::RecordGICacheReadback(ID3D12Device* device, ID3D12GraphicsCommandList* commandList)
+{
+	for (UINT i = 0; i < Voxelizer::MipCount + GICache::SHGridCount; ++i)
+	{
+		ID3D12Resource* resource = GetGICacheResource(i);
+
+		const D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
+
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+		UINT64 readbackBufferSize = 0;
+		device->GetCopyableFootprints(&resourceDesc, 0, 1, 0, &footprint, nullptr, nullptr, &readbackBufferSize);
+
+		ThrowIfFailed(device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(readbackBufferSize),
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(mGICacheReadbacks[i].ReleaseAndGetAddressOf())));
+
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource,
+			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_SOURCE));
+		commandList->CopyTextureRegion(&CD3DX12_TEXTURE_COPY_LOCATION(mGICacheReadbacks[i].Get(), footprint), 0, 0, 0,
+			&CD3DX12_TEXTURE_COPY_LOCATION(resource, 0), nullptr);
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource,
+			D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_GENERIC_READ));
+	}
+}
+
+bool Renderer::SaveGICache(const std::string& filePath)
+{
+	PROFILE_SCOPE("Renderer::SaveGICache");
+
+	const GICacheKey key = GetGICacheKey();
+
+	VoxelGrid voxelGrids[Voxelizer::MipCount];
+	VoxelGrid shGrids[GICache::SHGridCount];
+
+	if (!CopyGICacheReadback(voxelGrids, shGrids))
+		return false;
+
+	return GICache::Save(filePath, key, voxelGrids, shGrids);
+}
+
+bool Renderer::AddGIStatisticsFrame(const SHBakeSettings& settings)
+{
+	PROFILE_SCOPE("Renderer::AddGIStatisticsFrame");
+
+	VoxelGrid voxelGrids[Voxelizer::MipCount];
+	VoxelGrid shGrids[GICache::SHGridCount];
+
+	if (!CopyGICacheReadback(voxelGrids, shGrids))
+		return false;
+
+	giStatistics.AddFrame(settings, voxelGrids, shGrids, VoxelInjectionStatistics());
+
+	return true;
+}
+
+ID3D12Resource* Renderer::GetGICacheResource(UINT index)
+{
+	if (index < Voxelizer::MipCount)
+		return voxelInjectionRenderPass.mOutputBuffers[index].Get();
+
+	return shIndirectRenderPass.mOutputBuffers[index - Voxelizer::MipCount].Get();
+}
+
+bool Renderer::CopyGICacheReadback(VoxelGrid* voxelGrids, VoxelGrid* shGrids)
+{
+	for (UINT i = 0; i < Voxelizer::MipCount + GICache::SHGridCount; ++i)
+	{
+		if (mGICacheReadbacks[i] == nullptr)
+			return false;
+
+		VoxelGrid& grid = i < Voxelizer::MipCount ? voxelGrids[i] : shGrids[i - Voxelizer::MipCount];
+		grid.Reset((uint32_t)GetGICacheResource(i)->GetDesc().Width);
+
+		// Rows of the readback buffer are padded to the copy pitch alignment
+		const UINT rowPitch = (grid.GetResolution() * sizeof(uint32_t) + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1)
+			/ D3D12_TEXTURE_DATA_PITCH_ALIGNMENT * D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+		const UINT rowCount = grid.GetResolution() * grid.GetResolution();
+
+		BYTE* mappedData = nullptr;
+		ThrowIfFailed(mGICacheReadbacks[i]->Map(0, &CD3DX12_RANGE(0, (SIZE_T)rowPitch * rowCount), reinterpret_cast<void**>(&mappedData)));
+
+		for (UINT row = 0; row < rowCount; ++row)
+			memcpy(grid.GetTexels() + (size_t)row * grid.GetResolution(), mappedData + (size_t)row * rowPitch, grid.GetResolution() * sizeof(uint32_t));
+
+		mGICacheReadbacks[i]->Unmap(0, &CD3DX12_RANGE(0, 0));
+		mGICacheReadbacks[i] = nullptr;
+	}
+
+	return true;
+}
@@ -10,6 +10,9 @@
 #include "FXAARenderPass.h"
 #include "ToneMappingRenderPass.h"
 #include "ColorGradingRenderPass.h"
+#include "GpuProfiler.h"
+#include "../Utilities/GICache.h"
+#include "../Utilities/GIStatistics.h"
 
 class Renderer
 {
@@ -19,8 +22,37 @@ public:
 
 	static void Initialize(ComPtr<ID3D12Device>, int, int, DXGI_FORMAT, DXGI_FORMAT);
 	static void Execute(ID3D12GraphicsCommandList*, D3D12_CPU_DESCRIPTOR_HANDLE*, FrameResource*);
+	static void ExecutePass(RenderPass&, const char*, ID3D12GraphicsCommandList*, D3D12_CPU_DESCRIPTOR_HANDLE*, FrameResource*);
 	static void CopyToBackBuffer(ID3D12GraphicsCommandList*, ID3D12Resource*);
 
+	// Picks the part of the screen injected into the voxel grids this frame and writes its rectangles
+	// to the pass constants. Call before ScheduleSHUpdates().
+	static void ScheduleVoxelInjection(const InjectionView&, PassConstants&);
+
+	// Picks the SH grid cells cone traced this frame and writes them to the pass constants, from the
+	// view, not transposed. When injection runs, the cells around the voxels its rectangles see count
+	// as changed.
+	static void ScheduleSHUpdates(const XMFLOAT4X4&, PassConstants&);
+
+	// Whether every SH cell was cone traced since the voxels last changed, so the grids are worth saving
+	static bool IsGIConverged();
+
+	// The current scene and the grid settings of the voxel and SH passes
+	static GICacheKey GetGICacheKey();
+	// Records the upload of the voxel and SH grids of a cache file matching the key, copied straight
+	// from the file mapping. Call with the initialization command list, the grids aren't seeded when
+	// it returns Loaded.
+	static GICacheStatus RestoreGICache(ID3D12Device*, ID3D12GraphicsCommandList*, const std::string&);
+	// Frees the upload buffers and the mapping once the initialization command list has been executed
+	static void ReleaseGICacheUploaders();
+	// Records copies of the voxel and SH grids into readback buffers
+	static void RecordGICacheReadback(ID3D12Device*, ID3D12GraphicsCommandList*);
+	// Writes the grids read back to a cache file once the copies executed, and frees the buffers
+	static bool SaveGICache(const std::string&);
+	// Adds the grids read back to giStatistics once the copies executed, and frees the buffers. The
+	// shader doesn't count its injections, the frame has none.
+	static bool AddGIStatisticsFrame(const SHBakeSettings&);
+
 	static ShadowMapRenderPass shadowMapRenderPass;
 	static DirectLightingRenderPass directLightingRenderPass;
 	static VoxelInjectionRenderPass voxelInjectionRenderPass;
@@ -32,6 +64,24 @@ public:
 	static ToneMappingRenderPass toneMappingRenderPass;
 	static ColorGradingRenderPass colorGradingRenderPass;
 
-	static bool bPerformConeTracing;
 	static bool bPerformShadowMapping;
+
+	static SHUpdateScheduler shUpdateScheduler;
+	static InjectionChangeDetector injectionChangeDetector;
+	static GIStatistics giStatistics;
+
+private:
+
+	// The voxel grids followed by the SH grids
+	static ID3D12Resource* GetGICacheResource(UINT);
+	// Copies the grids out of the readback buffers and frees them, false if nothing was read back
+	static bool CopyGICacheReadback(VoxelGrid*, VoxelGrid*);
+
+	static std::vector<uint32_t> mScheduledCells;
+	// Scheduler frame of the last voxel injection
+	static uint32_t mLastInjectionFrame;
+
+	static GICache mGICache;
+	static ComPtr<ID3D12Resource> mGICacheUploaders[Voxelizer::MipCount + GICache::SHGridCount];
+	static ComPtr<ID3D12Resource> mGICacheReadbacks[Voxelizer::MipCount + GICache::SHGridCount];
 };
\ No newline at end of file
@@ -3,7 +3,10 @@
 void SHIndirectRenderPass::Execute(ID3D12GraphicsCommandList * commandList, D3D12_CPU_DESCRIPTOR_HANDLE * depthStencilViewPtr,
 	FrameResource* mCurrFrameResource)
 {
-	DISPATCH_COMPUTE(5, 3, (gridResolution / 4), (gridResolution / 4), (gridResolution / 4))
+	if (updateCellCount == 0)
+		return;
+
+	DISPATCH_COMPUTE(5, 3, ((updateCellCount + 63) / 64), 1, 1)
 }
 
 void SHIndirectRenderPass::Draw(ID3D12GraphicsCommandList *, ID3D12Resource *, ID3D12Resource *)
@@ -23,17 +26,17 @@ void SHIndirectRenderPass::BuildDescriptorHeaps()
 		D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, gridResolution, gridResolution, gridResolution)
 
 	for (int i = 0; i < 3; ++i)
-		CREATE_OUTPUT_BUFFER_RESOURCE(nullptr)
+		CREATE_OUTPUT_BUFFER_RESOURCE(nullptr, MemoryCategory::VoxelGrids)
 	
 	//
-	// Create the SRV and UAV heap.
+	// Allocate the SRV and UAV table in the global heap.
 	//
-	CREATE_SRV_UAV_HEAP(8)
+	ALLOCATE_SRV_UAV_DESCRIPTORS(8)
 
 	//
-	// Fill out the heap with texture descriptors.
+	// Fill out the table with texture descriptors.
 	//
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(GlobalDescriptorHeap::GetCpuHandle(mSrvDescriptors));
 
 	UINT cbvSrvUavDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
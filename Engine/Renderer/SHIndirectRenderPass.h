@@ -12,6 +12,8 @@ public:
 	UINT gridResolution = 8;
 	float worldVolumeBoundary = 50.0f;
 	UINT voxelResolution = 128;
+	// Cells Renderer::ScheduleSHUpdates picked for this frame
+	UINT updateCellCount = 0;
 
 protected:
 	virtual void BuildRootSignature() override;
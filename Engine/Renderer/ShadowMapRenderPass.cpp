@@ -39,7 +39,7 @@ void ShadowMapRenderPass::Draw(ID3D12GraphicsCommandList* commandList, ID3D12Res
 
 	for (size_t i = 0; i < SceneManager::GetScenePtr()->numberOfObjects; ++i)
 	{
-		SceneManager::GetScenePtr()->mOpaqueRObjects[i]->Draw(commandList, objectCB, matCB, mSrvDescriptorHeap, cbvSrvDescriptorSize, objCBByteSize, matCBByteSize, true);
+		SceneManager::GetScenePtr()->mOpaqueRObjects[i].Draw(commandList, objectCB, matCB, D3D12_GPU_DESCRIPTOR_HANDLE(), cbvSrvDescriptorSize, objCBByteSize, matCBByteSize, true);
 	}
 }
 
@@ -109,6 +109,8 @@ void ShadowMapRenderPass::BuildDescriptorHeaps()
 		&optClear,
 		IID_PPV_ARGS(mOutputBuffers[0].GetAddressOf())));
 
+	d3dUtil::TrackResource(md3dDevice.Get(), mOutputBuffers[0].Get(), MemoryCategory::PassOutputs);
+
 	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
 	dsvHeapDesc.NumDescriptors = 1;
 	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
@@ -3,21 +3,148 @@
 void VoxelInjectionRenderPass::Execute(ID3D12GraphicsCommandList * commandList, D3D12_CPU_DESCRIPTOR_HANDLE * depthStencilViewPtr,
 	FrameResource* mCurrFrameResource)
 {
-	DISPATCH_COMPUTE(2, 5, (mClientWidth / 16), (mClientHeight / 16), 1)
+	// Nothing new to inject, the grids and so their downsampled mips stay as they are
+	if (injectionTileCount == 0)
+		return;
+
+	// The atomic max only raises a voxel, a darker or farther pixel can't replace what an earlier light
+	// or scene left
+	if (bReseedPackedGrid)
+		DispatchOverPackedGrid(commandList, mReseedPSO.Get());
+
+	DISPATCH_COMPUTE(2, 6, injectionTileCount, 1, 1)
+
+	// Only the packed grid is injected, it is resolved into the finest grid and each coarser one is
+	// reduced from the one before it
+	for (int i = 0; i < 6; ++i)
+	{
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[i].Get(),
+			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+	}
+
+	commandList->SetPipelineState(mResolvePSO.Get());
+	commandList->Dispatch(voxelResolution / 4, voxelResolution / 4, voxelResolution / 4);
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(mOutputBuffers[0].Get()));
+
+	for (int i = 1; i < 5; ++i)
+	{
+		UINT groupCount = std::max((voxelResolution >> i) / 4, 1u);
+
+		commandList->SetPipelineState(mDownsamplePSOs[i - 1].Get());
+		commandList->Dispatch(groupCount, groupCount, groupCount);
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(mOutputBuffers[i].Get()));
+	}
+
+	for (int i = 0; i < 6; ++i)
+	{
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[i].Get(),
+			D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ));
+	}
+}
+
+void VoxelInjectionRenderPass::SeedVoxelGrids(ID3D12GraphicsCommandList* commandList)
+{
+	PROFILE_SCOPE("VoxelInjectionRenderPass::SeedVoxelGrids");
+
+	Voxelizer voxelizer;
+	voxelizer.Reset(voxelResolution, worldVolumeBoundary);
+	SceneManager::VoxelizeScene(voxelizer);
+
+	VoxelGrid grids[Voxelizer::MipCount];
+	voxelizer.Voxelize(grids);
+
+	// The seeds are the albedo under a dim share of the sun. They are as far away as possible, any pixel
+	// seen is nearer and replaces them.
+	const float seedLightFactor = 0.1f;
+	const XMFLOAT3 lightStrength = SceneManager::GetScenePtr()->lightStrength;
+
+	for (int i = 0; i < Voxelizer::MipCount; ++i)
+	{
+		std::vector<uint32_t> texels(grids[i].GetTexels(), grids[i].GetTexels() + grids[i].GetTexelCount());
+
+		for (uint32_t& texel : texels)
+		{
+			if ((texel >> 24) == 0)
+				continue;
+
+			texel = VoxelGrid::Pack(VoxelGrid::Unpack(texel, 0) * lightStrength.x * seedLightFactor,
+				VoxelGrid::Unpack(texel, 1) * lightStrength.y * seedLightFactor,
+				VoxelGrid::Unpack(texel, 2) * lightStrength.z * seedLightFactor, 1.0f);
+		}
+
+		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(mOutputBuffers[i].Get(), 0, 1);
+
+		ThrowIfFailed(md3dDevice->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(mSeedUploaders[i].GetAddressOf())));
+
+		D3D12_SUBRESOURCE_DATA subResourceData = {};
+		subResourceData.pData = texels.data();
+		subResourceData.RowPitch = (LONG_PTR)grids[i].GetResolution() * sizeof(uint32_t);
+		subResourceData.SlicePitch = subResourceData.RowPitch * grids[i].GetResolution();
+
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[i].Get(),
+			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST));
+		UpdateSubresources<1>(commandList, mOutputBuffers[i].Get(), mSeedUploaders[i].Get(), 0, 0, 1, &subResourceData);
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[i].Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+	}
+}
+
+void VoxelInjectionRenderPass::ReleaseSeedUploaders()
+{
+	for (int i = 0; i < Voxelizer::MipCount; ++i)
+		mSeedUploaders[i] = nullptr;
+}
+
+void VoxelInjectionRenderPass::PackVoxelGrid(ID3D12GraphicsCommandList* commandList)
+{
+	GlobalDescriptorHeap::SetHeap(commandList);
+
+	DispatchOverPackedGrid(commandList, mPackPSO.Get());
 }
 
 void VoxelInjectionRenderPass::Draw(ID3D12GraphicsCommandList *, ID3D12Resource *, ID3D12Resource *)
 {
 }
 
+void VoxelInjectionRenderPass::DispatchOverPackedGrid(ID3D12GraphicsCommandList* commandList, ID3D12PipelineState* pso)
+{
+	UINT cbvSrvUavDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[0].Get(),
+		D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[5].Get(),
+		D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+
+	commandList->SetPipelineState(pso);
+	commandList->SetComputeRootSignature(mRootSignature.Get());
+
+	CD3DX12_GPU_DESCRIPTOR_HANDLE tex(GlobalDescriptorHeap::GetGpuHandle(mSrvDescriptors));
+	commandList->SetComputeRootDescriptorTable(1, tex);
+	tex.Offset(2, cbvSrvUavDescriptorSize);
+	commandList->SetComputeRootDescriptorTable(2, tex);
+
+	commandList->Dispatch(voxelResolution / 4, voxelResolution / 4, voxelResolution / 4);
+
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[0].Get(),
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ));
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[5].Get(),
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ));
+}
+
 void VoxelInjectionRenderPass::BuildRootSignature()
 {
-	SETUP_COMPUTE_ROOT_SIGNATURE(2, 5)
+	SETUP_COMPUTE_ROOT_SIGNATURE(2, 6)
 }
 
 void VoxelInjectionRenderPass::BuildDescriptorHeaps()
 {
-	mOutputBuffers = new ComPtr<ID3D12Resource>[5];
+	mOutputBuffers = new ComPtr<ID3D12Resource>[6];
 
 	CREATE_OUTPUT_BUFFER_DESC(D3D12_RESOURCE_DIMENSION_TEXTURE3D, DXGI_FORMAT_R8G8B8A8_UNORM,
 		D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, voxelResolution, voxelResolution, voxelResolution)
@@ -28,20 +155,31 @@ void VoxelInjectionRenderPass::BuildDescriptorHeaps()
 		texDesc.Height = voxelResolution / ((int)(pow(2, i)));
 		texDesc.DepthOrArraySize = voxelResolution / ((int)(pow(2, i)));
 
-		CREATE_OUTPUT_BUFFER_RESOURCE(nullptr)
+		CREATE_OUTPUT_BUFFER_RESOURCE(nullptr, MemoryCategory::VoxelGrids)
+	}
+
+	// The finest grid packed for the injection's atomic max
+	texDesc.Format = DXGI_FORMAT_R32_UINT;
+	texDesc.Width = voxelResolution;
+	texDesc.Height = voxelResolution;
+	texDesc.DepthOrArraySize = voxelResolution;
+
+	for (int i = 5; i < 6; ++i)
+	{
+		CREATE_OUTPUT_BUFFER_RESOURCE(nullptr, MemoryCategory::VoxelGrids)
 	}
 
 	//
-	// Create the SRV and UAV heap.
+	// Allocate the SRV and UAV table in the global heap.
 	//
-	CREATE_SRV_UAV_HEAP(7)
+	ALLOCATE_SRV_UAV_DESCRIPTORS(8)
 
 	//
-	// Fill out the heap with texture descriptors.
+	// Fill out the table with texture descriptors.
 	//
 	UINT cbvSrvUavDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(GlobalDescriptorHeap::GetCpuHandle(mSrvDescriptors));
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -76,9 +214,70 @@ void VoxelInjectionRenderPass::BuildDescriptorHeaps()
 
 		CREATE_UAV(cbvSrvUavDescriptorSize)
 	}
+
+	uavDesc.Format = DXGI_FORMAT_R32_UINT;
+	uavDesc.Texture3D.WSize = voxelResolution;
+
+	for (int i = 5; i < 6; ++i)
+	{
+		CREATE_UAV(cbvSrvUavDescriptorSize)
+	}
 }
 
 void VoxelInjectionRenderPass::BuildPSOs()
 {
 	SETUP_COMPUTE_PSO()
+
+	const char* gridNames[] = { "voxelGrid0", "voxelGrid1", "voxelGrid2", "voxelGrid3", "voxelGrid4" };
+
+	for (int i = 1; i < 5; ++i)
+	{
+		const D3D_SHADER_MACRO defines[] =
+		{
+			"SOURCE_GRID", gridNames[i - 1],
+			"DESTINATION_GRID", gridNames[i],
+			"FINEST_SOURCE", i == 1 ? "1" : "0",
+			nullptr, nullptr
+		};
+
+		mDownsampleShaders[i - 1] = d3dUtil::CompileShader(L"../Assets/Shaders/VoxelDownsample.hlsl", defines, "CS", "cs_5_0");
+
+		computePSODesc.CS =
+		{
+			reinterpret_cast<BYTE*>(mDownsampleShaders[i - 1]->GetBufferPointer()),
+			mDownsampleShaders[i - 1]->GetBufferSize()
+		};
+
+		ThrowIfFailed(md3dDevice->CreateComputePipelineState(&computePSODesc, IID_PPV_ARGS(&mDownsamplePSOs[i - 1])));
+	}
+
+	mResolveShader = d3dUtil::CompileShader(L"../Assets/Shaders/VoxelInjection.hlsl", nullptr, "ResolveCS", "cs_5_0");
+
+	computePSODesc.CS =
+	{
+		reinterpret_cast<BYTE*>(mResolveShader->GetBufferPointer()),
+		mResolveShader->GetBufferSize()
+	};
+
+	ThrowIfFailed(md3dDevice->CreateComputePipelineState(&computePSODesc, IID_PPV_ARGS(&mResolvePSO)));
+
+	mPackShader = d3dUtil::CompileShader(L"../Assets/Shaders/VoxelInjection.hlsl", nullptr, "PackCS", "cs_5_0");
+
+	computePSODesc.CS =
+	{
+		reinterpret_cast<BYTE*>(mPackShader->GetBufferPointer()),
+		mPackShader->GetBufferSize()
+	};
+
+	ThrowIfFailed(md3dDevice->CreateComputePipelineState(&computePSODesc, IID_PPV_ARGS(&mPackPSO)));
+
+	mReseedShader = d3dUtil::CompileShader(L"../Assets/Shaders/VoxelInjection.hlsl", nullptr, "ReseedCS", "cs_5_0");
+
+	computePSODesc.CS =
+	{
+		reinterpret_cast<BYTE*>(mReseedShader->GetBufferPointer()),
+		mReseedShader->GetBufferSize()
+	};
+
+	ThrowIfFailed(md3dDevice->CreateComputePipelineState(&computePSODesc, IID_PPV_ARGS(&mReseedPSO)));
 }
\ No newline at end of file
@@ -7,14 +7,45 @@ class VoxelInjectionRenderPass : public RenderPass
 public:
 	VoxelInjectionRenderPass() = default;
 	virtual void Execute(ID3D12GraphicsCommandList*, D3D12_CPU_DESCRIPTOR_HANDLE*, FrameResource*) override;
+	// Records the upload of the current scene's static geometry voxelized, so cone tracing finds every
+	// surface before the camera has seen it. Call with the initialization command list, before the
+	// scene's uploaders are disposed.
+	void SeedVoxelGrids(ID3D12GraphicsCommandList*);
+	// Frees the upload buffers once the initialization command list has been executed
+	void ReleaseSeedUploaders();
+	// Records the packing of the finest grid into the grid injection takes the atomic max into, after it
+	// was seeded or restored from the GI cache. Every injection resolves the packed grid back into it.
+	void PackVoxelGrid(ID3D12GraphicsCommandList*);
 	~VoxelInjectionRenderPass() = default;
 
 	UINT voxelResolution = 64;
 	float worldVolumeBoundary = 50.0f;
+	// Tiles Renderer::ScheduleVoxelInjection picked for this frame, none skips the pass
+	UINT injectionTileCount = 0;
+	// Set by Renderer::ScheduleVoxelInjection when the light or the scene changed, the packed grid is
+	// reseeded before injecting so the new colors replace the old ones
+	bool bReseedPackedGrid = false;
 	
 protected:
 	virtual void BuildRootSignature() override;
 	virtual void BuildDescriptorHeaps() override;
 	virtual void BuildPSOs() override;
 	virtual void Draw(ID3D12GraphicsCommandList*, ID3D12Resource*, ID3D12Resource*) override;
+
+	// A thread per voxel of the finest grid, with it and the packed grid as UAVs
+	void DispatchOverPackedGrid(ID3D12GraphicsCommandList*, ID3D12PipelineState*);
+
+	ComPtr<ID3D12Resource> mSeedUploaders[Voxelizer::MipCount];
+
+	// One per coarser grid, reducing the grid before it
+	ComPtr<ID3DBlob> mDownsampleShaders[Voxelizer::MipCount - 1];
+	ComPtr<ID3D12PipelineState> mDownsamplePSOs[Voxelizer::MipCount - 1];
+
+	// Between the packed grid, the last output buffer, and the finest grid
+	ComPtr<ID3DBlob> mResolveShader;
+	ComPtr<ID3D12PipelineState> mResolvePSO;
+	ComPtr<ID3DBlob> mPackShader;
+	ComPtr<ID3D12PipelineState> mPackPSO;
+	ComPtr<ID3DBlob> mReseedShader;
+	ComPtr<ID3D12PipelineState> mReseedPSO;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <d3d12.h>
+#include <DirectXMath.h>
 #include <wrl.h>
 
 // Defines a subrange of geometry in a MeshGeometry.  This is for when multiple
@@ -14,6 +15,11 @@ struct SubmeshGeometry
 	UINT IndexCount = 0;
 	UINT StartIndexLocation = 0;
 	INT BaseVertexLocation = 0;
+
+	// Object space bounds and texture density, for estimating the mips the mesh needs on screen
+	DirectX::XMFLOAT3 BoundsCenter = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+	float BoundsRadius = 0.0f;
+	float UVDensity = 0.0f;
 };
 
 class MeshGeometry
@@ -1,5 +1,8 @@
 #include "MeshLoader.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace DirectX;
  
 MeshLoader::MeshData MeshLoader::CreateQuad()
@@ -78,4 +81,59 @@ MeshLoader::MeshData MeshLoader::LoadModel(std::string modelName)
 	inputFile.close();
 
 	return meshData;
+}
+
+float MeshLoader::ComputeUVDensity(const MeshData& meshData)
+{
+	double surfaceArea = 0.0;
+	double uvArea = 0.0;
+
+	for (size_t i = 0; i + 2 < meshData.Indices32.size(); i += 3)
+	{
+		const Vertex& v0 = meshData.Vertices[meshData.Indices32[i + 0]];
+		const Vertex& v1 = meshData.Vertices[meshData.Indices32[i + 1]];
+		const Vertex& v2 = meshData.Vertices[meshData.Indices32[i + 2]];
+
+		double e1[3] = { v1.Position.x - v0.Position.x, v1.Position.y - v0.Position.y, v1.Position.z - v0.Position.z };
+		double e2[3] = { v2.Position.x - v0.Position.x, v2.Position.y - v0.Position.y, v2.Position.z - v0.Position.z };
+
+		double cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+		surfaceArea += 0.5 * std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+		uvArea += 0.5 * std::fabs((v1.TexC.x - v0.TexC.x) * (v2.TexC.y - v0.TexC.y) - (v2.TexC.x - v0.TexC.x) * (v1.TexC.y - v0.TexC.y));
+	}
+
+	if (surfaceArea <= 0.0)
+		return 0.0f;
+
+	return (float)std::sqrt(uvArea / surfaceArea);
+}
+
+void MeshLoader::ComputeBoundingSphere(const MeshData& meshData, XMFLOAT3& center, float& radius)
+{
+	center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	radius = 0.0f;
+
+	if (meshData.Vertices.empty())
+		return;
+
+	XMFLOAT3 minimum = meshData.Vertices[0].Position;
+	XMFLOAT3 maximum = meshData.Vertices[0].Position;
+
+	for (const Vertex& vertex : meshData.Vertices)
+	{
+		minimum = XMFLOAT3(std::min(minimum.x, vertex.Position.x), std::min(minimum.y, vertex.Position.y), std::min(minimum.z, vertex.Position.z));
+		maximum = XMFLOAT3(std::max(maximum.x, vertex.Position.x), std::max(maximum.y, vertex.Position.y), std::max(maximum.z, vertex.Position.z));
+	}
+
+	center = XMFLOAT3(0.5f * (minimum.x + maximum.x), 0.5f * (minimum.y + maximum.y), 0.5f * (minimum.z + maximum.z));
+
+	for (const Vertex& vertex : meshData.Vertices)
+	{
+		float dx = vertex.Position.x - center.x;
+		float dy = vertex.Position.y - center.y;
+		float dz = vertex.Position.z - center.z;
+
+		radius = std::max(radius, std::sqrt(dx * dx + dy * dy + dz * dz));
+	}
 }
\ No newline at end of file
@@ -67,5 +67,11 @@ public:
 	static MeshData CreateQuad();
 	static MeshData LoadModel(std::string modelName);
 
+	// Texture coordinate units per object space unit, the square root of the ratio of the UV area to
+	// the surface area of the triangles. Tells how many texels cover a unit of the surface.
+	static float ComputeUVDensity(const MeshData&);
+	// Sphere around the bounding box of the vertices
+	static void ComputeBoundingSphere(const MeshData&, DirectX::XMFLOAT3&, float&);
+
 };
 
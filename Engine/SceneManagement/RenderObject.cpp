@@ -1,11 +1,11 @@
 #include "RenderObject.h"
 
 void RenderObject::Draw(ID3D12GraphicsCommandList* cmdList, ID3D12Resource* objectCB, ID3D12Resource* matCB, 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> srvDescriptorHeap, UINT cbvSrvDescriptorSize, UINT objCBByteSize, UINT matCBByteSize, bool isShadowPass)
+	D3D12_GPU_DESCRIPTOR_HANDLE srvTable, UINT cbvSrvDescriptorSize, UINT objCBByteSize, UINT matCBByteSize, bool isShadowPass)
 {
 	if (isPostProcessingQuad)
 	{
-		DrawQuad(cmdList, srvDescriptorHeap);
+		DrawQuad(cmdList, srvTable);
 	}
 	else
 	{
@@ -20,7 +20,7 @@ void RenderObject::Draw(ID3D12GraphicsCommandList* cmdList, ID3D12Resource* obje
 		}
 		else
 		{
-			CD3DX12_GPU_DESCRIPTOR_HANDLE tex(srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+			CD3DX12_GPU_DESCRIPTOR_HANDLE tex(srvTable);
 			tex.Offset(Mat->DiffuseSrvHeapIndex, cbvSrvDescriptorSize);
 
 			D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCB->GetGPUVirtualAddress() + ObjCBIndex * objCBByteSize;
@@ -63,6 +63,11 @@ UINT RenderObject::GetObjCBIndex()
 	return ObjCBIndex;
 }
 
+Material * RenderObject::GetMat()
+{
+	return Mat;
+}
+
 void RenderObject::SetObjCBIndex(UINT input)
 {
 	ObjCBIndex = input;
@@ -113,15 +118,13 @@ void RenderObject::DecrementNumFramesDirty()
 	--NumFramesDirty;
 }
 
-void RenderObject::DrawQuad(ID3D12GraphicsCommandList * cmdList, Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> srvDescriptorHeap)
+void RenderObject::DrawQuad(ID3D12GraphicsCommandList * cmdList, D3D12_GPU_DESCRIPTOR_HANDLE srvTable)
 {
 	cmdList->IASetVertexBuffers(0, 1, &(Geo->VertexBufferView()));
 	cmdList->IASetIndexBuffer(&(Geo->IndexBufferView()));
 	cmdList->IASetPrimitiveTopology(PrimitiveType);
 
-	CD3DX12_GPU_DESCRIPTOR_HANDLE tex(srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-	
-	cmdList->SetGraphicsRootDescriptorTable(0, tex);
+	cmdList->SetGraphicsRootDescriptorTable(0, srvTable);
 	
 	cmdList->DrawIndexedInstanced(IndexCount, 1, StartIndexLocation, BaseVertexLocation, 0);
 }
\ No newline at end of file
@@ -13,13 +13,14 @@ public:
 	RenderObject() = default;
 	
 	void Draw(ID3D12GraphicsCommandList*, ID3D12Resource*, ID3D12Resource*, 
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>, UINT, UINT, UINT, bool);
+		D3D12_GPU_DESCRIPTOR_HANDLE, UINT, UINT, UINT, bool);
 
 	void InitializeAsQuad(MeshGeometry*, UINT);
 	
 	int GetNumFramesDirty();
 	XMFLOAT4X4* GetWorldMatrixPtr();
 	UINT GetObjCBIndex();
+	Material* GetMat();
 
 	void SetObjCBIndex(UINT);
 	void SetMat(Material*);
@@ -37,7 +38,7 @@ public:
 
 private:
 
-	void DrawQuad(ID3D12GraphicsCommandList*, Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>);
+	void DrawQuad(ID3D12GraphicsCommandList*, D3D12_GPU_DESCRIPTOR_HANDLE);
 	
 	// World matrix of the shape that describes the object's local space
 	// relative to the world space, which defines the position, orientation,
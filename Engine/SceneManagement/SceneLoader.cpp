@@ -0,0 +1,62 @@
+#include "SceneLoader.h"
+
+#include <fstream>
+
+bool SceneLoader::LoadSceneDescription(const std::string& sceneFilePath, SceneDescription& description)
+{
+	std::ifstream inputFile;
+	inputFile.open(sceneFilePath, std::fstream::in);
+
+	if (!inputFile.is_open())
+		return false;
+
+	std::uint32_t numberOfObjects = 0;
+
+	inputFile >> description.name;
+	inputFile >> description.cameraPosition.x >> description.cameraPosition.y >> description.cameraPosition.z;
+	inputFile >> description.cameraRotation.x >> description.cameraRotation.y >> description.cameraRotation.z >> description.cameraRotation.w;
+	inputFile >> description.lightDirection.x >> description.lightDirection.y >> description.lightDirection.z;
+	inputFile >> description.lightStrength.x >> description.lightStrength.y >> description.lightStrength.z;
+	inputFile >> numberOfObjects;
+
+	description.objects.resize(numberOfObjects);
+	description.numberOfUniqueObjects = 0;
+
+	std::vector<std::string> objectMeshNames;
+
+	for (std::uint32_t i = 0; i < numberOfObjects; ++i)
+	{
+		SceneObject& sceneObject = description.objects[i];
+
+		inputFile >> sceneObject.meshName;
+		inputFile >> sceneObject.diffuseOpacityTextureName;
+		inputFile >> sceneObject.normalRoughnessTextureName;
+		inputFile >> sceneObject.position.x >> sceneObject.position.y >> sceneObject.position.z;
+		inputFile >> sceneObject.rotation.x >> sceneObject.rotation.y >> sceneObject.rotation.z >> sceneObject.rotation.w;
+		inputFile >> sceneObject.scale.x >> sceneObject.scale.y >> sceneObject.scale.z;
+
+		bool isAlreadyPresent = false;
+
+		for (size_t j = 0; j < objectMeshNames.size(); ++j)
+		{
+			if (objectMeshNames[j] == sceneObject.meshName)
+			{
+				isAlreadyPresent = true;
+				break;
+			}
+		}
+
+		if (!isAlreadyPresent)
+		{
+			objectMeshNames.push_back(sceneObject.meshName);
+			++description.numberOfUniqueObjects;
+		}
+	}
+
+	// A truncated file leaves the stream in a failed state
+	bool isValid = !inputFile.fail();
+
+	inputFile.close();
+
+	return isValid;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+struct SceneObject
+{
+	SceneObject() = default;
+
+	std::string					meshName;
+	std::string					diffuseOpacityTextureName;
+	std::string					normalRoughnessTextureName;
+	DirectX::XMFLOAT3			position;
+	DirectX::XMFLOAT4			rotation;
+	DirectX::XMFLOAT3			scale;
+};
+
+// Contents of a scene file, before any GPU resources are created for it
+struct SceneDescription
+{
+	SceneDescription() = default;
+
+	std::string					name;
+	DirectX::XMFLOAT3			cameraPosition;
+	DirectX::XMFLOAT4			cameraRotation;
+	DirectX::XMFLOAT3			lightDirection;
+	DirectX::XMFLOAT3			lightStrength;
+	std::uint32_t				numberOfUniqueObjects = 0;
+
+	std::vector<SceneObject>	objects;
+};
+
+class SceneLoader
+{
+public:
+	SceneLoader() = default;
+
+	// Parses a scene file exported from the Unity level editor. Returns false if the file could not be read.
+	static bool LoadSceneDescription(const std::string&, SceneDescription&);
+
+	~SceneLoader() = default;
+};
@@ -1,10 +1,69 @@
 #include "SceneManager.h"
+#include "../Utilities/BCDecoder.h"
+#include "../Utilities/GICache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+namespace
+{
+	// Average of the smallest mip of a diffuse texture, in the linear space the shader lights in.
+	// Grey when the file can't be read.
+	XMFLOAT3 GetAverageAlbedo(const std::wstring& filename)
+	{
+		// The asset paths are plain ASCII
+		std::string filePath;
+
+		for (wchar_t character : filename)
+			filePath += (char)character;
+
+		DDSImage image;
+
+		if (!image.Load(filePath) || image.GetDescription().mipCount == 0)
+			return XMFLOAT3(0.5f, 0.5f, 0.5f);
+
+		const DDSDescription& description = image.GetDescription();
+		const DDSSubresource& subresource = image.GetSubresource(description.mipCount - 1, 0);
+
+		std::vector<uint8_t> texels((size_t)subresource.width * subresource.height * 4);
+
+		if (description.format == DXGI_FORMAT_R8G8B8A8_UNORM || description.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+		{
+			for (uint32_t row = 0; row < subresource.height; ++row)
+				memcpy(&texels[(size_t)row * subresource.width * 4], subresource.data + row * subresource.rowPitch, (size_t)subresource.width * 4);
+		}
+		else if (!BCDecoder::DecodeSurface(subresource, description.format, texels.data(), (size_t)subresource.width * 4))
+		{
+			return XMFLOAT3(0.5f, 0.5f, 0.5f);
+		}
+
+		float sums[3] = { 0.0f, 0.0f, 0.0f };
+
+		for (size_t i = 0; i < texels.size(); i += 4)
+		{
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				sums[channel] += std::pow(texels[i + channel] / 255.0f, 2.2f);
+		}
+
+		float texelCount = (float)(texels.size() / 4);
+
+		return XMFLOAT3(sums[0] / texelCount, sums[1] / texelCount, sums[2] / texelCount);
+	}
+}
 
 Scene SceneManager::mScene;
+MemoryArena SceneManager::mSceneArena;
+ObjectPool<Texture> SceneManager::mTexturePool;
 
 void SceneManager::LoadScene(std::string sceneFilePath, Microsoft::WRL::ComPtr<ID3D12Device> md3dDevice,
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCommandList)
 {
+	PROFILE_SCOPE("SceneManager::LoadScene");
+
+	UnloadScene();
+
 	ImportScene(sceneFilePath);
 	ResizeBuffers();
 	LoadTextures(md3dDevice, mCommandList);
@@ -20,89 +79,82 @@ Scene* SceneManager::GetScenePtr()
 
 void SceneManager::ImportScene(std::string sceneFilePath)
 {
-	std::ifstream inputFile;
-	inputFile.open(sceneFilePath, std::fstream::in);
+	PROFILE_SCOPE("SceneManager::ImportScene");
 
-	std::string name;
-	DirectX::XMFLOAT3 cameraPosition;
-	DirectX::XMFLOAT4 cameraRotation;
-	DirectX::XMFLOAT3 lightDirection;
-	DirectX::XMFLOAT3 lightStrength;
-	UINT numberOfObjects;
+	SceneDescription sceneDescription;
 
-	inputFile >> name;
-	inputFile >> cameraPosition.x >> cameraPosition.y >> cameraPosition.z;
-	inputFile >> cameraRotation.x >> cameraRotation.y >> cameraRotation.z >> cameraRotation.w;
-	inputFile >> lightDirection.x >> lightDirection.y >> lightDirection.z;
-	inputFile >> lightStrength.x >> lightStrength.y >> lightStrength.z;
-	inputFile >> numberOfObjects;
+	if (!SceneLoader::LoadSceneDescription(sceneFilePath, sceneDescription))
+		throw DxException(E_FAIL, L"SceneLoader::LoadSceneDescription(" + AnsiToWString(sceneFilePath) + L")",
+			AnsiToWString(__FILE__), __LINE__);
 
-	mScene.name = name;
-	mScene.cameraPosition = cameraPosition;
-	mScene.cameraRotation = cameraRotation;
-	mScene.lightDirection = lightDirection;
-	mScene.lightStrength = lightStrength;
-	mScene.numberOfObjects = numberOfObjects;
+	mScene.name = sceneDescription.name;
+	mScene.cameraPosition = sceneDescription.cameraPosition;
+	mScene.cameraRotation = sceneDescription.cameraRotation;
+	mScene.lightDirection = sceneDescription.lightDirection;
+	mScene.lightStrength = sceneDescription.lightStrength;
+	mScene.numberOfObjects = (UINT)sceneDescription.objects.size();
+	mScene.numberOfUniqueObjects = sceneDescription.numberOfUniqueObjects;
 
-	mScene.mObjectsInScene = new SceneObject[numberOfObjects];
+	mScene.mObjectsInScene = mSceneArena.NewArray<SceneObject>(mScene.numberOfObjects);
 
-	mScene.numberOfUniqueObjects = 0;
+	for (UINT i = 0; i < mScene.numberOfObjects; ++i)
+		mScene.mObjectsInScene[i] = sceneDescription.objects[i];
 
-	std::vector<std::string> objectMeshNames;
+	// Hashed in the order the scene places the meshes and textures, each file once. The textures color
+	// the injected voxels as much as the meshes place them.
+	MappedFile file;
+	std::vector<std::string> filePathsHashed;
 
-	for (UINT i = 0; i < numberOfObjects; ++i)
-	{
-		inputFile >> mScene.mObjectsInScene[i].meshName;
-		inputFile >> mScene.mObjectsInScene[i].diffuseOpacityTextureName;
-		inputFile >> mScene.mObjectsInScene[i].normalRoughnessTextureName;
-		inputFile >> mScene.mObjectsInScene[i].position.x >> mScene.mObjectsInScene[i].position.y >> mScene.mObjectsInScene[i].position.z;
-		inputFile >> mScene.mObjectsInScene[i].rotation.x >> mScene.mObjectsInScene[i].rotation.y >> mScene.mObjectsInScene[i].rotation.z >> mScene.mObjectsInScene[i].rotation.w;
-		inputFile >> mScene.mObjectsInScene[i].scale.x >> mScene.mObjectsInScene[i].scale.y >> mScene.mObjectsInScene[i].scale.z;
+	mScene.contentHash = file.Open(sceneFilePath) ? GICache::Hash(file.GetData(), file.GetSize()) : GICache::Hash(nullptr, 0);
 
-		bool isAlreadyPresent = false;
+	for (const SceneObject& object : sceneDescription.objects)
+	{
+		const std::string filePaths[] = { "../Assets/Meshes/" + object.meshName + ".txt",
+			"../Assets/Textures/" + object.diffuseOpacityTextureName + ".dds",
+			"../Assets/Textures/" + object.normalRoughnessTextureName + ".dds" };
 
-		for (size_t j = 0; j < objectMeshNames.size(); ++j)
+		for (const std::string& filePath : filePaths)
 		{
-			if (objectMeshNames[j] == mScene.mObjectsInScene[i].meshName)
-			{
-				isAlreadyPresent = true;
-				break;
-			}
-		}
+			if (std::find(filePathsHashed.begin(), filePathsHashed.end(), filePath) != filePathsHashed.end())
+				continue;
 
-		if (!isAlreadyPresent)
-		{
-			objectMeshNames.push_back(mScene.mObjectsInScene[i].meshName);
-			++mScene.numberOfUniqueObjects;
+			filePathsHashed.push_back(filePath);
+
+			if (file.Open(filePath))
+				mScene.contentHash = GICache::Hash(file.GetData(), file.GetSize(), mScene.contentHash);
 		}
 	}
-
-	inputFile.close();
 }
 
 void SceneManager::ResizeBuffers()
 {
-	mScene.mSceneGeometry = std::make_unique<MeshGeometry>();
+	PROFILE_SCOPE("SceneManager::ResizeBuffers");
+
+	mScene.mSceneGeometry = mSceneArena.New<MeshGeometry>();
 	mScene.mSceneGeometry->Name = mScene.name;
 	
 	// 1 extra for quad
-	mScene.mSceneGeometry->DrawArgs = new SubmeshGeometry[mScene.numberOfUniqueObjects + 1];
-	// 2 extra for skybox cubemap and lut texture
-	mScene.mTextures = new std::unique_ptr<Texture>[(2 * mScene.numberOfUniqueObjects) + 2];
-	mScene.mMaterials = new std::unique_ptr<Material>[mScene.numberOfUniqueObjects];
-	// 1 extra for quad
-	mScene.mSubMeshes = new std::unique_ptr<SubmeshGeometry>[mScene.numberOfUniqueObjects + 1];
+	mScene.mSceneGeometry->DrawArgs = mSceneArena.NewArray<SubmeshGeometry>(mScene.numberOfUniqueObjects + 1);
+	// 2 extra for skybox cubemap and lut texture, slots of deduplicated textures stay null
+	mScene.mTextures = mSceneArena.NewArray<Texture*>((2 * mScene.numberOfUniqueObjects) + 2);
+	mScene.mMaterials = mSceneArena.NewArray<Material>(mScene.numberOfUniqueObjects);
 	
-	mScene.mOpaqueRObjects = new std::unique_ptr<RenderObject>[mScene.numberOfObjects];
+	mScene.mOpaqueRObjects = mSceneArena.NewArray<RenderObject>(mScene.numberOfObjects);
 }
 
 void SceneManager::LoadTextures(Microsoft::WRL::ComPtr<ID3D12Device> md3dDevice, 
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCommandList)
 {
+	PROFILE_SCOPE("SceneManager::LoadTextures");
+
 	UINT index = 0;
 	std::vector<std::string> textureNamesProcessed;
+	std::vector<Texture*> materialTextures;
+
+	TextureStreamer::BeginScene(md3dDevice, 2 * mScene.numberOfUniqueObjects);
 
-	// Load the scene material textures
+	// Gather the scene material textures, only their mip tails are uploaded here and the streamer
+	// brings in the detailed mips once the objects are in view
 	for (UINT i = 0; i < mScene.numberOfObjects; ++i)
 	{
 		bool isAlreadyProcessed = false;
@@ -130,57 +182,63 @@ void SceneManager::LoadTextures(Microsoft::WRL::ComPtr<ID3D12Device> md3dDevice,
 		wsDiffuseOpacity << mScene.mObjectsInScene[i].diffuseOpacityTextureName.c_str();
 		std::wstring wsNameDiffuseOpacity = wsDiffuseOpacity.str();
 
-		auto texDiffuseOpacity = std::make_unique<Texture>();
+		Texture* texDiffuseOpacity = mTexturePool.Create();
 		texDiffuseOpacity->Name = mScene.mObjectsInScene[i].diffuseOpacityTextureName;
 		texDiffuseOpacity->Filename = L"../Assets/Textures/" + wsNameDiffuseOpacity + L".dds";
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-			mCommandList.Get(), texDiffuseOpacity->Filename.c_str(),
-			texDiffuseOpacity->Resource, texDiffuseOpacity->UploadHeap));
 
-		mScene.mTextures[index++] = std::move(texDiffuseOpacity);
+		materialTextures.push_back(texDiffuseOpacity);
+		mScene.mTextures[index++] = texDiffuseOpacity;
 
 		// Load the normal roughness texture next
 		std::wstringstream wsNormalRoughness;
 		wsNormalRoughness << mScene.mObjectsInScene[i].normalRoughnessTextureName.c_str();
 		std::wstring wsNameNormalRoughness = wsNormalRoughness.str();
 
-		auto texNormalRoughness = std::make_unique<Texture>();
+		Texture* texNormalRoughness = mTexturePool.Create();
 		texNormalRoughness->Name = mScene.mObjectsInScene[i].normalRoughnessTextureName;
 		texNormalRoughness->Filename = L"../Assets/Textures/" + wsNameNormalRoughness + L".dds";
 
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-			mCommandList.Get(), texNormalRoughness->Filename.c_str(),
-			texNormalRoughness->Resource, texNormalRoughness->UploadHeap));
-
-		mScene.mTextures[index++] = std::move(texNormalRoughness);
+		materialTextures.push_back(texNormalRoughness);
+		mScene.mTextures[index++] = texNormalRoughness;
 	}
 
-	// Load the skybox texture
-	auto texSkyBox = std::make_unique<Texture>();
+	// The files of all textures are read and staged in parallel, the copies are recorded as one batch
+	TextureStreamer::LoadTextures(mCommandList.Get(), materialTextures);
+
+	for (Texture* texture : materialTextures)
+		TrackTexture(md3dDevice.Get(), texture);
+
+	// Load the skybox and lut textures with all their mips
+	Texture* texSkyBox = mTexturePool.Create();
 	texSkyBox->Name = "SkyBox";
 	texSkyBox->Filename = L"../Assets/Textures/SkyBox.dds";
 
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), texSkyBox->Filename.c_str(),
-		texSkyBox->Resource, texSkyBox->UploadHeap));
-
-	mScene.mTextures[index++] = std::move(texSkyBox);
+	mScene.mTextures[index++] = texSkyBox;
 
-	// Load the lut texture
-	auto texLUT = std::make_unique<Texture>();
+	Texture* texLUT = mTexturePool.Create();
 	texLUT->Name = "LUT";
 	texLUT->Filename = L"../Assets/Textures/LUT.dds";
 
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), texLUT->Filename.c_str(),
-		texLUT->Resource, texLUT->UploadHeap));
+	mScene.mTextures[index++] = texLUT;
+
+	// Uploaded on the copy queue, the direct queue waits for the scene's ticket before using them
+	mScene.mUploadTicket = UploadService::LoadTextures({ texSkyBox, texLUT });
 
-	mScene.mTextures[index++] = std::move(texLUT);
+	TrackTexture(md3dDevice.Get(), texSkyBox);
+	TrackTexture(md3dDevice.Get(), texLUT);
+}
+
+void SceneManager::TrackTexture(ID3D12Device* md3dDevice, Texture* texture)
+{
+	d3dUtil::TrackResource(md3dDevice, texture->Resource.Get(), MemoryCategory::Textures);
+	d3dUtil::TrackResource(md3dDevice, texture->UploadHeap.Get(), MemoryCategory::Staging);
 }
 
 void SceneManager::BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device> md3dDevice,
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCommandList)
 {
+	PROFILE_SCOPE("SceneManager::BuildSceneGeometry");
+
 	size_t totalVertexCount = 0;
 	size_t currentStartIndexCount = 0;
 	size_t currentBaseVertexLocation = 0;
@@ -219,17 +277,17 @@ void SceneManager::BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device> md3dD
 
 		totalVertexCount += tempMesh.Vertices.size();
 
-		auto tempSubMesh = std::make_unique<SubmeshGeometry>();;
+		SubmeshGeometry* tempSubMesh = &mScene.mSceneGeometry->DrawArgs[index];
 		tempSubMesh->Name = mScene.mObjectsInScene[i].meshName;
 		tempSubMesh->IndexCount = (UINT)tempMesh.Indices32.size();
 		tempSubMesh->StartIndexLocation = (UINT)currentStartIndexCount;
 		tempSubMesh->BaseVertexLocation = (INT)currentBaseVertexLocation;
+		tempSubMesh->UVDensity = MeshLoader::ComputeUVDensity(tempMesh);
+		MeshLoader::ComputeBoundingSphere(tempMesh, tempSubMesh->BoundsCenter, tempSubMesh->BoundsRadius);
 
 		currentStartIndexCount += tempMesh.Indices32.size();
 		currentBaseVertexLocation += tempMesh.Vertices.size();
 
-		mScene.mSubMeshes[index] = std::move(tempSubMesh);
-
 		vertices.resize(totalVertexCount);
 
 		for (size_t it = 0; it < tempMesh.Vertices.size(); ++it, ++k)
@@ -242,8 +300,6 @@ void SceneManager::BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device> md3dD
 
 		indices.insert(indices.end(), std::begin(tempMesh.GetIndices16()), std::end(tempMesh.GetIndices16()));
 
-		mScene.mSceneGeometry->DrawArgs[index] = *mScene.mSubMeshes[index];
-
 		++index;
 	}
 
@@ -252,7 +308,7 @@ void SceneManager::BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device> md3dD
 
 	totalVertexCount += tempMesh.Vertices.size();
 
-	auto tempSubMesh = std::make_unique<SubmeshGeometry>();
+	SubmeshGeometry* tempSubMesh = &mScene.mSceneGeometry->DrawArgs[index];
 	tempSubMesh->Name = "Quad";
 	tempSubMesh->IndexCount = (UINT)tempMesh.Indices32.size();
 	tempSubMesh->StartIndexLocation = (UINT)currentStartIndexCount;
@@ -261,8 +317,6 @@ void SceneManager::BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device> md3dD
 	currentStartIndexCount += tempMesh.Indices32.size();
 	currentBaseVertexLocation += tempMesh.Vertices.size();
 
-	mScene.mSubMeshes[index] = std::move(tempSubMesh);
-
 	vertices.resize(totalVertexCount);
 
 	for (size_t i = 0; i < tempMesh.Vertices.size(); ++i, ++k)
@@ -275,8 +329,6 @@ void SceneManager::BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device> md3dD
 
 	indices.insert(indices.end(), std::begin(tempMesh.GetIndices16()), std::end(tempMesh.GetIndices16()));
 
-	mScene.mSceneGeometry->DrawArgs[index] = *mScene.mSubMeshes[index];
-
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
@@ -286,11 +338,14 @@ void SceneManager::BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device> md3dD
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &mScene.mSceneGeometry->IndexBufferCPU));
 	CopyMemory(mScene.mSceneGeometry->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	mScene.mSceneGeometry->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, mScene.mSceneGeometry->VertexBufferUploader);
+	// Staged by the upload service, so the geometry has no upload heaps of its own
+	mScene.mSceneGeometry->VertexBufferGPU = UploadService::CreateDefaultBuffer(vertices.data(), vbByteSize, mScene.mUploadTicket);
+	mScene.mSceneGeometry->IndexBufferGPU = UploadService::CreateDefaultBuffer(indices.data(), ibByteSize, mScene.mUploadTicket);
 
-	mScene.mSceneGeometry->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, mScene.mSceneGeometry->IndexBufferUploader);
+	d3dUtil::TrackResource(md3dDevice.Get(), mScene.mSceneGeometry->VertexBufferGPU.Get(), MemoryCategory::Geometry);
+	d3dUtil::TrackResource(md3dDevice.Get(), mScene.mSceneGeometry->IndexBufferGPU.Get(), MemoryCategory::Geometry);
+	MemoryTracker::Track(MemoryCategory::Staging, mScene.mSceneGeometry->VertexBufferCPU.Get(), vbByteSize);
+	MemoryTracker::Track(MemoryCategory::Staging, mScene.mSceneGeometry->IndexBufferCPU.Get(), ibByteSize);
 
 	mScene.mSceneGeometry->VertexByteStride = sizeof(Vertex);
 	mScene.mSceneGeometry->VertexBufferByteSize = vbByteSize;
@@ -300,6 +355,8 @@ void SceneManager::BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device> md3dD
 
 void SceneManager::BuildMaterials()
 {
+	PROFILE_SCOPE("SceneManager::BuildMaterials");
+
 	UINT index = 0;
 	std::vector<std::string> materialNamesProcessed;
 
@@ -325,12 +382,13 @@ void SceneManager::BuildMaterials()
 			materialNamesProcessed.push_back(mScene.mObjectsInScene[i].meshName);
 		}
 
-		auto mat = std::make_unique<Material>();
+		Material* mat = &mScene.mMaterials[index];
 		mat->MatCBIndex = index;
 		mat->DiffuseSrvHeapIndex = index * 2;
 		mat->Metallic = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
 		mat->Name = mScene.mObjectsInScene[i].meshName;
-		mScene.mMaterials[index++] = std::move(mat);
+
+		++index;
 	}
 }
 
@@ -340,9 +398,25 @@ Material* SceneManager::GetMaterial(std::string materialName)
 
 	for (UINT i = 0; i < mScene.numberOfUniqueObjects; ++i)
 	{
-		if (mScene.mMaterials[i]->Name == materialName)
+		if (mScene.mMaterials[i].Name == materialName)
+		{
+			result = &mScene.mMaterials[i];
+			break;
+		}
+	}
+
+	return result;
+}
+
+SubmeshGeometry* SceneManager::GetSubmesh(std::string meshName)
+{
+	SubmeshGeometry* result = nullptr;
+
+	for (UINT i = 0; i < mScene.numberOfUniqueObjects; ++i)
+	{
+		if (mScene.mSceneGeometry->DrawArgs[i].Name == meshName)
 		{
-			result = mScene.mMaterials[i].get();
+			result = &mScene.mSceneGeometry->DrawArgs[i];
 			break;
 		}
 	}
@@ -400,14 +474,16 @@ int SceneManager::GetBaseVertexLocation(std::string meshName)
 
 void SceneManager::BuildRenderObjects()
 {
+	PROFILE_SCOPE("SceneManager::BuildRenderObjects");
+
 	for (UINT i = 0; i < mScene.numberOfObjects; ++i)
 	{
 		std::string meshName = mScene.mObjectsInScene[i].meshName;
 
-		auto rObject = std::make_unique<RenderObject>();
+		RenderObject* rObject = &mScene.mOpaqueRObjects[i];
 		rObject->SetObjCBIndex(i);
 		rObject->SetMat(GetMaterial(meshName));
-		rObject->SetGeo(mScene.mSceneGeometry.get());
+		rObject->SetGeo(mScene.mSceneGeometry);
 		rObject->SetPrimitiveType(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 		rObject->SetIndexCount(GetIndexCount(meshName));
 		rObject->SetStartIndexLocation(GetStartIndexLocation(meshName));
@@ -416,33 +492,138 @@ void SceneManager::BuildRenderObjects()
 			* XMMatrixRotationQuaternion(XMLoadFloat4(&mScene.mObjectsInScene[i].rotation))
 			* XMMatrixTranslation(mScene.mObjectsInScene[i].position.x, mScene.mObjectsInScene[i].position.y, mScene.mObjectsInScene[i].position.z)));
 
-		mScene.mOpaqueRObjects[i] = std::move(rObject);
+		// The streamer estimates the mips of the object's textures from its bounds and texture density
+		SubmeshGeometry* submesh = GetSubmesh(meshName);
+		XMFLOAT3 scale = mScene.mObjectsInScene[i].scale;
+		float maxScale = std::max(std::fabs(scale.x), std::max(std::fabs(scale.y), std::fabs(scale.z)));
+
+		if (submesh != nullptr && maxScale > 0.0f)
+		{
+			XMFLOAT3 center;
+			XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&submesh->BoundsCenter), XMLoadFloat4x4(rObject->GetWorldMatrixPtr())));
+
+			TextureStreamer::AddObject(center, submesh->BoundsRadius * maxScale, submesh->UVDensity / maxScale,
+				rObject->GetMat()->DiffuseSrvHeapIndex, rObject->GetMat()->DiffuseSrvHeapIndex + 1);
+		}
 	}
 
 	// Make the post processing quad render object
-	mScene.mQuadrObject = std::make_unique<RenderObject>();
-	mScene.mQuadrObject->InitializeAsQuad(mScene.mSceneGeometry.get(), mScene.numberOfUniqueObjects);
+	mScene.mQuadrObject = mSceneArena.New<RenderObject>();
+	mScene.mQuadrObject->InitializeAsQuad(mScene.mSceneGeometry, mScene.numberOfUniqueObjects);
 }
 
-void SceneManager::ReleaseMemory()
+void SceneManager::VoxelizeScene(Voxelizer& voxelizer)
 {
-	delete[] mScene.mObjectsInScene;
-	delete[] mScene.mSceneGeometry->DrawArgs;
+	PROFILE_SCOPE("SceneManager::VoxelizeScene");
+
+	if (mScene.mSceneGeometry == nullptr || mScene.mSceneGeometry->VertexBufferCPU == nullptr)
+		return;
+
+	const Vertex* vertices = static_cast<const Vertex*>(mScene.mSceneGeometry->VertexBufferCPU->GetBufferPointer());
+	const std::uint16_t* indices = static_cast<const std::uint16_t*>(mScene.mSceneGeometry->IndexBufferCPU->GetBufferPointer());
+
+	std::map<std::string, XMFLOAT3> albedos;
 
 	for (UINT i = 0; i < mScene.numberOfObjects; ++i)
 	{
-		mScene.mOpaqueRObjects[i].release();
+		const SceneObject& sceneObject = mScene.mObjectsInScene[i];
+		SubmeshGeometry* submesh = GetSubmesh(sceneObject.meshName);
+
+		if (submesh == nullptr)
+			continue;
+
+		// Indices of the submesh are relative to its base vertex
+		std::vector<uint32_t> meshIndices(indices + submesh->StartIndexLocation, indices + submesh->StartIndexLocation + submesh->IndexCount);
+		uint32_t vertexCount = 0;
+
+		for (uint32_t index : meshIndices)
+			vertexCount = std::max(vertexCount, index + 1);
+
+		std::vector<XMFLOAT3> positions(vertexCount);
+
+		for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+			positions[vertex] = vertices[submesh->BaseVertexLocation + vertex].Pos;
+
+		auto albedo = albedos.find(sceneObject.diffuseOpacityTextureName);
+
+		if (albedo == albedos.end())
+		{
+			std::wstring filename = L"../Assets/Textures/" + AnsiToWString(sceneObject.diffuseOpacityTextureName) + L".dds";
+			albedo = albedos.insert(std::make_pair(sceneObject.diffuseOpacityTextureName, GetAverageAlbedo(filename))).first;
+		}
+
+		voxelizer.AddMesh(positions, meshIndices, *mScene.mOpaqueRObjects[i].GetWorldMatrixPtr(), albedo->second);
 	}
+}
+
+void SceneManager::DisposeUploaders()
+{
+	// Textures that didn't fit in the staging ring have an upload heap of their own
+	TextureUploader::ReleaseAll();
 
+	// Textures that share a diffuse map are only loaded once, so trailing slots may be empty
 	for (UINT i = 0; i < (2 * mScene.numberOfUniqueObjects) + 2; ++i)
-		mScene.mTextures[i].release();
+	{
+		if (mScene.mTextures[i] == nullptr)
+			continue;
 
-	for (UINT i = 0; i < mScene.numberOfUniqueObjects; ++i)
-		mScene.mMaterials[i].release();
+		MemoryTracker::Untrack(mScene.mTextures[i]->UploadHeap.Get());
+		mScene.mTextures[i]->UploadHeap = nullptr;
+	}
+
+	MemoryTracker::Untrack(mScene.mSceneGeometry->VertexBufferUploader.Get());
+	MemoryTracker::Untrack(mScene.mSceneGeometry->IndexBufferUploader.Get());
+	mScene.mSceneGeometry->DisposeUploaders();
+
+	// Nothing reads the system memory copies once the buffers are on the GPU
+	MemoryTracker::Untrack(mScene.mSceneGeometry->VertexBufferCPU.Get());
+	MemoryTracker::Untrack(mScene.mSceneGeometry->IndexBufferCPU.Get());
+	mScene.mSceneGeometry->VertexBufferCPU = nullptr;
+	mScene.mSceneGeometry->IndexBufferCPU = nullptr;
+}
+
+void SceneManager::UnloadScene()
+{
+	PROFILE_SCOPE("SceneManager::UnloadScene");
+
+	// Releases the resources retired by streaming and closes the texture files
+	TextureStreamer::UnloadScene();
 
-	for (UINT i = 0; i < mScene.numberOfUniqueObjects + 1; ++i)
-		mScene.mSubMeshes[i].release();
+	// Also cleans up after a load that threw part way, so check what was created
+	if (mScene.mTextures != nullptr)
+	{
+		for (UINT i = 0; i < (2 * mScene.numberOfUniqueObjects) + 2; ++i)
+		{
+			if (mScene.mTextures[i] == nullptr)
+				continue;
+
+			MemoryTracker::Untrack(mScene.mTextures[i]->Resource.Get());
+			MemoryTracker::Untrack(mScene.mTextures[i]->UploadHeap.Get());
+			mTexturePool.Destroy(mScene.mTextures[i]);
+		}
+	}
+
+	// Untracking is a no-op for anything DisposeUploaders already released
+	if (mScene.mSceneGeometry != nullptr)
+	{
+		MemoryTracker::Untrack(mScene.mSceneGeometry->VertexBufferGPU.Get());
+		MemoryTracker::Untrack(mScene.mSceneGeometry->IndexBufferGPU.Get());
+		MemoryTracker::Untrack(mScene.mSceneGeometry->VertexBufferUploader.Get());
+		MemoryTracker::Untrack(mScene.mSceneGeometry->IndexBufferUploader.Get());
+		MemoryTracker::Untrack(mScene.mSceneGeometry->VertexBufferCPU.Get());
+		MemoryTracker::Untrack(mScene.mSceneGeometry->IndexBufferCPU.Get());
+	}
+
+	// Runs the destructors of the arena objects, which releases the geometry buffers
+	mSceneArena.Reset();
+
+	mScene = Scene();
+}
+
+void SceneManager::ReleaseMemory()
+{
+	UnloadScene();
 
-	mScene.mQuadrObject.release();
-	mScene.mSceneGeometry.release();
+	mSceneArena.Release();
+	mTexturePool.Clear();
 }
\ No newline at end of file
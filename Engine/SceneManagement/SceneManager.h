@@ -3,18 +3,13 @@
 #include "RenderObject.h"
 #include "MeshLoader.h"
 #include "Texture.h"
-
-struct SceneObject
-{
-	SceneObject() = default;
-
-	std::string					meshName;
-	std::string					diffuseOpacityTextureName;
-	std::string					normalRoughnessTextureName;
-	DirectX::XMFLOAT3			position;
-	DirectX::XMFLOAT4			rotation;
-	DirectX::XMFLOAT3			scale;
-};
+#include "SceneLoader.h"
+#include "TextureStreamer.h"
+#include "UploadService.h"
+#include "../Utilities/MemoryArena.h"
+#include "../Utilities/ObjectPool.h"
+#include "../Utilities/Profiler.h"
+#include "../Utilities/Voxelizer.h"
 
 struct Scene
 {
@@ -27,17 +22,23 @@ struct Scene
 	DirectX::XMFLOAT3			lightStrength;
 	UINT						numberOfObjects;
 	UINT						numberOfUniqueObjects;
+	// Of the scene file and the mesh and texture files it uses, a saved GI cache is only used while it matches
+	uint64_t					contentHash = 0;
 
-	SceneObject* mObjectsInScene;
+	// Everything below lives in the scene arena, except the textures which come from a pool
+	SceneObject* mObjectsInScene = nullptr;
 
-	std::unique_ptr<Texture>* mTextures;
-	std::unique_ptr<Material>* mMaterials;
-	std::unique_ptr<SubmeshGeometry>* mSubMeshes;
-	std::unique_ptr<RenderObject>* mOpaqueRObjects;
+	Texture** mTextures = nullptr;
+	Material* mMaterials = nullptr;
+	RenderObject* mOpaqueRObjects = nullptr;
 	
-	std::unique_ptr<RenderObject> mQuadrObject;
+	RenderObject* mQuadrObject = nullptr;
 	
-	std::unique_ptr<MeshGeometry> mSceneGeometry;
+	MeshGeometry* mSceneGeometry = nullptr;
+
+	// Complete once the geometry, skybox and lut reached the GPU, the material mip tails go with the
+	// initialization command list
+	UploadTicket mUploadTicket;
 };
 
 class SceneManager
@@ -45,8 +46,16 @@ class SceneManager
 public:
 	SceneManager() = default;
 
+	// Replaces the current scene, if any. The GPU must be done with the previous scene's resources.
 	static void LoadScene(std::string, Microsoft::WRL::ComPtr<ID3D12Device>, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>);
 	static Scene* GetScenePtr();
+	// Adds the world space triangles of every render object, with the average color of its diffuse
+	// texture. Reads the system memory copies of the geometry, so call it before DisposeUploaders().
+	static void VoxelizeScene(Voxelizer&);
+	// Releases the upload heaps and system memory copies, call once the initialization commands completed
+	static void DisposeUploaders();
+	// Destroys the scene's objects and rewinds the arena, its memory is reused by the next load
+	static void UnloadScene();
 	static void ReleaseMemory();
 
 	~SceneManager() = default;
@@ -56,14 +65,18 @@ private:
 	static void ImportScene(std::string);
 	static void ResizeBuffers();
 	static void LoadTextures(Microsoft::WRL::ComPtr<ID3D12Device>, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>);
+	static void TrackTexture(ID3D12Device*, Texture*);
 	static void BuildSceneGeometry(Microsoft::WRL::ComPtr<ID3D12Device>, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>);
 	static void BuildMaterials();
 	static void BuildRenderObjects();
 
 	static Material* GetMaterial(std::string);
+	static SubmeshGeometry* GetSubmesh(std::string);
 	static UINT GetIndexCount(std::string);
 	static UINT GetStartIndexLocation(std::string);
 	static int GetBaseVertexLocation(std::string);
 
 	static Scene mScene;
+	static MemoryArena mSceneArena;
+	static ObjectPool<Texture> mTexturePool;
 };
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TextureResidency::SetBudget(uint64_t budget)
+{
+	mBudget = budget;
+}
+
+void TextureResidency::SetUploadLimit(uint64_t uploadLimit)
+{
+	mUploadLimit = uploadLimit;
+}
+
+uint32_t TextureResidency::AddTexture(const std::vector<uint64_t>& mipBytes, uint32_t tailMip)
+{
+	ResidentTexture texture;
+	texture.mipBytes = mipBytes;
+	texture.tailMip = mipBytes.empty() ? 0 : std::min(tailMip, (uint32_t)mipBytes.size() - 1);
+	texture.residentMip = texture.tailMip;
+	texture.requestedMip = texture.tailMip;
+
+	mResidentBytes += GetBytes(texture, texture.tailMip, (uint32_t)mipBytes.size());
+	mStats.residentBytes = mResidentBytes;
+
+	mTextures.push_back(texture);
+
+	return (uint32_t)mTextures.size() - 1;
+}
+
+void TextureResidency::Clear()
+{
+	mTextures.clear();
+	mEvictionOrder.clear();
+	mResidentBytes = 0;
+	mUpdate = 0;
+	mStats = ResidencyStats();
+}
+
+void TextureResidency::Request(uint32_t textureIndex, uint32_t mip)
+{
+	ResidentTexture& texture = mTextures[textureIndex];
+
+	// Nothing coarser than the tail is ever evicted
+	mip = std::min(mip, texture.tailMip);
+
+	texture.requestedMip = texture.isRequested ? std::min(texture.requestedMip, mip) : mip;
+	texture.isRequested = true;
+}
+
+void TextureResidency::Update(std::vector<ResidencyChange>& changes)
+{
+	++mUpdate;
+
+	mStats.streamedInBytes = 0;
+	mStats.evictedBytes = 0;
+
+	std::vector<uint32_t> previousMips(mTextures.size());
+
+	for (size_t i = 0; i < mTextures.size(); ++i)
+	{
+		previousMips[i] = mTextures[i].residentMip;
+
+		if (mTextures[i].isRequested)
+			mTextures[i].lastRequestedUpdate = mUpdate;
+	}
+
+	mEvictionOrder.resize(mTextures.size());
+
+	for (uint32_t i = 0; i < (uint32_t)mTextures.size(); ++i)
+		mEvictionOrder[i] = i;
+
+	std::stable_sort(mEvictionOrder.begin(), mEvictionOrder.end(), [this](uint32_t a, uint32_t b)
+	{
+		return mTextures[a].lastRequestedUpdate < mTextures[b].lastRequestedUpdate;
+	});
+
+	// The budget may have been lowered since the last update
+	if (mResidentBytes > mBudget)
+		Evict(std::min(mResidentBytes - mBudget, GetEvictableBytes(UINT32_MAX)), UINT32_MAX);
+
+	// Textures short of their request, the ones missing the most mips first
+	std::vector<uint32_t> loads;
+
+	for (uint32_t i = 0; i < (uint32_t)mTextures.size(); ++i)
+	{
+		if (mTextures[i].requestedMip < mTextures[i].residentMip)
+			loads.push_back(i);
+	}
+
+	std::stable_sort(loads.begin(), loads.end(), [this](uint32_t a, uint32_t b)
+	{
+		return (mTextures[a].residentMip - mTextures[a].requestedMip) > (mTextures[b].residentMip - mTextures[b].requestedMip);
+	});
+
+	uint64_t uploadedBytes = 0;
+
+	for (uint32_t textureIndex : loads)
+	{
+		ResidentTexture& texture = mTextures[textureIndex];
+		uint32_t targetMip = texture.requestedMip;
+
+		// Closer to the request over several updates when the whole step doesn't fit the upload limit
+		while (targetMip + 1 < texture.residentMip && uploadedBytes + GetBytes(texture, targetMip, texture.residentMip) > mUploadLimit)
+			++targetMip;
+
+		if (uploadedBytes > 0 && uploadedBytes + GetBytes(texture, targetMip, texture.residentMip) > mUploadLimit)
+			continue;
+
+		while (targetMip < texture.residentMip)
+		{
+			uint64_t bytes = GetBytes(texture, targetMip, texture.residentMip);
+
+			if (mResidentBytes + bytes <= mBudget)
+				break;
+
+			// Evicting part of what is needed would only throw away mips without making room
+			if (mResidentBytes + bytes - mBudget <= GetEvictableBytes(textureIndex))
+			{
+				Evict(mResidentBytes + bytes - mBudget, textureIndex);
+				break;
+			}
+
+			++targetMip;
+		}
+
+		if (targetMip == texture.residentMip)
+			continue;
+
+		uint64_t bytes = GetBytes(texture, targetMip, texture.residentMip);
+
+		texture.residentMip = targetMip;
+		mResidentBytes += bytes;
+		uploadedBytes += bytes;
+		mStats.streamedInBytes += bytes;
+	}
+
+	mStats.residentBytes = mResidentBytes;
+	mStats.requestedBytes = 0;
+	mStats.pendingTextures = 0;
+
+	for (uint32_t i = 0; i < (uint32_t)mTextures.size(); ++i)
+	{
+		ResidentTexture& texture = mTextures[i];
+
+		mStats.requestedBytes += GetBytes(texture, texture.requestedMip, (uint32_t)texture.mipBytes.size());
+
+		if (texture.requestedMip < texture.residentMip)
+			++mStats.pendingTextures;
+
+		if (texture.residentMip != previousMips[i])
+		{
+			ResidencyChange change;
+			change.texture = i;
+			change.previousMip = previousMips[i];
+			change.residentMip = texture.residentMip;
+			changes.push_back(change);
+		}
+
+		texture.requestedMip = texture.tailMip;
+		texture.isRequested = false;
+	}
+}
+
+uint32_t TextureResidency::GetResidentMip(uint32_t textureIndex) const
+{
+	return mTextures[textureIndex].residentMip;
+}
+
+uint32_t TextureResidency::GetTailMip(uint32_t textureIndex) const
+{
+	return mTextures[textureIndex].tailMip;
+}
+
+uint32_t TextureResidency::GetMipCount(uint32_t textureIndex) const
+{
+	return (uint32_t)mTextures[textureIndex].mipBytes.size();
+}
+
+uint32_t TextureResidency::ComputeRequiredMip(float texelsPerWorldUnit, float distance, float fovY, float viewportHeight, uint32_t mipCount)
+{
+	if (mipCount == 0)
+		return 0;
+
+	// World units covered by one pixel row at that distance
+	float pixelsPerWorldUnit = viewportHeight / (2.0f * std::max(distance, 1.0e-3f) * std::tan(0.5f * fovY));
+	float texelsPerPixel = texelsPerWorldUnit / pixelsPerWorldUnit;
+
+	if (!(texelsPerPixel > 1.0f))
+		return 0;
+
+	// Rounded down, a mip too sharp costs memory, one too blurry is visible
+	return std::min((uint32_t)std::log2(texelsPerPixel), mipCount - 1);
+}
+
+uint64_t TextureResidency::GetBytes(const ResidentTexture& texture, uint32_t firstMip, uint32_t endMip) const
+{
+	uint64_t bytes = 0;
+
+	for (uint32_t mip = firstMip; mip < endMip; ++mip)
+		bytes += texture.mipBytes[mip];
+
+	return bytes;
+}
+
+uint64_t TextureResidency::GetEvictableBytes(uint32_t excludedTexture) const
+{
+	uint64_t bytes = 0;
+
+	for (uint32_t textureIndex = 0; textureIndex < (uint32_t)mTextures.size(); ++textureIndex)
+	{
+		if (textureIndex != excludedTexture)
+			bytes += GetBytes(mTextures[textureIndex], mTextures[textureIndex].residentMip, GetEvictionFloor(mTextures[textureIndex]));
+	}
+
+	return bytes;
+}
+
+void TextureResidency::Evict(uint64_t bytes, uint32_t excludedTexture)
+{
+	uint64_t evictedBytes = 0;
+
+	for (uint32_t textureIndex : mEvictionOrder)
+	{
+		if (evictedBytes >= bytes)
+			break;
+
+		if (textureIndex == excludedTexture)
+			continue;
+
+		ResidentTexture& texture = mTextures[textureIndex];
+		uint32_t floorMip = GetEvictionFloor(texture);
+
+		while (evictedBytes < bytes && texture.residentMip < floorMip)
+		{
+			evictedBytes += texture.mipBytes[texture.residentMip];
+			mResidentBytes -= texture.mipBytes[texture.residentMip];
+			mStats.evictedBytes += texture.mipBytes[texture.residentMip];
+			++texture.residentMip;
+		}
+	}
+}
+
+uint32_t TextureResidency::GetEvictionFloor(const ResidentTexture& texture) const
+{
+	// Textures in use keep what they asked for, the others go back to their tail
+	return texture.isRequested ? std::max(texture.requestedMip, texture.residentMip) : texture.tailMip;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A change of the resident mips of one texture, a lower mip streams in, a higher one evicts
+struct ResidencyChange
+{
+	uint32_t	texture = 0;
+	// Most detailed resident mip before and after the update
+	uint32_t	previousMip = 0;
+	uint32_t	residentMip = 0;
+};
+
+struct ResidencyStats
+{
+	uint64_t	residentBytes = 0;
+	// What would be resident if every request was granted
+	uint64_t	requestedBytes = 0;
+	// Of the last update
+	uint64_t	streamedInBytes = 0;
+	uint64_t	evictedBytes = 0;
+	// Textures still short of the mip they asked for
+	uint32_t	pendingTextures = 0;
+};
+
+// Decides which mips of the streamed textures are resident, without any graphics API so the policy
+// can be run headless. The renderer requests the mip every texture is sampled at, then applies the
+// changes Update hands back.
+//
+// The mip tail of a texture (every mip from the tail mip down) is resident from the start and is
+// never evicted. More detailed mips are granted to the textures furthest from their request first,
+// up to an upload limit per update. When they don't fit in the budget, the least recently requested
+// textures give back their detailed mips, one mip at a time, but never below what they requested
+// in the same update.
+class TextureResidency
+{
+public:
+	TextureResidency() = default;
+	~TextureResidency() = default;
+
+	void SetBudget(uint64_t);
+	// Bytes streamed in per update, at least one mip is always granted
+	void SetUploadLimit(uint64_t);
+
+	// Size of every mip in bytes, most detailed first, and the first mip of the tail.
+	// Returns the index of the texture.
+	uint32_t AddTexture(const std::vector<uint64_t>&, uint32_t);
+	void Clear();
+
+	// Most detailed mip the texture is sampled at this update, the lowest of all requests wins
+	void Request(uint32_t, uint32_t);
+
+	// Grants and evicts, appends one change per texture whose resident mips changed and clears the requests
+	void Update(std::vector<ResidencyChange>&);
+
+	uint32_t GetResidentMip(uint32_t) const;
+	uint32_t GetTailMip(uint32_t) const;
+	uint32_t GetMipCount(uint32_t) const;
+	uint32_t GetTextureCount() const { return (uint32_t)mTextures.size(); }
+	uint64_t GetBudget() const { return mBudget; }
+	const ResidencyStats& GetStats() const { return mStats; }
+
+	// Mip a surface is sampled at: log2 of texels per pixel, for a surface with the given texels per
+	// world unit seen from the given distance with the given vertical field of view (radians) and
+	// viewport height. Clamped to the mip count.
+	static uint32_t ComputeRequiredMip(float, float, float, float, uint32_t);
+
+private:
+
+	struct ResidentTexture
+	{
+		std::vector<uint64_t>	mipBytes;
+		uint32_t				tailMip = 0;
+		uint32_t				residentMip = 0;
+		// Lowest request of the current update, the tail mip when there was none
+		uint32_t				requestedMip = 0;
+		bool					isRequested = false;
+		uint64_t				lastRequestedUpdate = 0;
+	};
+
+	uint64_t GetBytes(const ResidentTexture&, uint32_t, uint32_t) const;
+	// Bytes textures other than the given one can give back without going below their floor
+	uint64_t GetEvictableBytes(uint32_t) const;
+	// Least recently requested first, until at least the given number of bytes are freed
+	void Evict(uint64_t, uint32_t);
+	// Least detailed mip eviction may leave a texture at
+	uint32_t GetEvictionFloor(const ResidentTexture&) const;
+
+	std::vector<ResidentTexture> mTextures;
+	// Texture indices from least to most recently requested, rebuilt every update
+	std::vector<uint32_t> mEvictionOrder;
+
+	uint64_t mBudget = UINT64_MAX;
+	uint64_t mUploadLimit = UINT64_MAX;
+	uint64_t mResidentBytes = 0;
+	uint64_t mUpdate = 0;
+
+	ResidencyStats mStats;
+};
\ No newline at end of file
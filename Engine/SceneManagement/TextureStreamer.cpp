@@ -0,0 +1,331 @@
+#include "TextureStreamer.h"
+#include "../Utilities/Profiler.h"
+
+#include <iomanip>
+
+using Microsoft::WRL::ComPtr;
+
+TextureStreamerSettings TextureStreamer::mSettings;
+TextureResidency TextureStreamer::mResidency;
+
+ComPtr<ID3D12Device> TextureStreamer::md3dDevice;
+ComPtr<ID3D12DescriptorHeap> TextureStreamer::mSrvDescriptorHeap;
+UINT TextureStreamer::mSrvDescriptorSize = 0;
+
+std::vector<TextureStreamer::StreamedTexture> TextureStreamer::mTextures;
+std::vector<TextureStreamer::StreamedObject> TextureStreamer::mObjects;
+std::vector<ResidencyChange> TextureStreamer::mChanges;
+std::vector<TextureStreamer::RetiredResource> TextureStreamer::mRetiredResources;
+
+void TextureStreamer::Initialize(const TextureStreamerSettings& settings)
+{
+	mSettings = settings;
+}
+
+void TextureStreamer::BeginScene(ComPtr<ID3D12Device> device, UINT textureCapacity)
+{
+	UnloadScene();
+
+	md3dDevice = device;
+	mSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	mResidency.SetBudget(mSettings.budgetBytes);
+	mResidency.SetUploadLimit(mSettings.uploadBytesPerFrame);
+
+	mTextures.reserve(textureCapacity);
+
+	// Not shader visible, the passes copy the descriptors into tables of the global heap
+	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
+	srvHeapDesc.NumDescriptors = std::max(textureCapacity, 1u);
+	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvDescriptorHeap)));
+}
+
+void TextureStreamer::LoadTextures(ID3D12GraphicsCommandList* cmdList, const std::vector<Texture*>& textures)
+{
+	PROFILE_SCOPE("TextureStreamer::LoadTextures");
+
+	if (mTextures.size() + textures.size() > mSrvDescriptorHeap->GetDesc().NumDescriptors)
+		throw DxException(E_INVALIDARG, L"TextureStreamer::LoadTextures", AnsiToWString(__FILE__), __LINE__);
+
+	// Only plain 2D textures are streamed, anything else uploads every mip and is rejected below
+	TextureUploadBatch batch;
+	TextureUploader::LoadTextures(cmdList, textures, [](const DDSDescription& description)
+	{
+		bool isStreamable = description.dimension == DDS_DIMENSION_TEXTURE2D && !description.isCubeMap && description.arraySize == 1;
+
+		return isStreamable ? GetTailMip(description) : 0;
+	}, batch);
+
+	for (uint32_t i = 0; i < batch.GetCount(); ++i)
+	{
+		TextureUpload& upload = batch.GetUpload(i);
+		const DDSDescription& description = upload.image->GetDescription();
+
+		if (description.dimension != DDS_DIMENSION_TEXTURE2D || description.isCubeMap || description.arraySize != 1)
+			throw DxException(E_INVALIDARG, L"TextureStreamer::LoadTextures(" + textures[i]->Filename + L")", AnsiToWString(__FILE__), __LINE__);
+
+		std::vector<uint64_t> mipBytes(description.mipCount);
+
+		for (uint32_t mip = 0; mip < description.mipCount; ++mip)
+			mipBytes[mip] = upload.image->GetSubresource(mip, 0).size;
+
+		StreamedTexture streamedTexture;
+		streamedTexture.texture = textures[i];
+		streamedTexture.desc = CD3DX12_RESOURCE_DESC::Tex2D(description.format, description.width, description.height, 1,
+			(UINT16)description.mipCount);
+		// Stays open, the detailed mips are streamed from it
+		streamedTexture.image = std::move(upload.image);
+
+		mResidency.AddTexture(mipBytes, upload.firstMip);
+		mTextures.push_back(std::move(streamedTexture));
+
+		CreateShaderResourceView((UINT)mTextures.size() - 1);
+	}
+}
+
+void TextureStreamer::AddObject(const DirectX::XMFLOAT3& center, float radius, float uvDensity, UINT diffuseTexture, UINT normalTexture)
+{
+	StreamedObject object;
+	object.center = center;
+	object.radius = radius;
+	object.uvDensity = uvDensity;
+	object.textures[0] = diffuseTexture;
+	object.textures[1] = normalTexture;
+
+	mObjects.push_back(object);
+}
+
+void TextureStreamer::UnloadScene()
+{
+	ReleaseRetired(UINT64_MAX);
+
+	// Closes the DDS files, the resources belong to the scene's textures
+	mTextures.clear();
+	mObjects.clear();
+	mChanges.clear();
+	mResidency.Clear();
+
+	mSrvDescriptorHeap = nullptr;
+}
+
+void TextureStreamer::Update(ID3D12GraphicsCommandList* cmdList, const DirectX::XMFLOAT3& eyePosition, const DirectX::XMFLOAT3& forwardDirection,
+	float fovY, float viewportHeight, UINT64 completedFence, UINT64 frameFence)
+{
+	PROFILE_SCOPE("TextureStreamer::Update");
+
+	ReleaseRetired(completedFence);
+
+	for (const StreamedObject& object : mObjects)
+	{
+		float dx = object.center.x - eyePosition.x;
+		float dy = object.center.y - eyePosition.y;
+		float dz = object.center.z - eyePosition.z;
+
+		// Objects entirely behind the camera are not requested, so their textures are the first to be evicted
+		if (dx * forwardDirection.x + dy * forwardDirection.y + dz * forwardDirection.z < -object.radius)
+			continue;
+
+		// Nearest point of the bounds, the whole object gets the mip its closest part needs
+		float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - object.radius;
+
+		for (UINT textureIndex : object.textures)
+		{
+			if (textureIndex >= mTextures.size())
+				continue;
+
+			const DDSDescription& description = mTextures[textureIndex].image->GetDescription();
+			float texelsPerWorldUnit = object.uvDensity * (float)std::max(description.width, description.height);
+
+			mResidency.Request(textureIndex, TextureResidency::ComputeRequiredMip(texelsPerWorldUnit, distance, fovY,
+				viewportHeight, description.mipCount));
+		}
+	}
+
+	mChanges.clear();
+	mResidency.Update(mChanges);
+
+	for (const ResidencyChange& change : mChanges)
+		ApplyChange(cmdList, change, frameFence);
+}
+
+void TextureStreamer::CopyDescriptors(D3D12_CPU_DESCRIPTOR_HANDLE destination)
+{
+	if (mTextures.empty())
+		return;
+
+	md3dDevice->CopyDescriptorsSimple((UINT)mTextures.size(), destination,
+		mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+UINT TextureStreamer::GetTextureCount()
+{
+	return (UINT)mTextures.size();
+}
+
+uint64_t TextureStreamer::GetResidentBytes()
+{
+	return mResidency.GetStats().residentBytes;
+}
+
+const ResidencyStats& TextureStreamer::GetStats()
+{
+	return mResidency.GetStats();
+}
+
+std::string TextureStreamer::GetReport()
+{
+	const ResidencyStats& stats = mResidency.GetStats();
+
+	std::ostringstream report;
+	report << std::fixed << std::setprecision(2);
+	report << "Streamed textures: " << mTextures.size() << ", " << stats.residentBytes / (1024.0 * 1024.0) << " MB resident of "
+		<< mSettings.budgetBytes / (1024.0 * 1024.0) << " MB budget, " << stats.requestedBytes / (1024.0 * 1024.0) << " MB requested, "
+		<< stats.pendingTextures << " pending\n";
+
+	for (UINT i = 0; i < (UINT)mTextures.size(); ++i)
+	{
+		const DDSDescription& description = mTextures[i].image->GetDescription();
+		uint32_t residentMip = mResidency.GetResidentMip(i);
+
+		report << std::left << std::setw(40) << mTextures[i].texture->Name << std::right
+			<< " mip " << residentMip << " (" << std::max(1u, description.width >> residentMip) << "x" << std::max(1u, description.height >> residentMip)
+			<< "), tail " << mResidency.GetTailMip(i) << " of " << description.mipCount << "\n";
+	}
+
+	return report.str();
+}
+
+uint32_t TextureStreamer::GetTailMip(const DDSDescription& description)
+{
+	uint32_t tailMip = 0;
+
+	while (tailMip + 1 < description.mipCount && std::max(description.width >> tailMip, description.height >> tailMip) > mSettings.tailSize)
+		++tailMip;
+
+	// Every resident range starts with a level the resource is created from, so each level down to the
+	// tail must halve exactly and stay a multiple of the 4x4 blocks of compressed formats
+	while (tailMip > 0 && ((description.width >> tailMip) << tailMip != description.width
+		|| (description.height >> tailMip) << tailMip != description.height
+		|| (description.width >> tailMip) % 4 != 0 || (description.height >> tailMip) % 4 != 0))
+		--tailMip;
+
+	return tailMip;
+}
+
+D3D12_RESOURCE_DESC TextureStreamer::GetResourceDesc(const StreamedTexture& streamedTexture, uint32_t residentMip)
+{
+	D3D12_RESOURCE_DESC resourceDesc = streamedTexture.desc;
+	resourceDesc.Width = std::max<UINT64>(1, streamedTexture.desc.Width >> residentMip);
+	resourceDesc.Height = std::max<UINT>(1, streamedTexture.desc.Height >> residentMip);
+	resourceDesc.MipLevels = (UINT16)(streamedTexture.desc.MipLevels - residentMip);
+
+	return resourceDesc;
+}
+
+void TextureStreamer::CreateShaderResourceView(UINT textureIndex)
+{
+	ID3D12Resource* resource = mTextures[textureIndex].texture->Resource.Get();
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Format = resource->GetDesc().Format;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = resource->GetDesc().MipLevels;
+	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), textureIndex, mSrvDescriptorSize);
+
+	md3dDevice->CreateShaderResourceView(resource, &srvDesc, hDescriptor);
+}
+
+void TextureStreamer::ApplyChange(ID3D12GraphicsCommandList* cmdList, const ResidencyChange& change, UINT64 frameFence)
+{
+	StreamedTexture& streamedTexture = mTextures[change.texture];
+	Texture* texture = streamedTexture.texture;
+	uint32_t mipCount = streamedTexture.desc.MipLevels;
+
+	D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(streamedTexture, change.residentMip);
+
+	ComPtr<ID3D12Resource> resource;
+
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&resource)));
+
+	d3dUtil::TrackResource(md3dDevice.Get(), resource.Get(), MemoryCategory::Textures);
+
+	// The mips both resources hold are copied on the GPU. The old resource stays a copy source until
+	// it is released, the frames sampling it were submitted before this one.
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(texture->Resource.Get(),
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+	for (uint32_t mip = std::max(change.residentMip, change.previousMip); mip < mipCount; ++mip)
+	{
+		CD3DX12_TEXTURE_COPY_LOCATION destination(resource.Get(), mip - change.residentMip);
+		CD3DX12_TEXTURE_COPY_LOCATION source(texture->Resource.Get(), mip - change.previousMip);
+
+		cmdList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+	}
+
+	// Streamed in mips come from the file
+	ComPtr<ID3D12Resource> uploadHeap;
+
+	if (change.residentMip < change.previousMip)
+	{
+		TextureUploader::UploadMips(cmdList, *streamedTexture.image, resource.Get(), change.residentMip, change.residentMip,
+			change.previousMip, uploadHeap);
+
+		// Only set when the staging ring was full
+		if (uploadHeap != nullptr)
+			d3dUtil::TrackResource(md3dDevice.Get(), uploadHeap.Get(), MemoryCategory::Staging);
+	}
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+	Retire(texture->Resource, frameFence);
+	Retire(uploadHeap, frameFence);
+
+	texture->Resource = resource;
+
+	// Later frames pick the new view up when their pass copies the descriptors
+	CreateShaderResourceView(change.texture);
+}
+
+void TextureStreamer::Retire(ComPtr<ID3D12Resource>& resource, UINT64 fence)
+{
+	if (resource == nullptr)
+		return;
+
+	RetiredResource retiredResource;
+	retiredResource.resource = resource;
+	retiredResource.fence = fence;
+
+	mRetiredResources.push_back(retiredResource);
+	resource = nullptr;
+}
+
+void TextureStreamer::ReleaseRetired(UINT64 completedFence)
+{
+	size_t keptCount = 0;
+
+	for (size_t i = 0; i < mRetiredResources.size(); ++i)
+	{
+		if (mRetiredResources[i].fence <= completedFence)
+		{
+			MemoryTracker::Untrack(mRetiredResources[i].resource.Get());
+			continue;
+		}
+
+		mRetiredResources[keptCount++] = mRetiredResources[i];
+	}
+
+	mRetiredResources.resize(keptCount);
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Texture.h"
+#include "TextureResidency.h"
+#include "TextureUploader.h"
+
+struct TextureStreamerSettings
+{
+	// Device memory of the streamed textures, mip tails included
+	uint64_t	budgetBytes = 256ull * 1024 * 1024;
+	// Bytes streamed in per frame, which also bounds the staging memory a frame allocates
+	uint64_t	uploadBytesPerFrame = 16ull * 1024 * 1024;
+	// Mips up to this size are uploaded with the scene and stay resident
+	uint32_t	tailSize = 128;
+};
+
+// Streams the mips of the scene's material textures. Loading the scene only uploads the mip tail of
+// every texture, the more detailed mips are streamed in while rendering, as the objects come close
+// enough to need them, within a memory budget (TextureResidency decides which).
+//
+// A texture's resource only holds its resident mips. Streaming in or evicting creates a new resource,
+// the mips both hold are copied on the GPU and the new ones are uploaded from the memory mapped DDS
+// file. The old resource is released once the frames that could sample it completed. Shaders see
+// the textures through SRVs in a CPU only heap that the passes copy from every frame.
+class TextureStreamer
+{
+public:
+	TextureStreamer() = default;
+	~TextureStreamer() = default;
+
+	static void Initialize(const TextureStreamerSettings&);
+
+	// Prepares for the textures of a new scene, with room for the given number of textures
+	static void BeginScene(Microsoft::WRL::ComPtr<ID3D12Device>, UINT);
+	// Records the upload of the textures' mip tails, through TextureUploader, and sets their resources.
+	// The SRVs are numbered in load order.
+	static void LoadTextures(ID3D12GraphicsCommandList*, const std::vector<Texture*>&);
+	// A render object sampling the given two textures, with its world space bounding sphere and texture density
+	static void AddObject(const DirectX::XMFLOAT3&, float, float, UINT, UINT);
+	// Releases everything, the GPU must be done with the scene
+	static void UnloadScene();
+
+	// Requests the mips the objects in front of the camera need, given its position, unit forward direction,
+	// vertical field of view and viewport height, and records the resulting copies. Takes the last completed
+	// fence value and the one the frame being recorded will signal.
+	static void Update(ID3D12GraphicsCommandList*, const DirectX::XMFLOAT3&, const DirectX::XMFLOAT3&, float, float, UINT64, UINT64);
+
+	// Copies the SRVs of all the textures, in load order, to consecutive descriptors
+	static void CopyDescriptors(D3D12_CPU_DESCRIPTOR_HANDLE);
+
+	static UINT GetTextureCount();
+	static uint64_t GetResidentBytes();
+	static const ResidencyStats& GetStats();
+
+	// Resident mips and bytes of every texture as a printable table
+	static std::string GetReport();
+
+private:
+
+	struct StreamedTexture
+	{
+		Texture* texture = nullptr;
+		std::unique_ptr<DDSImage> image;
+		D3D12_RESOURCE_DESC desc = {};
+	};
+
+	struct StreamedObject
+	{
+		DirectX::XMFLOAT3 center;
+		float radius = 0.0f;
+		float uvDensity = 0.0f;
+		UINT textures[2];
+	};
+
+	struct RetiredResource
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		UINT64 fence = 0;
+	};
+
+	static uint32_t GetTailMip(const DDSDescription&);
+	static D3D12_RESOURCE_DESC GetResourceDesc(const StreamedTexture&, uint32_t);
+	static void CreateShaderResourceView(UINT);
+	static void ApplyChange(ID3D12GraphicsCommandList*, const ResidencyChange&, UINT64);
+	static void Retire(Microsoft::WRL::ComPtr<ID3D12Resource>&, UINT64);
+	static void ReleaseRetired(UINT64);
+
+	static TextureStreamerSettings mSettings;
+	static TextureResidency mResidency;
+
+	static Microsoft::WRL::ComPtr<ID3D12Device> md3dDevice;
+	static Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap;
+	static UINT mSrvDescriptorSize;
+
+	static std::vector<StreamedTexture> mTextures;
+	static std::vector<StreamedObject> mObjects;
+	static std::vector<ResidencyChange> mChanges;
+	static std::vector<RetiredResource> mRetiredResources;
+};
\ No newline at end of file
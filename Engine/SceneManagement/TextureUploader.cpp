@@ -0,0 +1,239 @@
+#include "TextureUploader.h"
+#include "../Utilities/Profiler.h"
+#include "../Utilities/ThreadPool.h"
+
+using Microsoft::WRL::ComPtr;
+
+ComPtr<ID3D12Device> TextureUploader::md3dDevice;
+ComPtr<ID3D12Resource> TextureUploader::mStagingBuffer;
+uint8_t* TextureUploader::mStagingData = nullptr;
+StagingRing TextureUploader::mStagingRing;
+
+void TextureUploader::Initialize(ComPtr<ID3D12Device> device, uint64_t stagingBytes)
+{
+	Shutdown();
+
+	md3dDevice = device;
+
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(stagingBytes),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&mStagingBuffer)));
+
+	d3dUtil::TrackResource(md3dDevice.Get(), mStagingBuffer.Get(), MemoryCategory::Staging);
+
+	// Stays mapped, upload heaps are write combined and only ever written here
+	ThrowIfFailed(mStagingBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mStagingData)));
+
+	mStagingRing.Reset(stagingBytes);
+}
+
+void TextureUploader::Shutdown()
+{
+	if (mStagingBuffer != nullptr)
+	{
+		mStagingBuffer->Unmap(0, nullptr);
+		MemoryTracker::Untrack(mStagingBuffer.Get());
+	}
+
+	mStagingBuffer = nullptr;
+	mStagingData = nullptr;
+	mStagingRing.Reset(0);
+	md3dDevice = nullptr;
+}
+
+void TextureUploader::OpenTextures(const std::vector<Texture*>& textures,
+	const std::function<uint32_t(const DDSDescription&)>& selectFirstMip, TextureUploadBatch& batch)
+{
+	batch.Clear();
+
+	// The asset paths are plain ASCII
+	for (Texture* texture : textures)
+	{
+		std::string filePath;
+
+		for (wchar_t character : texture->Filename)
+			filePath += (char)character;
+
+		batch.Add(filePath);
+	}
+
+	PROFILE_SCOPE("TextureUploadBatch::Open");
+
+	if (!batch.Open(selectFirstMip))
+	{
+		for (uint32_t i = 0; i < batch.GetCount(); ++i)
+		{
+			if (!batch.GetUpload(i).isLoaded)
+				throw DxException(E_FAIL, L"DDSImage::Load(" + textures[i]->Filename + L")", AnsiToWString(__FILE__), __LINE__);
+		}
+	}
+}
+
+void TextureUploader::LoadTextures(ID3D12GraphicsCommandList* cmdList, const std::vector<Texture*>& textures,
+	const std::function<uint32_t(const DDSDescription&)>& selectFirstMip, TextureUploadBatch& batch)
+{
+	PROFILE_SCOPE("TextureUploader::LoadTextures");
+
+	OpenTextures(textures, selectFirstMip, batch);
+
+	for (uint32_t i = 0; i < batch.GetCount(); ++i)
+	{
+		const TextureUpload& upload = batch.GetUpload(i);
+		D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(upload.image->GetDescription(), upload.firstMip);
+
+		ThrowIfFailed(md3dDevice->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+			D3D12_HEAP_FLAG_NONE,
+			&resourceDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(textures[i]->Resource.ReleaseAndGetAddressOf())));
+	}
+
+	{
+		PROFILE_SCOPE("TextureUploadBatch::Stage");
+
+		batch.Stage(mStagingRing, mStagingData);
+	}
+
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+
+	for (uint32_t i = 0; i < batch.GetCount(); ++i)
+	{
+		const TextureUpload& upload = batch.GetUpload(i);
+		const DDSDescription& description = upload.image->GetDescription();
+
+		if (upload.isStaged)
+		{
+			RecordCopies(cmdList, textures[i]->Resource.Get(), mStagingBuffer.Get(), upload.stagingOffset, description,
+				upload.firstMip, upload.footprints);
+		}
+		else
+		{
+			textures[i]->UploadHeap = CreateUploadHeap(*upload.image, upload.stagingSize, upload.footprints);
+
+			RecordCopies(cmdList, textures[i]->Resource.Get(), textures[i]->UploadHeap.Get(), 0, description,
+				upload.firstMip, upload.footprints);
+		}
+
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(textures[i]->Resource.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	}
+
+	// All transitions in one call, after every copy of the batch
+	if (!barriers.empty())
+		cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+}
+
+void TextureUploader::UploadMips(ID3D12GraphicsCommandList* cmdList, const DDSImage& image, ID3D12Resource* resource,
+	uint32_t residentMip, uint32_t firstMip, uint32_t endMip, ComPtr<ID3D12Resource>& uploadHeap)
+{
+	std::vector<UploadFootprint> footprints;
+	uint64_t stagingSize = TextureUploadBatch::ComputeLayout(image, firstMip, endMip, footprints);
+	uint64_t stagingOffset = 0;
+
+	if (mStagingData != nullptr && mStagingRing.Allocate(stagingSize, TextureUploadBatch::PlacementAlignment, stagingOffset))
+	{
+		for (const UploadFootprint& footprint : footprints)
+			TextureUploadBatch::CopyToStaging(image, footprint, mStagingData + stagingOffset);
+
+		RecordCopies(cmdList, resource, mStagingBuffer.Get(), stagingOffset, image.GetDescription(), residentMip, footprints);
+		return;
+	}
+
+	uploadHeap = CreateUploadHeap(image, stagingSize, footprints);
+
+	RecordCopies(cmdList, resource, uploadHeap.Get(), 0, image.GetDescription(), residentMip, footprints);
+}
+
+void TextureUploader::Retire(UINT64 fence)
+{
+	mStagingRing.Retire(fence);
+}
+
+void TextureUploader::Release(UINT64 completedFence)
+{
+	mStagingRing.Release(completedFence);
+}
+
+void TextureUploader::ReleaseAll()
+{
+	mStagingRing.Retire(0);
+	mStagingRing.Release(UINT64_MAX);
+}
+
+uint64_t TextureUploader::GetCapacity()
+{
+	return mStagingRing.GetCapacity();
+}
+
+uint64_t TextureUploader::GetPeakUsedBytes()
+{
+	return mStagingRing.GetPeakUsedBytes();
+}
+
+D3D12_RESOURCE_DESC TextureUploader::GetResourceDesc(const DDSDescription& description, uint32_t firstMip)
+{
+	UINT64 width = std::max<UINT64>(1, description.width >> firstMip);
+	UINT height = std::max<UINT>(1, description.height >> firstMip);
+	UINT16 mipLevels = (UINT16)(description.mipCount - firstMip);
+
+	if (description.dimension == DDS_DIMENSION_TEXTURE3D)
+		return CD3DX12_RESOURCE_DESC::Tex3D(description.format, width, height, (UINT16)std::max<UINT>(1, description.depth >> firstMip), mipLevels);
+
+	// Cube maps are 2D arrays of six faces per cube, like the DDS loader creates them
+	return CD3DX12_RESOURCE_DESC::Tex2D(description.format, width, height, (UINT16)description.arraySize, mipLevels);
+}
+
+void TextureUploader::RecordCopies(ID3D12GraphicsCommandList* cmdList, ID3D12Resource* resource, ID3D12Resource* stagingBuffer,
+	uint64_t stagingOffset, const DDSDescription& description, uint32_t residentMip, const std::vector<UploadFootprint>& footprints)
+{
+	UINT resourceMipLevels = description.mipCount - residentMip;
+
+	for (const UploadFootprint& footprint : footprints)
+	{
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT placedFootprint = {};
+		placedFootprint.Offset = stagingOffset + footprint.offset;
+		placedFootprint.Footprint.Format = description.format;
+		placedFootprint.Footprint.Width = footprint.width;
+		placedFootprint.Footprint.Height = footprint.height;
+		placedFootprint.Footprint.Depth = footprint.depth;
+		placedFootprint.Footprint.RowPitch = footprint.rowPitch;
+
+		CD3DX12_TEXTURE_COPY_LOCATION destination(resource, (footprint.mip - residentMip) + footprint.arraySlice * resourceMipLevels);
+		CD3DX12_TEXTURE_COPY_LOCATION source(stagingBuffer, placedFootprint);
+
+		cmdList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+	}
+}
+
+ComPtr<ID3D12Resource> TextureUploader::CreateUploadHeap(const DDSImage& image, uint64_t stagingSize,
+	const std::vector<UploadFootprint>& footprints)
+{
+	ComPtr<ID3D12Resource> uploadHeap;
+
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(stagingSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&uploadHeap)));
+
+	uint8_t* stagingData = nullptr;
+	ThrowIfFailed(uploadHeap->Map(0, nullptr, reinterpret_cast<void**>(&stagingData)));
+
+	ThreadPool::ParallelFor(footprints.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			TextureUploadBatch::CopyToStaging(image, footprints[i], stagingData);
+	});
+
+	uploadHeap->Unmap(0, nullptr);
+
+	return uploadHeap;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Texture.h"
+#include "../Utilities/d3dUtil.h"
+#include "../Utilities/TextureUploadBatch.h"
+
+// Uploads textures through one persistently mapped upload buffer shared by scene loading and
+// streaming, suballocated as a ring (StagingRing). Loading reads and stages the files of a whole
+// batch in parallel and records all of its copies and barriers together. Whatever doesn't fit in
+// the ring gets an upload heap of its own, as every texture used to.
+class TextureUploader
+{
+public:
+	TextureUploader() = default;
+	~TextureUploader() = default;
+
+	// Creates the staging ring with the given size in bytes
+	static void Initialize(Microsoft::WRL::ComPtr<ID3D12Device>, uint64_t);
+	static void Shutdown();
+
+	// Adds the DDS files of the textures to the batch and opens them, see TextureUploadBatch::Open.
+	// Throws if a file can't be loaded.
+	static void OpenTextures(const std::vector<Texture*>&, const std::function<uint32_t(const DDSDescription&)>&,
+		TextureUploadBatch&);
+	// Loads the DDS files of the textures, creates their resources and records the uploads. The function
+	// picks the first mip every resource holds, see TextureUploadBatch::Open. Throws if a file can't be
+	// loaded. The batch keeps the images open for callers that read from them later.
+	static void LoadTextures(ID3D12GraphicsCommandList*, const std::vector<Texture*>&,
+		const std::function<uint32_t(const DDSDescription&)>&, TextureUploadBatch&);
+
+	// Records the upload of the image's mips in [first, end) to a resource whose most detailed mip is
+	// the given one. Sets the upload heap when the ring had no room, the caller releases it once the
+	// GPU is done with it.
+	static void UploadMips(ID3D12GraphicsCommandList*, const DDSImage&, ID3D12Resource*, uint32_t, uint32_t, uint32_t,
+		Microsoft::WRL::ComPtr<ID3D12Resource>&);
+
+	// Hands the allocations recorded since the last call the fence of the submission reading them
+	static void Retire(UINT64);
+	// Frees the ring space of the submissions up to the completed fence
+	static void Release(UINT64);
+	// Frees all ring space, the GPU must be idle
+	static void ReleaseAll();
+
+	static uint64_t GetCapacity();
+	static uint64_t GetPeakUsedBytes();
+
+	// Resource holding the image's mips from the given one down, 2D arrays for cube maps
+	static D3D12_RESOURCE_DESC GetResourceDesc(const DDSDescription&, uint32_t);
+	// Records the copies of subresources staged at the given offset of a buffer to a resource whose most
+	// detailed mip is the given one. Works on direct and copy command lists.
+	static void RecordCopies(ID3D12GraphicsCommandList*, ID3D12Resource*, ID3D12Resource*, uint64_t, const DDSDescription&, uint32_t,
+		const std::vector<UploadFootprint>&);
+
+private:
+
+	// Upload heap of its own for staging that doesn't fit in the ring, filled on the thread pool
+	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateUploadHeap(const DDSImage&, uint64_t, const std::vector<UploadFootprint>&);
+
+	static Microsoft::WRL::ComPtr<ID3D12Device> md3dDevice;
+	static Microsoft::WRL::ComPtr<ID3D12Resource> mStagingBuffer;
+	static uint8_t* mStagingData;
+	static StagingRing mStagingRing;
+};
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "UploadService.h"
+#include "../Utilities/Profiler.h"
+
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+ComPtr<ID3D12Device> UploadService::md3dDevice;
+ComPtr<ID3D12CommandQueue> UploadService::mCommandQueue;
+ComPtr<ID3D12GraphicsCommandList> UploadService::mCommandList;
+ComPtr<ID3D12Fence> UploadService::mFence;
+UINT64 UploadService::mFenceValue = 0;
+
+std::vector<UploadService::CommandAllocator> UploadService::mCommandAllocators;
+
+ComPtr<ID3D12Resource> UploadService::mStagingBuffer;
+uint8_t* UploadService::mStagingData = nullptr;
+StagingRing UploadService::mStagingRing;
+UploadQueue UploadService::mUploadQueue;
+
+std::vector<ComPtr<ID3D12Resource>> UploadService::mRecordedUploadHeaps;
+std::vector<UploadService::RetiredUploadHeap> UploadService::mRetiredUploadHeaps;
+
+void UploadService::Initialize(ComPtr<ID3D12Device> device, uint64_t stagingBytes)
+{
+	md3dDevice = device;
+
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	ThrowIfFailed(md3dDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&mCommandQueue)));
+
+	ThrowIfFailed(md3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+	mFenceValue = 0;
+
+	mStagingBuffer = CreateUploadHeap(stagingBytes, &mStagingData);
+	d3dUtil::TrackResource(md3dDevice.Get(), mStagingBuffer.Get(), MemoryCategory::Staging);
+
+	mStagingRing.Reset(stagingBytes);
+}
+
+void UploadService::Shutdown()
+{
+	if (md3dDevice == nullptr)
+		return;
+
+	Wait(GetLastTicket());
+
+	MemoryTracker::Untrack(mStagingBuffer.Get());
+
+	for (RetiredUploadHeap& retiredUploadHeap : mRetiredUploadHeaps)
+		MemoryTracker::Untrack(retiredUploadHeap.uploadHeap.Get());
+
+	mRetiredUploadHeaps.clear();
+	mRecordedUploadHeaps.clear();
+	mCommandAllocators.clear();
+
+	mStagingBuffer = nullptr;
+	mStagingData = nullptr;
+	mStagingRing.Reset(0);
+
+	mCommandList = nullptr;
+	mCommandQueue = nullptr;
+	mFence = nullptr;
+	md3dDevice = nullptr;
+}
+
+UploadTicket UploadService::UploadBuffer(ID3D12Resource* destination, const void* data, uint64_t size)
+{
+	// Anything the ring can never hold is staged right away in an upload heap of its own
+	if (size > mStagingRing.GetCapacity())
+	{
+		uint8_t* uploadData = nullptr;
+		ComPtr<ID3D12Resource> uploadHeap = CreateUploadHeap(size, &uploadData);
+
+		memcpy(uploadData, data, (size_t)size);
+		d3dUtil::TrackResource(md3dDevice.Get(), uploadHeap.Get(), MemoryCategory::Staging);
+
+		return mUploadQueue.Enqueue(0, 1, nullptr, [destination, uploadHeap, size](uint64_t)
+		{
+			mCommandList->CopyBufferRegion(destination, 0, uploadHeap.Get(), 0, size);
+			mRecordedUploadHeaps.push_back(uploadHeap);
+		});
+	}
+
+	// The caller's memory may be gone by the time the upload is packed
+	auto bufferData = std::make_shared<std::vector<uint8_t>>((const uint8_t*)data, (const uint8_t*)data + size);
+
+	return mUploadQueue.Enqueue(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, [bufferData](uint8_t* stagingData)
+	{
+		memcpy(stagingData, bufferData->data(), bufferData->size());
+	}, [destination, size](uint64_t stagingOffset)
+	{
+		mCommandList->CopyBufferRegion(destination, 0, mStagingBuffer.Get(), stagingOffset, size);
+	});
+}
+
+UploadTicket UploadService::UploadTexture(ID3D12Resource* destination, std::shared_ptr<const DDSImage> image, uint32_t firstMip)
+{
+	// Laid out on the calling thread
+	auto footprints = std::make_shared<std::vector<UploadFootprint>>();
+	uint64_t stagingSize = TextureUploadBatch::ComputeLayout(*image, firstMip, image->GetDescription().mipCount, *footprints);
+
+	if (stagingSize > mStagingRing.GetCapacity())
+	{
+		uint8_t* uploadData = nullptr;
+		ComPtr<ID3D12Resource> uploadHeap = CreateUploadHeap(stagingSize, &uploadData);
+
+		for (const UploadFootprint& footprint : *footprints)
+			TextureUploadBatch::CopyToStaging(*image, footprint, uploadData);
+
+		d3dUtil::TrackResource(md3dDevice.Get(), uploadHeap.Get(), MemoryCategory::Staging);
+
+		return mUploadQueue.Enqueue(0, 1, nullptr, [destination, image, firstMip, footprints, uploadHeap](uint64_t)
+		{
+			TextureUploader::RecordCopies(mCommandList.Get(), destination, uploadHeap.Get(), 0, image->GetDescription(), firstMip, *footprints);
+			mRecordedUploadHeaps.push_back(uploadHeap);
+		});
+	}
+
+	return mUploadQueue.Enqueue(stagingSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, [image, footprints](uint8_t* stagingData)
+	{
+		for (const UploadFootprint& footprint : *footprints)
+			TextureUploadBatch::CopyToStaging(*image, footprint, stagingData);
+	}, [destination, image, firstMip, footprints](uint64_t stagingOffset)
+	{
+		TextureUploader::RecordCopies(mCommandList.Get(), destination, mStagingBuffer.Get(), stagingOffset, image->GetDescription(),
+			firstMip, *footprints);
+	});
+}
+
+ComPtr<ID3D12Resource> UploadService::CreateDefaultBuffer(const void* data, uint64_t size, UploadTicket& ticket)
+{
+	ComPtr<ID3D12Resource> defaultBuffer;
+
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(&defaultBuffer)));
+
+	ticket = UploadBuffer(defaultBuffer.Get(), data, size);
+
+	return defaultBuffer;
+}
+
+UploadTicket UploadService::LoadTextures(const std::vector<Texture*>& textures)
+{
+	PROFILE_SCOPE("UploadService::LoadTextures");
+
+	TextureUploadBatch batch;
+	TextureUploader::OpenTextures(textures, nullptr, batch);
+
+	UploadTicket ticket;
+
+	for (uint32_t i = 0; i < batch.GetCount(); ++i)
+	{
+		TextureUpload& upload = batch.GetUpload(i);
+		D3D12_RESOURCE_DESC resourceDesc = TextureUploader::GetResourceDesc(upload.image->GetDescription(), upload.firstMip);
+
+		ThrowIfFailed(md3dDevice->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+			D3D12_HEAP_FLAG_NONE,
+			&resourceDesc,
+			D3D12_RESOURCE_STATE_COMMON,
+			nullptr,
+			IID_PPV_ARGS(textures[i]->Resource.ReleaseAndGetAddressOf())));
+
+		ticket = UploadTexture(textures[i]->Resource.Get(), std::shared_ptr<const DDSImage>(std::move(upload.image)), upload.firstMip);
+	}
+
+	return ticket;
+}
+
+void UploadService::Submit()
+{
+	PROFILE_SCOPE("UploadService::Submit");
+
+	Complete();
+
+	if (mUploadQueue.GetWaitingCount() == 0)
+		return;
+
+	// An allocator whose last submission completed, or a new one
+	CommandAllocator* commandAllocator = nullptr;
+
+	for (CommandAllocator& candidate : mCommandAllocators)
+	{
+		if (candidate.fence <= mFence->GetCompletedValue())
+		{
+			commandAllocator = &candidate;
+			break;
+		}
+	}
+
+	if (commandAllocator == nullptr)
+	{
+		mCommandAllocators.push_back(CommandAllocator());
+		commandAllocator = &mCommandAllocators.back();
+
+		ThrowIfFailed(md3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&commandAllocator->allocator)));
+	}
+
+	ThrowIfFailed(commandAllocator->allocator->Reset());
+
+	if (mCommandList == nullptr)
+	{
+		ThrowIfFailed(md3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, commandAllocator->allocator.Get(), nullptr,
+			IID_PPV_ARGS(&mCommandList)));
+	}
+	else
+	{
+		ThrowIfFailed(mCommandList->Reset(commandAllocator->allocator.Get(), nullptr));
+	}
+
+	// Whatever doesn't fit in the ring now waits for the next submission
+	mUploadQueue.Pack(mStagingRing, mStagingData);
+
+	ThrowIfFailed(mCommandList->Close());
+
+	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
+	mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), ++mFenceValue));
+
+	commandAllocator->fence = mFenceValue;
+	mUploadQueue.Submit(mStagingRing, mFenceValue);
+
+	for (ComPtr<ID3D12Resource>& uploadHeap : mRecordedUploadHeaps)
+	{
+		RetiredUploadHeap retiredUploadHeap;
+		retiredUploadHeap.uploadHeap = uploadHeap;
+		retiredUploadHeap.fence = mFenceValue;
+		mRetiredUploadHeaps.push_back(retiredUploadHeap);
+	}
+
+	mRecordedUploadHeaps.clear();
+}
+
+bool UploadService::IsComplete(UploadTicket ticket)
+{
+	return mUploadQueue.IsComplete(ticket);
+}
+
+void UploadService::WaitOnQueue(ID3D12CommandQueue* commandQueue, UploadTicket ticket)
+{
+	SubmitThrough(ticket);
+
+	UINT64 fence = mUploadQueue.GetFence(ticket);
+
+	if (fence != 0)
+		ThrowIfFailed(commandQueue->Wait(mFence.Get(), fence));
+}
+
+void UploadService::Wait(UploadTicket ticket)
+{
+	SubmitThrough(ticket);
+
+	UINT64 fence = mUploadQueue.GetFence(ticket);
+
+	if (fence != 0)
+	{
+		WaitForFence(fence);
+		Complete();
+	}
+}
+
+UploadTicket UploadService::GetLastTicket()
+{
+	return mUploadQueue.GetLastTicket();
+}
+
+ComPtr<ID3D12Resource> UploadService::CreateUploadHeap(uint64_t size, uint8_t** data)
+{
+	ComPtr<ID3D12Resource> uploadHeap;
+
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&uploadHeap)));
+
+	// Upload heaps may stay mapped for as long as they live
+	ThrowIfFailed(uploadHeap->Map(0, nullptr, reinterpret_cast<void**>(data)));
+
+	return uploadHeap;
+}
+
+void UploadService::Complete()
+{
+	UINT64 completedFence = mFence->GetCompletedValue();
+
+	mUploadQueue.Complete(mStagingRing, completedFence);
+
+	size_t keptCount = 0;
+
+	for (size_t i = 0; i < mRetiredUploadHeaps.size(); ++i)
+	{
+		if (mRetiredUploadHeaps[i].fence <= completedFence)
+		{
+			MemoryTracker::Untrack(mRetiredUploadHeaps[i].uploadHeap.Get());
+			continue;
+		}
+
+		mRetiredUploadHeaps[keptCount++] = mRetiredUploadHeaps[i];
+	}
+
+	mRetiredUploadHeaps.resize(keptCount);
+}
+
+void UploadService::SubmitThrough(UploadTicket ticket)
+{
+	while (mUploadQueue.GetFence(ticket) == UINT64_MAX)
+	{
+		Submit();
+
+		// Uploads that didn't fit in the ring go out once the ones before them completed
+		if (mUploadQueue.GetFence(ticket) == UINT64_MAX)
+		{
+			WaitForFence(mFenceValue);
+			Complete();
+		}
+	}
+}
+
+void UploadService::WaitForFence(UINT64 fence)
+{
+	if (mFence->GetCompletedValue() >= fence)
+		return;
+
+	HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+	ThrowIfFailed(mFence->SetEventOnCompletion(fence, eventHandle));
+	WaitForSingleObject(eventHandle, INFINITE);
+	CloseHandle(eventHandle);
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "TextureUploader.h"
+#include "../Utilities/UploadQueue.h"
+
+// Uploads buffers and textures on a copy queue of its own, so the direct queue never records or
+// waits on them. Uploads can be requested from any thread and return a ticket. Submit(), called
+// once per frame by the render thread, packs them into the service's staging ring and submits them
+// with a fence. Rendering continues meanwhile, a queue that needs the data waits for the ticket on
+// the GPU with WaitOnQueue().
+//
+// Destinations are created in the COMMON state. Copy queue writes leave them there, and the direct
+// queue promotes buffers and read only textures implicitly on first use.
+class UploadService
+{
+public:
+	UploadService() = default;
+	~UploadService() = default;
+
+	// Creates the copy queue and a staging ring with the given size in bytes
+	static void Initialize(Microsoft::WRL::ComPtr<ID3D12Device>, uint64_t);
+	// Waits for every upload and releases everything
+	static void Shutdown();
+
+	// The data is copied before returning. Uploads larger than the staging ring get an upload heap
+	// of their own.
+	static UploadTicket UploadBuffer(ID3D12Resource*, const void*, uint64_t);
+	// Mips of the image from the given one down, to a texture created with TextureUploader::GetResourceDesc.
+	// The image stays open until it was copied to staging memory.
+	static UploadTicket UploadTexture(ID3D12Resource*, std::shared_ptr<const DDSImage>, uint32_t);
+
+	// Creates a default heap buffer in the COMMON state and requests the upload of its data
+	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(const void*, uint64_t, UploadTicket&);
+	// Loads the DDS files of the textures with all their mips, creates their resources in the COMMON
+	// state and requests their uploads. Throws if a file can't be loaded. Returns the last ticket.
+	static UploadTicket LoadTextures(const std::vector<Texture*>&);
+
+	// Completes the tickets of finished submissions and submits the uploads requested since the last call
+	static void Submit();
+
+	static bool IsComplete(UploadTicket);
+	// Makes the queue wait on the GPU until the ticket is complete, submitting it first if it wasn't yet
+	static void WaitOnQueue(ID3D12CommandQueue*, UploadTicket);
+	// Blocks the calling thread until the ticket is complete
+	static void Wait(UploadTicket);
+
+	static UploadTicket GetLastTicket();
+
+private:
+
+	struct CommandAllocator
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		UINT64 fence = 0;
+	};
+
+	struct RetiredUploadHeap
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> uploadHeap;
+		UINT64 fence = 0;
+	};
+
+	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateUploadHeap(uint64_t, uint8_t**);
+	static void Complete();
+	// Submits until the ticket went out, waiting for earlier submissions while the ring is full
+	static void SubmitThrough(UploadTicket);
+	static void WaitForFence(UINT64);
+
+	static Microsoft::WRL::ComPtr<ID3D12Device> md3dDevice;
+	static Microsoft::WRL::ComPtr<ID3D12CommandQueue> mCommandQueue;
+	static Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCommandList;
+	static Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+	static UINT64 mFenceValue;
+
+	static std::vector<CommandAllocator> mCommandAllocators;
+
+	static Microsoft::WRL::ComPtr<ID3D12Resource> mStagingBuffer;
+	static uint8_t* mStagingData;
+	static StagingRing mStagingRing;
+	static UploadQueue mUploadQueue;
+
+	// Own upload heaps of oversized uploads, recorded and waiting for the fence of their submission
+	static std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mRecordedUploadHeaps;
+	static std::vector<RetiredUploadHeap> mRetiredUploadHeaps;
+};
\ No newline at end of file
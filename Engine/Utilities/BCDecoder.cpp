@@ -0,0 +1,1265 @@
+#include "BCDecoder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BC_DECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	enum class BlockType
+	{
+		BC1, BC2, BC3, BC4, BC5, BC6H, BC7, Unknown
+	};
+
+	struct BlockFormat
+	{
+		BlockType type = BlockType::Unknown;
+		bool isSigned = false;
+		bool isSRGB = false;
+	};
+
+	BlockFormat GetBlockFormat(DXGI_FORMAT format)
+	{
+		BlockFormat blockFormat;
+
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_TYPELESS:
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			blockFormat.type = BlockType::BC1;
+			blockFormat.isSRGB = (format == DXGI_FORMAT_BC1_UNORM_SRGB);
+			break;
+
+		case DXGI_FORMAT_BC2_TYPELESS:
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+			blockFormat.type = BlockType::BC2;
+			blockFormat.isSRGB = (format == DXGI_FORMAT_BC2_UNORM_SRGB);
+			break;
+
+		case DXGI_FORMAT_BC3_TYPELESS:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			blockFormat.type = BlockType::BC3;
+			blockFormat.isSRGB = (format == DXGI_FORMAT_BC3_UNORM_SRGB);
+			break;
+
+		case DXGI_FORMAT_BC4_TYPELESS:
+		case DXGI_FORMAT_BC4_UNORM:
+		case DXGI_FORMAT_BC4_SNORM:
+			blockFormat.type = BlockType::BC4;
+			blockFormat.isSigned = (format == DXGI_FORMAT_BC4_SNORM);
+			break;
+
+		case DXGI_FORMAT_BC5_TYPELESS:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC5_SNORM:
+			blockFormat.type = BlockType::BC5;
+			blockFormat.isSigned = (format == DXGI_FORMAT_BC5_SNORM);
+			break;
+
+		case DXGI_FORMAT_BC6H_TYPELESS:
+		case DXGI_FORMAT_BC6H_UF16:
+		case DXGI_FORMAT_BC6H_SF16:
+			blockFormat.type = BlockType::BC6H;
+			blockFormat.isSigned = (format == DXGI_FORMAT_BC6H_SF16);
+			break;
+
+		case DXGI_FORMAT_BC7_TYPELESS:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			blockFormat.type = BlockType::BC7;
+			blockFormat.isSRGB = (format == DXGI_FORMAT_BC7_UNORM_SRGB);
+			break;
+
+		default:
+			break;
+		}
+
+		return blockFormat;
+	}
+
+	// Interpolation weights for 2, 3 and 4 bit indices, in 1/64ths
+	const int32_t Weights2[4] = { 0, 21, 43, 64 };
+	const int32_t Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const int32_t Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	const int32_t* GetWeights(uint32_t indexBits)
+	{
+		return (indexBits == 2) ? Weights2 : ((indexBits == 3) ? Weights3 : Weights4);
+	}
+
+	// Subset of every texel for the 64 two subset partitions, one bit per texel
+	const uint16_t Partitions2[64] =
+	{
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+	};
+
+	// Subset of every texel for the 64 three subset partitions, two bits per texel
+	const uint32_t Partitions3[64] =
+	{
+		0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+		0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+		0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+		0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+		0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+		0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+		0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+		0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+	};
+
+	// Texels whose index has its most significant bit implied zero, besides texel 0
+	const uint8_t AnchorsOfSecondSubset2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+	};
+
+	const uint8_t AnchorsOfSecondSubset3[64] =
+	{
+		 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+		 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+		 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+		 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+	};
+
+	const uint8_t AnchorsOfThirdSubset3[64] =
+	{
+		15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+		15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+		15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+		15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+	};
+
+	uint32_t GetSubset(uint32_t subsetCount, uint32_t partition, uint32_t texel)
+	{
+		if (subsetCount == 2)
+			return (Partitions2[partition] >> texel) & 1;
+
+		if (subsetCount == 3)
+			return (Partitions3[partition] >> (2 * texel)) & 3;
+
+		return 0;
+	}
+
+	bool IsAnchor(uint32_t subsetCount, uint32_t partition, uint32_t texel)
+	{
+		if (texel == 0)
+			return true;
+
+		if (subsetCount == 2)
+			return texel == AnchorsOfSecondSubset2[partition];
+
+		if (subsetCount == 3)
+			return texel == AnchorsOfSecondSubset3[partition] || texel == AnchorsOfThirdSubset3[partition];
+
+		return false;
+	}
+
+	// Reads a 128 bit block from the least significant bit of the first byte on
+	struct BlockBitReader
+	{
+		uint64_t bits[2];
+		uint32_t position = 0;
+
+		explicit BlockBitReader(const uint8_t* block)
+		{
+			memcpy(bits, block, sizeof(bits));
+		}
+
+		uint32_t Read(uint32_t bitCount)
+		{
+			if (bitCount == 0)
+				return 0;
+
+			uint64_t value;
+
+			if (position >= 64)
+				value = bits[1] >> (position - 64);
+			else if (position + bitCount <= 64)
+				value = bits[0] >> position;
+			else
+				value = (bits[0] >> position) | (bits[1] << (64 - position));
+
+			position += bitCount;
+
+			return (uint32_t)(value & ((1ull << bitCount) - 1));
+		}
+	};
+
+	uint16_t Load16(const uint8_t* data)
+	{
+		return (uint16_t)(data[0] | (data[1] << 8));
+	}
+
+	uint64_t Load48(const uint8_t* data)
+	{
+		uint64_t value = 0;
+
+		for (int i = 5; i >= 0; --i)
+			value = (value << 8) | data[i];
+
+		return value;
+	}
+
+	void ExpandRGB565(uint16_t packed, int32_t* color)
+	{
+		int32_t r = (packed >> 11) & 31;
+		int32_t g = (packed >> 5) & 63;
+		int32_t b = packed & 31;
+
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// BC1 color block, BC2 and BC3 always use four colors
+	void DecodeColorBlock(const uint8_t* block, bool allowsPunchThrough, uint8_t* texels)
+	{
+		uint16_t color0 = Load16(block);
+		uint16_t color1 = Load16(block + 2);
+		uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+
+		int32_t expanded0[3];
+		int32_t expanded1[3];
+		ExpandRGB565(color0, expanded0);
+		ExpandRGB565(color1, expanded1);
+
+		bool isThreeColor = allowsPunchThrough && color0 <= color1;
+		uint8_t palette[4][4];
+
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			palette[0][channel] = (uint8_t)expanded0[channel];
+			palette[1][channel] = (uint8_t)expanded1[channel];
+
+			if (isThreeColor)
+			{
+				palette[2][channel] = (uint8_t)((expanded0[channel] + expanded1[channel] + 1) / 2);
+				palette[3][channel] = 0;
+			}
+			else
+			{
+				palette[2][channel] = (uint8_t)((2 * expanded0[channel] + expanded1[channel] + 1) / 3);
+				palette[3][channel] = (uint8_t)((expanded0[channel] + 2 * expanded1[channel] + 1) / 3);
+			}
+		}
+
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = isThreeColor ? 0 : 255;
+
+		for (int i = 0; i < 16; ++i)
+			memcpy(&texels[i * 4], palette[(indices >> (2 * i)) & 3], 4);
+	}
+
+	void DecodeExplicitAlphaBlock(const uint8_t* block, uint8_t* texels)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			uint32_t alpha = (block[i / 2] >> (4 * (i & 1))) & 15;
+			texels[i * 4 + 3] = (uint8_t)(alpha * 17);
+		}
+	}
+
+	// BC4 style block into one channel of RGBA8 texels. Values are rounded to the nearest 8 bit value.
+	void DecodeSingleChannelBlock(const uint8_t* block, uint32_t channel, uint8_t* texels)
+	{
+		int32_t endpoint0 = block[0];
+		int32_t endpoint1 = block[1];
+		uint8_t palette[8];
+
+		palette[0] = (uint8_t)endpoint0;
+		palette[1] = (uint8_t)endpoint1;
+
+		if (endpoint0 > endpoint1)
+		{
+			for (int p = 2; p < 8; ++p)
+				palette[p] = (uint8_t)((2 * ((8 - p) * endpoint0 + (p - 1) * endpoint1) + 7) / 14);
+		}
+		else
+		{
+			for (int p = 2; p < 6; ++p)
+				palette[p] = (uint8_t)((2 * ((6 - p) * endpoint0 + (p - 1) * endpoint1) + 5) / 10);
+
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t indices = Load48(block + 2);
+
+		for (int i = 0; i < 16; ++i)
+			texels[i * 4 + channel] = palette[(indices >> (3 * i)) & 7];
+	}
+
+	// Signed BC4 style block, -128 and -127 both decode to -1
+	void DecodeSignedSingleChannelBlock(const uint8_t* block, float* values)
+	{
+		int32_t endpoint0 = std::max<int32_t>((int8_t)block[0], -127);
+		int32_t endpoint1 = std::max<int32_t>((int8_t)block[1], -127);
+		float palette[8];
+
+		palette[0] = endpoint0 / 127.0f;
+		palette[1] = endpoint1 / 127.0f;
+
+		if (endpoint0 > endpoint1)
+		{
+			for (int p = 2; p < 8; ++p)
+				palette[p] = ((8 - p) * endpoint0 + (p - 1) * endpoint1) / (7.0f * 127.0f);
+		}
+		else
+		{
+			for (int p = 2; p < 6; ++p)
+				palette[p] = ((6 - p) * endpoint0 + (p - 1) * endpoint1) / (5.0f * 127.0f);
+
+			palette[6] = -1.0f;
+			palette[7] = 1.0f;
+		}
+
+		uint64_t indices = Load48(block + 2);
+
+		for (int i = 0; i < 16; ++i)
+			values[i] = palette[(indices >> (3 * i)) & 7];
+	}
+
+	// Per texel endpoints and weights of a BC7 block, the interpolation is the part that differs
+	// between the SIMD and the reference path
+	struct BC7Texels
+	{
+		alignas(16) int16_t endpoint0[16][4];
+		alignas(16) int16_t endpoint1[16][4];
+		alignas(16) int16_t weights[16][4];
+	};
+
+	struct BC7ModeInfo
+	{
+		uint8_t subsetCount;
+		uint8_t partitionBits;
+		uint8_t rotationBits;
+		uint8_t indexSelectionBits;
+		uint8_t colorBits;
+		uint8_t alphaBits;
+		uint8_t endpointPBits;
+		uint8_t sharedPBits;
+		uint8_t indexBits;
+		uint8_t secondaryIndexBits;
+	};
+
+	const BC7ModeInfo BC7Modes[8] =
+	{
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+	};
+
+	// Returns false for the reserved mode, which decodes to transparent black
+	bool UnpackBC7(const uint8_t* block, BC7Texels& texels)
+	{
+		uint32_t mode = 0;
+
+		while (mode < 8 && (block[0] & (1 << mode)) == 0)
+			++mode;
+
+		if (mode == 8)
+			return false;
+
+		const BC7ModeInfo& info = BC7Modes[mode];
+
+		BlockBitReader reader(block);
+		reader.Read(mode + 1);
+
+		uint32_t partition = reader.Read(info.partitionBits);
+		uint32_t rotation = reader.Read(info.rotationBits);
+		uint32_t indexSelection = reader.Read(info.indexSelectionBits);
+
+		int32_t endpoints[3][2][4] = {};
+		uint32_t channelBits[4] = { info.colorBits, info.colorBits, info.colorBits, info.alphaBits };
+		uint32_t channelCount = (info.alphaBits > 0) ? 4 : 3;
+
+		for (uint32_t channel = 0; channel < channelCount; ++channel)
+		{
+			for (uint32_t subset = 0; subset < info.subsetCount; ++subset)
+			{
+				endpoints[subset][0][channel] = (int32_t)reader.Read(channelBits[channel]);
+				endpoints[subset][1][channel] = (int32_t)reader.Read(channelBits[channel]);
+			}
+		}
+
+		if (info.endpointPBits > 0 || info.sharedPBits > 0)
+		{
+			for (uint32_t subset = 0; subset < info.subsetCount; ++subset)
+			{
+				uint32_t pBits[2];
+				pBits[0] = reader.Read(1);
+				pBits[1] = (info.sharedPBits > 0) ? pBits[0] : reader.Read(1);
+
+				for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+				{
+					for (uint32_t channel = 0; channel < channelCount; ++channel)
+						endpoints[subset][endpoint][channel] = (endpoints[subset][endpoint][channel] << 1) | (int32_t)pBits[endpoint];
+				}
+			}
+
+			for (uint32_t channel = 0; channel < channelCount; ++channel)
+				++channelBits[channel];
+		}
+
+		// Replicate the top bits into the low bits, modes without alpha are opaque
+		for (uint32_t subset = 0; subset < info.subsetCount; ++subset)
+		{
+			for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+			{
+				for (uint32_t channel = 0; channel < channelCount; ++channel)
+				{
+					int32_t value = endpoints[subset][endpoint][channel] << (8 - channelBits[channel]);
+					endpoints[subset][endpoint][channel] = value | (value >> channelBits[channel]);
+				}
+
+				if (channelCount == 3)
+					endpoints[subset][endpoint][3] = 255;
+			}
+		}
+
+		uint32_t indices[16];
+		uint32_t secondaryIndices[16] = {};
+
+		for (uint32_t i = 0; i < 16; ++i)
+			indices[i] = reader.Read(info.indexBits - (IsAnchor(info.subsetCount, partition, i) ? 1 : 0));
+
+		for (uint32_t i = 0; i < 16 && info.secondaryIndexBits > 0; ++i)
+			secondaryIndices[i] = reader.Read(info.secondaryIndexBits - ((i == 0) ? 1 : 0));
+
+		// With a second index set color and alpha are weighted separately, the selection bit swaps them
+		const int32_t* colorWeights = GetWeights(info.indexBits);
+		const int32_t* alphaWeights = colorWeights;
+		const uint32_t* colorIndices = indices;
+		const uint32_t* alphaIndices = indices;
+
+		if (info.secondaryIndexBits > 0)
+		{
+			alphaWeights = GetWeights(info.secondaryIndexBits);
+			alphaIndices = secondaryIndices;
+
+			if (indexSelection != 0)
+			{
+				std::swap(colorWeights, alphaWeights);
+				std::swap(colorIndices, alphaIndices);
+			}
+		}
+
+		// The rotation swaps alpha with one of the color channels after interpolation, swapping the
+		// inputs instead gives the same result
+		uint32_t channelOrder[4] = { 0, 1, 2, 3 };
+
+		if (rotation > 0)
+			std::swap(channelOrder[rotation - 1], channelOrder[3]);
+
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			uint32_t subset = GetSubset(info.subsetCount, partition, i);
+
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				uint32_t sourceChannel = channelOrder[channel];
+
+				texels.endpoint0[i][channel] = (int16_t)endpoints[subset][0][sourceChannel];
+				texels.endpoint1[i][channel] = (int16_t)endpoints[subset][1][sourceChannel];
+				texels.weights[i][channel] = (int16_t)((sourceChannel == 3) ? alphaWeights[alphaIndices[i]] : colorWeights[colorIndices[i]]);
+			}
+		}
+
+		return true;
+	}
+
+	void InterpolateBC7Reference(const BC7Texels& texels, uint8_t* output)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				int32_t weight = texels.weights[i][channel];
+				output[i * 4 + channel] = (uint8_t)(((64 - weight) * texels.endpoint0[i][channel] + weight * texels.endpoint1[i][channel] + 32) >> 6);
+			}
+		}
+	}
+
+#if defined(BC_DECODER_SSE2)
+	// Interleaves endpoint pairs and weight pairs so one multiply-add yields (64 - w) * e0 + w * e1 per channel
+	__m128i InterpolateTexel(const int16_t* endpoint0, const int16_t* endpoint1, const int16_t* weights, __m128i bias)
+	{
+		__m128i endpoints = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(endpoint0)),
+			_mm_loadl_epi64(reinterpret_cast<const __m128i*>(endpoint1)));
+
+		__m128i weight1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weights));
+		__m128i weight0 = _mm_sub_epi16(_mm_set1_epi16(64), weight1);
+
+		__m128i sum = _mm_madd_epi16(endpoints, _mm_unpacklo_epi16(weight0, weight1));
+
+		return _mm_srai_epi32(_mm_add_epi32(sum, bias), 6);
+	}
+#endif
+
+	void InterpolateBC7(const BC7Texels& texels, uint8_t* output)
+	{
+#if defined(BC_DECODER_SSE2)
+		__m128i rounding = _mm_set1_epi32(32);
+
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128i texel0 = InterpolateTexel(texels.endpoint0[i + 0], texels.endpoint1[i + 0], texels.weights[i + 0], rounding);
+			__m128i texel1 = InterpolateTexel(texels.endpoint0[i + 1], texels.endpoint1[i + 1], texels.weights[i + 1], rounding);
+			__m128i texel2 = InterpolateTexel(texels.endpoint0[i + 2], texels.endpoint1[i + 2], texels.weights[i + 2], rounding);
+			__m128i texel3 = InterpolateTexel(texels.endpoint0[i + 3], texels.endpoint1[i + 3], texels.weights[i + 3], rounding);
+
+			__m128i packed = _mm_packus_epi16(_mm_packs_epi32(texel0, texel1), _mm_packs_epi32(texel2, texel3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i * 4]), packed);
+		}
+#else
+		InterpolateBC7Reference(texels, output);
+#endif
+	}
+
+	// BC6H endpoints after unquantization, per texel like BC7. Values are 0 to 0xFFFF unsigned or
+	// -0x8000 to 0x7FFF signed, the fourth channel is unused.
+	struct BC6HTexels
+	{
+		alignas(16) int32_t endpoint0[16][4];
+		alignas(16) int32_t endpoint1[16][4];
+		alignas(16) int16_t weights[16][4];
+	};
+
+	enum BC6HField : uint8_t
+	{
+		RW, RX, RY, RZ, GW, GX, GY, GZ, BW, BX, BY, BZ, D
+	};
+
+	// Bits first to last of a field in block order, last < first means the bits are stored reversed
+	struct BC6HFieldBits
+	{
+		BC6HField field;
+		uint8_t first;
+		uint8_t last;
+	};
+
+	struct BC6HModeInfo
+	{
+		uint8_t modeValue;
+		uint8_t modeBits;
+		bool isTransformed;
+		uint8_t regionCount;
+		uint8_t endpointBits;
+		uint8_t deltaBits[3];
+		const BC6HFieldBits* fields;
+		uint8_t fieldCount;
+	};
+
+	const BC6HFieldBits BC6HFields0[] =
+	{
+		{ GY, 4, 4 }, { BY, 4, 4 }, { BZ, 4, 4 }, { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 },
+		{ GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 },
+		{ BZ, 3, 3 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields1[] =
+	{
+		{ GY, 5, 5 }, { GZ, 4, 4 }, { GZ, 5, 5 }, { RW, 0, 6 }, { BZ, 0, 0 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 0, 6 }, { BY, 5, 5 },
+		{ BZ, 2, 2 }, { GY, 4, 4 }, { BW, 0, 6 }, { BZ, 3, 3 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 5 },
+		{ GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 5 }, { RZ, 0, 5 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields2[] =
+	{
+		{ RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 4 }, { RW, 10, 10 }, { GY, 0, 3 }, { GX, 0, 3 }, { GW, 10, 10 }, { BZ, 0, 0 },
+		{ GZ, 0, 3 }, { BX, 0, 3 }, { BW, 10, 10 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 },
+		{ D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields3[] =
+	{
+		{ RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 10, 10 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 4 }, { GW, 10, 10 },
+		{ GZ, 0, 3 }, { BX, 0, 3 }, { BW, 10, 10 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 3 }, { BZ, 0, 0 }, { BZ, 2, 2 }, { RZ, 0, 3 },
+		{ GY, 4, 4 }, { BZ, 3, 3 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields4[] =
+	{
+		{ RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 10, 10 }, { BY, 4, 4 }, { GY, 0, 3 }, { GX, 0, 3 }, { GW, 10, 10 },
+		{ BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BW, 10, 10 }, { BY, 0, 3 }, { RY, 0, 3 }, { BZ, 1, 1 }, { BZ, 2, 2 }, { RZ, 0, 3 },
+		{ BZ, 4, 4 }, { BZ, 3, 3 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields5[] =
+	{
+		{ RW, 0, 8 }, { BY, 4, 4 }, { GW, 0, 8 }, { GY, 4, 4 }, { BW, 0, 8 }, { BZ, 4, 4 }, { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 },
+		{ GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 },
+		{ BZ, 3, 3 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields6[] =
+	{
+		{ RW, 0, 7 }, { GZ, 4, 4 }, { BY, 4, 4 }, { GW, 0, 7 }, { BZ, 2, 2 }, { GY, 4, 4 }, { BW, 0, 7 }, { BZ, 3, 3 }, { BZ, 4, 4 },
+		{ RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 5 },
+		{ RZ, 0, 5 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields7[] =
+	{
+		{ RW, 0, 7 }, { BZ, 0, 0 }, { BY, 4, 4 }, { GW, 0, 7 }, { GY, 5, 5 }, { GY, 4, 4 }, { BW, 0, 7 }, { GZ, 5, 5 }, { BZ, 4, 4 },
+		{ RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 5 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 },
+		{ BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields8[] =
+	{
+		{ RW, 0, 7 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 0, 7 }, { BY, 5, 5 }, { GY, 4, 4 }, { BW, 0, 7 }, { BZ, 5, 5 }, { BZ, 4, 4 },
+		{ RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 4 },
+		{ BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields9[] =
+	{
+		{ RW, 0, 5 }, { GZ, 4, 4 }, { BZ, 0, 0 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 0, 5 }, { GY, 5, 5 }, { BY, 5, 5 }, { BZ, 2, 2 },
+		{ GY, 4, 4 }, { BW, 0, 5 }, { GZ, 5, 5 }, { BZ, 3, 3 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 5 },
+		{ GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 5 }, { RZ, 0, 5 }, { D, 0, 4 }
+	};
+
+	const BC6HFieldBits BC6HFields10[] =
+	{
+		{ RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 9 }, { GX, 0, 9 }, { BX, 0, 9 }
+	};
+
+	const BC6HFieldBits BC6HFields11[] =
+	{
+		{ RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 8 }, { RW, 10, 10 }, { GX, 0, 8 }, { GW, 10, 10 }, { BX, 0, 8 }, { BW, 10, 10 }
+	};
+
+	const BC6HFieldBits BC6HFields12[] =
+	{
+		{ RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 7 }, { RW, 11, 10 }, { GX, 0, 7 }, { GW, 11, 10 }, { BX, 0, 7 }, { BW, 11, 10 }
+	};
+
+	const BC6HFieldBits BC6HFields13[] =
+	{
+		{ RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 15, 10 }, { GX, 0, 3 }, { GW, 15, 10 }, { BX, 0, 3 }, { BW, 15, 10 }
+	};
+
+#define BC6H_FIELDS(fields) fields, (uint8_t)(sizeof(fields) / sizeof(fields[0]))
+
+	// Modes 1 to 14 of the format specification
+	const BC6HModeInfo BC6HModes[14] =
+	{
+		{ 0x00, 2, true, 2, 10, { 5, 5, 5 }, BC6H_FIELDS(BC6HFields0) },
+		{ 0x01, 2, true, 2, 7, { 6, 6, 6 }, BC6H_FIELDS(BC6HFields1) },
+		{ 0x02, 5, true, 2, 11, { 5, 4, 4 }, BC6H_FIELDS(BC6HFields2) },
+		{ 0x06, 5, true, 2, 11, { 4, 5, 4 }, BC6H_FIELDS(BC6HFields3) },
+		{ 0x0A, 5, true, 2, 11, { 4, 4, 5 }, BC6H_FIELDS(BC6HFields4) },
+		{ 0x0E, 5, true, 2, 9, { 5, 5, 5 }, BC6H_FIELDS(BC6HFields5) },
+		{ 0x12, 5, true, 2, 8, { 6, 5, 5 }, BC6H_FIELDS(BC6HFields6) },
+		{ 0x16, 5, true, 2, 8, { 5, 6, 5 }, BC6H_FIELDS(BC6HFields7) },
+		{ 0x1A, 5, true, 2, 8, { 5, 5, 6 }, BC6H_FIELDS(BC6HFields8) },
+		{ 0x1E, 5, false, 2, 6, { 6, 6, 6 }, BC6H_FIELDS(BC6HFields9) },
+		{ 0x03, 5, false, 1, 10, { 10, 10, 10 }, BC6H_FIELDS(BC6HFields10) },
+		{ 0x07, 5, true, 1, 11, { 9, 9, 9 }, BC6H_FIELDS(BC6HFields11) },
+		{ 0x0B, 5, true, 1, 12, { 8, 8, 8 }, BC6H_FIELDS(BC6HFields12) },
+		{ 0x0F, 5, true, 1, 16, { 4, 4, 4 }, BC6H_FIELDS(BC6HFields13) }
+	};
+
+#undef BC6H_FIELDS
+
+	int32_t SignExtend(int32_t value, uint32_t bitCount)
+	{
+		int32_t shift = 32 - (int32_t)bitCount;
+		return (int32_t)((uint32_t)value << shift) >> shift;
+	}
+
+	int32_t UnquantizeBC6H(int32_t value, uint32_t bitCount, bool isSigned)
+	{
+		if (!isSigned)
+		{
+			if (bitCount >= 15 || value == 0)
+				return value;
+
+			if (value == (1 << bitCount) - 1)
+				return 0xFFFF;
+
+			return ((value << 16) + 0x8000) >> bitCount;
+		}
+
+		if (bitCount >= 16)
+			return value;
+
+		bool isNegative = value < 0;
+		int32_t magnitude = isNegative ? -value : value;
+		int32_t unquantized = 0;
+
+		if (magnitude == 0)
+			unquantized = 0;
+		else if (magnitude >= (1 << (bitCount - 1)) - 1)
+			unquantized = 0x7FFF;
+		else
+			unquantized = ((magnitude << 15) + 0x4000) >> (bitCount - 1);
+
+		return isNegative ? -unquantized : unquantized;
+	}
+
+	// Returns false for the reserved modes, which decode to black
+	bool UnpackBC6H(const uint8_t* block, bool isSigned, BC6HTexels& texels)
+	{
+		BlockBitReader reader(block);
+
+		uint32_t modeValue = reader.Read(2);
+
+		if (modeValue > 1)
+			modeValue |= reader.Read(3) << 2;
+
+		const BC6HModeInfo* info = nullptr;
+
+		for (const BC6HModeInfo& mode : BC6HModes)
+		{
+			if (mode.modeValue == modeValue)
+				info = &mode;
+		}
+
+		if (info == nullptr)
+			return false;
+
+		int32_t fields[D + 1] = {};
+
+		for (uint32_t i = 0; i < info->fieldCount; ++i)
+		{
+			const BC6HFieldBits& bits = info->fields[i];
+
+			if (bits.first <= bits.last)
+			{
+				for (uint32_t bit = bits.first; bit <= bits.last; ++bit)
+					fields[bits.field] |= (int32_t)reader.Read(1) << bit;
+			}
+			else
+			{
+				for (int32_t bit = bits.first; bit >= (int32_t)bits.last; --bit)
+					fields[bits.field] |= (int32_t)reader.Read(1) << bit;
+			}
+		}
+
+		// Endpoint pairs of both regions, W and X for the first, Y and Z for the second
+		int32_t endpoints[2][2][3] =
+		{
+			{ { fields[RW], fields[GW], fields[BW] }, { fields[RX], fields[GX], fields[BX] } },
+			{ { fields[RY], fields[GY], fields[BY] }, { fields[RZ], fields[GZ], fields[BZ] } }
+		};
+
+		uint32_t endpointBits = info->endpointBits;
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			if (isSigned)
+				endpoints[0][0][channel] = SignExtend(endpoints[0][0][channel], endpointBits);
+
+			for (uint32_t endpoint = 1; endpoint < 2u * info->regionCount; ++endpoint)
+			{
+				int32_t& value = endpoints[endpoint / 2][endpoint % 2][channel];
+
+				if (isSigned || info->isTransformed)
+					value = SignExtend(value, info->deltaBits[channel]);
+
+				// Transformed modes store the other endpoints as deltas to the first one
+				if (info->isTransformed)
+				{
+					value = (endpoints[0][0][channel] + value) & ((1 << endpointBits) - 1);
+
+					if (isSigned)
+						value = SignExtend(value, endpointBits);
+				}
+			}
+		}
+
+		for (uint32_t region = 0; region < info->regionCount; ++region)
+		{
+			for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+			{
+				for (uint32_t channel = 0; channel < 3; ++channel)
+					endpoints[region][endpoint][channel] = UnquantizeBC6H(endpoints[region][endpoint][channel], endpointBits, isSigned);
+			}
+		}
+
+		uint32_t shape = (uint32_t)fields[D];
+		uint32_t indexBits = (info->regionCount == 2) ? 3 : 4;
+		const int32_t* weights = GetWeights(indexBits);
+
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			uint32_t index = reader.Read(indexBits - (IsAnchor(info->regionCount, shape, i) ? 1 : 0));
+			uint32_t region = GetSubset(info->regionCount, shape, i);
+
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				texels.endpoint0[i][channel] = (channel < 3) ? endpoints[region][0][channel] : 0;
+				texels.endpoint1[i][channel] = (channel < 3) ? endpoints[region][1][channel] : 0;
+				texels.weights[i][channel] = (int16_t)weights[index];
+			}
+		}
+
+		return true;
+	}
+
+	const uint16_t HalfOne = 0x3C00;
+
+	void InterpolateBC6HReference(const BC6HTexels& texels, bool isSigned, uint16_t* output)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				int32_t weight = texels.weights[i][channel];
+				int32_t value = ((64 - weight) * texels.endpoint0[i][channel] + weight * texels.endpoint1[i][channel] + 32) >> 6;
+
+				// Scale to the half float bit pattern, 31/32 of the range so the largest value isn't infinity
+				if (isSigned)
+				{
+					int32_t magnitude = ((value < 0 ? -value : value) * 31) >> 5;
+					output[i * 4 + channel] = (uint16_t)((value < 0) ? (0x8000 | magnitude) : magnitude);
+				}
+				else
+				{
+					output[i * 4 + channel] = (uint16_t)((value * 31) >> 6);
+				}
+			}
+
+			output[i * 4 + 3] = HalfOne;
+		}
+	}
+
+	void InterpolateBC6H(const BC6HTexels& texels, bool isSigned, uint16_t* output)
+	{
+#if defined(BC_DECODER_SSE2)
+		// Unsigned values are biased into the signed 16 bit range for the multiply-add. The weights
+		// sum to 64, so the bias comes back as 64 times itself.
+		int32_t bias = isSigned ? 0 : 0x8000;
+		__m128i endpointBias = _mm_set1_epi32(bias);
+		__m128i rounding = _mm_set1_epi32(64 * bias + 32);
+		__m128i alphaMask = _mm_set_epi32(0, -1, -1, -1);
+		__m128i alpha = _mm_set_epi32(HalfOne, 0, 0, 0);
+
+		for (int i = 0; i < 16; i += 2)
+		{
+			__m128i results[2];
+
+			for (int texel = 0; texel < 2; ++texel)
+			{
+				__m128i endpoint0 = _mm_sub_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(texels.endpoint0[i + texel])), endpointBias);
+				__m128i endpoint1 = _mm_sub_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(texels.endpoint1[i + texel])), endpointBias);
+
+				alignas(16) int16_t packedEndpoints[2][8];
+				_mm_store_si128(reinterpret_cast<__m128i*>(packedEndpoints), _mm_packs_epi32(endpoint0, endpoint1));
+
+				__m128i value = InterpolateTexel(packedEndpoints[0], packedEndpoints[0] + 4, texels.weights[i + texel], rounding);
+
+				if (isSigned)
+				{
+					__m128i sign = _mm_srai_epi32(value, 31);
+					__m128i magnitude = _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+					magnitude = _mm_srli_epi32(_mm_sub_epi32(_mm_slli_epi32(magnitude, 5), magnitude), 5);
+					value = _mm_or_si128(magnitude, _mm_and_si128(sign, _mm_set1_epi32(0x8000)));
+				}
+				else
+				{
+					value = _mm_srli_epi32(_mm_sub_epi32(_mm_slli_epi32(value, 5), value), 6);
+				}
+
+				results[texel] = _mm_or_si128(_mm_and_si128(value, alphaMask), alpha);
+			}
+
+			// Bit patterns go up to 0xFFFF, shift them into the signed range for the saturating pack
+			__m128i offset = _mm_set1_epi32(0x8000);
+			__m128i packed = _mm_packs_epi32(_mm_sub_epi32(results[0], offset), _mm_sub_epi32(results[1], offset));
+			packed = _mm_xor_si128(packed, _mm_set1_epi16((int16_t)0x8000));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i * 4]), packed);
+		}
+#else
+		InterpolateBC6HReference(texels, isSigned, output);
+#endif
+	}
+
+	float SRGBToLinear(float value)
+	{
+		return (value <= 0.04045f) ? (value / 12.92f) : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	// 8 bit value to half float, plain and sRGB linearized
+	struct HalfTables
+	{
+		uint16_t linear[256];
+		uint16_t sRGB[256];
+
+		HalfTables()
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				linear[i] = BCDecoder::FloatToHalf(i / 255.0f);
+				sRGB[i] = BCDecoder::FloatToHalf(SRGBToLinear(i / 255.0f));
+			}
+		}
+	};
+
+	const HalfTables& GetHalfTables()
+	{
+		static HalfTables tables;
+		return tables;
+	}
+
+	uint8_t SignedToUNorm8(float value)
+	{
+		return (uint8_t)std::floor((value * 0.5f + 0.5f) * 255.0f + 0.5f);
+	}
+
+	// Decodes the 8 bit formats and BC7, whatever the output type is
+	void DecodeUNormBlock(const BlockFormat& blockFormat, const uint8_t* block, bool isVectorized, uint8_t* texels)
+	{
+		switch (blockFormat.type)
+		{
+		case BlockType::BC1:
+			DecodeColorBlock(block, true, texels);
+			break;
+
+		case BlockType::BC2:
+			DecodeColorBlock(block + 8, false, texels);
+			DecodeExplicitAlphaBlock(block, texels);
+			break;
+
+		case BlockType::BC3:
+			DecodeColorBlock(block + 8, false, texels);
+			DecodeSingleChannelBlock(block, 3, texels);
+			break;
+
+		case BlockType::BC4:
+			memset(texels, 0, 64);
+			DecodeSingleChannelBlock(block, 0, texels);
+
+			for (int i = 0; i < 16; ++i)
+				texels[i * 4 + 3] = 255;
+			break;
+
+		case BlockType::BC5:
+			memset(texels, 0, 64);
+			DecodeSingleChannelBlock(block, 0, texels);
+			DecodeSingleChannelBlock(block + 8, 1, texels);
+
+			for (int i = 0; i < 16; ++i)
+				texels[i * 4 + 3] = 255;
+			break;
+
+		case BlockType::BC7:
+		{
+			BC7Texels unpacked;
+
+			if (!UnpackBC7(block, unpacked))
+				memset(texels, 0, 64);
+			else if (isVectorized)
+				InterpolateBC7(unpacked, texels);
+			else
+				InterpolateBC7Reference(unpacked, texels);
+			break;
+		}
+
+		default:
+			memset(texels, 0, 64);
+			break;
+		}
+	}
+
+	// Signed BC4 / BC5, (r, 0, 0, 1) and (r, g, 0, 1)
+	void DecodeSignedBlock(const BlockFormat& blockFormat, const uint8_t* block, float* texels)
+	{
+		float values[16];
+
+		for (int i = 0; i < 16; ++i)
+		{
+			texels[i * 4 + 1] = 0.0f;
+			texels[i * 4 + 2] = 0.0f;
+			texels[i * 4 + 3] = 1.0f;
+		}
+
+		for (int channel = 0; channel < ((blockFormat.type == BlockType::BC5) ? 2 : 1); ++channel)
+		{
+			DecodeSignedSingleChannelBlock(block + channel * 8, values);
+
+			for (int i = 0; i < 16; ++i)
+				texels[i * 4 + channel] = values[i];
+		}
+	}
+
+	void DecodeHalfBlock(const BlockFormat& blockFormat, const uint8_t* block, bool isVectorized, uint16_t* texels)
+	{
+		BC6HTexels unpacked;
+
+		if (!UnpackBC6H(block, blockFormat.isSigned, unpacked))
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				texels[i * 4 + 0] = texels[i * 4 + 1] = texels[i * 4 + 2] = 0;
+				texels[i * 4 + 3] = HalfOne;
+			}
+		}
+		else if (isVectorized)
+		{
+			InterpolateBC6H(unpacked, blockFormat.isSigned, texels);
+		}
+		else
+		{
+			InterpolateBC6HReference(unpacked, blockFormat.isSigned, texels);
+		}
+	}
+}
+
+bool BCDecoder::IsSupported(DXGI_FORMAT format)
+{
+	return GetBlockFormat(format).type != BlockType::Unknown;
+}
+
+size_t BCDecoder::GetBlockSize(DXGI_FORMAT format)
+{
+	BlockType type = GetBlockFormat(format).type;
+
+	if (type == BlockType::Unknown)
+		return 0;
+
+	return (type == BlockType::BC1 || type == BlockType::BC4) ? 8 : 16;
+}
+
+void BCDecoder::DecodeBlock(DXGI_FORMAT format, const uint8_t* block, uint8_t* texels)
+{
+	DecodeBlockTexels(format, block, true, texels);
+}
+
+void BCDecoder::DecodeBlock(DXGI_FORMAT format, const uint8_t* block, uint16_t* texels)
+{
+	DecodeBlockTexels(format, block, true, texels);
+}
+
+void BCDecoder::DecodeBlock(const DDSSubresource& subresource, DXGI_FORMAT format, uint32_t blockX, uint32_t blockY, uint8_t* texels)
+{
+	DecodeBlockTexels(format, subresource.data + blockY * subresource.rowPitch + blockX * GetBlockSize(format), true, texels);
+}
+
+void BCDecoder::DecodeBlock(const DDSSubresource& subresource, DXGI_FORMAT format, uint32_t blockX, uint32_t blockY, uint16_t* texels)
+{
+	DecodeBlockTexels(format, subresource.data + blockY * subresource.rowPitch + blockX * GetBlockSize(format), true, texels);
+}
+
+void BCDecoder::DecodeBlockReference(DXGI_FORMAT format, const uint8_t* block, uint8_t* texels)
+{
+	DecodeBlockTexels(format, block, false, texels);
+}
+
+void BCDecoder::DecodeBlockReference(DXGI_FORMAT format, const uint8_t* block, uint16_t* texels)
+{
+	DecodeBlockTexels(format, block, false, texels);
+}
+
+bool BCDecoder::DecodeSurface(const DDSSubresource& subresource, DXGI_FORMAT format, uint8_t* output, size_t outputPitch)
+{
+	return DecodeSurfaceTexels(subresource, format, output, outputPitch);
+}
+
+bool BCDecoder::DecodeSurface(const DDSSubresource& subresource, DXGI_FORMAT format, uint16_t* output, size_t outputPitch)
+{
+	return DecodeSurfaceTexels(subresource, format, output, outputPitch);
+}
+
+template<typename Texel>
+bool BCDecoder::DecodeSurfaceTexels(const DDSSubresource& subresource, DXGI_FORMAT format, Texel* output, size_t outputPitch)
+{
+	if (!IsSupported(format) || subresource.data == nullptr)
+		return false;
+
+	size_t blockSize = GetBlockSize(format);
+	size_t blocksWide = std::max<size_t>(1, (subresource.width + 3) / 4);
+	size_t blocksHigh = std::max<size_t>(1, (subresource.height + 3) / 4);
+
+	ThreadPool::ParallelFor(blocksHigh, std::max<size_t>(1, 64 / blocksWide), [&](size_t begin, size_t end)
+	{
+		Texel texels[64];
+
+		for (size_t blockY = begin; blockY < end; ++blockY)
+		{
+			const uint8_t* blockRow = subresource.data + blockY * subresource.rowPitch;
+			size_t rowCount = std::min<size_t>(4, subresource.height - blockY * 4);
+
+			for (size_t blockX = 0; blockX < blocksWide; ++blockX)
+			{
+				DecodeBlockTexels(format, blockRow + blockX * blockSize, true, texels);
+
+				// Mips smaller than a block only keep the texels that exist
+				size_t columnCount = std::min<size_t>(4, subresource.width - blockX * 4);
+
+				for (size_t row = 0; row < rowCount; ++row)
+				{
+					uint8_t* destination = reinterpret_cast<uint8_t*>(output) + (blockY * 4 + row) * outputPitch + blockX * 4 * 4 * sizeof(Texel);
+					memcpy(destination, &texels[row * 16], columnCount * 4 * sizeof(Texel));
+				}
+			}
+		}
+	});
+
+	return true;
+}
+
+void BCDecoder::DecodeBlockTexels(DXGI_FORMAT format, const uint8_t* block, bool isVectorized, uint8_t* texels)
+{
+	BlockFormat blockFormat = GetBlockFormat(format);
+
+	if (blockFormat.type == BlockType::BC6H)
+	{
+		uint16_t halfTexels[64];
+		DecodeHalfBlock(blockFormat, block, isVectorized, halfTexels);
+
+		for (int i = 0; i < 64; ++i)
+			texels[i] = (uint8_t)std::floor(std::min(std::max(HalfToFloat(halfTexels[i]), 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+	else if (blockFormat.isSigned)
+	{
+		float signedTexels[64];
+		DecodeSignedBlock(blockFormat, block, signedTexels);
+
+		for (int i = 0; i < 64; ++i)
+			texels[i] = SignedToUNorm8(signedTexels[i]);
+	}
+	else
+	{
+		DecodeUNormBlock(blockFormat, block, isVectorized, texels);
+	}
+}
+
+void BCDecoder::DecodeBlockTexels(DXGI_FORMAT format, const uint8_t* block, bool isVectorized, uint16_t* texels)
+{
+	BlockFormat blockFormat = GetBlockFormat(format);
+
+	if (blockFormat.type == BlockType::BC6H)
+	{
+		DecodeHalfBlock(blockFormat, block, isVectorized, texels);
+	}
+	else if (blockFormat.isSigned)
+	{
+		float signedTexels[64];
+		DecodeSignedBlock(blockFormat, block, signedTexels);
+
+		for (int i = 0; i < 64; ++i)
+			texels[i] = FloatToHalf(signedTexels[i]);
+	}
+	else
+	{
+		uint8_t unormTexels[64];
+		DecodeUNormBlock(blockFormat, block, isVectorized, unormTexels);
+
+		const HalfTables& tables = GetHalfTables();
+		const uint16_t* colorTable = blockFormat.isSRGB ? tables.sRGB : tables.linear;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			texels[i * 4 + 0] = colorTable[unormTexels[i * 4 + 0]];
+			texels[i * 4 + 1] = colorTable[unormTexels[i * 4 + 1]];
+			texels[i * 4 + 2] = colorTable[unormTexels[i * 4 + 2]];
+			texels[i * 4 + 3] = tables.linear[unormTexels[i * 4 + 3]];
+		}
+	}
+}
+
+uint16_t BCDecoder::FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t magnitude = bits & 0x7FFFFFFF;
+
+	// NaN stays NaN, everything from 65520 on rounds to infinity
+	if (magnitude > 0x7F800000)
+		return (uint16_t)(sign | 0x7E00);
+
+	if (magnitude >= 0x477FF000)
+		return (uint16_t)(sign | 0x7C00);
+
+	uint32_t shift = 13;
+	uint32_t mantissa = magnitude;
+	uint32_t half = 0;
+
+	if (magnitude < 0x38800000)
+	{
+		// Denormal half, shift the mantissa with its implicit bit into place
+		if (magnitude < 0x33000000)
+			return (uint16_t)sign;
+
+		shift = 126 - (magnitude >> 23);
+		mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+		half = mantissa >> shift;
+	}
+	else
+	{
+		half = (magnitude - 0x38000000) >> 13;
+	}
+
+	// Round to nearest even
+	uint32_t remainder = mantissa & ((1u << shift) - 1);
+	uint32_t halfway = 1u << (shift - 1);
+
+	if (remainder > halfway || (remainder == halfway && (half & 1) != 0))
+		++half;
+
+	return (uint16_t)(sign | half);
+}
+
+float BCDecoder::HalfToFloat(uint16_t value)
+{
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 31;
+	uint32_t mantissa = value & 0x3FF;
+	uint32_t bits = 0;
+
+	if (exponent == 31)
+	{
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	else if (mantissa != 0)
+	{
+		// Denormal, normalize the mantissa
+		exponent = 113;
+
+		while ((mantissa & 0x400) == 0)
+		{
+			mantissa <<= 1;
+			--exponent;
+		}
+
+		bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+	}
+	else
+	{
+		bits = sign;
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <dxgiformat.h>
+#include "DDSImage.h"
+
+// CPU decoding of block compressed textures for tools that need texel data (bakers, reference
+// renderers, alpha coverage analysis). Handles every BC1-BC7 format, typeless formats decode as UNORM.
+//
+// RGBA8 output holds the stored values: sRGB data stays sRGB, SNORM is remapped to 0-255 like a
+// normal map and BC6H is clamped to 0-1. RGBA16F output holds what a shader would sample, sRGB
+// data is linearized. Texels are row major, four channels each.
+class BCDecoder
+{
+public:
+	BCDecoder() = default;
+	~BCDecoder() = default;
+
+	static bool IsSupported(DXGI_FORMAT);
+
+	// Random access, decodes one 4x4 block into 16 texels
+	static void DecodeBlock(DXGI_FORMAT, const uint8_t*, uint8_t*);
+	static void DecodeBlock(DXGI_FORMAT, const uint8_t*, uint16_t*);
+
+	// Block (blockX, blockY) of a subresource
+	static void DecodeBlock(const DDSSubresource&, DXGI_FORMAT, uint32_t, uint32_t, uint8_t*);
+	static void DecodeBlock(const DDSSubresource&, DXGI_FORMAT, uint32_t, uint32_t, uint16_t*);
+
+	// Straight per texel implementation of the format specifications, the SIMD paths are checked
+	// against it bit for bit
+	static void DecodeBlockReference(DXGI_FORMAT, const uint8_t*, uint8_t*);
+	static void DecodeBlockReference(DXGI_FORMAT, const uint8_t*, uint16_t*);
+
+	// Decodes a whole subresource into a linear width x height image with the given row pitch in
+	// bytes. Block rows are spread over the thread pool. Returns false for unsupported formats.
+	static bool DecodeSurface(const DDSSubresource&, DXGI_FORMAT, uint8_t*, size_t);
+	static bool DecodeSurface(const DDSSubresource&, DXGI_FORMAT, uint16_t*, size_t);
+
+	static size_t GetBlockSize(DXGI_FORMAT);
+
+	static uint16_t FloatToHalf(float);
+	static float HalfToFloat(uint16_t);
+
+private:
+
+	template<typename Texel>
+	static bool DecodeSurfaceTexels(const DDSSubresource&, DXGI_FORMAT, Texel*, size_t);
+
+	static void DecodeBlockTexels(DXGI_FORMAT, const uint8_t*, bool, uint8_t*);
+	static void DecodeBlockTexels(DXGI_FORMAT, const uint8_t*, bool, uint16_t*);
+};
\ No newline at end of file
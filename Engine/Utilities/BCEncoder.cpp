@@ -0,0 +1,1041 @@
+#include "BCEncoder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BC_ENCODER_SSE2
+#include <emmintrin.h>
+#endif
+
+const float BCEncoder::DiffuseAlphaClipThreshold = std::pow(0.1f, 1.0f / 2.2f);
+const float BCEncoder::NoAlphaClip = -1.0f;
+
+namespace
+{
+	// Structure of arrays so the index search can compare four texels at once
+	struct BlockTexels
+	{
+		alignas(16) float channels[4][16];
+	};
+
+	// BC7 interpolation weights for 2 and 4 bit indices, in 1/64ths
+	const int BC7Weights2[4] = { 0, 21, 43, 64 };
+	const int BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	int Interpolate(int endpoint0, int endpoint1, int weight)
+	{
+		return ((64 - weight) * endpoint0 + weight * endpoint1 + 32) >> 6;
+	}
+
+	void LoadBlock(const uint8_t* texels, uint32_t channelCount, BlockTexels& block)
+	{
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			for (uint32_t i = 0; i < 16; ++i)
+				block.channels[channel][i] = (channel < channelCount) ? (float)texels[i * 4 + channel] : 0.0f;
+		}
+	}
+
+	// Nearest palette entry of every texel and its squared distance. Channels that are not encoded
+	// have to be zero in both the block and the palette.
+	void FindClosestIndices(const BlockTexels& block, const float (*palette)[4], int paletteSize, uint8_t* indices, float* errors)
+	{
+#if defined(BC_ENCODER_SSE2)
+		for (int group = 0; group < 16; group += 4)
+		{
+			__m128 r = _mm_load_ps(&block.channels[0][group]);
+			__m128 g = _mm_load_ps(&block.channels[1][group]);
+			__m128 b = _mm_load_ps(&block.channels[2][group]);
+			__m128 a = _mm_load_ps(&block.channels[3][group]);
+
+			__m128 bestError = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+
+			for (int p = 0; p < paletteSize; ++p)
+			{
+				__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p][0]));
+				__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p][1]));
+				__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p][2]));
+				__m128 da = _mm_sub_ps(a, _mm_set1_ps(palette[p][3]));
+
+				__m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)),
+					_mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(da, da)));
+
+				__m128i isCloser = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+
+				bestError = _mm_min_ps(error, bestError);
+				bestIndex = _mm_or_si128(_mm_and_si128(isCloser, _mm_set1_epi32(p)), _mm_andnot_si128(isCloser, bestIndex));
+			}
+
+			alignas(16) int32_t groupIndices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(groupIndices), bestIndex);
+			_mm_storeu_ps(&errors[group], bestError);
+
+			for (int i = 0; i < 4; ++i)
+				indices[group + i] = (uint8_t)groupIndices[i];
+		}
+#else
+		for (int i = 0; i < 16; ++i)
+		{
+			float bestError = FLT_MAX;
+
+			for (int p = 0; p < paletteSize; ++p)
+			{
+				float error = 0.0f;
+
+				for (int channel = 0; channel < 4; ++channel)
+				{
+					float difference = block.channels[channel][i] - palette[p][channel];
+					error += difference * difference;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					indices[i] = (uint8_t)p;
+				}
+			}
+
+			errors[i] = bestError;
+		}
+#endif
+	}
+
+	// Fits a line through the selected texels (all when isSelected is null) and returns the
+	// extent of the texels along it as the two endpoints
+	void ComputeEndpoints(const BlockTexels& block, const bool* isSelected, uint32_t channelCount, float* endpoint0, float* endpoint1)
+	{
+		float mean[4] = {};
+		float selectedCount = 0.0f;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			if (isSelected != nullptr && !isSelected[i])
+				continue;
+
+			for (uint32_t channel = 0; channel < channelCount; ++channel)
+				mean[channel] += block.channels[channel][i];
+
+			selectedCount += 1.0f;
+		}
+
+		for (uint32_t channel = 0; channel < channelCount; ++channel)
+			mean[channel] /= selectedCount;
+
+		float covariance[4][4] = {};
+
+		for (int i = 0; i < 16; ++i)
+		{
+			if (isSelected != nullptr && !isSelected[i])
+				continue;
+
+			for (uint32_t row = 0; row < channelCount; ++row)
+			{
+				for (uint32_t column = 0; column < channelCount; ++column)
+					covariance[row][column] += (block.channels[row][i] - mean[row]) * (block.channels[column][i] - mean[column]);
+			}
+		}
+
+		// Power iteration, seeded with the channel of the largest variance
+		uint32_t largestChannel = 0;
+
+		for (uint32_t channel = 1; channel < channelCount; ++channel)
+		{
+			if (covariance[channel][channel] > covariance[largestChannel][largestChannel])
+				largestChannel = channel;
+		}
+
+		float axis[4] = {};
+
+		for (uint32_t channel = 0; channel < channelCount; ++channel)
+			axis[channel] = covariance[largestChannel][channel];
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float nextAxis[4] = {};
+			float length = 0.0f;
+
+			for (uint32_t row = 0; row < channelCount; ++row)
+			{
+				for (uint32_t column = 0; column < channelCount; ++column)
+					nextAxis[row] += covariance[row][column] * axis[column];
+
+				length += nextAxis[row] * nextAxis[row];
+			}
+
+			if (length < 1.0e-12f)
+				break;
+
+			length = 1.0f / std::sqrt(length);
+
+			for (uint32_t channel = 0; channel < channelCount; ++channel)
+				axis[channel] = nextAxis[channel] * length;
+		}
+
+		float minProjection = FLT_MAX;
+		float maxProjection = -FLT_MAX;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			if (isSelected != nullptr && !isSelected[i])
+				continue;
+
+			float projection = 0.0f;
+
+			for (uint32_t channel = 0; channel < channelCount; ++channel)
+				projection += (block.channels[channel][i] - mean[channel]) * axis[channel];
+
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			endpoint0[channel] = (channel < channelCount) ? std::min(std::max(mean[channel] + axis[channel] * minProjection, 0.0f), 255.0f) : 0.0f;
+			endpoint1[channel] = (channel < channelCount) ? std::min(std::max(mean[channel] + axis[channel] * maxProjection, 0.0f), 255.0f) : 0.0f;
+		}
+	}
+
+	// Least squares endpoints for fixed per texel weights of endpoint1. Returns false when the
+	// weights don't constrain both endpoints.
+	bool SolveEndpoints(const BlockTexels& block, const bool* isSelected, const float* weights, uint32_t channelCount,
+		float* endpoint0, float* endpoint1)
+	{
+		float alpha2 = 0.0f;
+		float alphaBeta = 0.0f;
+		float beta2 = 0.0f;
+		float alphaX[4] = {};
+		float betaX[4] = {};
+
+		for (int i = 0; i < 16; ++i)
+		{
+			if (isSelected != nullptr && !isSelected[i])
+				continue;
+
+			float beta = weights[i];
+			float alpha = 1.0f - beta;
+
+			alpha2 += alpha * alpha;
+			alphaBeta += alpha * beta;
+			beta2 += beta * beta;
+
+			for (uint32_t channel = 0; channel < channelCount; ++channel)
+			{
+				alphaX[channel] += alpha * block.channels[channel][i];
+				betaX[channel] += beta * block.channels[channel][i];
+			}
+		}
+
+		float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+
+		if (std::fabs(determinant) < 1.0e-6f)
+			return false;
+
+		float inverseDeterminant = 1.0f / determinant;
+
+		for (uint32_t channel = 0; channel < channelCount; ++channel)
+		{
+			endpoint0[channel] = std::min(std::max((beta2 * alphaX[channel] - alphaBeta * betaX[channel]) * inverseDeterminant, 0.0f), 255.0f);
+			endpoint1[channel] = std::min(std::max((alpha2 * betaX[channel] - alphaBeta * alphaX[channel]) * inverseDeterminant, 0.0f), 255.0f);
+		}
+
+		return true;
+	}
+
+	uint16_t QuantizeRGB565(const float* color)
+	{
+		int r = std::min(std::max((int)(color[0] * (31.0f / 255.0f) + 0.5f), 0), 31);
+		int g = std::min(std::max((int)(color[1] * (63.0f / 255.0f) + 0.5f), 0), 63);
+		int b = std::min(std::max((int)(color[2] * (31.0f / 255.0f) + 0.5f), 0), 31);
+
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void ExpandRGB565(uint16_t packed, int* color)
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// Palette of a BC1 color block as the decoder computes it, three colors when punch-through is used
+	void BuildColorPalette(uint16_t color0, uint16_t color1, bool isThreeColor, float (*palette)[4])
+	{
+		int expanded0[3];
+		int expanded1[3];
+		ExpandRGB565(color0, expanded0);
+		ExpandRGB565(color1, expanded1);
+
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			palette[0][channel] = (float)expanded0[channel];
+			palette[1][channel] = (float)expanded1[channel];
+
+			if (isThreeColor)
+			{
+				palette[2][channel] = (float)((expanded0[channel] + expanded1[channel] + 1) / 2);
+				palette[3][channel] = 0.0f;
+			}
+			else
+			{
+				palette[2][channel] = (float)((2 * expanded0[channel] + expanded1[channel] + 1) / 3);
+				palette[3][channel] = (float)((expanded0[channel] + 2 * expanded1[channel] + 1) / 3);
+			}
+		}
+
+		for (int entry = 0; entry < 4; ++entry)
+			palette[entry][3] = 0.0f;
+	}
+
+	// Whether a value decodes on the kept side of the clip threshold, both as the exact interpolated
+	// value and rounded to 8 bits, so the decision doesn't depend on the decoder's precision
+	bool IsKeptByClip(float value, float threshold)
+	{
+		return value >= threshold && std::floor(value + 0.5f) >= threshold;
+	}
+
+	bool IsDiscardedByClip(float value, float threshold)
+	{
+		return value < threshold && std::floor(value + 0.5f) < threshold;
+	}
+
+	// 3 bit index selection for a BC4 palette, returns the total squared error
+	float SelectSingleChannelIndices(const uint8_t* values, const float* palette, float threshold, uint8_t* indices)
+	{
+		float totalError = 0.0f;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			float value = (float)values[i];
+			bool isKept = (threshold >= 0.0f) && (value >= threshold);
+			float bestError = FLT_MAX;
+
+			for (int p = 0; p < 8; ++p)
+			{
+				if (threshold >= 0.0f && !(isKept ? IsKeptByClip(palette[p], threshold) : IsDiscardedByClip(palette[p], threshold)))
+					continue;
+
+				float error = (palette[p] - value) * (palette[p] - value);
+
+				if (error < bestError)
+				{
+					bestError = error;
+					indices[i] = (uint8_t)p;
+				}
+			}
+
+			totalError += bestError;
+		}
+
+		return totalError;
+	}
+
+	void WriteIndices(uint64_t indexBits, uint32_t byteCount, uint8_t* output)
+	{
+		for (uint32_t i = 0; i < byteCount; ++i)
+			output[i] = (uint8_t)(indexBits >> (8 * i));
+	}
+
+	// Little endian bit stream of a 128 bit BC7 block
+	struct BlockBitWriter
+	{
+		uint64_t bits[2] = { 0, 0 };
+		uint32_t position = 0;
+
+		void Write(uint64_t value, uint32_t bitCount)
+		{
+			uint32_t word = position >> 6;
+			uint32_t shift = position & 63;
+
+			bits[word] |= value << shift;
+
+			if (shift + bitCount > 64)
+				bits[word + 1] |= value >> (64 - shift);
+
+			position += bitCount;
+		}
+	};
+
+	// Mode 6: 7 bit RGBA endpoints with a p-bit each and 4 bit indices along one line through RGBA.
+	// Best when alpha changes together with the color.
+	float EncodeBC7Mode6(const BlockTexels& block, uint8_t* output, uint8_t* decoded)
+	{
+		float endpoint0[4];
+		float endpoint1[4];
+		ComputeEndpoints(block, nullptr, 4, endpoint0, endpoint1);
+
+		float bestError = FLT_MAX;
+		int bestQuantized[2][4] = {};
+		int bestPBits[2] = {};
+		uint8_t indices[16] = {};
+		float palette[16][4] = {};
+
+		for (int iteration = 0; iteration < 2; ++iteration)
+		{
+			uint8_t iterationIndices[16] = {};
+			float iterationError = FLT_MAX;
+
+			for (int pBitCombination = 0; pBitCombination < 4; ++pBitCombination)
+			{
+				int pBits[2] = { pBitCombination & 1, pBitCombination >> 1 };
+				int quantized[2][4];
+				int expanded[2][4];
+
+				for (int channel = 0; channel < 4; ++channel)
+				{
+					quantized[0][channel] = std::min(std::max((int)((endpoint0[channel] - pBits[0]) * 0.5f + 0.5f), 0), 127);
+					quantized[1][channel] = std::min(std::max((int)((endpoint1[channel] - pBits[1]) * 0.5f + 0.5f), 0), 127);
+					expanded[0][channel] = (quantized[0][channel] << 1) | pBits[0];
+					expanded[1][channel] = (quantized[1][channel] << 1) | pBits[1];
+				}
+
+				float candidatePalette[16][4];
+
+				for (int p = 0; p < 16; ++p)
+				{
+					for (int channel = 0; channel < 4; ++channel)
+						candidatePalette[p][channel] = (float)Interpolate(expanded[0][channel], expanded[1][channel], BC7Weights4[p]);
+				}
+
+				uint8_t candidateIndices[16];
+				float errors[16];
+				FindClosestIndices(block, candidatePalette, 16, candidateIndices, errors);
+
+				float totalError = 0.0f;
+
+				for (int i = 0; i < 16; ++i)
+					totalError += errors[i];
+
+				if (totalError < iterationError)
+				{
+					iterationError = totalError;
+					memcpy(iterationIndices, candidateIndices, sizeof(iterationIndices));
+				}
+
+				if (totalError < bestError)
+				{
+					bestError = totalError;
+					memcpy(bestQuantized, quantized, sizeof(bestQuantized));
+					bestPBits[0] = pBits[0];
+					bestPBits[1] = pBits[1];
+					memcpy(indices, candidateIndices, sizeof(indices));
+					memcpy(palette, candidatePalette, sizeof(palette));
+				}
+			}
+
+			float weights[16];
+
+			for (int i = 0; i < 16; ++i)
+				weights[i] = BC7Weights4[iterationIndices[i]] / 64.0f;
+
+			if (bestError == 0.0f || !SolveEndpoints(block, nullptr, weights, 4, endpoint0, endpoint1))
+				break;
+		}
+
+		// The most significant bit of the first index is implied zero
+		if (indices[0] >= 8)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+				std::swap(bestQuantized[0][channel], bestQuantized[1][channel]);
+
+			std::swap(bestPBits[0], bestPBits[1]);
+
+			for (int i = 0; i < 16; ++i)
+				indices[i] = 15 - indices[i];
+
+			for (int p = 0; p < 8; ++p)
+				std::swap(palette[p], palette[15 - p]);
+		}
+
+		BlockBitWriter writer;
+		writer.Write(1 << 6, 7);
+
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			writer.Write((uint64_t)bestQuantized[0][channel], 7);
+			writer.Write((uint64_t)bestQuantized[1][channel], 7);
+		}
+
+		writer.Write((uint64_t)bestPBits[0], 1);
+		writer.Write((uint64_t)bestPBits[1], 1);
+		writer.Write(indices[0], 3);
+
+		for (int i = 1; i < 16; ++i)
+			writer.Write(indices[i], 4);
+
+		WriteIndices(writer.bits[0], 8, output);
+		WriteIndices(writer.bits[1], 8, output + 8);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+				decoded[i * 4 + channel] = (uint8_t)palette[indices[i]][channel];
+		}
+
+		return bestError;
+	}
+
+	// Mode 5: 7 bit RGB and 8 bit alpha endpoints with separate 2 bit index sets for color and alpha.
+	// Best when alpha is unrelated to the color, e.g. roughness next to a normal.
+	float EncodeBC7Mode5(const BlockTexels& block, uint8_t* output, uint8_t* decoded)
+	{
+		BlockTexels colorBlock = block;
+		memset(colorBlock.channels[3], 0, sizeof(colorBlock.channels[3]));
+
+		float endpoint0[4];
+		float endpoint1[4];
+		ComputeEndpoints(colorBlock, nullptr, 3, endpoint0, endpoint1);
+
+		float colorError = FLT_MAX;
+		int colorQuantized[2][3] = {};
+		uint8_t colorIndices[16] = {};
+		float colorPalette[4][4] = {};
+
+		for (int iteration = 0; iteration < 2; ++iteration)
+		{
+			int quantized[2][3];
+			int expanded[2][3];
+
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				quantized[0][channel] = std::min(std::max((int)(endpoint0[channel] * (127.0f / 255.0f) + 0.5f), 0), 127);
+				quantized[1][channel] = std::min(std::max((int)(endpoint1[channel] * (127.0f / 255.0f) + 0.5f), 0), 127);
+				expanded[0][channel] = (quantized[0][channel] << 1) | (quantized[0][channel] >> 6);
+				expanded[1][channel] = (quantized[1][channel] << 1) | (quantized[1][channel] >> 6);
+			}
+
+			float candidatePalette[4][4] = {};
+
+			for (int p = 0; p < 4; ++p)
+			{
+				for (int channel = 0; channel < 3; ++channel)
+					candidatePalette[p][channel] = (float)Interpolate(expanded[0][channel], expanded[1][channel], BC7Weights2[p]);
+			}
+
+			uint8_t candidateIndices[16];
+			float errors[16];
+			FindClosestIndices(colorBlock, candidatePalette, 4, candidateIndices, errors);
+
+			float totalError = 0.0f;
+
+			for (int i = 0; i < 16; ++i)
+				totalError += errors[i];
+
+			if (totalError < colorError)
+			{
+				colorError = totalError;
+				memcpy(colorQuantized, quantized, sizeof(colorQuantized));
+				memcpy(colorIndices, candidateIndices, sizeof(colorIndices));
+				memcpy(colorPalette, candidatePalette, sizeof(colorPalette));
+			}
+
+			float weights[16];
+
+			for (int i = 0; i < 16; ++i)
+				weights[i] = BC7Weights2[candidateIndices[i]] / 64.0f;
+
+			if (colorError == 0.0f || !SolveEndpoints(colorBlock, nullptr, weights, 3, endpoint0, endpoint1))
+				break;
+		}
+
+		// Alpha endpoints are stored at full precision, the extremes are a good enough fit for 4 levels
+		int alphaEndpoints[2] = { 255, 0 };
+
+		for (int i = 0; i < 16; ++i)
+		{
+			alphaEndpoints[0] = std::min(alphaEndpoints[0], (int)block.channels[3][i]);
+			alphaEndpoints[1] = std::max(alphaEndpoints[1], (int)block.channels[3][i]);
+		}
+
+		int alphaPalette[4];
+
+		for (int p = 0; p < 4; ++p)
+			alphaPalette[p] = Interpolate(alphaEndpoints[0], alphaEndpoints[1], BC7Weights2[p]);
+
+		uint8_t alphaIndices[16];
+		float alphaError = 0.0f;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			float bestError = FLT_MAX;
+
+			for (int p = 0; p < 4; ++p)
+			{
+				float difference = block.channels[3][i] - alphaPalette[p];
+
+				if (difference * difference < bestError)
+				{
+					bestError = difference * difference;
+					alphaIndices[i] = (uint8_t)p;
+				}
+			}
+
+			alphaError += bestError;
+		}
+
+		// Both index sets have an implied zero most significant bit on their first index
+		if (colorIndices[0] >= 2)
+		{
+			for (int channel = 0; channel < 3; ++channel)
+				std::swap(colorQuantized[0][channel], colorQuantized[1][channel]);
+
+			for (int i = 0; i < 16; ++i)
+				colorIndices[i] = 3 - colorIndices[i];
+
+			std::swap(colorPalette[0], colorPalette[3]);
+			std::swap(colorPalette[1], colorPalette[2]);
+		}
+
+		if (alphaIndices[0] >= 2)
+		{
+			std::swap(alphaEndpoints[0], alphaEndpoints[1]);
+
+			for (int i = 0; i < 16; ++i)
+				alphaIndices[i] = 3 - alphaIndices[i];
+
+			std::swap(alphaPalette[0], alphaPalette[3]);
+			std::swap(alphaPalette[1], alphaPalette[2]);
+		}
+
+		BlockBitWriter writer;
+		writer.Write(1 << 5, 6);
+		// No channel rotation
+		writer.Write(0, 2);
+
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			writer.Write((uint64_t)colorQuantized[0][channel], 7);
+			writer.Write((uint64_t)colorQuantized[1][channel], 7);
+		}
+
+		writer.Write((uint64_t)alphaEndpoints[0], 8);
+		writer.Write((uint64_t)alphaEndpoints[1], 8);
+
+		writer.Write(colorIndices[0], 1);
+
+		for (int i = 1; i < 16; ++i)
+			writer.Write(colorIndices[i], 2);
+
+		writer.Write(alphaIndices[0], 1);
+
+		for (int i = 1; i < 16; ++i)
+			writer.Write(alphaIndices[i], 2);
+
+		WriteIndices(writer.bits[0], 8, output);
+		WriteIndices(writer.bits[1], 8, output + 8);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int channel = 0; channel < 3; ++channel)
+				decoded[i * 4 + channel] = (uint8_t)colorPalette[colorIndices[i]][channel];
+
+			decoded[i * 4 + 3] = (uint8_t)alphaPalette[alphaIndices[i]];
+		}
+
+		return colorError + alphaError;
+	}
+}
+
+void BCEncoder::EncodeBlockBC1(const uint8_t* texels, uint8_t* output, float alphaClipThreshold, uint8_t* decoded)
+{
+	EncodeColorBlock(texels, output, alphaClipThreshold, true, decoded);
+}
+
+void BCEncoder::EncodeBlockBC3(const uint8_t* texels, uint8_t* output, float alphaClipThreshold, uint8_t* decoded)
+{
+	// Color first, its decoded alpha is overwritten by the alpha block
+	EncodeColorBlock(texels, output + 8, NoAlphaClip, false, decoded);
+	EncodeSingleChannelBlock(texels, 3, output, alphaClipThreshold, decoded);
+}
+
+void BCEncoder::EncodeBlockBC5(const uint8_t* texels, uint8_t* output, uint8_t* decoded)
+{
+	EncodeSingleChannelBlock(texels, 0, output, NoAlphaClip, decoded);
+	EncodeSingleChannelBlock(texels, 1, output + 8, NoAlphaClip, decoded);
+
+	// BC5 has no blue or alpha, the sampler returns 0 and 1
+	if (decoded != nullptr)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			decoded[i * 4 + 2] = 0;
+			decoded[i * 4 + 3] = 255;
+		}
+	}
+}
+
+void BCEncoder::EncodeColorBlock(const uint8_t* texels, uint8_t* output, float alphaClipThreshold, bool allowPunchThrough,
+	uint8_t* decoded)
+{
+	bool isOpaque[16];
+	bool hasTransparent = false;
+	bool hasOpaque = false;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		isOpaque[i] = !allowPunchThrough || alphaClipThreshold < 0.0f || (texels[i * 4 + 3] >= alphaClipThreshold * 255.0f);
+		hasTransparent = hasTransparent || !isOpaque[i];
+		hasOpaque = hasOpaque || isOpaque[i];
+	}
+
+	uint16_t color0 = 0;
+	uint16_t color1 = 0;
+	uint8_t indices[16] = {};
+	float palette[4][4] = {};
+
+	if (hasOpaque)
+	{
+		BlockTexels block;
+		LoadBlock(texels, 3, block);
+
+		float endpoint0[4];
+		float endpoint1[4];
+		ComputeEndpoints(block, isOpaque, 3, endpoint0, endpoint1);
+
+		float bestError = FLT_MAX;
+
+		// Fit the principal axis first, then refine the endpoints once for the chosen indices
+		for (int iteration = 0; iteration < 2; ++iteration)
+		{
+			uint16_t candidate0 = QuantizeRGB565(endpoint0);
+			uint16_t candidate1 = QuantizeRGB565(endpoint1);
+
+			float candidatePalette[4][4];
+			BuildColorPalette(candidate0, candidate1, hasTransparent, candidatePalette);
+
+			uint8_t candidateIndices[16];
+			float errors[16];
+			FindClosestIndices(block, candidatePalette, hasTransparent ? 3 : 4, candidateIndices, errors);
+
+			float totalError = 0.0f;
+
+			for (int i = 0; i < 16; ++i)
+				totalError += isOpaque[i] ? errors[i] : 0.0f;
+
+			if (totalError < bestError)
+			{
+				bestError = totalError;
+				color0 = candidate0;
+				color1 = candidate1;
+				memcpy(indices, candidateIndices, sizeof(indices));
+				memcpy(palette, candidatePalette, sizeof(palette));
+			}
+
+			const float fourColorWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			const float threeColorWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+
+			float weights[16];
+
+			for (int i = 0; i < 16; ++i)
+				weights[i] = hasTransparent ? threeColorWeights[candidateIndices[i]] : fourColorWeights[candidateIndices[i]];
+
+			if (!SolveEndpoints(block, isOpaque, weights, 3, endpoint0, endpoint1))
+				break;
+		}
+	}
+
+	if (hasTransparent)
+	{
+		// Three color mode is selected by color0 <= color1
+		if (color0 > color1)
+		{
+			std::swap(color0, color1);
+			std::swap(palette[0], palette[1]);
+
+			for (int i = 0; i < 16; ++i)
+				indices[i] = (indices[i] < 2) ? (indices[i] ^ 1) : indices[i];
+		}
+
+		for (int i = 0; i < 16; ++i)
+			indices[i] = isOpaque[i] ? indices[i] : 3;
+	}
+	else if (color0 == color1)
+	{
+		// Equal endpoints would select three color mode, where index 0 still decodes to the color
+		memset(indices, 0, sizeof(indices));
+	}
+	else if (color0 < color1)
+	{
+		std::swap(color0, color1);
+		std::swap(palette[0], palette[1]);
+		std::swap(palette[2], palette[3]);
+
+		for (int i = 0; i < 16; ++i)
+			indices[i] ^= 1;
+	}
+
+	output[0] = (uint8_t)(color0 & 0xFF);
+	output[1] = (uint8_t)(color0 >> 8);
+	output[2] = (uint8_t)(color1 & 0xFF);
+	output[3] = (uint8_t)(color1 >> 8);
+
+	uint64_t indexBits = 0;
+
+	for (int i = 0; i < 16; ++i)
+		indexBits |= (uint64_t)indices[i] << (2 * i);
+
+	WriteIndices(indexBits, 4, output + 4);
+
+	if (decoded != nullptr)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			bool isTransparent = hasTransparent && indices[i] == 3;
+
+			decoded[i * 4 + 0] = (uint8_t)palette[indices[i]][0];
+			decoded[i * 4 + 1] = (uint8_t)palette[indices[i]][1];
+			decoded[i * 4 + 2] = (uint8_t)palette[indices[i]][2];
+			decoded[i * 4 + 3] = isTransparent ? 0 : 255;
+		}
+	}
+}
+
+void BCEncoder::EncodeSingleChannelBlock(const uint8_t* texels, uint32_t channel, uint8_t* output, float alphaClipThreshold,
+	uint8_t* decoded)
+{
+	uint8_t values[16];
+	uint8_t minValue = 255;
+	uint8_t maxValue = 0;
+	uint8_t minInnerValue = 255;
+	uint8_t maxInnerValue = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		values[i] = texels[i * 4 + channel];
+
+		minValue = std::min(minValue, values[i]);
+		maxValue = std::max(maxValue, values[i]);
+
+		if (values[i] != 0 && values[i] != 255)
+		{
+			minInnerValue = std::min(minInnerValue, values[i]);
+			maxInnerValue = std::max(maxInnerValue, values[i]);
+		}
+	}
+
+	float threshold = (alphaClipThreshold >= 0.0f) ? (alphaClipThreshold * 255.0f) : -1.0f;
+
+	// Eight interpolated values between the extremes, selected by endpoint0 > endpoint1
+	uint8_t endpoint0 = maxValue;
+	uint8_t endpoint1 = minValue;
+	float palette[8];
+
+	palette[0] = endpoint0;
+	palette[1] = endpoint1;
+
+	for (int p = 2; p < 8; ++p)
+		palette[p] = ((8 - p) * endpoint0 + (p - 1) * endpoint1) / 7.0f;
+
+	uint8_t indices[16] = {};
+	float bestError = (endpoint0 == endpoint1) ? 0.0f : SelectSingleChannelIndices(values, palette, threshold, indices);
+
+	// Six interpolated values plus exact 0 and 255, better when the block contains either extreme
+	if (bestError > 0.0f && (minValue == 0 || maxValue == 255))
+	{
+		uint8_t innerEndpoint0 = (minInnerValue <= maxInnerValue) ? minInnerValue : 0;
+		uint8_t innerEndpoint1 = (minInnerValue <= maxInnerValue) ? maxInnerValue : 0;
+		float innerPalette[8];
+
+		innerPalette[0] = innerEndpoint0;
+		innerPalette[1] = innerEndpoint1;
+
+		for (int p = 2; p < 6; ++p)
+			innerPalette[p] = ((6 - p) * innerEndpoint0 + (p - 1) * innerEndpoint1) / 5.0f;
+
+		innerPalette[6] = 0.0f;
+		innerPalette[7] = 255.0f;
+
+		uint8_t innerIndices[16];
+		float innerError = SelectSingleChannelIndices(values, innerPalette, threshold, innerIndices);
+
+		if (innerError < bestError)
+		{
+			endpoint0 = innerEndpoint0;
+			endpoint1 = innerEndpoint1;
+			memcpy(palette, innerPalette, sizeof(palette));
+			memcpy(indices, innerIndices, sizeof(indices));
+		}
+	}
+
+	output[0] = endpoint0;
+	output[1] = endpoint1;
+
+	uint64_t indexBits = 0;
+
+	for (int i = 0; i < 16; ++i)
+		indexBits |= (uint64_t)indices[i] << (3 * i);
+
+	WriteIndices(indexBits, 6, output + 2);
+
+	if (decoded != nullptr)
+	{
+		for (int i = 0; i < 16; ++i)
+			decoded[i * 4 + channel] = (uint8_t)std::floor(palette[indices[i]] + 0.5f);
+	}
+}
+
+void BCEncoder::EncodeBlockBC7(const uint8_t* texels, uint8_t* output, uint8_t* decoded)
+{
+	// Only the single subset modes are tried, they suit the smooth normal + roughness data and the
+	// partitioned modes would cost most of the encode time
+	BlockTexels block;
+	LoadBlock(texels, 4, block);
+
+	uint8_t mode5Block[16];
+	uint8_t mode5Decoded[64];
+	float mode5Error = EncodeBC7Mode5(block, mode5Block, mode5Decoded);
+
+	uint8_t mode6Block[16];
+	uint8_t mode6Decoded[64];
+	float mode6Error = EncodeBC7Mode6(block, mode6Block, mode6Decoded);
+
+	bool useMode5 = mode5Error < mode6Error;
+
+	memcpy(output, useMode5 ? mode5Block : mode6Block, 16);
+
+	if (decoded != nullptr)
+		memcpy(decoded, useMode5 ? mode5Decoded : mode6Decoded, 64);
+}
+
+void BCEncoder::EncodeSurface(const uint8_t* source, size_t width, size_t height, size_t sourceRowPitch, BCFormat format,
+	float alphaClipThreshold, uint8_t* output, size_t outputRowPitch, uint8_t* decoded)
+{
+	size_t blocksWide = std::max<size_t>(1, (width + 3) / 4);
+	size_t blocksHigh = std::max<size_t>(1, (height + 3) / 4);
+	size_t blockSize = GetBlockSize(format);
+
+	// Around 64 blocks per range keeps the scheduling overhead small for narrow mips
+	size_t grainSize = std::max<size_t>(1, 64 / blocksWide);
+
+	ThreadPool::ParallelFor(blocksHigh, grainSize, [=](size_t beginRow, size_t endRow)
+	{
+		uint8_t texels[64];
+		uint8_t decodedTexels[64];
+
+		for (size_t blockY = beginRow; blockY < endRow; ++blockY)
+		{
+			for (size_t blockX = 0; blockX < blocksWide; ++blockX)
+			{
+				for (size_t i = 0; i < 16; ++i)
+				{
+					size_t x = std::min(blockX * 4 + (i & 3), width - 1);
+					size_t y = std::min(blockY * 4 + (i >> 2), height - 1);
+
+					memcpy(&texels[i * 4], source + y * sourceRowPitch + x * 4, 4);
+				}
+
+				uint8_t* block = output + blockY * outputRowPitch + blockX * blockSize;
+				uint8_t* decodedBlock = (decoded != nullptr) ? decodedTexels : nullptr;
+
+				switch (format)
+				{
+				case BCFormat::BC1:
+					EncodeBlockBC1(texels, block, alphaClipThreshold, decodedBlock);
+					break;
+
+				case BCFormat::BC3:
+					EncodeBlockBC3(texels, block, alphaClipThreshold, decodedBlock);
+					break;
+
+				case BCFormat::BC5:
+					EncodeBlockBC5(texels, block, decodedBlock);
+					break;
+
+				case BCFormat::BC7:
+					EncodeBlockBC7(texels, block, decodedBlock);
+					break;
+				}
+
+				if (decoded == nullptr)
+					continue;
+
+				for (size_t i = 0; i < 16; ++i)
+				{
+					size_t x = blockX * 4 + (i & 3);
+					size_t y = blockY * 4 + (i >> 2);
+
+					if (x < width && y < height)
+						memcpy(decoded + (y * width + x) * 4, &decodedTexels[i * 4], 4);
+				}
+			}
+		}
+	});
+}
+
+size_t BCEncoder::GetBlockSize(BCFormat format)
+{
+	return (format == BCFormat::BC1) ? 8 : 16;
+}
+
+DXGI_FORMAT BCEncoder::GetDXGIFormat(BCFormat format, bool isSRGB)
+{
+	switch (format)
+	{
+	case BCFormat::BC1:
+		return isSRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+
+	case BCFormat::BC3:
+		return isSRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+
+	case BCFormat::BC5:
+		return DXGI_FORMAT_BC5_UNORM;
+
+	case BCFormat::BC7:
+		return isSRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+	}
+
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+double BCEncoder::ComputePSNR(const uint8_t* reference, const uint8_t* image, size_t texelCount, uint32_t channelCount,
+	float alphaClipThreshold)
+{
+	float threshold = alphaClipThreshold * 255.0f;
+	double squaredError = 0.0;
+	size_t comparedCount = 0;
+
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		// Texels the shader discards never reach the screen, whatever color they decode to
+		if (alphaClipThreshold >= 0.0f && reference[i * 4 + 3] < threshold)
+			continue;
+
+		++comparedCount;
+
+		for (uint32_t channel = 0; channel < channelCount; ++channel)
+		{
+			double difference = (double)reference[i * 4 + channel] - (double)image[i * 4 + channel];
+			squaredError += difference * difference;
+		}
+	}
+
+	// Identical images are reported as 100 dB instead of infinity
+	if (squaredError == 0.0)
+		return 100.0;
+
+	double meanSquaredError = squaredError / ((double)comparedCount * channelCount);
+
+	return std::min(10.0 * std::log10((255.0 * 255.0) / meanSquaredError), 100.0);
+}
+
+size_t BCEncoder::CountClipMismatches(const uint8_t* reference, const uint8_t* image, size_t texelCount, float alphaClipThreshold)
+{
+	float threshold = alphaClipThreshold * 255.0f;
+	size_t mismatchCount = 0;
+
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		if ((reference[i * 4 + 3] >= threshold) != (image[i * 4 + 3] >= threshold))
+			++mismatchCount;
+	}
+
+	return mismatchCount;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <dxgiformat.h>
+
+enum class BCFormat
+{
+	// RGB with 1 bit alpha, used for diffuse + opacity when the alpha only drives the clip
+	BC1,
+	// RGB with interpolated alpha, diffuse + opacity with soft alpha edges
+	BC3,
+	// Two channels, normal maps without roughness (Z is reconstructed)
+	BC5,
+	// RGBA, normal + roughness
+	BC7
+};
+
+// CPU block compression for the texture cook step. Blocks are 4x4 RGBA8 texels in row major
+// order. Every encode can also write back the texels a decoder will see, which the cooker uses
+// for its quality report.
+class BCEncoder
+{
+public:
+	BCEncoder() = default;
+	~BCEncoder() = default;
+
+	// Stored alpha below which DirectLighting.hlsl discards the pixel. The shader linearizes the
+	// whole texel before clipping, clip(pow(albedo.a, 2.2f) - 0.1f), so the cut is at 0.1^(1/2.2).
+	static const float DiffuseAlphaClipThreshold;
+
+	// Pass as threshold to encode alpha purely by error
+	static const float NoAlphaClip;
+
+	// With a threshold every texel keeps its side of it, so clip() discards exactly the same
+	// texels as before compression. BC1 turns the discarded texels into punch-through alpha.
+	static void EncodeBlockBC1(const uint8_t*, uint8_t*, float, uint8_t* = nullptr);
+	static void EncodeBlockBC3(const uint8_t*, uint8_t*, float, uint8_t* = nullptr);
+	static void EncodeBlockBC5(const uint8_t*, uint8_t*, uint8_t* = nullptr);
+	static void EncodeBlockBC7(const uint8_t*, uint8_t*, uint8_t* = nullptr);
+
+	// Encodes a whole RGBA8 surface, block rows are spread over the thread pool. Partial blocks at
+	// the right and bottom edge repeat the last texel. The optional decoded surface is tightly packed.
+	static void EncodeSurface(const uint8_t*, size_t, size_t, size_t, BCFormat, float, uint8_t*, size_t, uint8_t* = nullptr);
+
+	static size_t GetBlockSize(BCFormat);
+	static DXGI_FORMAT GetDXGIFormat(BCFormat, bool);
+
+	// Peak signal to noise ratio in dB over the first channelCount channels of two RGBA8 images.
+	// With a threshold the texels the reference clips are left out.
+	static double ComputePSNR(const uint8_t*, const uint8_t*, size_t, uint32_t, float = NoAlphaClip);
+
+	// Number of texels that are on different sides of the clip threshold in two RGBA8 images
+	static size_t CountClipMismatches(const uint8_t*, const uint8_t*, size_t, float);
+
+private:
+
+	static void EncodeColorBlock(const uint8_t*, uint8_t*, float, bool, uint8_t*);
+	static void EncodeSingleChannelBlock(const uint8_t*, uint32_t, uint8_t*, float, uint8_t*);
+};
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include "BrickMap.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+const uint32_t BrickMap::BrickSize;
+const uint32_t BrickMap::BrickTexelCount;
+const uint32_t BrickMap::PoolWidthInBricks;
+const uint32_t BrickMap::PoolHeightInBricks;
+
+namespace
+{
+	// Wrap addressing, like gsamLinearWrap
+	uint32_t WrapCoordinate(int32_t coordinate, uint32_t resolution)
+	{
+		if ((uint32_t)coordinate < resolution)
+			return (uint32_t)coordinate;
+
+		const int32_t wrapped = coordinate % (int32_t)resolution;
+		return (uint32_t)(wrapped < 0 ? wrapped + (int32_t)resolution : wrapped);
+	}
+}
+
+void BrickMap::Reset(uint32_t resolution, uint32_t mipCount)
+{
+	mMips.resize(mipCount);
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		Mip& level = mMips[mip];
+		level.resolution = std::max(resolution >> mip, 1u);
+		level.indirectionResolution = (level.resolution + BrickSize - 1) / BrickSize;
+		level.indirection.assign((size_t)level.indirectionResolution * level.indirectionResolution * level.indirectionResolution, 0);
+	}
+
+	mPool.clear();
+	mFreeBricks.clear();
+}
+
+uint32_t BrickMap::Update(uint32_t mip, const VoxelGrid& grid)
+{
+	Mip& level = mMips[mip];
+	const uint32_t resolution = level.resolution;
+	const uint32_t indirectionResolution = level.indirectionResolution;
+	const size_t brickCount = level.indirection.size();
+	const uint32_t* texels = grid.GetTexels();
+
+	// Which bricks hold an occupied voxel, found in parallel
+	std::vector<uint8_t> occupiedBricks(brickCount);
+
+	ThreadPool::ParallelFor(brickCount, 16, [&](size_t begin, size_t end)
+	{
+		for (size_t brick = begin; brick < end; ++brick)
+		{
+			const uint32_t brickX = (uint32_t)(brick % indirectionResolution) * BrickSize;
+			const uint32_t brickY = (uint32_t)(brick / indirectionResolution % indirectionResolution) * BrickSize;
+			const uint32_t brickZ = (uint32_t)(brick / ((size_t)indirectionResolution * indirectionResolution)) * BrickSize;
+			const uint32_t endX = std::min(brickX + BrickSize, resolution);
+			uint8_t occupied = 0;
+
+			for (uint32_t z = brickZ; z < std::min(brickZ + BrickSize, resolution) && occupied == 0; ++z)
+			{
+				for (uint32_t y = brickY; y < std::min(brickY + BrickSize, resolution) && occupied == 0; ++y)
+				{
+					const uint32_t* row = &texels[grid.GetIndex(0, y, z)];
+
+					for (uint32_t x = brickX; x < endX; ++x)
+						occupied |= (row[x] >> 24) != 0 ? 1 : 0;
+				}
+			}
+
+			occupiedBricks[brick] = occupied;
+		}
+	});
+
+	// Allocation touches the free list, so it stays serial. Bricks are freed first so the pool only
+	// grows when the occupied bricks outnumber the allocated ones.
+	uint32_t changedBricks = 0;
+
+	for (size_t brick = 0; brick < brickCount; ++brick)
+	{
+		if (occupiedBricks[brick] == 0 && level.indirection[brick] != 0)
+		{
+			FreeBrick(level.indirection[brick] - 1);
+			level.indirection[brick] = 0;
+			++changedBricks;
+		}
+	}
+
+	for (size_t brick = 0; brick < brickCount; ++brick)
+	{
+		if (occupiedBricks[brick] != 0 && level.indirection[brick] == 0)
+		{
+			level.indirection[brick] = AllocateBrick() + 1;
+			++changedBricks;
+		}
+	}
+
+	// Every allocated brick is overwritten, including the voxels that were cleared
+	ThreadPool::ParallelFor(brickCount, 16, [&](size_t begin, size_t end)
+	{
+		for (size_t brick = begin; brick < end; ++brick)
+		{
+			if (level.indirection[brick] == 0)
+				continue;
+
+			const uint32_t brickX = (uint32_t)(brick % indirectionResolution) * BrickSize;
+			const uint32_t brickY = (uint32_t)(brick / indirectionResolution % indirectionResolution) * BrickSize;
+			const uint32_t brickZ = (uint32_t)(brick / ((size_t)indirectionResolution * indirectionResolution)) * BrickSize;
+			const uint32_t width = std::min(BrickSize, resolution - brickX);
+			uint32_t* brickTexels = &mPool[(size_t)(level.indirection[brick] - 1) * BrickTexelCount];
+
+			for (uint32_t z = 0; z < std::min(BrickSize, resolution - brickZ); ++z)
+			{
+				for (uint32_t y = 0; y < std::min(BrickSize, resolution - brickY); ++y)
+				{
+					const uint32_t* row = &texels[grid.GetIndex(brickX, brickY + y, brickZ + z)];
+					std::copy(row, row + width, &brickTexels[(z * BrickSize + y) * BrickSize]);
+				}
+			}
+		}
+	});
+
+	return changedBricks;
+}
+
+void BrickMap::Store(uint32_t mip, uint32_t x, uint32_t y, uint32_t z, uint32_t texel)
+{
+	Mip& level = mMips[mip];
+	uint32_t& entry = level.indirection[GetBrickIndex(level, x / BrickSize, y / BrickSize, z / BrickSize)];
+
+	if (entry == 0)
+	{
+		if (texel == 0)
+			return;
+
+		entry = AllocateBrick() + 1;
+	}
+
+	mPool[(size_t)(entry - 1) * BrickTexelCount + ((z % BrickSize) * BrickSize + y % BrickSize) * BrickSize + x % BrickSize] = texel;
+}
+
+void BrickMap::Sample(uint32_t mip, const float* position, float* result) const
+{
+	const uint32_t resolution = mMips[mip].resolution;
+
+	// Texel centers are at half integers. Per axis, the two voxels filtered between and the weight of
+	// the second one.
+	uint32_t voxels[3][2];
+	float weights[3];
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		const float coordinate = position[axis] * (float)resolution - 0.5f;
+		const float floorCoordinate = std::floor(coordinate);
+		const int32_t base = (int32_t)floorCoordinate;
+
+		voxels[axis][0] = WrapCoordinate(base, resolution);
+		voxels[axis][1] = WrapCoordinate(base + 1, resolution);
+		weights[axis] = coordinate - floorCoordinate;
+	}
+
+	for (uint32_t channel = 0; channel < 4; ++channel)
+		result[channel] = 0.0f;
+
+	for (uint32_t corner = 0; corner < 8; ++corner)
+	{
+		const uint32_t offsetX = corner & 1;
+		const uint32_t offsetY = (corner >> 1) & 1;
+		const uint32_t offsetZ = corner >> 2;
+
+		const float weight = (offsetX != 0 ? weights[0] : 1.0f - weights[0])
+			* (offsetY != 0 ? weights[1] : 1.0f - weights[1])
+			* (offsetZ != 0 ? weights[2] : 1.0f - weights[2]);
+
+		const uint32_t texel = Load(mip, voxels[0][offsetX], voxels[1][offsetY], voxels[2][offsetZ]);
+
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			result[channel] += weight * VoxelGrid::Unpack(texel, channel);
+	}
+}
+
+size_t BrickMap::GetMemoryBytes() const
+{
+	size_t indirectionBytes = 0;
+
+	for (const Mip& level : mMips)
+		indirectionBytes += level.indirection.size() * sizeof(uint32_t);
+
+	// The pool texture holds the free bricks too, and grows by whole slices of bricks
+	const uint32_t bricksPerSlice = PoolWidthInBricks * PoolHeightInBricks;
+	const size_t sliceCount = (GetPoolCapacity() + bricksPerSlice - 1) / bricksPerSlice;
+
+	return indirectionBytes + sliceCount * bricksPerSlice * BrickTexelCount * sizeof(uint32_t);
+}
+
+void BrickMap::WritePoolTexture(std::vector<uint32_t>& texels) const
+{
+	const uint32_t bricksPerSlice = PoolWidthInBricks * PoolHeightInBricks;
+	const uint32_t sliceCount = (GetPoolCapacity() + bricksPerSlice - 1) / bricksPerSlice;
+	const size_t width = PoolWidthInBricks * BrickSize;
+	const size_t height = PoolHeightInBricks * BrickSize;
+
+	texels.assign(width * height * sliceCount * BrickSize, 0);
+
+	for (uint32_t brick = 0; brick < GetPoolCapacity(); ++brick)
+	{
+		const size_t originX = (brick % PoolWidthInBricks) * BrickSize;
+		const size_t originY = (brick / PoolWidthInBricks % PoolHeightInBricks) * BrickSize;
+		const size_t originZ = (brick / bricksPerSlice) * BrickSize;
+		const uint32_t* brickTexels = &mPool[(size_t)brick * BrickTexelCount];
+
+		for (uint32_t z = 0; z < BrickSize; ++z)
+		{
+			for (uint32_t y = 0; y < BrickSize; ++y)
+			{
+				const uint32_t* row = &brickTexels[(z * BrickSize + y) * BrickSize];
+				std::copy(row, row + BrickSize, &texels[((originZ + z) * height + originY + y) * width + originX]);
+			}
+		}
+	}
+}
+
+uint32_t BrickMap::AllocateBrick()
+{
+	if (mFreeBricks.empty())
+	{
+		mPool.resize(mPool.size() + BrickTexelCount, 0);
+		return (uint32_t)(mPool.size() / BrickTexelCount - 1);
+	}
+
+	const uint32_t brick = mFreeBricks.back();
+	mFreeBricks.pop_back();
+	std::fill_n(&mPool[(size_t)brick * BrickTexelCount], BrickTexelCount, 0u);
+
+	return brick;
+}
+
+void BrickMap::FreeBrick(uint32_t brick)
+{
+	mFreeBricks.push_back(brick);
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "VoxelGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sparse storage for the voxel mips. Each mip is split into bricks of 8x8x8 voxels, and only the
+// bricks holding an occupied voxel are allocated from one pool shared by every mip. A coarse
+// indirection grid per mip, one entry per brick, holds the pool index of the brick plus one, so a
+// cleared indirection grid means an empty volume. Mips smaller than a brick use a single brick.
+//
+// BrickMapUtil.hlsl reads the same layout on the GPU. The indirection grids are R32_UINT 3D textures,
+// and the pool is an RGBA8_UNORM 3D texture PoolWidthInBricks by PoolHeightInBricks bricks wide and as
+// many bricks deep as needed, the brick of index i at (i % width, i / width % height, i / (width *
+// height)). Texels are packed like VoxelGrid's.
+class BrickMap
+{
+public:
+	BrickMap() = default;
+	~BrickMap() = default;
+
+	static const uint32_t BrickSize = 8;
+	static const uint32_t BrickTexelCount = BrickSize * BrickSize * BrickSize;
+	static const uint32_t PoolWidthInBricks = 8;
+	static const uint32_t PoolHeightInBricks = 8;
+
+	// Resolution of the finest mip and the number of mips, every mip empty and the pool freed
+	void Reset(uint32_t, uint32_t);
+
+	// Copies a dense grid of the same resolution into a mip. Allocates the bricks that gained an
+	// occupied voxel and frees the ones left empty, returns the number of bricks allocated or freed.
+	uint32_t Update(uint32_t, const VoxelGrid&);
+
+	// Writes one voxel, allocating its brick unless the texel is empty
+	void Store(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+
+	// Texel of a voxel, zero in a brick that isn't allocated
+	uint32_t Load(uint32_t mip, uint32_t x, uint32_t y, uint32_t z) const
+	{
+		const Mip& level = mMips[mip];
+		const uint32_t entry = level.indirection[GetBrickIndex(level, x / BrickSize, y / BrickSize, z / BrickSize)];
+
+		if (entry == 0)
+			return 0;
+
+		return mPool[(size_t)(entry - 1) * BrickTexelCount + ((z % BrickSize) * BrickSize + y % BrickSize) * BrickSize + x % BrickSize];
+	}
+
+	// Trilinear filtering with wrapping at a position normalized to the volume, like the cone tracing's
+	// SampleLevel() on the dense grids. Writes the four channels.
+	void Sample(uint32_t, const float*, float*) const;
+
+	uint32_t GetMipCount() const { return (uint32_t)mMips.size(); }
+	uint32_t GetResolution(uint32_t mip) const { return mMips[mip].resolution; }
+	uint32_t GetIndirectionResolution(uint32_t mip) const { return mMips[mip].indirectionResolution; }
+	const uint32_t* GetIndirection(uint32_t mip) const { return mMips[mip].indirection.data(); }
+
+	// Bricks in use, and bricks the pool holds including the free ones
+	uint32_t GetBrickCount() const { return (uint32_t)(mPool.size() / BrickTexelCount - mFreeBricks.size()); }
+	uint32_t GetPoolCapacity() const { return (uint32_t)(mPool.size() / BrickTexelCount); }
+
+	// Bytes of the indirection grids and of a pool texture holding every brick of the pool
+	size_t GetMemoryBytes() const;
+
+	// Texels of the pool texture in the layout above, x fastest, for uploading it
+	void WritePoolTexture(std::vector<uint32_t>&) const;
+
+private:
+
+	struct Mip
+	{
+		uint32_t resolution = 0;
+		uint32_t indirectionResolution = 0;
+		std::vector<uint32_t> indirection;
+	};
+
+	static size_t GetBrickIndex(const Mip& level, uint32_t x, uint32_t y, uint32_t z)
+	{
+		return ((size_t)z * level.indirectionResolution + y) * level.indirectionResolution + x;
+	}
+
+	// Pool index of a free brick, cleared
+	uint32_t AllocateBrick();
+	void FreeBrick(uint32_t);
+
+	std::vector<Mip> mMips;
+	// Brick after brick, each x fastest, then y, then z
+	std::vector<uint32_t> mPool;
+	std::vector<uint32_t> mFreeBricks;
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "DDS.h"
+
+// Everything the loaders need to know about a DDS file without touching the pixel data
+struct DDSDescription
+{
+	uint32_t				width = 0;
+	uint32_t				height = 0;
+	uint32_t				depth = 0;
+	uint32_t				mipCount = 0;
+	uint32_t				arraySize = 0;
+	DXGI_FORMAT				format = DXGI_FORMAT_UNKNOWN;
+	DDS_RESOURCE_DIMENSION	dimension = DDS_DIMENSION_TEXTURE2D;
+	bool					isCubeMap = false;
+
+	// Offset of the first surface from the start of the file and the number of bytes after it
+	size_t					dataOffset = 0;
+	size_t					dataSize = 0;
+};
+
+// Device independent DDS helpers, usable by tools and benchmarks that never create a D3D device
+class DDSFormat
+{
+public:
+	DDSFormat() = default;
+	~DDSFormat() = default;
+
+	// Validates the magic number and headers of an in-memory DDS file. Returns false for
+	// malformed or unsupported files.
+	static bool ParseHeader(const uint8_t*, size_t, DDSDescription&);
+
+	// Appends the magic number and headers of a file with this description, always using the DX10
+	// extension. The offset and size members of the description are ignored.
+	static void WriteHeader(const DDSDescription&, std::vector<uint8_t>&);
+
+	static size_t BitsPerPixel(DXGI_FORMAT);
+	static void GetSurfaceInfo(size_t, size_t, DXGI_FORMAT, size_t*, size_t*, size_t*);
+	static DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT&);
+};
@@ -0,0 +1,134 @@
+#include "DDSImage.h"
+
+namespace
+{
+	// Resource limits of D3D12, a header beyond them can't describe a texture the renderer could create
+	const uint32_t MaxMipLevels = 15;
+	const uint32_t MaxTextureDimension2D = 16384;
+	const uint32_t MaxTextureDimension3D = 2048;
+	const uint32_t MaxTextureArraySize = 2048;
+
+	bool IsWithinLimits(const DDSDescription& description)
+	{
+		if (description.width == 0 || description.height == 0 || description.depth == 0)
+			return false;
+
+		if (description.mipCount > MaxMipLevels || description.arraySize > MaxTextureArraySize)
+			return false;
+
+		// A mip chain can't be longer than the halvings of the largest dimension
+		uint32_t largestDimension = description.width;
+		largestDimension = (description.height > largestDimension) ? description.height : largestDimension;
+		largestDimension = (description.depth > largestDimension) ? description.depth : largestDimension;
+
+		if ((largestDimension >> (description.mipCount - 1)) == 0)
+			return false;
+
+		if (description.dimension == DDS_DIMENSION_TEXTURE3D)
+		{
+			return description.width <= MaxTextureDimension3D && description.height <= MaxTextureDimension3D
+				&& description.depth <= MaxTextureDimension3D;
+		}
+
+		return description.width <= MaxTextureDimension2D && description.height <= MaxTextureDimension2D;
+	}
+}
+
+bool DDSImage::Load(const std::string& filePath)
+{
+	Close();
+
+	if (!mFile.Open(filePath))
+		return false;
+
+	if (!BuildSubresources(mFile.GetData(), mFile.GetSize()))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool DDSImage::LoadFromMemory(const uint8_t* ddsData, size_t ddsDataSize)
+{
+	Close();
+
+	if (!BuildSubresources(ddsData, ddsDataSize))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void DDSImage::Close()
+{
+	mSubresources.clear();
+	mDescription = DDSDescription();
+	mFile.Close();
+}
+
+const DDSSubresource& DDSImage::GetSubresource(uint32_t mipSlice, uint32_t arraySlice) const
+{
+	return mSubresources[CalcSubresource(mipSlice, arraySlice, mDescription.mipCount)];
+}
+
+const DDSSubresource& DDSImage::GetSubresource(uint32_t subresource) const
+{
+	return mSubresources[subresource];
+}
+
+bool DDSImage::BuildSubresources(const uint8_t* ddsData, size_t ddsDataSize)
+{
+	if (!DDSFormat::ParseHeader(ddsData, ddsDataSize, mDescription))
+		return false;
+
+	if (!IsWithinLimits(mDescription))
+		return false;
+
+	mSubresources.resize(mDescription.mipCount * mDescription.arraySize);
+
+	// Same walk as FillInitData12 in the loader, every mip of a slice before the next slice
+	const uint8_t* sourceBits = ddsData + mDescription.dataOffset;
+	const uint8_t* endBits = sourceBits + mDescription.dataSize;
+
+	size_t index = 0;
+
+	for (uint32_t arraySlice = 0; arraySlice < mDescription.arraySize; ++arraySlice)
+	{
+		size_t width = mDescription.width;
+		size_t height = mDescription.height;
+		size_t depth = mDescription.depth;
+
+		for (uint32_t mip = 0; mip < mDescription.mipCount; ++mip)
+		{
+			size_t numBytes = 0;
+			size_t rowBytes = 0;
+			size_t numRows = 0;
+			DDSFormat::GetSurfaceInfo(width, height, mDescription.format, &numBytes, &rowBytes, &numRows);
+
+			if (numBytes == 0 || (size_t)(endBits - sourceBits) < numBytes * depth)
+				return false;
+
+			DDSSubresource& subresource = mSubresources[index++];
+			subresource.data = sourceBits;
+			subresource.size = numBytes * depth;
+			subresource.width = (uint32_t)width;
+			subresource.height = (uint32_t)height;
+			subresource.depth = (uint32_t)depth;
+			subresource.rowPitch = rowBytes;
+			subresource.rowCount = numRows;
+			subresource.slicePitch = numBytes;
+
+			sourceBits += numBytes * depth;
+
+			width = (width > 1) ? (width >> 1) : 1;
+			height = (height > 1) ? (height >> 1) : 1;
+			depth = (depth > 1) ? (depth >> 1) : 1;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "DDSFormat.h"
+#include "MappedFile.h"
+
+// One mip level of one array slice (or cube face). For block compressed formats a row is a row of
+// 4x4 blocks, so rowCount is the number of block rows rather than texel rows.
+struct DDSSubresource
+{
+	const uint8_t*	data = nullptr;
+	size_t			size = 0;
+
+	uint32_t		width = 0;
+	uint32_t		height = 0;
+	uint32_t		depth = 0;
+
+	size_t			rowPitch = 0;
+	size_t			rowCount = 0;
+	// Bytes of one depth slice, equal to size for everything but volume textures
+	size_t			slicePitch = 0;
+};
+
+// Device independent view of a DDS file. The file is memory mapped and the subresources point
+// straight into the mapping, nothing is copied. The views are valid until the image is closed.
+class DDSImage
+{
+public:
+	DDSImage() = default;
+	~DDSImage() = default;
+
+	DDSImage(const DDSImage&) = delete;
+	DDSImage& operator=(const DDSImage&) = delete;
+
+	// Returns false for missing, malformed, unsupported or truncated files.
+	bool Load(const std::string&);
+
+	// Same as Load for a file that is already in memory. The caller keeps the memory alive.
+	bool LoadFromMemory(const uint8_t*, size_t);
+
+	void Close();
+
+	bool IsLoaded() const { return !mSubresources.empty(); }
+	const DDSDescription& GetDescription() const { return mDescription; }
+
+	uint32_t GetSubresourceCount() const { return (uint32_t)mSubresources.size(); }
+
+	// Subresources are in D3D12 order, all mips of the first slice first. Cube maps store their
+	// faces as six array slices in +X, -X, +Y, -Y, +Z, -Z order.
+	const DDSSubresource& GetSubresource(uint32_t, uint32_t) const;
+	const DDSSubresource& GetSubresource(uint32_t) const;
+
+	static uint32_t CalcSubresource(uint32_t mipSlice, uint32_t arraySlice, uint32_t mipLevels)
+	{
+		return mipSlice + arraySlice * mipLevels;
+	}
+
+private:
+
+	bool BuildSubresources(const uint8_t*, size_t);
+
+	MappedFile mFile;
+	DDSDescription mDescription;
+	std::vector<DDSSubresource> mSubresources;
+};
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+
+void DescriptorAllocator::Reset(uint32_t persistentCount, uint32_t transientCount, uint32_t frameCount)
+{
+	mPersistentCount = persistentCount;
+	mPersistentUsedCount = 0;
+
+	mTransientCount = transientCount;
+	mFrameCount = std::max(frameCount, 1u);
+	mFrameIndex = 0;
+	mTransientHead = 0;
+
+	mFreeRanges.clear();
+	mRetiredRanges.clear();
+
+	if (persistentCount > 0)
+		mFreeRanges.push_back({ 0, persistentCount });
+
+	mAllocatedCounts.assign(persistentCount, 0);
+	mGenerations.assign(persistentCount, 0);
+}
+
+bool DescriptorAllocator::Allocate(uint32_t count, DescriptorHandle& handle)
+{
+	if (count == 0)
+		return false;
+
+	for (size_t i = 0; i < mFreeRanges.size(); ++i)
+	{
+		Range& freeRange = mFreeRanges[i];
+
+		if (freeRange.count < count)
+			continue;
+
+		handle.index = freeRange.index;
+		handle.count = count;
+
+		// Zero is never handed out, so a default handle is never valid
+		uint32_t& generation = mGenerations[handle.index];
+		generation = generation == UINT32_MAX ? 1 : generation + 1;
+		handle.generation = generation;
+
+		mAllocatedCounts[handle.index] = count;
+		mPersistentUsedCount += count;
+
+		freeRange.index += count;
+		freeRange.count -= count;
+
+		if (freeRange.count == 0)
+			mFreeRanges.erase(mFreeRanges.begin() + i);
+
+		return true;
+	}
+
+	return false;
+}
+
+bool DescriptorAllocator::Free(DescriptorHandle handle, uint64_t fence)
+{
+	if (!IsValid(handle))
+		return false;
+
+	mAllocatedCounts[handle.index] = 0;
+
+	RetiredRange retiredRange;
+	retiredRange.range.index = handle.index;
+	retiredRange.range.count = handle.count;
+	retiredRange.fence = fence;
+
+	mRetiredRanges.push_back(retiredRange);
+
+	return true;
+}
+
+bool DescriptorAllocator::IsValid(DescriptorHandle handle) const
+{
+	return handle.generation != 0 && handle.index < mPersistentCount && mAllocatedCounts[handle.index] == handle.count
+		&& mGenerations[handle.index] == handle.generation;
+}
+
+void DescriptorAllocator::BeginFrame(uint32_t frameIndex, uint64_t completedFence)
+{
+	mFrameIndex = frameIndex % mFrameCount;
+	mTransientHead = 0;
+
+	size_t keptCount = 0;
+
+	for (size_t i = 0; i < mRetiredRanges.size(); ++i)
+	{
+		if (mRetiredRanges[i].fence <= completedFence)
+		{
+			Release(mRetiredRanges[i].range);
+			continue;
+		}
+
+		mRetiredRanges[keptCount++] = mRetiredRanges[i];
+	}
+
+	mRetiredRanges.resize(keptCount);
+}
+
+bool DescriptorAllocator::AllocateTransient(uint32_t count, uint32_t& index)
+{
+	if (count > mTransientCount - mTransientHead)
+		return false;
+
+	index = mPersistentCount + mFrameIndex * mTransientCount + mTransientHead;
+	mTransientHead += count;
+
+	return true;
+}
+
+uint32_t DescriptorAllocator::GetLargestFreeRange() const
+{
+	uint32_t largestCount = 0;
+
+	for (const Range& freeRange : mFreeRanges)
+		largestCount = std::max(largestCount, freeRange.count);
+
+	return largestCount;
+}
+
+void DescriptorAllocator::Release(Range range)
+{
+	mPersistentUsedCount -= range.count;
+
+	auto next = std::lower_bound(mFreeRanges.begin(), mFreeRanges.end(), range.index,
+		[](const Range& freeRange, uint32_t index) { return freeRange.index < index; });
+
+	// Merge with the free ranges right before and after it
+	if (next != mFreeRanges.begin())
+	{
+		auto previous = next - 1;
+
+		if (previous->index + previous->count == range.index)
+		{
+			previous->count += range.count;
+
+			if (next != mFreeRanges.end() && previous->index + previous->count == next->index)
+			{
+				previous->count += next->count;
+				mFreeRanges.erase(next);
+			}
+
+			return;
+		}
+	}
+
+	if (next != mFreeRanges.end() && range.index + range.count == next->index)
+	{
+		next->index = range.index;
+		next->count += range.count;
+		return;
+	}
+
+	mFreeRanges.insert(next, range);
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A range of persistent descriptors. The generation tells a live handle from one whose range was
+// freed and handed out again, zero is the generation of nothing.
+struct DescriptorHandle
+{
+	uint32_t	index = 0;
+	uint32_t	count = 0;
+	uint32_t	generation = 0;
+};
+
+// Manages the indices of one descriptor heap, so it has no graphics API dependency. The front of the
+// heap holds persistent ranges, allocated first fit from a free list that coalesces neighbours.
+// Freed ranges are reused once the fence of the last frame reading them completed. Behind them
+// every frame resource has a linear region for tables that only live for one frame, rewound when
+// the frame begins again. Used by the render thread only.
+class DescriptorAllocator
+{
+public:
+	DescriptorAllocator() = default;
+	~DescriptorAllocator() = default;
+
+	// Persistent descriptors, transient descriptors per frame and the number of frames. Forgets every
+	// allocation, nothing may be in flight.
+	void Reset(uint32_t, uint32_t, uint32_t);
+
+	// Returns false when no free range is large enough
+	bool Allocate(uint32_t, DescriptorHandle&);
+	// The handle is stale right away, its range is reused once the given fence completed. Returns false
+	// for a stale handle.
+	bool Free(DescriptorHandle, uint64_t);
+	bool IsValid(DescriptorHandle) const;
+
+	// Rewinds the frame's transient region and frees the ranges whose fence completed. The GPU must be
+	// done with the frame.
+	void BeginFrame(uint32_t, uint64_t);
+	// Index of a table in the current frame's region, false when the region is full
+	bool AllocateTransient(uint32_t, uint32_t&);
+
+	uint32_t GetCapacity() const { return mPersistentCount + mTransientCount * mFrameCount; }
+	uint32_t GetPersistentCount() const { return mPersistentCount; }
+	// Including the ranges waiting for their fence
+	uint32_t GetPersistentUsedCount() const { return mPersistentUsedCount; }
+	uint32_t GetLargestFreeRange() const;
+	uint32_t GetTransientUsedCount() const { return mTransientHead; }
+	uint32_t GetFreeRangeCount() const { return (uint32_t)mFreeRanges.size(); }
+
+private:
+
+	struct Range
+	{
+		uint32_t index;
+		uint32_t count;
+	};
+
+	struct RetiredRange
+	{
+		Range range;
+		uint64_t fence;
+	};
+
+	void Release(Range);
+
+	// Sorted by index, neighbours are always merged
+	std::vector<Range> mFreeRanges;
+	std::vector<RetiredRange> mRetiredRanges;
+
+	// Per persistent descriptor, for the ones starting a live range: its size and generation
+	std::vector<uint32_t> mAllocatedCounts;
+	std::vector<uint32_t> mGenerations;
+
+	uint32_t mPersistentCount = 0;
+	uint32_t mPersistentUsedCount = 0;
+
+	uint32_t mTransientCount = 0;
+	uint32_t mFrameCount = 0;
+	uint32_t mFrameIndex = 0;
+	uint32_t mTransientHead = 0;
+};
\ No newline at end of file
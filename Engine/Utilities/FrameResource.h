@@ -1,8 +1,13 @@
 #pragma once
 
+#include "../Utilities/InjectionChangeDetector.h"
 #include "../Utilities/MathHelper.h"
+#include "../Utilities/SHUpdateScheduler.h"
 #include "../Utilities/UploadBuffer.h"
 
+// Frames the CPU may record ahead of the GPU, each with its own FrameResource
+const int gNumFrameResources = 3;
+
 struct ObjectConstants
 {
     DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
@@ -38,6 +43,16 @@ struct PassConstants
 	DirectX::XMFLOAT4X4 shadowTransform = MathHelper::Identity4x4();
 
 	DirectX::XMFLOAT4 worldBoundary_R_ConeStep_G_HalfCellWidth_B_voxelResolution_A = { 50.0f, 64.0f, 0.0f, 0.0f };
+
+	// SH grid cells cone traced this frame, two 16 bit cell indices per component
+	UINT shUpdateCellCount = 0;
+	DirectX::XMUINT3 shUpdatePadding = { 0, 0, 0 };
+	DirectX::XMUINT4 shUpdateCells[SHUpdateScheduler::MaxCellsPerFrame / 8] = {};
+
+	// Screen rectangles VoxelInjection.hlsl goes through this frame, as x, y, width and height in tiles
+	UINT injectionRectCount = 0;
+	DirectX::XMUINT3 injectionPadding = { 0, 0, 0 };
+	DirectX::XMUINT4 injectionRects[InjectionChangeDetector::MaxRects] = {};
 };
 
 struct Vertex
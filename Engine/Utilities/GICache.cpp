@@ -0,0 +1,232 @@
+#include "GICache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+const uint32_t GICache::Version;
+const uint32_t GICache::SHGridCount;
+const uint32_t GICache::Magic;
+const uint32_t GICache::DataAlignment;
+
+uint64_t GICache::Hash(const void* data, size_t size, uint64_t hash)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+std::string GICache::GetFilePath(const std::string& directory, const std::string& sceneName)
+{
+	// Scene names come from the scene files, anything but a plain name is replaced
+	std::string fileName = sceneName;
+
+	for (char& character : fileName)
+	{
+		if (character == '/' || character == '\\' || character == ':' || character == '.')
+			character = '_';
+	}
+
+	return directory + "/" + fileName + ".gicache";
+}
+
+bool GICache::Save(const std::string& filePath, const GICacheKey& key, const VoxelGrid* voxelMips, const VoxelGrid* shGrids)
+{
+	for (uint32_t mip = 0; mip < key.voxelMipCount; ++mip)
+	{
+		if (voxelMips[mip].GetResolution() != key.voxelResolution >> mip)
+			return false;
+	}
+
+	for (uint32_t grid = 0; grid < SHGridCount; ++grid)
+	{
+		if (shGrids[grid].GetResolution() != key.shGridResolution)
+			return false;
+	}
+
+	Header header = {};
+	header.magic = Magic;
+	header.version = Version;
+	header.contentHash = key.contentHash;
+	header.texelEncoding = key.texelEncoding;
+	header.worldBoundary = key.worldBoundary;
+	header.voxelResolution = key.voxelResolution;
+	header.voxelMipCount = key.voxelMipCount;
+	header.shGridResolution = key.shGridResolution;
+	header.nameLength = (uint32_t)key.sceneName.size();
+	header.dataOffset = (uint32_t)((sizeof(Header) + key.sceneName.size() + DataAlignment - 1) / DataAlignment * DataAlignment);
+	header.dataSize = GetDataSize(key);
+
+	std::vector<uint8_t> file(header.dataOffset + (size_t)header.dataSize, 0);
+	uint8_t* data = file.data() + header.dataOffset;
+
+	for (uint32_t mip = 0; mip < key.voxelMipCount; ++mip)
+	{
+		const size_t size = voxelMips[mip].GetTexelCount() * sizeof(uint32_t);
+		std::memcpy(data, voxelMips[mip].GetTexels(), size);
+		data += size;
+	}
+
+	for (uint32_t grid = 0; grid < SHGridCount; ++grid)
+	{
+		const size_t size = shGrids[grid].GetTexelCount() * sizeof(uint32_t);
+		std::memcpy(data, shGrids[grid].GetTexels(), size);
+		data += size;
+	}
+
+	header.dataChecksum = Checksum(file.data() + header.dataOffset, (size_t)header.dataSize);
+
+	std::memcpy(file.data(), &header, sizeof(Header));
+	std::memcpy(file.data() + sizeof(Header), key.sceneName.data(), key.sceneName.size());
+
+	const std::string temporaryPath = filePath + ".tmp";
+
+	{
+		std::ofstream outputFile(temporaryPath, std::ios::binary | std::ios::trunc);
+
+		if (!outputFile.is_open())
+			return false;
+
+		outputFile.write(reinterpret_cast<const char*>(file.data()), (std::streamsize)file.size());
+
+		if (!outputFile.good())
+		{
+			outputFile.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	// rename() doesn't replace an existing file everywhere
+	std::remove(filePath.c_str());
+
+	return std::rename(temporaryPath.c_str(), filePath.c_str()) == 0;
+}
+
+GICacheStatus GICache::Open(const std::string& filePath, const GICacheKey& key)
+{
+	Close();
+
+	if (!mFile.Open(filePath))
+		return GICacheStatus::Missing;
+
+	Header header;
+
+	if (mFile.GetSize() < sizeof(Header))
+	{
+		Close();
+		return GICacheStatus::Invalid;
+	}
+
+	std::memcpy(&header, mFile.GetData(), sizeof(Header));
+
+	if (header.magic != Magic || header.version != Version || header.voxelMipCount > 32 ||
+		(uint64_t)header.dataOffset + header.dataSize != mFile.GetSize() || header.dataOffset % DataAlignment != 0 ||
+		sizeof(Header) + (size_t)header.nameLength > header.dataOffset)
+	{
+		Close();
+		return GICacheStatus::Invalid;
+	}
+
+	// The key is checked before the data, a stale cache doesn't have to be read
+	const std::string sceneName(reinterpret_cast<const char*>(mFile.GetData() + sizeof(Header)), header.nameLength);
+
+	if (sceneName != key.sceneName || header.contentHash != key.contentHash || header.texelEncoding != key.texelEncoding ||
+		header.worldBoundary != key.worldBoundary || header.voxelResolution != key.voxelResolution ||
+		header.voxelMipCount != key.voxelMipCount || header.shGridResolution != key.shGridResolution)
+	{
+		Close();
+		return GICacheStatus::Stale;
+	}
+
+	const uint8_t* data = mFile.GetData() + header.dataOffset;
+
+	if (header.dataSize != GetDataSize(key) || Checksum(data, (size_t)header.dataSize) != header.dataChecksum)
+	{
+		Close();
+		return GICacheStatus::Invalid;
+	}
+
+	mKey = key;
+	mVoxelTexels.resize(key.voxelMipCount);
+
+	for (uint32_t mip = 0; mip < key.voxelMipCount; ++mip)
+	{
+		const size_t resolution = key.voxelResolution >> mip;
+		mVoxelTexels[mip] = reinterpret_cast<const uint32_t*>(data);
+		data += resolution * resolution * resolution * sizeof(uint32_t);
+	}
+
+	for (uint32_t grid = 0; grid < SHGridCount; ++grid)
+	{
+		const size_t resolution = key.shGridResolution;
+		mSHTexels[grid] = reinterpret_cast<const uint32_t*>(data);
+		data += resolution * resolution * resolution * sizeof(uint32_t);
+	}
+
+	return GICacheStatus::Loaded;
+}
+
+void GICache::Close()
+{
+	mFile.Close();
+	mVoxelTexels.clear();
+
+	for (uint32_t grid = 0; grid < SHGridCount; ++grid)
+		mSHTexels[grid] = nullptr;
+}
+
+void GICache::CopyTo(VoxelGrid* voxelMips, VoxelGrid* shGrids) const
+{
+	for (uint32_t mip = 0; mip < mKey.voxelMipCount; ++mip)
+	{
+		if (voxelMips[mip].GetResolution() != mKey.voxelResolution >> mip)
+			voxelMips[mip].Reset(mKey.voxelResolution >> mip);
+
+		std::memcpy(voxelMips[mip].GetTexels(), mVoxelTexels[mip], voxelMips[mip].GetTexelCount() * sizeof(uint32_t));
+	}
+
+	for (uint32_t grid = 0; grid < SHGridCount; ++grid)
+	{
+		if (shGrids[grid].GetResolution() != mKey.shGridResolution)
+			shGrids[grid].Reset(mKey.shGridResolution);
+
+		std::memcpy(shGrids[grid].GetTexels(), mSHTexels[grid], shGrids[grid].GetTexelCount() * sizeof(uint32_t));
+	}
+}
+
+size_t GICache::GetDataSize(const GICacheKey& key)
+{
+	size_t texelCount = 0;
+
+	for (uint32_t mip = 0; mip < key.voxelMipCount; ++mip)
+	{
+		const size_t resolution = key.voxelResolution >> mip;
+		texelCount += resolution * resolution * resolution;
+	}
+
+	texelCount += (size_t)SHGridCount * key.shGridResolution * key.shGridResolution * key.shGridResolution;
+
+	return texelCount * sizeof(uint32_t);
+}
+
+uint64_t GICache::Checksum(const uint8_t* data, size_t size)
+{
+	uint64_t checksum = 14695981039346656037ull;
+	const size_t wordCount = size / sizeof(uint64_t);
+
+	for (size_t i = 0; i < wordCount; ++i)
+	{
+		uint64_t word;
+		std::memcpy(&word, data + i * sizeof(uint64_t), sizeof(uint64_t));
+		checksum = (checksum ^ word) * 1099511628211ull;
+	}
+
+	return Hash(data + wordCount * sizeof(uint64_t), size - wordCount * sizeof(uint64_t), checksum);
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "VoxelGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a cache has to have been saved with to be used
+struct GICacheKey
+{
+	std::string		sceneName;
+	// Of the scene file and the meshes and textures it uses, see SceneManager
+	uint64_t		contentHash = 0;
+	// Of what the texels hold, raised whenever injection, downsampling or SH packing change it, so a
+	// cache written by an older build isn't read as if it was current. 2: occupancy in the coarse mips,
+	// 3: linear depth in the finest mip's alpha.
+	uint32_t		texelEncoding = 3;
+
+	float			worldBoundary = 50.0f;
+	uint32_t		voxelResolution = 64;
+	uint32_t		voxelMipCount = 5;
+	uint32_t		shGridResolution = 8;
+};
+
+enum class GICacheStatus
+{
+	Loaded,
+	// No file, or it can't be mapped
+	Missing,
+	// Not a cache of this version, truncated or corrupted
+	Invalid,
+	// A cache of another scene, of older scene content, texel encoding or of other grid settings
+	Stale
+};
+
+// Converged indirect lighting on disk, so a launch doesn't have to inject and cone trace for many
+// frames before it looks right. A file holds the voxel mips and the red, green and blue SH grids of one
+// scene, as the RGBA8 texels the GPU stores, behind a versioned header with the key and a checksum.
+//
+// Open() maps the file and checks it, the texels are then read straight from the mapping. Save()
+// writes to a temporary file first, so an interrupted save never replaces a good cache.
+class GICache
+{
+public:
+	GICache() = default;
+	~GICache() = default;
+
+	static const uint32_t Version = 2;
+	static const uint32_t SHGridCount = 3;
+
+	// 64 bit FNV-1a, continuing from a previous hash
+	static uint64_t Hash(const void*, size_t, uint64_t = 14695981039346656037ull);
+
+	// <directory>/<scene name>.gicache
+	static std::string GetFilePath(const std::string&, const std::string&);
+
+	// Voxel mips from the finest and the SH grids, at the key's resolutions. Returns false if the file
+	// can't be written.
+	static bool Save(const std::string&, const GICacheKey&, const VoxelGrid*, const VoxelGrid*);
+
+	GICacheStatus Open(const std::string&, const GICacheKey&);
+	void Close();
+
+	bool IsOpen() const { return mFile.IsOpen(); }
+	size_t GetFileSize() const { return mFile.GetSize(); }
+
+	// Into the mapping, valid until the cache is closed
+	const uint32_t* GetVoxelTexels(uint32_t mip) const { return mVoxelTexels[mip]; }
+	const uint32_t* GetSHTexels(uint32_t grid) const { return mSHTexels[grid]; }
+
+	// Copies every grid out of the mapping, resizing them
+	void CopyTo(VoxelGrid*, VoxelGrid*) const;
+
+private:
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t contentHash;
+		uint32_t texelEncoding;
+		float worldBoundary;
+		uint32_t voxelResolution;
+		uint32_t voxelMipCount;
+		uint32_t shGridResolution;
+		// The scene name follows the header, the texels start at the data offset
+		uint32_t nameLength;
+		uint32_t dataOffset;
+		uint64_t dataSize;
+		uint64_t dataChecksum;
+	};
+
+	static const uint32_t Magic = 0x49475650;	// "PVGI"
+	static const uint32_t DataAlignment = 64;
+
+	// Texels of all grids of a key
+	static size_t GetDataSize(const GICacheKey&);
+	// FNV-1a over eight bytes at a time, quick enough to check every load
+	static uint64_t Checksum(const uint8_t*, size_t);
+
+	MappedFile mFile;
+	GICacheKey mKey;
+	std::vector<const uint32_t*> mVoxelTexels;
+	const uint32_t* mSHTexels[SHGridCount] = {};
+};
\ No newline at end of file
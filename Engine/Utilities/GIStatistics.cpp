@@ -0,0 +1,297 @@
+#include "GIStatistics.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+	double GetPercentage(uint64_t count, uint64_t total)
+	{
+		return total > 0 ? 100.0 * (double)count / (double)total : 0.0;
+	}
+
+	uint64_t Sum(const uint64_t* values, uint32_t count)
+	{
+		uint64_t sum = 0;
+
+		for (uint32_t i = 0; i < count; ++i)
+			sum += values[i];
+
+		return sum;
+	}
+}
+
+double GIFrameStatistics::GetAverageHitMip() const
+{
+	uint64_t hits = 0;
+	uint64_t mipSum = 0;
+
+	for (uint32_t mip = 0; mip < SHGridBaker::MipCount; ++mip)
+	{
+		hits += hitCones[mip];
+		mipSum += (uint64_t)hitCones[mip] * mip;
+	}
+
+	return hits > 0 ? (double)mipSum / hits : 0.0;
+}
+
+void GIStatistics::Reset()
+{
+	mFrames.clear();
+	mGridResolution = 0;
+	mCellCount = 0;
+	mCellEnergies.clear();
+}
+
+const GIFrameStatistics& GIStatistics::AddFrame(const SHBakeSettings& settings, const VoxelGrid* grids, const VoxelGrid* shGrids,
+	const VoxelInjectionStatistics& injection)
+{
+	const uint32_t cellCount = settings.gridResolution * settings.gridResolution * settings.gridResolution;
+
+	// The cells of another grid resolution can't be compared, the frames start over
+	if (settings.gridResolution != mGridResolution)
+	{
+		Reset();
+		mGridResolution = settings.gridResolution;
+		mCellCount = cellCount;
+	}
+
+	GIFrameStatistics statistics;
+	statistics.frame = (uint32_t)mFrames.size();
+	statistics.injection = injection;
+
+	for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+	{
+		const uint32_t* texels = grids[mip].GetTexels();
+
+		for (size_t i = 0; i < grids[mip].GetTexelCount(); ++i)
+			statistics.filledVoxels[mip] += (texels[i] >> 24) != 0 ? 1 : 0;
+	}
+
+	// Every cone into its own slot, so the sums don't depend on the threads
+	const size_t coneCount = (size_t)cellCount * SHGridBaker::ConeCount;
+	mConeSamples.resize(coneCount);
+	mConeHitMips.resize(coneCount);
+
+	ThreadPool::ParallelFor(cellCount, 8, [&](size_t begin, size_t end)
+	{
+		const float (*directions)[3] = SHGridBaker::GetConeDirections();
+
+		for (size_t cell = begin; cell < end; ++cell)
+		{
+			float position[3];
+			SHGridBaker::GetCellPosition(settings, (uint32_t)cell, position);
+
+			for (uint32_t cone = 0; cone < SHGridBaker::ConeCount; ++cone)
+			{
+				const size_t i = cell * SHGridBaker::ConeCount + cone;
+				float color[3];
+
+				mConeSamples[i] = SHGridBaker::TraceCone(settings, grids, position, directions[cone], color, mConeHitMips[i]);
+			}
+		}
+	});
+
+	statistics.cones = (uint32_t)coneCount;
+
+	for (size_t i = 0; i < coneCount; ++i)
+	{
+		statistics.coneSamples += mConeSamples[i];
+
+		if (mConeHitMips[i] < SHGridBaker::MipCount)
+			++statistics.hitCones[mConeHitMips[i]];
+		else
+			++statistics.missedCones;
+	}
+
+	const size_t firstEnergy = mCellEnergies.size();
+	mCellEnergies.resize(firstEnergy + cellCount);
+
+	double energySum = 0.0;
+	double changeSum = 0.0;
+
+	for (uint32_t cell = 0; cell < cellCount; ++cell)
+	{
+		const float energy = MeasureCellEnergy(shGrids, cell);
+		mCellEnergies[firstEnergy + cell] = energy;
+
+		energySum += energy;
+		statistics.maxEnergy = std::max(statistics.maxEnergy, (double)energy);
+
+		if (firstEnergy > 0)
+		{
+			const float previousEnergy = mCellEnergies[firstEnergy - cellCount + cell];
+			changeSum += std::fabs(energy - previousEnergy);
+			statistics.changedCells += energy != previousEnergy ? 1 : 0;
+		}
+	}
+
+	statistics.meanEnergy = cellCount > 0 ? energySum / cellCount : 0.0;
+	statistics.meanEnergyChange = cellCount > 0 ? changeSum / cellCount : 0.0;
+
+	mFrames.push_back(statistics);
+
+	return mFrames.back();
+}
+
+bool GIStatistics::ExportCSV(const std::string& filePath) const
+{
+	std::ofstream outputFile(filePath, std::fstream::out | std::fstream::trunc);
+
+	if (!outputFile.is_open())
+		return false;
+
+	outputFile << "frame";
+
+	for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+		outputFile << ",filled_voxels_mip" << mip;
+
+	// The injection counts are summed over the mips injected into
+	outputFile << ",pixels,masked_pixels,background_pixels,outside_volume,written_empty,written_nearer,rejected_farther,rejected_darker";
+	outputFile << ",cones,mean_cone_samples,mean_hit_mip";
+
+	for (uint32_t mip = 0; mip < SHGridBaker::MipCount; ++mip)
+		outputFile << ",hit_cones_mip" << mip;
+
+	outputFile << ",missed_cones,sh_mean_energy,sh_max_energy,sh_mean_energy_change,sh_changed_cells\n";
+
+	for (const GIFrameStatistics& statistics : mFrames)
+	{
+		const VoxelInjectionStatistics& injection = statistics.injection;
+
+		outputFile << statistics.frame;
+
+		for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+			outputFile << "," << statistics.filledVoxels[mip];
+
+		outputFile << "," << injection.pixels << "," << injection.maskedPixels << "," << injection.backgroundPixels
+			<< "," << Sum(injection.outsideVolume, VoxelInjector::MipCount) << "," << Sum(injection.writtenEmpty, VoxelInjector::MipCount)
+			<< "," << Sum(injection.writtenNearer, VoxelInjector::MipCount) << "," << Sum(injection.rejectedFarther, VoxelInjector::MipCount)
+			<< "," << Sum(injection.rejectedDarker, VoxelInjector::MipCount);
+
+		outputFile << "," << statistics.cones << "," << statistics.GetAverageConeSamples() << "," << statistics.GetAverageHitMip();
+
+		for (uint32_t mip = 0; mip < SHGridBaker::MipCount; ++mip)
+			outputFile << "," << statistics.hitCones[mip];
+
+		outputFile << "," << statistics.missedCones << "," << statistics.meanEnergy << "," << statistics.maxEnergy
+			<< "," << statistics.meanEnergyChange << "," << statistics.changedCells << "\n";
+	}
+
+	outputFile.close();
+
+	return true;
+}
+
+bool GIStatistics::ExportCellEnergyCSV(const std::string& filePath) const
+{
+	std::ofstream outputFile(filePath, std::fstream::out | std::fstream::trunc);
+
+	if (!outputFile.is_open())
+		return false;
+
+	outputFile << "frame,cell,x,y,z,sh_energy\n";
+
+	const uint32_t resolution = mGridResolution;
+
+	for (size_t frame = 0; frame < mFrames.size(); ++frame)
+	{
+		for (uint32_t cell = 0; cell < mCellCount; ++cell)
+		{
+			outputFile << mFrames[frame].frame << "," << cell << "," << cell % resolution << "," << cell / resolution % resolution
+				<< "," << cell / (resolution * resolution) << "," << GetCellEnergy(frame, cell) << "\n";
+		}
+	}
+
+	outputFile.close();
+
+	return true;
+}
+
+std::string GIStatistics::GetSummary() const
+{
+	std::ostringstream summary;
+	summary << std::fixed << std::setprecision(1);
+	summary << "GI statistics: " << mFrames.size() << " frames\n";
+
+	if (mFrames.empty())
+		return summary.str();
+
+	VoxelInjectionStatistics injection;
+	uint64_t cones = 0;
+	uint64_t coneSamples = 0;
+	uint64_t hitCones[SHGridBaker::MipCount] = {};
+	uint64_t missedCones = 0;
+	double meanEnergyChange = 0.0;
+
+	for (const GIFrameStatistics& statistics : mFrames)
+	{
+		injection.Add(statistics.injection);
+		cones += statistics.cones;
+		coneSamples += statistics.coneSamples;
+		missedCones += statistics.missedCones;
+		meanEnergyChange += statistics.meanEnergyChange;
+
+		for (uint32_t mip = 0; mip < SHGridBaker::MipCount; ++mip)
+			hitCones[mip] += statistics.hitCones[mip];
+	}
+
+	const GIFrameStatistics& last = mFrames.back();
+
+	summary << "Filled voxels per mip in the last frame:";
+
+	for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+		summary << " " << last.filledVoxels[mip];
+
+	summary << "\nInjected pixels: " << injection.pixels << ", " << GetPercentage(injection.maskedPixels, injection.pixels) << "% masked, "
+		<< GetPercentage(injection.backgroundPixels, injection.pixels) << "% background\n";
+
+	for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+	{
+		const uint64_t tests = injection.writtenEmpty[mip] + injection.writtenNearer[mip] + injection.rejectedFarther[mip] + injection.rejectedDarker[mip];
+
+		if (tests + injection.outsideVolume[mip] == 0)
+			continue;
+
+		summary << "Mip " << mip << ": " << injection.outsideVolume[mip] << " pixels outside the volume, " << tests << " tested, "
+			<< GetPercentage(injection.writtenEmpty[mip], tests) << "% written empty, " << GetPercentage(injection.writtenNearer[mip], tests)
+			<< "% written nearer, " << GetPercentage(injection.rejectedFarther[mip], tests) << "% rejected farther, "
+			<< GetPercentage(injection.rejectedDarker[mip], tests) << "% rejected darker\n";
+	}
+
+	summary << std::setprecision(2);
+	summary << "Cones: " << cones << ", " << (cones > 0 ? (double)coneSamples / cones : 0.0) << " samples each, stopped at mip";
+
+	for (uint32_t mip = 0; mip < SHGridBaker::MipCount; ++mip)
+		summary << " " << mip << " " << std::setprecision(1) << GetPercentage(hitCones[mip], cones) << "%";
+
+	summary << ", missed " << GetPercentage(missedCones, cones) << "%\n";
+
+	summary << std::setprecision(4);
+	summary << "SH energy per cell in the last frame: " << last.meanEnergy << " mean, " << last.maxEnergy << " max, "
+		<< last.changedCells << " cells changed, " << meanEnergyChange / mFrames.size() << " mean change per frame\n";
+
+	return summary.str();
+}
+
+float GIStatistics::MeasureCellEnergy(const VoxelGrid* shGrids, uint32_t cell)
+{
+	float energy = 0.0f;
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		const uint32_t texel = shGrids[channel].GetTexels()[cell];
+
+		for (uint32_t coefficient = 0; coefficient < 4; ++coefficient)
+		{
+			const float value = VoxelGrid::Unpack(texel, coefficient);
+			energy += value * value;
+		}
+	}
+
+	return energy;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "SHGridBaker.h"
+#include "VoxelInjector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One frame of the voxel and SH grids and the injections into them
+struct GIFrameStatistics
+{
+	uint32_t frame = 0;
+
+	// Voxels with a nonzero alpha, per mip
+	uint32_t filledVoxels[VoxelInjector::MipCount] = {};
+
+	VoxelInjectionStatistics injection;
+
+	// The cones of every SH cell, traced the way DiffuseConeTrace() does
+	uint32_t cones = 0;
+	uint64_t coneSamples = 0;
+	// Per mip the cones stopped at, the rest found nothing
+	uint32_t hitCones[SHGridBaker::MipCount] = {};
+	uint32_t missedCones = 0;
+
+	// Of a cell, the sum of the squared SH coefficients of the three colors as the grids store them
+	double meanEnergy = 0.0;
+	double maxEnergy = 0.0;
+	// Mean absolute change since the frame before, and the cells whose energy changed
+	double meanEnergyChange = 0.0;
+	uint32_t changedCells = 0;
+
+	double GetAverageConeSamples() const { return cones > 0 ? (double)coneSamples / cones : 0.0; }
+	// Of the cones that stopped at a voxel
+	double GetAverageHitMip() const;
+};
+
+// Numbers to tune the voxel GI by, the iteration counts of ConeTracingUtil.hlsl among them. Every frame
+// added measures the filled voxels per mip, why injected pixels were or weren't written, how many
+// samples the SH cells' cones took and at which mip they stopped, and the SH energy of every cell. The
+// grids come from the CPU reference kernels, or from the GPU through Renderer's readback, the injection
+// counts only from VoxelInjector. Its ordered injection still has the luma test the packed shader
+// dropped, the packed one never rejects a pixel as darker.
+//
+// ExportCSV() writes a row per frame, ExportCellEnergyCSV() a row per frame and cell, and GetSummary()
+// averages the frames.
+class GIStatistics
+{
+public:
+	GIStatistics() = default;
+	~GIStatistics() = default;
+
+	void Reset();
+
+	// Voxel mips, the three SH grids and the injections since the frame before. The cones are traced
+	// on the thread pool.
+	const GIFrameStatistics& AddFrame(const SHBakeSettings&, const VoxelGrid*, const VoxelGrid*, const VoxelInjectionStatistics&);
+
+	const std::vector<GIFrameStatistics>& GetFrames() const { return mFrames; }
+	uint32_t GetCellCount() const { return mCellCount; }
+	float GetCellEnergy(size_t frame, uint32_t cell) const { return mCellEnergies[frame * mCellCount + cell]; }
+
+	bool ExportCSV(const std::string&) const;
+	bool ExportCellEnergyCSV(const std::string&) const;
+	std::string GetSummary() const;
+
+private:
+
+	static float MeasureCellEnergy(const VoxelGrid*, uint32_t);
+
+	std::vector<GIFrameStatistics> mFrames;
+	uint32_t mGridResolution = 0;
+	uint32_t mCellCount = 0;
+	// Every cell of every frame, frame by frame
+	std::vector<float> mCellEnergies;
+
+	// Scratch of AddFrame(), per cone
+	std::vector<uint32_t> mConeSamples;
+	std::vector<uint32_t> mConeHitMips;
+};
\ No newline at end of file
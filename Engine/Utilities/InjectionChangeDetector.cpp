@@ -0,0 +1,340 @@
+#include "InjectionChangeDetector.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+	// Row vector times matrix, as the shaders' mul(position, matrix)
+	void TransformPoint(const float* point, const DirectX::XMFLOAT4X4& matrix, float* result)
+	{
+		for (uint32_t column = 0; column < 4; ++column)
+		{
+			result[column] = point[0] * matrix.m[0][column] + point[1] * matrix.m[1][column]
+				+ point[2] * matrix.m[2][column] + point[3] * matrix.m[3][column];
+		}
+	}
+
+	DirectX::XMFLOAT4X4 Multiply(const DirectX::XMFLOAT4X4& a, const DirectX::XMFLOAT4X4& b)
+	{
+		DirectX::XMFLOAT4X4 result;
+
+		for (uint32_t row = 0; row < 4; ++row)
+			TransformPoint(a.m[row], b, result.m[row]);
+
+		return result;
+	}
+
+	template <typename T>
+	bool Differs(const T& a, const T& b)
+	{
+		return std::memcmp(&a, &b, sizeof(T)) != 0;
+	}
+
+	// No injected pixel is further than the volume's furthest corner
+	float GetMaxDepth(const InjectionView& view, float worldBoundary)
+	{
+		float maxDepthSquared = 0.0f;
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const float extent = std::fabs(view.invView.m[3][axis]) + worldBoundary;
+			maxDepthSquared += extent * extent;
+		}
+
+		return std::sqrt(maxDepthSquared);
+	}
+
+	// The view space ray through a pixel corner, from the near plane to the max depth or the far plane
+	// if that is nearer
+	void GetCornerRay(const InjectionView& view, uint32_t pixelX, uint32_t pixelY, float maxDepth, float (&viewPoints)[2][4])
+	{
+		// VoxelInjection.hlsl's mapping of a pixel to clip space, on the near and the far plane
+		const float clipX = (float)pixelX / (float)view.width * 2.0f - 1.0f;
+		const float clipY = (float)pixelY / (float)view.height * 2.0f - 1.0f;
+		const float clipPoints[2][4] = { { clipX, clipY, 0.0f, 1.0f }, { clipX, clipY, 1.0f, 1.0f } };
+
+		for (uint32_t end = 0; end < 2; ++end)
+		{
+			TransformPoint(clipPoints[end], view.invProj, viewPoints[end]);
+
+			for (uint32_t i = 0; i < 4; ++i)
+				viewPoints[end][i] /= viewPoints[end][3];
+		}
+
+		// The ray's far end is pulled in to the volume, both ends are on the same ray through the eye
+		const float depthRange = viewPoints[1][2] - viewPoints[0][2];
+		const float farFraction = depthRange > 0.0f ? std::min(std::max((maxDepth - viewPoints[0][2]) / depthRange, 0.0f), 1.0f) : 1.0f;
+
+		for (uint32_t i = 0; i < 3; ++i)
+			viewPoints[1][i] = viewPoints[0][i] + (viewPoints[1][i] - viewPoints[0][i]) * farFraction;
+	}
+}
+
+const uint32_t InjectionChangeDetector::TileSize;
+const uint32_t InjectionChangeDetector::MaxRects;
+const uint32_t InjectionChangeDetector::DepthSlices;
+
+void InjectionChangeDetector::Reset(const InjectionChangeSettings& settings)
+{
+	mSettings = settings;
+	mCounters = InjectionCounters();
+
+	bHasPrevious = false;
+	bSceneChanged = false;
+	mPendingFrames = 0;
+
+	mTilesX = 0;
+	mTilesY = 0;
+	mTileCount = 0;
+	mTileMask.clear();
+	mRects.clear();
+}
+
+InjectionDecision InjectionChangeDetector::Detect(const InjectionView& view)
+{
+	const uint32_t tilesX = view.width / TileSize;
+	const uint32_t tilesY = view.height / TileSize;
+	const bool bResized = tilesX != mTilesX || tilesY != mTilesY;
+
+	mTilesX = tilesX;
+	mTilesY = tilesY;
+	mTileCount = 0;
+	mTileMask.assign((size_t)tilesX * tilesY, 0);
+	mRects.clear();
+
+	bSceneChanged = !bHasPrevious || bResized || view.bSceneChanged || Differs(view.proj, mPrevious.proj)
+		|| Differs(view.lightDirection, mPrevious.lightDirection) || Differs(view.lightStrength, mPrevious.lightStrength);
+
+	InjectionDecision decision = InjectionDecision::Skip;
+
+	if (bSceneChanged)
+	{
+		decision = InjectionDecision::Full;
+	}
+	else if (Differs(view.view, mPrevious.view))
+	{
+		++mPendingFrames;
+
+		if (mPendingFrames >= mSettings.refreshFrames)
+			decision = InjectionDecision::Full;
+		else if (MarkExposedTiles(view) > 0)
+			decision = InjectionDecision::Tiles;
+	}
+	else if (mPendingFrames > 0)
+	{
+		// The camera stopped
+		decision = InjectionDecision::Full;
+	}
+
+	if (decision == InjectionDecision::Full)
+	{
+		InjectAll();
+		mPendingFrames = 0;
+	}
+	else if (decision == InjectionDecision::Tiles)
+	{
+		BuildRects();
+	}
+
+	mPrevious = view;
+	bHasPrevious = true;
+
+	const uint64_t totalTiles = (uint64_t)tilesX * tilesY;
+
+	++mCounters.frames;
+	mCounters.skippedFrames += decision == InjectionDecision::Skip ? 1 : 0;
+	mCounters.tileFrames += decision == InjectionDecision::Tiles ? 1 : 0;
+	mCounters.fullFrames += decision == InjectionDecision::Full ? 1 : 0;
+	mCounters.injectedTiles += mTileCount;
+	mCounters.skippedTiles += totalTiles - mTileCount;
+
+	return decision;
+}
+
+bool InjectionChangeDetector::GetInjectedBounds(uint32_t rectIndex, uint32_t slice, float* boxMin, float* boxMax) const
+{
+	const InjectionRect& rect = mRects[rectIndex];
+	const float maxDepth = GetMaxDepth(mPrevious, mSettings.worldBoundary);
+
+	const uint32_t cornersX[2] = { rect.x * TileSize, (rect.x + rect.width) * TileSize };
+	const uint32_t cornersY[2] = { rect.y * TileSize, (rect.y + rect.height) * TileSize };
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		boxMin[axis] = FLT_MAX;
+		boxMax[axis] = -FLT_MAX;
+	}
+
+	// The rectangle's view up to the max depth is the hull of its corners' rays, as for the tiles. The
+	// slices are at even view depths, the rays' ends are on the near plane and at a common far depth.
+	for (uint32_t corner = 0; corner < 4; ++corner)
+	{
+		float viewPoints[2][4];
+		GetCornerRay(mPrevious, cornersX[corner & 1], cornersY[corner >> 1], maxDepth, viewPoints);
+
+		for (uint32_t end = 0; end < 2; ++end)
+		{
+			const float fraction = (float)(slice + end) / (float)DepthSlices;
+			float slicePoint[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+			for (uint32_t i = 0; i < 3; ++i)
+				slicePoint[i] = viewPoints[0][i] + (viewPoints[1][i] - viewPoints[0][i]) * fraction;
+
+			float worldPoint[4];
+			TransformPoint(slicePoint, mPrevious.invView, worldPoint);
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				boxMin[axis] = std::min(boxMin[axis], worldPoint[axis]);
+				boxMax[axis] = std::max(boxMax[axis], worldPoint[axis]);
+			}
+		}
+	}
+
+	// Clipped to the volume
+	bool bInside = true;
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		boxMin[axis] = std::max(boxMin[axis], -mSettings.worldBoundary);
+		boxMax[axis] = std::min(boxMax[axis], mSettings.worldBoundary);
+		bInside = bInside && boxMin[axis] <= boxMax[axis];
+	}
+
+	return bInside;
+}
+
+std::string InjectionChangeDetector::GetReport() const
+{
+	const uint64_t totalTiles = mCounters.injectedTiles + mCounters.skippedTiles;
+
+	std::ostringstream report;
+	report << std::fixed << std::setprecision(1);
+	report << "Voxel injection: " << mCounters.frames << " frames, " << mCounters.skippedFrames << " skipped, "
+		<< mCounters.tileFrames << " exposed tiles only, " << mCounters.fullFrames << " whole screen\n";
+	report << "Tiles injected: " << mCounters.injectedTiles << " of " << totalTiles << " ("
+		<< (totalTiles > 0 ? 100.0 * mCounters.injectedTiles / totalTiles : 0.0) << "%), " << mCounters.skippedTiles << " skipped\n";
+
+	return report.str();
+}
+
+uint32_t InjectionChangeDetector::MarkExposedTiles(const InjectionView& view)
+{
+	// From this frame's view space to the previous frame's clip space
+	const DirectX::XMFLOAT4X4 reprojection = Multiply(view.invView, Multiply(mPrevious.view, mPrevious.proj));
+
+	const float maxDepth = GetMaxDepth(view, mSettings.worldBoundary);
+
+	// Corners of the tiles, shared by up to four of them
+	const uint32_t cornersX = mTilesX + 1;
+	mExposedCorners.assign((size_t)cornersX * (mTilesY + 1), 0);
+
+	for (uint32_t cornerY = 0; cornerY <= mTilesY; ++cornerY)
+	{
+		for (uint32_t cornerX = 0; cornerX <= mTilesX; ++cornerX)
+		{
+			float viewPoints[2][4];
+			GetCornerRay(view, cornerX * TileSize, cornerY * TileSize, maxDepth, viewPoints);
+
+			bool bExposed = false;
+
+			for (uint32_t end = 0; end < 2 && !bExposed; ++end)
+			{
+				float previousClipPoint[4];
+				TransformPoint(viewPoints[end], reprojection, previousClipPoint);
+
+				const float w = previousClipPoint[3];
+
+				bExposed = !(w > 0.0f) || std::fabs(previousClipPoint[0]) > w || std::fabs(previousClipPoint[1]) > w;
+			}
+
+			mExposedCorners[(size_t)cornerY * cornersX + cornerX] = bExposed ? 1 : 0;
+		}
+	}
+
+	// A tile's view between the ends is the hull of its corners' rays, so it stayed in view when they did
+	for (uint32_t tileY = 0; tileY < mTilesY; ++tileY)
+	{
+		for (uint32_t tileX = 0; tileX < mTilesX; ++tileX)
+		{
+			const uint8_t* corners = &mExposedCorners[(size_t)tileY * cornersX + tileX];
+			const bool bExposed = corners[0] != 0 || corners[1] != 0 || corners[cornersX] != 0 || corners[cornersX + 1] != 0;
+
+			mTileMask[(size_t)tileY * mTilesX + tileX] = bExposed ? 1 : 0;
+			mTileCount += bExposed ? 1 : 0;
+		}
+	}
+
+	return mTileCount;
+}
+
+void InjectionChangeDetector::BuildRects()
+{
+	// Runs of tiles in a row, a run continuing one of the row above as tall as the rectangle so far
+	for (uint32_t tileY = 0; tileY < mTilesY; ++tileY)
+	{
+		const uint8_t* row = &mTileMask[(size_t)tileY * mTilesX];
+
+		for (uint32_t tileX = 0; tileX < mTilesX; ++tileX)
+		{
+			if (row[tileX] == 0)
+				continue;
+
+			uint32_t end = tileX;
+
+			while (end < mTilesX && row[end] != 0)
+				++end;
+
+			auto continued = std::find_if(mRects.begin(), mRects.end(), [tileX, end, tileY](const InjectionRect& rect)
+			{
+				return rect.x == tileX && rect.width == end - tileX && rect.y + rect.height == tileY;
+			});
+
+			if (continued != mRects.end())
+				++continued->height;
+			else
+				mRects.push_back({ tileX, tileY, end - tileX, 1 });
+
+			tileX = end;
+		}
+	}
+
+	if (mRects.size() <= MaxRects)
+		return;
+
+	// Too scattered, the bounds of all of them are injected
+	InjectionRect bounds = mRects[0];
+	uint32_t boundsEndX = bounds.x + bounds.width;
+	uint32_t boundsEndY = bounds.y + bounds.height;
+
+	for (const InjectionRect& rect : mRects)
+	{
+		bounds.x = std::min(bounds.x, rect.x);
+		bounds.y = std::min(bounds.y, rect.y);
+		boundsEndX = std::max(boundsEndX, rect.x + rect.width);
+		boundsEndY = std::max(boundsEndY, rect.y + rect.height);
+	}
+
+	bounds.width = boundsEndX - bounds.x;
+	bounds.height = boundsEndY - bounds.y;
+
+	mRects.assign(1, bounds);
+	mTileCount = bounds.width * bounds.height;
+
+	for (uint32_t tileY = bounds.y; tileY < boundsEndY; ++tileY)
+		std::fill_n(&mTileMask[(size_t)tileY * mTilesX + bounds.x], bounds.width, (uint8_t)1);
+}
+
+void InjectionChangeDetector::InjectAll()
+{
+	std::fill(mTileMask.begin(), mTileMask.end(), (uint8_t)1);
+	mTileCount = mTilesX * mTilesY;
+
+	if (mTileCount > 0)
+		mRects.assign(1, { 0, 0, mTilesX, mTilesY });
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct InjectionChangeSettings
+{
+	// Of VoxelInjectionRenderPass's volume, pixels beyond it are never injected
+	float		worldBoundary = 50.0f;
+
+	// Frames the camera may move with only the newly exposed tiles injected before the whole screen is
+	// again, for the surfaces moving the camera uncovers inside the previous view
+	uint32_t	refreshFrames = 8;
+};
+
+// A frame's camera, light and scene, what the pixels VoxelInjection.hlsl reads depend on
+struct InjectionView
+{
+	// Not transposed, as the camera keeps them
+	DirectX::XMFLOAT4X4	view;
+	DirectX::XMFLOAT4X4	invView;
+	DirectX::XMFLOAT4X4	proj;
+	DirectX::XMFLOAT4X4	invProj;
+
+	DirectX::XMFLOAT3	lightDirection = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3	lightStrength = { 0.0f, 0.0f, 0.0f };
+
+	// Some object or material is dirty
+	bool				bSceneChanged = false;
+
+	uint32_t			width = 0;
+	uint32_t			height = 0;
+};
+
+enum class InjectionDecision
+{
+	Skip,
+	Tiles,
+	Full
+};
+
+// Tiles of a rectangle of the screen, in tiles
+struct InjectionRect
+{
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+};
+
+struct InjectionCounters
+{
+	uint64_t frames = 0;
+	uint64_t skippedFrames = 0;
+	uint64_t tileFrames = 0;
+	uint64_t fullFrames = 0;
+
+	// Thread groups of the injection dispatched and left out
+	uint64_t injectedTiles = 0;
+	uint64_t skippedTiles = 0;
+};
+
+// Decides how much of the screen voxel injection has to go through each frame. Nothing changed, the
+// pixels are the ones injected before and the dispatch is skipped. The light, the projection, the
+// screen size or a dirty object changed, the whole screen is injected. Only the camera moved, the
+// injection is restricted to the 16x16 tiles showing what the previous frame didn't: a tile is newly
+// exposed when a corner of it, between the near plane and the far end of the voxel volume, reprojects
+// outside the previous view.
+//
+// Reprojection misses what the moving camera uncovers behind nearer surfaces, and the pixels still in
+// view are lit from a new angle, so the whole screen is injected again every refreshFrames frames
+// while moving and once when the camera stops.
+class InjectionChangeDetector
+{
+public:
+	InjectionChangeDetector() = default;
+	~InjectionChangeDetector() = default;
+
+	// The thread group size of VoxelInjection.hlsl
+	static const uint32_t TileSize = 16;
+	// What PassConstants has room for, more are merged into their bounds
+	static const uint32_t MaxRects = 16;
+	// Of a rectangle's view for GetInjectedBounds(), boxes around a slanted view are far larger than it
+	static const uint32_t DepthSlices = 4;
+
+	// Forgets the previous frame, the next one is injected whole
+	void Reset(const InjectionChangeSettings&);
+
+	// Starts a frame, fills the rectangles and the tile mask to inject
+	InjectionDecision Detect(const InjectionView&);
+
+	const std::vector<InjectionRect>& GetRects() const { return mRects; }
+	// One byte per tile, row by row, nonzero for the tiles to inject
+	const uint8_t* GetTileMask() const { return mTileMask.data(); }
+	uint32_t GetTileCount() const { return mTileCount; }
+	uint32_t GetTilesX() const { return mTilesX; }
+	uint32_t GetTilesY() const { return mTilesY; }
+	// The last Detect() saw the light or the scene change, not only the camera
+	bool HasSceneChanged() const { return bSceneChanged; }
+	// World space bounds of the voxels a rectangle can inject into between two view depths, as min and
+	// max corners: a slice of its view up to the far end of the volume, clipped to it. False when the
+	// slice is outside the volume.
+	bool GetInjectedBounds(uint32_t, uint32_t, float*, float*) const;
+
+	const InjectionChangeSettings& GetSettings() const { return mSettings; }
+	const InjectionCounters& GetCounters() const { return mCounters; }
+	std::string GetReport() const;
+
+private:
+
+	// Marks the newly exposed tiles, returns how many there are
+	uint32_t MarkExposedTiles(const InjectionView&);
+	void BuildRects();
+	void InjectAll();
+
+	InjectionChangeSettings mSettings;
+	InjectionCounters mCounters;
+
+	InjectionView mPrevious;
+	bool bHasPrevious = false;
+	bool bSceneChanged = false;
+	// Frames since the camera started moving without the whole screen injected, zero when it was
+	uint32_t mPendingFrames = 0;
+
+	uint32_t mTilesX = 0;
+	uint32_t mTilesY = 0;
+	uint32_t mTileCount = 0;
+	std::vector<uint8_t> mTileMask;
+	std::vector<InjectionRect> mRects;
+
+	// Scratch of MarkExposedTiles()
+	std::vector<uint8_t> mExposedCorners;
+};
\ No newline at end of file
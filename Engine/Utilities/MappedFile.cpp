@@ -0,0 +1,166 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+{
+	MoveFrom(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+	if (this != &other)
+	{
+		Close();
+		MoveFrom(other);
+	}
+
+	return *this;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mappingHandle == nullptr)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+	if (view == nullptr)
+	{
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	mFileHandle = fileHandle;
+	mMappingHandle = mappingHandle;
+	mData = static_cast<const uint8_t*>(view);
+	mSize = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+
+	if (mMappingHandle != nullptr)
+		CloseHandle(mMappingHandle);
+
+	if (mFileHandle != nullptr)
+		CloseHandle(mFileHandle);
+
+	mFileHandle = nullptr;
+	mMappingHandle = nullptr;
+	mData = nullptr;
+	mSize = 0;
+}
+
+void MappedFile::MoveFrom(MappedFile& other)
+{
+	mFileHandle = other.mFileHandle;
+	mMappingHandle = other.mMappingHandle;
+	mData = other.mData;
+	mSize = other.mSize;
+
+	other.mFileHandle = nullptr;
+	other.mMappingHandle = nullptr;
+	other.mData = nullptr;
+	other.mSize = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+
+	if (fileDescriptor < 0)
+		return false;
+
+	struct stat fileStatus;
+
+	if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+	if (view == MAP_FAILED)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	mFileDescriptor = fileDescriptor;
+	mData = static_cast<const uint8_t*>(view);
+	mSize = (size_t)fileStatus.st_size;
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData != nullptr)
+		munmap(const_cast<uint8_t*>(mData), mSize);
+
+	if (mFileDescriptor >= 0)
+		close(mFileDescriptor);
+
+	mFileDescriptor = -1;
+	mData = nullptr;
+	mSize = 0;
+}
+
+void MappedFile::MoveFrom(MappedFile& other)
+{
+	mFileDescriptor = other.mFileDescriptor;
+	mData = other.mData;
+	mSize = other.mSize;
+
+	other.mFileDescriptor = -1;
+	other.mData = nullptr;
+	other.mSize = 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read only memory mapping of a whole file. The pages are only read from disk when touched, so
+// looking at a header or a single mip of a large file does not pull in the rest of it.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&&);
+	MappedFile& operator=(MappedFile&&);
+
+	// Returns false if the file can't be opened or mapped. Empty files can't be mapped.
+	bool Open(const std::string&);
+	void Close();
+
+	bool IsOpen() const { return mData != nullptr; }
+	const uint8_t* GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+
+private:
+
+	void MoveFrom(MappedFile&);
+
+#if defined(_WIN32)
+	// HANDLEs, kept as void* so windows.h stays out of this header
+	void* mFileHandle = nullptr;
+	void* mMappingHandle = nullptr;
+#else
+	int mFileDescriptor = -1;
+#endif
+
+	const uint8_t* mData = nullptr;
+	size_t mSize = 0;
+};
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "MemoryArena.h"
+
+MemoryArena::MemoryArena(size_t blockSize)
+	: mBlockSize(blockSize)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+	Release();
+}
+
+void* MemoryArena::Allocate(size_t size, size_t alignment)
+{
+	// Try the current block, then any blocks left over from a previous fill
+	for (; mCurrentBlock < mBlocks.size(); ++mCurrentBlock)
+	{
+		Block& block = mBlocks[mCurrentBlock];
+
+		uintptr_t address = (uintptr_t)(block.memory + block.used);
+		size_t padding = (alignment - (address % alignment)) % alignment;
+
+		if (block.used + padding + size <= block.size)
+		{
+			block.used += padding + size;
+			return block.memory + block.used - size;
+		}
+	}
+
+	// Oversized requests get a block of their own, the padding covers any alignment above the heap's
+	AddBlock((size + alignment > mBlockSize) ? (size + alignment) : mBlockSize);
+
+	return Allocate(size, alignment);
+}
+
+void MemoryArena::Reset()
+{
+	RunDestructors();
+
+	// A fill that spilled over several blocks is coalesced into one, so refilling with the same
+	// data is a single contiguous run
+	if (mBlocks.size() > 1)
+	{
+		size_t totalSize = GetReservedBytes();
+
+		FreeBlocks();
+		AddBlock(totalSize);
+	}
+
+	for (Block& block : mBlocks)
+		block.used = 0;
+
+	mCurrentBlock = 0;
+}
+
+void MemoryArena::Release()
+{
+	RunDestructors();
+	FreeBlocks();
+
+	mDestructors.shrink_to_fit();
+}
+
+size_t MemoryArena::GetUsedBytes() const
+{
+	size_t usedBytes = 0;
+
+	for (const Block& block : mBlocks)
+		usedBytes += block.used;
+
+	return usedBytes;
+}
+
+size_t MemoryArena::GetReservedBytes() const
+{
+	size_t reservedBytes = 0;
+
+	for (const Block& block : mBlocks)
+		reservedBytes += block.size;
+
+	return reservedBytes;
+}
+
+size_t MemoryArena::GetBlockCount() const
+{
+	return mBlocks.size();
+}
+
+void MemoryArena::RunDestructors()
+{
+	// Newest first, later objects may point at earlier ones
+	for (size_t i = mDestructors.size(); i > 0; --i)
+		mDestructors[i - 1].function(mDestructors[i - 1].objects, mDestructors[i - 1].count);
+
+	mDestructors.clear();
+}
+
+void MemoryArena::AddBlock(size_t size)
+{
+	Block block;
+	block.memory = static_cast<uint8_t*>(::operator new(size));
+	block.size = size;
+	block.used = 0;
+
+	mBlocks.push_back(block);
+}
+
+void MemoryArena::FreeBlocks()
+{
+	for (Block& block : mBlocks)
+		::operator delete(block.memory);
+
+	mBlocks.clear();
+	mCurrentBlock = 0;
+}
\ No newline at end of file
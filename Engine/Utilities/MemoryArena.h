@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that shares one lifetime, e.g. everything belonging to a loaded scene.
+// Allocation bumps a pointer inside a large block, and Reset() releases everything at once. Objects
+// with non-trivial destructors (strings, ComPtrs) are recorded once per array and destroyed newest
+// first on Reset(). The blocks are kept, so refilling the arena with the same data allocates nothing.
+class MemoryArena
+{
+public:
+	explicit MemoryArena(size_t blockSize = 64 * 1024);
+	~MemoryArena();
+
+	MemoryArena(const MemoryArena&) = delete;
+	MemoryArena& operator=(const MemoryArena&) = delete;
+
+	void* Allocate(size_t, size_t);
+
+	template<typename T>
+	T* New()
+	{
+		return NewArray<T>(1);
+	}
+
+	// Default constructs count objects in arena memory
+	template<typename T>
+	T* NewArray(size_t count)
+	{
+		if (count == 0)
+			return nullptr;
+
+		T* objects = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+
+		for (size_t i = 0; i < count; ++i)
+			new (objects + i) T();
+
+		if (!std::is_trivially_destructible<T>::value)
+			mDestructors.push_back({ objects, count, &DestroyArray<T> });
+
+		return objects;
+	}
+
+	// Destroys every object and rewinds the arena, keeping its memory for the next fill
+	void Reset();
+
+	// Reset() and return all memory to the heap
+	void Release();
+
+	size_t GetUsedBytes() const;
+	size_t GetReservedBytes() const;
+	size_t GetBlockCount() const;
+
+private:
+
+	struct Block
+	{
+		uint8_t* memory;
+		size_t size;
+		size_t used;
+	};
+
+	struct Destructor
+	{
+		void* objects;
+		size_t count;
+		void (*function)(void*, size_t);
+	};
+
+	template<typename T>
+	static void DestroyArray(void* objects, size_t count)
+	{
+		T* typedObjects = static_cast<T*>(objects);
+
+		for (size_t i = count; i > 0; --i)
+			typedObjects[i - 1].~T();
+	}
+
+	void RunDestructors();
+	void AddBlock(size_t);
+	void FreeBlocks();
+
+	std::vector<Block> mBlocks;
+	std::vector<Destructor> mDestructors;
+	size_t mCurrentBlock = 0;
+	size_t mBlockSize;
+};
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "MemoryTracker.h"
+
+#include <cstdio>
+
+std::mutex MemoryTracker::mMutex;
+std::unordered_map<const void*, MemoryTracker::Allocation> MemoryTracker::mAllocations;
+uint64_t MemoryTracker::mLiveBytes[(int)MemoryCategory::Count] = {};
+uint64_t MemoryTracker::mPeakBytes[(int)MemoryCategory::Count] = {};
+
+void MemoryTracker::Track(MemoryCategory category, const void* allocation, uint64_t size)
+{
+	if (allocation == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// Re-tracking the same address (e.g. a recreated resource) replaces the old entry
+	auto existing = mAllocations.find(allocation);
+
+	if (existing != mAllocations.end())
+	{
+		mLiveBytes[(int)existing->second.category] -= existing->second.size;
+		mAllocations.erase(existing);
+	}
+
+	mAllocations[allocation] = { category, size };
+
+	int index = (int)category;
+	mLiveBytes[index] += size;
+
+	if (mLiveBytes[index] > mPeakBytes[index])
+		mPeakBytes[index] = mLiveBytes[index];
+}
+
+void MemoryTracker::Untrack(const void* allocation)
+{
+	if (allocation == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto existing = mAllocations.find(allocation);
+
+	if (existing == mAllocations.end())
+		return;
+
+	mLiveBytes[(int)existing->second.category] -= existing->second.size;
+	mAllocations.erase(existing);
+}
+
+uint64_t MemoryTracker::GetLiveBytes(MemoryCategory category)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mLiveBytes[(int)category];
+}
+
+uint64_t MemoryTracker::GetPeakBytes(MemoryCategory category)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mPeakBytes[(int)category];
+}
+
+uint64_t MemoryTracker::GetTotalLiveBytes()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	uint64_t result = 0;
+
+	for (int i = 0; i < (int)MemoryCategory::Count; ++i)
+		result += mLiveBytes[i];
+
+	return result;
+}
+
+const char* MemoryTracker::GetCategoryName(MemoryCategory category)
+{
+	switch (category)
+	{
+	case MemoryCategory::Textures:
+		return "Textures";
+	case MemoryCategory::Geometry:
+		return "Geometry";
+	case MemoryCategory::PassOutputs:
+		return "Pass outputs";
+	case MemoryCategory::VoxelGrids:
+		return "Voxel/SH grids";
+	case MemoryCategory::ConstantBuffers:
+		return "Constant buffers";
+	case MemoryCategory::Staging:
+		return "Staging";
+	default:
+		return "Unknown";
+	}
+}
+
+std::string MemoryTracker::GetReport()
+{
+	std::string result = "Category               Live (KB)     Peak (KB)\n";
+
+	uint64_t totalLiveBytes = 0;
+	char line[128];
+
+	for (int i = 0; i < (int)MemoryCategory::Count; ++i)
+	{
+		MemoryCategory category = (MemoryCategory)i;
+
+		uint64_t liveBytes = GetLiveBytes(category);
+		totalLiveBytes += liveBytes;
+
+		snprintf(line, sizeof(line), "%-20s %12.1f  %12.1f\n", GetCategoryName(category),
+			liveBytes / 1024.0, GetPeakBytes(category) / 1024.0);
+		result += line;
+	}
+
+	snprintf(line, sizeof(line), "%-20s %12.1f\n", "Total", totalLiveBytes / 1024.0);
+	result += line;
+
+	return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+enum class MemoryCategory
+{
+	Textures,
+	Geometry,
+	PassOutputs,
+	VoxelGrids,
+	ConstantBuffers,
+	// Upload heaps and system memory copies that are only needed until the data reached the GPU
+	Staging,
+	Count
+};
+
+// Registry of live allocations tagged by category. Allocations are keyed by their address (the
+// resource or blob pointer) so they can be untracked without knowing their size or category.
+class MemoryTracker
+{
+public:
+	MemoryTracker() = default;
+	~MemoryTracker() = default;
+
+	static void Track(MemoryCategory, const void*, uint64_t);
+	static void Untrack(const void*);
+
+	static uint64_t GetLiveBytes(MemoryCategory);
+	static uint64_t GetPeakBytes(MemoryCategory);
+	static uint64_t GetTotalLiveBytes();
+
+	static const char* GetCategoryName(MemoryCategory);
+
+	// Live and peak bytes of every category as a printable table
+	static std::string GetReport();
+
+private:
+
+	struct Allocation
+	{
+		MemoryCategory category;
+		uint64_t size;
+	};
+
+	static std::mutex mMutex;
+	static std::unordered_map<const void*, Allocation> mAllocations;
+	static uint64_t mLiveBytes[(int)MemoryCategory::Count];
+	static uint64_t mPeakBytes[(int)MemoryCategory::Count];
+};
@@ -0,0 +1,305 @@
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// The diffuse texture is decoded with pow(x, 2.2) in the shader, not the sRGB curve
+	const float DiffuseGamma = 2.2f;
+
+	// Bisection steps of the alpha scale search, far finer than one step of 8 bit alpha
+	const uint32_t AlphaScaleIterations = 24;
+
+	struct GammaTable
+	{
+		float toLinear[256];
+
+		GammaTable()
+		{
+			for (int i = 0; i < 256; ++i)
+				toLinear[i] = std::pow(i / 255.0f, DiffuseGamma);
+		}
+	};
+
+	const GammaTable& GetGammaTable()
+	{
+		static GammaTable table;
+		return table;
+	}
+
+	uint8_t ToByte(float value)
+	{
+		return (uint8_t)std::min(std::max(value * 255.0f + 0.5f, 0.0f), 255.0f);
+	}
+
+	// Float RGBA of the whole level, the chain is filtered from these so no level is quantized twice
+	struct FloatLevel
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<float> texels;
+	};
+
+	void Downsample(const FloatLevel& source, FloatLevel& destination)
+	{
+		destination.width = std::max(1u, source.width / 2);
+		destination.height = std::max(1u, source.height / 2);
+		destination.texels.resize((size_t)destination.width * destination.height * 4);
+
+		ThreadPool::ParallelFor(destination.height, std::max<size_t>(1, 4096 / destination.width), [&](size_t begin, size_t end)
+		{
+			for (size_t y = begin; y < end; ++y)
+			{
+				size_t y0 = std::min<size_t>(2 * y, source.height - 1);
+				size_t y1 = std::min<size_t>(2 * y + 1, source.height - 1);
+
+				for (size_t x = 0; x < destination.width; ++x)
+				{
+					size_t x0 = std::min<size_t>(2 * x, source.width - 1);
+					size_t x1 = std::min<size_t>(2 * x + 1, source.width - 1);
+
+					const float* texel00 = &source.texels[(y0 * source.width + x0) * 4];
+					const float* texel01 = &source.texels[(y0 * source.width + x1) * 4];
+					const float* texel10 = &source.texels[(y1 * source.width + x0) * 4];
+					const float* texel11 = &source.texels[(y1 * source.width + x1) * 4];
+
+					float* output = &destination.texels[(y * destination.width + x) * 4];
+
+					for (int channel = 0; channel < 4; ++channel)
+						output[channel] = 0.25f * (texel00[channel] + texel01[channel] + texel10[channel] + texel11[channel]);
+				}
+			}
+		});
+	}
+
+	void CopyTopLevel(const uint8_t* texels, uint32_t width, uint32_t height, std::vector<MipLevel>& mips)
+	{
+		mips[0].width = width;
+		mips[0].height = height;
+		mips[0].texels.assign(texels, texels + (size_t)width * height * 4);
+	}
+}
+
+uint32_t MipGenerator::GetMipCount(uint32_t width, uint32_t height)
+{
+	uint32_t mipCount = 1;
+
+	while (width > 1 || height > 1)
+	{
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+		++mipCount;
+	}
+
+	return mipCount;
+}
+
+void MipGenerator::GenerateDiffuseOpacityMips(const uint8_t* texels, uint32_t width, uint32_t height, float alphaClipThreshold,
+	std::vector<MipLevel>& mips, std::vector<MipCoverage>* coverage)
+{
+	uint32_t mipCount = GetMipCount(width, height);
+	size_t texelCount = (size_t)width * height;
+
+	mips.clear();
+	mips.resize(mipCount);
+	CopyTopLevel(texels, width, height, mips);
+
+	bool preservesCoverage = (alphaClipThreshold >= 0.0f);
+	double targetCoverage = preservesCoverage ? ComputeCoverage(texels, texelCount, alphaClipThreshold) : 0.0;
+
+	if (coverage != nullptr)
+	{
+		coverage->assign(mipCount, MipCoverage());
+
+		for (MipCoverage& mipCoverage : *coverage)
+			mipCoverage.targetCoverage = targetCoverage;
+
+		(*coverage)[0].filteredCoverage = targetCoverage;
+		(*coverage)[0].coverage = targetCoverage;
+	}
+
+	// Linear color, alpha stays as stored since the clip threshold is in stored units
+	const GammaTable& gammaTable = GetGammaTable();
+	FloatLevel level;
+	level.width = width;
+	level.height = height;
+	level.texels.resize(texelCount * 4);
+
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		level.texels[i * 4 + 0] = gammaTable.toLinear[texels[i * 4 + 0]];
+		level.texels[i * 4 + 1] = gammaTable.toLinear[texels[i * 4 + 1]];
+		level.texels[i * 4 + 2] = gammaTable.toLinear[texels[i * 4 + 2]];
+		level.texels[i * 4 + 3] = texels[i * 4 + 3] / 255.0f;
+	}
+
+	FloatLevel nextLevel;
+	std::vector<float> alpha;
+
+	for (uint32_t mip = 1; mip < mipCount; ++mip)
+	{
+		Downsample(level, nextLevel);
+		std::swap(level, nextLevel);
+
+		size_t levelTexelCount = (size_t)level.width * level.height;
+		float alphaScale = 1.0f;
+
+		// The scale is applied to the output only, the next level is filtered from the unscaled alpha
+		if (preservesCoverage)
+		{
+			alpha.resize(levelTexelCount);
+
+			for (size_t i = 0; i < levelTexelCount; ++i)
+				alpha[i] = level.texels[i * 4 + 3];
+
+			alphaScale = FindAlphaScale(alpha.data(), levelTexelCount, alphaClipThreshold, targetCoverage);
+		}
+
+		MipLevel& mipLevel = mips[mip];
+		mipLevel.width = level.width;
+		mipLevel.height = level.height;
+		mipLevel.texels.resize(levelTexelCount * 4);
+
+		float inverseGamma = 1.0f / DiffuseGamma;
+
+		ThreadPool::ParallelFor(level.height, std::max<size_t>(1, 4096 / level.width), [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin * level.width; i < end * level.width; ++i)
+			{
+				mipLevel.texels[i * 4 + 0] = ToByte(std::pow(level.texels[i * 4 + 0], inverseGamma));
+				mipLevel.texels[i * 4 + 1] = ToByte(std::pow(level.texels[i * 4 + 1], inverseGamma));
+				mipLevel.texels[i * 4 + 2] = ToByte(std::pow(level.texels[i * 4 + 2], inverseGamma));
+				mipLevel.texels[i * 4 + 3] = ToByte(level.texels[i * 4 + 3] * alphaScale);
+			}
+		});
+
+		if (coverage != nullptr && preservesCoverage)
+		{
+			MipCoverage& mipCoverage = (*coverage)[mip];
+			mipCoverage.filteredCoverage = ComputeCoverage(alpha.data(), levelTexelCount, alphaClipThreshold, 1.0f);
+			mipCoverage.coverage = ComputeCoverage(mipLevel.texels.data(), levelTexelCount, alphaClipThreshold);
+			mipCoverage.alphaScale = alphaScale;
+		}
+	}
+}
+
+void MipGenerator::GenerateNormalRoughnessMips(const uint8_t* texels, uint32_t width, uint32_t height, std::vector<MipLevel>& mips)
+{
+	uint32_t mipCount = GetMipCount(width, height);
+	size_t texelCount = (size_t)width * height;
+
+	mips.clear();
+	mips.resize(mipCount);
+	CopyTopLevel(texels, width, height, mips);
+
+	// Unpacked to [-1, 1] like DirectLighting.hlsl does, roughness as it is
+	FloatLevel level;
+	level.width = width;
+	level.height = height;
+	level.texels.resize(texelCount * 4);
+
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		for (int channel = 0; channel < 3; ++channel)
+			level.texels[i * 4 + channel] = texels[i * 4 + channel] / 255.0f * 2.0f - 1.0f;
+
+		level.texels[i * 4 + 3] = texels[i * 4 + 3] / 255.0f;
+	}
+
+	FloatLevel nextLevel;
+
+	for (uint32_t mip = 1; mip < mipCount; ++mip)
+	{
+		// The averages stay unnormalized for the next level so every level is the mean of the texels it covers
+		Downsample(level, nextLevel);
+		std::swap(level, nextLevel);
+
+		MipLevel& mipLevel = mips[mip];
+		mipLevel.width = level.width;
+		mipLevel.height = level.height;
+		mipLevel.texels.resize((size_t)level.width * level.height * 4);
+
+		ThreadPool::ParallelFor(level.height, std::max<size_t>(1, 4096 / level.width), [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin * level.width; i < end * level.width; ++i)
+			{
+				const float* normal = &level.texels[i * 4];
+				float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+				// Opposing normals cancel out, fall back to the surface normal
+				float inverseLength = (length > 1.0e-6f) ? (1.0f / length) : 0.0f;
+				float z = (length > 1.0e-6f) ? normal[2] * inverseLength : 1.0f;
+
+				mipLevel.texels[i * 4 + 0] = ToByte(normal[0] * inverseLength * 0.5f + 0.5f);
+				mipLevel.texels[i * 4 + 1] = ToByte(normal[1] * inverseLength * 0.5f + 0.5f);
+				mipLevel.texels[i * 4 + 2] = ToByte(z * 0.5f + 0.5f);
+				mipLevel.texels[i * 4 + 3] = ToByte(normal[3]);
+			}
+		});
+	}
+}
+
+double MipGenerator::ComputeCoverage(const uint8_t* texels, size_t texelCount, float alphaClipThreshold)
+{
+	if (texelCount == 0)
+		return 0.0;
+
+	size_t coveredCount = 0;
+
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		if (texels[i * 4 + 3] >= alphaClipThreshold * 255.0f)
+			++coveredCount;
+	}
+
+	return (double)coveredCount / texelCount;
+}
+
+double MipGenerator::ComputeCoverage(const float* alpha, size_t texelCount, float alphaClipThreshold, float alphaScale)
+{
+	if (texelCount == 0)
+		return 0.0;
+
+	size_t coveredCount = 0;
+
+	// Counted on the quantized alpha the level is stored with
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		if (ToByte(alpha[i] * alphaScale) >= alphaClipThreshold * 255.0f)
+			++coveredCount;
+	}
+
+	return (double)coveredCount / texelCount;
+}
+
+float MipGenerator::FindAlphaScale(const float* alpha, size_t texelCount, float alphaClipThreshold, double targetCoverage)
+{
+	double coverage = ComputeCoverage(alpha, texelCount, alphaClipThreshold, 1.0f);
+
+	// Leave the alpha alone when it is already as close as this level's resolution allows
+	if (std::fabs(coverage - targetCoverage) * texelCount < 0.5)
+		return 1.0f;
+
+	// Coverage only grows with the scale, bisect between a scale below and one above the target.
+	// A texel with alpha a passes from threshold / a on, so the largest scale covers every texel
+	// down to 1/255.
+	float lowerScale = (coverage > targetCoverage) ? 0.0f : 1.0f;
+	float upperScale = (coverage > targetCoverage) ? 1.0f : alphaClipThreshold * 255.0f;
+
+	for (uint32_t i = 0; i < AlphaScaleIterations; ++i)
+	{
+		float scale = 0.5f * (lowerScale + upperScale);
+
+		if (ComputeCoverage(alpha, texelCount, alphaClipThreshold, scale) < targetCoverage)
+			lowerScale = scale;
+		else
+			upperScale = scale;
+	}
+
+	double lowerError = targetCoverage - ComputeCoverage(alpha, texelCount, alphaClipThreshold, lowerScale);
+	double upperError = ComputeCoverage(alpha, texelCount, alphaClipThreshold, upperScale) - targetCoverage;
+
+	return (lowerError < upperError) ? lowerScale : upperScale;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MipLevel
+{
+	uint32_t				width = 0;
+	uint32_t				height = 0;
+	// Tightly packed RGBA8
+	std::vector<uint8_t>	texels;
+};
+
+// Alpha test coverage of one mip, the fraction of texels that survive the clip
+struct MipCoverage
+{
+	// Coverage of the top mip, what every level is matched to
+	double	targetCoverage = 0.0;
+	// With the plain box filtered alpha
+	double	filteredCoverage = 0.0;
+	// After the alpha has been rescaled
+	double	coverage = 0.0;
+	float	alphaScale = 1.0f;
+};
+
+// CPU mip chain generation for the texture cook step. Every level is a 2x2 box filter of the level
+// above it, the rows of a level are spread over the thread pool. Level 0 is a copy of the input.
+class MipGenerator
+{
+public:
+	MipGenerator() = default;
+	~MipGenerator() = default;
+
+	// Full chain down to 1x1
+	static uint32_t GetMipCount(uint32_t, uint32_t);
+
+	// Diffuse + opacity. Color is filtered in linear space using the same 2.2 power DirectLighting.hlsl
+	// decodes with. With a clip threshold the alpha of every level is scaled so that the same fraction
+	// of texels passes the alpha test as in level 0, otherwise distant foliage thins out and disappears.
+	// Coverage is optional and gets one entry per level.
+	static void GenerateDiffuseOpacityMips(const uint8_t*, uint32_t, uint32_t, float, std::vector<MipLevel>&,
+		std::vector<MipCoverage>* = nullptr);
+
+	// Normal + roughness. Normals are averaged as vectors and renormalized, roughness is averaged.
+	static void GenerateNormalRoughnessMips(const uint8_t*, uint32_t, uint32_t, std::vector<MipLevel>&);
+
+	// Fraction of the RGBA8 texels whose alpha is at least the threshold
+	static double ComputeCoverage(const uint8_t*, size_t, float);
+
+private:
+
+	static double ComputeCoverage(const float*, size_t, float, float);
+	static float FindAlphaScale(const float*, size_t, float, double);
+};
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Fixed size slots for objects that are created and destroyed individually but whose storage should
+// be reused instead of going back to the heap, e.g. textures that are replaced on every scene load.
+// Slots are handed out from a free list and never move, so returned pointers stay valid until Destroy().
+template<typename T, size_t ChunkSize = 64>
+class ObjectPool
+{
+public:
+	ObjectPool() = default;
+
+	~ObjectPool()
+	{
+		Clear();
+	}
+
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	template<typename... Args>
+	T* Create(Args&&... args)
+	{
+		if (mFreeList == nullptr)
+			AddChunk();
+
+		Slot* slot = mFreeList;
+		T* object = new (&slot->storage) T(std::forward<Args>(args)...);
+
+		mFreeList = slot->next;
+		slot->isLive = true;
+		++mLiveCount;
+
+		return object;
+	}
+
+	void Destroy(T* object)
+	{
+		if (object == nullptr)
+			return;
+
+		// The storage is the first member, so the object address is also the slot address
+		Slot* slot = reinterpret_cast<Slot*>(object);
+
+		object->~T();
+
+		slot->isLive = false;
+		slot->next = mFreeList;
+		mFreeList = slot;
+		--mLiveCount;
+	}
+
+	// Destroys every live object and returns the chunks to the heap
+	void Clear()
+	{
+		for (auto& chunk : mChunks)
+		{
+			for (size_t i = 0; i < ChunkSize; ++i)
+			{
+				if (chunk[i].isLive)
+					reinterpret_cast<T*>(&chunk[i].storage)->~T();
+			}
+		}
+
+		mChunks.clear();
+		mFreeList = nullptr;
+		mLiveCount = 0;
+	}
+
+	size_t GetLiveCount() const
+	{
+		return mLiveCount;
+	}
+
+	size_t GetCapacity() const
+	{
+		return mChunks.size() * ChunkSize;
+	}
+
+private:
+
+	struct Slot
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+		Slot* next;
+		bool isLive;
+	};
+
+	void AddChunk()
+	{
+		std::unique_ptr<Slot[]> chunk(new Slot[ChunkSize]);
+
+		for (size_t i = 0; i < ChunkSize; ++i)
+		{
+			chunk[i].next = (i + 1 < ChunkSize) ? &chunk[i + 1] : mFreeList;
+			chunk[i].isLive = false;
+		}
+
+		mFreeList = &chunk[0];
+		mChunks.push_back(std::move(chunk));
+	}
+
+	std::vector<std::unique_ptr<Slot[]>> mChunks;
+	Slot* mFreeList = nullptr;
+	size_t mLiveCount = 0;
+};
\ No newline at end of file
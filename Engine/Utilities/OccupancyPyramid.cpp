@@ -0,0 +1,145 @@
+#include "OccupancyPyramid.h"
+
+namespace
+{
+	size_t GetBitIndex(uint32_t resolution, uint32_t x, uint32_t y, uint32_t z)
+	{
+		return ((size_t)z * resolution + y) * resolution + x;
+	}
+
+	// Calls the function with the coordinates of every set bit of a level
+	template <typename Function>
+	void ForEachSetBit(const std::vector<uint64_t>& words, uint32_t resolution, Function function)
+	{
+		for (size_t word = 0; word < words.size(); ++word)
+		{
+			uint64_t bits = words[word];
+
+			while (bits != 0)
+			{
+				uint32_t bit = 0;
+
+				while ((bits & (1ull << bit)) == 0)
+					++bit;
+
+				bits &= bits - 1;
+
+				const size_t index = word * 64 + bit;
+				function((uint32_t)(index % resolution), (uint32_t)(index / resolution % resolution), (uint32_t)(index / ((size_t)resolution * resolution)));
+			}
+		}
+	}
+}
+
+uint32_t OccupancyPyramid::Build(const VoxelGrid* grids, uint32_t mipCount)
+{
+	mMips.resize(mipCount);
+	uint32_t occupiedVoxels = 0;
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		const uint32_t resolution = grids[mip].GetResolution();
+		Mip& bits = mMips[mip];
+		bits.voxels = MakeLevel(resolution);
+		bits.footprintLevels.clear();
+
+		const uint32_t* texels = grids[mip].GetTexels();
+
+		for (size_t i = 0; i < grids[mip].GetTexelCount(); ++i)
+		{
+			if (texels[i] != 0)
+			{
+				bits.voxels.words[i / 64] |= 1ull << (i % 64);
+				occupiedVoxels += mip == 0 ? 1 : 0;
+			}
+		}
+
+		// An occupied voxel is in the footprints of itself and the voxels before it on every axis
+		Level footprints = MakeLevel(resolution);
+
+		ForEachSetBit(bits.voxels.words, resolution, [&footprints, resolution](uint32_t x, uint32_t y, uint32_t z)
+		{
+			const uint32_t coordinates[3][2] = { { x, x > 0 ? x - 1 : resolution - 1 }, { y, y > 0 ? y - 1 : resolution - 1 },
+				{ z, z > 0 ? z - 1 : resolution - 1 } };
+
+			for (uint32_t corner = 0; corner < 8; ++corner)
+				Set(footprints, coordinates[0][corner & 1], coordinates[1][(corner >> 1) & 1], coordinates[2][corner >> 2]);
+		});
+
+		bits.footprintLevels.push_back(std::move(footprints));
+
+		// Down to a single bit for the whole mip
+		while (bits.footprintLevels.back().resolution > 1)
+		{
+			const Level& finer = bits.footprintLevels.back();
+			Level coarser = MakeLevel((finer.resolution + 1) / 2);
+
+			ForEachSetBit(finer.words, finer.resolution, [&coarser](uint32_t x, uint32_t y, uint32_t z)
+			{
+				Set(coarser, x / 2, y / 2, z / 2);
+			});
+
+			bits.footprintLevels.push_back(std::move(coarser));
+		}
+	}
+
+	return occupiedVoxels;
+}
+
+size_t OccupancyPyramid::GetMemorySize() const
+{
+	size_t size = 0;
+
+	for (const Mip& bits : mMips)
+	{
+		size += bits.voxels.words.size() * sizeof(uint64_t);
+
+		for (const Level& level : bits.footprintLevels)
+			size += level.words.size() * sizeof(uint64_t);
+	}
+
+	return size;
+}
+
+bool OccupancyPyramid::IsOccupied(uint32_t mip, uint32_t x, uint32_t y, uint32_t z) const
+{
+	return IsSet(mMips[mip].voxels, x, y, z);
+}
+
+bool OccupancyPyramid::FindEmptyBlock(uint32_t mip, uint32_t x, uint32_t y, uint32_t z, uint32_t& emptyLevel) const
+{
+	const std::vector<Level>& levels = mMips[mip].footprintLevels;
+
+	// An empty block has empty blocks inside, so the search goes from the top down
+	for (uint32_t level = (uint32_t)levels.size(); level > 0; --level)
+	{
+		if (!IsSet(levels[level - 1], x >> (level - 1), y >> (level - 1), z >> (level - 1)))
+		{
+			emptyLevel = level - 1;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void OccupancyPyramid::Set(Level& level, uint32_t x, uint32_t y, uint32_t z)
+{
+	const size_t index = GetBitIndex(level.resolution, x, y, z);
+	level.words[index / 64] |= 1ull << (index % 64);
+}
+
+bool OccupancyPyramid::IsSet(const Level& level, uint32_t x, uint32_t y, uint32_t z)
+{
+	const size_t index = GetBitIndex(level.resolution, x, y, z);
+	return (level.words[index / 64] & (1ull << (index % 64))) != 0;
+}
+
+OccupancyPyramid::Level OccupancyPyramid::MakeLevel(uint32_t resolution)
+{
+	Level level;
+	level.resolution = resolution;
+	level.words.assign(((size_t)resolution * resolution * resolution + 63) / 64, 0);
+
+	return level;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "VoxelGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bitmasks of where the voxel mips are empty, so the cone tracing can leap over empty space without
+// reading texels. Per mip there is a bit per voxel, set when its texel is anything but zero, and a
+// pyramid over the trilinear sample footprints: a footprint is the eight texels from a voxel to the
+// next one on every axis, wrapping, and a sample whose footprint is empty is exactly zero. Level 0
+// has a bit per footprint, and every coarser level a bit per block of 2, 4, 8 ... of them, set when
+// any footprint of the block touches an occupied texel.
+//
+// Built from the mips after injection or voxelization, about a fifteenth of the texels' memory.
+class OccupancyPyramid
+{
+public:
+	OccupancyPyramid() = default;
+	~OccupancyPyramid() = default;
+
+	// Voxel mips and their count. Returns the occupied voxels of the finest one.
+	uint32_t Build(const VoxelGrid*, uint32_t);
+
+	uint32_t GetMipCount() const { return (uint32_t)mMips.size(); }
+	uint32_t GetLevelCount(uint32_t mip) const { return (uint32_t)mMips[mip].footprintLevels.size(); }
+	uint32_t GetResolution(uint32_t mip, uint32_t level) const { return mMips[mip].footprintLevels[level].resolution; }
+	size_t GetMemorySize() const;
+
+	bool IsOccupied(uint32_t, uint32_t, uint32_t, uint32_t) const;
+	// No texel of the mip is occupied
+	bool IsEmpty(uint32_t mip) const { return !IsSet(mMips[mip].footprintLevels.back(), 0, 0, 0); }
+
+	// The footprint from a voxel of a mip
+	bool IsFootprintEmpty(uint32_t mip, uint32_t x, uint32_t y, uint32_t z) const { return !IsSet(mMips[mip].footprintLevels[0], x, y, z); }
+	// Coarsest level whose block around a voxel's footprint has only empty footprints. Returns false
+	// if the footprint itself isn't empty.
+	bool FindEmptyBlock(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t&) const;
+
+private:
+
+	struct Level
+	{
+		uint32_t resolution = 0;
+		// x fastest, then y, then z, 64 bits to a word
+		std::vector<uint64_t> words;
+	};
+
+	struct Mip
+	{
+		Level voxels;
+		std::vector<Level> footprintLevels;
+	};
+
+	static void Set(Level&, uint32_t, uint32_t, uint32_t);
+	static bool IsSet(const Level&, uint32_t, uint32_t, uint32_t);
+	static Level MakeLevel(uint32_t);
+
+	std::vector<Mip> mMips;
+};
\ No newline at end of file
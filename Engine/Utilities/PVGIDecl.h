@@ -62,9 +62,6 @@ UINT cbvSrvUavDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D1
 																													\
 commandList->SetPipelineState(mPSO.Get());																			\
 																													\
-ID3D12DescriptorHeap* descriptorHeaps[] = { mSrvDescriptorHeap.Get() };												\
-commandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);										\
-																													\
 for (int i = 0; i < NUM_OF_UAV; ++i)																				\
 {																													\
 	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mOutputBuffers[i].Get(),					\
@@ -75,7 +72,7 @@ commandList->SetComputeRootSignature(mRootSignature.Get());															\
 																													\
 commandList->SetComputeRootConstantBufferView(0, passCB->GetGPUVirtualAddress());									\
 																													\
-CD3DX12_GPU_DESCRIPTOR_HANDLE tex(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());						\
+CD3DX12_GPU_DESCRIPTOR_HANDLE tex(GlobalDescriptorHeap::GetGpuHandle(mSrvDescriptors));							\
 																													\
 commandList->SetComputeRootDescriptorTable(1, tex);																	\
 																													\
@@ -107,23 +104,22 @@ texDesc.Height = HEIGHT;										\
 texDesc.DepthOrArraySize = DEPTH;								
 														
 
-#define CREATE_OUTPUT_BUFFER_RESOURCE(CLEAR_VAL_PTR)			\
+#define CREATE_OUTPUT_BUFFER_RESOURCE(CLEAR_VAL_PTR, MEMORY_CATEGORY)	\
+{																\
 	ThrowIfFailed(md3dDevice->CreateCommittedResource(			\
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),		\
 		D3D12_HEAP_FLAG_NONE,									\
 		&texDesc,												\
 		D3D12_RESOURCE_STATE_GENERIC_READ,						\
 		CLEAR_VAL_PTR,											\
-		IID_PPV_ARGS(&mOutputBuffers[i])));
+		IID_PPV_ARGS(&mOutputBuffers[i])));						\
+	d3dUtil::TrackResource(md3dDevice.Get(), mOutputBuffers[i].Get(), MEMORY_CATEGORY);	\
+}
 
 
-#define CREATE_SRV_UAV_HEAP(SIZE)								\
+#define ALLOCATE_SRV_UAV_DESCRIPTORS(SIZE)						\
 																\
-D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};					\
-srvHeapDesc.NumDescriptors = SIZE;								\
-srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;		\
-srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;	\
-ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvDescriptorHeap)));
+mSrvDescriptors = GlobalDescriptorHeap::Allocate(SIZE);
 
 
 #define CREATE_UAV_DESC(FORMAT, DIMENSION, DEPTH)							\
@@ -0,0 +1,92 @@
+#include "PackedVoxelGrid.h"
+
+void PackedVoxelGrid::Reset(uint32_t resolution)
+{
+	const size_t texelCount = (size_t)resolution * resolution * resolution;
+
+	if (texelCount != mTexelCount)
+	{
+		mTexels.reset(new std::atomic<uint32_t>[texelCount]);
+		mTexelCount = texelCount;
+	}
+
+	mResolution = resolution;
+
+	for (size_t i = 0; i < mTexelCount; ++i)
+		mTexels[i].store(0, std::memory_order_relaxed);
+}
+
+uint32_t PackedVoxelGrid::Max(size_t index, uint32_t value, uint32_t& lostExchanges)
+{
+	std::atomic<uint32_t>& texel = mTexels[index];
+	uint32_t previous = texel.load(std::memory_order_relaxed);
+
+	// C++14 has no fetch_max, a failed exchange means another thread wrote in between and the loaded
+	// value is tried against again
+	while (previous < value && !texel.compare_exchange_strong(previous, value, std::memory_order_relaxed))
+		++lostExchanges;
+
+	return previous;
+}
+
+void PackedVoxelGrid::Resolve(VoxelGrid& grid) const
+{
+	if (grid.GetResolution() != mResolution)
+		grid.Reset(mResolution);
+
+	uint32_t* texels = grid.GetTexels();
+
+	for (size_t i = 0; i < mTexelCount; ++i)
+		texels[i] = ToTexel(Load(i));
+}
+
+void PackedVoxelGrid::Pack(const VoxelGrid& grid)
+{
+	Reset(grid.GetResolution());
+
+	const uint32_t* texels = grid.GetTexels();
+
+	for (size_t i = 0; i < mTexelCount; ++i)
+		mTexels[i].store(FromTexel(texels[i]), std::memory_order_relaxed);
+}
+
+void PackedVoxelGrid::Reseed()
+{
+	for (size_t i = 0; i < mTexelCount; ++i)
+	{
+		const uint32_t texel = Load(i);
+
+		// The smallest inverted depth of an occupied texel, it resolves to an alpha of 1 as a seed does
+		if (texel != 0)
+			mTexels[i].store((1u << 20) | (texel & 0xFFFFF), std::memory_order_relaxed);
+	}
+}
+
+uint32_t PackedVoxelGrid::FromTexel(uint32_t texel)
+{
+	const uint32_t alpha = texel >> 24;
+
+	if (alpha == 0)
+		return 0;
+
+	// Alphas below a half aren't resolved from an injection, they are taken as the nearest depth
+	const uint32_t depth12 = (std::max(alpha, 128u) - 128) << 5;
+
+	return ((4095 - depth12) << 20) | (((texel >> 18) & 0x3F) << 14) | (((texel >> 9) & 0x7F) << 7) | ((texel >> 1) & 0x7F);
+}
+
+uint32_t PackedVoxelGrid::ToTexel(uint32_t packed)
+{
+	const uint32_t invertedDepth = packed >> 20;
+
+	if (invertedDepth == 0)
+		return 0;
+
+	// The low bits of a channel repeat its high bits, so white stays white
+	const uint32_t red = packed & 0x7F;
+	const uint32_t green = (packed >> 7) & 0x7F;
+	const uint32_t blue = (packed >> 14) & 0x3F;
+	const uint32_t alpha = 128 + ((4095 - invertedDepth) >> 5);
+
+	return ((red << 1) | (red >> 6)) | (((green << 1) | (green >> 6)) << 8) | (((blue << 2) | (blue >> 4)) << 16) | (alpha << 24);
+}
\ No newline at end of file
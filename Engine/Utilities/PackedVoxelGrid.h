@@ -0,0 +1,69 @@
+#pragma once
+
+#include "VoxelGrid.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// CPU copy of the R32_UINT 3D texture VoxelInjection.hlsl injects into with InterlockedMax. A texel
+// keeps the pixel's view depth over the far plane in 12 bits, inverted in the high bits so that nearer
+// is larger, and its color in 7, 7 and 6 bits of red, green and blue below. Zero is an empty voxel.
+// The maximum of all pixels written into a voxel is the nearest one, ties going to the larger color,
+// whatever the order they arrive in, so a single atomic max replaces the shader's read, test and write.
+// That only holds for the pixels of one injection. The grid is kept across frames and only ever rises,
+// a later frame can't lower a texel, Reseed() lets it when the light or the scene changed.
+//
+// Resolving to the RGBA8 grid maps the depth to an alpha in [0.5..1], farther is larger. Every
+// occupied voxel passes the cone tracer's test, and the seeds, stored at an alpha of 1, are the
+// farthest. Packing a resolved texel and resolving it again gives it back.
+class PackedVoxelGrid
+{
+public:
+	PackedVoxelGrid() = default;
+	~PackedVoxelGrid() = default;
+
+	// Resizes to the given resolution and empties every texel
+	void Reset(uint32_t);
+
+	uint32_t GetResolution() const { return mResolution; }
+	size_t GetTexelCount() const { return mTexelCount; }
+
+	// Raises a texel to the value if that is larger, returns the texel before. Adds the compare
+	// exchanges lost to other threads writing the same texel to the last argument.
+	uint32_t Max(size_t, uint32_t, uint32_t&);
+	uint32_t Load(size_t index) const { return mTexels[index].load(std::memory_order_relaxed); }
+
+	// To and from the RGBA8 grid the passes after injection read, the resolve pass of the GPU and
+	// the packing of the seeded or restored grid before the first injection
+	void Resolve(VoxelGrid&) const;
+	void Pack(const VoxelGrid&);
+	// Moves every occupied texel to the far plane, keeping its color, so any pixel nearer than that
+	// replaces it. The grid only ever rises, the injection does this first when the light or the scene
+	// changed, otherwise a voxel lit darker at the same depth, or seen farther, keeps its old color.
+	void Reseed();
+
+	// A pixel's color and view depth over the far plane
+	static uint32_t Encode(float red, float green, float blue, float depth)
+	{
+		return ((4095 - ToUnorm(depth, 4094.0f)) << 20) | (ToUnorm(blue, 63.0f) << 14) | (ToUnorm(green, 127.0f) << 7) | ToUnorm(red, 127.0f);
+	}
+
+	static uint32_t FromTexel(uint32_t);
+	static uint32_t ToTexel(uint32_t);
+
+private:
+
+	// Saturated and rounded to the given maximum, NaN becomes zero. Without branches, the injection
+	// encodes every pixel.
+	static uint32_t ToUnorm(float value, float maxValue)
+	{
+		return (uint32_t)(std::min(1.0f, std::max(0.0f, value)) * maxValue + 0.5f);
+	}
+
+	std::unique_ptr<std::atomic<uint32_t>[]> mTexels;
+	size_t mTexelCount = 0;
+	uint32_t mResolution = 0;
+};
\ No newline at end of file
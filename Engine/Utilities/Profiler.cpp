@@ -0,0 +1,289 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+
+std::atomic<bool> Profiler::sEnabled = { false };
+
+std::mutex Profiler::mRegistryMutex;
+std::vector<std::unique_ptr<ProfileThreadBuffer>> Profiler::mBuffers;
+ProfileThreadBuffer* Profiler::mGpuBuffer = nullptr;
+
+namespace
+{
+	thread_local ProfileThreadBuffer* tlsThreadBuffer = nullptr;
+
+	// Escapes the characters that would break a JSON string literal
+	std::string EscapeJSON(const char* input)
+	{
+		std::string result;
+
+		for (const char* c = input; *c != '\0'; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				result.push_back('\\');
+			result.push_back(*c);
+		}
+
+		return result;
+	}
+}
+
+void Profiler::SetEnabled(bool input)
+{
+#if defined(PVGI_PROFILING)
+	sEnabled.store(input, std::memory_order_relaxed);
+#else
+	(void)input;
+#endif
+}
+
+uint64_t Profiler::Now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::SetThreadName(const std::string& threadName)
+{
+	ProfileThreadBuffer* buffer = GetThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(mRegistryMutex);
+	buffer->trackName = threadName;
+}
+
+uint64_t Profiler::BeginEvent()
+{
+	++GetThreadBuffer()->depth;
+	return Now();
+}
+
+void Profiler::EndEvent(const char* name, uint64_t startTime)
+{
+	uint64_t endTime = Now();
+
+	ProfileThreadBuffer* buffer = GetThreadBuffer();
+	--buffer->depth;
+
+	PushEvent(buffer, name, startTime, endTime, buffer->depth);
+}
+
+void Profiler::RecordGpuEvent(const char* name, uint64_t startTime, uint64_t endTime, uint32_t depth)
+{
+	if (!IsEnabled())
+		return;
+
+	if (mGpuBuffer == nullptr)
+		mGpuBuffer = RegisterBuffer("GPU");
+
+	PushEvent(mGpuBuffer, name, startTime, endTime, depth);
+}
+
+void Profiler::Reset()
+{
+	std::lock_guard<std::mutex> lock(mRegistryMutex);
+
+	for (auto& buffer : mBuffers)
+		buffer->head.store(0, std::memory_order_release);
+}
+
+ProfileThreadBuffer* Profiler::GetThreadBuffer()
+{
+	if (tlsThreadBuffer == nullptr)
+		tlsThreadBuffer = RegisterBuffer("");
+
+	return tlsThreadBuffer;
+}
+
+ProfileThreadBuffer* Profiler::RegisterBuffer(const std::string& trackName)
+{
+	auto buffer = std::make_unique<ProfileThreadBuffer>();
+
+	std::lock_guard<std::mutex> lock(mRegistryMutex);
+
+	buffer->trackId = (uint32_t)mBuffers.size();
+	buffer->trackName = trackName.empty() ? ("Thread " + std::to_string(buffer->trackId)) : trackName;
+
+	mBuffers.push_back(std::move(buffer));
+
+	return mBuffers.back().get();
+}
+
+void Profiler::PushEvent(ProfileThreadBuffer* buffer, const char* name, uint64_t startTime, uint64_t endTime, uint32_t depth)
+{
+	// Only the owning thread writes the head, so a relaxed load is enough here. The release stores
+	// publish the event to the exporter.
+	uint64_t index = buffer->head.load(std::memory_order_relaxed);
+	uint64_t slot = index & (ProfileThreadBuffer::Capacity - 1);
+
+	buffer->sequences[slot].store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	ProfileEvent& profileEvent = buffer->events[slot];
+	profileEvent.name = name;
+	profileEvent.startTime = startTime;
+	profileEvent.endTime = endTime;
+	profileEvent.depth = depth;
+
+	buffer->sequences[slot].store(index * 2 + 2, std::memory_order_release);
+	buffer->head.store(index + 1, std::memory_order_release);
+}
+
+std::vector<ProfileEvent> Profiler::CopyEvents(const ProfileThreadBuffer* buffer)
+{
+	std::vector<ProfileEvent> result;
+
+	uint64_t head = buffer->head.load(std::memory_order_acquire);
+	uint64_t first = (head > ProfileThreadBuffer::Capacity) ? (head - ProfileThreadBuffer::Capacity) : 0;
+
+	result.reserve((size_t)(head - first));
+
+	// The owner may keep writing while we copy. A slot it started overwriting before or during the
+	// copy has another sequence than the event's, and is dropped.
+	for (uint64_t i = first; i < head; ++i)
+	{
+		const uint64_t slot = i & (ProfileThreadBuffer::Capacity - 1);
+		const uint64_t sequence = buffer->sequences[slot].load(std::memory_order_acquire);
+
+		if (sequence != i * 2 + 2)
+			continue;
+
+		ProfileEvent profileEvent = buffer->events[slot];
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (buffer->sequences[slot].load(std::memory_order_relaxed) == sequence)
+			result.push_back(profileEvent);
+	}
+
+	return result;
+}
+
+bool Profiler::ExportChromeTrace(const std::string& filePath)
+{
+	std::ofstream outputFile(filePath, std::fstream::out | std::fstream::trunc);
+
+	if (!outputFile.is_open())
+		return false;
+
+	std::lock_guard<std::mutex> lock(mRegistryMutex);
+
+	uint64_t baseTime = UINT64_MAX;
+
+	std::vector<std::vector<ProfileEvent>> trackEvents;
+
+	for (auto& buffer : mBuffers)
+	{
+		trackEvents.push_back(CopyEvents(buffer.get()));
+
+		for (auto& profileEvent : trackEvents.back())
+			baseTime = std::min(baseTime, profileEvent.startTime);
+	}
+
+	outputFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool isFirstEvent = true;
+
+	for (size_t i = 0; i < mBuffers.size(); ++i)
+	{
+		outputFile << (isFirstEvent ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+			<< mBuffers[i]->trackId << ",\"args\":{\"name\":\"" << EscapeJSON(mBuffers[i]->trackName.c_str()) << "\"}}";
+
+		isFirstEvent = false;
+
+		const char* category = (mBuffers[i].get() == mGpuBuffer) ? "GPU" : "CPU";
+
+		for (auto& profileEvent : trackEvents[i])
+		{
+			// Chrome expects microseconds
+			outputFile << ",\n{\"name\":\"" << EscapeJSON(profileEvent.name) << "\",\"cat\":\"" << category
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << mBuffers[i]->trackId
+				<< ",\"ts\":" << ((profileEvent.startTime - baseTime) / 1000.0)
+				<< ",\"dur\":" << ((profileEvent.endTime - profileEvent.startTime) / 1000.0)
+				<< ",\"args\":{\"depth\":" << profileEvent.depth << "}}";
+		}
+	}
+
+	outputFile << "\n]}\n";
+	outputFile.close();
+
+	return true;
+}
+
+bool Profiler::ExportCSVSummary(const std::string& filePath)
+{
+	struct MarkerSummary
+	{
+		uint64_t count = 0;
+		uint64_t totalTime = 0;
+		uint64_t selfTime = 0;
+		uint64_t minTime = UINT64_MAX;
+		uint64_t maxTime = 0;
+	};
+
+	std::ofstream outputFile(filePath, std::fstream::out | std::fstream::trunc);
+
+	if (!outputFile.is_open())
+		return false;
+
+	std::lock_guard<std::mutex> lock(mRegistryMutex);
+
+	// Keyed by track category and marker name so CPU and GPU times of the same pass stay apart
+	std::map<std::pair<std::string, std::string>, MarkerSummary> summaries;
+
+	for (auto& buffer : mBuffers)
+	{
+		std::vector<ProfileEvent> events = CopyEvents(buffer.get());
+
+		std::string category = (buffer.get() == mGpuBuffer) ? "GPU" : "CPU";
+
+		// Parents close after their children, sort by start time so a stack can attribute child time
+		std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b)
+		{
+			return (a.startTime != b.startTime) ? (a.startTime < b.startTime) : (a.depth < b.depth);
+		});
+
+		std::vector<uint64_t> childTime(events.size(), 0);
+		std::vector<size_t> openEvents;
+
+		for (size_t i = 0; i < events.size(); ++i)
+		{
+			while (!openEvents.empty() && events[openEvents.back()].endTime <= events[i].startTime)
+				openEvents.pop_back();
+
+			if (!openEvents.empty())
+				childTime[openEvents.back()] += (events[i].endTime - events[i].startTime);
+
+			openEvents.push_back(i);
+		}
+
+		for (size_t i = 0; i < events.size(); ++i)
+		{
+			uint64_t duration = events[i].endTime - events[i].startTime;
+
+			MarkerSummary& summary = summaries[std::make_pair(category, std::string(events[i].name))];
+			summary.count++;
+			summary.totalTime += duration;
+			summary.selfTime += (duration > childTime[i]) ? (duration - childTime[i]) : 0;
+			summary.minTime = std::min(summary.minTime, duration);
+			summary.maxTime = std::max(summary.maxTime, duration);
+		}
+	}
+
+	outputFile << "track,name,count,total_ms,self_ms,mean_ms,min_ms,max_ms\n";
+
+	for (auto& entry : summaries)
+	{
+		const MarkerSummary& summary = entry.second;
+
+		outputFile << entry.first.first << ",\"" << entry.first.second << "\"," << summary.count << ","
+			<< (summary.totalTime / 1.0e6) << "," << (summary.selfTime / 1.0e6) << ","
+			<< (summary.totalTime / 1.0e6 / summary.count) << ","
+			<< (summary.minTime / 1.0e6) << "," << (summary.maxTime / 1.0e6) << "\n";
+	}
+
+	outputFile.close();
+
+	return true;
+}
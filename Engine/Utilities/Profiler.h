@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILER_CONCAT_INNER(A, B) A##B
+#define PROFILER_CONCAT(A, B) PROFILER_CONCAT_INNER(A, B)
+
+// Times the enclosing scope. NAME must be a string literal (or otherwise outlive the profiler) because
+// only the pointer is recorded. Builds without PVGI_PROFILING compile the scopes out and never record.
+// With it, a scope costs a flag load and a branch on entry and exit while recording is switched off.
+#if defined(PVGI_PROFILING)
+#define PROFILE_SCOPE(NAME) ProfileScope PROFILER_CONCAT(profileScope, __LINE__)(NAME)
+#else
+#define PROFILE_SCOPE(NAME)
+#endif
+
+// A single timed region. Times are in nanoseconds on the profiler clock (see Profiler::Now).
+struct ProfileEvent
+{
+	const char* name = nullptr;
+	uint64_t startTime = 0;
+	uint64_t endTime = 0;
+	uint32_t depth = 0;
+};
+
+// Fixed size ring of events written by exactly one thread and read by the exporter. The writer never
+// blocks; once the ring is full the oldest events are overwritten.
+struct ProfileThreadBuffer
+{
+	static const uint64_t Capacity = 1 << 14;
+
+	ProfileEvent events[Capacity];
+	// Per slot, odd while the event with index (sequence - 1) / 2 is written and even once it is. The
+	// exporter skips the slots whose sequence isn't that of the event it expects, or changed while it
+	// copied.
+	std::atomic<uint64_t> sequences[Capacity] = {};
+
+	// Total number of events ever written, only modified by the owning thread.
+	std::atomic<uint64_t> head = { 0 };
+
+	// Nesting depth of the currently open scopes on the owning thread.
+	uint32_t depth = 0;
+
+	uint32_t trackId = 0;
+	std::string trackName;
+};
+
+class Profiler
+{
+public:
+	Profiler() = default;
+	~Profiler() = default;
+
+	static bool IsEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+	static void SetEnabled(bool);
+
+	// Current time in nanoseconds on a monotonic clock.
+	static uint64_t Now();
+
+	// Names the calling thread's track in the exported trace.
+	static void SetThreadName(const std::string&);
+
+	// Used by ProfileScope, opens a nested scope on the calling thread and returns its start time.
+	static uint64_t BeginEvent();
+	static void EndEvent(const char*, uint64_t);
+
+	// Records a region measured by the GPU, already converted to the profiler clock.
+	static void RecordGpuEvent(const char*, uint64_t, uint64_t, uint32_t);
+
+	// Drops every recorded event while keeping the thread registrations. Only call this while no
+	// other thread is recording.
+	static void Reset();
+
+	// Chrome trace event format, load through chrome://tracing or ui.perfetto.dev.
+	static bool ExportChromeTrace(const std::string&);
+
+	// Per marker totals with inclusive and exclusive (self) times.
+	static bool ExportCSVSummary(const std::string&);
+
+private:
+
+	static ProfileThreadBuffer* GetThreadBuffer();
+	static ProfileThreadBuffer* RegisterBuffer(const std::string&);
+	static void PushEvent(ProfileThreadBuffer*, const char*, uint64_t, uint64_t, uint32_t);
+	static std::vector<ProfileEvent> CopyEvents(const ProfileThreadBuffer*);
+
+	static std::atomic<bool> sEnabled;
+
+	static std::mutex mRegistryMutex;
+	static std::vector<std::unique_ptr<ProfileThreadBuffer>> mBuffers;
+	static ProfileThreadBuffer* mGpuBuffer;
+};
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+	{
+		if (Profiler::IsEnabled())
+		{
+			mName = name;
+			mStartTime = Profiler::BeginEvent();
+		}
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+	~ProfileScope()
+	{
+		if (mName != nullptr)
+			Profiler::EndEvent(mName, mStartTime);
+	}
+
+private:
+	const char* mName = nullptr;
+	uint64_t mStartTime = 0;
+};
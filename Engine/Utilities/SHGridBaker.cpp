@@ -0,0 +1,632 @@
+#include "SHGridBaker.h"
+#include "SphericalHarmonics.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+	// The defines of ConeTracingUtil.hlsl
+	const uint32_t InitialIterations = 2;
+	const uint32_t FirstMipIterations = 2;
+	const float OccupiedAlpha = 0.05f;
+	const float CoarseOccupiedAlpha = 0.025f;
+	const float InversePi = 0.31830988618f;
+
+	// Cones traced in parallel by one job
+	const size_t ConesPerJob = 64;
+
+	// The alpha at which a sample of a mip stops a cone. The coarser mips keep the fraction of occupied
+	// voxels below, at least 1/8 when anything is there.
+	float GetOccupiedAlpha(uint32_t mip)
+	{
+		return mip == 0 ? OccupiedAlpha : CoarseOccupiedAlpha;
+	}
+
+	void Normalize(float* vector)
+	{
+		const float inverseLength = 1.0f / std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			vector[axis] *= inverseLength;
+	}
+
+	void Cross(const float* a, const float* b, float* result)
+	{
+		result[0] = a[1] * b[2] - a[2] * b[1];
+		result[1] = a[2] * b[0] - a[0] * b[2];
+		result[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	// Built the way the shader builds them, including its implicit conversions
+	struct ConeDirections
+	{
+		float values[SHGridBaker::ConeCount][3];
+
+		ConeDirections()
+		{
+			const float worldNormal[3] = { 0.0f, 1.0f, 0.0f };
+			const float randomVector[3] = { 0.267261f, 0.534522f, 0.801784f };
+
+			float direction1[3];
+			float direction3[3];
+			Cross(worldNormal, randomVector, direction1);
+			Normalize(direction1);
+			Cross(worldNormal, direction1, direction3);
+			Normalize(direction3);
+
+			// The shader stores these products in floats, which keeps their x component
+			float direction1LerpValue = direction1[0] * 0.3333f;
+			const float direction3LerpValue = direction3[0] * 0.6667f;
+
+			// normalize() of a float is its sign, which then fills all three components
+			const float direction5 = direction3LerpValue + direction1LerpValue >= 0.0f ? 1.0f : -1.0f;
+			const float direction7 = direction3LerpValue - direction1LerpValue >= 0.0f ? 1.0f : -1.0f;
+
+			direction1LerpValue = direction1[0] * 0.6667f;
+			const float offsets[6] = { direction1LerpValue, -direction1LerpValue, direction5 * 0.6667f, -direction5 * 0.6667f,
+				direction7 * 0.6667f, -direction7 * 0.6667f };
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+				values[0][axis] = worldNormal[axis];
+
+			for (uint32_t cone = 1; cone < 7; ++cone)
+			{
+				for (uint32_t axis = 0; axis < 3; ++axis)
+					values[cone][axis] = worldNormal[axis] * 0.3333f + offsets[cone - 1];
+
+				Normalize(values[cone]);
+			}
+
+			for (uint32_t cone = 0; cone < 7; ++cone)
+			{
+				for (uint32_t axis = 0; axis < 3; ++axis)
+					values[cone + 7][axis] = -values[cone][axis];
+			}
+		}
+	};
+
+	uint32_t WrapCoordinate(int32_t coordinate, uint32_t resolution)
+	{
+		if ((uint32_t)coordinate < resolution)
+			return (uint32_t)coordinate;
+
+		const int32_t wrapped = coordinate % (int32_t)resolution;
+		return (uint32_t)(wrapped < 0 ? wrapped + (int32_t)resolution : wrapped);
+	}
+
+	// SampleLevel() with gsamLinearWrap at a position normalized to the volume
+	void SampleGrid(const VoxelGrid& grid, const float* position, float* result)
+	{
+		const uint32_t resolution = grid.GetResolution();
+		uint32_t voxels[3][2];
+		float weights[3];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const float coordinate = position[axis] * (float)resolution - 0.5f;
+			const float floorCoordinate = std::floor(coordinate);
+			const int32_t base = (int32_t)floorCoordinate;
+
+			voxels[axis][0] = WrapCoordinate(base, resolution);
+			voxels[axis][1] = WrapCoordinate(base + 1, resolution);
+			weights[axis] = coordinate - floorCoordinate;
+		}
+
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			result[channel] = 0.0f;
+
+		for (uint32_t corner = 0; corner < 8; ++corner)
+		{
+			const uint32_t offsetX = corner & 1;
+			const uint32_t offsetY = (corner >> 1) & 1;
+			const uint32_t offsetZ = corner >> 2;
+
+			const float weight = (offsetX != 0 ? weights[0] : 1.0f - weights[0])
+				* (offsetY != 0 ? weights[1] : 1.0f - weights[1])
+				* (offsetZ != 0 ? weights[2] : 1.0f - weights[2]);
+
+			const uint32_t texel = grid.GetTexels()[grid.GetIndex(voxels[0][offsetX], voxels[1][offsetY], voxels[2][offsetZ])];
+
+			for (uint32_t channel = 0; channel < 4; ++channel)
+				result[channel] += weight * VoxelGrid::Unpack(texel, channel);
+		}
+	}
+
+	// Eight lanes of SampleGrid(), for grids with a power of two resolution
+	AVX2_FUNCTION void SampleGridAvx2(const VoxelGrid& grid, const __m256* position, __m256* result)
+	{
+		const uint32_t resolution = grid.GetResolution();
+		const __m256 resolutionLanes = _mm256_set1_ps((float)resolution);
+		const __m256i wrapMask = _mm256_set1_epi32((int32_t)resolution - 1);
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256 oneLanes = _mm256_set1_ps(1.0f);
+
+		__m256i voxels[3][2];
+		__m256 weights[3][2];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const __m256 coordinate = _mm256_sub_ps(_mm256_mul_ps(position[axis], resolutionLanes), _mm256_set1_ps(0.5f));
+			const __m256 floorCoordinate = _mm256_floor_ps(coordinate);
+			const __m256i base = _mm256_cvttps_epi32(floorCoordinate);
+
+			// Two's complement wraps negative coordinates too
+			voxels[axis][0] = _mm256_and_si256(base, wrapMask);
+			voxels[axis][1] = _mm256_and_si256(_mm256_add_epi32(base, one), wrapMask);
+			weights[axis][1] = _mm256_sub_ps(coordinate, floorCoordinate);
+			weights[axis][0] = _mm256_sub_ps(oneLanes, weights[axis][1]);
+		}
+
+		const __m256i byteMask = _mm256_set1_epi32(0xFF);
+		const __m256 inverse255 = _mm256_set1_ps(1.0f / 255.0f);
+		const __m256i resolutionIntegers = _mm256_set1_epi32((int32_t)resolution);
+		const int32_t* texels = reinterpret_cast<const int32_t*>(grid.GetTexels());
+
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			result[channel] = _mm256_setzero_ps();
+
+		for (uint32_t corner = 0; corner < 8; ++corner)
+		{
+			const uint32_t offsetX = corner & 1;
+			const uint32_t offsetY = (corner >> 1) & 1;
+			const uint32_t offsetZ = corner >> 2;
+
+			const __m256 weight = _mm256_mul_ps(_mm256_mul_ps(weights[0][offsetX], weights[1][offsetY]), weights[2][offsetZ]);
+
+			const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_mullo_epi32(voxels[2][offsetZ], resolutionIntegers),
+				voxels[1][offsetY]), resolutionIntegers), voxels[0][offsetX]);
+			const __m256i texel = _mm256_i32gather_epi32(texels, index, 4);
+
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				const __m256i channelValue = _mm256_and_si256(_mm256_srli_epi32(texel, channel * 8), byteMask);
+				result[channel] = _mm256_add_ps(result[channel], _mm256_mul_ps(weight, _mm256_mul_ps(_mm256_cvtepi32_ps(channelValue), inverse255)));
+			}
+		}
+	}
+
+	// DiffuseConeTrace() for eight cones. A cone keeps sampling while the voxel it found is nearly
+	// empty for its mip, which gives the same color as the shader's early returns.
+	AVX2_FUNCTION void TraceConesAvx2(const SHBakeSettings& settings, const VoxelGrid* grids, const __m256* origin, const __m256* direction, __m256* color)
+	{
+		const __m256 coneStep = _mm256_set1_ps(settings.coneStep);
+		const __m256 worldBoundary = _mm256_set1_ps(settings.worldBoundary);
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+
+		__m256 position[3];
+		__m256 stepOffset[3];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			stepOffset[axis] = _mm256_mul_ps(direction[axis], coneStep);
+			position[axis] = _mm256_add_ps(origin[axis], _mm256_mul_ps(stepOffset[axis], _mm256_set1_ps((float)InitialIterations)));
+		}
+
+		__m256 voxelInfo[4] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+		__m256 searching = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (uint32_t mip = 0; mip < SHGridBaker::MipCount; ++mip)
+		{
+			const uint32_t iterations = FirstMipIterations << mip;
+			const __m256 occupiedAlpha = _mm256_set1_ps(GetOccupiedAlpha(mip));
+
+			for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+			{
+				for (uint32_t axis = 0; axis < 3; ++axis)
+					position[axis] = _mm256_add_ps(position[axis], stepOffset[axis]);
+
+				if (_mm256_movemask_ps(searching) == 0)
+				{
+					for (uint32_t channel = 0; channel < 3; ++channel)
+						color[channel] = voxelInfo[channel];
+
+					return;
+				}
+
+				__m256 voxelPosition[3];
+
+				for (uint32_t axis = 0; axis < 3; ++axis)
+					voxelPosition[axis] = _mm256_mul_ps(_mm256_add_ps(_mm256_div_ps(position[axis], worldBoundary), one), half);
+
+				__m256 sample[4];
+				SampleGridAvx2(grids[mip], voxelPosition, sample);
+
+				for (uint32_t channel = 0; channel < 4; ++channel)
+					voxelInfo[channel] = _mm256_blendv_ps(voxelInfo[channel], sample[channel], searching);
+
+				searching = _mm256_and_ps(searching, _mm256_cmp_ps(voxelInfo[3], occupiedAlpha, _CMP_LT_OQ));
+			}
+		}
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+			color[channel] = voxelInfo[channel];
+	}
+
+	bool IsPowerOfTwo(uint32_t value)
+	{
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+}
+
+const uint32_t SHGridBaker::ConeCount;
+const uint32_t SHGridBaker::MipCount;
+
+uint32_t SHGridBaker::Bake(const SHBakeSettings& settings, const VoxelGrid* grids, VoxelGrid* shGrids)
+{
+	const uint32_t cellCount = settings.gridResolution * settings.gridResolution * settings.gridResolution;
+	std::vector<uint32_t> cells(cellCount);
+
+	for (uint32_t cell = 0; cell < cellCount; ++cell)
+		cells[cell] = cell;
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		if (shGrids[i].GetResolution() != settings.gridResolution)
+			shGrids[i].Reset(settings.gridResolution);
+	}
+
+	BakeCells(settings, grids, cells.data(), cells.size(), shGrids);
+
+	return cellCount;
+}
+
+uint32_t SHGridBaker::BakeSerial(const SHBakeSettings& settings, const VoxelGrid* grids, VoxelGrid* shGrids)
+{
+	const uint32_t cellCount = settings.gridResolution * settings.gridResolution * settings.gridResolution;
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		if (shGrids[i].GetResolution() != settings.gridResolution)
+			shGrids[i].Reset(settings.gridResolution);
+	}
+
+	for (uint32_t cell = 0; cell < cellCount; ++cell)
+	{
+		float colors[ConeCount][3];
+		TraceCellConesScalar(settings, grids, &cell, 0, ConeCount, colors);
+		StoreCell(cell, colors, shGrids);
+	}
+
+	return cellCount;
+}
+
+uint32_t SHGridBaker::Bake(const SHBakeSettings& settings, const VoxelGrid* grids, const OccupancyPyramid& pyramid, VoxelGrid* shGrids)
+{
+	const uint32_t cellCount = settings.gridResolution * settings.gridResolution * settings.gridResolution;
+	std::vector<uint32_t> cells(cellCount);
+
+	for (uint32_t cell = 0; cell < cellCount; ++cell)
+		cells[cell] = cell;
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		if (shGrids[i].GetResolution() != settings.gridResolution)
+			shGrids[i].Reset(settings.gridResolution);
+	}
+
+	std::vector<float> colors(cells.size() * ConeCount * 3);
+	float (*coneColors)[3] = reinterpret_cast<float (*)[3]>(colors.data());
+	const size_t coneCount = cells.size() * ConeCount;
+
+	ThreadPool::ParallelFor((coneCount + ConesPerJob - 1) / ConesPerJob, 1, [&](size_t begin, size_t end)
+	{
+		TraceCellConesSkipping(settings, grids, pyramid, cells.data(), begin * ConesPerJob, std::min(end * ConesPerJob, coneCount), coneColors);
+	});
+
+	ThreadPool::ParallelFor(cells.size(), 16, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			StoreCell(cells[i], &coneColors[i * ConeCount], shGrids);
+	});
+
+	return cellCount;
+}
+
+void SHGridBaker::BakeCells(const SHBakeSettings& settings, const VoxelGrid* grids, const uint32_t* cells, size_t cellCount, VoxelGrid* shGrids)
+{
+	std::vector<float> colors(cellCount * ConeCount * 3);
+	float (*coneColors)[3] = reinterpret_cast<float (*)[3]>(colors.data());
+
+	bool useAvx2 = IsAvx2Supported();
+
+	for (uint32_t mip = 0; mip < MipCount; ++mip)
+		useAvx2 = useAvx2 && IsPowerOfTwo(grids[mip].GetResolution());
+
+	const size_t coneCount = cellCount * ConeCount;
+
+	ThreadPool::ParallelFor((coneCount + ConesPerJob - 1) / ConesPerJob, 1, [&](size_t begin, size_t end)
+	{
+		const size_t firstCone = begin * ConesPerJob;
+		const size_t lastCone = std::min(end * ConesPerJob, coneCount);
+
+		if (useAvx2)
+			TraceCellConesAvx2(settings, grids, cells, firstCone, lastCone, coneColors);
+		else
+			TraceCellConesScalar(settings, grids, cells, firstCone, lastCone, coneColors);
+	});
+
+	ThreadPool::ParallelFor(cellCount, 16, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			StoreCell(cells[i], &coneColors[i * ConeCount], shGrids);
+	});
+}
+
+uint32_t SHGridBaker::TraceCone(const SHBakeSettings& settings, const VoxelGrid* grids, const float* origin, const float* direction, float* color)
+{
+	uint32_t hitMip = 0;
+	return TraceCone(settings, grids, origin, direction, color, hitMip);
+}
+
+uint32_t SHGridBaker::TraceCone(const SHBakeSettings& settings, const VoxelGrid* grids, const float* origin, const float* direction, float* color,
+	uint32_t& hitMip)
+{
+	float position[3];
+	float stepOffset[3];
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		stepOffset[axis] = direction[axis] * settings.coneStep;
+		position[axis] = origin[axis] + stepOffset[axis] * (float)InitialIterations;
+	}
+
+	float voxelInfo[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	uint32_t sampleCount = 0;
+	hitMip = MipCount;
+
+	for (uint32_t mip = 0; mip < MipCount && hitMip == MipCount; ++mip)
+	{
+		const uint32_t iterations = FirstMipIterations << mip;
+
+		for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			for (uint32_t axis = 0; axis < 3; ++axis)
+				position[axis] += stepOffset[axis];
+
+			if (hitMip == MipCount)
+			{
+				float voxelPosition[3];
+
+				for (uint32_t axis = 0; axis < 3; ++axis)
+					voxelPosition[axis] = (position[axis] / settings.worldBoundary + 1.0f) * 0.5f;
+
+				SampleGrid(grids[mip], voxelPosition, voxelInfo);
+				++sampleCount;
+				hitMip = voxelInfo[3] < GetOccupiedAlpha(mip) ? MipCount : mip;
+			}
+		}
+	}
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+		color[channel] = voxelInfo[channel];
+
+	return sampleCount;
+}
+
+uint32_t SHGridBaker::TraceCone(const SHBakeSettings& settings, const VoxelGrid* grids, const OccupancyPyramid& pyramid, const float* origin,
+	const float* direction, float* color)
+{
+	float position[3];
+	float stepOffset[3];
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		stepOffset[axis] = direction[axis] * settings.coneStep;
+		position[axis] = origin[axis] + stepOffset[axis] * (float)InitialIterations;
+	}
+
+	// Once the remaining mips are all empty, so is every remaining sample
+	uint32_t firstOfEmptyMips = MipCount;
+
+	while (firstOfEmptyMips > 0 && pyramid.IsEmpty(firstOfEmptyMips - 1))
+		--firstOfEmptyMips;
+
+	float voxelInfo[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	uint32_t sampleCount = 0;
+
+	for (uint32_t mip = 0; mip < firstOfEmptyMips; ++mip)
+	{
+		const uint32_t iterations = FirstMipIterations << mip;
+		const uint32_t resolution = grids[mip].GetResolution();
+
+		// Footprints of the last empty block found, not wrapped
+		int32_t emptyBegin[3] = { 1, 1, 1 };
+		int32_t emptyEnd[3] = { 0, 0, 0 };
+
+		for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			float voxelPosition[3];
+			int32_t texel[3];
+			bool isEmpty = true;
+
+			// Positions are accumulated step by step as in TraceCone(), so the samples taken are the same
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				position[axis] += stepOffset[axis];
+				voxelPosition[axis] = (position[axis] / settings.worldBoundary + 1.0f) * 0.5f;
+				texel[axis] = (int32_t)std::floor(voxelPosition[axis] * (float)resolution - 0.5f);
+				isEmpty = isEmpty && texel[axis] >= emptyBegin[axis] && texel[axis] <= emptyEnd[axis];
+			}
+
+			if (!isEmpty)
+			{
+				const uint32_t wrapped[3] = { WrapCoordinate(texel[0], resolution), WrapCoordinate(texel[1], resolution), WrapCoordinate(texel[2], resolution) };
+				uint32_t level = 0;
+				isEmpty = pyramid.FindEmptyBlock(mip, wrapped[0], wrapped[1], wrapped[2], level);
+
+				// The steps after this one may still be in the block, or anywhere once the whole mip is empty
+				const bool isMipEmpty = isEmpty && pyramid.GetResolution(mip, level) == 1;
+
+				for (uint32_t axis = 0; axis < 3 && isEmpty; ++axis)
+				{
+					const uint32_t blockBegin = wrapped[axis] >> level << level;
+					const uint32_t blockEnd = std::min(blockBegin + (1u << level), resolution);
+
+					emptyBegin[axis] = isMipEmpty ? INT32_MIN : texel[axis] - (int32_t)(wrapped[axis] - blockBegin);
+					emptyEnd[axis] = isMipEmpty ? INT32_MAX : emptyBegin[axis] + (int32_t)(blockEnd - blockBegin) - 1;
+				}
+			}
+
+			if (isEmpty)
+			{
+				for (uint32_t channel = 0; channel < 4; ++channel)
+					voxelInfo[channel] = 0.0f;
+
+				continue;
+			}
+
+			SampleGrid(grids[mip], voxelPosition, voxelInfo);
+			++sampleCount;
+
+			// TraceCone() takes no more samples after a hit
+			if (voxelInfo[3] >= GetOccupiedAlpha(mip))
+			{
+				for (uint32_t channel = 0; channel < 3; ++channel)
+					color[channel] = voxelInfo[channel];
+
+				return sampleCount;
+			}
+		}
+	}
+
+	// The samples of the empty mips are zero
+	if (firstOfEmptyMips < MipCount)
+	{
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			voxelInfo[channel] = 0.0f;
+	}
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+		color[channel] = voxelInfo[channel];
+
+	return sampleCount;
+}
+
+void SHGridBaker::GetCellPosition(const SHBakeSettings& settings, uint32_t cell, float* position)
+{
+	const uint32_t resolution = settings.gridResolution;
+	const uint32_t coordinates[3] = { cell % resolution, cell / resolution % resolution, cell / (resolution * resolution) };
+
+	// The shader divides by the boundary over the half cell width of the pass constants
+	const float cellsPerVolume = settings.worldBoundary / (settings.worldBoundary / (float)resolution);
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+		position[axis] = ((float)coordinates[axis] / cellsPerVolume * 2.0f - 1.0f) * settings.worldBoundary;
+}
+
+const float (*SHGridBaker::GetConeDirections())[3]
+{
+	static const ConeDirections directions;
+	return directions.values;
+}
+
+bool SHGridBaker::IsAvx2Supported()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+
+	// The OS has to save the AVX registers
+	if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+AVX2_FUNCTION void SHGridBaker::TraceCellConesAvx2(const SHBakeSettings& settings, const VoxelGrid* grids, const uint32_t* cells,
+	size_t firstCone, size_t lastCone, float (*colors)[3])
+{
+	const float (*directions)[3] = GetConeDirections();
+
+	for (size_t batch = firstCone; batch < lastCone; batch += 8)
+	{
+		alignas(32) float lanes[6][8];
+
+		// The last batch repeats its last cone in the unused lanes
+		for (uint32_t lane = 0; lane < 8; ++lane)
+		{
+			const size_t cone = std::min(batch + lane, lastCone - 1);
+			float cellPosition[3];
+			GetCellPosition(settings, cells[cone / ConeCount], cellPosition);
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				lanes[axis][lane] = cellPosition[axis];
+				lanes[3 + axis][lane] = directions[cone % ConeCount][axis];
+			}
+		}
+
+		const __m256 origin[3] = { _mm256_load_ps(lanes[0]), _mm256_load_ps(lanes[1]), _mm256_load_ps(lanes[2]) };
+		const __m256 direction[3] = { _mm256_load_ps(lanes[3]), _mm256_load_ps(lanes[4]), _mm256_load_ps(lanes[5]) };
+		__m256 color[3];
+
+		TraceConesAvx2(settings, grids, origin, direction, color);
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+			_mm256_store_ps(lanes[channel], color[channel]);
+
+		for (uint32_t lane = 0; lane < 8 && batch + lane < lastCone; ++lane)
+		{
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				colors[batch + lane][channel] = lanes[channel][lane];
+		}
+	}
+}
+
+void SHGridBaker::TraceCellConesScalar(const SHBakeSettings& settings, const VoxelGrid* grids, const uint32_t* cells,
+	size_t firstCone, size_t lastCone, float (*colors)[3])
+{
+	const float (*directions)[3] = GetConeDirections();
+
+	for (size_t cone = firstCone; cone < lastCone; ++cone)
+	{
+		float cellPosition[3];
+		GetCellPosition(settings, cells[cone / ConeCount], cellPosition);
+		TraceCone(settings, grids, cellPosition, directions[cone % ConeCount], colors[cone]);
+	}
+}
+
+void SHGridBaker::TraceCellConesSkipping(const SHBakeSettings& settings, const VoxelGrid* grids, const OccupancyPyramid& pyramid,
+	const uint32_t* cells, size_t firstCone, size_t lastCone, float (*colors)[3])
+{
+	const float (*directions)[3] = GetConeDirections();
+
+	for (size_t cone = firstCone; cone < lastCone; ++cone)
+	{
+		float cellPosition[3];
+		GetCellPosition(settings, cells[cone / ConeCount], cellPosition);
+		TraceCone(settings, grids, pyramid, cellPosition, directions[cone % ConeCount], colors[cone]);
+	}
+}
+
+void SHGridBaker::StoreCell(uint32_t cell, const float (*colors)[3], VoxelGrid* shGrids)
+{
+	const float (*directions)[3] = GetConeDirections();
+	SHL1RGB coefficients;
+
+	for (uint32_t cone = 0; cone < ConeCount; ++cone)
+		SphericalHarmonics::AddCosineLobe(directions[cone], colors[cone], coefficients);
+
+	// The grids are RGBA8_UNORM, so negative coefficients are stored as zero like on the GPU
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		const float* values = coefficients.channels[channel].values;
+		shGrids[channel].GetTexels()[cell] = VoxelGrid::Pack(values[0] * InversePi, values[1] * InversePi, values[2] * InversePi, values[3] * InversePi);
+	}
+}
\ No newline at end of file
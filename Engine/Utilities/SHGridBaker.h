@@ -0,0 +1,69 @@
+#pragma once
+
+#include "OccupancyPyramid.h"
+#include "VoxelGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// What SHIndirectConeTracing.hlsl reads from the pass constants
+struct SHBakeSettings
+{
+	float		worldBoundary = 50.0f;
+	// Distance between two samples along a cone
+	float		coneStep = 1.0f;
+	// Cells per axis of the SH grids
+	uint32_t	gridResolution = 8;
+};
+
+// CPU port of SHIndirectConeTracing.hlsl. Every cell traces the shader's fourteen cones through the
+// five voxel mips with DiffuseConeTrace's steps, projects the colors onto the cosine lobe and fills
+// the red, green and blue RGBA8 SH grids the indirect lighting samples. Voxels are filtered
+// trilinearly with wrapping, like gsamLinearWrap.
+//
+// Bake() runs on the thread pool and traces eight cones at a time with AVX2 when the CPU has it.
+// The cones of all cells are lined up, so no lane idles. BakeSerial() traces one cone at a time on
+// the calling thread and is the reference. Given an OccupancyPyramid of the mips, Bake() traces one
+// cone at a time on the thread pool and skips the samples it shows to be empty, with the same result.
+class SHGridBaker
+{
+public:
+	SHGridBaker() = default;
+	~SHGridBaker() = default;
+
+	static const uint32_t ConeCount = 14;
+	static const uint32_t MipCount = 5;
+
+	// Voxel mips and three SH grids, resized to the grid resolution. Returns the number of cells.
+	static uint32_t Bake(const SHBakeSettings&, const VoxelGrid*, VoxelGrid*);
+	static uint32_t BakeSerial(const SHBakeSettings&, const VoxelGrid*, VoxelGrid*);
+	static uint32_t Bake(const SHBakeSettings&, const VoxelGrid*, const OccupancyPyramid&, VoxelGrid*);
+
+	// Only the listed cells, by index x fastest, the SH grids must have the grid resolution already
+	static void BakeCells(const SHBakeSettings&, const VoxelGrid*, const uint32_t*, size_t, VoxelGrid*);
+
+	// Color DiffuseConeTrace() returns for a world position and a direction. Returns the voxel samples
+	// taken, the pyramid's version only takes those that may not be zero and stops at the first hit.
+	static uint32_t TraceCone(const SHBakeSettings&, const VoxelGrid*, const float*, const float*, float*);
+	static uint32_t TraceCone(const SHBakeSettings&, const VoxelGrid*, const OccupancyPyramid&, const float*, const float*, float*);
+	// Also the mip the cone stopped at, MipCount when it found nothing
+	static uint32_t TraceCone(const SHBakeSettings&, const VoxelGrid*, const float*, const float*, float*, uint32_t&);
+
+	// World position of a cell
+	static void GetCellPosition(const SHBakeSettings&, uint32_t, float*);
+
+	// The directions of the shader, the first seven and then their opposites
+	static const float (*GetConeDirections())[3];
+
+	static bool IsAvx2Supported();
+
+private:
+
+	// Colors of cones of cells, cone c of cell i at i * ConeCount + c
+	static void TraceCellConesAvx2(const SHBakeSettings&, const VoxelGrid*, const uint32_t*, size_t, size_t, float (*)[3]);
+	static void TraceCellConesScalar(const SHBakeSettings&, const VoxelGrid*, const uint32_t*, size_t, size_t, float (*)[3]);
+	static void TraceCellConesSkipping(const SHBakeSettings&, const VoxelGrid*, const OccupancyPyramid&, const uint32_t*, size_t, size_t, float (*)[3]);
+
+	// Projects the cone colors of a cell and writes its texels
+	static void StoreCell(uint32_t, const float (*)[3], VoxelGrid*);
+};
\ No newline at end of file
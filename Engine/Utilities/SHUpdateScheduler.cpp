@@ -0,0 +1,125 @@
+#include "SHUpdateScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Cells are where SHIndirectConeTracing.hlsl places them, the first one on the volume's minimum corner
+	float GetCellCoordinate(uint32_t coordinate, const SHUpdateSettings& settings)
+	{
+		return ((float)coordinate / (float)settings.gridResolution * 2.0f - 1.0f) * settings.worldBoundary;
+	}
+}
+
+const uint32_t SHUpdateScheduler::MaxCellsPerFrame;
+
+void SHUpdateScheduler::Reset(const SHUpdateSettings& settings)
+{
+	mSettings = settings;
+	mFrame = 0;
+
+	const uint32_t cellCount = settings.gridResolution * settings.gridResolution * settings.gridResolution;
+
+	mLastTracedFrames.assign(cellCount, 0);
+	mChanged.assign(cellCount, 1);
+	mPriorities.resize(cellCount);
+	mOrder.resize(cellCount);
+}
+
+void SHUpdateScheduler::MarkChanged(const float* boxMin, const float* boxMax)
+{
+	const float cellWidth = 2.0f * mSettings.worldBoundary / (float)mSettings.gridResolution;
+	const float margin = (float)mSettings.changeRadius * cellWidth;
+
+	int32_t begin[3];
+	int32_t end[3];
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		begin[axis] = std::max((int32_t)std::ceil((boxMin[axis] - margin + mSettings.worldBoundary) / cellWidth), 0);
+		end[axis] = std::min((int32_t)std::floor((boxMax[axis] + margin + mSettings.worldBoundary) / cellWidth) + 1, (int32_t)mSettings.gridResolution);
+
+		if (begin[axis] >= end[axis])
+			return;
+	}
+
+	for (int32_t z = begin[2]; z < end[2]; ++z)
+	{
+		for (int32_t y = begin[1]; y < end[1]; ++y)
+		{
+			for (int32_t x = begin[0]; x < end[0]; ++x)
+				mChanged[((uint32_t)z * mSettings.gridResolution + (uint32_t)y) * mSettings.gridResolution + (uint32_t)x] = 1;
+		}
+	}
+}
+
+void SHUpdateScheduler::MarkAllChanged()
+{
+	std::fill(mChanged.begin(), mChanged.end(), (uint8_t)1);
+}
+
+uint32_t SHUpdateScheduler::Schedule(const float* cameraPosition, std::vector<uint32_t>& cells)
+{
+	++mFrame;
+
+	const uint32_t cellCount = GetCellCount();
+	const uint32_t selectedCount = std::min(GetCellsPerFrame(), cellCount);
+
+	for (uint32_t cell = 0; cell < cellCount; ++cell)
+	{
+		mPriorities[cell] = GetPriority(cell, cameraPosition);
+		mOrder[cell] = cell;
+	}
+
+	// Ties go to the lower index, so the order doesn't depend on the sort
+	if (selectedCount < cellCount)
+	{
+		std::nth_element(mOrder.begin(), mOrder.begin() + selectedCount, mOrder.end(), [this](uint32_t a, uint32_t b)
+		{
+			return mPriorities[a] > mPriorities[b] || (mPriorities[a] == mPriorities[b] && a < b);
+		});
+	}
+
+	cells.assign(mOrder.begin(), mOrder.begin() + selectedCount);
+	std::sort(cells.begin(), cells.end());
+
+	for (uint32_t cell : cells)
+	{
+		mLastTracedFrames[cell] = mFrame;
+		mChanged[cell] = 0;
+	}
+
+	return selectedCount;
+}
+
+bool SHUpdateScheduler::IsTracedSince(uint32_t frame) const
+{
+	return std::all_of(mLastTracedFrames.begin(), mLastTracedFrames.end(), [frame](uint32_t lastTraced) { return lastTraced >= frame; });
+}
+
+float SHUpdateScheduler::GetPriority(uint32_t cell, const float* cameraPosition) const
+{
+	const uint32_t resolution = mSettings.gridResolution;
+	const uint32_t coordinates[3] = { cell % resolution, cell / resolution % resolution, cell / (resolution * resolution) };
+
+	float squaredDistance = 0.0f;
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		const float offset = GetCellCoordinate(coordinates[axis], mSettings) - cameraPosition[axis];
+		squaredDistance += offset * offset;
+	}
+
+	// A cell at the camera gets all of the distance weight, one a cell width away half of it
+	const float cellWidth = 2.0f * mSettings.worldBoundary / (float)resolution;
+	const float proximity = 1.0f / (1.0f + std::sqrt(squaredDistance) / cellWidth);
+
+	return mSettings.stalenessWeight * (float)GetStaleness(cell) + (mChanged[cell] != 0 ? mSettings.changeWeight : 0.0f)
+		+ mSettings.distanceWeight * proximity;
+}
+
+uint32_t SHUpdateScheduler::GetCellsPerFrame() const
+{
+	return std::min(mSettings.cellsPerFrame, MaxCellsPerFrame);
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct SHUpdateSettings
+{
+	// Of the SH grids, as SHBakeSettings
+	uint32_t	gridResolution = 8;
+	float		worldBoundary = 50.0f;
+
+	// Cost cap, the cells cone traced in a frame. Clamped to SHUpdateScheduler::MaxCellsPerFrame.
+	uint32_t	cellsPerFrame = 64;
+
+	// Priority of a cell: stalenessWeight per frame since it was traced, changeWeight once voxels
+	// near it changed, and up to distanceWeight the nearer it is to the camera
+	float		stalenessWeight = 1.0f;
+	float		changeWeight = 16.0f;
+	float		distanceWeight = 8.0f;
+
+	// Cells around a changed box that count as changed, the cones start next to their cell
+	uint32_t	changeRadius = 1;
+};
+
+// Chooses which SH grid cells to cone trace each frame, so a frame traces a fixed budget of cells
+// instead of the whole grid. The cells picked are the highest priority ones, mixing how long ago a
+// cell was traced, whether the voxels around it changed since and how near it is to the camera.
+// Staleness keeps growing, so every cell is traced again eventually however the camera moves.
+//
+// Only bookkeeping, the caller traces the cells it returns. After Reset() every cell counts as changed.
+class SHUpdateScheduler
+{
+public:
+	SHUpdateScheduler() = default;
+	~SHUpdateScheduler() = default;
+
+	// What PassConstants has room for
+	static const uint32_t MaxCellsPerFrame = 256;
+
+	void Reset(const SHUpdateSettings&);
+
+	// A world space box of voxels that changed, as min and max corners
+	void MarkChanged(const float*, const float*);
+	void MarkAllChanged();
+
+	// Starts a frame and fills the cells to trace in it, in increasing order, from a camera position.
+	// They count as traced from then on. Returns how many there are.
+	uint32_t Schedule(const float*, std::vector<uint32_t>&);
+
+	float GetPriority(uint32_t, const float*) const;
+
+	const SHUpdateSettings& GetSettings() const { return mSettings; }
+	uint32_t GetCellCount() const { return (uint32_t)mLastTracedFrames.size(); }
+	uint32_t GetCellsPerFrame() const;
+	uint32_t GetFrame() const { return mFrame; }
+	// Frames since the cell was traced
+	uint32_t GetStaleness(uint32_t cell) const { return mFrame - mLastTracedFrames[cell]; }
+	bool IsChanged(uint32_t cell) const { return mChanged[cell] != 0; }
+	// Whether every cell was traced in the frame or after it
+	bool IsTracedSince(uint32_t) const;
+
+private:
+
+	SHUpdateSettings mSettings;
+	uint32_t mFrame = 0;
+
+	std::vector<uint32_t> mLastTracedFrames;
+	std::vector<uint8_t> mChanged;
+
+	// Scratch of Schedule()
+	std::vector<float> mPriorities;
+	std::vector<uint32_t> mOrder;
+};
\ No newline at end of file
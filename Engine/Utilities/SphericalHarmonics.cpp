@@ -0,0 +1,473 @@
+#include "SphericalHarmonics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace
+{
+	// Basis constants, SH_C0 and SH_C1 of IndirectLightingUtil.hlsl and the L2 ones
+	const float BasisC0 = 0.282094792f;
+	const float BasisC1 = 0.488602512f;
+	const float BasisC2 = 1.09254843f;
+	const float BasisC20 = 0.315391565f;
+	const float BasisC22 = 0.546274215f;
+
+	// The basis constants times the cosine's band scales, SH_cosLobe_C0 and SH_cosLobe_C1 of
+	// ConeTracingUtil.hlsl and the L2 ones
+	const float CosineLobeC0 = 0.886226925f;
+	const float CosineLobeC1 = 1.02332671f;
+	const float CosineLobeC2 = 0.858085531f;
+	const float CosineLobeC20 = 0.247707956f;
+	const float CosineLobeC22 = 0.429042765f;
+
+	const float Pi = 3.14159265f;
+	const uint32_t MaxCoefficientCount = 9;
+
+	// Directions the rotation of band 2 is solved at, any five whose basis values are independent
+	const float Band2Directions[5][3] =
+	{
+		{ 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f },
+		{ 0.707106781f, 0.707106781f, 0.0f },
+		{ 0.707106781f, 0.0f, 0.707106781f },
+		{ 0.0f, 0.707106781f, 0.707106781f }
+	};
+
+	const float Band1Directions[3][3] =
+	{
+		{ 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f }
+	};
+
+	// Fills the first Order * Order of nine values
+	template <uint32_t Order>
+	void GetBasis(float x, float y, float z, float* basis)
+	{
+		basis[0] = BasisC0;
+		basis[1] = -BasisC1 * y;
+		basis[2] = BasisC1 * z;
+		basis[3] = -BasisC1 * x;
+
+		if (Order > 2)
+		{
+			basis[4] = BasisC2 * x * y;
+			basis[5] = -BasisC2 * y * z;
+			basis[6] = BasisC20 * (3.0f * z * z - 1.0f);
+			basis[7] = -BasisC2 * x * z;
+			basis[8] = BasisC22 * (x * x - y * y);
+		}
+	}
+
+	template <uint32_t Order>
+	void GetBasis(__m128 x, __m128 y, __m128 z, __m128* basis)
+	{
+		basis[0] = _mm_set1_ps(BasisC0);
+		basis[1] = _mm_mul_ps(_mm_set1_ps(-BasisC1), y);
+		basis[2] = _mm_mul_ps(_mm_set1_ps(BasisC1), z);
+		basis[3] = _mm_mul_ps(_mm_set1_ps(-BasisC1), x);
+
+		if (Order > 2)
+		{
+			basis[4] = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(BasisC2), x), y);
+			basis[5] = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(-BasisC2), y), z);
+			basis[6] = _mm_mul_ps(_mm_set1_ps(BasisC20), _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(3.0f), z), z), _mm_set1_ps(1.0f)));
+			basis[7] = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(-BasisC2), x), z);
+			basis[8] = _mm_mul_ps(_mm_set1_ps(BasisC22), _mm_sub_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+		}
+	}
+
+	float Sum(__m128 value)
+	{
+		float lanes[4];
+		_mm_storeu_ps(lanes, value);
+
+		return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	}
+
+	// Rotation of the band starting at a coefficient, from its basis values at sample directions
+	// and at those directions rotated back: A * rotated = B * original, so rotated = A^-1 * B
+	template <uint32_t Size>
+	void SolveBandRotation(const float* matrix, const float (*directions)[3], uint32_t firstCoefficient, float (&rotation)[Size][Size])
+	{
+		float a[Size][Size];
+		float b[Size][Size];
+
+		for (uint32_t i = 0; i < Size; ++i)
+		{
+			const float* direction = directions[i];
+			float rotatedBack[3];
+
+			// The transpose undoes the rotation
+			for (uint32_t axis = 0; axis < 3; ++axis)
+				rotatedBack[axis] = matrix[axis] * direction[0] + matrix[3 + axis] * direction[1] + matrix[6 + axis] * direction[2];
+
+			float basis[MaxCoefficientCount];
+			float rotatedBackBasis[MaxCoefficientCount];
+			GetBasis<3>(direction[0], direction[1], direction[2], basis);
+			GetBasis<3>(rotatedBack[0], rotatedBack[1], rotatedBack[2], rotatedBackBasis);
+
+			for (uint32_t j = 0; j < Size; ++j)
+			{
+				a[i][j] = basis[firstCoefficient + j];
+				b[i][j] = rotatedBackBasis[firstCoefficient + j];
+			}
+		}
+
+		// Gauss-Jordan elimination with partial pivoting, applied to B alongside
+		for (uint32_t column = 0; column < Size; ++column)
+		{
+			uint32_t pivot = column;
+
+			for (uint32_t row = column + 1; row < Size; ++row)
+			{
+				if (std::fabs(a[row][column]) > std::fabs(a[pivot][column]))
+					pivot = row;
+			}
+
+			for (uint32_t j = 0; j < Size; ++j)
+			{
+				std::swap(a[column][j], a[pivot][j]);
+				std::swap(b[column][j], b[pivot][j]);
+			}
+
+			const float inversePivot = 1.0f / a[column][column];
+
+			for (uint32_t j = 0; j < Size; ++j)
+			{
+				a[column][j] *= inversePivot;
+				b[column][j] *= inversePivot;
+			}
+
+			for (uint32_t row = 0; row < Size; ++row)
+			{
+				if (row == column)
+					continue;
+
+				const float factor = a[row][column];
+
+				for (uint32_t j = 0; j < Size; ++j)
+				{
+					a[row][j] -= factor * a[column][j];
+					b[row][j] -= factor * b[column][j];
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < Size; ++i)
+		{
+			for (uint32_t j = 0; j < Size; ++j)
+				rotation[i][j] = b[i][j];
+		}
+	}
+}
+
+SHRotation::SHRotation(const float* matrix)
+{
+	SolveBandRotation<3>(matrix, Band1Directions, 1, mBand1);
+	SolveBandRotation<5>(matrix, Band2Directions, 4, mBand2);
+}
+
+template <uint32_t Order>
+void SHRotation::Apply(const SHVector<Order>& input, SHVector<Order>& output) const
+{
+	// The output may be the input
+	float values[MaxCoefficientCount];
+	std::copy(input.values, input.values + SHVector<Order>::CoefficientCount, values);
+
+	output.values[0] = values[0];
+
+	for (uint32_t i = 0; i < 3; ++i)
+		output.values[1 + i] = mBand1[i][0] * values[1] + mBand1[i][1] * values[2] + mBand1[i][2] * values[3];
+
+	if (Order > 2)
+	{
+		for (uint32_t i = 0; i < 5; ++i)
+		{
+			float value = 0.0f;
+
+			for (uint32_t j = 0; j < 5; ++j)
+				value += mBand2[i][j] * values[4 + j];
+
+			output.values[4 + i] = value;
+		}
+	}
+}
+
+template <uint32_t Order>
+void SHRotation::Apply(const SHColor<Order>& input, SHColor<Order>& output) const
+{
+	for (uint32_t channel = 0; channel < 3; ++channel)
+		Apply(input.channels[channel], output.channels[channel]);
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::EvaluateBasis(const float* direction, SHVector<Order>& basis)
+{
+	float values[MaxCoefficientCount];
+	GetBasis<Order>(direction[0], direction[1], direction[2], values);
+
+	std::copy(values, values + SHVector<Order>::CoefficientCount, basis.values);
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::EvaluateCosineLobe(const float* direction, SHVector<Order>& lobe)
+{
+	// Written out like dirToCosineLobe(), so the cone tracing port rounds like the shader
+	float values[MaxCoefficientCount];
+	values[0] = CosineLobeC0;
+	values[1] = -CosineLobeC1 * direction[1];
+	values[2] = CosineLobeC1 * direction[2];
+	values[3] = -CosineLobeC1 * direction[0];
+
+	if (Order > 2)
+	{
+		values[4] = CosineLobeC2 * direction[0] * direction[1];
+		values[5] = -CosineLobeC2 * direction[1] * direction[2];
+		values[6] = CosineLobeC20 * (3.0f * direction[2] * direction[2] - 1.0f);
+		values[7] = -CosineLobeC2 * direction[0] * direction[2];
+		values[8] = CosineLobeC22 * (direction[0] * direction[0] - direction[1] * direction[1]);
+	}
+
+	std::copy(values, values + SHVector<Order>::CoefficientCount, lobe.values);
+}
+
+template <uint32_t Order>
+float SphericalHarmonics::Evaluate(const SHVector<Order>& expansion, const float* direction)
+{
+	float basis[MaxCoefficientCount];
+	GetBasis<Order>(direction[0], direction[1], direction[2], basis);
+
+	float value = 0.0f;
+
+	for (uint32_t i = 0; i < SHVector<Order>::CoefficientCount; ++i)
+		value += expansion.values[i] * basis[i];
+
+	return value;
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::Evaluate(const SHColor<Order>& expansion, const float* direction, float* color)
+{
+	float basis[MaxCoefficientCount];
+	GetBasis<Order>(direction[0], direction[1], direction[2], basis);
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		float value = 0.0f;
+
+		for (uint32_t i = 0; i < SHVector<Order>::CoefficientCount; ++i)
+			value += expansion.channels[channel].values[i] * basis[i];
+
+		color[channel] = value;
+	}
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::Project(const float* direction, const float* color, float weight, SHColor<Order>& expansion)
+{
+	float basis[MaxCoefficientCount];
+	GetBasis<Order>(direction[0], direction[1], direction[2], basis);
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		const float weightedColor = color[channel] * weight;
+
+		for (uint32_t i = 0; i < SHVector<Order>::CoefficientCount; ++i)
+			expansion.channels[channel].values[i] += basis[i] * weightedColor;
+	}
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::AddCosineLobe(const float* direction, const float* color, SHColor<Order>& expansion)
+{
+	SHVector<Order> lobe;
+	EvaluateCosineLobe(direction, lobe);
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		for (uint32_t i = 0; i < SHVector<Order>::CoefficientCount; ++i)
+			expansion.channels[channel].values[i] += lobe.values[i] * color[channel];
+	}
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::ProjectBatch(const float* x, const float* y, const float* z, const float* red, const float* green,
+	const float* blue, const float* weights, size_t count, SHColor<Order>& expansion)
+{
+	const uint32_t coefficientCount = SHVector<Order>::CoefficientCount;
+	const float* colors[3] = { red, green, blue };
+
+	// Every lane sums its own directions, the lanes are added up at the end
+	__m128 sums[3][MaxCoefficientCount];
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		for (uint32_t i = 0; i < coefficientCount; ++i)
+			sums[channel][i] = _mm_setzero_ps();
+	}
+
+	const size_t batchedCount = count & ~(size_t)3;
+
+	for (size_t first = 0; first < batchedCount; first += 4)
+	{
+		__m128 basis[MaxCoefficientCount];
+		GetBasis<Order>(_mm_loadu_ps(x + first), _mm_loadu_ps(y + first), _mm_loadu_ps(z + first), basis);
+
+		const __m128 weight = weights != nullptr ? _mm_loadu_ps(weights + first) : _mm_set1_ps(1.0f);
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			const __m128 weightedColor = _mm_mul_ps(_mm_loadu_ps(colors[channel] + first), weight);
+
+			for (uint32_t i = 0; i < coefficientCount; ++i)
+				sums[channel][i] = _mm_add_ps(sums[channel][i], _mm_mul_ps(basis[i], weightedColor));
+		}
+	}
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		for (uint32_t i = 0; i < coefficientCount; ++i)
+			expansion.channels[channel].values[i] += Sum(sums[channel][i]);
+	}
+
+	for (size_t remaining = batchedCount; remaining < count; ++remaining)
+	{
+		const float direction[3] = { x[remaining], y[remaining], z[remaining] };
+		const float color[3] = { red[remaining], green[remaining], blue[remaining] };
+
+		Project(direction, color, weights != nullptr ? weights[remaining] : 1.0f, expansion);
+	}
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::EvaluateBatch(const SHColor<Order>& expansion, const float* x, const float* y, const float* z, size_t count,
+	float* red, float* green, float* blue)
+{
+	const uint32_t coefficientCount = SHVector<Order>::CoefficientCount;
+	float* colors[3] = { red, green, blue };
+
+	__m128 coefficients[3][MaxCoefficientCount];
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		for (uint32_t i = 0; i < coefficientCount; ++i)
+			coefficients[channel][i] = _mm_set1_ps(expansion.channels[channel].values[i]);
+	}
+
+	const size_t batchedCount = count & ~(size_t)3;
+
+	for (size_t first = 0; first < batchedCount; first += 4)
+	{
+		__m128 basis[MaxCoefficientCount];
+		GetBasis<Order>(_mm_loadu_ps(x + first), _mm_loadu_ps(y + first), _mm_loadu_ps(z + first), basis);
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			__m128 value = _mm_mul_ps(coefficients[channel][0], basis[0]);
+
+			for (uint32_t i = 1; i < coefficientCount; ++i)
+				value = _mm_add_ps(value, _mm_mul_ps(coefficients[channel][i], basis[i]));
+
+			_mm_storeu_ps(colors[channel] + first, value);
+		}
+	}
+
+	for (size_t remaining = batchedCount; remaining < count; ++remaining)
+	{
+		const float direction[3] = { x[remaining], y[remaining], z[remaining] };
+		float color[3];
+
+		Evaluate(expansion, direction, color);
+
+		for (uint32_t channel = 0; channel < 3; ++channel)
+			colors[channel][remaining] = color[channel];
+	}
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::ConvolveCosine(SHVector<Order>& expansion)
+{
+	for (uint32_t band = 0; band < Order; ++band)
+	{
+		const float scale = GetCosineBandScale(band);
+
+		for (uint32_t i = band * band; i < (band + 1) * (band + 1); ++i)
+			expansion.values[i] *= scale;
+	}
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::ConvolveCosine(SHColor<Order>& expansion)
+{
+	for (uint32_t channel = 0; channel < 3; ++channel)
+		ConvolveCosine(expansion.channels[channel]);
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::ApplyWindow(SHVector<Order>& expansion, float width)
+{
+	for (uint32_t band = 1; band < Order; ++band)
+	{
+		const float scale = (float)band < width ? 0.5f * (1.0f + std::cos(Pi * (float)band / width)) : 0.0f;
+
+		for (uint32_t i = band * band; i < (band + 1) * (band + 1); ++i)
+			expansion.values[i] *= scale;
+	}
+}
+
+template <uint32_t Order>
+void SphericalHarmonics::ApplyWindow(SHColor<Order>& expansion, float width)
+{
+	for (uint32_t channel = 0; channel < 3; ++channel)
+		ApplyWindow(expansion.channels[channel], width);
+}
+
+float SphericalHarmonics::GetCosineBandScale(uint32_t band)
+{
+	// Ramamoorthi and Hanrahan's A_l: pi, 2pi/3 and pi/4, zero for the odd bands above
+	switch (band)
+	{
+	case 0:
+		return Pi;
+	case 1:
+		return 2.0f * Pi / 3.0f;
+	case 2:
+		return 0.25f * Pi;
+	default:
+		return 0.0f;
+	}
+}
+
+template void SHRotation::Apply<2>(const SHVector<2>&, SHVector<2>&) const;
+template void SHRotation::Apply<3>(const SHVector<3>&, SHVector<3>&) const;
+template void SHRotation::Apply<2>(const SHColor<2>&, SHColor<2>&) const;
+template void SHRotation::Apply<3>(const SHColor<3>&, SHColor<3>&) const;
+
+template void SphericalHarmonics::EvaluateBasis<2>(const float*, SHVector<2>&);
+template void SphericalHarmonics::EvaluateBasis<3>(const float*, SHVector<3>&);
+template void SphericalHarmonics::EvaluateCosineLobe<2>(const float*, SHVector<2>&);
+template void SphericalHarmonics::EvaluateCosineLobe<3>(const float*, SHVector<3>&);
+template float SphericalHarmonics::Evaluate<2>(const SHVector<2>&, const float*);
+template float SphericalHarmonics::Evaluate<3>(const SHVector<3>&, const float*);
+template void SphericalHarmonics::Evaluate<2>(const SHColor<2>&, const float*, float*);
+template void SphericalHarmonics::Evaluate<3>(const SHColor<3>&, const float*, float*);
+template void SphericalHarmonics::Project<2>(const float*, const float*, float, SHColor<2>&);
+template void SphericalHarmonics::Project<3>(const float*, const float*, float, SHColor<3>&);
+template void SphericalHarmonics::AddCosineLobe<2>(const float*, const float*, SHColor<2>&);
+template void SphericalHarmonics::AddCosineLobe<3>(const float*, const float*, SHColor<3>&);
+template void SphericalHarmonics::ProjectBatch<2>(const float*, const float*, const float*, const float*, const float*, const float*,
+	const float*, size_t, SHColor<2>&);
+template void SphericalHarmonics::ProjectBatch<3>(const float*, const float*, const float*, const float*, const float*, const float*,
+	const float*, size_t, SHColor<3>&);
+template void SphericalHarmonics::EvaluateBatch<2>(const SHColor<2>&, const float*, const float*, const float*, size_t, float*, float*, float*);
+template void SphericalHarmonics::EvaluateBatch<3>(const SHColor<3>&, const float*, const float*, const float*, size_t, float*, float*, float*);
+template void SphericalHarmonics::ConvolveCosine<2>(SHVector<2>&);
+template void SphericalHarmonics::ConvolveCosine<3>(SHVector<3>&);
+template void SphericalHarmonics::ConvolveCosine<2>(SHColor<2>&);
+template void SphericalHarmonics::ConvolveCosine<3>(SHColor<3>&);
+template void SphericalHarmonics::ApplyWindow<2>(SHVector<2>&, float);
+template void SphericalHarmonics::ApplyWindow<3>(SHVector<3>&, float);
+template void SphericalHarmonics::ApplyWindow<2>(SHColor<2>&, float);
+template void SphericalHarmonics::ApplyWindow<3>(SHColor<3>&, float);
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Coefficients of a real SH expansion with Order bands, 2 for L1 and 3 for L2. They are ordered
+// like the shaders' dirToSH(): band by band, from m = -l to m = l.
+template <uint32_t Order>
+struct SHVector
+{
+	static const uint32_t CoefficientCount = Order * Order;
+
+	float values[CoefficientCount] = {};
+};
+
+template <uint32_t Order>
+const uint32_t SHVector<Order>::CoefficientCount;
+
+// A red, green and blue expansion, a channel's coefficients next to each other
+template <uint32_t Order>
+struct SHColor
+{
+	SHVector<Order> channels[3];
+};
+
+typedef SHVector<2> SHL1;
+typedef SHVector<3> SHL2;
+typedef SHColor<2> SHL1RGB;
+typedef SHColor<3> SHL2RGB;
+
+// Rotates SH expansions, for one rotation set up once and applied to many expansions. The matrix
+// is row major and rotates directions, so the rotated expansion takes at R * d the value the
+// original takes at d.
+class SHRotation
+{
+public:
+	SHRotation() = default;
+	~SHRotation() = default;
+
+	explicit SHRotation(const float*);
+
+	template <uint32_t Order>
+	void Apply(const SHVector<Order>&, SHVector<Order>&) const;
+	template <uint32_t Order>
+	void Apply(const SHColor<Order>&, SHColor<Order>&) const;
+
+private:
+
+	// Band 1 rotates like a vector, band 2 with a 5x5 block
+	float mBand1[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+	float mBand2[5][5] = { { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 0.0f, 1.0f } };
+};
+
+// CPU side of the SH math of ConeTracingUtil.hlsl and IndirectLightingUtil.hlsl, for L1 and L2. The
+// basis is the shaders' one, with the sign of the odd m terms, so SH_C0 and SH_C1 are the first
+// constants and EvaluateCosineLobe() of an L1 expansion is dirToCosineLobe().
+//
+// Directions are unit vectors. The batch functions take structure of arrays directions and colors and
+// work on four directions at a time with SSE.
+class SphericalHarmonics
+{
+public:
+	SphericalHarmonics() = default;
+	~SphericalHarmonics() = default;
+
+	// The basis functions at a direction
+	template <uint32_t Order>
+	static void EvaluateBasis(const float*, SHVector<Order>&);
+
+	// The clamped cosine lobe around a direction, the basis convolved with it
+	template <uint32_t Order>
+	static void EvaluateCosineLobe(const float*, SHVector<Order>&);
+
+	// Value of an expansion at a direction
+	template <uint32_t Order>
+	static float Evaluate(const SHVector<Order>&, const float*);
+	template <uint32_t Order>
+	static void Evaluate(const SHColor<Order>&, const float*, float*);
+
+	// Adds a color from a direction with a weight, the solid angle it stands for when integrating
+	template <uint32_t Order>
+	static void Project(const float*, const float*, float, SHColor<Order>&);
+
+	// Adds the cosine lobe around a direction scaled by a color, as the SH cone tracing does
+	template <uint32_t Order>
+	static void AddCosineLobe(const float*, const float*, SHColor<Order>&);
+
+	// Project() of many directions, from x, y and z arrays, red, green and blue arrays and optional
+	// weights, one each if null
+	template <uint32_t Order>
+	static void ProjectBatch(const float*, const float*, const float*, const float*, const float*, const float*,
+		const float*, size_t, SHColor<Order>&);
+
+	// Evaluate() at many directions, into red, green and blue arrays
+	template <uint32_t Order>
+	static void EvaluateBatch(const SHColor<Order>&, const float*, const float*, const float*, size_t, float*, float*, float*);
+
+	// Convolves with the clamped cosine, turning radiance into irradiance. The bands kept are exact,
+	// the cosine's higher bands are small enough that L2 irradiance is within a few percent.
+	template <uint32_t Order>
+	static void ConvolveCosine(SHVector<Order>&);
+	template <uint32_t Order>
+	static void ConvolveCosine(SHColor<Order>&);
+
+	// Scales band l by the Hann window (1 + cos(pi * l / width)) / 2, zero from the width on. Damps
+	// the ringing of truncated expansions of sharp lights, at the price of blurring them.
+	template <uint32_t Order>
+	static void ApplyWindow(SHVector<Order>&, float);
+	template <uint32_t Order>
+	static void ApplyWindow(SHColor<Order>&, float);
+
+	// What convolving with the clamped cosine scales band l by, up to band 2
+	static float GetCosineBandScale(uint32_t);
+};
\ No newline at end of file
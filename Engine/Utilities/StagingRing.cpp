@@ -0,0 +1,66 @@
+#include "StagingRing.h"
+
+void StagingRing::Reset(uint64_t capacity)
+{
+	mRetiredRanges.clear();
+
+	mCapacity = capacity;
+	mHead = 0;
+	mUsedBytes = 0;
+	mPendingBytes = 0;
+	mPeakUsedBytes = 0;
+}
+
+bool StagingRing::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+{
+	if (size > mCapacity)
+		return false;
+
+	uint64_t start = (mHead + alignment - 1) / alignment * alignment;
+	uint64_t allocatedBytes = start - mHead + size;
+
+	// Allocations are contiguous, the end of the ring is skipped and counted as used until released
+	if (start + size > mCapacity)
+	{
+		start = 0;
+		allocatedBytes = mCapacity - mHead + size;
+	}
+
+	if (mUsedBytes + allocatedBytes > mCapacity)
+		return false;
+
+	mHead = start + size;
+	mUsedBytes += allocatedBytes;
+	mPendingBytes += allocatedBytes;
+	mPeakUsedBytes = mUsedBytes > mPeakUsedBytes ? mUsedBytes : mPeakUsedBytes;
+
+	offset = start;
+
+	return true;
+}
+
+void StagingRing::Retire(uint64_t fence)
+{
+	if (mPendingBytes == 0)
+		return;
+
+	RetiredRange range;
+	range.fence = fence;
+	range.size = mPendingBytes;
+
+	mRetiredRanges.push_back(range);
+	mPendingBytes = 0;
+}
+
+void StagingRing::Release(uint64_t completedFence)
+{
+	while (!mRetiredRanges.empty() && mRetiredRanges.front().fence <= completedFence)
+	{
+		mUsedBytes -= mRetiredRanges.front().size;
+		mRetiredRanges.pop_front();
+	}
+
+	// Empty, so the next allocation may as well start at the beginning
+	if (mUsedBytes == 0)
+		mHead = 0;
+}
\ No newline at end of file
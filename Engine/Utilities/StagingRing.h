@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Suballocates one large upload buffer as a ring, only the offsets are managed so it has no graphics
+// API dependency. Allocations are made while recording, handed the fence of the submission that reads
+// them with Retire(), and their space comes back once Release() sees that fence completed. Space is
+// freed in allocation order, so the ring never fragments.
+class StagingRing
+{
+public:
+	StagingRing() = default;
+	~StagingRing() = default;
+
+	// Forgets every allocation, nothing may be in flight
+	void Reset(uint64_t);
+
+	// Returns false when the ring has no room for the allocation until older ones are released
+	bool Allocate(uint64_t, uint64_t, uint64_t&);
+
+	// The allocations made since the last call are read by the submission signalling the given fence
+	void Retire(uint64_t);
+	// Frees the allocations retired with fences up to the given one
+	void Release(uint64_t);
+
+	uint64_t GetCapacity() const { return mCapacity; }
+	// Including the padding and the end of the ring skipped when an allocation wrapped around
+	uint64_t GetUsedBytes() const { return mUsedBytes; }
+	uint64_t GetPeakUsedBytes() const { return mPeakUsedBytes; }
+
+private:
+
+	struct RetiredRange
+	{
+		uint64_t fence;
+		uint64_t size;
+	};
+
+	std::deque<RetiredRange> mRetiredRanges;
+
+	uint64_t mCapacity = 0;
+	// Next allocation starts at the head, the live ones are the used bytes before it
+	uint64_t mHead = 0;
+	uint64_t mUsedBytes = 0;
+	// Bytes allocated since the last Retire()
+	uint64_t mPendingBytes = 0;
+	uint64_t mPeakUsedBytes = 0;
+};
\ No newline at end of file
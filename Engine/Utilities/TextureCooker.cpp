@@ -0,0 +1,318 @@
+#include "TextureCooker.h"
+#include "DDSImage.h"
+#include "ThreadPool.h"
+#include "../SceneManagement/SceneLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	struct SourceSurface
+	{
+		uint32_t width;
+		uint32_t height;
+	};
+
+	// Alpha this close to 0 or 255 counts as on / off when choosing between BC1 and BC3
+	const uint8_t BinaryAlphaTolerance = 8;
+
+	bool IsSupportedSourceFormat(DXGI_FORMAT format, bool& isBGRA, bool& isSRGB)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			isBGRA = false;
+			isSRGB = (format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB);
+			return true;
+
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			isBGRA = true;
+			isSRGB = (format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	bool Fail(TextureCookReport& report, const std::string& error)
+	{
+		report.succeeded = false;
+		report.error = error;
+		return false;
+	}
+
+	// Replaces the surfaces with a generated chain for every array slice
+	void GenerateMips(const TextureCookSettings& settings, float alphaClipThreshold, uint32_t sourceMipCount,
+		const DDSDescription& description, std::vector<std::vector<uint8_t>>& surfaces, std::vector<SourceSurface>& surfaceSizes,
+		TextureCookReport& report)
+	{
+		std::vector<std::vector<uint8_t>> generatedSurfaces(description.mipCount * description.arraySize);
+		std::vector<SourceSurface> generatedSizes(generatedSurfaces.size());
+
+		bool reportsCoverage = (settings.usage == TextureUsage::DiffuseOpacity);
+
+		if (reportsCoverage)
+		{
+			report.mipCoverageErrors.assign(description.mipCount, 0.0);
+			report.filteredMipCoverageErrors.assign(description.mipCount, 0.0);
+		}
+
+		std::vector<MipLevel> mips;
+		std::vector<MipCoverage> coverage;
+
+		for (uint32_t slice = 0; slice < description.arraySize; ++slice)
+		{
+			uint32_t topLevel = DDSImage::CalcSubresource(0, slice, sourceMipCount);
+
+			if (reportsCoverage)
+			{
+				MipGenerator::GenerateDiffuseOpacityMips(surfaces[topLevel].data(), surfaceSizes[topLevel].width, surfaceSizes[topLevel].height,
+					alphaClipThreshold, mips, &coverage);
+
+				for (uint32_t mip = 0; mip < description.mipCount; ++mip)
+				{
+					report.mipCoverageErrors[mip] = std::max(report.mipCoverageErrors[mip],
+						std::fabs(coverage[mip].coverage - coverage[mip].targetCoverage));
+					report.filteredMipCoverageErrors[mip] = std::max(report.filteredMipCoverageErrors[mip],
+						std::fabs(coverage[mip].filteredCoverage - coverage[mip].targetCoverage));
+				}
+			}
+			else
+			{
+				MipGenerator::GenerateNormalRoughnessMips(surfaces[topLevel].data(), surfaceSizes[topLevel].width, surfaceSizes[topLevel].height,
+					mips);
+			}
+
+			for (uint32_t mip = 0; mip < description.mipCount; ++mip)
+			{
+				uint32_t subresource = DDSImage::CalcSubresource(mip, slice, description.mipCount);
+
+				generatedSizes[subresource].width = mips[mip].width;
+				generatedSizes[subresource].height = mips[mip].height;
+				generatedSurfaces[subresource] = std::move(mips[mip].texels);
+			}
+		}
+
+		surfaces = std::move(generatedSurfaces);
+		surfaceSizes = std::move(generatedSizes);
+	}
+}
+
+bool TextureCooker::CookTexture(const std::string& inputPath, const std::string& outputPath, const TextureCookSettings& settings,
+	TextureCookReport& report)
+{
+	report = TextureCookReport();
+	report.inputPath = inputPath;
+	report.outputPath = outputPath;
+
+	DDSImage image;
+
+	if (!image.Load(inputPath))
+		return Fail(report, "could not read " + inputPath);
+
+	const DDSDescription& sourceDescription = image.GetDescription();
+
+	bool isBGRA = false;
+	bool isSRGB = false;
+
+	if (!IsSupportedSourceFormat(sourceDescription.format, isBGRA, isSRGB))
+		return Fail(report, "only RGBA8 and BGRA8 textures can be cooked");
+
+	if (sourceDescription.dimension != DDS_DIMENSION_TEXTURE2D)
+		return Fail(report, "only 2D textures can be cooked");
+
+	// D3D12 requires the top mip of a block compressed texture to be whole blocks
+	if ((sourceDescription.width % 4) != 0 || (sourceDescription.height % 4) != 0)
+		return Fail(report, "width and height must be multiples of 4");
+
+	// Tightly packed RGBA8 copies, the encoder and the quality report both read them
+	std::vector<std::vector<uint8_t>> surfaces(image.GetSubresourceCount());
+	std::vector<SourceSurface> surfaceSizes(image.GetSubresourceCount());
+
+	for (uint32_t i = 0; i < image.GetSubresourceCount(); ++i)
+	{
+		const DDSSubresource& subresource = image.GetSubresource(i);
+
+		surfaceSizes[i].width = subresource.width;
+		surfaceSizes[i].height = subresource.height;
+		surfaces[i].resize((size_t)subresource.width * subresource.height * 4);
+
+		for (uint32_t y = 0; y < subresource.height; ++y)
+		{
+			const uint8_t* sourceRow = subresource.data + y * subresource.rowPitch;
+			uint8_t* destinationRow = &surfaces[i][(size_t)y * subresource.width * 4];
+
+			if (!isBGRA)
+			{
+				memcpy(destinationRow, sourceRow, (size_t)subresource.width * 4);
+				continue;
+			}
+
+			for (uint32_t x = 0; x < subresource.width; ++x)
+			{
+				destinationRow[x * 4 + 0] = sourceRow[x * 4 + 2];
+				destinationRow[x * 4 + 1] = sourceRow[x * 4 + 1];
+				destinationRow[x * 4 + 2] = sourceRow[x * 4 + 0];
+				destinationRow[x * 4 + 3] = sourceRow[x * 4 + 3];
+			}
+		}
+
+		report.inputBytes += subresource.size;
+	}
+
+	report.format = ChooseFormat(settings, surfaces);
+
+	// BC5 has no sRGB variant, it is only meant for normals
+	DDSDescription description = sourceDescription;
+	description.format = BCEncoder::GetDXGIFormat(report.format, isSRGB);
+
+	float alphaClipThreshold = (settings.usage == TextureUsage::DiffuseOpacity) ? BCEncoder::DiffuseAlphaClipThreshold : BCEncoder::NoAlphaClip;
+
+	if (settings.generateMips)
+	{
+		description.mipCount = MipGenerator::GetMipCount(description.width, description.height);
+		GenerateMips(settings, alphaClipThreshold, sourceDescription.mipCount, description, surfaces, surfaceSizes, report);
+	}
+
+	report.subresourceCount = (uint32_t)surfaces.size();
+
+	std::vector<uint8_t> file;
+	DDSFormat::WriteHeader(description, file);
+	size_t blockSize = BCEncoder::GetBlockSize(report.format);
+
+	report.psnr = 100.0;
+
+	std::vector<uint8_t> decoded;
+	double encodeSeconds = 0.0;
+
+	for (uint32_t i = 0; i < report.subresourceCount; ++i)
+	{
+		uint32_t width = surfaceSizes[i].width;
+		uint32_t height = surfaceSizes[i].height;
+		size_t blocksWide = std::max<size_t>(1, (width + 3) / 4);
+		size_t blocksHigh = std::max<size_t>(1, (height + 3) / 4);
+
+		size_t offset = file.size();
+		file.resize(offset + blocksWide * blocksHigh * blockSize);
+		decoded.resize((size_t)width * height * 4);
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		BCEncoder::EncodeSurface(surfaces[i].data(), width, height, (size_t)width * 4, report.format, alphaClipThreshold,
+			&file[offset], blocksWide * blockSize, decoded.data());
+
+		encodeSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		size_t texelCount = (size_t)width * height;
+		double psnr = 0.0;
+
+		if (report.format == BCFormat::BC5)
+			psnr = BCEncoder::ComputePSNR(surfaces[i].data(), decoded.data(), texelCount, 2);
+		else if (report.format == BCFormat::BC7)
+			psnr = BCEncoder::ComputePSNR(surfaces[i].data(), decoded.data(), texelCount, 4);
+		else
+			psnr = BCEncoder::ComputePSNR(surfaces[i].data(), decoded.data(), texelCount, 3, alphaClipThreshold);
+
+		report.psnr = std::min(report.psnr, psnr);
+
+		if (alphaClipThreshold >= 0.0f)
+			report.clipMismatches += BCEncoder::CountClipMismatches(surfaces[i].data(), decoded.data(), texelCount, alphaClipThreshold);
+	}
+
+	report.encodeMilliseconds = encodeSeconds * 1000.0;
+	report.outputBytes = file.size();
+
+	std::ofstream outputFile(outputPath, std::ios::binary);
+
+	if (!outputFile.is_open())
+		return Fail(report, "could not write " + outputPath);
+
+	outputFile.write(reinterpret_cast<const char*>(file.data()), (std::streamsize)file.size());
+
+	if (!outputFile.good())
+		return Fail(report, "could not write " + outputPath);
+
+	report.succeeded = true;
+
+	return true;
+}
+
+bool TextureCooker::CookScene(const std::string& scenePath, const std::string& textureDirectory, const std::string& outputDirectory,
+	const TextureCookSettings& sceneSettings, std::vector<TextureCookReport>& reports)
+{
+	reports.clear();
+
+	SceneDescription scene;
+
+	if (!SceneLoader::LoadSceneDescription(scenePath, scene))
+		return false;
+
+	// Objects share their textures, every texture is cooked once
+	std::vector<std::string> textureNames;
+	std::vector<TextureUsage> textureUsages;
+
+	auto addTexture = [&textureNames, &textureUsages](const std::string& name, TextureUsage usage)
+	{
+		if (std::find(textureNames.begin(), textureNames.end(), name) != textureNames.end())
+			return;
+
+		textureNames.push_back(name);
+		textureUsages.push_back(usage);
+	};
+
+	for (const SceneObject& sceneObject : scene.objects)
+	{
+		addTexture(sceneObject.diffuseOpacityTextureName, TextureUsage::DiffuseOpacity);
+		addTexture(sceneObject.normalRoughnessTextureName, TextureUsage::NormalRoughness);
+	}
+
+	reports.resize(textureNames.size());
+
+	// One texture per job, the block rows of each texture are spread over the pool again inside
+	ThreadPool::ParallelFor(textureNames.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			TextureCookSettings settings = sceneSettings;
+			settings.usage = textureUsages[i];
+
+			CookTexture(textureDirectory + "/" + textureNames[i] + ".dds", outputDirectory + "/" + textureNames[i] + ".dds",
+				settings, reports[i]);
+		}
+	});
+
+	for (const TextureCookReport& report : reports)
+	{
+		if (!report.succeeded)
+			return false;
+	}
+
+	return true;
+}
+
+BCFormat TextureCooker::ChooseFormat(const TextureCookSettings& settings, const std::vector<std::vector<uint8_t>>& surfaces)
+{
+	if (settings.overrideFormat)
+		return settings.format;
+
+	if (settings.usage == TextureUsage::NormalRoughness)
+		return BCFormat::BC7;
+
+	for (const std::vector<uint8_t>& surface : surfaces)
+	{
+		for (size_t i = 3; i < surface.size(); i += 4)
+		{
+			if (surface[i] > BinaryAlphaTolerance && surface[i] < 255 - BinaryAlphaTolerance)
+				return BCFormat::BC3;
+		}
+	}
+
+	return BCFormat::BC1;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "BCEncoder.h"
+#include "MipGenerator.h"
+
+// What a texture is sampled as, decides the block format and how quality is measured
+enum class TextureUsage
+{
+	DiffuseOpacity,
+	NormalRoughness
+};
+
+struct TextureCookSettings
+{
+	TextureUsage	usage = TextureUsage::DiffuseOpacity;
+
+	// Without an override diffuse textures use BC1 when their alpha is only on / off and BC3
+	// otherwise, normal + roughness textures use BC7 (BC5 drops the roughness)
+	bool			overrideFormat = false;
+	BCFormat		format = BCFormat::BC7;
+
+	// Replaces the mips of the input with a chain generated from its top level, see MipGenerator
+	bool			generateMips = false;
+};
+
+struct TextureCookReport
+{
+	std::string		inputPath;
+	std::string		outputPath;
+	bool			succeeded = false;
+	std::string		error;
+
+	BCFormat		format = BCFormat::BC7;
+	uint32_t		subresourceCount = 0;
+	size_t			inputBytes = 0;
+	size_t			outputBytes = 0;
+
+	// Worst subresource, over RGB for diffuse (clipped texels excluded), RG for BC5 and RGBA for BC7
+	double			psnr = 0.0;
+	// Texels that moved across the alpha clip threshold, zero unless something is wrong
+	size_t			clipMismatches = 0;
+	double			encodeMilliseconds = 0.0;
+
+	// With generated diffuse mips, per mip the largest difference of any array slice between the
+	// fraction of texels passing the alpha test and that of the top mip. Box filtered alone for comparison.
+	std::vector<double>	mipCoverageErrors;
+	std::vector<double>	filteredMipCoverageErrors;
+};
+
+// Offline conversion of the scene textures from RGBA8 / BGRA8 DDS files into block compressed DDS
+// files that DDSTextureLoader reads as they are. Every mip and array slice of the input is encoded.
+class TextureCooker
+{
+public:
+	TextureCooker() = default;
+	~TextureCooker() = default;
+
+	// Cooks a single file. Returns false and fills in report.error when it fails.
+	static bool CookTexture(const std::string&, const std::string&, const TextureCookSettings&, TextureCookReport&);
+
+	// Cooks the DiffuseOpacity and NormalRoughness textures of every object in a scene file, each
+	// texture once. Textures are named like the engine expects, <textures>/<name>.dds in and
+	// <output>/<name>.dds out. The usage in the settings is taken from the scene. Returns false if
+	// the scene could not be read or a texture failed.
+	static bool CookScene(const std::string&, const std::string&, const std::string&, const TextureCookSettings&,
+		std::vector<TextureCookReport>&);
+
+private:
+
+	static BCFormat ChooseFormat(const TextureCookSettings&, const std::vector<std::vector<uint8_t>>&);
+};
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "TextureUploadBatch.h"
+#include "DDSFormat.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	bool IsBlockCompressed(DXGI_FORMAT format)
+	{
+		return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM)
+			|| (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+	}
+
+	struct StagingCopy
+	{
+		const TextureUpload* upload;
+		const UploadFootprint* footprint;
+	};
+}
+
+uint32_t TextureUploadBatch::Add(const std::string& filePath)
+{
+	TextureUpload upload;
+	upload.filePath = filePath;
+	upload.image = std::make_unique<DDSImage>();
+
+	mUploads.push_back(std::move(upload));
+
+	return (uint32_t)mUploads.size() - 1;
+}
+
+void TextureUploadBatch::Clear()
+{
+	mUploads.clear();
+}
+
+bool TextureUploadBatch::Open(const std::function<uint32_t(const DDSDescription&)>& selectFirstMip)
+{
+	std::atomic<uint32_t> failedCount = { 0 };
+
+	// One file per job, opening and mapping a file is mostly waiting on the OS
+	ThreadPool::ParallelFor(mUploads.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			TextureUpload& upload = mUploads[i];
+
+			if (upload.isLoaded)
+				continue;
+
+			if (!upload.image->Load(upload.filePath))
+			{
+				++failedCount;
+				continue;
+			}
+
+			const DDSDescription& description = upload.image->GetDescription();
+
+			upload.firstMip = selectFirstMip ? std::min(selectFirstMip(description), description.mipCount - 1) : 0;
+			upload.stagingSize = ComputeLayout(*upload.image, upload.firstMip, description.mipCount, upload.footprints);
+			upload.isLoaded = true;
+		}
+	});
+
+	return failedCount == 0;
+}
+
+uint32_t TextureUploadBatch::Stage(StagingRing& ring, uint8_t* stagingData)
+{
+	std::vector<StagingCopy> copies;
+	uint32_t stagedCount = 0;
+
+	// The ring is only touched here, the copies below can then run anywhere in it
+	for (TextureUpload& upload : mUploads)
+	{
+		if (!upload.isLoaded || upload.isStaged)
+			continue;
+
+		if (!ring.Allocate(upload.stagingSize, PlacementAlignment, upload.stagingOffset))
+			continue;
+
+		upload.isStaged = true;
+		++stagedCount;
+
+		for (const UploadFootprint& footprint : upload.footprints)
+		{
+			StagingCopy copy;
+			copy.upload = &upload;
+			copy.footprint = &footprint;
+			copies.push_back(copy);
+		}
+	}
+
+	// One subresource per job, so a single large texture is spread over the workers as well
+	ThreadPool::ParallelFor(copies.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			CopyToStaging(*copies[i].upload->image, *copies[i].footprint, stagingData + copies[i].upload->stagingOffset);
+	});
+
+	return stagedCount;
+}
+
+uint64_t TextureUploadBatch::ComputeLayout(const DDSImage& image, uint32_t firstMip, uint32_t endMip, std::vector<UploadFootprint>& footprints)
+{
+	const DDSDescription& description = image.GetDescription();
+	bool isBlockCompressed = IsBlockCompressed(description.format);
+
+	footprints.clear();
+
+	uint64_t size = 0;
+
+	// Same order as the destination's subresources, every mip of a slice before the next slice
+	for (uint32_t arraySlice = 0; arraySlice < description.arraySize; ++arraySlice)
+	{
+		for (uint32_t mip = firstMip; mip < endMip; ++mip)
+		{
+			const DDSSubresource& subresource = image.GetSubresource(mip, arraySlice);
+
+			UploadFootprint footprint;
+			footprint.mip = mip;
+			footprint.arraySlice = arraySlice;
+			footprint.width = isBlockCompressed ? (uint32_t)AlignUp(subresource.width, 4) : subresource.width;
+			footprint.height = isBlockCompressed ? (uint32_t)AlignUp(subresource.height, 4) : subresource.height;
+			footprint.depth = subresource.depth;
+			footprint.rowSize = (uint32_t)subresource.rowPitch;
+			footprint.rowPitch = (uint32_t)AlignUp(subresource.rowPitch, RowPitchAlignment);
+			footprint.rowCount = (uint32_t)subresource.rowCount;
+			footprint.offset = AlignUp(size, PlacementAlignment);
+
+			size = footprint.offset + (uint64_t)footprint.rowPitch * footprint.rowCount * footprint.depth;
+
+			footprints.push_back(footprint);
+		}
+	}
+
+	return size;
+}
+
+void TextureUploadBatch::CopyToStaging(const DDSImage& image, const UploadFootprint& footprint, uint8_t* stagingData)
+{
+	const DDSSubresource& subresource = image.GetSubresource(footprint.mip, footprint.arraySlice);
+
+	uint8_t* destination = stagingData + footprint.offset;
+
+	for (uint32_t z = 0; z < footprint.depth; ++z)
+	{
+		const uint8_t* sourceSlice = subresource.data + z * subresource.slicePitch;
+		uint8_t* destinationSlice = destination + (uint64_t)z * footprint.rowPitch * footprint.rowCount;
+
+		// Tightly packed rows are copied in one go
+		if (footprint.rowPitch == footprint.rowSize)
+		{
+			memcpy(destinationSlice, sourceSlice, (size_t)footprint.rowSize * footprint.rowCount);
+			continue;
+		}
+
+		for (uint32_t row = 0; row < footprint.rowCount; ++row)
+			memcpy(destinationSlice + (uint64_t)row * footprint.rowPitch, sourceSlice + row * subresource.rowPitch, footprint.rowSize);
+	}
+}
\ No newline at end of file
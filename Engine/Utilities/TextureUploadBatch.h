@@ -0,0 +1,85 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DDSImage.h"
+#include "StagingRing.h"
+
+// Where one subresource of a texture goes in staging memory, laid out the way D3D12 copies from a
+// buffer expect it: rows at a 256 byte pitch and each subresource at a 512 byte aligned offset.
+struct UploadFootprint
+{
+	uint32_t	mip = 0;
+	uint32_t	arraySlice = 0;
+
+	// From the start of the texture's staging memory
+	uint64_t	offset = 0;
+
+	// Texels, rounded up to whole 4x4 blocks for block compressed formats
+	uint32_t	width = 0;
+	uint32_t	height = 0;
+	uint32_t	depth = 0;
+
+	uint32_t	rowPitch = 0;
+	uint32_t	rowCount = 0;
+	// Bytes of texel data in a row, the rest of the pitch is padding
+	uint32_t	rowSize = 0;
+};
+
+struct TextureUpload
+{
+	std::string						filePath;
+	std::unique_ptr<DDSImage>		image;
+
+	// Most detailed mip that is uploaded, the resource only holds it and the smaller ones
+	uint32_t						firstMip = 0;
+	std::vector<UploadFootprint>	footprints;
+	uint64_t						stagingSize = 0;
+	// Within the staging ring
+	uint64_t						stagingOffset = 0;
+
+	bool							isLoaded = false;
+	bool							isStaged = false;
+};
+
+// The CPU half of loading a set of DDS files, without any graphics API. The files are opened and
+// their staging layouts computed in parallel, then they are copied into one staging ring, also in
+// parallel, so the renderer only has to create the resources and record one copy per subresource.
+// The pages of a file are read from disk by the worker copying them out of the mapping.
+class TextureUploadBatch
+{
+public:
+	TextureUploadBatch() = default;
+	~TextureUploadBatch() = default;
+
+	static const uint64_t RowPitchAlignment = 256;
+	static const uint64_t PlacementAlignment = 512;
+
+	// Returns the index of the texture in the batch
+	uint32_t Add(const std::string&);
+	void Clear();
+
+	// Opens every file and computes its layout on the thread pool. The function picks the first mip
+	// to upload from the description, when empty every mip is uploaded. Returns false if any file
+	// failed to load, those are left with isLoaded false.
+	bool Open(const std::function<uint32_t(const DDSDescription&)>&);
+
+	// Allocates ring space for every loaded texture not staged yet, in order, and copies the ones
+	// that fit to the staging memory the ring manages, starting at the given address. Returns the
+	// number of textures staged by this call.
+	uint32_t Stage(StagingRing&, uint8_t*);
+
+	uint32_t GetCount() const { return (uint32_t)mUploads.size(); }
+	TextureUpload& GetUpload(uint32_t index) { return mUploads[index]; }
+
+	// Lays out the mips in [first, end) of every array slice. Returns the staging size.
+	static uint64_t ComputeLayout(const DDSImage&, uint32_t, uint32_t, std::vector<UploadFootprint>&);
+	// Copies one subresource from the image to staging memory laid out by ComputeLayout
+	static void CopyToStaging(const DDSImage&, const UploadFootprint&, uint8_t*);
+
+private:
+
+	std::vector<TextureUpload> mUploads;
+};
\ No newline at end of file
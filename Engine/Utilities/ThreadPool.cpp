@@ -0,0 +1,148 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+std::vector<std::thread> ThreadPool::mWorkers;
+std::deque<std::function<void()>> ThreadPool::mQueue;
+std::mutex ThreadPool::mQueueMutex;
+std::condition_variable ThreadPool::mQueueCondition;
+bool ThreadPool::bShuttingDown = false;
+
+void ThreadPool::Initialize(uint32_t workerCount)
+{
+	Shutdown();
+
+	if (workerCount == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = (hardwareThreads > 1) ? (hardwareThreads - 1) : 1;
+	}
+
+	bShuttingDown = false;
+
+	for (uint32_t i = 0; i < workerCount; ++i)
+		mWorkers.emplace_back(&ThreadPool::WorkerMain, i);
+}
+
+void ThreadPool::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mQueueMutex);
+		bShuttingDown = true;
+	}
+
+	mQueueCondition.notify_all();
+
+	// Workers drain the queue before they exit, so submitted jobs still run
+	for (std::thread& worker : mWorkers)
+		worker.join();
+
+	mWorkers.clear();
+}
+
+uint32_t ThreadPool::GetThreadCount()
+{
+	return (uint32_t)mWorkers.size() + 1;
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& function)
+{
+	if (count == 0)
+		return;
+
+	grainSize = std::max<size_t>(grainSize, 1);
+
+	if (mWorkers.empty() || count <= grainSize)
+	{
+		for (size_t begin = 0; begin < count; begin += grainSize)
+			function(begin, std::min(begin + grainSize, count));
+
+		return;
+	}
+
+	// Shared with the helpers, a helper that only gets to run after the loop finished still needs it
+	auto job = std::make_shared<ParallelForJob>();
+	job->function = function;
+	job->count = count;
+	job->grainSize = grainSize;
+	job->rangeCount = (count + grainSize - 1) / grainSize;
+
+	size_t helperCount = std::min<size_t>(mWorkers.size(), job->rangeCount - 1);
+
+	{
+		std::lock_guard<std::mutex> lock(mQueueMutex);
+
+		for (size_t i = 0; i < helperCount; ++i)
+			mQueue.push_back([job]() { RunRanges(*job); });
+	}
+
+	mQueueCondition.notify_all();
+
+	// The caller takes ranges as well, so nested loops make progress even when every worker is busy
+	RunRanges(*job);
+
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->completed.wait(lock, [&job]() { return job->completedRanges.load() == job->rangeCount; });
+}
+
+void ThreadPool::Submit(std::function<void()> function)
+{
+	if (mWorkers.empty())
+	{
+		function();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mQueueMutex);
+		mQueue.push_back(std::move(function));
+	}
+
+	mQueueCondition.notify_one();
+}
+
+void ThreadPool::WorkerMain(uint32_t workerIndex)
+{
+	Profiler::SetThreadName("Worker " + std::to_string(workerIndex));
+
+	for (;;)
+	{
+		std::function<void()> function;
+
+		{
+			std::unique_lock<std::mutex> lock(mQueueMutex);
+			mQueueCondition.wait(lock, []() { return bShuttingDown || !mQueue.empty(); });
+
+			if (mQueue.empty())
+				return;
+
+			function = std::move(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		function();
+	}
+}
+
+void ThreadPool::RunRanges(ParallelForJob& job)
+{
+	for (;;)
+	{
+		size_t range = job.nextRange.fetch_add(1);
+
+		if (range >= job.rangeCount)
+			return;
+
+		size_t begin = range * job.grainSize;
+		job.function(begin, std::min(begin + job.grainSize, job.count));
+
+		if (job.completedRanges.fetch_add(1) + 1 == job.rangeCount)
+		{
+			std::lock_guard<std::mutex> lock(job.mutex);
+			job.completed.notify_all();
+		}
+	}
+}
\ No newline at end of file
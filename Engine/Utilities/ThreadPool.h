@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by the CPU side systems (texture cooking, baking, streaming).
+// Until Initialize() is called every job simply runs on the calling thread.
+class ThreadPool
+{
+public:
+	ThreadPool() = default;
+	~ThreadPool() = default;
+
+	// Zero uses one worker per hardware thread, minus the calling thread.
+	static void Initialize(uint32_t workerCount = 0);
+	static void Shutdown();
+
+	// Workers plus the calling thread, i.e. how many ranges can run at once
+	static uint32_t GetThreadCount();
+
+	// Splits [0, count) into ranges of at most grainSize and runs them on the workers and the
+	// calling thread. Returns once every range is done. Safe to call from inside a job.
+	static void ParallelFor(size_t, size_t, const std::function<void(size_t, size_t)>&);
+
+	// Runs a job on a worker without waiting for it.
+	static void Submit(std::function<void()>);
+
+private:
+
+	struct ParallelForJob
+	{
+		std::function<void(size_t, size_t)> function;
+		size_t count;
+		size_t grainSize;
+		size_t rangeCount;
+		std::atomic<size_t> nextRange = { 0 };
+		std::atomic<size_t> completedRanges = { 0 };
+		std::mutex mutex;
+		std::condition_variable completed;
+	};
+
+	static void WorkerMain(uint32_t);
+	static void RunRanges(ParallelForJob&);
+
+	static std::vector<std::thread> mWorkers;
+	static std::deque<std::function<void()>> mQueue;
+	static std::mutex mQueueMutex;
+	static std::condition_variable mQueueCondition;
+	static bool bShuttingDown;
+};
\ No newline at end of file
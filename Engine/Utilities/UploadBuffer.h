@@ -31,6 +31,9 @@ public:
 
         ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
 
+        d3dUtil::TrackResource(device, mUploadBuffer.Get(),
+            isConstantBuffer ? MemoryCategory::ConstantBuffers : MemoryCategory::Staging);
+
         // We do not need to unmap until we are done with the resource.  However, we must not write to
         // the resource while it is in use by the GPU (so we must use synchronization techniques).
     }
@@ -42,6 +45,8 @@ public:
         if(mUploadBuffer != nullptr)
             mUploadBuffer->Unmap(0, nullptr);
 
+        MemoryTracker::Untrack(mUploadBuffer.Get());
+
         mMappedData = nullptr;
     }
 
@@ -0,0 +1,137 @@
+#include "UploadQueue.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+UploadTicket UploadQueue::Enqueue(uint64_t size, uint64_t alignment, std::function<void(uint8_t*)> write,
+	std::function<void(uint64_t)> record)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	Upload upload;
+	upload.ticket = mNextTicket++;
+	upload.size = size;
+	upload.alignment = alignment > 0 ? alignment : 1;
+	upload.write = std::move(write);
+	upload.record = std::move(record);
+
+	mWaitingUploads.push_back(std::move(upload));
+
+	UploadTicket ticket;
+	ticket.value = mWaitingUploads.back().ticket;
+
+	return ticket;
+}
+
+uint32_t UploadQueue::Pack(StagingRing& ring, uint8_t* stagingData)
+{
+	std::vector<Upload> packedUploads;
+	std::vector<uint64_t> offsets;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		// In request order, so tickets complete in order as well
+		while (!mWaitingUploads.empty())
+		{
+			Upload& upload = mWaitingUploads.front();
+			uint64_t offset = 0;
+
+			if (upload.size > 0 && !ring.Allocate(upload.size, upload.alignment, offset))
+				break;
+
+			packedUploads.push_back(std::move(upload));
+			offsets.push_back(offset);
+			mWaitingUploads.pop_front();
+		}
+
+		if (!packedUploads.empty())
+			mPackedTicket = packedUploads.back().ticket;
+	}
+
+	ThreadPool::ParallelFor(packedUploads.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (packedUploads[i].size > 0 && packedUploads[i].write)
+				packedUploads[i].write(stagingData + offsets[i]);
+		}
+	});
+
+	// Command lists are recorded by one thread
+	for (size_t i = 0; i < packedUploads.size(); ++i)
+	{
+		if (packedUploads[i].record)
+			packedUploads[i].record(offsets[i]);
+	}
+
+	return (uint32_t)packedUploads.size();
+}
+
+void UploadQueue::Submit(StagingRing& ring, uint64_t fence)
+{
+	ring.Retire(fence);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mPackedTicket == mSubmittedTicket)
+		return;
+
+	Submission submission;
+	submission.lastTicket = mPackedTicket;
+	submission.fence = fence;
+
+	mSubmissions.push_back(submission);
+	mSubmittedTicket = mPackedTicket;
+}
+
+void UploadQueue::Complete(StagingRing& ring, uint64_t completedFence)
+{
+	ring.Release(completedFence);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	while (!mSubmissions.empty() && mSubmissions.front().fence <= completedFence)
+	{
+		mCompletedTicket = mSubmissions.front().lastTicket;
+		mSubmissions.pop_front();
+	}
+}
+
+bool UploadQueue::IsComplete(UploadTicket ticket) const
+{
+	return ticket.value <= mCompletedTicket;
+}
+
+uint64_t UploadQueue::GetFence(UploadTicket ticket) const
+{
+	if (IsComplete(ticket))
+		return 0;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (const Submission& submission : mSubmissions)
+	{
+		if (ticket.value <= submission.lastTicket)
+			return submission.fence;
+	}
+
+	return UINT64_MAX;
+}
+
+uint32_t UploadQueue::GetWaitingCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	return (uint32_t)mWaitingUploads.size();
+}
+
+UploadTicket UploadQueue::GetLastTicket() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	UploadTicket ticket;
+	ticket.value = mNextTicket - 1;
+
+	return ticket;
+}
\ No newline at end of file
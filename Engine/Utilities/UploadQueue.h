@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "StagingRing.h"
+
+// Handed out for every upload. Tickets are numbered in the order the uploads were requested, zero
+// is the ticket of nothing and always complete.
+struct UploadTicket
+{
+	uint64_t	value = 0;
+};
+
+// The device independent half of an upload service. Uploads are requested from any thread with the
+// staging memory they need, a function writing their data into it and one recording their copy.
+// The submitting thread packs them into a staging ring, in request order, records them and submits
+// them with a fence. A ticket is complete once the fence of its submission is.
+class UploadQueue
+{
+public:
+	UploadQueue() = default;
+	~UploadQueue() = default;
+
+	// Staging bytes and alignment, the function writing the data to staging memory and the one
+	// recording the copy from the given staging offset. Uploads that need no staging memory (size
+	// zero) only record. Safe to call from any thread.
+	UploadTicket Enqueue(uint64_t, uint64_t, std::function<void(uint8_t*)>, std::function<void(uint64_t)>);
+
+	// Packs the waiting uploads into the ring until one doesn't fit, writes their data on the thread
+	// pool and records them in order. Returns the number packed, uploads larger than the ring are
+	// never packed and stay waiting.
+	uint32_t Pack(StagingRing&, uint8_t*);
+
+	// The uploads packed since the last call go out with the submission signalling the fence
+	void Submit(StagingRing&, uint64_t);
+	// Completes the tickets of the submissions up to the fence and frees their staging memory
+	void Complete(StagingRing&, uint64_t);
+
+	bool IsComplete(UploadTicket) const;
+	// Fence the ticket's submission signals. Zero when it is complete, UINT64_MAX when it wasn't submitted yet.
+	uint64_t GetFence(UploadTicket) const;
+
+	uint32_t GetWaitingCount() const;
+	UploadTicket GetLastTicket() const;
+
+private:
+
+	struct Upload
+	{
+		uint64_t ticket;
+		uint64_t size;
+		uint64_t alignment;
+		std::function<void(uint8_t*)> write;
+		std::function<void(uint64_t)> record;
+	};
+
+	struct Submission
+	{
+		uint64_t lastTicket;
+		uint64_t fence;
+	};
+
+	mutable std::mutex mMutex;
+	std::deque<Upload> mWaitingUploads;
+	std::deque<Submission> mSubmissions;
+
+	uint64_t mNextTicket = 1;
+	// Last ticket packed, submitted and completed
+	uint64_t mPackedTicket = 0;
+	uint64_t mSubmittedTicket = 0;
+	std::atomic<uint64_t> mCompletedTicket = { 0 };
+};
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "VoxelClipmap.h"
+
+#include <algorithm>
+#include <cmath>
+
+void VoxelClipmap::Reset(uint32_t levelCount, uint32_t resolution, float finestVoxelSize)
+{
+	mResolution = resolution;
+	mLevels.resize(levelCount);
+
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		mLevels[level].voxelSize = finestVoxelSize * (float)(1u << level);
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			mLevels[level].origin[axis] = 0;
+	}
+
+	bInitialized = false;
+}
+
+uint32_t VoxelClipmap::Update(const DirectX::XMFLOAT3& cameraPosition, std::vector<ClipmapRegion>& regions)
+{
+	const float position[3] = { cameraPosition.x, cameraPosition.y, cameraPosition.z };
+	const int32_t resolution = (int32_t)mResolution;
+	uint32_t dirtyVoxelCount = 0;
+
+	for (uint32_t level = 0; level < (uint32_t)mLevels.size(); ++level)
+	{
+		Level& clipmapLevel = mLevels[level];
+
+		// The origin moves a whole voxel at a time, so the voxels keep their place in the world
+		int32_t origin[3];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			origin[axis] = (int32_t)std::floor(position[axis] / clipmapLevel.voxelSize) - resolution / 2;
+
+		// The part of the new volume that was covered before shrinks axis by axis, so the slabs of the
+		// later axes leave out the ones of the earlier axes
+		int32_t keptBegin[3];
+		uint32_t keptSize[3];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			keptBegin[axis] = origin[axis];
+			keptSize[axis] = mResolution;
+		}
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const int32_t shift = bInitialized ? origin[axis] - clipmapLevel.origin[axis] : resolution;
+
+			if (shift == 0)
+				continue;
+
+			// Nothing of the rest was covered before
+			if (std::abs(shift) >= resolution)
+			{
+				AppendRegions(level, keptBegin, keptSize, regions);
+				keptSize[axis] = 0;
+				break;
+			}
+
+			int32_t slabBegin[3] = { keptBegin[0], keptBegin[1], keptBegin[2] };
+			uint32_t slabSize[3] = { keptSize[0], keptSize[1], keptSize[2] };
+
+			// Moving up scrolls in voxels at the top end, moving down at the bottom end
+			slabSize[axis] = (uint32_t)std::abs(shift);
+			slabBegin[axis] = shift > 0 ? origin[axis] + resolution - shift : origin[axis];
+
+			AppendRegions(level, slabBegin, slabSize, regions);
+
+			keptSize[axis] -= slabSize[axis];
+			keptBegin[axis] = shift > 0 ? origin[axis] : origin[axis] - shift;
+		}
+
+		dirtyVoxelCount += mResolution * mResolution * mResolution - keptSize[0] * keptSize[1] * keptSize[2];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			clipmapLevel.origin[axis] = origin[axis];
+	}
+
+	bInitialized = true;
+
+	return dirtyVoxelCount;
+}
+
+uint32_t VoxelClipmap::FindLevel(const DirectX::XMFLOAT3& worldPosition) const
+{
+	const float position[3] = { worldPosition.x, worldPosition.y, worldPosition.z };
+
+	for (uint32_t level = 0; level < (uint32_t)mLevels.size(); ++level)
+	{
+		const Level& clipmapLevel = mLevels[level];
+		bool inside = true;
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const float voxel = position[axis] / clipmapLevel.voxelSize - (float)clipmapLevel.origin[axis];
+			inside = inside && voxel >= 0.0f && voxel < (float)mResolution;
+		}
+
+		if (inside)
+			return level;
+	}
+
+	return (uint32_t)mLevels.size();
+}
+
+void VoxelClipmap::AppendRegions(uint32_t level, const int32_t* begin, const uint32_t* size, std::vector<ClipmapRegion>& regions) const
+{
+	// Per axis, the box is one range in the texture or two when it wraps around the edge
+	uint32_t rangeBegins[3][2];
+	uint32_t rangeSizes[3][2];
+	uint32_t rangeCounts[3];
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		if (size[axis] == 0)
+			return;
+
+		const uint32_t texelBegin = GetTexelCoordinate(begin[axis]);
+		const uint32_t firstSize = std::min(size[axis], mResolution - texelBegin);
+
+		rangeBegins[axis][0] = texelBegin;
+		rangeSizes[axis][0] = firstSize;
+		rangeBegins[axis][1] = 0;
+		rangeSizes[axis][1] = size[axis] - firstSize;
+		rangeCounts[axis] = rangeSizes[axis][1] != 0 ? 2 : 1;
+	}
+
+	for (uint32_t z = 0; z < rangeCounts[2]; ++z)
+	{
+		for (uint32_t y = 0; y < rangeCounts[1]; ++y)
+		{
+			for (uint32_t x = 0; x < rangeCounts[0]; ++x)
+			{
+				ClipmapRegion region;
+				region.level = level;
+				region.begin[0] = rangeBegins[0][x];
+				region.begin[1] = rangeBegins[1][y];
+				region.begin[2] = rangeBegins[2][z];
+				region.size[0] = rangeSizes[0][x];
+				region.size[1] = rangeSizes[1][y];
+				region.size[2] = rangeSizes[2][z];
+
+				regions.push_back(region);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A box of voxels of one clipmap level to initialize, in texel coordinates of the level's texture. It
+// never wraps around the texture's edges.
+struct ClipmapRegion
+{
+	uint32_t	level = 0;
+	uint32_t	begin[3] = {};
+	uint32_t	size[3] = {};
+};
+
+// Bookkeeping of nested voxel volumes centred on the camera, each with the same resolution and twice
+// the voxel size of the one inside it. A level covers the voxels from its origin, in units of its own
+// voxels, to the origin plus the resolution. The textures are addressed toroidally, a voxel lives at
+// its coordinate modulo the resolution, so when the camera moves the texels that kept their voxel stay
+// valid and only the slabs that scrolled in have to be initialized again.
+class VoxelClipmap
+{
+public:
+	VoxelClipmap() = default;
+	~VoxelClipmap() = default;
+
+	// Number of levels, resolution of every level and voxel size of the finest. Every level becomes
+	// dirty.
+	void Reset(uint32_t, uint32_t, float);
+
+	// Centres every level on the camera position. Appends the regions to initialize again and returns
+	// their number of voxels. A region never overlaps another one of the same update.
+	uint32_t Update(const DirectX::XMFLOAT3&, std::vector<ClipmapRegion>&);
+
+	uint32_t GetLevelCount() const { return (uint32_t)mLevels.size(); }
+	uint32_t GetResolution() const { return mResolution; }
+	float GetVoxelSize(uint32_t level) const { return mLevels[level].voxelSize; }
+	// In voxels of the level
+	const int32_t* GetOrigin(uint32_t level) const { return mLevels[level].origin; }
+	// Half the size of the volume a level covers
+	float GetHalfExtent(uint32_t level) const { return 0.5f * (float)mResolution * mLevels[level].voxelSize; }
+
+	// Where a voxel of a level lives in the level's texture
+	uint32_t GetTexelCoordinate(int32_t voxel) const
+	{
+		const int32_t wrapped = voxel % (int32_t)mResolution;
+		return (uint32_t)(wrapped < 0 ? wrapped + (int32_t)mResolution : wrapped);
+	}
+
+	// Finest level whose volume holds a position, the level count when none does
+	uint32_t FindLevel(const DirectX::XMFLOAT3&) const;
+
+	// Bytes of one RGBA8 texture per level
+	size_t GetMemoryBytes() const { return (size_t)mLevels.size() * mResolution * mResolution * mResolution * sizeof(uint32_t); }
+
+private:
+
+	struct Level
+	{
+		int32_t origin[3];
+		float voxelSize;
+	};
+
+	// Splits a box of voxels of a level into the boxes it covers in the texture
+	void AppendRegions(uint32_t, const int32_t*, const uint32_t*, std::vector<ClipmapRegion>&) const;
+
+	std::vector<Level> mLevels;
+	uint32_t mResolution = 0;
+	// Nothing is valid before the first update
+	bool bInitialized = false;
+};
\ No newline at end of file
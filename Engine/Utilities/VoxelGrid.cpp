@@ -0,0 +1,7 @@
+#include "VoxelGrid.h"
+
+void VoxelGrid::Reset(uint32_t resolution)
+{
+	mResolution = resolution;
+	mTexels.assign((size_t)resolution * resolution * resolution, 0);
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU copy of one of the RGBA8_UNORM 3D textures the voxel passes write to. Texels are packed the way
+// the GPU stores them, red in the lowest byte, and laid out x fastest, then y, then z.
+class VoxelGrid
+{
+public:
+	VoxelGrid() = default;
+	~VoxelGrid() = default;
+
+	// Resizes to the given resolution and clears every texel, which the shaders read as an empty voxel
+	void Reset(uint32_t);
+
+	uint32_t GetResolution() const { return mResolution; }
+	size_t GetTexelCount() const { return mTexels.size(); }
+	uint32_t GetIndex(uint32_t x, uint32_t y, uint32_t z) const { return (z * mResolution + y) * mResolution + x; }
+
+	uint32_t* GetTexels() { return mTexels.data(); }
+	const uint32_t* GetTexels() const { return mTexels.data(); }
+
+	// Rounds like a UNORM write: saturated, to nearest, NaN becomes zero
+	static uint32_t Pack(float red, float green, float blue, float alpha)
+	{
+		return ToUnorm8(red) | (ToUnorm8(green) << 8) | (ToUnorm8(blue) << 16) | (ToUnorm8(alpha) << 24);
+	}
+
+	static float Unpack(uint32_t texel, uint32_t channel)
+	{
+		return (float)((texel >> (channel * 8)) & 0xFF) * (1.0f / 255.0f);
+	}
+
+private:
+
+	static uint32_t ToUnorm8(float value)
+	{
+		if (!(value > 0.0f))
+			return 0;
+
+		if (value >= 1.0f)
+			return 255;
+
+		return (uint32_t)(value * 255.0f + 0.5f);
+	}
+
+	std::vector<uint32_t> mTexels;
+	uint32_t mResolution = 0;
+};
\ No newline at end of file
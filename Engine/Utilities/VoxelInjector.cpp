@@ -0,0 +1,484 @@
+#include "VoxelInjector.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	// The defines of VoxelInjection.hlsl
+	const float LumaThresholdFactor = 0.02f;
+	const float LumaDepthFactor = 100.0f;
+	const float LumaFactor = 1.9632107f;
+
+	// Rows per band, the height of a thread group. The dispatch only covers whole groups.
+	const uint32_t BandHeight = 16;
+	// Jobs per voxel mip, voxels are split between them by the low bits of their index
+	const uint32_t PartitionCount = 8;
+
+	float GetLuma(float red, float green)
+	{
+		return green * LumaFactor + red;
+	}
+
+	// The shader's float to uint conversion, negative and NaN become zero
+	uint32_t ToVoxelCoordinate(float value)
+	{
+		if (!(value > 0.0f))
+			return 0;
+
+		if (value >= 4294967040.0f)
+			return UINT32_MAX;
+
+		return (uint32_t)value;
+	}
+}
+
+const uint32_t VoxelInjector::MipCount;
+
+uint32_t VoxelInjector::Inject(const VoxelInjectionInput& input, VoxelGrid* grids, uint32_t mipCount)
+{
+	const uint32_t dispatchWidth = input.width / BandHeight * BandHeight;
+	const uint32_t bandCount = input.height / BandHeight;
+
+	if (dispatchWidth == 0 || bandCount == 0)
+		return 0;
+
+	const uint32_t bandsPerChunk = std::max(ThreadPool::GetThreadCount() * 4, 4u);
+	const uint32_t bucketsPerBand = mipCount * PartitionCount;
+
+	// Only a chunk of bands is buffered at a time, so the scratch memory doesn't grow with the resolution
+	mBuckets.resize(bandsPerChunk * bucketsPerBand);
+	mPixels.resize((size_t)bandsPerChunk * BandHeight * dispatchWidth);
+	mBandCounts.resize(bandsPerChunk);
+
+	uint32_t outcomeCounts[MipCount * PartitionCount][(uint32_t)Outcome::Count] = {};
+	BandCounts leftOut = {};
+
+	for (uint32_t firstBand = 0; firstBand < bandCount; firstBand += bandsPerChunk)
+	{
+		const uint32_t chunkBandCount = std::min(bandsPerChunk, bandCount - firstBand);
+
+		// Every band buckets its candidate writes in raster order
+		ThreadPool::ParallelFor(chunkBandCount, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t band = begin; band < end; ++band)
+			{
+				std::vector<Candidate>* buckets = &mBuckets[band * bucketsPerBand];
+				BandCounts& counts = mBandCounts[band];
+				counts = BandCounts();
+
+				for (uint32_t i = 0; i < bucketsPerBand; ++i)
+					buckets[i].clear();
+
+				for (uint32_t row = 0; row < BandHeight; ++row)
+				{
+					const uint32_t y = (firstBand + (uint32_t)band) * BandHeight + row;
+					const uint32_t firstPixel = ((uint32_t)band * BandHeight + row) * dispatchWidth;
+
+					for (uint32_t x = 0; x < dispatchWidth; ++x)
+					{
+						float encodedPosition[3];
+
+						if (!IsInTileMask(input, x, y))
+						{
+							++counts.masked;
+							continue;
+						}
+
+						if (!PreparePixel(input, x, y, encodedPosition, mPixels[firstPixel + x]))
+						{
+							++counts.background;
+							continue;
+						}
+
+						for (uint32_t mip = 0; mip < mipCount; ++mip)
+						{
+							uint32_t voxelIndex = 0;
+
+							if (GetVoxelIndex(encodedPosition, grids[mip].GetResolution(), voxelIndex))
+								buckets[mip * PartitionCount + voxelIndex % PartitionCount].push_back({ voxelIndex, firstPixel + x });
+							else
+								++counts.outsideVolume[mip];
+						}
+					}
+				}
+			}
+		});
+
+		// A voxel only ever lands in one bucket of a band, so the jobs never touch the same texel. Going
+		// through the bands in order keeps the raster order per voxel.
+		ThreadPool::ParallelFor(bucketsPerBand, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t bucket = begin; bucket < end; ++bucket)
+			{
+				uint32_t* texels = grids[bucket / PartitionCount].GetTexels();
+				uint32_t* counts = outcomeCounts[bucket];
+
+				for (uint32_t band = 0; band < chunkBandCount; ++band)
+				{
+					for (const Candidate& candidate : mBuckets[band * bucketsPerBand + bucket])
+					{
+						const PixelInjection& pixel = mPixels[candidate.pixelIndex];
+						uint32_t& texel = texels[candidate.voxelIndex];
+						const Outcome outcome = Test(texel, pixel);
+
+						++counts[(uint32_t)outcome];
+
+						if (outcome <= Outcome::WrittenNearer)
+							texel = pixel.value;
+					}
+				}
+			}
+		});
+
+		for (uint32_t band = 0; band < chunkBandCount; ++band)
+		{
+			leftOut.masked += mBandCounts[band].masked;
+			leftOut.background += mBandCounts[band].background;
+
+			for (uint32_t mip = 0; mip < mipCount; ++mip)
+				leftOut.outsideVolume[mip] += mBandCounts[band].outsideVolume[mip];
+		}
+	}
+
+	uint32_t totalWriteCount = 0;
+
+	for (uint32_t bucket = 0; bucket < bucketsPerBand; ++bucket)
+		totalWriteCount += outcomeCounts[bucket][(uint32_t)Outcome::WrittenEmpty] + outcomeCounts[bucket][(uint32_t)Outcome::WrittenNearer];
+
+	if (input.statistics != nullptr)
+	{
+		VoxelInjectionStatistics statistics;
+		statistics.pixels = (uint64_t)dispatchWidth * bandCount * BandHeight;
+		statistics.maskedPixels = leftOut.masked;
+		statistics.backgroundPixels = leftOut.background;
+
+		for (uint32_t mip = 0; mip < mipCount; ++mip)
+		{
+			statistics.outsideVolume[mip] = leftOut.outsideVolume[mip];
+
+			for (uint32_t partition = 0; partition < PartitionCount; ++partition)
+			{
+				const uint32_t* counts = outcomeCounts[mip * PartitionCount + partition];
+
+				statistics.writtenEmpty[mip] += counts[(uint32_t)Outcome::WrittenEmpty];
+				statistics.writtenNearer[mip] += counts[(uint32_t)Outcome::WrittenNearer];
+				statistics.rejectedFarther[mip] += counts[(uint32_t)Outcome::RejectedFarther];
+				statistics.rejectedDarker[mip] += counts[(uint32_t)Outcome::RejectedDarker];
+			}
+		}
+
+		input.statistics->Add(statistics);
+	}
+
+	return totalWriteCount;
+}
+
+uint32_t VoxelInjector::InjectSerial(const VoxelInjectionInput& input, VoxelGrid* grids, uint32_t mipCount)
+{
+	const uint32_t dispatchWidth = input.width / BandHeight * BandHeight;
+	const uint32_t dispatchHeight = input.height / BandHeight * BandHeight;
+
+	VoxelInjectionStatistics statistics;
+	statistics.pixels = (uint64_t)dispatchWidth * dispatchHeight;
+
+	for (uint32_t y = 0; y < dispatchHeight; ++y)
+	{
+		for (uint32_t x = 0; x < dispatchWidth; ++x)
+		{
+			float encodedPosition[3];
+			PixelInjection pixel;
+
+			if (!IsInTileMask(input, x, y))
+			{
+				++statistics.maskedPixels;
+				continue;
+			}
+
+			if (!PreparePixel(input, x, y, encodedPosition, pixel))
+			{
+				++statistics.backgroundPixels;
+				continue;
+			}
+
+			for (uint32_t mip = 0; mip < mipCount; ++mip)
+			{
+				uint32_t voxelIndex = 0;
+
+				if (!GetVoxelIndex(encodedPosition, grids[mip].GetResolution(), voxelIndex))
+				{
+					++statistics.outsideVolume[mip];
+					continue;
+				}
+
+				uint32_t& texel = grids[mip].GetTexels()[voxelIndex];
+
+				switch (Test(texel, pixel))
+				{
+				case Outcome::WrittenEmpty:
+					++statistics.writtenEmpty[mip];
+					texel = pixel.value;
+					break;
+				case Outcome::WrittenNearer:
+					++statistics.writtenNearer[mip];
+					texel = pixel.value;
+					break;
+				case Outcome::RejectedFarther:
+					++statistics.rejectedFarther[mip];
+					break;
+				default:
+					++statistics.rejectedDarker[mip];
+					break;
+				}
+			}
+		}
+	}
+
+	uint64_t writeCount = 0;
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+		writeCount += statistics.writtenEmpty[mip] + statistics.writtenNearer[mip];
+
+	if (input.statistics != nullptr)
+		input.statistics->Add(statistics);
+
+	return (uint32_t)writeCount;
+}
+
+uint32_t VoxelInjector::InjectPacked(const VoxelInjectionInput& input, PackedVoxelGrid& grid)
+{
+	const uint32_t bandCount = input.height / BandHeight;
+
+	if (input.width / BandHeight == 0 || bandCount == 0)
+		return 0;
+
+	mBandCounts.resize(bandCount);
+	mPackedBandCounts.resize(bandCount);
+
+	// The bands write the grid concurrently, as the shader's thread groups do
+	ThreadPool::ParallelFor(bandCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t band = begin; band < end; ++band)
+		{
+			mBandCounts[band] = BandCounts();
+			mPackedBandCounts[band] = PackedBandCounts();
+
+			InjectPackedBand(input, grid, (uint32_t)band, mBandCounts[band], mPackedBandCounts[band]);
+		}
+	});
+
+	BandCounts leftOut = {};
+	PackedBandCounts counts = {};
+
+	for (uint32_t band = 0; band < bandCount; ++band)
+	{
+		leftOut.masked += mBandCounts[band].masked;
+		leftOut.background += mBandCounts[band].background;
+		leftOut.outsideVolume[0] += mBandCounts[band].outsideVolume[0];
+
+		counts.writtenEmpty += mPackedBandCounts[band].writtenEmpty;
+		counts.writtenNearer += mPackedBandCounts[band].writtenNearer;
+		counts.rejectedFarther += mPackedBandCounts[band].rejectedFarther;
+		counts.lostExchanges += mPackedBandCounts[band].lostExchanges;
+	}
+
+	AddPackedStatistics(input, leftOut, counts);
+
+	return counts.writtenEmpty + counts.writtenNearer;
+}
+
+uint32_t VoxelInjector::InjectPackedSerial(const VoxelInjectionInput& input, PackedVoxelGrid& grid)
+{
+	const uint32_t bandCount = input.height / BandHeight;
+
+	BandCounts leftOut = {};
+	PackedBandCounts counts = {};
+
+	for (uint32_t band = 0; band < bandCount; ++band)
+		InjectPackedBand(input, grid, band, leftOut, counts);
+
+	AddPackedStatistics(input, leftOut, counts);
+
+	return counts.writtenEmpty + counts.writtenNearer;
+}
+
+bool VoxelInjector::IsInTileMask(const VoxelInjectionInput& input, uint32_t x, uint32_t y)
+{
+	return input.tileMask == nullptr || input.tileMask[(y / BandHeight) * (input.width / BandHeight) + x / BandHeight] != 0;
+}
+
+bool VoxelInjector::PreparePixel(const VoxelInjectionInput& input, uint32_t x, uint32_t y, float* encodedPosition, PixelInjection& pixel)
+{
+	float viewDepth = 0.0f;
+
+	if (!GetPixelPosition(input, x, y, encodedPosition, viewDepth))
+		return false;
+
+	const size_t pixelIndex = (size_t)y * input.width + x;
+	const float depth = input.depth[pixelIndex];
+	const DirectX::XMFLOAT4& lighting = input.lighting[pixelIndex];
+
+	pixel.value = VoxelGrid::Pack(lighting.x, lighting.y, lighting.z, depth);
+	pixel.depth = depth;
+	pixel.luma = GetLuma(lighting.x, lighting.y);
+	pixel.lumaThreshold = LumaThresholdFactor * (1.0f / std::max(depth * LumaDepthFactor, 0.1f));
+
+	return true;
+}
+
+bool VoxelInjector::GetPixelPosition(const VoxelInjectionInput& input, uint32_t x, uint32_t y, float* encodedPosition, float& viewDepth)
+{
+	const float depth = input.depth[(size_t)y * input.width + x];
+
+	if (depth <= 0.1f)
+		return false;
+
+	// World position, with the shader's mapping of depth and pixel to clip space
+	const float clipPosition[4] =
+	{
+		(float)x * (1.0f / (float)input.width) * 2.0f - 1.0f,
+		(float)y * (1.0f / (float)input.height) * 2.0f - 1.0f,
+		depth * 2.0f - 1.0f,
+		1.0f
+	};
+
+	float viewPosition[4];
+
+	for (uint32_t column = 0; column < 4; ++column)
+	{
+		viewPosition[column] = clipPosition[0] * input.invProj.m[0][column] + clipPosition[1] * input.invProj.m[1][column]
+			+ clipPosition[2] * input.invProj.m[2][column] + clipPosition[3] * input.invProj.m[3][column];
+	}
+
+	const float w = viewPosition[3];
+
+	for (uint32_t column = 0; column < 4; ++column)
+		viewPosition[column] /= w;
+
+	for (uint32_t column = 0; column < 3; ++column)
+	{
+		const float worldPosition = viewPosition[0] * input.invView.m[0][column] + viewPosition[1] * input.invView.m[1][column]
+			+ viewPosition[2] * input.invView.m[2][column] + viewPosition[3] * input.invView.m[3][column];
+
+		encodedPosition[column] = (worldPosition / input.worldBoundary + 1.0f) * 0.5f;
+	}
+
+	viewDepth = viewPosition[2];
+
+	return true;
+}
+
+bool VoxelInjector::GetVoxelIndex(const float* encodedPosition, uint32_t resolution, uint32_t& voxelIndex)
+{
+	const uint32_t x = ToVoxelCoordinate(encodedPosition[0] * (float)resolution);
+	const uint32_t y = ToVoxelCoordinate(encodedPosition[1] * (float)resolution);
+	const uint32_t z = ToVoxelCoordinate(encodedPosition[2] * (float)resolution);
+
+	// Out of bounds UAV writes are dropped
+	if (x >= resolution || y >= resolution || z >= resolution)
+		return false;
+
+	voxelIndex = (z * resolution + y) * resolution + x;
+
+	return true;
+}
+
+VoxelInjector::Outcome VoxelInjector::Test(uint32_t texel, const PixelInjection& pixel)
+{
+	if ((texel >> 24) == 0)
+		return Outcome::WrittenEmpty;
+
+	const float voxelDepth = VoxelGrid::Unpack(texel, 3);
+
+	if (!(pixel.depth < voxelDepth))
+		return Outcome::RejectedFarther;
+
+	const float voxelLuma = GetLuma(VoxelGrid::Unpack(texel, 0), VoxelGrid::Unpack(texel, 1));
+	const float lumaDifference = std::min(std::max(voxelLuma - pixel.luma, 0.0f), 1.0f);
+
+	return lumaDifference < pixel.lumaThreshold ? Outcome::WrittenNearer : Outcome::RejectedDarker;
+}
+
+void VoxelInjector::InjectPackedBand(const VoxelInjectionInput& input, PackedVoxelGrid& grid, uint32_t band, BandCounts& leftOut,
+	PackedBandCounts& counts)
+{
+	const uint32_t dispatchWidth = input.width / BandHeight * BandHeight;
+
+	// The far plane is at a clip space depth of one
+	const DirectX::XMFLOAT4X4& invProj = input.invProj;
+	const float inverseFarDepth = (invProj.m[2][3] + invProj.m[3][3]) / (invProj.m[2][2] + invProj.m[3][2]);
+
+	for (uint32_t y = band * BandHeight; y < (band + 1) * BandHeight; ++y)
+	{
+		for (uint32_t x = 0; x < dispatchWidth; ++x)
+		{
+			float encodedPosition[3];
+			float viewDepth = 0.0f;
+			uint32_t voxelIndex = 0;
+
+			if (!IsInTileMask(input, x, y))
+			{
+				++leftOut.masked;
+				continue;
+			}
+
+			if (!GetPixelPosition(input, x, y, encodedPosition, viewDepth))
+			{
+				++leftOut.background;
+				continue;
+			}
+
+			if (!GetVoxelIndex(encodedPosition, grid.GetResolution(), voxelIndex))
+			{
+				++leftOut.outsideVolume[0];
+				continue;
+			}
+
+			const DirectX::XMFLOAT4& lighting = input.lighting[(size_t)y * input.width + x];
+			const uint32_t value = PackedVoxelGrid::Encode(lighting.x, lighting.y, lighting.z, viewDepth * inverseFarDepth);
+			const uint32_t previous = grid.Max(voxelIndex, value, counts.lostExchanges);
+
+			if (previous == 0)
+				++counts.writtenEmpty;
+			else if (previous < value)
+				++counts.writtenNearer;
+			else
+				++counts.rejectedFarther;
+		}
+	}
+}
+
+void VoxelInjector::AddPackedStatistics(const VoxelInjectionInput& input, const BandCounts& leftOut, const PackedBandCounts& counts)
+{
+	if (input.statistics == nullptr)
+		return;
+
+	VoxelInjectionStatistics statistics;
+	statistics.pixels = (uint64_t)(input.width / BandHeight * BandHeight) * (input.height / BandHeight * BandHeight);
+	statistics.maskedPixels = leftOut.masked;
+	statistics.backgroundPixels = leftOut.background;
+	statistics.outsideVolume[0] = leftOut.outsideVolume[0];
+	statistics.writtenEmpty[0] = counts.writtenEmpty;
+	statistics.writtenNearer[0] = counts.writtenNearer;
+	statistics.rejectedFarther[0] = counts.rejectedFarther;
+	statistics.lostExchanges = counts.lostExchanges;
+
+	input.statistics->Add(statistics);
+}
+
+void VoxelInjectionStatistics::Add(const VoxelInjectionStatistics& other)
+{
+	pixels += other.pixels;
+	maskedPixels += other.maskedPixels;
+	backgroundPixels += other.backgroundPixels;
+	lostExchanges += other.lostExchanges;
+
+	for (uint32_t mip = 0; mip < VoxelInjector::MipCount; ++mip)
+	{
+		outsideVolume[mip] += other.outsideVolume[mip];
+		writtenEmpty[mip] += other.writtenEmpty[mip];
+		writtenNearer[mip] += other.writtenNearer[mip];
+		rejectedFarther[mip] += other.rejectedFarther[mip];
+		rejectedDarker[mip] += other.rejectedDarker[mip];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "PackedVoxelGrid.h"
+#include "VoxelGrid.h"
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+struct VoxelInjectionStatistics;
+
+// What VoxelInjection.hlsl reads for one frame
+struct VoxelInjectionInput
+{
+	const DirectX::XMFLOAT4*	lighting = nullptr;		// Row major, width * height pixels
+	const float*				depth = nullptr;
+	uint32_t					width = 0;
+	uint32_t					height = 0;
+
+	// Not transposed, as the camera keeps them
+	DirectX::XMFLOAT4X4			invView;
+	DirectX::XMFLOAT4X4			invProj;
+
+	float						worldBoundary = 50.0f;
+
+	// A byte per 16x16 tile, row by row, nonzero for the tiles to inject as InjectionChangeDetector
+	// picks them. Null injects every tile.
+	const uint8_t*				tileMask = nullptr;
+
+	// Added to with what happened to the pixels, null counts nothing
+	VoxelInjectionStatistics*	statistics = nullptr;
+};
+
+// CPU port of VoxelInjection.hlsl, so progressive voxelization can be checked and profiled without a
+// GPU. Takes the grids of the voxel mips, the first one at full resolution and every next one at half
+// the previous one, and the number of mips to inject into, and returns how many texels were written.
+// The shader only injects into the finest mip, VoxelMipBuilder downsamples the others. Injecting into
+// every mip is what it did before.
+//
+// Inject() is the shader's former read, test and write of the RGBA8 grid, with its luma test. On the
+// GPU, pixels landing in the same voxel raced and the result depended on the scheduling. Here every
+// voxel sees its pixels in raster order, as if the dispatch ran one thread at a time, so the result is
+// the same on any number of threads. Rows are split into bands whose candidate writes are bucketed per
+// voxel mip and partition in parallel, then each bucket's writes are applied in band order.
+//
+// InjectPacked() is what the shader does now: an atomic max into a PackedVoxelGrid, which leaves the
+// nearest pixel of every voxel whatever the order. Bands are injected in parallel straight into the
+// grid. The grid is the same on any number of threads, only the counts of writes and lost exchanges
+// depend on the order. Injected into a grid an earlier frame filled, it only keeps the larger texels.
+class VoxelInjector
+{
+public:
+	VoxelInjector() = default;
+	~VoxelInjector() = default;
+
+	static const uint32_t MipCount = 5;
+
+	// Runs on the thread pool
+	uint32_t Inject(const VoxelInjectionInput&, VoxelGrid*, uint32_t);
+
+	// One pixel at a time in raster order on the calling thread, the reference Inject() matches
+	static uint32_t InjectSerial(const VoxelInjectionInput&, VoxelGrid*, uint32_t);
+
+	// Into the finest mip only, as the shader, on the thread pool
+	uint32_t InjectPacked(const VoxelInjectionInput&, PackedVoxelGrid&);
+	// One pixel at a time in raster order on the calling thread
+	static uint32_t InjectPackedSerial(const VoxelInjectionInput&, PackedVoxelGrid&);
+
+private:
+
+	// A pixel's value and acceptance test, the same for every voxel mip
+	struct PixelInjection
+	{
+		uint32_t value;
+		float depth;
+		float luma;
+		float lumaThreshold;
+	};
+
+	struct Candidate
+	{
+		uint32_t voxelIndex;
+		uint32_t pixelIndex;
+	};
+
+	// The shader's test of a pixel against a voxel, the first two write it
+	enum class Outcome
+	{
+		WrittenEmpty,
+		WrittenNearer,
+		RejectedFarther,
+		RejectedDarker,
+		Count
+	};
+
+	// Pixels of a band that never reached a voxel
+	struct BandCounts
+	{
+		uint32_t masked;
+		uint32_t background;
+		uint32_t outsideVolume[MipCount];
+	};
+
+	// What InjectPacked()'s band did with the pixels that reached a voxel
+	struct PackedBandCounts
+	{
+		uint32_t writtenEmpty;
+		uint32_t writtenNearer;
+		uint32_t rejectedFarther;
+		uint32_t lostExchanges;
+	};
+
+	// The pixel is in a tile the dispatch covers
+	static bool IsInTileMask(const VoxelInjectionInput&, uint32_t, uint32_t);
+	// Returns false for the pixels the shader skips, otherwise their position in [0..1] of the volume
+	// and what the ordered test compares
+	static bool PreparePixel(const VoxelInjectionInput&, uint32_t, uint32_t, float*, PixelInjection&);
+	// The same position and the view depth InjectPacked() orders by
+	static bool GetPixelPosition(const VoxelInjectionInput&, uint32_t, uint32_t, float*, float&);
+	// Returns false when the position is outside a grid of the given resolution
+	static bool GetVoxelIndex(const float*, uint32_t, uint32_t&);
+	// The shader's test: empty voxels are always written, others when nearer and not much darker
+	static Outcome Test(uint32_t, const PixelInjection&);
+	// Injects a band of rows into the packed grid, counting into the band counts
+	static void InjectPackedBand(const VoxelInjectionInput&, PackedVoxelGrid&, uint32_t, BandCounts&, PackedBandCounts&);
+	static void AddPackedStatistics(const VoxelInjectionInput&, const BandCounts&, const PackedBandCounts&);
+
+	// Per band of the current chunk of rows, voxel mip and partition
+	std::vector<std::vector<Candidate>> mBuckets;
+	std::vector<PixelInjection> mPixels;
+	std::vector<BandCounts> mBandCounts;
+	std::vector<PackedBandCounts> mPackedBandCounts;
+};
+
+// What happened to the pixels of injections, to tune the shader's acceptance test. Every pixel the
+// dispatch covers is masked, background or tested against a voxel of each mip it was injected into.
+struct VoxelInjectionStatistics
+{
+	uint64_t pixels = 0;
+	// Outside InjectionChangeDetector's tiles
+	uint64_t maskedPixels = 0;
+	// Without depth, the sky
+	uint64_t backgroundPixels = 0;
+
+	// Per voxel mip, the pixels beyond the volume and the tests of the others
+	uint64_t outsideVolume[VoxelInjector::MipCount] = {};
+	uint64_t writtenEmpty[VoxelInjector::MipCount] = {};
+	uint64_t writtenNearer[VoxelInjector::MipCount] = {};
+	// The voxel is nearer, or the pixel is nearer but darker by more than the luma threshold. Packed,
+	// a voxel as near with a color at least as large also rejects the pixel as farther.
+	uint64_t rejectedFarther[VoxelInjector::MipCount] = {};
+	uint64_t rejectedDarker[VoxelInjector::MipCount] = {};
+
+	// Compare exchanges of InjectPacked() another thread's write to the voxel made fail and retry
+	uint64_t lostExchanges = 0;
+
+	void Add(const VoxelInjectionStatistics&);
+};
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "VoxelMipBuilder.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	// The eight voxels a coarse voxel covers, child x + 2y + 4z, as color premultiplied by occupancy
+	// and occupancy
+	void LoadChildren(const VoxelGrid& source, uint32_t x, uint32_t y, uint32_t z, bool finest, float (*children)[4])
+	{
+		for (uint32_t child = 0; child < 8; ++child)
+		{
+			const uint32_t texel = source.GetTexels()[source.GetIndex(x * 2 + (child & 1), y * 2 + ((child >> 1) & 1), z * 2 + (child >> 2))];
+			const float occupancy = finest ? ((texel >> 24) != 0 ? 1.0f : 0.0f) : VoxelGrid::Unpack(texel, 3);
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				children[child][channel] = VoxelGrid::Unpack(texel, channel) * occupancy;
+
+			children[child][3] = occupancy;
+		}
+	}
+
+	// Back to the color the cone tracing reads, empty stays zero
+	uint32_t PackPremultiplied(const float* color, float occupancy)
+	{
+		if (occupancy == 0.0f)
+			return 0;
+
+		return VoxelGrid::Pack(color[0] / occupancy, color[1] / occupancy, color[2] / occupancy, occupancy);
+	}
+
+	// Blends the two children of each column along a direction front to back, and averages the columns
+	uint32_t ReduceDirection(const float (*children)[4], uint32_t direction)
+	{
+		const uint32_t axisBit = 1u << (direction / 2);
+		// Moving towards positive coordinates, the child at the lower one is in front
+		const uint32_t frontBit = direction % 2 == 0 ? 0 : axisBit;
+
+		float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		for (uint32_t child = 0; child < 8; ++child)
+		{
+			if ((child & axisBit) != frontBit)
+				continue;
+
+			const float* front = children[child];
+			const float* back = children[child ^ axisBit];
+			const float transmittance = 1.0f - front[3];
+
+			for (uint32_t channel = 0; channel < 4; ++channel)
+				sum[channel] += front[channel] + transmittance * back[channel];
+		}
+
+		const float color[3] = { sum[0] * 0.25f, sum[1] * 0.25f, sum[2] * 0.25f };
+		return PackPremultiplied(color, sum[3] * 0.25f);
+	}
+}
+
+void VoxelMipBuilder::BuildMips(VoxelGrid* grids, uint32_t mipCount)
+{
+	for (uint32_t mip = 1; mip < mipCount; ++mip)
+		Reduce(grids[mip - 1], grids[mip], mip == 1);
+}
+
+void VoxelMipBuilder::Reduce(const VoxelGrid& source, VoxelGrid& destination, bool finest)
+{
+	const uint32_t resolution = source.GetResolution() / 2;
+
+	if (destination.GetResolution() != resolution)
+		destination.Reset(resolution);
+
+	ThreadPool::ParallelFor(resolution, 1, [&source, &destination, resolution, finest](size_t begin, size_t end)
+	{
+		for (uint32_t z = (uint32_t)begin; z < (uint32_t)end; ++z)
+		{
+			for (uint32_t y = 0; y < resolution; ++y)
+			{
+				for (uint32_t x = 0; x < resolution; ++x)
+				{
+					float children[8][4];
+					LoadChildren(source, x, y, z, finest, children);
+
+					float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+					uint32_t occupiedChildren = 0;
+
+					for (uint32_t child = 0; child < 8; ++child)
+					{
+						for (uint32_t channel = 0; channel < 4; ++channel)
+							sum[channel] += children[child][channel];
+
+						occupiedChildren += children[child][3] > 0.0f ? 1 : 0;
+					}
+
+					// Alpha counts the occupied children rather than averaging their alpha, so a single
+					// occupied voxel of the finest grid is still 1/8 four mips up instead of vanishing
+					// under the RGBA8 precision
+					destination.GetTexels()[destination.GetIndex(x, y, z)] = sum[3] > 0.0f
+						? VoxelGrid::Pack(sum[0] / sum[3], sum[1] / sum[3], sum[2] / sum[3], (float)occupiedChildren * 0.125f) : 0;
+				}
+			}
+		}
+	});
+}
+
+void VoxelMipBuilder::BuildAnisotropicMips(const VoxelGrid& finest, VoxelGrid* directionalGrids, uint32_t mipCount)
+{
+	for (uint32_t mip = 1; mip < mipCount; ++mip)
+	{
+		const uint32_t resolution = finest.GetResolution() >> mip;
+		VoxelGrid* destinations = &directionalGrids[(mip - 1) * DirectionCount];
+		const VoxelGrid* sources = mip > 1 ? &directionalGrids[(mip - 2) * DirectionCount] : nullptr;
+
+		for (uint32_t direction = 0; direction < DirectionCount; ++direction)
+		{
+			if (destinations[direction].GetResolution() != resolution)
+				destinations[direction].Reset(resolution);
+		}
+
+		ThreadPool::ParallelFor(resolution, 1, [&finest, destinations, sources, resolution](size_t begin, size_t end)
+		{
+			for (uint32_t z = (uint32_t)begin; z < (uint32_t)end; ++z)
+			{
+				for (uint32_t y = 0; y < resolution; ++y)
+				{
+					for (uint32_t x = 0; x < resolution; ++x)
+					{
+						float children[8][4];
+
+						// The first mip reads the finest grid once for every direction, the next ones
+						// reduce the grid of the same direction
+						if (sources == nullptr)
+							LoadChildren(finest, x, y, z, true, children);
+
+						for (uint32_t direction = 0; direction < DirectionCount; ++direction)
+						{
+							if (sources != nullptr)
+								LoadChildren(sources[direction], x, y, z, false, children);
+
+							destinations[direction].GetTexels()[destinations[direction].GetIndex(x, y, z)] = ReduceDirection(children, direction);
+						}
+					}
+				}
+			}
+		});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "VoxelGrid.h"
+
+#include <cstdint>
+
+// Builds the coarser voxel mips from the finest one, so a coarse voxel is the filtered average of
+// the voxels it covers rather than whichever pixel last won the injection's test. Each voxel of a
+// mip reduces the 2x2x2 voxels below it: its alpha is the fraction of them that are occupied and its
+// color their average weighted by their alpha. Slices of a mip are reduced in parallel.
+//
+// The finest grid's alpha only tells occupied voxels apart, the injection stores depth in it.
+class VoxelMipBuilder
+{
+public:
+	VoxelMipBuilder() = default;
+	~VoxelMipBuilder() = default;
+
+	// Directions a cone can travel along, in the order of the directional grids
+	enum Direction
+	{
+		PositiveX, NegativeX, PositiveY, NegativeY, PositiveZ, NegativeZ, DirectionCount
+	};
+
+	// Fills mips 1 up to the count from mip 0, resizing them
+	static void BuildMips(VoxelGrid*, uint32_t);
+
+	// Fills a grid of half the resolution, resizing it. True when the source is the finest grid.
+	static void Reduce(const VoxelGrid&, VoxelGrid&, bool);
+
+	// Anisotropic mips from the finest grid and the number of mips including it. Every coarser mip
+	// gets one grid per direction, at (mip - 1) * DirectionCount + direction. Along a direction, the
+	// two voxels of each of the four columns are blended front to back before the columns are
+	// averaged, so a voxel hidden behind an opaque one doesn't show through.
+	static void BuildAnisotropicMips(const VoxelGrid&, VoxelGrid*, uint32_t);
+};
\ No newline at end of file
@@ -0,0 +1,427 @@
+#include "Voxelizer.h"
+#include "ThreadPool.h"
+#include "VoxelMipBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// a * u + b * v + c >= 0 for every box whose projection touches the triangle's side of an edge
+	struct EdgeFunction
+	{
+		float a;
+		float b;
+		float c;
+	};
+
+	// Edge of a triangle projected onto the uv plane, starting at the given vertex. The sign of the
+	// normal's third component keeps the functions positive inside the triangle.
+	EdgeFunction MakeEdgeFunction(float edgeU, float edgeV, float vertexU, float vertexV, float sign)
+	{
+		EdgeFunction edgeFunction;
+		edgeFunction.a = -edgeV * sign;
+		edgeFunction.b = edgeU * sign;
+		edgeFunction.c = -(edgeFunction.a * vertexU + edgeFunction.b * vertexV)
+			+ std::max(0.0f, edgeFunction.a) + std::max(0.0f, edgeFunction.b);
+
+		return edgeFunction;
+	}
+
+	void Cross(const float* a, const float* b, float* result)
+	{
+		result[0] = a[1] * b[2] - a[2] * b[1];
+		result[1] = a[2] * b[0] - a[0] * b[2];
+		result[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	float Dot(const float* a, const float* b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// Range of voxels the bounding box of the triangle touches, faces included. False when it's
+	// outside the grid.
+	bool GetVoxelRange(const float (*vertices)[3], uint32_t resolution, int32_t* minVoxel, int32_t* maxVoxel)
+	{
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			float low = std::min(vertices[0][axis], std::min(vertices[1][axis], vertices[2][axis]));
+			float high = std::max(vertices[0][axis], std::max(vertices[1][axis], vertices[2][axis]));
+
+			low = std::min(std::max(low, -1.0f), (float)resolution);
+			high = std::min(std::max(high, -1.0f), (float)resolution);
+
+			minVoxel[axis] = std::max((int32_t)std::ceil(low) - 1, 0);
+			maxVoxel[axis] = std::min((int32_t)std::floor(high), (int32_t)resolution - 1);
+
+			if (minVoxel[axis] > maxVoxel[axis])
+				return false;
+		}
+
+		return true;
+	}
+}
+
+const uint32_t Voxelizer::MipCount;
+
+void Voxelizer::Reset(uint32_t resolution, float worldBoundary)
+{
+	mResolution = resolution;
+	mWorldBoundary = worldBoundary;
+
+	mTriangles.clear();
+	mAccumulators.reset(new std::atomic<uint32_t>[(size_t)resolution * resolution * resolution * 4]);
+}
+
+void Voxelizer::AddMesh(const std::vector<XMFLOAT3>& positions, const std::vector<uint32_t>& indices, const XMFLOAT4X4& world,
+	const XMFLOAT3& albedo)
+{
+	// World space to grid space, the mapping the voxel injection uses
+	const float scale = 0.5f * (float)mResolution / mWorldBoundary;
+	const float offset = 0.5f * (float)mResolution;
+
+	std::vector<XMFLOAT3> gridPositions(positions.size());
+
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		const XMFLOAT3& position = positions[i];
+
+		gridPositions[i].x = (position.x * world._11 + position.y * world._21 + position.z * world._31 + world._41) * scale + offset;
+		gridPositions[i].y = (position.x * world._12 + position.y * world._22 + position.z * world._32 + world._42) * scale + offset;
+		gridPositions[i].z = (position.x * world._13 + position.y * world._23 + position.z * world._33 + world._43) * scale + offset;
+	}
+
+	Triangle triangle;
+	triangle.albedo = VoxelGrid::Pack(albedo.x, albedo.y, albedo.z, 0.0f);
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			const XMFLOAT3& position = gridPositions[indices[i + corner]];
+
+			triangle.vertices[corner][0] = position.x;
+			triangle.vertices[corner][1] = position.y;
+			triangle.vertices[corner][2] = position.z;
+		}
+
+		// Degenerate triangles cover nothing
+		float edges[2][3];
+		float normal[3];
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			edges[0][axis] = triangle.vertices[1][axis] - triangle.vertices[0][axis];
+			edges[1][axis] = triangle.vertices[2][axis] - triangle.vertices[0][axis];
+		}
+
+		Cross(edges[0], edges[1], normal);
+
+		if (normal[0] == 0.0f && normal[1] == 0.0f && normal[2] == 0.0f)
+			continue;
+
+		mTriangles.push_back(triangle);
+	}
+}
+
+uint32_t Voxelizer::Voxelize(VoxelGrid* grids)
+{
+	const size_t voxelCount = (size_t)mResolution * mResolution * mResolution;
+
+	ThreadPool::ParallelFor(voxelCount * 4, 1 << 16, [this](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			mAccumulators[i].store(0, std::memory_order_relaxed);
+	});
+
+	ThreadPool::ParallelFor(mTriangles.size(), 64, [this](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			RasterizeTriangle(mTriangles[i]);
+	});
+
+	for (uint32_t mip = 0; mip < MipCount; ++mip)
+		grids[mip].Reset(mResolution >> mip);
+
+	std::atomic<uint32_t> occupiedCount(0);
+	uint32_t* texels = grids[0].GetTexels();
+
+	ThreadPool::ParallelFor(voxelCount, 1 << 12, [this, texels, &occupiedCount](size_t begin, size_t end)
+	{
+		uint32_t rangeOccupiedCount = 0;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			uint32_t triangleCount = mAccumulators[i * 4].load(std::memory_order_relaxed);
+
+			if (triangleCount == 0)
+				continue;
+
+			uint32_t albedoSums[3] = { mAccumulators[i * 4 + 1].load(std::memory_order_relaxed),
+				mAccumulators[i * 4 + 2].load(std::memory_order_relaxed), mAccumulators[i * 4 + 3].load(std::memory_order_relaxed) };
+
+			texels[i] = ResolveVoxel(triangleCount, albedoSums);
+			++rangeOccupiedCount;
+		}
+
+		occupiedCount += rangeOccupiedCount;
+	});
+
+	VoxelMipBuilder::BuildMips(grids, MipCount);
+
+	return occupiedCount;
+}
+
+uint32_t Voxelizer::VoxelizeReference(VoxelGrid* grids) const
+{
+	const size_t voxelCount = (size_t)mResolution * mResolution * mResolution;
+	std::vector<uint32_t> accumulators(voxelCount * 4, 0);
+
+	for (const Triangle& triangle : mTriangles)
+	{
+		int32_t minVoxel[3];
+		int32_t maxVoxel[3];
+
+		if (!GetVoxelRange(triangle.vertices, mResolution, minVoxel, maxVoxel))
+			continue;
+
+		for (int32_t z = minVoxel[2]; z <= maxVoxel[2]; ++z)
+		{
+			for (int32_t y = minVoxel[1]; y <= maxVoxel[1]; ++y)
+			{
+				for (int32_t x = minVoxel[0]; x <= maxVoxel[0]; ++x)
+				{
+					if (!TriangleOverlapsVoxel(triangle, x, y, z))
+						continue;
+
+					size_t voxelIndex = ((size_t)z * mResolution + y) * mResolution + x;
+
+					accumulators[voxelIndex * 4] += 1;
+
+					for (uint32_t channel = 0; channel < 3; ++channel)
+						accumulators[voxelIndex * 4 + 1 + channel] += (triangle.albedo >> (channel * 8)) & 0xFF;
+				}
+			}
+		}
+	}
+
+	for (uint32_t mip = 0; mip < MipCount; ++mip)
+		grids[mip].Reset(mResolution >> mip);
+
+	uint32_t occupiedCount = 0;
+
+	for (size_t i = 0; i < voxelCount; ++i)
+	{
+		if (accumulators[i * 4] == 0)
+			continue;
+
+		grids[0].GetTexels()[i] = ResolveVoxel(accumulators[i * 4], &accumulators[i * 4 + 1]);
+		++occupiedCount;
+	}
+
+	VoxelMipBuilder::BuildMips(grids, MipCount);
+
+	return occupiedCount;
+}
+
+void Voxelizer::RasterizeTriangle(const Triangle& triangle)
+{
+	int32_t minVoxel[3];
+	int32_t maxVoxel[3];
+
+	if (!GetVoxelRange(triangle.vertices, mResolution, minVoxel, maxVoxel))
+		return;
+
+	// Most scene triangles are much smaller than a voxel, one that lies inside a voxel needs no tests
+	if (minVoxel[0] == maxVoxel[0] && minVoxel[1] == maxVoxel[1] && minVoxel[2] == maxVoxel[2])
+	{
+		Accumulate(((size_t)minVoxel[2] * mResolution + minVoxel[1]) * mResolution + minVoxel[0], triangle.albedo);
+		return;
+	}
+
+	const float (*vertices)[3] = triangle.vertices;
+
+	float edges[3][3];
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			edges[i][axis] = vertices[(i + 1) % 3][axis] - vertices[i][axis];
+	}
+
+	float normal[3];
+	Cross(edges[0], edges[1], normal);
+
+	// The triangle's plane passes between the two corners of the box furthest apart along its normal
+	float criticalPoint[3];
+	float oppositePoint[3];
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		criticalPoint[axis] = (normal[axis] > 0.0f ? 1.0f : 0.0f) - vertices[0][axis];
+		oppositePoint[axis] = (normal[axis] > 0.0f ? 0.0f : 1.0f) - vertices[0][axis];
+	}
+
+	const float planeOffsets[2] = { Dot(normal, criticalPoint), Dot(normal, oppositePoint) };
+
+	// The box must also touch the triangle's projections onto the xy, yz and zx planes
+	EdgeFunction xyEdges[3];
+	EdgeFunction yzEdges[3];
+	EdgeFunction zxEdges[3];
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		xyEdges[i] = MakeEdgeFunction(edges[i][0], edges[i][1], vertices[i][0], vertices[i][1], normal[2] >= 0.0f ? 1.0f : -1.0f);
+		yzEdges[i] = MakeEdgeFunction(edges[i][1], edges[i][2], vertices[i][1], vertices[i][2], normal[0] >= 0.0f ? 1.0f : -1.0f);
+		zxEdges[i] = MakeEdgeFunction(edges[i][2], edges[i][0], vertices[i][2], vertices[i][0], normal[1] >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 normalX = _mm_set1_ps(normal[0]);
+
+	for (int32_t z = minVoxel[2]; z <= maxVoxel[2]; ++z)
+	{
+		for (int32_t y = minVoxel[1]; y <= maxVoxel[1]; ++y)
+		{
+			// The yz projection is the same for the whole row
+			bool isRowTouched = true;
+
+			for (uint32_t i = 0; i < 3; ++i)
+				isRowTouched = isRowTouched && yzEdges[i].a * y + yzEdges[i].b * z + yzEdges[i].c >= 0.0f;
+
+			if (!isRowTouched)
+				continue;
+
+			const float planeRow = normal[1] * y + normal[2] * z;
+			const __m128 planeOffset0 = _mm_set1_ps(planeRow + planeOffsets[0]);
+			const __m128 planeOffset1 = _mm_set1_ps(planeRow + planeOffsets[1]);
+
+			__m128 xyCoefficients[3];
+			__m128 xyRows[3];
+			__m128 zxCoefficients[3];
+			__m128 zxRows[3];
+
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				xyCoefficients[i] = _mm_set1_ps(xyEdges[i].a);
+				xyRows[i] = _mm_set1_ps(xyEdges[i].b * y + xyEdges[i].c);
+				zxCoefficients[i] = _mm_set1_ps(zxEdges[i].b);
+				zxRows[i] = _mm_set1_ps(zxEdges[i].a * z + zxEdges[i].c);
+			}
+
+			const size_t rowIndex = ((size_t)z * mResolution + y) * mResolution;
+
+			// Four voxels of the row at a time
+			for (int32_t x = minVoxel[0]; x <= maxVoxel[0]; x += 4)
+			{
+				__m128 voxelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+				__m128 plane = _mm_mul_ps(normalX, voxelX);
+				__m128 isTouched = _mm_cmple_ps(_mm_mul_ps(_mm_add_ps(plane, planeOffset0), _mm_add_ps(plane, planeOffset1)), zero);
+
+				for (uint32_t i = 0; i < 3; ++i)
+				{
+					isTouched = _mm_and_ps(isTouched, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(xyCoefficients[i], voxelX), xyRows[i]), zero));
+					isTouched = _mm_and_ps(isTouched, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(zxCoefficients[i], voxelX), zxRows[i]), zero));
+				}
+
+				int touchedMask = _mm_movemask_ps(isTouched);
+				int laneCount = std::min(4, maxVoxel[0] - x + 1);
+
+				for (int lane = 0; lane < laneCount; ++lane)
+				{
+					if ((touchedMask & (1 << lane)) == 0)
+						continue;
+
+					Accumulate(rowIndex + x + lane, triangle.albedo);
+				}
+			}
+		}
+	}
+}
+
+void Voxelizer::Accumulate(size_t voxelIndex, uint32_t albedo)
+{
+	std::atomic<uint32_t>* accumulator = &mAccumulators[voxelIndex * 4];
+
+	accumulator[0].fetch_add(1, std::memory_order_relaxed);
+
+	for (uint32_t channel = 0; channel < 3; ++channel)
+		accumulator[1 + channel].fetch_add((albedo >> (channel * 8)) & 0xFF, std::memory_order_relaxed);
+}
+
+uint32_t Voxelizer::ResolveVoxel(uint32_t triangleCount, const uint32_t* albedoSums)
+{
+	const float scale = 1.0f / (255.0f * (float)triangleCount);
+
+	return VoxelGrid::Pack(albedoSums[0] * scale, albedoSums[1] * scale, albedoSums[2] * scale, 1.0f);
+}
+
+bool Voxelizer::TriangleOverlapsVoxel(const Triangle& triangle, uint32_t x, uint32_t y, uint32_t z)
+{
+	// Relative to the centre of the voxel, whose half size is one half
+	const float center[3] = { x + 0.5f, y + 0.5f, z + 0.5f };
+	float vertices[3][3];
+
+	for (uint32_t corner = 0; corner < 3; ++corner)
+	{
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			vertices[corner][axis] = triangle.vertices[corner][axis] - center[axis];
+	}
+
+	float edges[3][3];
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			edges[i][axis] = vertices[(i + 1) % 3][axis] - vertices[i][axis];
+	}
+
+	// Cross products of the edges with the box's axes
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		for (uint32_t boxAxis = 0; boxAxis < 3; ++boxAxis)
+		{
+			const float unitAxis[3] = { boxAxis == 0 ? 1.0f : 0.0f, boxAxis == 1 ? 1.0f : 0.0f, boxAxis == 2 ? 1.0f : 0.0f };
+			float axis[3];
+			Cross(unitAxis, edges[i], axis);
+
+			float projections[3] = { Dot(axis, vertices[0]), Dot(axis, vertices[1]), Dot(axis, vertices[2]) };
+			float radius = 0.5f * (std::fabs(axis[0]) + std::fabs(axis[1]) + std::fabs(axis[2]));
+
+			if (std::min(projections[0], std::min(projections[1], projections[2])) > radius
+				|| std::max(projections[0], std::max(projections[1], projections[2])) < -radius)
+				return false;
+		}
+	}
+
+	// The box's own axes
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		if (std::min(vertices[0][axis], std::min(vertices[1][axis], vertices[2][axis])) > 0.5f
+			|| std::max(vertices[0][axis], std::max(vertices[1][axis], vertices[2][axis])) < -0.5f)
+			return false;
+	}
+
+	// The triangle's normal
+	float normal[3];
+	Cross(edges[0], edges[1], normal);
+
+	float nearCorner[3];
+	float farCorner[3];
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		nearCorner[axis] = normal[axis] > 0.0f ? -0.5f : 0.5f;
+		farCorner[axis] = -nearCorner[axis];
+	}
+
+	float distance = Dot(normal, vertices[0]);
+
+	return Dot(normal, nearCorner) <= distance && Dot(normal, farCorner) >= distance;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "VoxelGrid.h"
+
+#include <DirectXMath.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Conservatively voxelizes static triangles into the voxel mips when a scene is loaded, so the grids
+// hold every surface before the camera has seen it. A voxel is marked when a triangle touches it at
+// all, found with the triangle / box separating axis tests evaluated for four voxels of a row at a
+// time. Triangles are rasterized in parallel and merged into the finest grid with atomic adds, so the
+// result doesn't depend on the thread count.
+//
+// The finest grid gets an alpha of one and the average albedo of the triangles touching the voxel.
+// Every coarser grid is reduced from the one before it, its alpha is the occupied fraction of the
+// eight children and its albedo their average weighted by occupancy.
+class Voxelizer
+{
+public:
+	Voxelizer() = default;
+	~Voxelizer() = default;
+
+	static const uint32_t MipCount = 5;
+
+	// Resolution of the finest grid and half the size of the volume, a cube around the origin like
+	// the one of the voxel injection. Forgets the triangles.
+	void Reset(uint32_t, float);
+
+	// Object space positions, triangle list indices, world matrix and linear albedo of a mesh instance
+	void AddMesh(const std::vector<DirectX::XMFLOAT3>&, const std::vector<uint32_t>&, const DirectX::XMFLOAT4X4&, const DirectX::XMFLOAT3&);
+
+	// Fills grids of the given resolution and below, returns the number of occupied voxels in the finest one
+	uint32_t Voxelize(VoxelGrid*);
+
+	uint32_t GetTriangleCount() const { return (uint32_t)mTriangles.size(); }
+	uint32_t GetResolution() const { return mResolution; }
+
+	// Same as Voxelize() one voxel at a time with the classic separating axis test, for checking it
+	uint32_t VoxelizeReference(VoxelGrid*) const;
+
+private:
+
+	// In grid space, where a voxel is a unit cube
+	struct Triangle
+	{
+		float vertices[3][3];
+		uint32_t albedo;
+	};
+
+	void RasterizeTriangle(const Triangle&);
+	// Adds a triangle's albedo to a voxel of the finest grid, from any thread
+	void Accumulate(size_t, uint32_t);
+
+	// Occupied voxels get an alpha of one and the average albedo
+	static uint32_t ResolveVoxel(uint32_t, const uint32_t*);
+
+	static bool TriangleOverlapsVoxel(const Triangle&, uint32_t, uint32_t, uint32_t);
+
+	std::vector<Triangle> mTriangles;
+	// Per voxel of the finest grid, the number of triangles touching it and the sums of their albedo
+	std::unique_ptr<std::atomic<uint32_t>[]> mAccumulators;
+
+	uint32_t mResolution = 0;
+	float mWorldBoundary = 0.0f;
+};
\ No newline at end of file
@@ -25,6 +25,17 @@ UINT d3dUtil::CalcConstantBufferByteSize(UINT byteSize)
 	return (byteSize + 255) & ~255;
 }
 
+void d3dUtil::TrackResource(ID3D12Device* device, ID3D12Resource* resource, MemoryCategory category)
+{
+	if (resource == nullptr)
+		return;
+
+	D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+	MemoryTracker::Track(category, resource, allocationInfo.SizeInBytes);
+}
+
 ComPtr<ID3DBlob> d3dUtil::LoadBinary(const std::wstring& filename)
 {
     std::ifstream fin(filename, std::ios::binary);
@@ -18,6 +18,7 @@
 #include <cassert>
 #include "DDSTextureLoader.h"
 #include "DxException.h"
+#include "MemoryTracker.h"
 
 class d3dUtil
 {
@@ -36,6 +37,9 @@ public:
         UINT64 byteSize,
         Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
 
+	// Registers the resource with the memory tracker using the size the device reports for it
+	static void TrackResource(ID3D12Device* device, ID3D12Resource* resource, MemoryCategory category);
+
 	static Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
 		const std::wstring& filename,
 		const D3D_SHADER_MACRO* defines,
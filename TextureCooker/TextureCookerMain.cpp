@@ -0,0 +1,180 @@
+#include "../Engine/Utilities/TextureCooker.h"
+#include "../Engine/Utilities/ThreadPool.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+	struct CookerSettings
+	{
+		std::string scenePath;
+		std::string textureDirectory = "../Assets/Textures";
+		std::string outputDirectory;
+
+		std::string inputPath;
+		std::string outputPath;
+		TextureCookSettings textureSettings;
+
+		uint32_t threadCount = 0;
+	};
+
+	const char* GetFormatName(BCFormat format)
+	{
+		switch (format)
+		{
+		case BCFormat::BC1: return "BC1";
+		case BCFormat::BC3: return "BC3";
+		case BCFormat::BC5: return "BC5";
+		case BCFormat::BC7: return "BC7";
+		}
+
+		return "?";
+	}
+
+	bool ParseFormat(const char* name, BCFormat& format)
+	{
+		if (strcmp(name, "bc1") == 0)
+			format = BCFormat::BC1;
+		else if (strcmp(name, "bc3") == 0)
+			format = BCFormat::BC3;
+		else if (strcmp(name, "bc5") == 0)
+			format = BCFormat::BC5;
+		else if (strcmp(name, "bc7") == 0)
+			format = BCFormat::BC7;
+		else
+			return false;
+
+		return true;
+	}
+
+	bool ParseArguments(int argc, char** argv, CookerSettings& settings)
+	{
+		bool isValid = true;
+
+		for (int i = 1; i < argc && isValid; ++i)
+		{
+			bool hasValue = (i + 1 < argc);
+
+			if (strcmp(argv[i], "--scene") == 0 && hasValue)
+				settings.scenePath = argv[++i];
+			else if (strcmp(argv[i], "--textures") == 0 && hasValue)
+				settings.textureDirectory = argv[++i];
+			else if (strcmp(argv[i], "--out") == 0 && hasValue)
+				settings.outputDirectory = argv[++i];
+			else if (strcmp(argv[i], "--input") == 0 && hasValue)
+				settings.inputPath = argv[++i];
+			else if (strcmp(argv[i], "--output") == 0 && hasValue)
+				settings.outputPath = argv[++i];
+			else if (strcmp(argv[i], "--type") == 0 && hasValue)
+			{
+				++i;
+
+				if (strcmp(argv[i], "diffuse") == 0)
+					settings.textureSettings.usage = TextureUsage::DiffuseOpacity;
+				else if (strcmp(argv[i], "normal") == 0)
+					settings.textureSettings.usage = TextureUsage::NormalRoughness;
+				else
+					isValid = false;
+			}
+			else if (strcmp(argv[i], "--format") == 0 && hasValue)
+			{
+				settings.textureSettings.overrideFormat = true;
+				isValid = ParseFormat(argv[++i], settings.textureSettings.format);
+			}
+			else if (strcmp(argv[i], "--mips") == 0)
+				settings.textureSettings.generateMips = true;
+			else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+				settings.threadCount = (uint32_t)std::stoul(argv[++i]);
+			else
+				isValid = false;
+		}
+
+		bool cooksScene = !settings.scenePath.empty() && !settings.outputDirectory.empty();
+		bool cooksFile = !settings.inputPath.empty() && !settings.outputPath.empty();
+
+		if (!isValid || cooksScene == cooksFile)
+		{
+			std::cerr << "Usage: " << argv[0] << " --scene scene.txt [--textures directory] --out directory [--mips] [--threads count]" << std::endl
+				<< "       " << argv[0] << " --input texture.dds --output texture.dds --type diffuse|normal"
+				<< " [--format bc1|bc3|bc5|bc7] [--mips] [--threads count]" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	void PrintReport(const TextureCookReport& report)
+	{
+		if (!report.succeeded)
+		{
+			std::cerr << report.inputPath << ": " << report.error << std::endl;
+			return;
+		}
+
+		char line[512];
+		snprintf(line, sizeof(line), "%-60s %s  %2u subresources  %9zu -> %9zu bytes  %6.2f dB  %4zu clip mismatches  %8.1f ms",
+			report.outputPath.c_str(), GetFormatName(report.format), report.subresourceCount, report.inputBytes, report.outputBytes,
+			report.psnr, report.clipMismatches, report.encodeMilliseconds);
+
+		std::cout << line << std::endl;
+
+		if (report.mipCoverageErrors.empty())
+			return;
+
+		// Alpha test coverage of the generated mips against the top mip, in percent
+		std::string coverageLine = "    mip coverage error %:";
+		std::string filteredLine = "    box filter only      :";
+
+		for (size_t mip = 0; mip < report.mipCoverageErrors.size(); ++mip)
+		{
+			snprintf(line, sizeof(line), " %5.2f", report.mipCoverageErrors[mip] * 100.0);
+			coverageLine += line;
+			snprintf(line, sizeof(line), " %5.2f", report.filteredMipCoverageErrors[mip] * 100.0);
+			filteredLine += line;
+		}
+
+		std::cout << coverageLine << std::endl << filteredLine << std::endl;
+	}
+}
+
+// Converts the RGBA8 scene textures into block compressed DDS files for the engine to load
+int main(int argc, char** argv)
+{
+	CookerSettings settings;
+
+	if (!ParseArguments(argc, argv, settings))
+		return 1;
+
+	// The calling thread works as well, so one thread means no workers
+	if (settings.threadCount != 1)
+		ThreadPool::Initialize((settings.threadCount > 1) ? (settings.threadCount - 1) : 0);
+
+	bool succeeded = false;
+
+	if (!settings.scenePath.empty())
+	{
+		std::vector<TextureCookReport> reports;
+		succeeded = TextureCooker::CookScene(settings.scenePath, settings.textureDirectory, settings.outputDirectory,
+			settings.textureSettings, reports);
+
+		if (reports.empty())
+			std::cerr << "Failed to read " << settings.scenePath << std::endl;
+
+		for (const TextureCookReport& report : reports)
+			PrintReport(report);
+	}
+	else
+	{
+		TextureCookReport report;
+		succeeded = TextureCooker::CookTexture(settings.inputPath, settings.outputPath, settings.textureSettings, report);
+
+		PrintReport(report);
+	}
+
+	ThreadPool::Shutdown();
+
+	return succeeded ? 0 : 1;
+}
\ No newline at end of file